@@ -14,6 +14,18 @@
 #include "sensor_tasks.h"
 #include "sync_queue.h"
 #include "task_config.h"
+#include "power_manager.h"
+#include "boot_profiler.h"
+#include "telemetry.h"
+#include "console.h"
+#include "inclinometer.h"
+#include "measure_service.h"
+#include "point_cloud_service.h"
+#include "config_store.h"
+#include "height_map_service.h"
+#include "data_logger.h"
+#include "flight_recorder_service.h"
+#include "system_monitor_service.h"
 
 #include <Wire.h>
 #include <Arduino_GFX_Library.h>
@@ -33,104 +45,110 @@ UIConfig ui;
 
 // === NUOVE VARIABILI GLOBALI ===
 static SensorData latestSensorData = {0};
-static bool sensorsReady = false;
 
 void setup() {
     Serial.begin(115200);
     Serial.println("\n=== HySeq Plus FreeRTOS ===");
+
+    // Traccia eventi in RTC RAM: prima di tutto, per vedere com'è finito
+    // il giro precedente (panic, watchdog, leaf bloccata)
+    initFlightRecorder();
+    
+    // Eventi UI: il loop dorme finché arriva touch (IRQ), un nuovo campione
+    // o la fine del boot sensori
+    initUIEvents();
+    
+    // Configurazione da NVS in RAM, una volta sola (calibrazione e tuning)
+    initConfigStore();
     
-    // === INIT HARDWARE (esistente) ===
+    // === BOOT SENSORI IN BACKGROUND ===
+    // IMU/radar (distanceBegin è lento) e task partono su Wire nel core 0,
+    // mentre qui display e touch vanno avanti sui loro bus
+    Wire.begin(SENSOR_SDA, SENSOR_SCL); // I2C sensori
+    startSensorBoot();
+    initTelemetry();    // Stream binario: parte quando il topic sensori è pronto
+    initConsole();      // Tuning da seriale senza riflashare
+    initInclinometer(); // Pitch di precisione su richiesta (FIFO IMU)
+    initMeasureService(); // Misura su trigger: console, touch, tasto BOOT
+    initPointCloud();   // Nuvola di punti in PSRAM (catture, misure, sweep)
+    initHeightMap();    // Griglia di quota dello sweep (schermata MAP)
+    initDataLogger();   // Log di sessione su SD con piramide min/max/media
+    initSystemMonitor();    // CPU per task, stack e heap a 1Hz (System Info, telemetria)
+    
+    // === INIT DISPLAY ===
+    bootPhaseBegin(BOOT_PHASE_DISPLAY);
     pinMode(LCD_BL, OUTPUT); 
     digitalWrite(LCD_BL, HIGH);
-    Wire.begin(11, 10);       // I2C sensori
-    Wire1.begin(TP_SDA, TP_SCL); // I2C touch separato
-
-    // Display init
     gfx->begin();
     gfx->fillScreen(ui.bgColor);
+    bootPhaseEnd(BOOT_PHASE_DISPLAY);
 
-    // Touch init
-    if (!touch->begin()) {
+    // === INIT TOUCH ===
+    bootPhaseBegin(BOOT_PHASE_TOUCH);
+    Wire1.begin(TP_SDA, TP_SCL); // I2C touch separato
+    bool touchOk = touch->begin();
+    if (!touchOk) {
         Serial.println("❌ Touch CST328 non rilevato!");
-        gfx->setCursor(10, 150);
-        gfx->setTextColor(RED);
-        gfx->println("Touch Error");
-    }
-
-    // === INIT SENSORI (modificato con retry) ===
-    bool imuOk = false;
-    bool radarOk = false;
-    
-    for (int retry = 0; retry < 3 && (!imuOk || !radarOk); retry++) {
-        if (!imuOk) {
-            imuOk = initIMU();
-            if (!imuOk) {
-                Serial.printf("❌ IMU Init Failed (attempt %d/3)\n", retry + 1);
-                delay(100);
-            }
-        }
-        
-        if (!radarOk) {
-            radarOk = initRadar();
-            if (!radarOk) {
-                Serial.printf("❌ Radar Init Failed (attempt %d/3)\n", retry + 1);
-                delay(100);
-            }
-        }
-    }
-    
-    if (!imuOk) {
-        gfx->setCursor(10, 170);
-        gfx->setTextColor(RED);
-        gfx->println("IMU Failed!");
     }
-    
-    if (!radarOk) {
-        gfx->setCursor(10, 190);
-        gfx->setTextColor(RED);
-        gfx->println("Radar Failed!");
-    }
-    
-    sensorsReady = imuOk && radarOk;
-    
-    // === INIT FREERTOS (nuovo) ===
-    if (sensorsReady) {
-        if (initSensorTasks()) {
-            Serial.println("✅ FreeRTOS tasks started");
-            gfx->setCursor(10, 210);
-            gfx->setTextColor(GREEN);
-            gfx->println("Tasks OK");
-        } else {
-            Serial.println("❌ FreeRTOS init failed");
-            gfx->setCursor(10, 210);
-            gfx->setTextColor(RED);
-            gfx->println("Tasks Failed!");
-        }
+    if (!initTouchInterrupt(TP_INT)) {
+        Serial.println("⚠️ IRQ touch non disponibile, uso polling");
     }
+    bootPhaseEnd(BOOT_PHASE_TOUCH, touchOk);
     
     // Configurazione UI
     ui.topLine = IntestazioneLCD;
     ui.botLine = PiedipaginaLCD;
 
-    // Mostra menu principale dopo 2 secondi
-    delay(2000);
+    // Menu subito: le voci sensori restano "warming up" fino a UI_EVENT_BOOT
+    bootPhaseBegin(BOOT_PHASE_MENU);
     drawMainMenu(gfx, ui);
+    bootPhaseEnd(BOOT_PHASE_MENU);
+
+    // DFS (+ light sleep se PM_LIGHT_SLEEP_ENABLE): da qui in poi i core rallentano in idle
+    initPowerManagement();
 }
 
 void loop() {
+    // === ATTESA EVENTI (touch IRQ, nuovo campione, timeout 1Hz) ===
+    // I campioni svegliano la UI solo quando devono andare a video
+    EventBits_t waitMask = UI_EVENT_TOUCH | UI_EVENT_BOOT;
+    if (areSensorsReady() && getCurrentMenuState() == DISPLAY_LIVE_DATA) {
+        waitMask |= UI_EVENT_SENSOR;
+    }
+    EventBits_t events = waitUIEvent(waitMask, UI_IDLE_TIMEOUT_MS);
+    flightTaskBeat(FR_TASK_LOOP);
+
+    // === FINE BOOT SENSORI ===
+    // Le voci "warming up" diventano attive: ridisegna se siamo in un menu
+    if (events & UI_EVENT_BOOT) {
+        if (getMenuItems(getCurrentMenuState())) {
+            drawMenu(gfx, ui, getCurrentMenuState());
+        }
+        printBootProfile();
+    }
+
     // === GESTIONE TOUCH (esistente) ===
-    handleTouch(gfx, ui);
+    if (events & UI_EVENT_TOUCH) {
+        handleTouch(gfx, ui);
+    }
     
     // === AGGIORNAMENTO DATI SENSORI (nuovo) ===
-    if (sensorsReady) {
+    if (areSensorsReady()) {
+        // Subscriber del display: solo l'ultimo campione, senza togliere
+        // dati a logger/test che hanno il proprio cursore
+        static int8_t displaySub = -1;
+        if (displaySub < 0) {
+            displaySub = subscribeSensorData("display", PUBSUB_LATEST_ONLY);
+        }
+        
         // Ottieni ultimi dati sincronizzati (non bloccante)
-        if (getLatestSensorData(latestSensorData)) {
+        if (readSensorData(displaySub, latestSensorData, 0)) {
             // I dati sono disponibili per essere usati
             // da displayLiveData() o altre funzioni
             
             // Debug su seriale (opzionale)
             static uint32_t lastDebugPrint = 0;
-            if (millis() - lastDebugPrint > 1000) {
+            if (millis() - lastDebugPrint >= UI_IDLE_TIMEOUT_MS) {
                 Serial.printf("📊 Sync: %dms | Dist: %.0fmm | Pitch: %.1f° | Yaw: %.1f°\n",
                     latestSensorData.sync_delta_ms,
                     latestSensorData.filtered_distance_mm,
@@ -146,6 +164,12 @@ void loop() {
                     (stats.sync_success * 100.0) / stats.samples_acquired,
                     stats.avg_sync_delta_ms
                 );
+
+                // Residenza idle/sleep per core
+                printIdleReport();
+                
+                // Lag/perdite per subscriber del topic sensori
+                printSensorSubscribers();
                 
                 lastDebugPrint = millis();
             }
@@ -157,9 +181,6 @@ void loop() {
     if (getCurrentMenuState() == DISPLAY_LIVE_DATA) {
         updateLiveDataDisplay();
     }
-    
-    // Delay ridotto perché i sensori girano in parallelo
-    delay(50);
 }
 
 // === NUOVA FUNZIONE PER AGGIORNARE DISPLAY LIVE ===
@@ -170,7 +191,7 @@ void updateLiveDataDisplay() {
     if (millis() - lastUpdate < 100) return;
     lastUpdate = millis();
     
-    if (!sensorsReady) {
+    if (!areSensorsReady()) {
         gfx->setCursor(50, 150);
         gfx->setTextColor(RED, ui.bgColor);
         gfx->println("Sensors Not Ready");
@@ -233,7 +254,7 @@ void displayLiveData() {
 
 // === GESTIONE CALIBRAZIONE IN BACKGROUND ===
 void startCalibration() {
-    if (sensorsReady) {
+    if (areSensorsReady()) {
         startBackgroundCalibration();
         
         // Mostra schermata progresso
@@ -0,0 +1,77 @@
+// auto_capture.cpp
+#include "auto_capture.h"
+#include "power_manager.h"
+
+// === VARIABILI DI STATO ===
+// Il detector lo usa solo il task sensori; il resto è condiviso con UI e
+// console sotto lock (copie brevi, nessuna attesa nel ciclo sensori)
+static AutoCaptureDetector detector;
+static portMUX_TYPE captureLock = portMUX_INITIALIZER_UNLOCKED;
+static AutoCaptureStatus status = {};
+static AutoCaptureConfig config = {AUTO_CAPTURE_DEFAULT_RATE, AUTO_CAPTURE_DEFAULT_DIST_SD,
+                                   AUTO_CAPTURE_DEFAULT_HOLD_MS};
+static volatile bool reloadRequested = true;    // Config nuova o riattivazione
+static volatile bool enabled = false;
+
+void autoCaptureProcess(const SensorData &data, float rateDps) {
+    if (!enabled) return;
+
+    if (reloadRequested) {
+        taskENTER_CRITICAL(&captureLock);
+        detector.setConfig(config);
+        reloadRequested = false;
+        taskEXIT_CRITICAL(&captureLock);
+        detector.reset();
+    }
+
+    SensorData point;
+    bool captured = detector.add(data, rateDps, point);
+
+    taskENTER_CRITICAL(&captureLock);
+    status.state = detector.state();
+    status.progress = detector.progress();
+    status.rate_dps = detector.rate();
+    status.distance_sd_mm = detector.distanceSd();
+    if (captured) {
+        status.last = point;
+        status.captures++;
+    }
+    taskEXIT_CRITICAL(&captureLock);
+
+    if (captured) notifyUIEvent(UI_EVENT_CAPTURE);
+}
+
+void setAutoCaptureEnabled(bool on) {
+    if (on && !enabled) reloadRequested = true;     // Riparte da finestra vuota
+    enabled = on;
+    taskENTER_CRITICAL(&captureLock);
+    status.enabled = on;
+    if (!on) {
+        status.state = AUTO_CAPTURE_MOVING;
+        status.progress = 0;
+    }
+    taskEXIT_CRITICAL(&captureLock);
+}
+
+bool isAutoCaptureEnabled() {
+    return enabled;
+}
+
+void setAutoCaptureConfig(const AutoCaptureConfig &c) {
+    taskENTER_CRITICAL(&captureLock);
+    config = c;
+    reloadRequested = true;
+    taskEXIT_CRITICAL(&captureLock);
+}
+
+void getAutoCaptureConfig(AutoCaptureConfig &c) {
+    taskENTER_CRITICAL(&captureLock);
+    c = config;
+    taskEXIT_CRITICAL(&captureLock);
+}
+
+void getAutoCaptureStatus(AutoCaptureStatus &s) {
+    taskENTER_CRITICAL(&captureLock);
+    s = status;
+    taskEXIT_CRITICAL(&captureLock);
+}
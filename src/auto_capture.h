@@ -0,0 +1,33 @@
+// auto_capture.h
+#ifndef AUTO_CAPTURE_H
+#define AUTO_CAPTURE_H
+
+#include <Arduino.h>
+#include "auto_capture_detector.h"
+
+// === CATTURA AUTOMATICA DA FERMO ===
+// Il task sensori passa ogni campione a autoCaptureProcess() (O(1), nessun
+// I/O): quando il dispositivo resta fermo per hold_ms viene preso un punto e
+// segnalato UI_EVENT_CAPTURE. Niente tocco sullo schermo, quindi niente
+// movimento dovuto al tap. Disabilitata di default.
+
+struct AutoCaptureStatus {
+    bool enabled;
+    uint8_t state;              // AutoCaptureState
+    float progress;             // 0..1 verso la prossima cattura
+    float rate_dps;
+    float distance_sd_mm;
+    uint32_t captures;          // Totale dall'avvio (cambia a ogni nuovo punto)
+    SensorData last;            // Ultimo punto catturato
+};
+
+// Dal task sensori, una volta per ciclo dopo il calcolo delle coordinate
+void autoCaptureProcess(const SensorData &data, float rateDps);
+
+void setAutoCaptureEnabled(bool enabled);
+bool isAutoCaptureEnabled();
+void setAutoCaptureConfig(const AutoCaptureConfig &config);
+void getAutoCaptureConfig(AutoCaptureConfig &config);
+void getAutoCaptureStatus(AutoCaptureStatus &status);
+
+#endif // AUTO_CAPTURE_H
@@ -0,0 +1,124 @@
+// auto_capture_detector.h
+// Cattura automatica di un punto 3D quando il dispositivo è fermo: velocità
+// angolare (modulo del giroscopio) sotto soglia a ogni campione e varianza
+// della distanza radar sotto soglia sulla finestra scorrevole, entrambe per
+// hold_ms di fila. Dopo una cattura serve un movimento vero (isteresi) prima
+// della successiva. O(1) per campione, nessuna allocazione: gira dentro il
+// ciclo sensori. Header puro C++, testato in tools/auto_capture_test.cpp.
+#ifndef AUTO_CAPTURE_DETECTOR_H
+#define AUTO_CAPTURE_DETECTOR_H
+
+#include <stdint.h>
+#include <math.h>
+#include "sync_queue.h"
+#include "running_stats.h"
+
+#define AUTO_CAPTURE_WINDOW           8       // Campioni radar per la varianza (0.8s a 10Hz)
+#define AUTO_CAPTURE_DEFAULT_RATE     2.0f    // dps
+#define AUTO_CAPTURE_DEFAULT_DIST_SD  3.0f    // mm
+#define AUTO_CAPTURE_DEFAULT_HOLD_MS  500     // Oltre al riempimento della finestra
+#define AUTO_CAPTURE_REARM_FACTOR     2.0f    // Movimento = soglie superate di questo fattore
+
+struct AutoCaptureConfig {
+    float max_rate_dps;
+    float max_distance_sd_mm;
+    uint32_t hold_ms;
+};
+
+inline void autoCaptureDefaults(AutoCaptureConfig &c) {
+    c.max_rate_dps = AUTO_CAPTURE_DEFAULT_RATE;
+    c.max_distance_sd_mm = AUTO_CAPTURE_DEFAULT_DIST_SD;
+    c.hold_ms = AUTO_CAPTURE_DEFAULT_HOLD_MS;
+}
+
+enum AutoCaptureState : uint8_t {
+    AUTO_CAPTURE_MOVING = 0,    // Soglie superate (o finestra non ancora piena)
+    AUTO_CAPTURE_SETTLING,      // Fermo da meno di hold_ms
+    AUTO_CAPTURE_CAPTURED       // Punto preso: attesa movimento per riarmare
+};
+
+inline float autoCaptureRate(const float gyroDps[3]) {
+    return sqrtf(gyroDps[0] * gyroDps[0] + gyroDps[1] * gyroDps[1] + gyroDps[2] * gyroDps[2]);
+}
+
+class AutoCaptureDetector {
+public:
+    AutoCaptureDetector() {
+        autoCaptureDefaults(cfg);
+        reset();
+    }
+
+    void setConfig(const AutoCaptureConfig &c) { cfg = c; }
+    const AutoCaptureConfig &config() const { return cfg; }
+
+    void reset() {
+        dist.reset();
+        st = AUTO_CAPTURE_MOVING;
+        stillSinceUs = 0;
+        lastUs = 0;
+        lastRate = 0;
+    }
+
+    // Un campione del ciclo. true se ha prodotto un punto in out (distanza
+    // media della finestra, angoli del campione, coordinate calcolate).
+    bool add(const SensorData &d, float rateDps, SensorData &out) {
+        lastRate = rateDps;
+        lastUs = d.timestamp_us;
+        if (!d.radar_valid || !d.imu_valid) {
+            reset();
+            return false;
+        }
+        dist.add(d.distance_mm);
+
+        float sd = (float)dist.stddev();
+        bool still = dist.full() && rateDps <= cfg.max_rate_dps && sd <= cfg.max_distance_sd_mm;
+
+        if (st == AUTO_CAPTURE_CAPTURED) {
+            if (rateDps > cfg.max_rate_dps * AUTO_CAPTURE_REARM_FACTOR ||
+                sd > cfg.max_distance_sd_mm * AUTO_CAPTURE_REARM_FACTOR) {
+                st = AUTO_CAPTURE_MOVING;
+            }
+            return false;
+        }
+
+        if (!still) {
+            st = AUTO_CAPTURE_MOVING;
+            return false;
+        }
+        if (st == AUTO_CAPTURE_MOVING) {
+            st = AUTO_CAPTURE_SETTLING;
+            stillSinceUs = d.timestamp_us;
+        }
+        if (d.timestamp_us - stillSinceUs < (uint64_t)cfg.hold_ms * 1000) return false;
+
+        out = d;
+        out.distance_mm = (float)dist.mean;
+        out.filtered_distance_mm = out.distance_mm;
+        calculateCoordinates(out);
+        st = AUTO_CAPTURE_CAPTURED;
+        return true;
+    }
+
+    AutoCaptureState state() const { return st; }
+
+    // Avanzamento verso la cattura (0..1) per il feedback a video
+    float progress() const {
+        if (st == AUTO_CAPTURE_CAPTURED) return 1.0f;
+        if (st != AUTO_CAPTURE_SETTLING || cfg.hold_ms == 0) return 0.0f;
+        float p = (lastUs - stillSinceUs) / (cfg.hold_ms * 1000.0f);
+        return p > 1.0f ? 1.0f : p;
+    }
+
+    float rate() const { return lastRate; }
+    float distanceSd() const { return (float)dist.stddev(); }
+
+private:
+    AutoCaptureConfig cfg;
+    SlidingStats<AUTO_CAPTURE_WINDOW> dist;
+    AutoCaptureState st;
+    timestamp_us_t stillSinceUs;
+    timestamp_us_t lastUs;
+    float lastRate;
+};
+
+#endif // AUTO_CAPTURE_DETECTOR_H
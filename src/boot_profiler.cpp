@@ -0,0 +1,106 @@
+// boot_profiler.cpp
+#include "boot_profiler.h"
+#include "timebase.h"
+
+// === VARIABILI DI STATO ===
+static BootPhaseRecord phases[BOOT_PHASE_COUNT];
+
+static const char *phaseNames[BOOT_PHASE_COUNT] = {
+    "Display",
+    "Touch",
+    "Menu",
+    "IMU",
+    "Radar",
+    "Tasks"
+};
+
+// === REGISTRAZIONE ===
+void bootPhaseBegin(uint8_t phase) {
+    if (phase >= BOOT_PHASE_COUNT) return;
+    phases[phase].start_us = (uint32_t)timebaseNowUs();
+    phases[phase].started = true;
+    phases[phase].done = false;
+}
+
+void bootPhaseEnd(uint8_t phase, bool ok) {
+    if (phase >= BOOT_PHASE_COUNT) return;
+    phases[phase].end_us = (uint32_t)timebaseNowUs();
+    phases[phase].ok = ok;
+    phases[phase].done = true;
+}
+
+bool isBootProfileComplete() {
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (phases[i].started && !phases[i].done) return false;
+    }
+    return phases[BOOT_PHASE_MENU].done && phases[BOOT_PHASE_TASKS].done;
+}
+
+void getBootPhase(uint8_t phase, BootPhaseRecord &record) {
+    if (phase >= BOOT_PHASE_COUNT) {
+        memset(&record, 0, sizeof(record));
+        return;
+    }
+    record = phases[phase];
+}
+
+const char *getBootPhaseName(uint8_t phase) {
+    return phase < BOOT_PHASE_COUNT ? phaseNames[phase] : "?";
+}
+
+// === REPORT ===
+static const char *grade(uint32_t ms, uint32_t target, uint32_t accept, uint32_t max) {
+    if (ms <= target) return "✅ target";
+    if (ms <= accept) return "⚠️ accettabile";
+    if (ms <= max) return "⚠️ limite";
+    return "❌ fuori specifica";
+}
+
+static void printCriterion(const char *name, uint32_t ms,
+                           uint32_t target, uint32_t accept, uint32_t max) {
+    Serial.printf("%-14s %5lums (<%lums)  %s\n", name, (unsigned long)ms,
+                  (unsigned long)target, grade(ms, target, accept, max));
+}
+
+void printBootProfile() {
+    Serial.println("\n=== Boot Profile ===");
+    Serial.println("Fase      inizio    fine   durata");
+    for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+        const BootPhaseRecord &p = phases[i];
+        if (!p.started) continue;
+
+        if (p.done) {
+            Serial.printf("%-8s %6lums %6lums %6lums %s\n", phaseNames[i],
+                          (unsigned long)(p.start_us / 1000),
+                          (unsigned long)(p.end_us / 1000),
+                          (unsigned long)((p.end_us - p.start_us) / 1000),
+                          p.ok ? "" : "❌");
+        } else {
+            Serial.printf("%-8s %6lums      -      - in corso\n", phaseNames[i],
+                          (unsigned long)(p.start_us / 1000));
+        }
+    }
+
+    // Verdetto rispetto a performance-criteria.md
+    if (phases[BOOT_PHASE_DISPLAY].done) {
+        printCriterion("Display ready", phases[BOOT_PHASE_DISPLAY].end_us / 1000,
+                       BOOT_DISPLAY_READY_TARGET_MS, BOOT_DISPLAY_READY_ACCEPT_MS,
+                       BOOT_DISPLAY_READY_MAX_MS);
+    }
+    if (phases[BOOT_PHASE_MENU].done) {
+        printCriterion("Boot (menu)", phases[BOOT_PHASE_MENU].end_us / 1000,
+                       BOOT_TIME_TARGET_MS, BOOT_TIME_ACCEPT_MS, BOOT_TIME_MAX_MS);
+    }
+    if (phases[BOOT_PHASE_IMU].done && phases[BOOT_PHASE_RADAR].done) {
+        uint32_t sensorUs = (phases[BOOT_PHASE_IMU].end_us - phases[BOOT_PHASE_IMU].start_us) +
+                            (phases[BOOT_PHASE_RADAR].end_us - phases[BOOT_PHASE_RADAR].start_us);
+        printCriterion("Sensor init", sensorUs / 1000,
+                       BOOT_SENSOR_INIT_TARGET_MS, BOOT_SENSOR_INIT_ACCEPT_MS,
+                       BOOT_SENSOR_INIT_MAX_MS);
+    }
+    if (phases[BOOT_PHASE_TASKS].done) {
+        Serial.printf("Sensori pronti %5lums (in background)\n",
+                      (unsigned long)(phases[BOOT_PHASE_TASKS].end_us / 1000));
+    }
+    Serial.println("====================\n");
+}
@@ -0,0 +1,53 @@
+// boot_profiler.h
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+
+// === PROFILER DI BOOT ===
+// Timestamp di inizio/fine per ogni fase di boot, confrontati con i target di
+// docs/test-plans/performance-criteria.md. Il tempo è esp_timer (µs dall'avvio
+// dell'app): il bootloader ROM/2° stadio precede lo zero e non è incluso.
+// Le fasi sensori girano nel task di boot in parallelo a display e menu.
+
+enum BootPhase : uint8_t {
+    BOOT_PHASE_DISPLAY = 0,     // gfx->begin() + primo fillScreen
+    BOOT_PHASE_TOUCH,           // CST328 + IRQ
+    BOOT_PHASE_MENU,            // Menu principale a video
+    BOOT_PHASE_IMU,             // initIMU() con retry (task di boot)
+    BOOT_PHASE_RADAR,           // initRadar() con retry (task di boot)
+    BOOT_PHASE_TASKS,           // Bus manager + task sensori
+    BOOT_PHASE_COUNT
+};
+
+// === TARGET (target / accettabile / massimo, in ms) ===
+#define BOOT_DISPLAY_READY_TARGET_MS   100
+#define BOOT_DISPLAY_READY_ACCEPT_MS   200
+#define BOOT_DISPLAY_READY_MAX_MS      500
+#define BOOT_TIME_TARGET_MS            2000
+#define BOOT_TIME_ACCEPT_MS            3000
+#define BOOT_TIME_MAX_MS               5000
+#define BOOT_SENSOR_INIT_TARGET_MS     500
+#define BOOT_SENSOR_INIT_ACCEPT_MS     1000
+#define BOOT_SENSOR_INIT_MAX_MS        2000
+
+struct BootPhaseRecord {
+    uint32_t start_us;
+    uint32_t end_us;
+    bool started;
+    bool done;
+    bool ok;
+};
+
+void bootPhaseBegin(uint8_t phase);
+void bootPhaseEnd(uint8_t phase, bool ok = true);
+
+// Tutte le fasi registrate chiuse (UI + task di boot)
+bool isBootProfileComplete();
+void getBootPhase(uint8_t phase, BootPhaseRecord &record);
+const char *getBootPhaseName(uint8_t phase);
+
+// Tabella fasi + verdetto sui target
+void printBootProfile();
+
+#endif // BOOT_PROFILER_H
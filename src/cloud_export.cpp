@@ -0,0 +1,143 @@
+// cloud_export.cpp
+#include "cloud_export.h"
+#include "point_cloud_service.h"
+#include "sd_card.h"
+#include <SD.h>
+#include "esp_heap_caps.h"
+
+// === VARIABILI DI STATO ===
+static bool exporting = false;                  // Sotto exportMux
+static portMUX_TYPE exportMux = portMUX_INITIALIZER_UNLOCKED;
+static ExportPoint batch[CLOUD_EXPORT_BATCH];   // Solo chi ha exporting
+
+// File su SD come destinazione del writer
+class SDFileSink : public ExportSink {
+public:
+    explicit SDFileSink(File &f) : file(f) {}
+    bool write(const uint8_t *data, size_t len) override {
+        return file.write(data, len) == len;
+    }
+    bool rewrite(uint32_t offset, const uint8_t *data, size_t len) override {
+        return file.seek(offset) && file.write(data, len) == len;
+    }
+
+private:
+    File &file;
+};
+
+static bool nextFreePath(PointExportFormat format, char *path, size_t max) {
+    for (uint16_t i = 0; i < CLOUD_EXPORT_MAX_FILES; i++) {
+        snprintf(path, max, "/cloud_%03u.%s", i, pointExportExtension(format));
+        if (!SD.exists(path)) return true;
+    }
+    return false;
+}
+
+// Copia fino a CLOUD_EXPORT_BATCH punti da start; 0 = fine (o nuvola svuotata)
+static uint32_t copyBatch(uint32_t start, uint32_t end) {
+    PointCloudView view;
+    if (!lockPointCloud(view, CLOUD_EXPORT_LOCK_MS)) return 0;
+    uint32_t stop = end < view.count ? end : view.count;
+    uint32_t n = 0;
+    for (uint32_t i = start; i < stop && n < CLOUD_EXPORT_BATCH; i++, n++) {
+        ExportPoint &p = batch[n];
+        p.x_mm = view.x[i];
+        p.y_mm = view.y[i];
+        p.z_mm = view.z[i];
+        p.time_s = view.time_ms[i] / 1000.0;
+        p.strength = view.hits[i];
+        p.valid = 1;
+        p.flags = view.flags[i];
+    }
+    unlockPointCloud();
+    return n;
+}
+
+static bool exportFile(File &file, PointExportFormat format, uint8_t *chunk, uint32_t total,
+                       CloudExportResult &r, CloudExportProgress progress) {
+    SDFileSink sink(file);
+    PointExportWriter writer;
+    if (!writer.begin(sink, chunk, CLOUD_EXPORT_CHUNK_BYTES, format)) return false;
+
+    // Solo i punti presenti all'avvio: in STREAM la nuvola cresce intanto
+    uint32_t done = 0;
+    while (done < total) {
+        uint32_t n = copyBatch(done, total);
+        if (n == 0) break;
+        for (uint32_t i = 0; i < n; i++) {
+            if (!writer.add(batch[i])) return false;
+        }
+        done += n;
+        if (progress) progress(done, total);
+    }
+    if (!writer.finish()) return false;
+
+    r.points = writer.count();
+    r.bytes = (uint32_t)writer.bytes();
+    return true;
+}
+
+// === API ===
+bool exportPointCloudToSD(PointExportFormat format, CloudExportResult &r, CloudExportProgress progress) {
+    memset(&r, 0, sizeof(r));
+    r.format = format;
+
+    portENTER_CRITICAL(&exportMux);
+    bool busy = exporting;
+    exporting = true;
+    portEXIT_CRITICAL(&exportMux);
+    if (busy) {
+        r.status = CLOUD_EXPORT_BUSY;
+        return false;
+    }
+
+    uint32_t t0 = millis();
+    PointCloudStats stats;
+    getPointCloudStats(stats);
+    uint8_t *chunk = NULL;
+    File file;
+
+    if (stats.count == 0) {
+        r.status = CLOUD_EXPORT_EMPTY;
+    } else if (!mountSDCard() || !nextFreePath(format, r.path, sizeof(r.path))) {
+        r.status = CLOUD_EXPORT_NO_CARD;
+    } else if (!(chunk = (uint8_t *)heap_caps_malloc(CLOUD_EXPORT_CHUNK_BYTES,
+                                                      MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL))) {
+        r.status = CLOUD_EXPORT_NO_MEMORY;
+    } else if (!(file = SD.open(r.path, FILE_WRITE))) {
+        r.status = CLOUD_EXPORT_NO_CARD;
+    } else {
+        bool ok = exportFile(file, format, chunk, stats.count, r, progress);
+        file.close();
+        if (ok && r.points > 0) {
+            r.status = CLOUD_EXPORT_OK;
+        } else {
+            SD.remove(r.path);
+            r.status = ok ? CLOUD_EXPORT_EMPTY : CLOUD_EXPORT_WRITE_ERROR;
+        }
+    }
+
+    if (chunk) heap_caps_free(chunk);
+    r.duration_ms = millis() - t0;
+
+    portENTER_CRITICAL(&exportMux);
+    exporting = false;
+    portEXIT_CRITICAL(&exportMux);
+    return r.status == CLOUD_EXPORT_OK;
+}
+
+const char *cloudExportStatusName(uint8_t status) {
+    static const char *names[] = {"OK", "VUOTA", "OCCUPATO", "NO SD", "NO RAM", "ERRORE SCRITTURA"};
+    return status <= CLOUD_EXPORT_WRITE_ERROR ? names[status] : "?";
+}
+
+void printCloudExport(const CloudExportResult &r) {
+    if (r.status != CLOUD_EXPORT_OK) {
+        Serial.printf("❌ Export nuvola: %s\n", cloudExportStatusName(r.status));
+        return;
+    }
+    float kbps = r.duration_ms ? r.bytes / 1.024f / r.duration_ms : 0;
+    Serial.printf("✅ Export %s: %lu punti, %lu KB in %lums (%.0f KB/s)\n", r.path,
+                  (unsigned long)r.points, (unsigned long)(r.bytes / 1024),
+                  (unsigned long)r.duration_ms, kbps);
+}
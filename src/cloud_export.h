@@ -0,0 +1,46 @@
+// cloud_export.h
+#ifndef CLOUD_EXPORT_H
+#define CLOUD_EXPORT_H
+
+#include <Arduino.h>
+#include "point_export.h"
+
+// === EXPORT NUVOLA SU SD ===
+// La nuvola viene copiata a lotti brevi sotto lock (l'accumulo continua fra
+// un lotto e l'altro) e scritta su /cloud_NNN.ply|xyz in blocchi da
+// CLOUD_EXPORT_CHUNK_BYTES: scritture grandi e sequenziali, le più veloci
+// per la SD in SPI. Bloccante: da chiamare da UI o console, mai dal task
+// sensori. Un export alla volta.
+
+#define CLOUD_EXPORT_CHUNK_BYTES   16384   // RAM interna DMA, liberata a fine export
+#define CLOUD_EXPORT_BATCH         256     // Punti copiati per lock
+#define CLOUD_EXPORT_LOCK_MS       200
+#define CLOUD_EXPORT_MAX_FILES     1000
+
+enum CloudExportStatus : uint8_t {
+    CLOUD_EXPORT_OK = 0,
+    CLOUD_EXPORT_EMPTY,         // Nessun punto
+    CLOUD_EXPORT_BUSY,          // Export già in corso
+    CLOUD_EXPORT_NO_CARD,
+    CLOUD_EXPORT_NO_MEMORY,
+    CLOUD_EXPORT_WRITE_ERROR    // Il file parziale viene rimosso
+};
+
+struct CloudExportResult {
+    uint8_t status;             // CloudExportStatus
+    uint8_t format;             // PointExportFormat
+    char path[24];
+    uint32_t points;
+    uint32_t bytes;
+    uint32_t duration_ms;
+};
+
+// Chiamata dopo ogni lotto (done <= total), può essere NULL
+typedef void (*CloudExportProgress)(uint32_t done, uint32_t total);
+
+bool exportPointCloudToSD(PointExportFormat format, CloudExportResult &result,
+                          CloudExportProgress progress = NULL);
+const char *cloudExportStatusName(uint8_t status);
+void printCloudExport(const CloudExportResult &result);
+
+#endif // CLOUD_EXPORT_H
@@ -20,6 +20,10 @@
 
 #define TP_SDA      1
 #define TP_SCL      3
+#define SD_CS       21
+#define SD_SCK      14
+#define SD_MISO     16
+#define SD_MOSI     17
 
 // === COLORS ===
 #define COLOR_BLACK       0x0000
@@ -0,0 +1,319 @@
+// config_schema.h
+// Configurazione persistente tipizzata: schema versionato, record con CRC32
+// e logica di load/save indipendente dal supporto. Header puro C++: il
+// backend NVS è in config_store.cpp, quello in RAM serve ai test host.
+//
+// Regola di evoluzione dello schema: i campi si aggiungono solo in coda a
+// DeviceConfig. Un record più vecchio viene letto per la parte che contiene
+// e i campi nuovi restano ai default; configMigrate() sistema i casi in cui
+// serve convertire un valore.
+#ifndef CONFIG_SCHEMA_H
+#define CONFIG_SCHEMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CONFIG_SCHEMA_VERSION  8
+#define CONFIG_RECORD_MAGIC    0x46435948u  // "HYCF"
+#define CONFIG_RECORD_MAX      256          // Header + payload
+
+// === SCHEMA (v8) ===
+struct DeviceConfig {
+    // Calibrazione magnetometro
+    float mag_offset[3];
+    float mag_scale[3];         // v1: semiassi min/max (scritto ancora come 1/W[i][i])
+    uint8_t mag_calibrated;
+
+    uint8_t radar_profile;      // 1..5
+    uint8_t telemetry_enabled;
+    uint8_t reserved0;
+
+    // Radar
+    uint32_t range_start_mm;
+    uint32_t range_end_mm;
+    float kalman_process;
+    float kalman_measure;
+    float kalman_init_error;
+    float smoothing;
+
+    // IMU
+    float pitch_dead_zone;
+    float yaw_dead_zone;
+
+    // v2: fit di ellissoide (mag_calibration.h)
+    float mag_soft_iron[9];     // W riga per riga: m = W (raw - offset)
+    float mag_field_ut;
+    float mag_residual_ut;
+    float mag_coverage;
+
+    // v3: calibrazione giroscopio/accelerometro (imu_calibration.h)
+    float gyro_bias_dps[3];
+    float accel_offset[3];      // m/s²
+    float accel_scale[3];
+    uint8_t gyro_calibrated;
+    uint8_t accel_calibrated;
+    uint8_t reserved1[2];
+
+    // v4: misura su trigger (measurement.h)
+    uint8_t measure_pre;
+    uint8_t measure_post;
+    uint8_t reserved2[2];
+    float measure_max_distance_sd_mm;
+    float measure_max_angle_sd_deg;
+
+    // v5: cattura automatica da fermo (auto_capture_detector.h)
+    uint8_t capture_enabled;
+    uint8_t reserved3[3];
+    float capture_max_rate_dps;
+    float capture_max_distance_sd_mm;
+    uint32_t capture_hold_ms;
+
+    // v6: nuvola di punti (point_cloud_service.h)
+    uint8_t cloud_mode;
+    uint8_t reserved4[3];
+    float cloud_voxel_mm;
+
+    // v7: montaggio del radar (coord_transform.h)
+    float mount_offset_mm[3];
+    float mount_pitch_offset_deg;
+    float mount_yaw_offset_deg;
+
+    // v8: mappa di quota (height_map_service.h)
+    uint8_t hmap_mode;
+    uint8_t reserved5[3];
+    float hmap_cell_deg;
+    float hmap_cell_mm;
+};
+
+// Stessi default dei driver (radar_handler.cpp, imu_handler.cpp)
+inline void configDefaults(DeviceConfig &c) {
+    memset(&c, 0, sizeof(c));
+    for (int i = 0; i < 3; i++) {
+        c.mag_scale[i] = 1.0f;
+        c.mag_soft_iron[i * 4] = 1.0f;
+        c.accel_scale[i] = 1.0f;
+    }
+    c.radar_profile = 2;
+    c.range_start_mm = 250;
+    c.range_end_mm = 1500;
+    c.kalman_process = 20;
+    c.kalman_measure = 10;
+    c.kalman_init_error = 0.1f;
+    c.smoothing = 0.2f;
+    c.pitch_dead_zone = 0.1f;
+    c.yaw_dead_zone = 0.15f;
+    c.measure_pre = 5;
+    c.measure_post = 0;
+    c.measure_max_distance_sd_mm = 5.0f;
+    c.measure_max_angle_sd_deg = 0.5f;
+    c.capture_max_rate_dps = 2.0f;
+    c.capture_max_distance_sd_mm = 3.0f;
+    c.capture_hold_ms = 500;
+    c.cloud_voxel_mm = 10.0f;
+    c.hmap_cell_deg = 1.0f;
+    c.hmap_cell_mm = 50.0f;
+}
+
+// === RECORD ===
+struct ConfigRecordHeader {
+    uint32_t magic;
+    uint16_t schema;            // CONFIG_SCHEMA_VERSION di chi ha scritto
+    uint16_t length;            // Byte di payload (sizeof(DeviceConfig) dello schema)
+    uint32_t sequence;          // Salvataggi totali (diagnostica usura)
+    uint32_t crc;               // CRC32 del payload
+};
+
+static_assert(sizeof(DeviceConfig) + sizeof(ConfigRecordHeader) <= CONFIG_RECORD_MAX,
+              "DeviceConfig troppo grande per il record");
+
+// CRC-32 (IEEE, riflesso) con tabella a nibble
+inline uint32_t configCrc32(const void *data, size_t len, uint32_t crc = 0) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ p[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (p[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+inline size_t configEncode(const DeviceConfig &c, uint32_t sequence, uint8_t *buf) {
+    ConfigRecordHeader h;
+    h.magic = CONFIG_RECORD_MAGIC;
+    h.schema = CONFIG_SCHEMA_VERSION;
+    h.length = sizeof(DeviceConfig);
+    h.sequence = sequence;
+    h.crc = configCrc32(&c, sizeof(c));
+    memcpy(buf, &h, sizeof(h));
+    memcpy(buf + sizeof(h), &c, sizeof(c));
+    return sizeof(h) + sizeof(c);
+}
+
+enum ConfigLoadResult {
+    CONFIG_LOAD_OK = 0,
+    CONFIG_LOAD_MIGRATED,       // Schema diverso: convertito, da risalvare
+    CONFIG_LOAD_EMPTY,          // Nessun record: default
+    CONFIG_LOAD_CORRUPT         // Magic/lunghezza/CRC errati: default
+};
+
+// Conversioni puntuali fra versioni (i campi nuovi sono già ai default)
+inline void configMigrate(DeviceConfig &c, uint16_t fromSchema) {
+    // v1 -> v2: la calibrazione min/max diventa una matrice diagonale
+    if (fromSchema < 2) {
+        for (int i = 0; i < 3; i++) {
+            c.mag_soft_iron[i * 4] = c.mag_scale[i] != 0 ? 1.0f / c.mag_scale[i] : 1.0f;
+        }
+    }
+}
+
+inline ConfigLoadResult configDecode(const uint8_t *buf, size_t len, DeviceConfig &c,
+                                     uint32_t &sequence) {
+    configDefaults(c);
+    sequence = 0;
+    if (len == 0) return CONFIG_LOAD_EMPTY;
+    if (len < sizeof(ConfigRecordHeader)) return CONFIG_LOAD_CORRUPT;
+
+    ConfigRecordHeader h;
+    memcpy(&h, buf, sizeof(h));
+    if (h.magic != CONFIG_RECORD_MAGIC || h.schema == 0 ||
+        sizeof(h) + h.length > len) {
+        return CONFIG_LOAD_CORRUPT;
+    }
+    const uint8_t *payload = buf + sizeof(h);
+    if (configCrc32(payload, h.length) != h.crc) return CONFIG_LOAD_CORRUPT;
+
+    // Prefisso comune: un record più lungo (firmware più nuovo) perde solo
+    // i campi che questo firmware non conosce
+    memcpy(&c, payload, h.length < sizeof(c) ? h.length : sizeof(c));
+    sequence = h.sequence;
+
+    if (h.schema != CONFIG_SCHEMA_VERSION || h.length != sizeof(c)) {
+        configMigrate(c, h.schema);
+        return CONFIG_LOAD_MIGRATED;
+    }
+    return CONFIG_LOAD_OK;
+}
+
+// === SUPPORTO ===
+// Un solo record sostituito in modo atomico: o resta il vecchio o c'è il
+// nuovo (NVS lo garantisce scrivendo la nuova entry prima di invalidare
+// la precedente, e ruota le pagine per il wear levelling).
+class ConfigBackend {
+public:
+    virtual ~ConfigBackend() {}
+    virtual size_t read(uint8_t *buf, size_t max) = 0;     // 0 = nessun record
+    virtual bool write(const uint8_t *buf, size_t len) = 0;
+    virtual bool erase() = 0;
+};
+
+// Backend in RAM per i test host, con guasti simulati
+class ConfigMemoryBackend : public ConfigBackend {
+public:
+    ConfigMemoryBackend() : len(0), writes(0), failNextWrite(false) {}
+
+    size_t read(uint8_t *buf, size_t max) override {
+        size_t n = len < max ? len : max;
+        memcpy(buf, data, n);
+        return n;
+    }
+    bool write(const uint8_t *buf, size_t n) override {
+        if (failNextWrite || n > sizeof(data)) {
+            failNextWrite = false;
+            return false;       // Il record precedente resta intatto
+        }
+        memcpy(data, buf, n);
+        len = n;
+        writes++;
+        return true;
+    }
+    bool erase() override {
+        len = 0;
+        return true;
+    }
+
+    uint8_t data[CONFIG_RECORD_MAX];
+    size_t len;
+    uint32_t writes;
+    bool failNextWrite;
+};
+
+// === STORE (copia in RAM + salvataggio differito) ===
+// Non thread-safe: config_store.cpp serializza gli accessi.
+class ConfigStoreCore {
+public:
+    explicit ConfigStoreCore(ConfigBackend &b)
+        : backend(b), sequence(0), savedCrc(0), dirty(false), saves(0), skipped(0), failures(0) {
+        configDefaults(config);
+    }
+
+    ConfigLoadResult load() {
+        uint8_t buf[CONFIG_RECORD_MAX];
+        size_t n = backend.read(buf, sizeof(buf));
+        ConfigLoadResult r = configDecode(buf, n, config, sequence);
+        savedCrc = (r == CONFIG_LOAD_OK) ? configCrc32(&config, sizeof(config)) : 0;
+        dirty = (r == CONFIG_LOAD_MIGRATED);
+        return r;
+    }
+
+    const DeviceConfig &get() const { return config; }
+
+    void set(const DeviceConfig &c) {
+        config = c;
+        dirty = true;
+    }
+
+    bool isDirty() const { return dirty; }
+
+    // Scrive solo se il contenuto è cambiato dall'ultimo salvataggio
+    bool save() {
+        if (!dirty) return true;
+        uint32_t crc = configCrc32(&config, sizeof(config));
+        if (crc == savedCrc && sequence > 0) {
+            dirty = false;
+            skipped++;
+            return true;
+        }
+
+        uint8_t buf[CONFIG_RECORD_MAX];
+        size_t n = configEncode(config, sequence + 1, buf);
+        if (!backend.write(buf, n)) {
+            failures++;
+            return false;       // Resta dirty: si ritenta
+        }
+        sequence++;
+        savedCrc = crc;
+        dirty = false;
+        saves++;
+        return true;
+    }
+
+    bool reset() {
+        configDefaults(config);
+        sequence = 0;
+        savedCrc = 0;
+        dirty = false;
+        return backend.erase();
+    }
+
+    uint32_t getSequence() const { return sequence; }
+    uint32_t getSaves() const { return saves; }
+    uint32_t getSkipped() const { return skipped; }
+    uint32_t getFailures() const { return failures; }
+
+private:
+    ConfigBackend &backend;
+    DeviceConfig config;
+    uint32_t sequence;
+    uint32_t savedCrc;
+    bool dirty;
+    uint32_t saves;
+    uint32_t skipped;
+    uint32_t failures;
+};
+
+#endif // CONFIG_SCHEMA_H
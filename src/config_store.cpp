@@ -0,0 +1,312 @@
+// config_store.cpp
+#include "config_store.h"
+#include "task_config.h"
+#include "radar_handler.h"
+#include "imu_handler.h"
+#include "telemetry.h"
+#include "sensor_tasks.h"
+#include "measure_service.h"
+#include "auto_capture.h"
+#include "point_cloud_service.h"
+#include "height_map_service.h"
+#include <Preferences.h>
+#include <EEPROM.h>
+
+// === VECCHIO LAYOUT EEPROM (solo importazione) ===
+#define LEGACY_EEPROM_SIZE       64
+#define LEGACY_EEPROM_FLAG_ADDR  48      // 1 = calibrazione magnetometro valida
+
+// === BACKEND NVS ===
+class NVSConfigBackend : public ConfigBackend {
+public:
+    size_t read(uint8_t *buf, size_t max) override {
+        if (!prefs.begin(CONFIG_NVS_NAMESPACE, true)) return 0;
+        size_t n = prefs.isKey(CONFIG_NVS_KEY) ? prefs.getBytes(CONFIG_NVS_KEY, buf, max) : 0;
+        prefs.end();
+        return n;
+    }
+
+    // Blob NVS: la nuova entry è scritta prima di invalidare la vecchia
+    bool write(const uint8_t *buf, size_t len) override {
+        if (!prefs.begin(CONFIG_NVS_NAMESPACE, false)) return false;
+        size_t n = prefs.putBytes(CONFIG_NVS_KEY, buf, len);
+        prefs.end();
+        return n == len;
+    }
+
+    bool erase() override {
+        if (!prefs.begin(CONFIG_NVS_NAMESPACE, false)) return false;
+        bool ok = prefs.clear();
+        prefs.end();
+        return ok;
+    }
+
+private:
+    Preferences prefs;
+};
+
+// === VARIABILI DI STATO ===
+static NVSConfigBackend nvsBackend;
+static ConfigStoreCore store(nvsBackend);
+static SemaphoreHandle_t storeMutex = NULL;
+static TaskHandle_t configTaskHandle = NULL;
+static volatile uint32_t lastChangeMs = 0;
+
+// === IMPORTAZIONE EEPROM ===
+static bool importLegacyEEPROM(DeviceConfig &config) {
+    EEPROM.begin(LEGACY_EEPROM_SIZE);
+    if (EEPROM.read(LEGACY_EEPROM_FLAG_ADDR) != 1) return false;
+
+    for (int i = 0; i < 3; i++) {
+        config.mag_offset[i] = EEPROM.readFloat(i * 4);
+        config.mag_scale[i] = EEPROM.readFloat((i + 3) * 4);
+    }
+    configMigrate(config, 1);   // Scala min/max -> matrice soft iron
+    config.mag_calibrated = 1;
+    return true;
+}
+
+static void clearLegacyEEPROM() {
+    EEPROM.begin(LEGACY_EEPROM_SIZE);
+    EEPROM.write(LEGACY_EEPROM_FLAG_ADDR, 0xFF);
+    EEPROM.commit();
+}
+
+// === TASK SALVATAGGIO ===
+static bool saveNow() {
+    if (!TAKE_MUTEX(storeMutex, portMAX_DELAY)) return false;
+    bool ok = store.save();
+    GIVE_MUTEX(storeMutex);
+    return ok;
+}
+
+static void configStoreTask(void *pvParameters) {
+    RTOS_LOG("Config store task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_CONFIG);
+    int8_t sub = -1;
+
+    while (1) {
+        // Dorme finché qualcuno modifica la configurazione
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Debounce: ogni nuova modifica sposta il salvataggio
+        while (1) {
+            int32_t wait = CONFIG_SAVE_DEBOUNCE_MS - (int32_t)(millis() - lastChangeMs);
+            if (wait <= 0) break;
+            ulTaskNotifyTake(pdTRUE, MS_TO_TICKS(wait));
+        }
+
+        // Allinea la scrittura flash alla pausa dopo un campione
+        if (getSensorBootState() == SENSOR_BOOT_DONE) {
+            if (sub < 0) sub = subscribeSensorData("config", PUBSUB_LATEST_ONLY);
+            SensorData data;
+            if (sub >= 0) readSensorData(sub, data, CONFIG_SAVE_SYNC_MS);
+        }
+
+        uint32_t start = millis();
+        if (saveNow()) {
+            RTOS_LOG("Config saved in %lums", (unsigned long)(millis() - start));
+        } else {
+            Serial.println("⚠️ Salvataggio configurazione fallito, ritento");
+            vTaskDelay(MS_TO_TICKS(CONFIG_SAVE_RETRY_MS));
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle());
+        }
+    }
+}
+
+// === API ===
+bool initConfigStore() {
+    if (storeMutex) return true;
+    storeMutex = xSemaphoreCreateMutex();
+    if (!storeMutex) return false;
+    flightRegisterMutex(storeMutex, FR_MUTEX_CONFIG);
+
+    ConfigLoadResult result = store.load();
+    switch (result) {
+        case CONFIG_LOAD_OK:
+            Serial.printf("✅ Configurazione caricata (salvataggio #%lu)\n",
+                          (unsigned long)store.getSequence());
+            break;
+        case CONFIG_LOAD_MIGRATED:
+            Serial.println("⚙️ Configurazione migrata allo schema corrente");
+            break;
+        case CONFIG_LOAD_CORRUPT:
+            Serial.println("⚠️ Configurazione corrotta: uso i default");
+            break;
+        case CONFIG_LOAD_EMPTY: {
+            DeviceConfig config = store.get();
+            config.telemetry_enabled = TELEMETRY_AUTOSTART;
+            if (importLegacyEEPROM(config)) {
+                Serial.println("⚙️ Calibrazione importata dalla vecchia EEPROM");
+            }
+            store.set(config);
+            break;
+        }
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(
+        configStoreTask,
+        "ConfigStore",
+        CONFIG_TASK_STACK_SIZE,
+        NULL,
+        CONFIG_TASK_PRIORITY,
+        &configTaskHandle,
+        CONFIG_TASK_CORE
+    );
+    if (ok != pdPASS) {
+        Serial.println("❌ Failed to create config store task");
+        return false;
+    }
+
+    // Migrazione/importazione: risalva in background
+    if (store.isDirty()) {
+        lastChangeMs = millis();
+        xTaskNotifyGive(configTaskHandle);
+    }
+    return true;
+}
+
+void getConfig(DeviceConfig &config) {
+    if (!storeMutex || !TAKE_MUTEX(storeMutex, portMAX_DELAY)) {
+        configDefaults(config);
+        return;
+    }
+    config = store.get();
+    GIVE_MUTEX(storeMutex);
+}
+
+void updateConfig(ConfigMutator mutate, void *ctx) {
+    if (!storeMutex || !TAKE_MUTEX(storeMutex, portMAX_DELAY)) return;
+    DeviceConfig config = store.get();
+    mutate(config, ctx);
+    store.set(config);
+    GIVE_MUTEX(storeMutex);
+
+    lastChangeMs = millis();
+    if (configTaskHandle) xTaskNotifyGive(configTaskHandle);
+}
+
+void applyConfigTunables() {
+    DeviceConfig c;
+    getConfig(c);
+    setRadarRange(c.range_start_mm, c.range_end_mm);
+    setRadarProfile(c.radar_profile);
+    setKalmanParameters(c.kalman_process, c.kalman_measure, c.kalman_init_error);
+    setSmoothingFactor(c.smoothing);
+    setDeadZones(c.pitch_dead_zone, c.yaw_dead_zone);
+    setTelemetryEnabled(c.telemetry_enabled);
+
+    MeasureConfig m = {c.measure_pre, c.measure_post,
+                       c.measure_max_distance_sd_mm, c.measure_max_angle_sd_deg};
+    setMeasureConfig(m);
+
+    AutoCaptureConfig a = {c.capture_max_rate_dps, c.capture_max_distance_sd_mm, c.capture_hold_ms};
+    setAutoCaptureConfig(a);
+    setAutoCaptureEnabled(c.capture_enabled);
+
+    setPointCloudMode((PointCloudMode)c.cloud_mode);
+    setPointCloudVoxel(c.cloud_voxel_mm);
+
+    CoordMount mount = {{c.mount_offset_mm[0], c.mount_offset_mm[1], c.mount_offset_mm[2]},
+                        c.mount_pitch_offset_deg, c.mount_yaw_offset_deg};
+    setPointCloudMount(mount);
+
+    setHeightMapMode((HeightMapMode)c.hmap_mode);
+    setHeightMapCells(c.hmap_cell_deg, c.hmap_cell_mm);
+}
+
+// Getter dei moduli: solo copie di variabili, adatti a girare sotto il lock
+static void captureTunables(DeviceConfig &c, void *) {
+    getRadarRange(c.range_start_mm, c.range_end_mm);
+    c.radar_profile = getRadarProfile();
+    getKalmanParameters(c.kalman_process, c.kalman_measure, c.kalman_init_error);
+    c.smoothing = getSmoothingFactor();
+    getDeadZones(c.pitch_dead_zone, c.yaw_dead_zone);
+    c.telemetry_enabled = isTelemetryEnabled();
+
+    MeasureConfig m;
+    getMeasureConfig(m);
+    c.measure_pre = m.pre_samples;
+    c.measure_post = m.post_samples;
+    c.measure_max_distance_sd_mm = m.max_distance_sd_mm;
+    c.measure_max_angle_sd_deg = m.max_angle_sd_deg;
+
+    AutoCaptureConfig a;
+    getAutoCaptureConfig(a);
+    c.capture_enabled = isAutoCaptureEnabled();
+    c.capture_max_rate_dps = a.max_rate_dps;
+    c.capture_max_distance_sd_mm = a.max_distance_sd_mm;
+    c.capture_hold_ms = a.hold_ms;
+
+    c.cloud_mode = getPointCloudMode();
+    c.cloud_voxel_mm = getPointCloudVoxel();
+
+    CoordMount mount;
+    getPointCloudMount(mount);
+    for (int i = 0; i < 3; i++) c.mount_offset_mm[i] = mount.offset_mm[i];
+    c.mount_pitch_offset_deg = mount.pitch_offset_deg;
+    c.mount_yaw_offset_deg = mount.yaw_offset_deg;
+
+    c.hmap_mode = getHeightMapMode();
+    getHeightMapCells(c.hmap_cell_deg, c.hmap_cell_mm);
+}
+
+void captureConfigTunables() {
+    updateConfig(captureTunables);
+}
+
+bool flushConfig() {
+    return storeMutex && saveNow();
+}
+
+bool factoryResetConfig() {
+    if (!storeMutex || !TAKE_MUTEX(storeMutex, portMAX_DELAY)) return false;
+    bool ok = store.reset();
+    GIVE_MUTEX(storeMutex);
+
+    // Altrimenti al riavvio la vecchia calibrazione verrebbe reimportata
+    clearLegacyEEPROM();
+    return ok;
+}
+
+void printConfig() {
+    DeviceConfig c;
+    getConfig(c);
+
+    Serial.println("\n=== Configurazione ===");
+    Serial.printf("Schema v%d, salvataggi %lu (saltati %lu, falliti %lu)\n",
+                  CONFIG_SCHEMA_VERSION, (unsigned long)store.getSequence(),
+                  (unsigned long)store.getSkipped(), (unsigned long)store.getFailures());
+    Serial.printf("Mag %s offset %.2f %.2f %.2f campo %.1fuT residuo %.2fuT copertura %.0f%%\n",
+                  c.mag_calibrated ? "calibrato" : "non calibrato",
+                  c.mag_offset[0], c.mag_offset[1], c.mag_offset[2],
+                  c.mag_field_ut, c.mag_residual_ut, c.mag_coverage * 100.0f);
+    for (int r = 0; r < 3; r++) {
+        Serial.printf("  W %8.4f %8.4f %8.4f\n", c.mag_soft_iron[r * 3],
+                      c.mag_soft_iron[r * 3 + 1], c.mag_soft_iron[r * 3 + 2]);
+    }
+    Serial.printf("Gyro %s bias %.3f %.3f %.3f dps\n", c.gyro_calibrated ? "calibrato" : "non calibrato",
+                  c.gyro_bias_dps[0], c.gyro_bias_dps[1], c.gyro_bias_dps[2]);
+    Serial.printf("Accel %s offset %.3f %.3f %.3f scala %.4f %.4f %.4f\n",
+                  c.accel_calibrated ? "calibrato" : "non calibrato",
+                  c.accel_offset[0], c.accel_offset[1], c.accel_offset[2],
+                  c.accel_scale[0], c.accel_scale[1], c.accel_scale[2]);
+    Serial.printf("Radar range %lu-%lumm, profilo %d, kalman %.1f/%.1f/%.3f, smooth %.2f\n",
+                  (unsigned long)c.range_start_mm, (unsigned long)c.range_end_mm,
+                  c.radar_profile, c.kalman_process, c.kalman_measure,
+                  c.kalman_init_error, c.smoothing);
+    Serial.printf("Dead zone pitch %.2f yaw %.2f, telemetria %s\n",
+                  c.pitch_dead_zone, c.yaw_dead_zone, c.telemetry_enabled ? "ON" : "OFF");
+    Serial.printf("Misura %u pre + %u post, stabilità %.1fmm / %.2f°\n",
+                  c.measure_pre, c.measure_post,
+                  c.measure_max_distance_sd_mm, c.measure_max_angle_sd_deg);
+    Serial.printf("Auto-capture %s: %.1f dps, %.1fmm, %lums\n", c.capture_enabled ? "ON" : "OFF",
+                  c.capture_max_rate_dps, c.capture_max_distance_sd_mm,
+                  (unsigned long)c.capture_hold_ms);
+    Serial.printf("Point cloud modo %u, voxel %.1fmm\n", c.cloud_mode, c.cloud_voxel_mm);
+    Serial.printf("Montaggio radar %.1f %.1f %.1f mm, pitch %+.2f° yaw %+.2f°\n",
+                  c.mount_offset_mm[0], c.mount_offset_mm[1], c.mount_offset_mm[2],
+                  c.mount_pitch_offset_deg, c.mount_yaw_offset_deg);
+    Serial.printf("Height map modo %u, celle %.2f° / %.0fmm\n", c.hmap_mode, c.hmap_cell_deg, c.hmap_cell_mm);
+    Serial.println("======================\n");
+}
@@ -0,0 +1,44 @@
+// config_store.h
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include "config_schema.h"
+
+// === CONFIGURAZIONE PERSISTENTE (NVS) ===
+// Caricata una volta al boot in RAM; le modifiche aggiornano la copia in RAM
+// e il salvataggio avviene in un task a bassa priorità, dopo una pausa di
+// debounce e subito dopo un campione sensori: la scrittura flash (che ferma
+// la cache di entrambi i core) cade nella pausa fra due cicli I2C.
+
+#define CONFIG_NVS_NAMESPACE     "hyseq"
+#define CONFIG_NVS_KEY           "config"
+#define CONFIG_SAVE_DEBOUNCE_MS  2000    // Raggruppa modifiche ravvicinate (slider, console)
+#define CONFIG_SAVE_RETRY_MS     5000    // Dopo una scrittura fallita
+#define CONFIG_SAVE_SYNC_MS      250     // Attesa max del prossimo campione
+
+// Carica da NVS (o importa la vecchia calibrazione EEPROM) e avvia il task
+bool initConfigStore();
+
+// Copia della configurazione corrente
+void getConfig(DeviceConfig &config);
+
+// Modifica della copia in RAM sotto il lock dello store, poi salvataggio
+// pianificato: due scrittori concorrenti non si sovrascrivono i campi.
+// mutate deve essere breve (niente I2C, niente attese su altri task).
+typedef void (*ConfigMutator)(DeviceConfig &config, void *ctx);
+void updateConfig(ConfigMutator mutate, void *ctx = NULL);
+
+// Applica i parametri di tuning ai driver / li rilegge dai driver
+void applyConfigTunables();
+void captureConfigTunables();
+
+// Salva subito (bloccante, fuori dal percorso caldo: factory reset, shutdown)
+bool flushConfig();
+
+// Cancella configurazione e vecchia EEPROM: al riavvio tornano i default
+bool factoryResetConfig();
+
+void printConfig();
+
+#endif // CONFIG_STORE_H
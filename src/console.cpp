@@ -0,0 +1,780 @@
+// console.cpp
+#include "console.h"
+#include "task_config.h"
+#include "radar_handler.h"
+#include "imu_handler.h"
+#include "i2c_bus.h"
+#include "sensor_tasks.h"
+#include "sensor_health.h"
+#include "boot_profiler.h"
+#include "telemetry.h"
+#include "config_store.h"
+#include "inclinometer.h"
+#include "measure_service.h"
+#include "auto_capture.h"
+#include "point_cloud_service.h"
+#include "cloud_export.h"
+#include "height_map_service.h"
+#include "data_logger.h"
+#include "flight_recorder_service.h"
+#include "system_monitor_service.h"
+#include "power_manager.h"
+#include <stdlib.h>
+#include <math.h>
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t consoleTaskHandle = NULL;
+static char lineBuffer[CONSOLE_LINE_MAX];
+static uint8_t lineLength = 0;
+static bool lineOverflow = false;
+
+// === TOKENIZER ===
+// Divide la riga in place sugli spazi: argv punta dentro line
+static uint8_t tokenize(char *line, char *argv[], uint8_t maxArgs) {
+    uint8_t argc = 0;
+    char *p = line;
+    while (*p) {
+        while (*p == ' ' || *p == '\t') *p++ = '\0';
+        if (!*p) break;
+        if (argc == maxArgs) return maxArgs + 1;    // Troppi argomenti
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+    }
+    return argc;
+}
+
+static bool parseFloat(const char *s, float &out) {
+    char *end;
+    out = strtof(s, &end);
+    return end != s && *end == '\0' && isfinite(out);
+}
+
+// === PARAMETRI ===
+// get riempie values e ritorna quanti sono; set riceve i valori già
+// convertiti e controlla i range (false = rifiutato)
+struct ConsoleParam {
+    const char *name;
+    const char *usage;
+    uint8_t minValues;
+    uint8_t maxValues;
+    bool onRadarBus;            // set eseguito come job I2C sul radar
+    uint8_t (*get)(float *values);
+    bool (*set)(const float *values, uint8_t count);
+};
+
+static uint8_t getKalman(float *v) {
+    getKalmanParameters(v[0], v[1], v[2]);
+    return 3;
+}
+static bool setKalman(const float *v, uint8_t n) {
+    if (v[0] <= 0 || v[1] <= 0 || (n > 2 && v[2] <= 0)) return false;
+    float process, measure, initError;
+    getKalmanParameters(process, measure, initError);   // initError omesso: resta il corrente
+    setKalmanParameters(v[0], v[1], n > 2 ? v[2] : initError);
+    return true;
+}
+
+static uint8_t getSmoothing(float *v) {
+    v[0] = getSmoothingFactor();
+    return 1;
+}
+static bool setSmoothing(const float *v, uint8_t n) {
+    if (v[0] < 0 || v[0] > 1) return false;
+    setSmoothingFactor(v[0]);
+    return true;
+}
+
+static uint8_t getRange(float *v) {
+    uint32_t start, end;
+    getRadarRange(start, end);
+    v[0] = start;
+    v[1] = end;
+    return 2;
+}
+static bool setRange(const float *v, uint8_t n) {
+    if (v[0] < 0 || v[1] <= v[0]) return false;
+    setRadarRange((uint32_t)v[0], (uint32_t)v[1]);
+    return true;
+}
+
+static uint8_t getProfile(float *v) {
+    v[0] = getRadarProfile();
+    return 1;
+}
+static bool setProfile(const float *v, uint8_t n) {
+    if (v[0] != floorf(v[0]) || v[0] < 1 || v[0] > 5) return false;
+    setRadarProfile((uint8_t)v[0]);
+    return true;
+}
+
+static uint8_t getDeadZone(float *v) {
+    getDeadZones(v[0], v[1]);
+    return 2;
+}
+static bool setDeadZone(const float *v, uint8_t n) {
+    if (v[0] < 0 || v[1] < 0) return false;
+    setDeadZones(v[0], v[1]);
+    return true;
+}
+
+static uint8_t getTelemetry(float *v) {
+    v[0] = isTelemetryEnabled() ? 1 : 0;
+    return 1;
+}
+static bool setTelemetry(const float *v, uint8_t n) {
+    if (v[0] != 0 && v[0] != 1) return false;
+    setTelemetryEnabled(v[0] == 1);
+    return true;
+}
+
+static uint8_t getMeasureWindow(float *v) {
+    MeasureConfig c;
+    getMeasureConfig(c);
+    v[0] = c.pre_samples;
+    v[1] = c.post_samples;
+    return 2;
+}
+static bool setMeasureWindow(const float *v, uint8_t n) {
+    if (v[0] != floorf(v[0]) || v[1] != floorf(v[1]) || v[0] < 0 || v[1] < 0 ||
+        v[0] + v[1] < 1 || v[0] + v[1] > MEASURE_MAX_SAMPLES) {
+        return false;
+    }
+    MeasureConfig c;
+    getMeasureConfig(c);
+    c.pre_samples = (uint8_t)v[0];
+    c.post_samples = (uint8_t)v[1];
+    setMeasureConfig(c);
+    return true;
+}
+
+static uint8_t getMeasureLimits(float *v) {
+    MeasureConfig c;
+    getMeasureConfig(c);
+    v[0] = c.max_distance_sd_mm;
+    v[1] = c.max_angle_sd_deg;
+    return 2;
+}
+static bool setMeasureLimits(const float *v, uint8_t n) {
+    if (v[0] <= 0 || v[1] <= 0) return false;
+    MeasureConfig c;
+    getMeasureConfig(c);
+    c.max_distance_sd_mm = v[0];
+    c.max_angle_sd_deg = v[1];
+    setMeasureConfig(c);
+    return true;
+}
+
+static uint8_t getCaptureEnabled(float *v) {
+    v[0] = isAutoCaptureEnabled() ? 1 : 0;
+    return 1;
+}
+static bool setCaptureEnabled(const float *v, uint8_t n) {
+    if (v[0] != 0 && v[0] != 1) return false;
+    setAutoCaptureEnabled(v[0] == 1);
+    return true;
+}
+
+static uint8_t getCaptureLimits(float *v) {
+    AutoCaptureConfig c;
+    getAutoCaptureConfig(c);
+    v[0] = c.max_rate_dps;
+    v[1] = c.max_distance_sd_mm;
+    v[2] = c.hold_ms;
+    return 3;
+}
+static bool setCaptureLimits(const float *v, uint8_t n) {
+    if (v[0] <= 0 || v[1] <= 0 || v[2] < 0 || v[2] > 60000) return false;
+    AutoCaptureConfig c = {v[0], v[1], (uint32_t)v[2]};
+    setAutoCaptureConfig(c);
+    return true;
+}
+
+static uint8_t getCloudMode(float *v) {
+    v[0] = getPointCloudMode();
+    return 1;
+}
+static bool setCloudMode(const float *v, uint8_t n) {
+    if (v[0] != floorf(v[0]) || v[0] < POINT_CLOUD_OFF || v[0] > POINT_CLOUD_STREAM) return false;
+    setPointCloudMode((PointCloudMode)v[0]);
+    return true;
+}
+
+static uint8_t getCloudVoxel(float *v) {
+    v[0] = getPointCloudVoxel();
+    return 1;
+}
+static bool setCloudVoxel(const float *v, uint8_t n) {
+    if (v[0] < 0 || v[0] > 1000) return false;
+    setPointCloudVoxel(v[0]);
+    return true;
+}
+
+static uint8_t getMountOffset(float *v) {
+    CoordMount m;
+    getPointCloudMount(m);
+    for (int i = 0; i < 3; i++) v[i] = m.offset_mm[i];
+    return 3;
+}
+static bool setMountOffset(const float *v, uint8_t n) {
+    for (int i = 0; i < 3; i++) {
+        if (fabsf(v[i]) > 500) return false;
+    }
+    CoordMount m;
+    getPointCloudMount(m);
+    for (int i = 0; i < 3; i++) m.offset_mm[i] = v[i];
+    setPointCloudMount(m);
+    return true;
+}
+
+static uint8_t getMountAngles(float *v) {
+    CoordMount m;
+    getPointCloudMount(m);
+    v[0] = m.pitch_offset_deg;
+    v[1] = m.yaw_offset_deg;
+    return 2;
+}
+static bool setMountAngles(const float *v, uint8_t n) {
+    if (fabsf(v[0]) > 10 || fabsf(v[1]) > 10) return false;
+    CoordMount m;
+    getPointCloudMount(m);
+    m.pitch_offset_deg = v[0];
+    m.yaw_offset_deg = v[1];
+    setPointCloudMount(m);
+    return true;
+}
+
+static uint8_t getMapMode(float *v) {
+    v[0] = getHeightMapMode();
+    return 1;
+}
+static bool setMapMode(const float *v, uint8_t n) {
+    if (v[0] != HEIGHT_MAP_ANGULAR && v[0] != HEIGHT_MAP_PLAN) return false;
+    setHeightMapMode((HeightMapMode)v[0]);
+    return true;
+}
+
+static uint8_t getMapCells(float *v) {
+    getHeightMapCells(v[0], v[1]);
+    return 2;
+}
+static bool setMapCells(const float *v, uint8_t n) {
+    if (v[0] < 0.05f || v[0] > 10 || v[1] < 1 || v[1] > 1000) return false;
+    setHeightMapCells(v[0], v[1]);
+    return true;
+}
+
+static constexpr ConsoleParam params[] = {
+    {"radar.kalman",    "<process> <measure> [initError]", 2, 3, true,  getKalman,    setKalman},
+    {"radar.smoothing", "<0..1>",                          1, 1, true,  getSmoothing, setSmoothing},
+    {"radar.range",     "<startMm> <endMm>",               2, 2, true,  getRange,     setRange},
+    {"radar.profile",   "<1..5>",                          1, 1, true,  getProfile,   setProfile},
+    {"imu.deadzone",    "<pitchDeg> <yawDeg>",             2, 2, false, getDeadZone,  setDeadZone},
+    {"telem.enabled",   "<0|1>",                           1, 1, false, getTelemetry, setTelemetry},
+    {"measure.window",  "<pre> <post>",                    2, 2, false, getMeasureWindow, setMeasureWindow},
+    {"measure.limits",  "<distSdMm> <angleSdDeg>",         2, 2, false, getMeasureLimits, setMeasureLimits},
+    {"capture.enabled", "<0|1>",                           1, 1, false, getCaptureEnabled, setCaptureEnabled},
+    {"capture.limits",  "<rateDps> <distSdMm> <holdMs>",   3, 3, false, getCaptureLimits, setCaptureLimits},
+    {"cloud.mode",      "<0=off|1=capture|2=stream>",      1, 1, false, getCloudMode, setCloudMode},
+    {"cloud.voxel",     "<mm> (0 = nessuna fusione)",      1, 1, false, getCloudVoxel, setCloudVoxel},
+    {"mount.offset",    "<xMm> <yMm> <zMm>",               3, 3, false, getMountOffset, setMountOffset},
+    {"mount.angles",    "<pitchDeg> <yawDeg>",             2, 2, false, getMountAngles, setMountAngles},
+    {"hmap.mode",       "<0=yaw x pitch|1=pianta XY>",     1, 1, false, getMapMode,   setMapMode},
+    {"hmap.cells",      "<gradi> <mm>",                    2, 2, false, getMapCells,  setMapCells},
+};
+static constexpr uint8_t PARAM_COUNT = sizeof(params) / sizeof(params[0]);
+
+static const ConsoleParam *findParam(const char *name) {
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+        if (strcmp(params[i].name, name) == 0) return &params[i];
+    }
+    return NULL;
+}
+
+static void printParam(const ConsoleParam &p) {
+    float values[CONSOLE_MAX_VALUES];
+    uint8_t n = p.get(values);
+    Serial.printf("%-16s", p.name);
+    for (uint8_t i = 0; i < n; i++) Serial.printf(" %g", values[i]);
+    Serial.println();
+}
+
+// Applicazione sul bus: il radar non viene toccato a metà di una lettura
+struct ParamJob {
+    const ConsoleParam *param;
+    const float *values;
+    uint8_t count;
+    bool ok;
+};
+
+static bool paramJob(void *ctx) {
+    ParamJob *job = (ParamJob *)ctx;
+    job->ok = job->param->set(job->values, job->count);
+    return job->ok;
+}
+
+static bool applyParam(const ConsoleParam &p, const float *values, uint8_t count) {
+    if (!p.onRadarBus || !isI2CBusRunning()) return p.set(values, count);
+
+    // job.ok resta false anche se il job non è partito (coda piena/timeout)
+    ParamJob job = {&p, values, count, false};
+    i2cRunJob(I2C_DEV_RADAR, I2C_PRIO_LOW, paramJob, &job, CONSOLE_JOB_TIMEOUT_MS);
+    return job.ok;
+}
+
+// === COMANDI ===
+struct ConsoleCommand {
+    const char *name;
+    const char *usage;
+    bool (*run)(uint8_t argc, char *argv[]);
+};
+
+static bool cmdHelp(uint8_t argc, char *argv[]);
+
+static bool cmdList(uint8_t argc, char *argv[]) {
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) printParam(params[i]);
+    return true;
+}
+
+static bool cmdGet(uint8_t argc, char *argv[]) {
+    if (argc != 2) return false;
+    const ConsoleParam *p = findParam(argv[1]);
+    if (!p) {
+        Serial.printf("❌ Parametro sconosciuto: %s\n", argv[1]);
+        return false;
+    }
+    printParam(*p);
+    return true;
+}
+
+static bool cmdSet(uint8_t argc, char *argv[]) {
+    if (argc < 3) return false;
+    const ConsoleParam *p = findParam(argv[1]);
+    if (!p) {
+        Serial.printf("❌ Parametro sconosciuto: %s\n", argv[1]);
+        return false;
+    }
+
+    uint8_t count = argc - 2;
+    float values[CONSOLE_MAX_VALUES];
+    if (count < p->minValues || count > p->maxValues) {
+        Serial.printf("❌ Uso: set %s %s\n", p->name, p->usage);
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!parseFloat(argv[2 + i], values[i])) {
+            Serial.printf("❌ Valore non numerico: %s\n", argv[2 + i]);
+            return false;
+        }
+    }
+
+    if (!applyParam(*p, values, count)) {
+        Serial.printf("❌ Valori rifiutati: set %s %s\n", p->name, p->usage);
+        return false;
+    }
+    captureConfigTunables();    // Persistente (salvataggio differito)
+    printParam(*p);
+    return true;
+}
+
+static bool cmdTelem(uint8_t argc, char *argv[]) {
+    if (argc != 2) return false;
+    if (strcmp(argv[1], "on") == 0) {
+        setTelemetryEnabled(true);
+    } else if (strcmp(argv[1], "off") == 0) {
+        setTelemetryEnabled(false);
+    } else if (strcmp(argv[1], "stats") == 0) {
+        TelemLinkStats s;
+        getTelemetryStats(s);
+        Serial.printf("Telemetria %s: sent %lu drop %lu lost %lu cpu %.1f%%\n",
+                      isTelemetryEnabled() ? "ON" : "OFF",
+                      (unsigned long)s.frames_sent, (unsigned long)s.frames_dropped,
+                      (unsigned long)s.samples_dropped, s.cpu_permille / 10.0f);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool cmdStats(uint8_t argc, char *argv[]) {
+    TaskStats stats;
+    getSensorTaskStats(stats);
+    Serial.printf("Samples %lu, sync %lu/%lu, avg %.2fms, max %luus, overflow %lu, bus %lu/%lu\n",
+                  (unsigned long)stats.samples_acquired,
+                  (unsigned long)stats.sync_success, (unsigned long)stats.sync_failures,
+                  stats.avg_sync_delta_ms, (unsigned long)stats.max_sync_delta_us,
+                  (unsigned long)stats.queue_overflows,
+                  (unsigned long)stats.bus_failures, (unsigned long)stats.bus_overruns);
+    return true;
+}
+
+static bool cmdHealth(uint8_t argc, char *argv[]) {
+    printSensorHealth();
+    return true;
+}
+
+static bool cmdI2C(uint8_t argc, char *argv[]) {
+    printI2CStats();
+    return true;
+}
+
+static bool cmdSubs(uint8_t argc, char *argv[]) {
+    printSensorSubscribers();
+    return true;
+}
+
+static bool cmdConfig(uint8_t argc, char *argv[]) {
+    if (argc == 2 && strcmp(argv[1], "save") == 0) {
+        return flushConfig();
+    }
+    if (argc != 1) return false;
+    printConfig();
+    return true;
+}
+
+// Misura bloccante per il solo task console: finisce alla convergenza
+static bool cmdIncl(uint8_t argc, char *argv[]) {
+    float target = INCLINO_DEFAULT_TARGET_DEG;
+    if (argc > 2 || (argc == 2 && (!parseFloat(argv[1], target) || target <= 0))) return false;
+    if (!startPrecisionPitch(target)) {
+        Serial.println("❌ Inclinometro non disponibile (IMU assente o misura in corso)");
+        return true;
+    }
+
+    InclinoResult r;
+    waitPrecisionPitch(r);
+
+    static const char *names[] = {"annullata", "", "OK", "TIMEOUT", "FALLITA"};
+    Serial.printf("%s Pitch %.3f ±%.3f° (target %.3f) roll %.2f° — %lu campioni, "
+                  "%lu scartati, %lu ripartenze, %lums [%s]\n",
+                  r.state == INCLINO_DONE ? "✅" : "⚠️", r.pitch_deg, r.ci95_deg, r.target_deg,
+                  r.roll_deg, (unsigned long)r.samples, (unsigned long)r.rejected,
+                  (unsigned long)r.restarts, (unsigned long)r.duration_ms, names[r.state]);
+    return true;
+}
+
+static bool cmdMeasure(uint8_t argc, char *argv[]) {
+    if (argc > 2) return false;
+    if (argc == 2 && strcmp(argv[1], "stats") == 0) {
+        MeasureStats s;
+        getMeasureStats(s);
+        Serial.printf("Misure %lu (instabili %lu, parziali %lu, senza dati %lu), "
+                      "latenza ultima %lu us, max %lu us\n",
+                      (unsigned long)s.count, (unsigned long)s.unstable, (unsigned long)s.partial,
+                      (unsigned long)s.no_data, (unsigned long)s.last_latency_us,
+                      (unsigned long)s.max_latency_us);
+        return true;
+    }
+    if (argc == 2 && strcmp(argv[1], "last") != 0) return false;
+
+    MeasureResult r;
+    if (argc == 2) {
+        if (!getLastMeasurement(r)) {
+            Serial.println("⚠️ Nessuna misura");
+            return true;
+        }
+    } else {
+        measureNow(MEASURE_SRC_CONSOLE, r);
+    }
+    printMeasurement(r);
+    return true;
+}
+
+static bool cmdCapture(uint8_t argc, char *argv[]) {
+    if (argc != 1) return false;
+    static const char *states[] = {"in movimento", "fermo", "catturato"};
+    AutoCaptureStatus s;
+    getAutoCaptureStatus(s);
+    Serial.printf("Auto-capture %s, %s (%.0f%%): %.2f dps, σ %.2f mm, %lu punti\n",
+                  s.enabled ? "ON" : "OFF", s.state <= AUTO_CAPTURE_CAPTURED ? states[s.state] : "?",
+                  s.progress * 100.0f, s.rate_dps, s.distance_sd_mm, (unsigned long)s.captures);
+    if (s.captures > 0) {
+        Serial.printf("Ultimo: %.1f mm pitch %.2f° yaw %.2f° -> X %.1f Y %.1f Z %.1f mm\n",
+                      s.last.distance_mm, s.last.pitch_deg, s.last.yaw_deg,
+                      s.last.x_mm, s.last.y_mm, s.last.z_mm);
+    }
+    return true;
+}
+
+static bool cmdCloud(uint8_t argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "export") == 0) {
+        if (argc > 3) return false;
+        PointExportFormat format = POINT_EXPORT_PLY;
+        if (argc == 3) {
+            if (strcmp(argv[2], "xyz") == 0) {
+                format = POINT_EXPORT_XYZ;
+            } else if (strcmp(argv[2], "ply") != 0) {
+                return false;
+            }
+        }
+        CloudExportResult r;
+        exportPointCloudToSD(format, r);
+        printCloudExport(r);
+        return true;
+    }
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "clear") != 0)) return false;
+    if (argc == 2) clearPointCloud();
+    printPointCloudStats();
+    return true;
+}
+
+static bool cmdMap(uint8_t argc, char *argv[]) {
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "clear") != 0)) return false;
+    if (argc == 2) clearHeightMap();
+    printHeightMapStats();
+    return true;
+}
+
+static void printLogList() {
+    static const char *states[] = {"INTERROTTA", "OK", "ERRORE"};
+    LogCatalogEntry list[CONSOLE_LOG_LIST];
+    uint32_t t0 = micros();
+    uint16_t n = readLogCatalog(list, CONSOLE_LOG_LIST);
+    uint32_t us = micros() - t0;
+    Serial.printf("\n=== Catalogo log (%u, letto in %lu us) ===\n", n, (unsigned long)us);
+    for (uint16_t i = 0; i < n; i++) {
+        const LogCatalogEntry &e = list[i];
+        uint32_t seconds = e.end_us > e.start_us ? (uint32_t)((e.end_us - e.start_us) / 1000000ULL) : 0;
+        Serial.printf("/log_%03u %-10s %6lus %8lu rec (validi %lu, persi %lu)  dist %ld..%ld mm media %ld  cfg %08lX v%u\n",
+                      e.session, e.state <= LOG_SESSION_FAILED ? states[e.state] : "?",
+                      (unsigned long)seconds, (unsigned long)e.records, (unsigned long)e.valid,
+                      (unsigned long)e.dropped, (long)(e.dist_min_um / RECORD_UM_PER_MM),
+                      (long)(e.dist_max_um / RECORD_UM_PER_MM), (long)(e.dist_mean_um / RECORD_UM_PER_MM),
+                      (unsigned long)e.config_crc, e.config_schema);
+    }
+    Serial.println("=====================\n");
+}
+
+static bool cmdLogSeek(const char *sessionArg, const char *secondsArg) {
+    float session, seconds;
+    if (!parseFloat(sessionArg, session) || !parseFloat(secondsArg, seconds) ||
+        session < 0 || session >= LOG_MAX_SESSIONS || seconds < 0) {
+        return false;
+    }
+    LogSessionReader reader;
+    if (!reader.open((uint16_t)session)) {
+        Serial.printf("❌ /log_%03u non leggibile\n", (unsigned)session);
+        return true;
+    }
+    uint32_t reads = 0;
+    uint32_t t0 = micros();
+    uint32_t index = reader.findRecord(reader.startUs() + (uint64_t)((double)seconds * 1e6), &reads);
+    uint32_t us = micros() - t0;
+    SensorRecord r;
+    if (index < reader.records() && reader.readRecord(index, r)) {
+        Serial.printf("🔎 /log_%03u @%.1fs: record %lu/%lu (t=%.3fs, %.1f mm), %lu letture in %lu us\n",
+                      reader.session(), seconds, (unsigned long)index, (unsigned long)reader.records(),
+                      (r.timestamp_us - reader.startUs()) / 1e6f, r.distanceMm(),
+                      (unsigned long)reads, (unsigned long)us);
+    } else {
+        Serial.printf("🔎 /log_%03u @%.1fs: oltre la fine (%lu record), %lu letture in %lu us\n",
+                      reader.session(), seconds, (unsigned long)reader.records(),
+                      (unsigned long)reads, (unsigned long)us);
+    }
+    return true;
+}
+
+static bool cmdLog(uint8_t argc, char *argv[]) {
+    if (argc == 4 && strcmp(argv[1], "seek") == 0) return cmdLogSeek(argv[2], argv[3]);
+    if (argc > 2) return false;
+    if (argc == 2) {
+        if (strcmp(argv[1], "start") == 0) {
+            startDataLogging();
+        } else if (strcmp(argv[1], "stop") == 0) {
+            stopDataLogging();
+        } else if (strcmp(argv[1], "list") == 0) {
+            printLogList();
+            return true;
+        } else {
+            return false;
+        }
+    }
+    printDataLogStats();
+    return true;
+}
+
+static bool cmdBoot(uint8_t argc, char *argv[]) {
+    printBootProfile();
+    return true;
+}
+
+static bool cmdTrace(uint8_t argc, char *argv[]) {
+    if (argc > 2) return false;
+    if (argc == 1) {
+        printFlightTrace(CONSOLE_TRACE_EVENTS);
+    } else if (strcmp(argv[1], "dump") == 0) {
+        dumpFlightTrace();
+    } else if (strcmp(argv[1], "clear") == 0) {
+        clearFlightTrace();
+        Serial.println("✅ Traccia azzerata");
+    } else if (strcmp(argv[1], "mark") == 0) {
+        flightEvent(FR_EV_MARK);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool cmdSys(uint8_t argc, char *argv[]) {
+    if (argc > 2) return false;
+    if (argc == 2) {
+        if (strcmp(argv[1], "reset") != 0) return false;
+        resetSystemMonitorPeak();
+        Serial.println("✅ Media e picco CPU azzerati");
+        return true;
+    }
+    printSystemMonitor();
+    return true;
+}
+
+static constexpr ConsoleCommand commands[] = {
+    {"help",   "",                   cmdHelp},
+    {"list",   "",                   cmdList},
+    {"get",    "<param>",            cmdGet},
+    {"set",    "<param> <valori..>", cmdSet},
+    {"telem",  "on|off|stats",       cmdTelem},
+    {"stats",  "",                   cmdStats},
+    {"health", "",                   cmdHealth},
+    {"i2c",    "",                   cmdI2C},
+    {"subs",   "",                   cmdSubs},
+    {"boot",   "",                   cmdBoot},
+    {"config", "[save]",             cmdConfig},
+    {"incl",   "[target_deg]",       cmdIncl},
+    {"measure", "[last|stats]",      cmdMeasure},
+    {"capture", "",                  cmdCapture},
+    {"cloud",  "[clear|export [ply|xyz]]", cmdCloud},
+    {"hmap",   "[clear]",            cmdMap},
+    {"log",    "[start|stop|list|seek <n> <s>]", cmdLog},
+    {"trace",  "[dump|clear|mark]",  cmdTrace},
+    {"sys",    "[reset]",            cmdSys},
+};
+static constexpr uint8_t COMMAND_COUNT = sizeof(commands) / sizeof(commands[0]);
+
+static bool cmdHelp(uint8_t argc, char *argv[]) {
+    Serial.println("Comandi:");
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+        Serial.printf("  %-7s %s\n", commands[i].name, commands[i].usage);
+    }
+    Serial.println("Parametri:");
+    for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+        Serial.printf("  %-16s %s\n", params[i].name, params[i].usage);
+    }
+    return true;
+}
+
+// === ESECUZIONE ===
+bool consoleExecute(char *line) {
+    char *argv[CONSOLE_MAX_ARGS];
+    uint8_t argc = tokenize(line, argv, CONSOLE_MAX_ARGS);
+    if (argc == 0) return true;
+    if (argc > CONSOLE_MAX_ARGS) {
+        Serial.println("❌ Troppi argomenti");
+        return false;
+    }
+
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+        if (strcmp(commands[i].name, argv[0]) != 0) continue;
+        if (!commands[i].run(argc, argv)) {
+            Serial.printf("⚠️ Uso: %s %s\n", commands[i].name, commands[i].usage);
+            return false;
+        }
+        return true;
+    }
+
+    Serial.printf("❌ Comando sconosciuto: %s (help)\n", argv[0]);
+    return false;
+}
+
+// === TASK ===
+// Risveglio su evento della seriale: byte ricevuti o host collegato
+static void wakeConsole() {
+    if (consoleTaskHandle) xTaskNotifyGive(consoleTaskHandle);
+}
+
+#if ARDUINO_USB_CDC_ON_BOOT
+static void onSerialEvent(void *, esp_event_base_t, int32_t, void *) {
+    wakeConsole();
+}
+#endif
+
+static void registerSerialWakeup() {
+#if ARDUINO_USB_CDC_ON_BOOT && ARDUINO_USB_MODE
+    // HWCDC (USB Serial/JTAG): niente eventi TX, la telemetria scrive di continuo
+    Serial.onEvent(ARDUINO_HW_CDC_RX_EVENT, onSerialEvent);
+    Serial.onEvent(ARDUINO_HW_CDC_CONNECTED_EVENT, onSerialEvent);
+#elif ARDUINO_USB_CDC_ON_BOOT
+    // USB OTG (TinyUSB CDC)
+    Serial.onEvent(ARDUINO_USB_CDC_RX_EVENT, onSerialEvent);
+    Serial.onEvent(ARDUINO_USB_CDC_CONNECTED_EVENT, onSerialEvent);
+    Serial.onEvent(ARDUINO_USB_CDC_DISCONNECTED_EVENT, onSerialEvent);
+#else
+    Serial.onReceive(wakeConsole);
+#endif
+}
+
+static void consoleTask(void *pvParameters) {
+    RTOS_LOG("Console task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_CONSOLE);
+    uint32_t lastRxMs = millis();   // Sessione aperta al boot
+
+    while (1) {
+        while (Serial.available() > 0) {
+            int c = Serial.read();
+            if (c < 0) break;
+            lastRxMs = millis();
+
+            if (c == '\r' || c == '\n') {
+                if (lineOverflow) {
+                    Serial.printf("❌ Riga troppo lunga (max %d)\n", CONSOLE_LINE_MAX - 1);
+                } else if (lineLength > 0) {
+                    lineBuffer[lineLength] = '\0';
+                    consoleExecute(lineBuffer);
+                }
+                lineLength = 0;
+                lineOverflow = false;
+            } else if (c == '\b' || c == 0x7F) {
+                if (lineLength > 0) lineLength--;
+            } else if (lineLength < CONSOLE_LINE_MAX - 1) {
+                lineBuffer[lineLength++] = (char)c;
+            } else {
+                lineOverflow = true;
+            }
+        }
+
+        // Sessione attiva (host USB collegato o byte recenti): niente light
+        // sleep, che fermerebbe la USB-CDC e perderebbe comandi e risposte
+        uint32_t idle = millis() - lastRxMs;
+        bool session = (bool)Serial || idle < CONSOLE_SESSION_MS;
+        setLightSleepAllowed(PM_HOLD_CONSOLE, !session);
+
+        // Dorme fino al prossimo evento RX. A sessione aperta si risveglia
+        // alla scadenza (o ogni CONSOLE_SESSION_MS con l'host collegato)
+        // per rilasciare il blocco del light sleep quando l'host se ne va.
+        TickType_t wait = portMAX_DELAY;
+        if (session) {
+            wait = MS_TO_TICKS(idle < CONSOLE_SESSION_MS ? CONSOLE_SESSION_MS - idle : CONSOLE_SESSION_MS);
+        }
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+bool initConsole() {
+    if (consoleTaskHandle) return true;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        consoleTask,
+        "Console",
+        CONSOLE_TASK_STACK_SIZE,
+        NULL,
+        CONSOLE_TASK_PRIORITY,
+        &consoleTaskHandle,
+        CONSOLE_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create console task");
+        return false;
+    }
+    registerSerialWakeup();
+    Serial.println("✅ Console pronta (help)");
+    return true;
+}
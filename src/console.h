@@ -0,0 +1,46 @@
+// console.h
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+// === CONSOLE SERIALE DI TUNING ===
+// Task dedicato che legge righe dalla seriale e le esegue da una tabella
+// comandi costante. Buffer statici e tokenizer in place: nessuna String,
+// nessuna allocazione. I parametri radar vengono applicati come job sul bus
+// I2C, quindi mai a metà di una lettura.
+//
+//   list                      tutti i parametri con valore corrente
+//   get <param>               valore di un parametro
+//   set <param> <v1> [v2..]   nuovo valore (immediato, salvato in NVS differito)
+//   config [save]             configurazione persistente / salvataggio immediato
+//   telem on|off|stats        stream binario (telemetry.h)
+//   incl [target_deg]         pitch di precisione (inclinometer.h)
+//   measure [last|stats]      misura su trigger dallo storico (measure_service.h)
+//   capture                   stato cattura automatica da fermo (auto_capture.h)
+//   cloud [clear]             nuvola di punti accumulata (point_cloud_service.h)
+//   cloud export [ply|xyz]    export della nuvola su SD (cloud_export.h)
+//   hmap [clear]              mappa di quota dello sweep (height_map_service.h)
+//   log [start|stop]          log di sessione su SD con piramide (data_logger.h)
+//   log list                  ultime sessioni dal catalogo su SD
+//   log seek <n> <secondi>    record al tempo dato (ricerca sull'indice sparso)
+//   trace [clear|mark]        registratore di volo (flight_recorder_service.h)
+//   trace dump                traccia binaria per tools/flight_recorder_cli
+//   sys [reset]               CPU per task, stack e heap (system_monitor_service.h)
+//   stats | health | i2c | subs | boot    report esistenti
+
+#define CONSOLE_LINE_MAX        96      // Caratteri per riga comando
+#define CONSOLE_MAX_ARGS        6       // Token per riga (comando incluso)
+#define CONSOLE_MAX_VALUES      4       // Valori per parametro
+#define CONSOLE_LOG_LIST        16      // Sessioni stampate da "log list"
+#define CONSOLE_TRACE_EVENTS    40      // Eventi stampati da "trace"
+#define CONSOLE_SESSION_MS      60000   // Niente light sleep fino a 60s dall'ultimo byte
+#define CONSOLE_JOB_TIMEOUT_MS  200     // Attesa max per applicare un parametro radar
+
+bool initConsole();
+
+// Esegue una riga (modificata in place dal tokenizer). false se il comando
+// non esiste o gli argomenti non sono validi.
+bool consoleExecute(char *line);
+
+#endif // CONSOLE_H
@@ -0,0 +1,120 @@
+// coord_transform.h
+// Trasformazione a lotti distanza/pitch/yaw(/roll) -> x/y/z su array
+// separati (SoA), per replay di log ed export di nuvole con milioni di
+// campioni. Float a precisione singola e seno/coseno polinomiali senza
+// chiamate di libreria né salti: i cicli si vettorizzano da soli sull'host
+// (-O2 con GCC >= 12, o -O3). Sull'ESP32-S3 le istruzioni vettoriali PIE
+// lavorano solo su interi, quindi lo stesso codice gira sulla FPU scalare,
+// comunque molto più veloce di sin/cos double.
+// Header puro C++, benchmark in tools/coord_transform_bench.cpp.
+//
+// Convenzione (la stessa di calculateCoordinates() in sync_queue.h):
+// corpo con X a destra, Y in avanti lungo il fascio radar, Z in alto.
+// Il punto nel corpo è mount.offset + (0, distanza, 0); si applicano roll
+// attorno a Y, pitch attorno a X (positivo = fascio verso l'alto) e yaw
+// attorno a Z (positivo = da Y verso X). Con offset nullo il roll non
+// sposta il punto e il risultato coincide con calculateCoordinates().
+#ifndef COORD_TRANSFORM_H
+#define COORD_TRANSFORM_H
+
+#include <stdint.h>
+#include <math.h>
+#include "sensor_record.h"
+
+#define COORD_BATCH_CHUNK   64      // Record convertiti per giro (buffer sullo stack)
+
+// Montaggio del radar rispetto al centro di rotazione dell'IMU
+struct CoordMount {
+    float offset_mm[3];         // Origine del fascio nel corpo (X destra, Y avanti, Z su)
+    float pitch_offset_deg;     // Disallineamento del fascio (boresight)
+    float yaw_offset_deg;
+};
+
+inline void coordMountDefaults(CoordMount &m) {
+    m.offset_mm[0] = m.offset_mm[1] = m.offset_mm[2] = 0;
+    m.pitch_offset_deg = 0;
+    m.yaw_offset_deg = 0;
+}
+
+// === SENO/COSENO VELOCI (gradi) ===
+// Riduzione al quadrante con k = round(deg/90), polinomi di Taylor su
+// [-45°, 45°] (errore < 1e-7, sotto l'ULP del float attorno a 1) e scambio
+// senza salti. Arrotondamento con troncamento di un valore reso positivo
+// (nearbyintf non si vettorizza con SSE2). Valido per |deg| < 700000.
+inline void fastSinCosDeg(float deg, float &s, float &c) {
+    int k = (int)(deg * (1.0f / 90.0f) + 8192.5f) - 8192;
+    float r = (deg - (float)k * 90.0f) * 0.017453292519943295f;
+    float r2 = r * r;
+    float sp = r * (1.0f + r2 * (-1.0f / 6 + r2 * (1.0f / 120 + r2 * (-1.0f / 5040 + r2 * (1.0f / 362880)))));
+    float cp = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24 + r2 * (-1.0f / 720 + r2 * (1.0f / 40320))));
+    int q = k & 3;
+    float odd = (float)(q & 1);                 // Quadranti dispari: seno e coseno si scambiano
+    float sa = sp + odd * (cp - sp);
+    float ca = cp + odd * (sp - cp);
+    s = sa * (float)(1 - (q & 2));              // Segni per quadrante senza salti
+    c = ca * (float)(1 - ((q + 1) & 2));
+}
+
+// === LOTTI ===
+// Corpo del ciclo senza salti; la variante senza roll è un'istanza separata
+// perché un if nel ciclo ne impedisce la vettorizzazione
+template <bool ROLL>
+inline void coordTransformLoop(const float *dist, const float *pitch, const float *yaw, const float *roll,
+                               uint32_t n, const CoordMount &m,
+                               float *__restrict x, float *__restrict y, float *__restrict z) {
+    const float ox = m.offset_mm[0], oy = m.offset_mm[1], oz = m.offset_mm[2];
+    const float dp = m.pitch_offset_deg, dy = m.yaw_offset_deg;
+
+    for (uint32_t i = 0; i < n; i++) {
+        float sp, cp, sy, cy, sr = 0, cr = 1;
+        fastSinCosDeg(pitch[i] + dp, sp, cp);
+        fastSinCosDeg(yaw[i] + dy, sy, cy);
+        if (ROLL) fastSinCosDeg(roll[i], sr, cr);
+
+        // Roll attorno a Y (fascio), poi pitch attorno a X, poi yaw attorno a Z
+        float by = oy + dist[i];
+        float rx = ox * cr + oz * sr;
+        float rz = oz * cr - ox * sr;
+        float py = by * cp - rz * sp;
+        float pz = by * sp + rz * cp;
+        x[i] = rx * cy + py * sy;
+        y[i] = py * cy - rx * sy;
+        z[i] = pz;
+    }
+}
+
+// roll può essere nullptr (roll = 0). Gli array di uscita non devono
+// sovrapporsi a quelli di ingresso.
+inline void coordTransformBatch(const float *dist, const float *pitch, const float *yaw, const float *roll,
+                                uint32_t n, const CoordMount &m, float *x, float *y, float *z) {
+    if (roll) {
+        coordTransformLoop<true>(dist, pitch, yaw, roll, n, m, x, y, z);
+    } else {
+        coordTransformLoop<false>(dist, pitch, yaw, nullptr, n, m, x, y, z);
+    }
+}
+
+// Record del ring/log: conversione a blocchi su buffer locali, poi lotto
+inline void coordTransformRecords(const SensorRecord *records, uint32_t n, const CoordMount &m,
+                                  float *x, float *y, float *z) {
+    float dist[COORD_BATCH_CHUNK], pitch[COORD_BATCH_CHUNK], yaw[COORD_BATCH_CHUNK], roll[COORD_BATCH_CHUNK];
+    for (uint32_t base = 0; base < n; base += COORD_BATCH_CHUNK) {
+        uint32_t count = n - base < COORD_BATCH_CHUNK ? n - base : COORD_BATCH_CHUNK;
+        for (uint32_t i = 0; i < count; i++) {
+            const SensorRecord &r = records[base + i];
+            dist[i] = r.distanceMm();
+            pitch[i] = r.pitchDeg();
+            yaw[i] = r.yawDeg();
+            roll[i] = r.rollDeg();
+        }
+        coordTransformBatch(dist, pitch, yaw, roll, count, m, x + base, y + base, z + base);
+    }
+}
+
+// Un solo punto con la stessa formula (catture, misure)
+inline void coordTransformPoint(float distance, float pitch, float yaw, float roll, const CoordMount &m,
+                                float &x, float &y, float &z) {
+    coordTransformBatch(&distance, &pitch, &yaw, &roll, 1, m, &x, &y, &z);
+}
+
+#endif // COORD_TRANSFORM_H
@@ -0,0 +1,566 @@
+// data_logger.cpp
+#include "data_logger.h"
+#include "task_config.h"
+#include "sensor_tasks.h"
+#include "sd_card.h"
+#include "config_store.h"
+#include "timebase.h"
+#include "esp_heap_caps.h"
+#include <SD.h>
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t loggerTaskHandle = NULL;
+static volatile bool wantRecording = false;
+static DataLogStats logStats;                   // Sotto statsMux
+static TaskHandle_t commandWaiter = NULL;       // Chiamante di start/stop, sotto statsMux
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Solo il task logger
+static int8_t loggerSub = -1;
+static bool sessionOpen = false;
+static File recFile;
+static File levelFiles[LOG_PYRAMID_LEVELS];
+static File idxFile;
+static LogIndexEntry idxBuffer[DATA_LOG_INDEX_BUFFER];
+static uint8_t idxBuffered = 0;
+static LogCatalogEntry sessionEntry;            // Voce di catalogo della sessione aperta
+static LogBlockEncoder encoder;                 // Blocco in costruzione (~5KB)
+static uint32_t recOffset = 0;                  // Byte scritti nel .rec
+static PyramidBin binBuffer[LOG_PYRAMID_LEVELS][DATA_LOG_BIN_BUFFER];
+static uint8_t binBuffered[LOG_PYRAMID_LEVELS];
+static PyramidBuilder builder;
+static uint32_t sessionStartMs = 0;
+static uint64_t lastRecordUs = 0;
+static bool writeFailed = false;
+
+// Cambio di stato: sveglia chi attende in startDataLogging()/stopDataLogging()
+static void setState(uint8_t state, uint8_t error) {
+    portENTER_CRITICAL(&statsMux);
+    logStats.state = state;
+    logStats.error = error;
+    TaskHandle_t waiter = commandWaiter;
+    commandWaiter = NULL;
+    portEXIT_CRITICAL(&statsMux);
+    if (waiter) xTaskNotifyGive(waiter);
+}
+
+static uint8_t getState() {
+    portENTER_CRITICAL(&statsMux);
+    uint8_t state = logStats.state;
+    portEXIT_CRITICAL(&statsMux);
+    return state;
+}
+
+static void addBytes(uint32_t bytes) {
+    portENTER_CRITICAL(&statsMux);
+    logStats.bytes += bytes;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// === SCRITTURA ===
+static bool writeAll(File &file, const void *data, size_t len) {
+    if (len == 0) return true;
+    if (file.write((const uint8_t *)data, len) != len) {
+        writeFailed = true;
+        return false;
+    }
+    addBytes(len);
+    return true;
+}
+
+static bool writeLevel(uint8_t l) {
+    bool ok = writeAll(levelFiles[l], binBuffer[l], binBuffered[l] * sizeof(PyramidBin));
+    binBuffered[l] = 0;
+    return ok;
+}
+
+// Bin chiusi dal builder: in coda al buffer del livello
+class LevelSink : public PyramidSink {
+public:
+    bool append(uint8_t level, const PyramidBin &bin) override {
+        uint8_t l = level - 1;
+        binBuffer[l][binBuffered[l]++] = bin;
+        portENTER_CRITICAL(&statsMux);
+        logStats.bins[l]++;
+        portEXIT_CRITICAL(&statsMux);
+        return binBuffered[l] < DATA_LOG_BIN_BUFFER || writeLevel(l);
+    }
+};
+
+static LevelSink levelSink;
+
+// Blocco chiuso su SD e sua voce di indice; si riparte dal record successivo
+static void writeBlock() {
+    if (encoder.records() == 0) return;
+    uint32_t c0 = ESP.getCycleCount();
+    uint32_t bytes = encoder.seal();
+    uint32_t next = encoder.firstRecord() + encoder.records();
+    LogIndexEntry &e = idxBuffer[idxBuffered++];
+    e.timestamp_us = encoder.firstTimestampUs();
+    e.record = encoder.firstRecord();
+    e.offset = recOffset;
+    uint32_t sealCycles = ESP.getCycleCount() - c0;
+
+    writeAll(recFile, encoder.data(), bytes);
+    recOffset += bytes;
+    if (idxBuffered == DATA_LOG_INDEX_BUFFER) {
+        writeAll(idxFile, idxBuffer, sizeof(idxBuffer));
+        idxBuffered = 0;
+    }
+    encoder.begin(next);
+    portENTER_CRITICAL(&statsMux);
+    logStats.rec_bytes += bytes;
+    logStats.encode_cycles += sealCycles;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+// Buffer in RAM su SD e flush dei file (dati visibili anche dopo un reset).
+// Il blocco in corso si chiude anche se corto: ogni flush lascia solo
+// blocchi completi e decodificabili.
+static void flushSession() {
+    uint32_t t0 = micros();
+    writeBlock();
+    recFile.flush();
+    for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS; l++) {
+        writeLevel(l);
+        levelFiles[l].flush();
+    }
+    writeAll(idxFile, idxBuffer, idxBuffered * sizeof(LogIndexEntry));
+    idxBuffered = 0;
+    idxFile.flush();
+    uint32_t us = micros() - t0;
+
+    PubSubSubscriberStats sub = {};
+    if (loggerSub >= 0) getSensorSubscriberStats(loggerSub, sub);
+    portENTER_CRITICAL(&statsMux);
+    logStats.flushes++;
+    if (us > logStats.max_flush_us) logStats.max_flush_us = us;
+    logStats.dropped = sub.dropped;
+    logStats.duration_ms = millis() - sessionStartMs;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+static void closeFiles() {
+    recFile.close();
+    for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS; l++) levelFiles[l].close();
+    idxFile.close();
+}
+
+static void removeSessionFiles(uint16_t session) {
+    char path[LOG_PATH_MAX];
+    for (uint8_t l = 0; l <= LOG_PYRAMID_LEVELS; l++) {
+        logFilePath(path, sizeof(path), "", session, l);
+        SD.remove(path);
+    }
+    logIndexPath(path, sizeof(path), "", session);
+    SD.remove(path);
+}
+
+// === CATALOGO ===
+// Una voce in coda (file aperto e chiuso subito: resta coerente a un reset)
+static bool appendCatalog(LogCatalogEntry &e) {
+    logCatalogSeal(e);
+    File f = SD.open(LOG_CATALOG_PATH, FILE_APPEND);
+    if (!f) return false;
+    bool ok = true;
+    if (f.size() == 0) {
+        LogFileHeader h;
+        logHeaderInit(h, LOG_FILE_CATALOG, 0, LOG_PYRAMID_FANOUT, sizeof(LogCatalogEntry), 0, 0);
+        ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h);
+    }
+    ok = ok && f.write((const uint8_t *)&e, sizeof(e)) == sizeof(e);
+    f.close();
+    return ok;
+}
+
+// Numero della prossima sessione: dall'ultima voce del catalogo, senza
+// scandire la SD (la scansione resta solo per un catalogo perso)
+static int32_t nextSession() {
+    LogCatalogEntry last;
+    uint16_t session = readLogCatalog(&last, 1) == 1 ? last.session + 1 : 0;
+    char path[LOG_PATH_MAX];
+    for (; session < LOG_MAX_SESSIONS; session++) {
+        logFilePath(path, sizeof(path), "", session, 0);
+        if (!SD.exists(path)) return session;
+    }
+    return -1;
+}
+
+static bool openFile(File &file, const char *path, const LogFileHeader &h) {
+    file = SD.open(path, FILE_WRITE);
+    return file && writeAll(file, &h, sizeof(h));
+}
+
+static bool openSessionFiles(uint16_t session, uint64_t startUs) {
+    char path[LOG_PATH_MAX];
+    LogFileHeader h;
+    logFilePath(path, sizeof(path), "", session, 0);
+    logHeaderInit(h, LOG_FILE_BLOCKS, 0, LOG_PYRAMID_FANOUT, sizeof(SensorRecord), session, startUs);
+    bool ok = openFile(recFile, path, h);
+    for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS && ok; l++) {
+        logFilePath(path, sizeof(path), "", session, l + 1);
+        logHeaderInit(h, LOG_FILE_PYRAMID, l + 1, LOG_PYRAMID_FANOUT, sizeof(PyramidBin), session, startUs);
+        ok = openFile(levelFiles[l], path, h);
+    }
+    if (ok) {
+        logIndexPath(path, sizeof(path), "", session);
+        logHeaderInit(h, LOG_FILE_INDEX, 0, LOG_PYRAMID_FANOUT, sizeof(LogIndexEntry), session, startUs);
+        ok = openFile(idxFile, path, h);
+    }
+    return ok;
+}
+
+static uint8_t openSession() {
+    if (getSensorBootState() != SENSOR_BOOT_DONE) return DATA_LOG_ERR_NO_SENSORS;
+    if (!mountSDCard()) return DATA_LOG_ERR_NO_CARD;
+
+    int32_t session = nextSession();
+    if (session < 0) return DATA_LOG_ERR_FULL;
+
+    portENTER_CRITICAL(&statsMux);
+    memset(&logStats, 0, sizeof(logStats));
+    logStats.state = DATA_LOG_STARTING;
+    logStats.session = (uint16_t)session;
+    portEXIT_CRITICAL(&statsMux);
+
+    writeFailed = false;
+    uint64_t startUs = timebaseNowUs();
+    if (!openSessionFiles(session, startUs)) {
+        // Niente sessioni a metà: si tolgono i file già creati
+        closeFiles();
+        removeSessionFiles(session);
+        return DATA_LOG_ERR_NO_CARD;
+    }
+
+    loggerSub = subscribeSensorData("logger", PUBSUB_DECIMATED, 1);
+    if (loggerSub < 0) {
+        closeFiles();
+        removeSessionFiles(session);
+        return DATA_LOG_ERR_NO_SENSORS;
+    }
+
+    // Voce OPEN subito: una sessione interrotta da un reset resta in elenco
+    DeviceConfig config;
+    getConfig(config);
+    memset(&sessionEntry, 0, sizeof(sessionEntry));
+    sessionEntry.session = session;
+    sessionEntry.state = LOG_SESSION_OPEN;
+    sessionEntry.start_us = startUs;
+    sessionEntry.config_crc = configCrc32(&config, sizeof(config));
+    sessionEntry.config_schema = CONFIG_SCHEMA_VERSION;
+    appendCatalog(sessionEntry);
+
+    encoder.begin(0);
+    recOffset = sizeof(LogFileHeader);
+    idxBuffered = 0;
+    memset(binBuffered, 0, sizeof(binBuffered));
+    builder.begin();
+    lastRecordUs = 0;
+    sessionStartMs = millis();
+    sessionOpen = true;
+    return DATA_LOG_ERR_NONE;
+}
+
+// Bin parziali, ultimi buffer e chiusura: la sessione resta leggibile
+static void closeSession() {
+    builder.finish(levelSink);
+    flushSession();
+    closeFiles();
+
+    PyramidBin summary;
+    builder.summary(summary);
+    DataLogStats s;
+    getDataLogStats(s);
+    sessionEntry.state = writeFailed ? LOG_SESSION_FAILED : LOG_SESSION_CLOSED;
+    sessionEntry.end_us = lastRecordUs;
+    sessionEntry.records = builder.recordCount();
+    sessionEntry.valid = summary.count;
+    sessionEntry.dropped = s.dropped;
+    if (summary.count > 0) {
+        sessionEntry.dist_min_um = summary.min[LOG_CH_DISTANCE];
+        sessionEntry.dist_max_um = summary.max[LOG_CH_DISTANCE];
+        sessionEntry.dist_mean_um = summary.mean[LOG_CH_DISTANCE];
+        sessionEntry.pitch_min_cdeg = summary.min[LOG_CH_PITCH];
+        sessionEntry.pitch_max_cdeg = summary.max[LOG_CH_PITCH];
+    }
+    appendCatalog(sessionEntry);
+    if (loggerSub >= 0) unsubscribeSensorData(loggerSub);
+    loggerSub = -1;
+    sessionOpen = false;
+}
+
+// === TASK ===
+static void loggerTask(void *pvParameters) {
+    RTOS_LOG("Logger task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_LOGGER);
+    uint32_t lastFlushMs = 0;
+
+    while (1) {
+        flightTaskBeat(FR_TASK_LOGGER);
+        if (!sessionOpen) {
+            if (!wantRecording) {
+                // Fermo fino a startDataLogging()
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            uint8_t error = openSession();
+            if (error != DATA_LOG_ERR_NONE) {
+                wantRecording = false;
+                setState(DATA_LOG_ERROR, error);
+                continue;
+            }
+            setState(DATA_LOG_RECORDING, DATA_LOG_ERR_NONE);
+            lastFlushMs = millis();
+        }
+
+        if (!wantRecording) {
+            closeSession();
+            setState(DATA_LOG_IDLE, DATA_LOG_ERR_NONE);
+            continue;
+        }
+
+        SensorRecord record;
+        if (readSensorRecord(loggerSub, record, DATA_LOG_IDLE_MS)) {
+            uint32_t c0 = ESP.getCycleCount();
+            bool full = encoder.add(record);
+            uint32_t encodeCycles = ESP.getCycleCount() - c0;
+            if (full) writeBlock();
+            builder.add(record, levelSink);
+            lastRecordUs = record.timestamp_us;
+            portENTER_CRITICAL(&statsMux);
+            logStats.records++;
+            logStats.encode_cycles += encodeCycles;
+            portEXIT_CRITICAL(&statsMux);
+        }
+
+        if (millis() - lastFlushMs >= DATA_LOG_FLUSH_MS) {
+            lastFlushMs = millis();
+            flushSession();
+        }
+
+        if (writeFailed) {
+            closeSession();
+            wantRecording = false;
+            setState(DATA_LOG_ERROR, DATA_LOG_ERR_WRITE);
+        }
+    }
+}
+
+// === API ===
+bool initDataLogger() {
+    if (loggerTaskHandle) return true;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        loggerTask,
+        "Logger",
+        LOGGER_TASK_STACK_SIZE,
+        NULL,
+        LOGGER_TASK_PRIORITY,
+        &loggerTaskHandle,
+        LOGGER_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create logger task");
+        return false;
+    }
+    return true;
+}
+
+// Attende che il task logger lasci lo stato 'from' (notifica da setState)
+static void waitStateChange(uint8_t from) {
+    uint32_t t0 = millis();
+    while (1) {
+        portENTER_CRITICAL(&statsMux);
+        bool pending = logStats.state == from;
+        commandWaiter = pending ? xTaskGetCurrentTaskHandle() : NULL;
+        portEXIT_CRITICAL(&statsMux);
+
+        uint32_t elapsed = millis() - t0;
+        if (!pending || elapsed >= DATA_LOG_COMMAND_TIMEOUT_MS) break;
+        ulTaskNotifyTake(pdTRUE, MS_TO_TICKS(DATA_LOG_COMMAND_TIMEOUT_MS - elapsed));
+    }
+    portENTER_CRITICAL(&statsMux);
+    commandWaiter = NULL;
+    portEXIT_CRITICAL(&statsMux);
+}
+
+bool startDataLogging() {
+    if (!loggerTaskHandle) return false;
+    if (getState() == DATA_LOG_RECORDING) return true;
+
+    setState(DATA_LOG_STARTING, DATA_LOG_ERR_NONE);
+    wantRecording = true;
+    xTaskNotifyGive(loggerTaskHandle);
+    waitStateChange(DATA_LOG_STARTING);
+    return getState() == DATA_LOG_RECORDING;
+}
+
+void stopDataLogging() {
+    wantRecording = false;
+    waitStateChange(DATA_LOG_RECORDING);
+}
+
+bool isDataLogging() {
+    return getState() == DATA_LOG_RECORDING;
+}
+
+void getDataLogStats(DataLogStats &stats) {
+    portENTER_CRITICAL(&statsMux);
+    stats = logStats;
+    portEXIT_CRITICAL(&statsMux);
+    if (stats.state == DATA_LOG_RECORDING) stats.duration_ms = millis() - sessionStartMs;
+}
+
+const char *dataLogErrorName(uint8_t error) {
+    static const char *names[] = {"OK", "NO SD", "SENSORI NON PRONTI", "SD PIENA", "ERRORE SCRITTURA"};
+    return error <= DATA_LOG_ERR_WRITE ? names[error] : "?";
+}
+
+void printDataLogStats() {
+    static const char *states[] = {"FERMO", "AVVIO", "REC", "ERRORE"};
+    DataLogStats s;
+    getDataLogStats(s);
+    Serial.printf("\n=== Data Log (%s) ===\n", s.state <= DATA_LOG_ERROR ? states[s.state] : "?");
+    if (s.state == DATA_LOG_ERROR) Serial.printf("❌ %s\n", dataLogErrorName(s.error));
+    if (s.state != DATA_LOG_IDLE || s.records > 0) {
+        Serial.printf("Sessione /log_%03u: %lu record in %lus, %lu KB, persi %lu\n",
+                      s.session, (unsigned long)s.records, (unsigned long)(s.duration_ms / 1000),
+                      (unsigned long)(s.bytes / 1024), (unsigned long)s.dropped);
+        Serial.print("Piramide:");
+        for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS; l++) {
+            Serial.printf(" L%u %lu", l + 1, (unsigned long)s.bins[l]);
+        }
+        if (s.records > 0 && s.rec_bytes > 0) {
+            Serial.printf("\nRecord compressi: %.1f B/record (%.2fx), codifica %.2f us/record",
+                          (float)s.rec_bytes / s.records, (float)s.records * sizeof(SensorRecord) / s.rec_bytes,
+                          (float)s.encode_cycles / ESP.getCpuFreqMHz() / s.records);
+        }
+        Serial.printf("\nFlush %lu, max %lu us\n", (unsigned long)s.flushes, (unsigned long)s.max_flush_us);
+    }
+    Serial.println("=====================\n");
+}
+
+uint16_t readLogCatalog(LogCatalogEntry *out, uint16_t max) {
+    if (max == 0 || !mountSDCard()) return 0;
+    File f = SD.open(LOG_CATALOG_PATH, FILE_READ);
+    if (!f) return 0;
+
+    LogCatalogEntry chunk[DATA_LOG_CATALOG_CHUNK];
+    uint32_t remaining = logItemCount(f.size(), sizeof(LogCatalogEntry));
+    uint16_t count = 0;
+    bool more = true;
+    while (remaining > 0 && more) {
+        uint32_t n = remaining < DATA_LOG_CATALOG_CHUNK ? remaining : DATA_LOG_CATALOG_CHUNK;
+        remaining -= n;
+        if (!f.seek(sizeof(LogFileHeader) + (uint64_t)remaining * sizeof(LogCatalogEntry)) ||
+            f.read((uint8_t *)chunk, n * sizeof(LogCatalogEntry)) != n * sizeof(LogCatalogEntry)) {
+            break;
+        }
+        for (int32_t i = (int32_t)n - 1; i >= 0 && more; i--) {
+            more = logCatalogCollect(out, count, max, chunk[i]);
+        }
+    }
+    f.close();
+    return count;
+}
+
+int32_t findLatestLogSession() {
+    LogCatalogEntry e;
+    return readLogCatalog(&e, 1) == 1 ? e.session : -1;
+}
+
+// === LETTURA ===
+static void *allocReaderBuffer(size_t bytes) {
+    void *mem = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return mem ? mem : heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+}
+
+LogSessionReader::~LogSessionReader() {
+    closeFiles();
+    if (payload) heap_caps_free(payload);
+    if (block) heap_caps_free(block);
+}
+
+bool LogSessionReader::openFiles() {
+    char path[LOG_PATH_MAX];
+    logFilePath(path, sizeof(path), "", sessionId, 0);
+    file.rec = SD.open(path, FILE_READ);
+    logIndexPath(path, sizeof(path), "", sessionId);
+    file.idx = SD.open(path, FILE_READ);
+    return file.rec;
+}
+
+void LogSessionReader::closeFiles() {
+    if (file.rec) file.rec.close();
+    if (file.idx) file.idx.close();
+}
+
+bool LogSessionReader::open(uint16_t session) {
+    recordCount = 0;
+    sessionId = session;
+    if (!mountSDCard()) return false;
+    if (!payload) payload = (uint8_t *)allocReaderBuffer(LOG_BLOCK_MAX_PAYLOAD);
+    if (!block) block = (SensorRecord *)allocReaderBuffer(LOG_BLOCK_RECORDS * sizeof(SensorRecord));
+    if (!payload || !block || !openFiles()) {
+        closeFiles();
+        return false;
+    }
+
+    LogFileHeader h;
+    bool ok = file.rec.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              (logHeaderValid(h, LOG_FILE_RECORDS, 0) || logHeaderValid(h, LOG_FILE_BLOCKS, 0)) &&
+              h.item_bytes == sizeof(SensorRecord) && h.fanout == LOG_PYRAMID_FANOUT;
+    if (ok) {
+        kind = h.kind;
+        start = h.start_us;
+        file.begin(kind, file.rec.size(), file.idx ? file.idx.size() : 0, payload, block);
+        recordCount = file.records();
+    }
+    closeFiles();
+    return ok;
+}
+
+uint32_t LogSessionReader::read(uint8_t level, uint32_t first, uint32_t n, PyramidBin *out) {
+    uint32_t got = 0;
+    if (level == 0) {
+        // Record convertiti al volo sul buffer di uscita
+        SensorRecord *records = (SensorRecord *)out;     // 32 <= 40 byte: si converte all'indietro
+        if (openFiles()) got = file.read(first, n, records);
+        closeFiles();
+        for (int32_t i = (int32_t)got - 1; i >= 0; i--) {
+            SensorRecord r = records[i];
+            pyramidBinFromRecord(r, out[i]);
+        }
+        return got;
+    }
+
+    char path[LOG_PATH_MAX];
+    logFilePath(path, sizeof(path), "", sessionId, level);
+    File f = SD.open(path, FILE_READ);
+    if (!f) return 0;
+    LogFileHeader h;
+    if (f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) && logHeaderValid(h, LOG_FILE_PYRAMID, level) &&
+        h.item_bytes == sizeof(PyramidBin) &&
+        f.seek(sizeof(LogFileHeader) + (uint64_t)first * sizeof(PyramidBin))) {
+        got = f.read((uint8_t *)out, n * sizeof(PyramidBin)) / sizeof(PyramidBin);
+    }
+    f.close();
+    return got;
+}
+
+bool LogSessionReader::readRecord(uint32_t index, SensorRecord &record) {
+    if (index >= recordCount) return false;
+    bool ok = openFiles() && file.read(index, 1, &record) == 1;
+    closeFiles();
+    return ok;
+}
+
+uint32_t LogSessionReader::findRecord(uint64_t timestampUs, uint32_t *reads) {
+    uint32_t found = recordCount;
+    file.reads = 0;
+    if (openFiles()) found = file.find(timestampUs);
+    closeFiles();
+    if (reads) *reads = file.reads;
+    return found < recordCount ? found : recordCount;
+}
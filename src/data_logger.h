@@ -0,0 +1,131 @@
+// data_logger.h
+#ifndef DATA_LOGGER_H
+#define DATA_LOGGER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "log_format.h"
+#include "log_pyramid.h"
+#include "log_codec.h"
+
+// === LOG DI SESSIONE SU SD ===
+// Task a bassa priorità, subscriber in ordine e con perdita del topic
+// sensori (mai backpressure sul ciclo): ogni SensorRecord va compresso in
+// /log_NNN.rec (blocchi delta/varint con CRC, log_codec.h) e alimenta la
+// piramide min/max/media (log_pyramid.h), i cui
+// bin chiusi vanno in /log_NNN.p1..p5 (formato in log_format.h). Scritture
+// a blocchi dal buffer RAM; tutto su SD almeno ogni DATA_LOG_FLUSH_MS.
+// Ogni sessione ha anche l'indice sparso /log_NNN.idx e due voci nel
+// catalogo /logs.cat (apertura e chiusura, con il riassunto): elenco delle
+// sessioni e ricerca per tempo senza scandire la SD.
+// Lettura delle sessioni (viewer e host): LogSessionReader qui sotto e
+// tools/log_pyramid_cli.cpp.
+
+#define DATA_LOG_BIN_BUFFER         16      // Bin per livello prima di scrivere
+#define DATA_LOG_INDEX_BUFFER       8       // Voci di indice (una per blocco)
+#define DATA_LOG_CATALOG_CHUNK      8       // Voci lette per accesso dalla coda del catalogo
+#define DATA_LOG_FLUSH_MS           5000    // Perdita massima a un reset
+#define DATA_LOG_IDLE_MS            100     // Attesa campioni durante la registrazione
+#define DATA_LOG_COMMAND_TIMEOUT_MS 3000    // Attesa apertura/chiusura file
+
+enum DataLogState : uint8_t {
+    DATA_LOG_IDLE = 0,
+    DATA_LOG_STARTING,
+    DATA_LOG_RECORDING,
+    DATA_LOG_ERROR              // Sessione chiusa, causa in error
+};
+
+enum DataLogError : uint8_t {
+    DATA_LOG_ERR_NONE = 0,
+    DATA_LOG_ERR_NO_CARD,
+    DATA_LOG_ERR_NO_SENSORS,    // Topic sensori non pronto o subscriber esauriti
+    DATA_LOG_ERR_FULL,          // Nessun numero di sessione libero
+    DATA_LOG_ERR_WRITE          // Scrittura fallita: i dati fino all'ultimo flush restano
+};
+
+struct DataLogStats {
+    uint8_t state;              // DataLogState
+    uint8_t error;              // DataLogError
+    uint16_t session;
+    uint32_t records;
+    uint32_t bins[LOG_PYRAMID_LEVELS];
+    uint32_t bytes;             // Scritti su SD (header compresi)
+    uint32_t rec_bytes;         // Blocchi compressi nel .rec
+    uint64_t encode_cycles;     // Costo della compressione (cicli CPU)
+    uint32_t dropped;           // Campioni persi dal subscriber
+    uint32_t flushes;
+    uint32_t max_flush_us;
+    uint32_t duration_ms;
+};
+
+// Crea il task (nessuna sessione aperta)
+bool initDataLogger();
+
+// Bloccanti fino all'apertura/chiusura dei file (DATA_LOG_COMMAND_TIMEOUT_MS)
+bool startDataLogging();
+void stopDataLogging();
+bool isDataLogging();
+
+void getDataLogStats(DataLogStats &stats);
+const char *dataLogErrorName(uint8_t error);
+void printDataLogStats();
+
+// Ultime sessioni dal catalogo, la più recente prima (stato dell'ultima
+// voce di ciascuna). Legge dalla coda solo quanto serve: il costo dipende da
+// max, non dal numero di sessioni sulla SD.
+uint16_t readLogCatalog(LogCatalogEntry *out, uint16_t max);
+
+// Sessione più recente nel catalogo, -1 se nessuna
+int32_t findLatestLogSession();
+
+// === LETTURA ===
+// Sorgente della piramide su SD per il viewer: i file si aprono a ogni
+// read() (il logger ne tiene aperti sette). Una sessione in corso si vede
+// fino all'ultimo flush. I record (compressi o no) passano da LogRecordFile
+// (log_codec.h) con ~10KB di buffer allocati in open(), PSRAM se c'è.
+class SdRecordFile : public LogRecordFile {
+public:
+    uint32_t readRecords(uint64_t offset, void *buf, uint32_t len) override { return readAt(rec, offset, buf, len); }
+    uint32_t readIndex(uint64_t offset, void *buf, uint32_t len) override { return readAt(idx, offset, buf, len); }
+    File rec;
+    File idx;
+
+private:
+    static uint32_t readAt(File &f, uint64_t offset, void *buf, uint32_t len) {
+        return f && f.seek(offset) ? f.read((uint8_t *)buf, len) : 0;
+    }
+};
+
+class LogSessionReader : public PyramidSource {
+public:
+    LogSessionReader() {}
+    ~LogSessionReader();
+    LogSessionReader(const LogSessionReader &) = delete;
+    LogSessionReader &operator=(const LogSessionReader &) = delete;
+
+    bool open(uint16_t session);
+    uint32_t records() override { return recordCount; }
+    uint32_t read(uint8_t level, uint32_t first, uint32_t n, PyramidBin *out) override;
+    bool readRecord(uint32_t index, SensorRecord &record);
+    // Primo record con timestamp >= timestampUs (records() se nessuno):
+    // ricerca binaria su .idx e poi dentro un blocco, ~15 letture per una
+    // sessione di 24 ore. reads (opzionale) conta le letture.
+    uint32_t findRecord(uint64_t timestampUs, uint32_t *reads = NULL);
+    uint16_t session() const { return sessionId; }
+    uint64_t startUs() const { return start; }
+    bool compressed() const { return kind == LOG_FILE_BLOCKS; }
+
+private:
+    bool openFiles();
+    void closeFiles();
+
+    SdRecordFile file;
+    uint8_t *payload = NULL;
+    SensorRecord *block = NULL;
+    uint16_t sessionId = 0;
+    uint32_t recordCount = 0;
+    uint64_t start = 0;
+    uint8_t kind = LOG_FILE_RECORDS;
+};
+
+#endif // DATA_LOGGER_H
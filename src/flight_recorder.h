@@ -0,0 +1,280 @@
+// flight_recorder.h
+// Registratore di volo: traccia binaria di eventi a dimensione fissa, pensata
+// per stare in RAM RTC non inizializzata e sopravvivere a panic, watchdog e
+// ESP.restart(). Comune a firmware (flight_recorder_service.cpp) e decoder
+// host (tools/flight_recorder_cli.cpp).
+//
+// Scrittura senza lock: ogni evento prenota il suo indice con un fetch-add
+// atomico su head e scrive lo slot head % FR_EVENTS; il campo seq (16 bit
+// bassi dell'indice) va scritto per ultimo. Uno slot interrotto da un reset
+// conserva il seq del giro precedente e il decoder lo scarta.
+// Header puro C++.
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FR_MAGIC             0x52544648u   // "HFTR" in little endian
+#define FR_VERSION           2             // 2: FR_TASK_MONITOR
+#define FR_EVENTS            256           // Potenza di 2: 4KB sugli 8KB di RTC slow
+#define FR_TASK_CORE_BIT     0x80          // task = FlightTaskId | core << 7
+
+static_assert((FR_EVENTS & (FR_EVENTS - 1)) == 0, "FR_EVENTS: potenza di 2");
+
+// === TIPI DI EVENTO ===
+enum FlightEventType : uint8_t {
+    FR_EV_NONE = 0,
+    FR_EV_BOOT,                 // object = avvii conservati, arg = esp_reset_reason()
+    FR_EV_TASK_START,           // Task registrato; arg = stack libero (word)
+    FR_EV_MUTEX_WAIT,           // Mutex conteso; object = FlightMutexId, arg = attesa µs
+    FR_EV_MUTEX_TIMEOUT,        // Non ottenuto entro il timeout; arg = attesa µs
+    FR_EV_QUEUE_OVERFLOW,       // object = FlightQueueId, arg = totale (topic) o dispositivo (i2c)
+    FR_EV_I2C_ERROR,            // object = dispositivo I2C, arg = I2CResult
+    FR_EV_MENU,                 // object = nuovo MenuState, arg = precedente
+    FR_EV_LEAF_ENTER,           // object = MenuState del sottomenu, arg = voce
+    FR_EV_LEAF_EXIT,
+    FR_EV_MARK,                 // Marcatore libero (console, debug)
+    FR_EV_COUNT
+};
+
+// Task di interesse: id piccoli e stabili, il decoder host li conosce per nome
+enum FlightTaskId : uint8_t {
+    FR_TASK_OTHER = 0,          // Non registrato (idle, timer, WiFi...)
+    FR_TASK_LOOP,               // loop() Arduino: UI
+    FR_TASK_SENSOR,
+    FR_TASK_I2C,
+    FR_TASK_SENSOR_BOOT,
+    FR_TASK_LOGGER,
+    FR_TASK_TELEMETRY,
+    FR_TASK_CONSOLE,
+    FR_TASK_CONFIG,
+    FR_TASK_INCLINO,
+    FR_TASK_MEASURE,
+    FR_TASK_CLOUD,
+    FR_TASK_MONITOR,
+    FR_TASK_COUNT
+};
+
+enum FlightMutexId : uint8_t {
+    FR_MUTEX_OTHER = 0,
+    FR_MUTEX_DISPLAY,
+    FR_MUTEX_CONFIG,
+    FR_MUTEX_MEASURE,
+    FR_MUTEX_CLOUD,
+    FR_MUTEX_COUNT
+};
+
+enum FlightQueueId : uint8_t {
+    FR_QUEUE_SENSOR_TOPIC = 0,  // Subscriber LOSSLESS in ritardo
+    FR_QUEUE_I2C,               // Coda del bus manager piena
+    FR_QUEUE_COUNT
+};
+
+// === FORMATO ===
+struct FlightEvent {
+    uint32_t time_us;           // timebase, 32 bit bassi (wrap ogni ~71 minuti)
+    uint16_t seq;               // 16 bit bassi dell'indice: scritto per ultimo
+    uint8_t type;               // FlightEventType
+    uint8_t task;               // FlightTaskId | core << 7
+    uint16_t object;
+    uint16_t reserved;
+    uint32_t arg;
+};
+
+static_assert(sizeof(FlightEvent) == 16, "FlightEvent: 16 byte");
+
+struct FlightTrace {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t capacity;          // FR_EVENTS del firmware che ha scritto
+    uint32_t head;              // Eventi scritti in totale (fetch-add)
+    uint32_t boots;             // Avvii da quando la traccia è stata azzerata
+    uint32_t beat_us[FR_TASK_COUNT];  // Ultimo giro di ogni task (flightTaskBeat)
+    uint32_t prev_beat_us[FR_TASK_COUNT];  // Stessa tabella all'avvio precedente
+    FlightEvent events[FR_EVENTS];
+};
+
+inline void flightTraceReset(FlightTrace &t) {
+    memset(&t, 0, sizeof(t));
+    t.magic = FR_MAGIC;
+    t.version = FR_VERSION;
+    t.capacity = FR_EVENTS;
+}
+
+inline bool flightTraceValid(const FlightTrace &t) {
+    return t.magic == FR_MAGIC && t.version == FR_VERSION && t.capacity == FR_EVENTS;
+}
+
+inline uint8_t flightTaskTag(uint8_t id, uint8_t core) {
+    return (uint8_t)((id & ~FR_TASK_CORE_BIT) | (core ? FR_TASK_CORE_BIT : 0));
+}
+
+// === SCRITTURA ===
+// Solo store e un fetch-add: niente lock, chiamabile da più task e core
+inline void flightTraceRecord(FlightTrace &t, uint32_t timeUs, uint8_t type, uint8_t task,
+                              uint16_t object, uint32_t arg) {
+    uint32_t idx = __atomic_fetch_add(&t.head, 1, __ATOMIC_RELAXED);
+    FlightEvent &e = t.events[idx & (FR_EVENTS - 1)];
+    e.time_us = timeUs;
+    e.type = type;
+    e.task = task;
+    e.object = object;
+    e.arg = arg;
+    __atomic_store_n(&e.seq, (uint16_t)idx, __ATOMIC_RELEASE);
+}
+
+// === LETTURA ===
+// Eventi completi dal più vecchio al più recente: fn(indice, evento).
+// Ritorna gli slot scartati (scrittura interrotta o sovrascritti in corsa).
+template <typename F>
+inline uint32_t flightTraceForEach(const FlightTrace &t, F fn) {
+    uint32_t head = t.head;
+    uint32_t first = head > FR_EVENTS ? head - FR_EVENTS : 0;
+    uint32_t skipped = 0;
+    for (uint32_t i = first; i != head; i++) {
+        FlightEvent e = t.events[i & (FR_EVENTS - 1)];
+        if (e.seq != (uint16_t)i || e.type == FR_EV_NONE || e.type >= FR_EV_COUNT) {
+            skipped++;
+            continue;
+        }
+        fn(i, e);
+    }
+    return skipped;
+}
+
+// Tempo a 64 bit lungo la traccia: i 32 bit bassi vengono srotolati evento
+// per evento, un BOOT riparte da zero (nuovo esp_timer)
+struct FlightClock {
+    uint64_t now_us = 0;
+    uint32_t last = 0;
+    bool started = false;
+
+    uint64_t advance(const FlightEvent &e) {
+        if (e.type == FR_EV_BOOT || !started) {
+            now_us = e.time_us;
+        } else {
+            // Eventi di core diversi possono arrivare con pochi µs di disordine
+            now_us += (int64_t)(int32_t)(e.time_us - last);
+        }
+        last = e.time_us;
+        started = true;
+        return now_us;
+    }
+};
+
+// === NOMI (timeline) ===
+inline const char *flightEventName(uint8_t type) {
+    static const char *names[FR_EV_COUNT] = {
+        "-", "BOOT", "TASK", "MUTEX", "MUTEX_TIMEOUT", "OVERFLOW",
+        "I2C_ERROR", "MENU", "LEAF", "LEAF_EXIT", "MARK"
+    };
+    return type < FR_EV_COUNT ? names[type] : "?";
+}
+
+inline const char *flightTaskName(uint8_t task) {
+    static const char *names[FR_TASK_COUNT] = {
+        "other", "loop", "Sensor", "I2CBus", "SensorBoot", "Logger",
+        "Telemetry", "Console", "Config", "Inclino", "Measure", "Cloud", "Monitor"
+    };
+    uint8_t id = task & ~FR_TASK_CORE_BIT;
+    return id < FR_TASK_COUNT ? names[id] : "?";
+}
+
+inline const char *flightMutexName(uint16_t id) {
+    static const char *names[FR_MUTEX_COUNT] = {"?", "display", "config", "measure", "cloud"};
+    return id < FR_MUTEX_COUNT ? names[id] : "?";
+}
+
+inline const char *flightQueueName(uint16_t id) {
+    static const char *names[FR_QUEUE_COUNT] = {"sensor topic", "i2c"};
+    return id < FR_QUEUE_COUNT ? names[id] : "?";
+}
+
+inline const char *flightResetName(uint32_t reason) {
+    // Valori di esp_reset_reason_t (ESP-IDF)
+    static const char *names[] = {
+        "unknown", "poweron", "ext", "sw", "panic", "int_wdt",
+        "task_wdt", "wdt", "deepsleep", "brownout", "sdio"
+    };
+    return reason < sizeof(names) / sizeof(names[0]) ? names[reason] : "?";
+}
+
+// Dettaglio di un evento in una riga (senza tempo né task)
+inline void flightEventDescribe(char *out, size_t max, const FlightEvent &e) {
+    switch (e.type) {
+        case FR_EV_BOOT:
+            snprintf(out, max, "reset %s, avvio %u", flightResetName(e.arg), e.object);
+            break;
+        case FR_EV_TASK_START:
+            snprintf(out, max, "stack libero %u word", (unsigned)e.arg);
+            break;
+        case FR_EV_MUTEX_WAIT:
+        case FR_EV_MUTEX_TIMEOUT:
+            snprintf(out, max, "%s %u us", flightMutexName(e.object), (unsigned)e.arg);
+            break;
+        case FR_EV_QUEUE_OVERFLOW:
+            snprintf(out, max, "%s (totale %u)", flightQueueName(e.object), (unsigned)e.arg);
+            break;
+        case FR_EV_I2C_ERROR:
+            snprintf(out, max, "dev %u result %u", e.object, (unsigned)e.arg);
+            break;
+        case FR_EV_MENU:
+            snprintf(out, max, "%u -> %u", (unsigned)e.arg, e.object);
+            break;
+        case FR_EV_LEAF_ENTER:
+        case FR_EV_LEAF_EXIT:
+            snprintf(out, max, "menu %u voce %u", e.object, (unsigned)e.arg);
+            break;
+        default:
+            snprintf(out, max, "%u %u", e.object, (unsigned)e.arg);
+            break;
+    }
+}
+
+// "   12.345678  c1 Sensor     MUTEX        display 1200 us"
+inline void flightEventFormat(char *out, size_t max, uint64_t timeUs, const FlightEvent &e) {
+    char detail[48];
+    flightEventDescribe(detail, sizeof(detail), e);
+    snprintf(out, max, "%6u.%06u  c%u %-10s %-13s %s",
+             (unsigned)(timeUs / 1000000), (unsigned)(timeUs % 1000000),
+             (e.task & FR_TASK_CORE_BIT) ? 1u : 0u, flightTaskName(e.task),
+             flightEventName(e.type), detail);
+}
+
+// === DUMP TESTUALE ===
+// La struttura viaggia in righe "FR <offset hex> <byte hex>" su seriale: il
+// decoder host le riconosce in mezzo al resto del log
+#define FR_DUMP_LINE_BYTES   32
+
+inline int flightDumpLine(char *out, size_t max, const FlightTrace &t, uint32_t offset) {
+    const uint8_t *p = (const uint8_t *)&t;
+    uint32_t n = sizeof(FlightTrace) - offset;
+    if (n > FR_DUMP_LINE_BYTES) n = FR_DUMP_LINE_BYTES;
+    int len = snprintf(out, max, "FR %04x ", (unsigned)offset);
+    for (uint32_t i = 0; i < n && len + 3 < (int)max; i++) {
+        len += snprintf(out + len, max - len, "%02x", p[offset + i]);
+    }
+    return len;
+}
+
+// Una riga di dump dentro t; false se non è una riga FR valida
+inline bool flightParseLine(FlightTrace &t, const char *line) {
+    const char *p = strstr(line, "FR ");
+    if (!p) return false;
+    unsigned offset = 0;
+    int used = 0;
+    if (sscanf(p + 3, "%x %n", &offset, &used) != 1) return false;
+    p += 3 + used;
+    uint8_t *dst = (uint8_t *)&t;
+    while (offset < sizeof(FlightTrace)) {
+        unsigned byte;
+        if (sscanf(p, "%2x", &byte) != 1) break;
+        dst[offset++] = (uint8_t)byte;
+        p += 2;
+    }
+    return true;
+}
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,166 @@
+// flight_recorder_service.cpp
+#include "flight_recorder_service.h"
+#include "timebase.h"
+#include "esp_system.h"
+
+// === VARIABILI DI STATO ===
+// Fuori dallo zero-init del boot: sopravvive a panic, watchdog e restart
+static RTC_NOINIT_ATTR FlightTrace trace;
+
+static TaskHandle_t taskHandles[FR_TASK_COUNT];
+static SemaphoreHandle_t mutexHandles[FR_MUTEX_COUNT];
+static uint32_t resetReason = 0;
+
+static inline uint32_t nowUs() {
+    return (uint32_t)timebaseNowUs();
+}
+
+// Task corrente fra quelli registrati (al più FR_TASK_COUNT confronti)
+static inline uint8_t currentTaskTag() {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    uint8_t id = FR_TASK_OTHER;
+    for (uint8_t i = 1; i < FR_TASK_COUNT; i++) {
+        if (taskHandles[i] == self) {
+            id = i;
+            break;
+        }
+    }
+    return flightTaskTag(id, xPortGetCoreID());
+}
+
+static bool abnormalReset(uint32_t reason) {
+    return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT ||
+           reason == ESP_RST_TASK_WDT || reason == ESP_RST_WDT ||
+           reason == ESP_RST_BROWNOUT;
+}
+
+// === INIZIALIZZAZIONE ===
+void initFlightRecorder() {
+    resetReason = (uint32_t)esp_reset_reason();
+
+    // Dopo un power-on la RTC RAM contiene rumore
+    if (resetReason == ESP_RST_POWERON || !flightTraceValid(trace)) {
+        flightTraceReset(trace);
+    }
+    memcpy(trace.prev_beat_us, trace.beat_us, sizeof(trace.beat_us));
+    memset(trace.beat_us, 0, sizeof(trace.beat_us));
+
+    if (abnormalReset(resetReason) && trace.head > 0) {
+        Serial.printf("⚠️ Reset anomalo (%s): ultimi eventi prima del reset\n",
+                      flightResetName(resetReason));
+        printFlightTrace(FR_BOOT_REPORT_EVENTS);
+    }
+
+    trace.boots++;
+    taskHandles[FR_TASK_LOOP] = xTaskGetCurrentTaskHandle();
+    flightTraceRecord(trace, nowUs(), FR_EV_BOOT, currentTaskTag(),
+                      (uint16_t)trace.boots, resetReason);
+
+    Serial.printf("✅ Flight recorder: %u eventi in RTC RAM, avvio %u\n",
+                  FR_EVENTS, (unsigned)trace.boots);
+}
+
+void flightRegisterTask(uint8_t id) {
+    if (id == FR_TASK_OTHER || id >= FR_TASK_COUNT) return;
+    taskHandles[id] = xTaskGetCurrentTaskHandle();
+    flightTraceRecord(trace, nowUs(), FR_EV_TASK_START, currentTaskTag(), id,
+                      (uint32_t)uxTaskGetStackHighWaterMark(NULL));
+}
+
+void flightRegisterMutex(SemaphoreHandle_t mutex, uint8_t id) {
+    if (id < FR_MUTEX_COUNT) mutexHandles[id] = mutex;
+}
+
+// === REGISTRAZIONE ===
+void flightEvent(uint8_t type, uint16_t object, uint32_t arg) {
+    flightTraceRecord(trace, nowUs(), type, currentTaskTag(), object, arg);
+}
+
+void flightTaskBeat(uint8_t id) {
+    if (id < FR_TASK_COUNT) trace.beat_us[id] = nowUs();
+}
+
+bool flightTakeMutex(SemaphoreHandle_t mutex, TickType_t timeout) {
+    if (xSemaphoreTake(mutex, 0) == pdTRUE) return true;
+    if (timeout == 0) return false;
+
+    uint32_t start = nowUs();
+    bool ok = xSemaphoreTake(mutex, timeout) == pdTRUE;
+    uint32_t wait = nowUs() - start;
+
+    if (!ok || wait >= FR_MUTEX_WAIT_MIN_US) {
+        uint16_t id = FR_MUTEX_OTHER;
+        for (uint8_t i = 1; i < FR_MUTEX_COUNT; i++) {
+            if (mutexHandles[i] == mutex) {
+                id = i;
+                break;
+            }
+        }
+        flightEvent(ok ? FR_EV_MUTEX_WAIT : FR_EV_MUTEX_TIMEOUT, id, wait);
+    }
+    return ok;
+}
+
+TaskHandle_t getFlightTaskHandle(uint8_t id) {
+    return id < FR_TASK_COUNT ? taskHandles[id] : NULL;
+}
+
+uint32_t getFlightResetReason() {
+    return resetReason;
+}
+
+const FlightTrace &getFlightTrace() {
+    return trace;
+}
+
+// === REPORT ===
+static void printBeats(const char *title, const uint32_t *beats) {
+    bool any = false;
+    for (uint8_t i = 1; i < FR_TASK_COUNT; i++) any |= beats[i] != 0;
+    if (!any) return;
+    Serial.print(title);
+    for (uint8_t i = 1; i < FR_TASK_COUNT; i++) {
+        if (beats[i]) Serial.printf(" %s=%u", flightTaskName(i), (unsigned)beats[i]);
+    }
+    Serial.println();
+}
+
+void printFlightTrace(uint16_t last) {
+    uint32_t head = trace.head;
+    uint32_t from = head > last ? head - last : 0;
+    FlightClock clock;
+    char line[96];
+
+    Serial.printf("=== FLIGHT RECORDER (%u eventi, avvio %u) ===\n",
+                  (unsigned)head, (unsigned)trace.boots);
+
+    // L'orologio va srotolato da tutta la traccia, anche per gli ultimi N
+    uint32_t skipped = flightTraceForEach(trace, [&](uint32_t i, const FlightEvent &e) {
+        uint64_t t = clock.advance(e);
+        if (i < from) return;
+        flightEventFormat(line, sizeof(line), t, e);
+        Serial.println(line);
+    });
+    if (skipped) {
+        Serial.printf("⚠️ %u slot incompleti scartati\n", (unsigned)skipped);
+    }
+
+    printBeats("Ultimo giro per task (µs dall'avvio):", trace.beat_us);
+    printBeats("Avvio precedente:", trace.prev_beat_us);
+}
+
+void dumpFlightTrace() {
+    char line[12 + FR_DUMP_LINE_BYTES * 2];
+    for (uint32_t offset = 0; offset < sizeof(FlightTrace); offset += FR_DUMP_LINE_BYTES) {
+        flightDumpLine(line, sizeof(line), trace, offset);
+        Serial.println(line);
+    }
+    Serial.println("FR end");
+}
+
+void clearFlightTrace() {
+    uint32_t boots = trace.boots;
+    flightTraceReset(trace);
+    trace.boots = boots;
+    flightEvent(FR_EV_MARK, 0, 0);
+}
@@ -0,0 +1,48 @@
+// flight_recorder_service.h
+#ifndef FLIGHT_RECORDER_SERVICE_H
+#define FLIGHT_RECORDER_SERVICE_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "flight_recorder.h"
+
+// === REGISTRATORE DI VOLO ===
+// Traccia di eventi (flight_recorder.h) in RAM RTC non inizializzata: dopo un
+// panic, un watchdog o un loop bloccato la traccia del giro precedente è
+// ancora lì. Sempre attiva: un evento costa un fetch-add, una lettura di
+// esp_timer e cinque store, nessun lock e nessuna Serial. Si registra solo
+// ciò che è anomalo o raro (attese sui mutex, overflow, errori I2C, menu);
+// i giri dei task vanno nella tabella beat_us, non nel ring.
+// Lettura: console "trace" (timeline) e "trace dump" per tools/flight_recorder_cli.
+
+#define FR_MUTEX_WAIT_MIN_US   1000    // Attese più brevi non finiscono nella traccia
+#define FR_BOOT_REPORT_EVENTS  24      // Eventi stampati al boot dopo un reset anomalo
+
+// Prima cosa in setup(): conserva la traccia se il reset non è un power-on
+void initFlightRecorder();
+
+// Chiamata una volta dal task stesso, all'avvio del suo corpo
+void flightRegisterTask(uint8_t id);
+void flightRegisterMutex(SemaphoreHandle_t mutex, uint8_t id);
+
+void flightEvent(uint8_t type, uint16_t object = 0, uint32_t arg = 0);
+
+// Giro completato dal task id: solo uno store nella tabella beat_us
+void flightTaskBeat(uint8_t id);
+
+// TAKE_MUTEX (task_config.h): libero -> nessun costo extra; conteso ->
+// evento con l'attesa se >= FR_MUTEX_WAIT_MIN_US, o timeout
+bool flightTakeMutex(SemaphoreHandle_t mutex, TickType_t timeout);
+
+// Handle registrato con flightRegisterTask (NULL se mai registrato)
+TaskHandle_t getFlightTaskHandle(uint8_t id);
+
+uint32_t getFlightResetReason();    // esp_reset_reason() dell'ultimo avvio
+const FlightTrace &getFlightTrace();
+
+void printFlightTrace(uint16_t last);   // Timeline degli ultimi eventi
+void dumpFlightTrace();                 // Righe "FR ..." per il decoder host
+void clearFlightTrace();
+
+#endif // FLIGHT_RECORDER_SERVICE_H
@@ -0,0 +1,293 @@
+// health_supervisor.h
+// Macchina a stati del supervisore salute sensori (sensor_health.cpp):
+// errori consecutivi -> guasto, re-init a passi come job I2C con budget,
+// backoff esponenziale, sblocco del bus prima di riprovare. Nessuna
+// dipendenza da Arduino/FreeRTOS: driver, bus manager e log passano da
+// HealthPort, così su host gira con I2CScheduler + I2CSimBackend
+// (tools/sensor_health_test.cpp).
+#ifndef HEALTH_SUPERVISOR_H
+#define HEALTH_SUPERVISOR_H
+
+#include <stdint.h>
+#include <string.h>
+#include "i2c_scheduler.h"
+#include "timebase.h"
+
+// === CONFIGURAZIONE ===
+#define HEALTH_FAIL_LIMIT          3       // Errori bus consecutivi -> guasto
+#define HEALTH_RADAR_STALL_LIMIT   50      // Letture radar senza picco (5s) -> re-init
+#define HEALTH_IMU_FROZEN_LIMIT    20      // Campioni accel identici (2s) -> IMU in reset
+#define HEALTH_BACKOFF_MIN_MS      200     // Attesa prima del primo tentativo
+#define HEALTH_BACKOFF_MAX_MS      10000   // Tetto del backoff esponenziale
+#define HEALTH_RECOVERY_BUDGET_MS  2000    // Durata max di un tentativo di re-init
+
+enum HealthSensor : uint8_t {
+    HEALTH_RADAR = 0,
+    HEALTH_IMU,
+    HEALTH_SENSOR_COUNT
+};
+
+enum HealthState : uint8_t {
+    HEALTH_OK = 0,
+    HEALTH_DEGRADED,        // Errori sporadici, letture ancora attive
+    HEALTH_FAILED,          // Sospeso, in attesa del prossimo tentativo
+    HEALTH_RECOVERING       // Re-init in corso sul bus
+};
+
+struct SensorHealth {
+    uint8_t state;              // HealthState
+    uint8_t consecutive_errors;
+    uint32_t total_errors;
+    uint32_t faults;            // Guasti dichiarati
+    uint32_t attempts;          // Tentativi di re-init
+    uint32_t recoveries;        // Re-init riusciti
+    uint32_t backoff_ms;        // Attesa corrente prima di riprovare
+    uint32_t last_attempt_ms;   // Durata ultimo tentativo (tempo bus + attese)
+    uint32_t last_recovery_ms;  // Guasto -> letture di nuovo riuscite
+    uint32_t max_recovery_ms;
+};
+
+struct BusHealth {
+    uint32_t recoveries;        // Clock-out eseguiti
+    uint32_t failed;            // SDA ancora bassa dopo il clock-out
+    uint32_t last_us;
+    uint32_t max_us;
+};
+
+// === AZIONI VERSO IL SISTEMA ===
+class HealthPort {
+public:
+    virtual ~HealthPort() {}
+    // Il task sensori smette di leggere il sensore fino al re-init
+    virtual void suspend(uint8_t sensor) = 0;
+    // Job del passo step di re-init; false = passi finiti (tx intatto), re-init completo
+    virtual bool prepareInitStep(uint8_t sensor, uint8_t step, I2CTransaction &tx) = 0;
+    virtual uint64_t deadlineFromNow(uint32_t us) = 0;
+    // Al bus manager; false = coda piena (result già terminale)
+    virtual bool submit(I2CTransaction &tx) = 0;
+    // Per il log
+    virtual void onFault(uint8_t, const SensorHealth &) {}
+    virtual void onAttemptFailed(uint8_t, const SensorHealth &, uint8_t) {}
+    virtual void onRecovered(uint8_t, const SensorHealth &) {}
+};
+
+// === SUPERVISORE ===
+// Tempi in ms a 32 bit (millis() sul target), confronti modulo 2^32.
+// Non thread-safe: chiamato solo dal task sensori.
+class HealthSupervisor {
+public:
+    explicit HealthSupervisor(HealthPort &p) : port(p) { reset(); }
+
+    // Sensore non partito al boot: tentativi subito, come dopo un guasto
+    void begin(uint32_t now, bool radarReady, bool imuReady) {
+        reset();
+        if (!radarReady) declareFault(HEALTH_RADAR, now);
+        if (!imuReady) declareFault(HEALTH_IMU, now);
+    }
+
+    // Esito del ciclo: busOk = transazioni riuscite, dataOk = dato plausibile
+    void report(uint8_t sensor, bool busOk, bool dataOk, uint32_t now) {
+        if (sensor >= HEALTH_SENSOR_COUNT) return;
+        Supervised &s = sup[sensor];
+
+        // Sensore sospeso: il ciclo non lo ha letto
+        if (s.health.state == HEALTH_FAILED || s.health.state == HEALTH_RECOVERING) {
+            return;
+        }
+
+        if (!busOk) {
+            s.health.total_errors++;
+            if (s.health.consecutive_errors < 255) s.health.consecutive_errors++;
+            if (s.health.consecutive_errors >= HEALTH_FAIL_LIMIT) {
+                declareFault(sensor, now);
+            } else {
+                s.health.state = HEALTH_DEGRADED;
+            }
+            return;
+        }
+
+        s.health.consecutive_errors = 0;
+        s.health.state = HEALTH_OK;
+
+        // Primo ciclo riuscito dopo il re-init: chiude la misura di recovery
+        if (s.awaitingData) {
+            s.awaitingData = false;
+            s.health.last_recovery_ms = now - s.faultStartMs;
+            if (s.health.last_recovery_ms > s.health.max_recovery_ms) {
+                s.health.max_recovery_ms = s.health.last_recovery_ms;
+            }
+        }
+
+        // Bus OK ma dati fermi: sensore resettato o bloccato internamente.
+        // Un solo re-init per stallo (il radar senza target resta "fermo" a lungo).
+        if (dataOk) {
+            s.stallCount = 0;
+            s.stallHandled = false;
+            return;
+        }
+
+        uint16_t limit = (sensor == HEALTH_RADAR) ? HEALTH_RADAR_STALL_LIMIT : HEALTH_IMU_FROZEN_LIMIT;
+        if (s.stallCount < limit) s.stallCount++;
+        if (s.stallCount >= limit && !s.stallHandled) {
+            s.stallHandled = true;
+            declareFault(sensor, now);
+        }
+    }
+
+    // Avanza la macchina a stati: sottomette job e ritorna subito
+    void service(uint32_t now) {
+        // === RECOVERY BUS ===
+        if (recoverInFlight) {
+            if (!i2cIsDone(recoverTx)) return;   // Niente re-init a bus bloccato
+
+            recoverInFlight = false;
+            if (recoverTx.result == I2C_RESULT_OK) {
+                uint32_t us = (uint32_t)(recoverTx.complete_us - recoverTx.start_us);
+                bus.recoveries++;
+                bus.last_us = us;
+                if (us > bus.max_us) bus.max_us = us;
+            } else {
+                bus.failed++;
+            }
+        }
+
+        // === RE-INIT SENSORI ===
+        for (uint8_t i = 0; i < HEALTH_SENSOR_COUNT; i++) {
+            Supervised &s = sup[i];
+
+            if (s.health.state == HEALTH_FAILED && timeReachedMs(now, s.nextAttemptMs)) {
+                if (busRecoverRequested) {
+                    busRecoverRequested = false;
+                    i2cPrepareRecover(recoverTx, I2C_PRIO_LOW);
+                    if (port.submit(recoverTx)) {
+                        recoverInFlight = true;
+                        return;
+                    }
+                }
+
+                s.health.state = HEALTH_RECOVERING;
+                s.health.attempts++;
+                s.attemptStartMs = now;
+                s.step = 0;
+                submitStep(i, now);
+                continue;
+            }
+
+            if (s.health.state != HEALTH_RECOVERING || !i2cIsDone(s.tx)) {
+                continue;
+            }
+
+            bool inBudget = (now - s.attemptStartMs) < HEALTH_RECOVERY_BUDGET_MS;
+            if (s.tx.result != I2C_RESULT_OK || !inBudget) {
+                attemptFailed(i, now);
+            } else if (port.prepareInitStep(i, ++s.step, s.tx)) {
+                // Passo successivo al prossimo ciclo: fra un passo e l'altro passa l'altro sensore
+                submitPrepared(i, now);
+            } else {
+                attemptSucceeded(i, now);
+            }
+        }
+    }
+
+    bool isHealthy(uint8_t sensor) const {
+        if (sensor >= HEALTH_SENSOR_COUNT) return false;
+        uint8_t state = sup[sensor].health.state;
+        return state == HEALTH_OK || state == HEALTH_DEGRADED;
+    }
+
+    const SensorHealth &health(uint8_t sensor) const {
+        return sup[sensor < HEALTH_SENSOR_COUNT ? sensor : 0].health;
+    }
+
+    const BusHealth &busHealth() const { return bus; }
+
+private:
+    struct Supervised {
+        SensorHealth health;
+        uint32_t faultStartMs;      // Inizio guasto (per il tempo di recovery)
+        uint32_t nextAttemptMs;
+        uint32_t attemptStartMs;
+        uint16_t stallCount;        // Cicli con bus OK ma dato non plausibile
+        bool stallHandled;          // Re-init già tentato per questo stallo
+        bool awaitingData;          // Re-init riuscito, attende il primo ciclo OK
+        uint8_t step;               // Passo di re-init in corso
+        I2CTransaction tx;          // Job di re-init (resta valido fino al termine)
+    };
+
+    HealthPort &port;
+    Supervised sup[HEALTH_SENSOR_COUNT];
+    I2CTransaction recoverTx;
+    BusHealth bus;
+    bool busRecoverRequested;
+    bool recoverInFlight;
+
+    void reset() {
+        memset(sup, 0, sizeof(sup));
+        memset(&recoverTx, 0, sizeof(recoverTx));
+        memset(&bus, 0, sizeof(bus));
+        busRecoverRequested = false;
+        recoverInFlight = false;
+    }
+
+    void declareFault(uint8_t sensor, uint32_t now) {
+        Supervised &s = sup[sensor];
+        s.health.state = HEALTH_FAILED;
+        s.health.faults++;
+        s.health.backoff_ms = HEALTH_BACKOFF_MIN_MS;
+        s.faultStartMs = now;
+        s.nextAttemptMs = now + s.health.backoff_ms;
+        s.awaitingData = false;
+        port.suspend(sensor);
+
+        // Errori contemporanei sull'altro sensore: probabile bus bloccato
+        uint8_t other = (sensor == HEALTH_RADAR) ? HEALTH_IMU : HEALTH_RADAR;
+        if (sup[other].health.consecutive_errors > 0) {
+            busRecoverRequested = true;
+        }
+        port.onFault(sensor, s.health);
+    }
+
+    // Un passo di re-init come job a bassa priorità, con deadline pari al
+    // budget residuo del tentativo: se il bus è occupato scade invece di ritardare
+    void submitStep(uint8_t sensor, uint32_t now) {
+        port.prepareInitStep(sensor, sup[sensor].step, sup[sensor].tx);
+        submitPrepared(sensor, now);
+    }
+
+    void submitPrepared(uint8_t sensor, uint32_t now) {
+        Supervised &s = sup[sensor];
+        uint32_t used = now - s.attemptStartMs;
+        uint32_t left = used < HEALTH_RECOVERY_BUDGET_MS ? HEALTH_RECOVERY_BUDGET_MS - used : 0;
+        s.tx.deadline_us = port.deadlineFromNow(left * 1000);
+
+        // In caso di coda piena result è già terminale: gestito come fallimento
+        port.submit(s.tx);
+    }
+
+    void attemptFailed(uint8_t sensor, uint32_t now) {
+        Supervised &s = sup[sensor];
+        s.health.state = HEALTH_FAILED;
+        s.health.last_attempt_ms = now - s.attemptStartMs;
+        s.health.backoff_ms = s.health.backoff_ms * 2 < HEALTH_BACKOFF_MAX_MS
+                                  ? s.health.backoff_ms * 2 : HEALTH_BACKOFF_MAX_MS;
+        s.nextAttemptMs = now + s.health.backoff_ms;
+        port.suspend(sensor);
+
+        // Prima del prossimo tentativo si libera comunque il bus
+        busRecoverRequested = true;
+        port.onAttemptFailed(sensor, s.health, s.tx.result);
+    }
+
+    void attemptSucceeded(uint8_t sensor, uint32_t now) {
+        Supervised &s = sup[sensor];
+        s.health.state = HEALTH_OK;
+        s.health.recoveries++;
+        s.health.consecutive_errors = 0;
+        s.health.last_attempt_ms = now - s.attemptStartMs;
+        s.health.backoff_ms = 0;
+        s.awaitingData = true;
+        port.onRecovered(sensor, s.health);
+    }
+};
+
+#endif // HEALTH_SUPERVISOR_H
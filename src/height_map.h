@@ -0,0 +1,204 @@
+// height_map.h
+// Griglia 2D incrementale dai punti dello sweep: per cella media, minimo,
+// massimo e numero di campioni. Memoria fissa (dimensioni nel template),
+// aggiornamento O(1) e lista delle celle cambiate, così il display ridisegna
+// solo quelle invece dell'intera immagine.
+//
+// Due proiezioni:
+//   ANGOLI  colonne = yaw, righe = pitch (in alto = più su), valore = distanza
+//   PIANTA  colonne = X, righe = Y (in alto = più lontano), valore = Z (quota)
+// La griglia si centra sul primo campione dopo reset(); i campioni fuori
+// griglia vengono contati e scartati.
+// Header puro C++, test in tools/height_map_test.cpp.
+#ifndef HEIGHT_MAP_H
+#define HEIGHT_MAP_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "sync_queue.h"
+
+#define HEIGHT_MAP_MAX_COUNT       0xFFFF     // Oltre, la media diventa mobile
+
+enum HeightMapMode : uint8_t {
+    HEIGHT_MAP_ANGULAR = 0,
+    HEIGHT_MAP_PLAN
+};
+
+struct HeightMapCell {
+    float mean;
+    float min;
+    float max;
+    uint16_t count;             // 0 = cella vuota
+    uint8_t dirty;              // In lista per il ridisegno
+    uint8_t reserved;
+};
+
+struct HeightMapStats {
+    uint8_t mode;
+    float cell_size;            // Gradi (ANGOLI) o mm (PIANTA)
+    float origin_u, origin_v;   // Centro della griglia (yaw/pitch o X/Y)
+    uint32_t samples;           // Campioni entrati in griglia
+    uint32_t rejected;          // Fuori griglia o non finiti
+    uint32_t occupied;          // Celle con almeno un campione
+    float value_min;            // Estremi dei valori (scala colori)
+    float value_max;
+    uint32_t generation;        // Cambia a ogni clear(): la UI ridisegna lo sfondo
+};
+
+// Differenza angolare nel verso più corto (-180..180]
+inline float heightMapWrapDeg(float d) {
+    d = fmodf(d, 360.0f);
+    if (d > 180.0f) d -= 360.0f;
+    if (d <= -180.0f) d += 360.0f;
+    return d;
+}
+
+template <uint16_t COLS, uint16_t ROWS>
+class HeightMap {
+public:
+    static constexpr uint32_t CELLS = (uint32_t)COLS * ROWS;
+
+    void reset(HeightMapMode m, float cellSize) {
+        mode = m;
+        cell = cellSize > 0 ? cellSize : 1.0f;
+        clear();
+    }
+
+    // Svuota e ricentra sul prossimo campione
+    void clear() {
+        memset(cells, 0, sizeof(cells));
+        dirtyCount = 0;
+        centered = false;
+        originU = originV = 0;
+        samples = rejected = occupied = 0;
+        valueMin = INFINITY;
+        valueMax = -INFINITY;
+        generation++;
+    }
+
+    // Campione fuso del task sensori (solo radar e IMU validi)
+    bool add(const SensorData &d) {
+        if (!d.radar_valid || !d.imu_valid) return false;
+        if (mode == HEIGHT_MAP_ANGULAR) return add(d.yaw_deg, d.pitch_deg, d.distance_mm);
+        return add(d.x_mm, d.y_mm, d.z_mm);
+    }
+
+    // u, v nelle unità della proiezione (gradi o mm)
+    bool add(float u, float v, float value) {
+        if (!isfinite(u) || !isfinite(v) || !isfinite(value)) {
+            rejected++;
+            return false;
+        }
+        if (!centered) {
+            originU = u;
+            originV = v;
+            centered = true;
+        }
+        float du = mode == HEIGHT_MAP_ANGULAR ? heightMapWrapDeg(u - originU) : u - originU;
+        float dv = v - originV;
+        int32_t col = (int32_t)floorf(du / cell + COLS * 0.5f);
+        int32_t row = (int32_t)floorf((float)ROWS * 0.5f - dv / cell);     // Riga 0 in alto
+        if (col < 0 || col >= COLS || row < 0 || row >= ROWS) {
+            rejected++;
+            return false;
+        }
+
+        uint32_t idx = (uint32_t)row * COLS + col;
+        HeightMapCell &c = cells[idx];
+        if (c.count == 0) {
+            c.mean = c.min = c.max = value;
+            c.count = 1;
+            occupied++;
+        } else {
+            if (c.count < HEIGHT_MAP_MAX_COUNT) c.count++;
+            c.mean += (value - c.mean) / c.count;
+            if (value < c.min) c.min = value;
+            if (value > c.max) c.max = value;
+        }
+        if (value < valueMin) valueMin = value;
+        if (value > valueMax) valueMax = value;
+        samples++;
+        markDirty(idx);
+        return true;
+    }
+
+    // Preleva fino a max celle cambiate (indice + copia) e le toglie dalla lista
+    uint16_t takeDirty(uint16_t *indices, HeightMapCell *out, uint16_t max) {
+        uint16_t n = 0;
+        while (n < max && dirtyCount > 0) {
+            uint16_t idx = dirtyList[--dirtyCount];
+            cells[idx].dirty = 0;
+            indices[n] = idx;
+            out[n] = cells[idx];
+            n++;
+        }
+        return n;
+    }
+
+    // Tutte le celle occupate da ridisegnare (cambio scala colori)
+    void markAllDirty() {
+        for (uint32_t i = 0; i < CELLS; i++) {
+            if (cells[i].count) markDirty(i);
+        }
+    }
+
+    void getStats(HeightMapStats &s) const {
+        s.mode = mode;
+        s.cell_size = cell;
+        s.origin_u = originU;
+        s.origin_v = originV;
+        s.samples = samples;
+        s.rejected = rejected;
+        s.occupied = occupied;
+        s.value_min = occupied ? valueMin : 0;
+        s.value_max = occupied ? valueMax : 0;
+        s.generation = generation;
+    }
+
+    const HeightMapCell &at(uint16_t col, uint16_t row) const { return cells[(uint32_t)row * COLS + col]; }
+    HeightMapMode getMode() const { return mode; }
+    float cellSize() const { return cell; }
+    uint32_t pending() const { return dirtyCount; }
+
+private:
+    void markDirty(uint32_t idx) {
+        if (cells[idx].dirty) return;
+        cells[idx].dirty = 1;
+        dirtyList[dirtyCount++] = (uint16_t)idx;
+    }
+
+    static_assert(CELLS <= 65536, "HeightMap: indici a 16 bit");
+
+    HeightMapCell cells[CELLS];
+    uint16_t dirtyList[CELLS];  // Ogni cella al più una volta
+    uint32_t dirtyCount = 0;
+    HeightMapMode mode = HEIGHT_MAP_ANGULAR;
+    float cell = 1.0f;
+    bool centered = false;
+    float originU = 0, originV = 0;
+    uint32_t samples = 0, rejected = 0, occupied = 0;
+    float valueMin = INFINITY, valueMax = -INFINITY;
+    uint32_t generation = 0;
+};
+
+// === SCALA COLORI ===
+// t in [0,1] -> RGB565 lungo blu, ciano, verde, giallo, rosso
+inline uint16_t heightMapColor(float t) {
+    static const uint8_t stops[5][3] = {
+        {0, 0, 255}, {0, 255, 255}, {0, 255, 0}, {255, 255, 0}, {255, 0, 0}
+    };
+    if (!(t > 0)) t = 0;
+    if (t > 1) t = 1;
+    float f = t * 4.0f;
+    int i = (int)f;
+    if (i > 3) i = 3;
+    f -= i;
+    uint8_t rgb[3];
+    for (int k = 0; k < 3; k++) {
+        rgb[k] = (uint8_t)(stops[i][k] + (stops[i + 1][k] - stops[i][k]) * f);
+    }
+    return (uint16_t)(((rgb[0] & 0xF8) << 8) | ((rgb[1] & 0xFC) << 3) | (rgb[2] >> 3));
+}
+
+#endif // HEIGHT_MAP_H
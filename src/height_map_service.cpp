@@ -0,0 +1,122 @@
+// height_map_service.cpp
+#include "height_map_service.h"
+#include "esp_heap_caps.h"
+#include <new>
+
+// === VARIABILI DI STATO ===
+// Aggiornamenti e prelievi sono brevi e a costo fisso: basta una sezione
+// critica, il task sensori non attende mai un mutex
+static SweepHeightMap *grid = NULL;
+static portMUX_TYPE mapLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile HeightMapMode mode = HEIGHT_MAP_ANGULAR;
+static float cellDeg = HEIGHT_MAP_DEFAULT_CELL_DEG;
+static float cellMm = HEIGHT_MAP_DEFAULT_CELL_MM;
+static bool inPSRAM = false;
+
+static void resetLocked() {
+    grid->reset(mode, mode == HEIGHT_MAP_ANGULAR ? cellDeg : cellMm);
+}
+
+bool initHeightMap() {
+    if (grid) return true;
+    void *mem = heap_caps_malloc(sizeof(SweepHeightMap), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    inPSRAM = mem != NULL;
+    if (!mem) mem = heap_caps_malloc(sizeof(SweepHeightMap), MALLOC_CAP_8BIT);
+    if (!mem) {
+        Serial.println("❌ Height map allocation failed");
+        return false;
+    }
+    SweepHeightMap *g = new (mem) SweepHeightMap();
+
+    taskENTER_CRITICAL(&mapLock);
+    grid = g;
+    resetLocked();
+    taskEXIT_CRITICAL(&mapLock);
+
+    Serial.printf("✅ Height map: %ux%u celle in %s (%u KB)\n", HEIGHT_MAP_COLS, HEIGHT_MAP_ROWS,
+                  inPSRAM ? "PSRAM" : "RAM interna", (unsigned)(sizeof(SweepHeightMap) / 1024));
+    return true;
+}
+
+void heightMapProcess(const SensorData &data) {
+    if (!grid || !data.radar_valid || !data.imu_valid) return;
+    taskENTER_CRITICAL(&mapLock);
+    grid->add(data);
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+void setHeightMapMode(HeightMapMode m) {
+    taskENTER_CRITICAL(&mapLock);
+    mode = m > HEIGHT_MAP_PLAN ? HEIGHT_MAP_ANGULAR : m;
+    if (grid) resetLocked();
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+HeightMapMode getHeightMapMode() {
+    return mode;
+}
+
+void setHeightMapCells(float deg, float mm) {
+    taskENTER_CRITICAL(&mapLock);
+    if (deg > 0) cellDeg = deg;
+    if (mm > 0) cellMm = mm;
+    if (grid) resetLocked();
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+void getHeightMapCells(float &deg, float &mm) {
+    taskENTER_CRITICAL(&mapLock);
+    deg = cellDeg;
+    mm = cellMm;
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+void clearHeightMap() {
+    taskENTER_CRITICAL(&mapLock);
+    if (grid) grid->clear();
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+void getHeightMapStats(HeightMapStats &stats) {
+    memset(&stats, 0, sizeof(stats));
+    taskENTER_CRITICAL(&mapLock);
+    if (grid) grid->getStats(stats);
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+bool getHeightMapCell(uint16_t col, uint16_t row, HeightMapCell &cell) {
+    if (col >= HEIGHT_MAP_COLS || row >= HEIGHT_MAP_ROWS) return false;
+    taskENTER_CRITICAL(&mapLock);
+    bool ok = grid != NULL;
+    if (ok) cell = grid->at(col, row);
+    taskEXIT_CRITICAL(&mapLock);
+    return ok && cell.count > 0;
+}
+
+uint16_t takeHeightMapDirty(uint16_t *indices, HeightMapCell *cells, uint16_t max) {
+    taskENTER_CRITICAL(&mapLock);
+    uint16_t n = grid ? grid->takeDirty(indices, cells, max) : 0;
+    taskEXIT_CRITICAL(&mapLock);
+    return n;
+}
+
+void markHeightMapDirty() {
+    taskENTER_CRITICAL(&mapLock);
+    if (grid) grid->markAllDirty();
+    taskEXIT_CRITICAL(&mapLock);
+}
+
+void printHeightMapStats() {
+    HeightMapStats s;
+    getHeightMapStats(s);
+    bool angular = s.mode == HEIGHT_MAP_ANGULAR;
+    Serial.printf("\n=== Height Map (%s, %ux%u, cella %.2f%s) ===\n", angular ? "yaw x pitch" : "pianta XY",
+                  HEIGHT_MAP_COLS, HEIGHT_MAP_ROWS, s.cell_size, angular ? "°" : "mm");
+    Serial.printf("Celle %lu/%u, campioni %lu, fuori griglia %lu\n", (unsigned long)s.occupied,
+                  HEIGHT_MAP_COLS * HEIGHT_MAP_ROWS, (unsigned long)s.samples, (unsigned long)s.rejected);
+    if (s.occupied > 0) {
+        Serial.printf("Centro %.1f %.1f%s, %s %.1f..%.1f mm\n", s.origin_u, s.origin_v, angular ? "°" : "mm",
+                      angular ? "distanza" : "quota", s.value_min, s.value_max);
+    }
+    Serial.println("=====================\n");
+}
@@ -0,0 +1,39 @@
+// height_map_service.h
+#ifndef HEIGHT_MAP_SERVICE_H
+#define HEIGHT_MAP_SERVICE_H
+
+#include <Arduino.h>
+#include "height_map.h"
+
+// === MAPPA DI QUOTA DALLO SWEEP ===
+// Griglia HEIGHT_MAP_COLS x HEIGHT_MAP_ROWS allocata una volta (PSRAM se
+// c'è). Il task sensori passa ogni campione a heightMapProcess(): O(1),
+// nessun I/O. La UI preleva solo le celle cambiate.
+
+#define HEIGHT_MAP_COLS              40      // 6px per cella: 240x240 sul display
+#define HEIGHT_MAP_ROWS              40
+#define HEIGHT_MAP_DEFAULT_CELL_DEG  1.0f
+#define HEIGHT_MAP_DEFAULT_CELL_MM   50.0f
+
+typedef HeightMap<HEIGHT_MAP_COLS, HEIGHT_MAP_ROWS> SweepHeightMap;
+
+bool initHeightMap();
+
+// Dal task sensori, una volta per ciclo dopo il calcolo delle coordinate
+void heightMapProcess(const SensorData &data);
+
+// Cambiare modo o celle svuota la griglia
+void setHeightMapMode(HeightMapMode mode);
+HeightMapMode getHeightMapMode();
+void setHeightMapCells(float cellDeg, float cellMm);
+void getHeightMapCells(float &cellDeg, float &cellMm);
+void clearHeightMap();
+
+void getHeightMapStats(HeightMapStats &stats);
+bool getHeightMapCell(uint16_t col, uint16_t row, HeightMapCell &cell);
+uint16_t takeHeightMapDirty(uint16_t *indices, HeightMapCell *cells, uint16_t max);
+void markHeightMapDirty();      // Ridisegno completo (nuova scala colori)
+
+void printHeightMapStats();
+
+#endif // HEIGHT_MAP_SERVICE_H
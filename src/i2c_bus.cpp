@@ -0,0 +1,317 @@
+// i2c_bus.cpp
+#include "i2c_bus.h"
+#include "task_config.h"
+#include "timebase.h"
+
+// Mezzo periodo SCL durante il clock-out (~100kHz)
+#define I2C_RECOVER_HALF_PERIOD_US  5
+#define I2C_RECOVER_CLOCKS          9
+
+#ifdef I2C_BUS_SIMULATOR
+#include "i2c_sim_backend.h"
+#endif
+
+// === BACKEND WIRE ===
+class WireBackend : public I2CBackend {
+public:
+    WireBackend(TwoWire &w, int sdaPin, int sclPin) : wire(w), sda(sdaPin), scl(sclPin) {}
+
+    bool readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) override {
+        wire.beginTransmission(addr);
+        wire.write(reg);
+        if (wire.endTransmission(false) != 0) return false;
+
+        if (wire.requestFrom(addr, (size_t)len) != len) return false;
+        for (uint8_t i = 0; i < len; i++) {
+            buf[i] = wire.read();
+        }
+        return true;
+    }
+
+    bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t len) override {
+        wire.beginTransmission(addr);
+        wire.write(reg);
+        wire.write(buf, len);
+        return wire.endTransmission() == 0;
+    }
+
+    // Uno slave interrotto a metà byte può tenere SDA bassa: si stacca la
+    // periferica, si danno fino a 9 clock su SCL finché SDA si libera, poi
+    // uno STOP manuale e si riavvia Wire. Durata limitata (~150us).
+    bool recoverBus() override {
+        uint32_t clock = wire.getClock();
+        wire.end();
+
+        pinMode(sda, INPUT_PULLUP);
+        pinMode(scl, OUTPUT_OPEN_DRAIN);
+        digitalWrite(scl, HIGH);
+        delayMicroseconds(I2C_RECOVER_HALF_PERIOD_US);
+
+        for (int i = 0; i < I2C_RECOVER_CLOCKS && digitalRead(sda) == LOW; i++) {
+            digitalWrite(scl, LOW);
+            delayMicroseconds(I2C_RECOVER_HALF_PERIOD_US);
+            digitalWrite(scl, HIGH);
+            delayMicroseconds(I2C_RECOVER_HALF_PERIOD_US);
+        }
+
+        // STOP: SDA sale mentre SCL è alta
+        pinMode(sda, OUTPUT_OPEN_DRAIN);
+        digitalWrite(sda, LOW);
+        delayMicroseconds(I2C_RECOVER_HALF_PERIOD_US);
+        digitalWrite(scl, HIGH);
+        delayMicroseconds(I2C_RECOVER_HALF_PERIOD_US);
+        digitalWrite(sda, HIGH);
+        delayMicroseconds(I2C_RECOVER_HALF_PERIOD_US);
+
+        pinMode(sda, INPUT_PULLUP);
+        bool released = digitalRead(sda) == HIGH;
+
+        wire.begin(sda, scl, clock);
+        return released;
+    }
+
+    uint64_t nowUs() override {
+        return timebaseNowUs();
+    }
+
+private:
+    TwoWire &wire;
+    int sda;
+    int scl;
+};
+
+#ifdef I2C_BUS_SIMULATOR
+// Sul target il simulatore usa il tempo reale e attende la latenza modellata
+class TargetSimBackend : public I2CSimBackend {
+public:
+    bool readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) override {
+        delayMicroseconds(baseLatencyUs + len * byteLatencyUs);
+        return I2CSimBackend::readRegs(addr, reg, buf, len);
+    }
+    bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t len) override {
+        delayMicroseconds(baseLatencyUs + len * byteLatencyUs);
+        return I2CSimBackend::writeRegs(addr, reg, buf, len);
+    }
+    uint64_t nowUs() override {
+        return timebaseNowUs();
+    }
+};
+#endif
+
+// === VARIABILI DI STATO ===
+static I2CScheduler scheduler;
+static I2CBackend *backend = NULL;
+static TaskHandle_t busTaskHandle = NULL;
+static portMUX_TYPE schedulerLock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *deviceNames[I2C_DEV_COUNT] = {
+    "XM125",
+    "LSM6DSOX",
+    "LIS3MDL",
+    "other"
+};
+
+// === TASK BUS ===
+static void i2cBusTask(void *pvParameters) {
+    RTOS_LOG("I2C bus task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_I2C);
+
+    I2CTransaction *batch[I2C_BATCH_MAX];
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (1) {
+            portENTER_CRITICAL(&schedulerLock);
+            uint8_t n = scheduler.pop(batch);
+            portEXIT_CRITICAL(&schedulerLock);
+            if (!n) break;
+
+            // Bus fuori lock, contatori sotto lock (letti da console/monitor)
+            I2CBatchRun run;
+            if (!scheduler.transfer(batch, n, run)) break;
+            portENTER_CRITICAL(&schedulerLock);
+            scheduler.account(batch, n, run);
+            portEXIT_CRITICAL(&schedulerLock);
+
+            // Completamento: callback nel contesto bus, poi result, poi notifica.
+            // Il descrittore può stare sullo stack del chiamante, che ritorna
+            // appena vede result: dopo la pubblicazione si usano solo copie locali.
+            for (uint8_t i = 0; i < n; i++) {
+                I2CTransaction *t = batch[i];
+                uint8_t result = t->outcome;
+                I2CCallback callback = t->callback;
+                TaskHandle_t notify = (TaskHandle_t)t->notify;
+
+                if (result != I2C_RESULT_OK) {
+                    flightEvent(FR_EV_I2C_ERROR, t->device, result);
+                    RTOS_LOG("I2C %s: result %d", deviceNames[t->device % I2C_DEV_COUNT], result);
+                }
+                if (callback) {
+                    callback(t);
+                }
+                i2cPublishResult(*t, result);
+                if (notify) {
+                    xTaskNotifyGive(notify);
+                }
+            }
+        }
+        flightTaskBeat(FR_TASK_I2C);
+    }
+}
+
+// === INIZIALIZZAZIONE ===
+bool initI2CBus(TwoWire &wire, int sdaPin, int sclPin) {
+    if (busTaskHandle) return true;
+
+#ifdef I2C_BUS_SIMULATOR
+    static TargetSimBackend simBackend;
+    backend = &simBackend;
+    Serial.println("⚠️ I2C bus in modalità SIMULATORE");
+#else
+    static WireBackend wireBackend(wire, sdaPin, sclPin);
+    backend = &wireBackend;
+#endif
+    scheduler.setBackend(backend);
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        i2cBusTask,
+        "I2CBus",
+        I2C_BUS_TASK_STACK_SIZE,
+        NULL,
+        I2C_BUS_TASK_PRIORITY,
+        &busTaskHandle,
+        SENSOR_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create I2C bus task");
+        busTaskHandle = NULL;
+        return false;
+    }
+
+    Serial.println("✅ I2C bus manager avviato");
+    return true;
+}
+
+bool isI2CBusRunning() {
+    return busTaskHandle != NULL;
+}
+
+// === SOTTOMISSIONE ===
+bool i2cSubmit(I2CTransaction &t) {
+    if (!busTaskHandle) {
+        t.result = I2C_RESULT_ERROR;
+        return false;
+    }
+
+    uint64_t now = backend->nowUs();
+    portENTER_CRITICAL(&schedulerLock);
+    bool queued = scheduler.push(&t, now);
+    portEXIT_CRITICAL(&schedulerLock);
+
+    if (!queued) {
+        flightEvent(FR_EV_QUEUE_OVERFLOW, FR_QUEUE_I2C, t.device);
+        RTOS_LOG("I2C queue full (prio %d)", t.priority);
+        return false;
+    }
+
+    xTaskNotifyGive(busTaskHandle);
+    return true;
+}
+
+I2CResult i2cExecute(I2CTransaction &t, uint32_t timeout_ms) {
+    t.notify = xTaskGetCurrentTaskHandle();
+    if (!i2cSubmit(t)) {
+        return (I2CResult)t.result;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = MS_TO_TICKS(timeout_ms);
+    while (!i2cIsDone(t)) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout || !ulTaskNotifyTake(pdTRUE, timeout - elapsed)) {
+            break;
+        }
+    }
+
+    if (!i2cIsDone(t)) {
+        portENTER_CRITICAL(&schedulerLock);
+        bool cancelled = scheduler.cancel(&t);
+        portEXIT_CRITICAL(&schedulerLock);
+
+        if (cancelled) {
+            t.result = I2C_RESULT_TIMEOUT;
+        } else {
+            // Già in esecuzione: il descrittore deve restare valido fino alla fine
+            while (!i2cIsDone(t)) {
+                ulTaskNotifyTake(pdTRUE, MS_TO_TICKS(10));
+            }
+        }
+    }
+
+    return (I2CResult)t.result;
+}
+
+I2CResult i2cRunJob(uint8_t device, uint8_t priority, I2CJobFn job, void *ctx,
+                    uint32_t timeout_ms) {
+    I2CTransaction t;
+    i2cPrepareJob(t, device, priority, job, ctx);
+    return i2cExecute(t, timeout_ms);
+}
+
+uint64_t i2cDeadlineFromNow(uint32_t us) {
+    return (backend ? backend->nowUs() : timebaseNowUs()) + us;
+}
+
+// === STATISTICHE ===
+// Copia sotto lock: execute() aggiorna i contatori dal task bus
+void getI2CDeviceStats(uint8_t device, I2CDeviceStats &stats) {
+    portENTER_CRITICAL(&schedulerLock);
+    stats = scheduler.getStats(device);
+    portEXIT_CRITICAL(&schedulerLock);
+}
+
+uint8_t getI2CQueueDepth() {
+    uint8_t depth = 0;
+    portENTER_CRITICAL(&schedulerLock);
+    for (uint8_t p = 0; p < I2C_PRIO_COUNT; p++) depth += scheduler.pendingCount(p);
+    portEXIT_CRITICAL(&schedulerLock);
+    return depth;
+}
+
+void resetI2CStats() {
+    portENTER_CRITICAL(&schedulerLock);
+    scheduler.resetStats();
+    portEXIT_CRITICAL(&schedulerLock);
+}
+
+const char *getI2CDeviceName(uint8_t device) {
+    return deviceNames[device < I2C_DEV_COUNT ? device : I2C_DEV_OTHER];
+}
+
+void printI2CStats() {
+    Serial.println("\n=== I2C Bus Stats ===");
+    for (uint8_t d = 0; d < I2C_DEV_COUNT; d++) {
+        I2CDeviceStats s;
+        getI2CDeviceStats(d, s);
+        if (!s.transactions && !s.deadline_misses) continue;
+
+        Serial.printf("%-9s tx:%lu busy:%lums max:%luus wait:%luus err:%lu miss:%lu batch:%lu\n",
+                      deviceNames[d],
+                      (unsigned long)s.transactions,
+                      (unsigned long)(s.busy_us / 1000),
+                      (unsigned long)s.max_busy_us,
+                      (unsigned long)s.max_wait_us,
+                      (unsigned long)s.errors,
+                      (unsigned long)s.deadline_misses,
+                      (unsigned long)s.batched);
+    }
+    Serial.println("=====================\n");
+}
+
+#ifdef I2C_BUS_SIMULATOR
+I2CSimBackend *getI2CSimulator() {
+    return static_cast<I2CSimBackend *>(backend);
+}
+#endif
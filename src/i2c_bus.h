@@ -0,0 +1,48 @@
+// i2c_bus.h
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "i2c_scheduler.h"
+
+// === BUS MANAGER I2C ===
+// Un solo task possiede Wire: driver e letture registri vengono accodati
+// come transazioni con priorità e deadline invece di prendere un mutex.
+// Con I2C_BUS_SIMULATOR definito il backend Wire è sostituito dal simulatore.
+
+// Inizializza scheduler e task del bus (Wire già avviato con begin()).
+// I pin servono al recovery del bus (clock-out manuale di SCL).
+bool initI2CBus(TwoWire &wire, int sdaPin, int sclPin);
+bool isI2CBusRunning();
+
+// === SOTTOMISSIONE ===
+// Asincrona: completa via t.callback (esito in t.outcome, result ancora
+// PENDING) e/o notifica a t.notify dopo la pubblicazione di result
+bool i2cSubmit(I2CTransaction &t);
+
+// Sincrona: attende il completamento (notifica al task chiamante).
+// Allo scadere del timeout la transazione viene annullata se non avviata.
+I2CResult i2cExecute(I2CTransaction &t, uint32_t timeout_ms);
+
+// Esegue una funzione driver in esclusiva sul bus (sincrona)
+I2CResult i2cRunJob(uint8_t device, uint8_t priority, I2CJobFn job, void *ctx,
+                    uint32_t timeout_ms);
+
+// Deadline relativa all'istante corrente, in µs del bus (timebase.h)
+uint64_t i2cDeadlineFromNow(uint32_t us);
+
+// === STATISTICHE ===
+void getI2CDeviceStats(uint8_t device, I2CDeviceStats &stats);
+void resetI2CStats();
+void printI2CStats();
+uint8_t getI2CQueueDepth();     // Transazioni in coda, tutte le priorità
+const char *getI2CDeviceName(uint8_t device);
+
+#ifdef I2C_BUS_SIMULATOR
+// Accesso al simulatore per preparare registri / latenze
+class I2CSimBackend;
+I2CSimBackend *getI2CSimulator();
+#endif
+
+#endif // I2C_BUS_H
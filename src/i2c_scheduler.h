@@ -0,0 +1,396 @@
+// i2c_scheduler.h
+// Nucleo di scheduling del bus I2C: nessuna dipendenza da Arduino/FreeRTOS,
+// così la logica (priorità, deadline, batching, accounting) gira anche su host
+// con I2CSimBackend (vedi i2c_sim_backend.h).
+#ifndef I2C_SCHEDULER_H
+#define I2C_SCHEDULER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// === CONFIGURAZIONE ===
+#define I2C_QUEUE_DEPTH       8       // Transazioni pendenti per priorità
+#define I2C_BATCH_MAX         4       // Max transazioni fuse in un burst
+#define I2C_BATCH_MAX_BYTES   32      // Max byte letti in un burst
+
+// === DISPOSITIVI (per accounting tempo bus) ===
+enum I2CDevice : uint8_t {
+    I2C_DEV_RADAR = 0,      // XM125
+    I2C_DEV_IMU,            // LSM6DSOX (accel + gyro)
+    I2C_DEV_MAG,            // LIS3MDL
+    I2C_DEV_OTHER,
+    I2C_DEV_COUNT
+};
+
+// === PRIORITÀ (0 = più alta) ===
+enum I2CPriority : uint8_t {
+    I2C_PRIO_HIGH = 0,      // Letture IMU: brevi, sensibili al sync
+    I2C_PRIO_NORMAL,        // Letture radar
+    I2C_PRIO_LOW,           // Configurazione, re-init, diagnostica
+    I2C_PRIO_COUNT
+};
+
+enum I2COp : uint8_t {
+    I2C_OP_READ_REGS,       // Lettura registri (fondibile in burst)
+    I2C_OP_WRITE_REGS,      // Scrittura registri
+    I2C_OP_JOB,             // Funzione driver eseguita in esclusiva sul bus
+    I2C_OP_BUS_RECOVER      // Sblocco bus (clock-out SCL + STOP)
+};
+
+enum I2CResult : uint8_t {
+    I2C_RESULT_IDLE = 0,        // Preparata, non ancora sottomessa
+    I2C_RESULT_PENDING,
+    I2C_RESULT_OK,
+    I2C_RESULT_ERROR,           // NACK / errore driver
+    I2C_RESULT_DEADLINE_MISSED, // Scartata: deadline già passata all'avvio
+    I2C_RESULT_QUEUE_FULL,
+    I2C_RESULT_TIMEOUT          // Annullata dal chiamante
+};
+
+#define I2C_FLAG_NO_BATCH   0x01    // Non fondere con letture adiacenti
+
+struct I2CTransaction;
+typedef void (*I2CCallback)(I2CTransaction *t);
+typedef bool (*I2CJobFn)(void *ctx);
+
+// === DESCRITTORE TRANSAZIONE ===
+// Il descrittore resta del chiamante (niente copie): non va riutilizzato
+// finché result == I2C_RESULT_PENDING. execute() scrive l'esito in outcome;
+// result è pubblicato per ultimo (i2cPublishResult), dopo il quale il bus
+// non tocca più il descrittore e il chiamante può liberarlo.
+struct I2CTransaction {
+    // Richiesta
+    uint8_t device;             // I2CDevice
+    uint8_t priority;           // I2CPriority
+    uint8_t op;                 // I2COp
+    uint8_t flags;
+    uint8_t addr;               // Indirizzo 7 bit (per i job: 0 o dispositivo pilotato)
+    uint8_t reg;                // Registro iniziale
+    uint8_t len;                // Byte da leggere/scrivere
+    uint8_t *buf;
+    I2CJobFn job;               // Solo per I2C_OP_JOB
+    void *ctx;
+    uint64_t deadline_us;       // Avvio entro questo istante (0 = nessuna)
+
+    // Completamento
+    I2CCallback callback;       // Chiamata nel contesto del bus (breve!)
+    void *user;
+    void *notify;               // TaskHandle_t da notificare (lato FreeRTOS)
+
+    // Esito
+    volatile uint8_t result;    // I2CResult, pubblicato per ultimo
+    uint8_t outcome;            // Esito di execute() in attesa di pubblicazione
+    uint64_t submit_us;
+    uint64_t start_us;
+    uint64_t complete_us;       // Istante fine trasferimento
+};
+
+inline bool i2cIsDone(const I2CTransaction &t) {
+    return __atomic_load_n(&t.result, __ATOMIC_ACQUIRE) > I2C_RESULT_PENDING;
+}
+
+// Ultima scrittura sul descrittore: rende visibili esito e tempi al chiamante
+inline void i2cPublishResult(I2CTransaction &t, uint8_t result) {
+    __atomic_store_n(&t.result, result, __ATOMIC_RELEASE);
+}
+
+// Helper per costruire descrittori
+inline void i2cPrepareRead(I2CTransaction &t, uint8_t device, uint8_t priority,
+                           uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) {
+    memset(&t, 0, sizeof(t));
+    t.device = device;
+    t.priority = priority;
+    t.op = I2C_OP_READ_REGS;
+    t.addr = addr;
+    t.reg = reg;
+    t.buf = buf;
+    t.len = len;
+}
+
+inline void i2cPrepareWrite(I2CTransaction &t, uint8_t device, uint8_t priority,
+                            uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) {
+    i2cPrepareRead(t, device, priority, addr, reg, buf, len);
+    t.op = I2C_OP_WRITE_REGS;
+}
+
+inline void i2cPrepareJob(I2CTransaction &t, uint8_t device, uint8_t priority,
+                          I2CJobFn job, void *ctx) {
+    memset(&t, 0, sizeof(t));
+    t.device = device;
+    t.priority = priority;
+    t.op = I2C_OP_JOB;
+    t.job = job;
+    t.ctx = ctx;
+}
+
+inline void i2cPrepareRecover(I2CTransaction &t, uint8_t priority) {
+    memset(&t, 0, sizeof(t));
+    t.device = I2C_DEV_OTHER;
+    t.priority = priority;
+    t.op = I2C_OP_BUS_RECOVER;
+    t.flags = I2C_FLAG_NO_BATCH;
+}
+
+// === BACKEND (Wire su target, simulatore su host) ===
+class I2CBackend {
+public:
+    virtual ~I2CBackend() {}
+    virtual bool readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) = 0;
+    virtual bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t len) = 0;
+    virtual bool runJob(uint8_t /*addr*/, I2CJobFn job, void *ctx) { return job ? job(ctx) : false; }
+    // Libera un bus bloccato da uno slave che tiene SDA bassa; true se SDA torna alta
+    virtual bool recoverBus() { return false; }
+    virtual uint64_t nowUs() = 0;
+};
+
+// === STATISTICHE PER DISPOSITIVO ===
+struct I2CDeviceStats {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t deadline_misses;
+    uint32_t batched;           // Transazioni servite dentro un burst altrui
+    uint64_t busy_us;           // Tempo bus totale
+    uint32_t max_busy_us;       // Transazione più lunga
+    uint32_t max_wait_us;       // Attesa in coda più lunga
+};
+
+// Esito di un trasferimento, fra transfer() e account()
+struct I2CBatchRun {
+    uint64_t start;
+    uint64_t end;
+    uint16_t bytes;
+    bool ok;
+    bool missed;                // Deadline già passata: niente bus
+};
+
+// === SCHEDULER ===
+// Non thread-safe: il chiamante serializza push()/pop()/cancel()/account()
+// e le letture delle statistiche; transfer() gira fuori dal lock.
+class I2CScheduler {
+public:
+    I2CScheduler() : backend(nullptr) { reset(); }
+
+    void setBackend(I2CBackend *b) { backend = b; }
+    I2CBackend *getBackend() { return backend; }
+
+    void reset() {
+        memset(pending, 0, sizeof(pending));
+        memset(count, 0, sizeof(count));
+        resetStats();
+    }
+
+    void resetStats() { memset(stats, 0, sizeof(stats)); }
+
+    bool push(I2CTransaction *t, uint64_t now) {
+        uint8_t prio = t->priority < I2C_PRIO_COUNT ? t->priority : (uint8_t)I2C_PRIO_LOW;
+        if (count[prio] >= I2C_QUEUE_DEPTH) {
+            t->result = I2C_RESULT_QUEUE_FULL;
+            return false;
+        }
+        t->result = I2C_RESULT_PENDING;
+        t->submit_us = now;
+        pending[prio][count[prio]++] = t;
+        return true;
+    }
+
+    // Rimuove una transazione non ancora avviata
+    bool cancel(I2CTransaction *t) {
+        for (uint8_t p = 0; p < I2C_PRIO_COUNT; p++) {
+            for (uint8_t i = 0; i < count[p]; i++) {
+                if (pending[p][i] == t) {
+                    removeAt(p, i);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool hasPending() const {
+        for (uint8_t p = 0; p < I2C_PRIO_COUNT; p++) {
+            if (count[p]) return true;
+        }
+        return false;
+    }
+
+    uint8_t pendingCount(uint8_t prio) const {
+        return prio < I2C_PRIO_COUNT ? count[prio] : 0;
+    }
+
+    // Estrae la prossima transazione (priorità più alta, poi deadline più
+    // vicina) più eventuali letture contigue sullo stesso dispositivo.
+    uint8_t pop(I2CTransaction **batch) {
+        for (uint8_t p = 0; p < I2C_PRIO_COUNT; p++) {
+            if (!count[p]) continue;
+
+            uint8_t best = 0;
+            for (uint8_t i = 1; i < count[p]; i++) {
+                if (earlier(pending[p][i], pending[p][best])) best = i;
+            }
+
+            I2CTransaction *head = pending[p][best];
+            removeAt(p, best);
+            batch[0] = head;
+            uint8_t n = 1;
+
+            if (head->op != I2C_OP_READ_REGS || (head->flags & I2C_FLAG_NO_BATCH)) {
+                return n;
+            }
+
+            // Fonde letture che proseguono il blocco di registri corrente
+            uint16_t nextReg = head->reg + head->len;
+            uint16_t total = head->len;
+            bool merged = true;
+            while (merged && n < I2C_BATCH_MAX) {
+                merged = false;
+                for (uint8_t i = 0; i < count[p]; i++) {
+                    I2CTransaction *t = pending[p][i];
+                    if (t->op == I2C_OP_READ_REGS && !(t->flags & I2C_FLAG_NO_BATCH) &&
+                        t->addr == head->addr && t->reg == nextReg &&
+                        total + t->len <= I2C_BATCH_MAX_BYTES) {
+                        batch[n++] = t;
+                        nextReg += t->len;
+                        total += t->len;
+                        removeAt(p, i);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+            return n;
+        }
+        return 0;
+    }
+
+    // Esegue un batch estratto da pop(): controlla deadline, trasferisce,
+    // aggiorna l'accounting e imposta outcome/complete_us. result resta
+    // PENDING finché il chiamante non chiama publish()/i2cPublishResult().
+    void execute(I2CTransaction **batch, uint8_t n) {
+        I2CBatchRun run;
+        if (!transfer(batch, n, run)) return;
+        account(batch, n, run);
+    }
+
+    // Prima metà di execute(): solo il bus e i buffer del chiamante, nessuno
+    // stato dello scheduler, quindi fuori dal lock. false = niente da fare.
+    bool transfer(I2CTransaction **batch, uint8_t n, I2CBatchRun &run) {
+        if (!n || !backend) return false;
+
+        I2CTransaction *head = batch[0];
+        run.start = backend->nowUs();
+        run.end = run.start;
+        run.bytes = 0;
+        run.ok = false;
+        run.missed = head->deadline_us && run.start > head->deadline_us;
+        if (run.missed) return true;
+
+        switch (head->op) {
+            case I2C_OP_READ_REGS:
+                if (n == 1) {
+                    run.ok = backend->readRegs(head->addr, head->reg, head->buf, head->len);
+                    run.bytes = head->len;
+                } else {
+                    uint8_t burst[I2C_BATCH_MAX_BYTES];
+                    for (uint8_t i = 0; i < n; i++) run.bytes += batch[i]->len;
+                    run.ok = backend->readRegs(head->addr, head->reg, burst, run.bytes);
+                    uint16_t offset = 0;
+                    for (uint8_t i = 0; i < n; i++) {
+                        memcpy(batch[i]->buf, burst + offset, batch[i]->len);
+                        offset += batch[i]->len;
+                    }
+                }
+                break;
+
+            case I2C_OP_WRITE_REGS:
+                run.ok = backend->writeRegs(head->addr, head->reg, head->buf, head->len);
+                run.bytes = head->len;
+                break;
+
+            case I2C_OP_JOB:
+                run.ok = backend->runJob(head->addr, head->job, head->ctx);
+                break;
+
+            case I2C_OP_BUS_RECOVER:
+                run.ok = backend->recoverBus();
+                break;
+        }
+
+        run.end = backend->nowUs();
+        return true;
+    }
+
+    // Seconda metà: statistiche ed esiti in outcome. Breve, va serializzata
+    // con getStats()/resetStats() (lock del chiamante).
+    void account(I2CTransaction **batch, uint8_t n, const I2CBatchRun &run) {
+        if (run.missed) {
+            for (uint8_t i = 0; i < n; i++) {
+                I2CDeviceStats &s = stats[deviceIndex(batch[i])];
+                s.deadline_misses++;
+                batch[i]->start_us = run.start;
+                batch[i]->complete_us = run.start;
+                batch[i]->outcome = I2C_RESULT_DEADLINE_MISSED;
+            }
+            return;
+        }
+
+        uint32_t busy = (uint32_t)(run.end - run.start);
+
+        for (uint8_t i = 0; i < n; i++) {
+            I2CTransaction *t = batch[i];
+            I2CDeviceStats &s = stats[deviceIndex(t)];
+            uint32_t wait = (uint32_t)(run.start - t->submit_us);
+
+            s.transactions++;
+            if (wait > s.max_wait_us) s.max_wait_us = wait;
+            if (i > 0) s.batched++;
+            if (!run.ok) s.errors++;
+
+            t->start_us = run.start;
+            t->complete_us = run.end;
+            t->outcome = run.ok ? I2C_RESULT_OK : I2C_RESULT_ERROR;
+        }
+
+        // Il tempo bus va al dispositivo che lo ha occupato
+        I2CDeviceStats &hs = stats[deviceIndex(batch[0])];
+        hs.busy_us += busy;
+        hs.bytes += run.bytes;
+        if (busy > hs.max_busy_us) hs.max_busy_us = busy;
+    }
+
+    // Completamento senza callback (driver su host): pubblica gli esiti
+    void publish(I2CTransaction **batch, uint8_t n) {
+        for (uint8_t i = 0; i < n; i++) i2cPublishResult(*batch[i], batch[i]->outcome);
+    }
+
+    const I2CDeviceStats &getStats(uint8_t device) const {
+        return stats[device < I2C_DEV_COUNT ? device : (uint8_t)I2C_DEV_OTHER];
+    }
+
+private:
+    I2CBackend *backend;
+    I2CTransaction *pending[I2C_PRIO_COUNT][I2C_QUEUE_DEPTH];
+    uint8_t count[I2C_PRIO_COUNT];
+    I2CDeviceStats stats[I2C_DEV_COUNT];
+
+    static uint8_t deviceIndex(const I2CTransaction *t) {
+        return t->device < I2C_DEV_COUNT ? t->device : (uint8_t)I2C_DEV_OTHER;
+    }
+
+    // Deadline più vicina prima; senza deadline in coda (FIFO fra pari)
+    static bool earlier(const I2CTransaction *a, const I2CTransaction *b) {
+        if (a->deadline_us == 0) return false;
+        if (b->deadline_us == 0) return true;
+        return a->deadline_us < b->deadline_us;
+    }
+
+    void removeAt(uint8_t prio, uint8_t index) {
+        for (uint8_t i = index; i + 1 < count[prio]; i++) {
+            pending[prio][i] = pending[prio][i + 1];
+        }
+        count[prio]--;
+    }
+};
+
+#endif // I2C_SCHEDULER_H
@@ -0,0 +1,174 @@
+// i2c_sim_backend.h
+// Backend I2C simulato: mappa registri per indirizzo e modello di latenza
+// su orologio virtuale. Serve a provare lo scheduling su host (o sul target
+// senza sensori collegati, con I2C_BUS_SIMULATOR definito).
+// Supporta l'iniezione di guasti (NACK, dispositivo assente, bus bloccato)
+// per provare il supervisore di recovery senza hardware difettoso.
+#ifndef I2C_SIM_BACKEND_H
+#define I2C_SIM_BACKEND_H
+
+#include "i2c_scheduler.h"
+
+#define I2C_SIM_MAX_DEVICES 4
+#define I2C_SIM_FAULT_FOREVER 0xFFFFFFFFu   // NACK finché non si chiama clearFaults()
+#define I2C_SIM_RECOVER_US    120           // 9 clock a ~100kHz + STOP
+
+class I2CSimBackend : public I2CBackend {
+public:
+    // Latenza tipica a 400kHz: ~25us/byte più overhead indirizzo/start
+    I2CSimBackend(uint32_t baseUs = 60, uint32_t perByteUs = 25)
+        : clockUs(0), baseLatencyUs(baseUs), byteLatencyUs(perByteUs),
+          jobLatencyUs(2000), numDevices(0), reads(0), writes(0),
+          busStuck(false), recoveries(0), injectedFailures(0) {
+        memset(devices, 0, sizeof(devices));
+    }
+
+    // === OROLOGIO VIRTUALE ===
+    uint64_t nowUs() override { return clockUs; }
+    void advance(uint64_t us) { clockUs += us; }
+    void setJobLatency(uint32_t us) { jobLatencyUs = us; }
+
+    // === MAPPA REGISTRI ===
+    bool addDevice(uint8_t addr) {
+        if (find(addr)) return true;
+        if (numDevices >= I2C_SIM_MAX_DEVICES) return false;
+        devices[numDevices].addr = addr;
+        devices[numDevices].present = true;
+        numDevices++;
+        return true;
+    }
+
+    void setRegister(uint8_t addr, uint8_t reg, uint8_t value) {
+        SimDevice *d = find(addr);
+        if (d) d->regs[reg] = value;
+    }
+
+    uint8_t getRegister(uint8_t addr, uint8_t reg) {
+        SimDevice *d = find(addr);
+        return d ? d->regs[reg] : 0;
+    }
+
+    // Maschera bit registro ignorati nell'auto-incremento (es. 0x80 LIS3MDL)
+    void setAddressMask(uint8_t addr, uint8_t mask) {
+        SimDevice *d = find(addr);
+        if (d) d->regMask = mask;
+    }
+
+    // === FAULT INJECTION ===
+    // Le prossime 'count' transazioni verso addr rispondono NACK
+    void injectNack(uint8_t addr, uint32_t count) {
+        SimDevice *d = find(addr);
+        if (d) d->nackCount = count;
+    }
+
+    // Dispositivo scollegato / in reset: NACK fino a setDevicePresent(true)
+    void setDevicePresent(uint8_t addr, bool present) {
+        SimDevice *d = find(addr);
+        if (d) d->present = present;
+    }
+
+    // Slave che tiene SDA bassa: ogni transazione fallisce fino a recoverBus()
+    void injectStuckBus() { busStuck = true; }
+
+    void clearFaults() {
+        busStuck = false;
+        for (uint8_t i = 0; i < numDevices; i++) {
+            devices[i].nackCount = 0;
+            devices[i].present = true;
+        }
+    }
+
+    bool isBusStuck() const { return busStuck; }
+
+    // === BACKEND ===
+    bool readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) override {
+        reads++;
+        clockUs += baseLatencyUs + (uint32_t)len * byteLatencyUs;
+        SimDevice *d = find(addr);
+        if (!respond(d)) return false;
+        uint8_t start = reg & ~d->regMask;
+        for (uint8_t i = 0; i < len; i++) {
+            buf[i] = d->regs[(uint8_t)(start + i)];
+        }
+        return true;
+    }
+
+    bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t *buf, uint8_t len) override {
+        writes++;
+        clockUs += baseLatencyUs + (uint32_t)len * byteLatencyUs;
+        SimDevice *d = find(addr);
+        if (!respond(d)) return false;
+        uint8_t start = reg & ~d->regMask;
+        for (uint8_t i = 0; i < len; i++) {
+            d->regs[(uint8_t)(start + i)] = buf[i];
+        }
+        return true;
+    }
+
+    bool runJob(uint8_t addr, I2CJobFn job, void *ctx) override {
+        clockUs += jobLatencyUs;
+        // Job senza indirizzo: conta solo lo stato del bus
+        if (busStuck) {
+            injectedFailures++;
+            return false;
+        }
+        if (addr && !respond(find(addr))) return false;
+        return job ? job(ctx) : false;
+    }
+
+    bool recoverBus() override {
+        clockUs += I2C_SIM_RECOVER_US;
+        recoveries++;
+        busStuck = false;
+        return true;
+    }
+
+    uint32_t getReadCount() const { return reads; }
+    uint32_t getWriteCount() const { return writes; }
+    uint32_t getRecoveryCount() const { return recoveries; }
+    uint32_t getInjectedFailures() const { return injectedFailures; }
+
+protected:
+    struct SimDevice {
+        uint8_t addr;
+        bool present;
+        uint8_t regMask;
+        uint32_t nackCount;
+        uint8_t regs[256];
+    };
+
+    uint64_t clockUs;
+    uint32_t baseLatencyUs;
+    uint32_t byteLatencyUs;
+    uint32_t jobLatencyUs;
+    SimDevice devices[I2C_SIM_MAX_DEVICES];
+    uint8_t numDevices;
+    uint32_t reads;
+    uint32_t writes;
+    bool busStuck;
+    uint32_t recoveries;
+    uint32_t injectedFailures;
+
+    // Esito della fase indirizzo con i guasti iniettati
+    bool respond(SimDevice *d) {
+        if (busStuck || !d || !d->present) {
+            injectedFailures += (busStuck || (d && !d->present)) ? 1 : 0;
+            return false;
+        }
+        if (d->nackCount) {
+            if (d->nackCount != I2C_SIM_FAULT_FOREVER) d->nackCount--;
+            injectedFailures++;
+            return false;
+        }
+        return true;
+    }
+
+    SimDevice *find(uint8_t addr) {
+        for (uint8_t i = 0; i < numDevices; i++) {
+            if (devices[i].addr == addr) return &devices[i];
+        }
+        return nullptr;
+    }
+};
+
+#endif // I2C_SIM_BACKEND_H
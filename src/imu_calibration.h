@@ -0,0 +1,258 @@
+// imu_calibration.h
+// Motori di calibrazione IMU, alimentati campione per campione dal task
+// sensori (nessun buffer, nessuna attesa a tempo fisso):
+//  - GyroBiasCalibrator: bias del giroscopio a dispositivo fermo. Il movimento
+//    azzera le statistiche; finisce appena l'incertezza della media scende
+//    sotto la soglia.
+//  - AccelSixPosCalibrator: offset e scala dell'accelerometro da sei
+//    orientamenti (±X, ±Y, ±Z verso l'alto). Ogni faccia viene acquisita da
+//    sola quando il dispositivo è fermo abbastanza a lungo.
+// Header puro C++ (running_stats.h), testato in tools/imu_cal_test.cpp.
+#ifndef IMU_CALIBRATION_H
+#define IMU_CALIBRATION_H
+
+#include <stdint.h>
+#include <math.h>
+#include "running_stats.h"
+
+#define IMU_CAL_GRAVITY           9.80665f
+
+// Giroscopio (dps, campioni a 10Hz)
+#define GYRO_CAL_MIN_SAMPLES      20        // Almeno 2 s fermi
+#define GYRO_CAL_MAX_SAMPLES      300       // 30 s senza convergenza = fallita
+#define GYRO_CAL_TARGET_SE_DPS    0.01f     // Incertezza della media richiesta
+#define GYRO_CAL_MOTION_DPS       1.0f      // Scarto che indica movimento
+#define GYRO_CAL_MOTION_MS2       0.5f      // Idem sull'accelerometro
+#define GYRO_CAL_MAX_BIAS_DPS     10.0f     // Oltre: sensore guasto o non fermo
+
+// Accelerometro (m/s²)
+#define ACCEL_CAL_MIN_SAMPLES     15
+#define ACCEL_CAL_MAX_SAMPLES     1800      // 3 minuti per girare le sei facce
+#define ACCEL_CAL_TARGET_SE_MS2   0.01f     // ~1 mg
+#define ACCEL_CAL_MOTION_MS2      0.3f
+#define ACCEL_CAL_FACE_MIN        0.8f      // Asse dominante: almeno 0.8 g...
+#define ACCEL_CAL_FACE_MAX_OFF    0.25f     // ...e gli altri sotto 0.25 g (~14°)
+#define ACCEL_CAL_MAX_OFFSET_MS2  2.0f
+#define ACCEL_CAL_MIN_SCALE       0.9f
+#define ACCEL_CAL_MAX_SCALE       1.1f
+
+#define ACCEL_CAL_FACES           6
+#define ACCEL_CAL_ALL_FACES       0x3F
+
+enum IMUCalState : uint8_t {
+    IMU_CAL_IDLE = 0,
+    IMU_CAL_RUNNING,
+    IMU_CAL_DONE,
+    IMU_CAL_FAILED
+};
+
+// Faccia = asse verso l'alto: indice asse * 2 + (negativo ? 1 : 0)
+inline const char *accelFaceName(int face) {
+    static const char *names[ACCEL_CAL_FACES] = {"+X", "-X", "+Y", "-Y", "+Z", "-Z"};
+    return (face >= 0 && face < ACCEL_CAL_FACES) ? names[face] : "--";
+}
+
+// -1 se il dispositivo non è appoggiato su una faccia
+inline int accelClassifyFace(const float a[3]) {
+    int axis = 0;
+    for (int i = 1; i < 3; i++) {
+        if (fabsf(a[i]) > fabsf(a[axis])) axis = i;
+    }
+    if (fabsf(a[axis]) < ACCEL_CAL_FACE_MIN * IMU_CAL_GRAVITY) return -1;
+    for (int i = 0; i < 3; i++) {
+        if (i != axis && fabsf(a[i]) > ACCEL_CAL_FACE_MAX_OFF * IMU_CAL_GRAVITY) return -1;
+    }
+    return axis * 2 + (a[axis] < 0 ? 1 : 0);
+}
+
+// Progresso di una media verso la convergenza (0..1)
+inline float calConvergence(const RunningStats3 &s, uint32_t minSamples, float targetSE) {
+    float bySamples = s.count() / (float)minSamples;
+    float se = s.maxStdError();
+    float byError = se > 0 ? targetSE / se : 1.0f;
+    float p = bySamples < byError ? bySamples : byError;
+    return p > 1.0f ? 1.0f : p;
+}
+
+// === GIROSCOPIO ===
+class GyroBiasCalibrator {
+public:
+    GyroBiasCalibrator() { reset(); }
+
+    void reset() {
+        state = IMU_CAL_IDLE;
+        gyroStats.reset();
+        accelStats.reset();
+        total = 0;
+        restarts = 0;
+        for (int i = 0; i < 3; i++) biasDps[i] = 0;
+    }
+
+    void start() {
+        reset();
+        state = IMU_CAL_RUNNING;
+    }
+
+    IMUCalState add(const float gyroDps[3], const float accelMs2[3]) {
+        if (state != IMU_CAL_RUNNING) return state;
+        total++;
+
+        // Movimento: la media accumulata non rappresenta più il bias
+        if (gyroStats.count() >= 3 &&
+            (gyroStats.maxDeviation(gyroDps) > GYRO_CAL_MOTION_DPS ||
+             accelStats.maxDeviation(accelMs2) > GYRO_CAL_MOTION_MS2)) {
+            gyroStats.reset();
+            accelStats.reset();
+            restarts++;
+        }
+        gyroStats.add(gyroDps);
+        accelStats.add(accelMs2);
+
+        if (gyroStats.count() >= GYRO_CAL_MIN_SAMPLES &&
+            gyroStats.maxStdError() <= GYRO_CAL_TARGET_SE_DPS) {
+            gyroStats.mean(biasDps);
+            state = IMU_CAL_DONE;
+            for (int i = 0; i < 3; i++) {
+                if (fabsf(biasDps[i]) > GYRO_CAL_MAX_BIAS_DPS) state = IMU_CAL_FAILED;
+            }
+        } else if (total >= GYRO_CAL_MAX_SAMPLES) {
+            state = IMU_CAL_FAILED;
+        }
+        return state;
+    }
+
+    IMUCalState getState() const { return state; }
+    bool isStill() const { return gyroStats.count() >= 3; }
+    uint32_t getRestarts() const { return restarts; }
+    float noiseDps() const { return gyroStats.maxStddev(); }
+
+    float progress() const {
+        if (state == IMU_CAL_DONE) return 1.0f;
+        float p = calConvergence(gyroStats, GYRO_CAL_MIN_SAMPLES, GYRO_CAL_TARGET_SE_DPS);
+        return p < 0.99f ? p : 0.99f;
+    }
+
+    void getBias(float out[3]) const {
+        for (int i = 0; i < 3; i++) out[i] = biasDps[i];
+    }
+
+private:
+    IMUCalState state;
+    RunningStats3 gyroStats;
+    RunningStats3 accelStats;
+    uint32_t total;
+    uint32_t restarts;
+    float biasDps[3];
+};
+
+// === ACCELEROMETRO A SEI POSIZIONI ===
+// Modello per asse: misura = scala * vero + offset. Con l'asse rivolto in
+// alto e in basso (±g): offset = (p + m) / 2, scala = (p - m) / 2g.
+class AccelSixPosCalibrator {
+public:
+    AccelSixPosCalibrator() { reset(); }
+
+    void reset() {
+        state = IMU_CAL_IDLE;
+        stats.reset();
+        face = -1;
+        faces = 0;
+        total = 0;
+        for (int i = 0; i < ACCEL_CAL_FACES; i++) faceMean[i] = 0;
+        for (int i = 0; i < 3; i++) {
+            offset[i] = 0;
+            scale[i] = 1.0f;
+        }
+    }
+
+    void start() {
+        reset();
+        state = IMU_CAL_RUNNING;
+    }
+
+    IMUCalState add(const float a[3]) {
+        if (state != IMU_CAL_RUNNING) return state;
+        total++;
+
+        int f = accelClassifyFace(a);
+        bool moved = stats.count() >= 3 && stats.maxDeviation(a) > ACCEL_CAL_MOTION_MS2;
+        if (f != face || moved) {
+            stats.reset();
+            face = f;
+        }
+
+        if (face >= 0 && !(faces & (1u << face))) {
+            stats.add(a);
+            if (stats.count() >= ACCEL_CAL_MIN_SAMPLES &&
+                stats.maxStdError() <= ACCEL_CAL_TARGET_SE_MS2) {
+                faceMean[face] = (float)stats.axis[face / 2].mean;
+                faces |= 1u << face;
+                stats.reset();
+                if (faces == ACCEL_CAL_ALL_FACES) solve();
+            }
+        }
+
+        if (state == IMU_CAL_RUNNING && total >= ACCEL_CAL_MAX_SAMPLES) state = IMU_CAL_FAILED;
+        return state;
+    }
+
+    IMUCalState getState() const { return state; }
+    uint8_t getFaces() const { return faces; }
+    int getCurrentFace() const { return face; }
+    bool isFaceDone(int f) const { return f >= 0 && (faces & (1u << f)); }
+
+    float progress() const {
+        if (state == IMU_CAL_DONE) return 1.0f;
+        int done = 0;
+        for (int i = 0; i < ACCEL_CAL_FACES; i++) {
+            if (faces & (1u << i)) done++;
+        }
+        float partial = 0;
+        if (face >= 0 && !isFaceDone(face)) {
+            partial = calConvergence(stats, ACCEL_CAL_MIN_SAMPLES, ACCEL_CAL_TARGET_SE_MS2);
+        }
+        float p = (done + partial) / ACCEL_CAL_FACES;
+        return p < 0.99f ? p : 0.99f;
+    }
+
+    void getResult(float off[3], float sc[3]) const {
+        for (int i = 0; i < 3; i++) {
+            off[i] = offset[i];
+            sc[i] = scale[i];
+        }
+    }
+
+private:
+    void solve() {
+        state = IMU_CAL_DONE;
+        for (int i = 0; i < 3; i++) {
+            float p = faceMean[i * 2], m = faceMean[i * 2 + 1];
+            offset[i] = (p + m) * 0.5f;
+            scale[i] = (p - m) / (2.0f * IMU_CAL_GRAVITY);
+            if (fabsf(offset[i]) > ACCEL_CAL_MAX_OFFSET_MS2 ||
+                !(scale[i] >= ACCEL_CAL_MIN_SCALE && scale[i] <= ACCEL_CAL_MAX_SCALE)) {
+                state = IMU_CAL_FAILED;
+            }
+        }
+    }
+
+    IMUCalState state;
+    RunningStats3 stats;        // Faccia corrente, azzerate a ogni movimento
+    int face;
+    uint8_t faces;              // Bitmask delle facce acquisite
+    uint32_t total;
+    float faceMean[ACCEL_CAL_FACES];  // Lettura dell'asse verticale per faccia
+    float offset[3];
+    float scale[3];
+};
+
+// === APPLICAZIONE ===
+inline void imuCalApplyAccel(float a[3], const float offset[3], const float scale[3]) {
+    for (int i = 0; i < 3; i++) a[i] = (a[i] - offset[i]) / scale[i];
+}
+
+inline void imuCalApplyGyro(float g[3], const float bias[3]) {
+    for (int i = 0; i < 3; i++) g[i] -= bias[i];
+}
+
+#endif // IMU_CALIBRATION_H
@@ -1,7 +1,9 @@
 // imu_handler.cpp
 #include "imu_handler.h"
 #include <Wire.h>
-#include <EEPROM.h>
+#include "config_store.h"
+#include "sensor_tasks.h"     // printIMUDebug: ultimo campione pubblicato
+#include "power_manager.h"    // UI_EVENT_MAG_CAL
 #include <Adafruit_LSM6DSOX.h>
 #include <Adafruit_LIS3MDL.h>
 #include <Adafruit_Sensor.h>
@@ -10,11 +12,21 @@
 static Adafruit_LSM6DSOX lsm6ds;
 static Adafruit_LIS3MDL lis3mdl;
 
-// Variabili calibrazione
+// Variabili calibrazione: m = W (raw - offset), vedi mag_calibration.h
 static float magOffset[3] = {0, 0, 0};
-static float magScale[3] = {1, 1, 1};
-static float minVal[3] = {10000, 10000, 10000};
-static float maxVal[3] = {-10000, -10000, -10000};
+static float magSoftIron[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+static EllipsoidFit magFit;         // Solo del task sensori: accumulo e fit
+static MagFitResult lastFit = {};
+static portMUX_TYPE magLock = portMUX_INITIALIZER_UNLOCKED;  // Parametri + stato calibrazione
+
+// Calibrazione giroscopio/accelerometro: a = (raw - offset) / scala, g = raw - bias
+static float gyroBias[3] = {0, 0, 0};
+static float accelOffset[3] = {0, 0, 0};
+static float accelScale[3] = {1, 1, 1};
+static GyroBiasCalibrator gyroCal;
+static AccelSixPosCalibrator accelCal;
+static IMUCalMode calMode = IMU_CAL_MODE_NONE;
+static portMUX_TYPE imuCalLock = portMUX_INITIALIZER_UNLOCKED;  // calibratori + parametri
 
 // Variabili filtrate (GLOBALI per mantenere stato)
 static float smoothPitch = 0;
@@ -37,13 +49,21 @@ static bool imuReady = false;
 static bool calibrated = false;
 static bool firstRun = true;
 
-// Variabili calibrazione
-static bool calibrationInProgress = false;
+// Variabili calibrazione: la UI chiede avvio/fine, il task sensori esegue
+static volatile bool calibrationInProgress = false;
+static bool magResetRequested = false;
+static bool magFinishRequested = false;
 static float calibrationProgress = 0.0f;
+static float magCoverage = 0.0f;        // Pubblicati dal task sensori per la UI
 static uint32_t calibrationStartTime = 0;
 
+#define MAG_CAL_TARGET_COVERAGE  0.85f   // Fine anticipata quando le direzioni bastano
+#define MAG_CAL_TIMEOUT_MS       20000
+
 // === INIZIALIZZAZIONE ===
 bool initIMU() {
+    imuReady = false;
+    
     // Inizializza I2C su pin standard
     if (!lsm6ds.begin_I2C(IMU_I2C_ADDR_6DOF)) {
         Serial.println("❌ LSM6DSOX non trovato");
@@ -69,35 +89,64 @@ bool initIMU() {
     Serial.println("✅ IMU inizializzata");
     
     // Carica calibrazione se presente
-    calibrated = loadCalibrationFromEEPROM();
+    calibrated = loadCalibrationFromConfig();
     imuReady = true;
     firstRun = true;
     
     return true;
 }
 
-// === NUOVA FUNZIONE PRINCIPALE PER FREERTOS ===
-IMUData getIMUData() {
+static void saveIMUCalibrationToConfig(IMUCalMode mode);
+static void serviceMagCalibration(const float rawMag[3]);
+
+// === CALIBRAZIONE GYRO/ACCEL ===
+// Solo dal task sensori: i calibratori vedono i valori grezzi,
+// poi si applicano i parametri correnti
+static void applyIMUCalibration(float accel[3], float gyro[3]) {
+    IMUCalMode finished = IMU_CAL_MODE_NONE;
+    float bias[3], offset[3], scale[3];
+    
+    taskENTER_CRITICAL(&imuCalLock);
+    if (calMode == IMU_CAL_MODE_GYRO && gyroCal.getState() == IMU_CAL_RUNNING) {
+        if (gyroCal.add(gyro, accel) == IMU_CAL_DONE) {
+            gyroCal.getBias(gyroBias);
+            finished = IMU_CAL_MODE_GYRO;
+        }
+    } else if (calMode == IMU_CAL_MODE_ACCEL && accelCal.getState() == IMU_CAL_RUNNING) {
+        if (accelCal.add(accel) == IMU_CAL_DONE) {
+            accelCal.getResult(accelOffset, accelScale);
+            finished = IMU_CAL_MODE_ACCEL;
+        }
+    }
+    memcpy(bias, gyroBias, sizeof(bias));
+    memcpy(offset, accelOffset, sizeof(offset));
+    memcpy(scale, accelScale, sizeof(scale));
+    taskEXIT_CRITICAL(&imuCalLock);
+    
+    // Una volta per calibrazione: copia in config, la flash la scrive il task config
+    if (finished != IMU_CAL_MODE_NONE) saveIMUCalibrationToConfig(finished);
+    
+    imuCalApplyAccel(accel, offset, scale);
+    imuCalApplyGyro(gyro, bias);
+}
+
+// === CALCOLO ANGOLI E FILTRI (comune a lettura driver e raw) ===
+// Accelerazione in m/s², campo magnetico in uT (stesse unità dei driver Adafruit)
+static IMUData computeIMUData(float ax, float ay, float az, const float rawMag[3]) {
     IMUData data;
-    data.timestamp = millis();
+    data.timestamp_us = timebaseNowUs();
+    data.timestamp = usToMs(data.timestamp_us);
     
-    if (!imuReady) {
-        data.valid = false;
-        data.pitch = 0.0f;
-        data.yaw = 0.0f;
-        data.roll = 0.0f;
-        return data;
-    }
+    // Campioni per la calibrazione magnetometro raccolti nel flusso normale
+    serviceMagCalibration(rawMag);
     
-    // Leggi tutti i sensori una volta sola
-    sensors_event_t accel, gyro, temp, mag;
-    lsm6ds.getEvent(&accel, &gyro, &temp);
-    lis3mdl.getEvent(&mag);
+    float offset[3], softIron[9];
+    taskENTER_CRITICAL(&magLock);
+    memcpy(offset, magOffset, sizeof(offset));
+    memcpy(softIron, magSoftIron, sizeof(softIron));
+    taskEXIT_CRITICAL(&magLock);
     
     // === CALCOLO PITCH & ROLL ===
-    float ax = accel.acceleration.x;
-    float ay = accel.acceleration.y;
-    float az = accel.acceleration.z;
     
     currentPitch = atan2(-ax, sqrt(ay * ay + az * az)) * 180.0 / PI;
     currentRoll = atan2(ay, az) * 180.0 / PI;
@@ -107,11 +156,8 @@ IMUData getIMUData() {
     float rollRad = currentRoll * DEG_TO_RAD;
     
     // Applica calibrazione magnetometro
-    float rawMag[3] = {mag.magnetic.x, mag.magnetic.y, mag.magnetic.z};
     float calibratedMag[3];
-    for (int i = 0; i < 3; i++) {
-        calibratedMag[i] = (rawMag[i] - magOffset[i]) / magScale[i];
-    }
+    magApplyCalibration(rawMag, offset, softIron, calibratedMag);
     
     // Compensazione tilt
     float mx = calibratedMag[0];
@@ -184,42 +230,46 @@ IMUData getIMUData() {
     return data;
 }
 
-// === FUNZIONI COMPATIBILITÀ (ora usano i valori già calcolati) ===
-float getIMUPitch() {
-    if (!imuReady) return 0;
-    
-    // Se non abbiamo aggiornato di recente, forza un aggiornamento
-    static uint32_t lastUpdate = 0;
-    if (millis() - lastUpdate > 100) {
-        getIMUData();
-        lastUpdate = millis();
-    }
-    
-    return smoothPitch;
+// === LETTURA RAW (bus manager) ===
+static inline int16_t rawToInt16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
 }
 
-float getIMURoll() {
-    if (!imuReady) return 0;
-    
-    static uint32_t lastUpdate = 0;
-    if (millis() - lastUpdate > 100) {
-        getIMUData();
-        lastUpdate = millis();
-    }
-    
-    return smoothRoll;
+void prepareIMURawReads(IMURawSample &raw, I2CTransaction &gyroTx,
+                        I2CTransaction &accelTx, I2CTransaction &magTx) {
+    // Giroscopio e accelerometro sono contigui: lo scheduler li fonde in un burst
+    i2cPrepareRead(gyroTx, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_I2C_ADDR_6DOF,
+                   LSM6DSOX_REG_OUTX_L_G, raw.gyro, sizeof(raw.gyro));
+    i2cPrepareRead(accelTx, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_I2C_ADDR_6DOF,
+                   LSM6DSOX_REG_OUTX_L_A, raw.accel, sizeof(raw.accel));
+    i2cPrepareRead(magTx, I2C_DEV_MAG, I2C_PRIO_HIGH, IMU_I2C_ADDR_MAG,
+                   LIS3MDL_REG_OUT_X_L | LIS3MDL_AUTO_INCREMENT, raw.mag, sizeof(raw.mag));
 }
 
-float getIMUYaw() {
-    if (!imuReady) return 0;
+IMUData processIMURaw(const IMURawSample &raw) {
+    if (!imuReady) {
+        IMUData data;
+        data.timestamp_us = timebaseNowUs();
+        data.timestamp = usToMs(data.timestamp_us);
+        data.valid = false;
+        data.pitch = 0.0f;
+        data.yaw = 0.0f;
+        data.roll = 0.0f;
+        memset(data.gyro_dps, 0, sizeof(data.gyro_dps));
+        return data;
+    }
     
-    static uint32_t lastUpdate = 0;
-    if (millis() - lastUpdate > 100) {
-        getIMUData();
-        lastUpdate = millis();
+    float a[3], g[3], rawMag[3];
+    for (int i = 0; i < 3; i++) {
+        a[i] = rawToInt16(&raw.accel[i * 2]) * LSM6DSOX_ACCEL_MS2_PER_LSB;
+        g[i] = rawToInt16(&raw.gyro[i * 2]) * LSM6DSOX_GYRO_DPS_PER_LSB;
+        rawMag[i] = rawToInt16(&raw.mag[i * 2]) * LIS3MDL_UT_PER_LSB;
     }
+    applyIMUCalibration(a, g);
     
-    return smoothYaw;
+    IMUData data = computeIMUData(a[0], a[1], a[2], rawMag);
+    memcpy(data.gyro_dps, g, sizeof(data.gyro_dps));
+    return data;
 }
 
 // === FUNZIONI STATO ===
@@ -227,37 +277,117 @@ bool isIMUReady() {
     return imuReady;
 }
 
+void markIMUFault() {
+    imuReady = false;
+}
+
 bool isIMUCalibrated() {
     return calibrated;
 }
 
 // === CALIBRAZIONE MAGNETOMETRO ===
+// magFit è del task sensori: accumulo (O(1)) e fit senza lock. La UI
+// passa solo richieste e legge copertura/esito pubblicati sotto magLock.
 void startMagCalibration() {
     Serial.println("🧲 Inizia calibrazione magnetometro...");
-    calibrationInProgress = true;
-    calibrationProgress = 0.0f;
+    lastFit = MagFitResult();       // Esito di questa calibrazione (il task sensori lo scrive solo a fine fit)
+    taskENTER_CRITICAL(&magLock);
+    magResetRequested = true;
+    magFinishRequested = false;
+    magCoverage = 0.0f;
     calibrationStartTime = millis();
-    
-    for (int i = 0; i < 3; i++) {
-        minVal[i] = 10000;
-        maxVal[i] = -10000;
-    }
+    calibrationProgress = 0.0f;
+    calibrationInProgress = true;
+    taskEXIT_CRITICAL(&magLock);
 }
 
-void finishMagCalibration() {
-    if (!calibrationInProgress) return;
-    
-    for (int i = 0; i < 3; i++) {
-        magOffset[i] = (maxVal[i] + minVal[i]) / 2.0;
-        magScale[i] = (maxVal[i] - minVal[i]) / 2.0;
+// Fit (~1 ms in double) e applicazione dei parametri, dal task sensori
+static bool completeMagCalibration() {
+    MagFitResult fit;
+    bool ok = magFit.solve(fit);
+    lastFit = fit;
+    
+    if (!ok) {
+        // Copertura insufficiente o fit degenere: resta la calibrazione precedente
+        Serial.printf("❌ Calibrazione rifiutata (%lu campioni, copertura %.0f%%)\n",
+                      (unsigned long)fit.samples, fit.coverage * 100.0f);
+        return false;
     }
     
-    saveCalibrationToEEPROM();
+    taskENTER_CRITICAL(&magLock);
+    memcpy(magOffset, fit.offset, sizeof(magOffset));
+    memcpy(magSoftIron, fit.soft_iron, sizeof(magSoftIron));
+    taskEXIT_CRITICAL(&magLock);
+    
+    // Copia in config, la flash la scrive il task config
+    saveCalibrationToConfig();
     calibrated = true;
+    
+    Serial.printf("✅ Calibrazione completata: campo %.1f uT, residuo %.2f uT, "
+                  "copertura %.0f%%, %lu campioni (%lu scartati)\n",
+                  fit.field_ut, fit.residual_ut, fit.coverage * 100.0f,
+                  (unsigned long)fit.samples, (unsigned long)fit.rejected);
+    return true;
+}
+
+static void serviceMagCalibration(const float rawMag[3]) {
+    bool reset, finish;
+    uint32_t startTime;
+    taskENTER_CRITICAL(&magLock);
+    if (!calibrationInProgress) {
+        taskEXIT_CRITICAL(&magLock);
+        return;
+    }
+    reset = magResetRequested;
+    finish = magFinishRequested;
+    magResetRequested = false;
+    startTime = calibrationStartTime;
+    taskEXIT_CRITICAL(&magLock);
+    
+    if (reset) magFit.reset();
+    magFit.add(rawMag[0], rawMag[1], rawMag[2]);
+    float coverage = magFit.coverage();
+    
+    // Auto-complete a copertura raggiunta o dopo 20 secondi; prima se lo chiede la UI
+    bool done = finish ||
+                (coverage >= MAG_CAL_TARGET_COVERAGE && magFit.samples() >= MAG_FIT_MIN_SAMPLES) ||
+                millis() - startTime >= MAG_CAL_TIMEOUT_MS;
+    if (done) completeMagCalibration();
+    
+    taskENTER_CRITICAL(&magLock);
+    magCoverage = coverage;
+    if (done) {
+        magFinishRequested = false;
+        calibrationProgress = 1.0f;
+        calibrationInProgress = false;
+    }
+    taskEXIT_CRITICAL(&magLock);
+    if (done) notifyUIEvent(UI_EVENT_MAG_CAL);
+}
+
+void finishMagCalibration() {
+    // Il fit lo chiude il task sensori al prossimo campione IMU
+    taskENTER_CRITICAL(&magLock);
+    if (calibrationInProgress) magFinishRequested = true;
+    taskEXIT_CRITICAL(&magLock);
+}
+
+void abortMagCalibration() {
+    taskENTER_CRITICAL(&magLock);
+    bool running = calibrationInProgress;
     calibrationInProgress = false;
+    magFinishRequested = false;
     calibrationProgress = 1.0f;
+    taskEXIT_CRITICAL(&magLock);
+    if (!running) return;
     
-    Serial.println("✅ Calibrazione completata");
+    Serial.println("❌ Calibrazione annullata: nessun campione IMU");
+    notifyUIEvent(UI_EVENT_MAG_CAL);
+}
+
+bool getMagCalibrationResult(MagFitResult &result) {
+    result = lastFit;
+    return lastFit.ok;
 }
 
 bool isMagCalibrationInProgress() {
@@ -265,53 +395,156 @@ bool isMagCalibrationInProgress() {
 }
 
 float getMagCalibrationProgress() {
-    if (!calibrationInProgress) return calibrationProgress;
-    
-    // Aggiorna progresso basato sul tempo (20 secondi)
+    // Progresso = direzioni coperte, pubblicate dal task sensori
+    // (serviceMagCalibration), così la UI non tocca né bus né fit.
+    taskENTER_CRITICAL(&magLock);
+    bool running = calibrationInProgress;
+    float coverage = magCoverage;
     uint32_t elapsed = millis() - calibrationStartTime;
-    calibrationProgress = min(1.0f, elapsed / 20000.0f);
+    taskEXIT_CRITICAL(&magLock);
     
-    // Durante la calibrazione, continua a leggere il magnetometro
-    if (elapsed < 20000) {
-        sensors_event_t mag;
-        lis3mdl.getEvent(&mag);
-        
-        float raw[3] = {mag.magnetic.x, mag.magnetic.y, mag.magnetic.z};
-        for (int i = 0; i < 3; i++) {
-            minVal[i] = min(minVal[i], raw[i]);
-            maxVal[i] = max(maxVal[i], raw[i]);
-        }
-    } else {
-        // Auto-complete dopo 20 secondi
-        finishMagCalibration();
+    if (!running) return calibrationProgress;
+    
+    // Task sensori fermo oltre il timeout (il fit sarebbe già partito):
+    // chiude senza attendere altri campioni
+    if (elapsed >= MAG_CAL_TIMEOUT_MS + MAG_CAL_FINISH_WAIT_MS) {
+        abortMagCalibration();
+        return calibrationProgress;
     }
     
-    return calibrationProgress;
+    return min(0.99f, coverage / MAG_CAL_TARGET_COVERAGE);
 }
 
-// === EEPROM ===
-bool loadCalibrationFromEEPROM() {
-    EEPROM.begin(64);
-    if (EEPROM.read(48) != 1) return false;
-    
-    for (int i = 0; i < 3; i++) {
-        magOffset[i] = EEPROM.readFloat(i * 4);
-        magScale[i] = EEPROM.readFloat((i + 3) * 4);
+// === CALIBRAZIONE GIROSCOPIO / ACCELEROMETRO ===
+bool startIMUCalibration(IMUCalMode mode) {
+    if (!imuReady || mode == IMU_CAL_MODE_NONE) return false;
+    
+    taskENTER_CRITICAL(&imuCalLock);
+    calMode = mode;
+    if (mode == IMU_CAL_MODE_GYRO) gyroCal.start();
+    else accelCal.start();
+    taskEXIT_CRITICAL(&imuCalLock);
+    
+    Serial.println(mode == IMU_CAL_MODE_GYRO ? "🔧 Calibrazione giroscopio: tenere fermo"
+                                             : "🔧 Calibrazione accelerometro: sei facce");
+    return true;
+}
+
+void cancelIMUCalibration() {
+    taskENTER_CRITICAL(&imuCalLock);
+    if (calMode == IMU_CAL_MODE_GYRO) gyroCal.reset();
+    else if (calMode == IMU_CAL_MODE_ACCEL) accelCal.reset();
+    taskEXIT_CRITICAL(&imuCalLock);
+}
+
+void getIMUCalibrationStatus(IMUCalStatus &status) {
+    taskENTER_CRITICAL(&imuCalLock);
+    status.mode = calMode;
+    if (calMode == IMU_CAL_MODE_ACCEL) {
+        status.state = accelCal.getState();
+        status.progress = accelCal.progress();
+        status.still = false;
+        status.face = (int8_t)accelCal.getCurrentFace();
+        status.faces_done = accelCal.getFaces();
+    } else {
+        status.state = calMode == IMU_CAL_MODE_GYRO ? gyroCal.getState() : IMU_CAL_IDLE;
+        status.progress = gyroCal.progress();
+        status.still = gyroCal.isStill();
+        status.face = -1;
+        status.faces_done = 0;
+    }
+    memcpy(status.gyro_bias_dps, gyroBias, sizeof(status.gyro_bias_dps));
+    memcpy(status.accel_offset, accelOffset, sizeof(status.accel_offset));
+    memcpy(status.accel_scale, accelScale, sizeof(status.accel_scale));
+    taskEXIT_CRITICAL(&imuCalLock);
+}
+
+void applyAccelCalibration(float accel[3]) {
+    float offset[3], scale[3];
+    taskENTER_CRITICAL(&imuCalLock);
+    memcpy(offset, accelOffset, sizeof(offset));
+    memcpy(scale, accelScale, sizeof(scale));
+    taskEXIT_CRITICAL(&imuCalLock);
+    imuCalApplyAccel(accel, offset, scale);
+}
+
+// Solo i campi della calibrazione appena conclusa, sotto il lock dello store
+static void storeIMUCalibration(DeviceConfig &config, void *ctx) {
+    IMUCalMode mode = *(IMUCalMode *)ctx;
+    taskENTER_CRITICAL(&imuCalLock);
+    if (mode == IMU_CAL_MODE_GYRO) {
+        memcpy(config.gyro_bias_dps, gyroBias, sizeof(gyroBias));
+        config.gyro_calibrated = 1;
+    } else {
+        memcpy(config.accel_offset, accelOffset, sizeof(accelOffset));
+        memcpy(config.accel_scale, accelScale, sizeof(accelScale));
+        config.accel_calibrated = 1;
     }
+    taskEXIT_CRITICAL(&imuCalLock);
+}
+
+static void saveIMUCalibrationToConfig(IMUCalMode mode) {
+    updateConfig(storeIMUCalibration, &mode);
+    
+    float bias[3], offset[3], scale[3];
+    taskENTER_CRITICAL(&imuCalLock);
+    memcpy(bias, gyroBias, sizeof(bias));
+    memcpy(offset, accelOffset, sizeof(offset));
+    memcpy(scale, accelScale, sizeof(scale));
+    taskEXIT_CRITICAL(&imuCalLock);
+    
+    if (mode == IMU_CAL_MODE_GYRO) {
+        Serial.printf("✅ Bias giroscopio %.3f %.3f %.3f dps\n", bias[0], bias[1], bias[2]);
+    } else {
+        Serial.printf("✅ Accelerometro offset %.3f %.3f %.3f scala %.4f %.4f %.4f\n",
+                 offset[0], offset[1], offset[2], scale[0], scale[1], scale[2]);
+    }
+}
+
+// === PERSISTENZA (config_store) ===
+// Carica tutte le calibrazioni IMU; ritorna lo stato del magnetometro
+bool loadCalibrationFromConfig() {
+    DeviceConfig config;
+    getConfig(config);
+    
+    taskENTER_CRITICAL(&imuCalLock);
+    if (config.gyro_calibrated) memcpy(gyroBias, config.gyro_bias_dps, sizeof(gyroBias));
+    if (config.accel_calibrated) {
+        memcpy(accelOffset, config.accel_offset, sizeof(accelOffset));
+        memcpy(accelScale, config.accel_scale, sizeof(accelScale));
+    }
+    taskEXIT_CRITICAL(&imuCalLock);
+    
+    if (!config.mag_calibrated) return false;
+    
+    taskENTER_CRITICAL(&magLock);
+    memcpy(magOffset, config.mag_offset, sizeof(magOffset));
+    memcpy(magSoftIron, config.mag_soft_iron, sizeof(magSoftIron));
+    taskEXIT_CRITICAL(&magLock);
     
-    Serial.println("✅ Calibrazione caricata da EEPROM");
+    Serial.println("✅ Calibrazione caricata dalla configurazione");
     return true;
 }
 
-void saveCalibrationToEEPROM() {
-    EEPROM.begin(64);
+static void storeMagCalibration(DeviceConfig &config, void *) {
+    taskENTER_CRITICAL(&magLock);
+    memcpy(config.mag_offset, magOffset, sizeof(magOffset));
+    memcpy(config.mag_soft_iron, magSoftIron, sizeof(magSoftIron));
+    taskEXIT_CRITICAL(&magLock);
     for (int i = 0; i < 3; i++) {
-        EEPROM.writeFloat(i * 4, magOffset[i]);
-        EEPROM.writeFloat((i + 3) * 4, magScale[i]);
+        // Campo v1 per firmware precedenti: solo la diagonale
+        float w = config.mag_soft_iron[i * 4];
+        config.mag_scale[i] = w != 0 ? 1.0f / w : 1.0f;
     }
-    EEPROM.write(48, 1);
-    EEPROM.commit();
-    Serial.println("✅ Calibrazione salvata in EEPROM");
+    config.mag_field_ut = lastFit.field_ut;
+    config.mag_residual_ut = lastFit.residual_ut;
+    config.mag_coverage = lastFit.coverage;
+    config.mag_calibrated = 1;
+}
+
+void saveCalibrationToConfig() {
+    updateConfig(storeMagCalibration);  // La scrittura flash avviene nel task config
+    Serial.println("✅ Calibrazione salvata");
 }
 
 // === CONFIGURAZIONE ===
@@ -326,10 +559,12 @@ void getDeadZones(float &pitchDZ, float &yawDZ) {
 }
 
 // === DEBUG ===
+// Ultimo campione pubblicato dal task sensori: mai letture dirette sul bus
 void printIMUDebug() {
-    IMUData data = getIMUData();
+    SensorData data;
+    bool have = getLatestSensorData(data);
     Serial.printf("IMU Debug - P:%.1f Y:%.1f R:%.1f Valid:%d\n", 
-        data.pitch, data.yaw, data.roll, data.valid);
+        data.pitch_deg, data.yaw_deg, data.roll_deg, have && data.imu_valid);
 }
 
 void resetIMUFilters() {
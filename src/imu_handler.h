@@ -3,44 +3,84 @@
 #define IMU_HANDLER_H
 
 #include <Arduino.h>
+#include "i2c_scheduler.h"
+#include "timebase.h"
+#include "mag_calibration.h"
+#include "imu_calibration.h"
 
 // === STRUTTURA DATI IMU ===
 struct IMUData {
     float pitch;
     float yaw;
     float roll;
+    float gyro_dps[3];      // Velocità angolare, bias già sottratto
     bool valid;
     uint32_t timestamp;
+    timestamp_us_t timestamp_us;
 };
 
 // === FUNZIONI IMU PUBBLICHE ===
 // Inizializzazione
 bool initIMU();
 bool isIMUReady();
+void markIMUFault();                // Sospende le letture fino a re-init
 bool isIMUCalibrated();
 
-// Lettura dati completa (NUOVA - per FreeRTOS)
-IMUData getIMUData();
-
-// Lettura valori singoli (per compatibilità)
-float getIMUPitch();
-float getIMURoll();
-float getIMUYaw();
+// Lettura raw tramite bus manager I2C (task sensori)
+struct IMURawSample {
+    uint8_t gyro[6];     // OUTX_L_G..OUTZ_H_G
+    uint8_t accel[6];    // OUTX_L_A..OUTZ_H_A
+    uint8_t mag[6];      // OUT_X_L..OUT_Z_H
+};
+void prepareIMURawReads(IMURawSample &raw, I2CTransaction &gyroTx,
+                        I2CTransaction &accelTx, I2CTransaction &magTx);
+IMUData processIMURaw(const IMURawSample &raw);
 
 // Calibrazione magnetometro
+// Il fit lo esegue il task sensori, che a fine calibrazione (copertura,
+// timeout o richiesta della UI) segnala UI_EVENT_MAG_CAL
+#define MAG_CAL_FINISH_WAIT_MS   500     // Attesa max del fit dopo finishMagCalibration()
 void startMagCalibration();
-void finishMagCalibration();
+void finishMagCalibration();        // Chiede il fit con i campioni raccolti finora
+void abortMagCalibration();         // Nessun campione IMU: resta la calibrazione precedente
 bool isMagCalibrationInProgress();  // AGGIUNTA - utile per UI
 float getMagCalibrationProgress();   // AGGIUNTA - per progress bar (0.0-1.0)
-bool loadCalibrationFromEEPROM();
-void saveCalibrationToEEPROM();
+bool getMagCalibrationResult(MagFitResult &result);  // Ultimo fit (residuo, copertura)
+bool loadCalibrationFromConfig();   // Copia in RAM (config_store.h)
+void saveCalibrationToConfig();     // Salvataggio NVS differito
 
 // Configurazione parametri filtro
 void setDeadZones(float pitchDZ, float yawDZ);  // AGGIUNTA - per tuning runtime
 void getDeadZones(float &pitchDZ, float &yawDZ); // AGGIUNTA
 
-// Debug
+// Debug (ultimo campione pubblicato, nessun accesso al bus)
 void printIMUDebug();
+
+// Calibrazione giroscopio / accelerometro: i campioni arrivano dal task
+// sensori, la fine dipende dalla convergenza statistica (imu_calibration.h)
+enum IMUCalMode : uint8_t {
+    IMU_CAL_MODE_NONE = 0,
+    IMU_CAL_MODE_GYRO,      // Dispositivo fermo
+    IMU_CAL_MODE_ACCEL      // Sei facce, una alla volta
+};
+
+struct IMUCalStatus {
+    IMUCalMode mode;        // Ultima calibrazione avviata
+    IMUCalState state;
+    float progress;         // 0.0-1.0
+    bool still;             // Gyro: fermo da almeno 3 campioni
+    int8_t face;            // Accel: faccia corrente (-1 = nessuna)
+    uint8_t faces_done;     // Accel: bitmask facce acquisite
+    float gyro_bias_dps[3];
+    float accel_offset[3];
+    float accel_scale[3];
+};
+
+bool startIMUCalibration(IMUCalMode mode);   // false se IMU non pronta
+void cancelIMUCalibration();
+void getIMUCalibrationStatus(IMUCalStatus &status);
+void applyAccelCalibration(float accel[3]);  // m/s², per chi legge l'accelerometro a parte
+
 void resetIMUFilters();  // AGGIUNTA - utile per test
 
 // === COSTANTI CONFIGURAZIONE ===
@@ -50,6 +90,30 @@ void resetIMUFilters();  // AGGIUNTA - utile per test
 #define IMU_SAMPLE_RATE_HZ 52      // Da configurazione originale
 #define IMU_MAG_RATE_HZ    20      // Da configurazione originale
 
+// Registri dati (lettura burst con auto-incremento)
+#define LSM6DSOX_REG_OUTX_L_G   0x22
+#define LSM6DSOX_REG_OUTX_L_A   0x28
+
+// FIFO LSM6DSOX (modalità inclinometro, inclinometer.cpp)
+#define LSM6DSOX_REG_FIFO_CTRL3     0x09    // BDR_XL nei bit 3:0
+#define LSM6DSOX_REG_FIFO_CTRL4     0x0A    // FIFO_MODE nei bit 2:0
+#define LSM6DSOX_REG_CTRL1_XL       0x10    // ODR_XL 7:4, FS_XL 3:2
+#define LSM6DSOX_REG_FIFO_STATUS1   0x3A    // DIFF_FIFO 7:0 (+ STATUS2 bit 1:0)
+#define LSM6DSOX_REG_FIFO_DATA_TAG  0x78    // Tag + 6 byte per parola
+#define LSM6DSOX_FIFO_WORD_BYTES    7
+#define LSM6DSOX_FIFO_TAG_XL        0x02    // TAG_SENSOR (bit 7:3) accelerometro
+#define LSM6DSOX_ODR_52HZ           0x03
+#define LSM6DSOX_ODR_416HZ          0x06
+#define LSM6DSOX_FIFO_MODE_BYPASS   0x00
+#define LSM6DSOX_FIFO_MODE_STREAM   0x06
+#define LIS3MDL_REG_OUT_X_L     0x28
+#define LIS3MDL_AUTO_INCREMENT  0x80    // Bit MSB sottoindirizzo LIS3MDL
+
+// Sensibilità per i range configurati in initIMU()
+#define LSM6DSOX_ACCEL_MS2_PER_LSB (0.061f * 9.80665f / 1000.0f)   // ±2g
+#define LSM6DSOX_GYRO_DPS_PER_LSB  (8.75f / 1000.0f)               // ±250dps
+#define LIS3MDL_UT_PER_LSB         (100.0f / 6842.0f)              // ±4 gauss
+
 // Valori di default per filtri (dal codice originale)
 #define DEFAULT_YAW_DEAD_ZONE   0.15f
 #define DEFAULT_PITCH_DEAD_ZONE 0.1f
@@ -0,0 +1,228 @@
+// inclinometer.cpp
+#include "inclinometer.h"
+#include "task_config.h"
+#include "imu_handler.h"
+#include "i2c_bus.h"
+
+#define INCLINO_SETTLE_SAMPLES  8       // Campioni scartati dopo il cambio di ODR
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t inclinoTaskHandle = NULL;
+static portMUX_TYPE resultLock = portMUX_INITIALIZER_UNLOCKED;
+static InclinoResult result = {};
+static volatile bool cancelRequested = false;
+static TaskHandle_t resultWaiter = NULL;    // Task in waitPrecisionPitch()
+
+// Solo il task inclinometro
+static PrecisionPitchEstimator estimator;
+static uint8_t fifoBuffer[INCLINO_WORDS_PER_READ * LSM6DSOX_FIFO_WORD_BYTES];
+static uint32_t settleSamples = 0;
+
+// === ACCESSO REGISTRI (bus manager, sotto il ciclo sensori) ===
+static bool writeIMUReg(uint8_t reg, uint8_t value) {
+    I2CTransaction t;
+    i2cPrepareWrite(t, I2C_DEV_IMU, I2C_PRIO_NORMAL, IMU_I2C_ADDR_6DOF, reg, &value, 1);
+    return i2cExecute(t, INCLINO_I2C_TIMEOUT_MS) == I2C_RESULT_OK;
+}
+
+static bool readIMURegs(uint8_t reg, uint8_t *buf, uint8_t len) {
+    I2CTransaction t;
+    i2cPrepareRead(t, I2C_DEV_IMU, I2C_PRIO_NORMAL, IMU_I2C_ADDR_6DOF, reg, buf, len);
+    t.flags = I2C_FLAG_NO_BATCH;
+    return i2cExecute(t, INCLINO_I2C_TIMEOUT_MS) == I2C_RESULT_OK;
+}
+
+// Accelerometro a 416Hz in FIFO (stream: le parole più vecchie si sovrascrivono)
+// oppure ritorno alla configurazione di initIMU() (52Hz, ±2g)
+static bool configureFifo(bool enable) {
+    if (enable) {
+        settleSamples = 0;
+        return writeIMUReg(LSM6DSOX_REG_CTRL1_XL, LSM6DSOX_ODR_416HZ << 4) &&
+               writeIMUReg(LSM6DSOX_REG_FIFO_CTRL3, LSM6DSOX_ODR_416HZ) &&
+               writeIMUReg(LSM6DSOX_REG_FIFO_CTRL4, LSM6DSOX_FIFO_MODE_STREAM);
+    }
+    bool ok = writeIMUReg(LSM6DSOX_REG_FIFO_CTRL4, LSM6DSOX_FIFO_MODE_BYPASS);
+    ok &= writeIMUReg(LSM6DSOX_REG_FIFO_CTRL3, 0);
+    ok &= writeIMUReg(LSM6DSOX_REG_CTRL1_XL, LSM6DSOX_ODR_52HZ << 4);
+    return ok;
+}
+
+// Svuota la FIFO nell'estimatore. Ritorna le parole lette, -1 su errore bus.
+// L'indirizzo di lettura torna da solo a FIFO_DATA_OUT_TAG dopo 0x7E: più
+// parole in un'unica transazione.
+static int drainFifo() {
+    uint8_t status[2];
+    if (!readIMURegs(LSM6DSOX_REG_FIFO_STATUS1, status, sizeof(status))) return -1;
+    int words = status[0] | ((status[1] & 0x03) << 8);
+    int total = words;
+
+    while (words > 0) {
+        int chunk = words < INCLINO_WORDS_PER_READ ? words : INCLINO_WORDS_PER_READ;
+        if (!readIMURegs(LSM6DSOX_REG_FIFO_DATA_TAG, fifoBuffer,
+                         chunk * LSM6DSOX_FIFO_WORD_BYTES)) {
+            return -1;
+        }
+        for (int w = 0; w < chunk; w++) {
+            const uint8_t *p = &fifoBuffer[w * LSM6DSOX_FIFO_WORD_BYTES];
+            if ((p[0] >> 3) != LSM6DSOX_FIFO_TAG_XL) continue;
+            if (settleSamples < INCLINO_SETTLE_SAMPLES) {
+                settleSamples++;
+                continue;
+            }
+            float a[3];
+            for (int i = 0; i < 3; i++) {
+                a[i] = (int16_t)(p[1 + i * 2] | (p[2 + i * 2] << 8)) * LSM6DSOX_ACCEL_MS2_PER_LSB;
+            }
+            applyAccelCalibration(a);
+            estimator.add(a);
+        }
+        words -= chunk;
+    }
+    return total;
+}
+
+static void publishResult(InclinoState state, uint32_t startMs) {
+    taskENTER_CRITICAL(&resultLock);
+    result.state = state;
+    result.pitch_deg = estimator.pitch();
+    result.roll_deg = estimator.roll();
+    result.ci95_deg = estimator.ci95();
+    result.samples = estimator.samples();
+    result.rejected = estimator.rejected();
+    result.restarts = estimator.restarts();
+    result.duration_ms = millis() - startMs;
+    taskEXIT_CRITICAL(&resultLock);
+}
+
+// === MISURA ===
+static void runMeasurement() {
+    taskENTER_CRITICAL(&resultLock);
+    float target = result.target_deg;
+    taskEXIT_CRITICAL(&resultLock);
+
+    estimator.reset();
+    uint32_t startMs = millis();
+    uint32_t lastDataMs = startMs;
+    InclinoState final = INCLINO_FAILED;
+
+    if (configureFifo(true)) {
+        final = INCLINO_TIMEOUT;
+        while (true) {
+            vTaskDelay(MS_TO_TICKS(INCLINO_POLL_MS));
+            if (cancelRequested) {
+                final = INCLINO_IDLE;
+                break;
+            }
+
+            int words = drainFifo();
+            if (words < 0) {
+                final = INCLINO_FAILED;
+                break;
+            }
+            if (words > 0) {
+                lastDataMs = millis();
+            } else if (millis() - lastDataMs > INCLINO_STALL_MS) {
+                final = INCLINO_FAILED;    // ODR azzerato da una re-init dell'IMU
+                break;
+            }
+
+            publishResult(INCLINO_RUNNING, startMs);
+            if (estimator.converged(target)) {
+                final = INCLINO_DONE;
+                break;
+            }
+            if (millis() - startMs >= INCLINO_TIMEOUT_MS) break;
+        }
+    }
+
+    if (!configureFifo(false)) {
+        RTOS_LOG("Inclinometer: FIFO restore failed");
+    }
+    publishResult(final, startMs);
+
+    taskENTER_CRITICAL(&resultLock);
+    TaskHandle_t waiter = resultWaiter;
+    resultWaiter = NULL;
+    taskEXIT_CRITICAL(&resultLock);
+    if (waiter) xTaskNotifyGive(waiter);
+
+    RTOS_LOG("Inclinometer: state %d pitch %.3f ±%.3f deg, %lu samples in %lums",
+             final, estimator.pitch(), estimator.ci95(),
+             (unsigned long)estimator.samples(), (unsigned long)(millis() - startMs));
+}
+
+static void inclinometerTask(void *pvParameters) {
+    RTOS_LOG("Inclinometer task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_INCLINO);
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        runMeasurement();
+    }
+}
+
+// === API ===
+bool initInclinometer() {
+    if (inclinoTaskHandle) return true;
+
+    BaseType_t res = xTaskCreatePinnedToCore(
+        inclinometerTask,
+        "Inclinometer",
+        INCLINO_TASK_STACK_SIZE,
+        NULL,
+        INCLINO_TASK_PRIORITY,
+        &inclinoTaskHandle,
+        INCLINO_TASK_CORE
+    );
+
+    if (res != pdPASS) {
+        Serial.println("❌ Failed to create inclinometer task");
+        return false;
+    }
+    return true;
+}
+
+bool startPrecisionPitch(float targetDeg) {
+    if (!inclinoTaskHandle || !isIMUReady() || !isI2CBusRunning()) return false;
+
+    taskENTER_CRITICAL(&resultLock);
+    bool busy = result.state == INCLINO_RUNNING;
+    if (!busy) {
+        memset(&result, 0, sizeof(result));
+        result.state = INCLINO_RUNNING;
+        result.target_deg = targetDeg > 0 ? targetDeg : INCLINO_DEFAULT_TARGET_DEG;
+        result.ci95_deg = INFINITY;
+    }
+    taskEXIT_CRITICAL(&resultLock);
+    if (busy) return false;
+
+    cancelRequested = false;
+    xTaskNotifyGive(inclinoTaskHandle);
+    return true;
+}
+
+void cancelPrecisionPitch() {
+    cancelRequested = true;
+}
+
+bool isPrecisionPitchRunning() {
+    return result.state == INCLINO_RUNNING;
+}
+
+void getPrecisionPitchResult(InclinoResult &r) {
+    taskENTER_CRITICAL(&resultLock);
+    r = result;
+    taskEXIT_CRITICAL(&resultLock);
+}
+
+void waitPrecisionPitch(InclinoResult &r) {
+    while (1) {
+        taskENTER_CRITICAL(&resultLock);
+        r = result;
+        if (r.state == INCLINO_RUNNING) resultWaiter = xTaskGetCurrentTaskHandle();
+        taskEXIT_CRITICAL(&resultLock);
+        if (r.state != INCLINO_RUNNING) return;
+
+        // La misura ha già un suo timeout: questo è solo un paracadute
+        ulTaskNotifyTake(pdTRUE, MS_TO_TICKS(INCLINO_TIMEOUT_MS));
+    }
+}
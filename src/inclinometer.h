@@ -0,0 +1,57 @@
+// inclinometer.h
+#ifndef INCLINOMETER_H
+#define INCLINOMETER_H
+
+#include <Arduino.h>
+#include "inclinometer_estimator.h"
+
+// === MODALITÀ INCLINOMETRO DI PRECISIONE ===
+// Su richiesta l'accelerometro passa a 416Hz con la FIFO in stream; un task
+// la svuota tramite il bus manager e media i campioni con scarto degli
+// outlier (inclinometer_estimator.h). La misura termina appena l'IC al 95%
+// del pitch scende sotto il target: niente attese fisse. Il ciclo sensori
+// a 10Hz continua in parallelo (legge i registri OUT, non la FIFO).
+
+#define INCLINO_DEFAULT_TARGET_DEG  0.05f   // Specifica pitch ±0.05°
+#define INCLINO_ODR_HZ              416
+#define INCLINO_POLL_MS             20      // ~8 parole FIFO per lettura
+#define INCLINO_TIMEOUT_MS          5000
+#define INCLINO_STALL_MS            200     // FIFO ferma (IMU re-init?) = fallita
+#define INCLINO_WORDS_PER_READ      18      // 126 byte: entro il buffer Wire (128)
+#define INCLINO_I2C_TIMEOUT_MS      20
+
+enum InclinoState : uint8_t {
+    INCLINO_IDLE = 0,
+    INCLINO_RUNNING,
+    INCLINO_DONE,       // IC sotto il target
+    INCLINO_TIMEOUT,    // Stima migliore disponibile, IC sopra il target
+    INCLINO_FAILED      // IMU assente o errore bus
+};
+
+struct InclinoResult {
+    InclinoState state;
+    float pitch_deg;
+    float roll_deg;
+    float ci95_deg;         // Semiampiezza IC al 95% sul pitch
+    float target_deg;
+    uint32_t samples;       // Campioni accettati
+    uint32_t rejected;
+    uint32_t restarts;      // Movimento durante la misura
+    uint32_t duration_ms;
+};
+
+bool initInclinometer();
+
+// false se una misura è già in corso o l'IMU non è pronta
+bool startPrecisionPitch(float targetDeg = INCLINO_DEFAULT_TARGET_DEG);
+void cancelPrecisionPitch();
+bool isPrecisionPitchRunning();
+
+// Istantanea (anche durante la misura: IC corrente)
+void getPrecisionPitchResult(InclinoResult &result);
+
+// Attende la fine della misura: il task inclinometro notifica il chiamante
+// (risvegli spuri della notifica del task sono tollerati)
+void waitPrecisionPitch(InclinoResult &result);
+
+#endif // INCLINOMETER_H
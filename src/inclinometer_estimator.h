@@ -0,0 +1,131 @@
+// inclinometer_estimator.h
+// Stima di pitch/roll ad alta precisione da accelerometro sovracampionato:
+// scarto degli outlier e intervallo di confidenza con il metodo delle
+// medie a blocchi (batch means), che resta corretto anche se i campioni
+// consecutivi sono correlati dal filtro del sensore.
+// Header puro C++ (running_stats.h), testato in tools/inclinometer_test.cpp.
+#ifndef INCLINOMETER_ESTIMATOR_H
+#define INCLINOMETER_ESTIMATOR_H
+
+#include <stdint.h>
+#include <math.h>
+#include "running_stats.h"
+
+#define INCLINO_BLOCK_SAMPLES      16      // ~38ms a 416Hz per blocco
+#define INCLINO_MIN_BLOCKS         8       // Sotto: varianza dei blocchi inaffidabile
+#define INCLINO_GRAVITY            9.80665f
+#define INCLINO_NORM_TOLERANCE     0.05f   // |a| oltre ±5% di g: urto/vibrazione
+#define INCLINO_OUTLIER_SIGMA      4.0f
+#define INCLINO_MIN_SIGMA_DEG      0.02f   // Soglia minima del gate outlier
+#define INCLINO_MAX_CONSECUTIVE_REJECTS (INCLINO_BLOCK_SAMPLES * 4)  // = spostato: si riparte
+
+// Quantile 97.5% della t di Student (IC al 95% con pochi blocchi)
+inline float inclinoT95(uint32_t df) {
+    static const float table[] = {
+        12.71f, 4.303f, 3.182f, 2.776f, 2.571f, 2.447f, 2.365f, 2.306f, 2.262f, 2.228f,
+        2.201f, 2.179f, 2.160f, 2.145f, 2.131f, 2.120f, 2.110f, 2.101f, 2.093f, 2.086f
+    };
+    if (df == 0) return INFINITY;
+    if (df <= sizeof(table) / sizeof(table[0])) return table[df - 1];
+    if (df <= 30) return 2.05f;
+    if (df <= 60) return 2.01f;
+    return 1.96f;
+}
+
+inline float inclinoPitchDeg(const float a[3]) {
+    return atan2f(-a[0], sqrtf(a[1] * a[1] + a[2] * a[2])) * (180.0f / (float)M_PI);
+}
+
+inline float inclinoRollDeg(const float a[3]) {
+    return atan2f(a[1], a[2]) * (180.0f / (float)M_PI);
+}
+
+class PrecisionPitchEstimator {
+public:
+    PrecisionPitchEstimator() { reset(); }
+
+    void reset() {
+        pitchBlocks.reset();
+        rollBlocks.reset();
+        pitchSamples.reset();
+        blockPitch = blockRoll = 0;
+        blockCount = 0;
+        total = 0;
+        rejectedCount = 0;
+        consecutiveRejects = 0;
+        restartCount = 0;
+    }
+
+    // false = campione scartato (modulo fuori tolleranza o outlier)
+    bool add(const float a[3]) {
+        total++;
+        float norm = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+        bool ok = fabsf(norm - INCLINO_GRAVITY) <= INCLINO_NORM_TOLERANCE * INCLINO_GRAVITY;
+
+        float pitch = inclinoPitchDeg(a);
+        if (ok && pitchSamples.n >= 2 * INCLINO_BLOCK_SAMPLES) {
+            float sigma = (float)pitchSamples.stddev();
+            if (sigma < INCLINO_MIN_SIGMA_DEG) sigma = INCLINO_MIN_SIGMA_DEG;
+            ok = fabsf(pitch - (float)pitchSamples.mean) <= INCLINO_OUTLIER_SIGMA * sigma;
+        }
+
+        if (!ok) {
+            rejectedCount++;
+            // Troppi scarti di fila: il dispositivo è stato mosso, la media
+            // accumulata non vale più
+            if (++consecutiveRejects >= INCLINO_MAX_CONSECUTIVE_REJECTS) restart();
+            return false;
+        }
+        consecutiveRejects = 0;
+
+        pitchSamples.add(pitch);
+        blockPitch += pitch;
+        blockRoll += inclinoRollDeg(a);
+        if (++blockCount == INCLINO_BLOCK_SAMPLES) {
+            pitchBlocks.add(blockPitch / INCLINO_BLOCK_SAMPLES);
+            rollBlocks.add(blockRoll / INCLINO_BLOCK_SAMPLES);
+            blockPitch = blockRoll = 0;
+            blockCount = 0;
+        }
+        return true;
+    }
+
+    // Semiampiezza dell'IC al 95% sul pitch (INFINITY finché i blocchi sono pochi)
+    float ci95() const {
+        if (pitchBlocks.n < INCLINO_MIN_BLOCKS) return INFINITY;
+        return inclinoT95(pitchBlocks.n - 1) * (float)pitchBlocks.stdError();
+    }
+
+    bool converged(float targetDeg) const { return ci95() <= targetDeg; }
+
+    float pitch() const { return (float)pitchBlocks.mean; }
+    float roll() const { return (float)rollBlocks.mean; }
+    uint32_t blocks() const { return pitchBlocks.n; }
+    uint32_t samples() const { return pitchSamples.n; }
+    uint32_t received() const { return total; }
+    uint32_t rejected() const { return rejectedCount; }
+    uint32_t restarts() const { return restartCount; }
+
+private:
+    void restart() {
+        pitchBlocks.reset();
+        rollBlocks.reset();
+        pitchSamples.reset();
+        blockPitch = blockRoll = 0;
+        blockCount = 0;
+        consecutiveRejects = 0;
+        restartCount++;
+    }
+
+    RunningStats pitchBlocks;   // Medie dei blocchi: base dell'IC
+    RunningStats rollBlocks;
+    RunningStats pitchSamples;  // Campioni accettati: gate outlier
+    double blockPitch, blockRoll;
+    uint32_t blockCount;
+    uint32_t total;
+    uint32_t rejectedCount;
+    uint32_t consecutiveRejects;
+    uint32_t restartCount;
+};
+
+#endif // INCLINOMETER_ESTIMATOR_H
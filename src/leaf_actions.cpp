@@ -5,13 +5,25 @@
 #include "display_utils.h"
 #include "ui_config.h"
 #include "sensor_tasks.h"     // Se usi FreeRTOS
+#include "power_manager.h"
 #include <Arduino_GFX_Library.h>
 #include <SD.h>
-#include <EEPROM.h>
+#include "config_store.h"
+#include "measure_service.h"
+#include "auto_capture.h"
+#include "point_cloud_service.h"
+#include "cloud_export.h"
+#include "height_map_service.h"
+#include "strip_chart.h"
+#include "data_logger.h"
+#include "system_monitor_service.h"
+#include "touch_handler.h"    // showMessage
+#include "config.h"
 #include <CSE_CST328.h>
 
 // Puntatori esterni
 extern Arduino_GFX* gfx;
+extern Arduino_DataBus* bus;
 extern CSE_CST328* touch;
 extern UIConfig ui;
 
@@ -29,25 +41,73 @@ namespace LeafActions {
     static bool stopRequested = false;
     
     // === SUBMENU 1: PITCH,YAW,DIST ===
+
+    // Riga misura su trigger della schermata Live Data (touch o tasto)
+    static void drawMeasurement(const MeasureResult &r) {
+        gfx->fillRect(10, 235, 220, 24, RGB565_BLUE);
+        gfx->setTextSize(1);
+        gfx->setTextColor(r.status == MEASURE_OK ? GREEN : ORANGE);
+        gfx->setCursor(10, 237);
+        gfx->printf("%s %.1fmm P%+.2f Y%.2f",
+                    measureStatusName(r.status), r.distance_mm, r.pitch_deg, r.yaw_deg);
+        gfx->setCursor(10, 250);
+        gfx->printf("X%.0f Y%.0f Z%.0f  n%u  %luus",
+                    r.x_mm, r.y_mm, r.z_mm, r.samples, (unsigned long)r.latency_us);
+    }
+
+    // Pulsante AUTO (cattura da fermo) e barra di stabilità
+    static void drawAutoButton(int x, int y, int w, int h, bool on) {
+        gfx->fillRect(x, y, w, h, on ? GREEN : DARKGREY);
+        gfx->drawRect(x, y, w, h, WHITE);
+        gfx->setCursor(x + 12, y + 10);
+        gfx->setTextSize(2);
+        gfx->setTextColor(WHITE);
+        gfx->print(on ? "AUTO*" : "AUTO");
+    }
+
+    static void drawStillnessBar(const AutoCaptureStatus &s) {
+        const int BAR_X = 10, BAR_Y = 261, BAR_W = 220, BAR_H = 4;
+        gfx->fillRect(BAR_X, BAR_Y, BAR_W, BAR_H, RGB565_BLUE);
+        if (!s.enabled) return;
+        uint16_t color = s.state == AUTO_CAPTURE_CAPTURED ? GREEN : YELLOW;
+        gfx->fillRect(BAR_X, BAR_Y, (int)(BAR_W * s.progress), BAR_H, color);
+    }
+
+    static void drawCapture(const AutoCaptureStatus &s) {
+        gfx->fillRect(10, 235, 220, 24, RGB565_BLUE);
+        gfx->setTextSize(1);
+        gfx->setTextColor(GREEN);
+        gfx->setCursor(10, 237);
+        gfx->printf("CAPT #%lu %.1fmm P%+.2f Y%.2f", (unsigned long)s.captures,
+                    s.last.distance_mm, s.last.pitch_deg, s.last.yaw_deg);
+        gfx->setCursor(10, 250);
+        gfx->printf("X%.0f Y%.0f Z%.0f", s.last.x_mm, s.last.y_mm, s.last.z_mm);
+    }
     
-    void startDataAcquisition() {
-        Serial.println("🔵 Starting data acquisition...");
-        actionRunning = true;
-        
-        // TODO: Implementare acquisizione con timestamp
-        // - Salvare su SD card
-        // - O buffer in RAM
-        
-        delay(2000);  // Simulazione
-        actionRunning = false;
-        Serial.println("✅ Acquisition complete");
+    // === LAYOUT LIVE DATA ===
+    static const int BACK_X = 20;
+    static const int BACK_Y = 270;
+    static const int BACK_W = 80;
+    static const int BACK_H = 35;
+    static const int AUTO_X = 130;
+    static const int AUTO_W = 90;
+    static const int MAP_BTN_X = 180;
+    static const int MAP_BTN_Y = 48;
+    static const int MAP_BTN_W = 50;
+    static const int MAP_BTN_H = 22;
+    static const int GRAPH_BTN_X = 110;
+    static const int GRAPH_BTN_W = 64;
+    
+    static void drawButton(int x, int y, int w, int h, uint16_t color, const char *label, uint8_t size) {
+        gfx->fillRect(x, y, w, h, color);
+        gfx->drawRect(x, y, w, h, WHITE);
+        gfx->setTextSize(size);
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(x + (w - (int)strlen(label) * 6 * size) / 2, y + (h - 8 * size) / 2);
+        gfx->print(label);
     }
     
-    void showLiveData() {
-        Serial.println("📊 Showing live data...");
-        actionRunning = true;
-        stopRequested = false;
-        
+    static void drawLiveDataLayout() {
         // Setup display
         gfx->fillScreen(RGB565_BLUE);
         
@@ -68,11 +128,6 @@ namespace LeafActions {
         gfx->println("Yaw:");
         
         // === BACK BUTTON CON COORDINATE CORRETTE ===
-        const int BACK_X = 20;
-        const int BACK_Y = 270;
-        const int BACK_W = 80;
-        const int BACK_H = 35;
-        
         gfx->fillRect(BACK_X, BACK_Y, BACK_W, BACK_H, ORANGE);
         gfx->drawRect(BACK_X, BACK_Y, BACK_W, BACK_H, WHITE);
         gfx->setCursor(BACK_X + 15, BACK_Y + 10);
@@ -80,15 +135,173 @@ namespace LeafActions {
         gfx->setTextColor(WHITE);
         gfx->println("BACK");
         
-        // === DEBUG: Mostra area touch ===
+        // Cattura automatica: niente tap, il punto si prende da fermo
+        drawAutoButton(AUTO_X, BACK_Y, AUTO_W, BACK_H, isAutoCaptureEnabled());
+        
+        // Mappa di quota dello sweep
+        drawButton(MAP_BTN_X, MAP_BTN_Y, MAP_BTN_W, MAP_BTN_H, DARKGREY, "MAP", 2);
+        
+        // Grafico a scorrimento di distanza/pitch/yaw
+        drawButton(GRAPH_BTN_X, MAP_BTN_Y, GRAPH_BTN_W, MAP_BTN_H, DARKGREY, "GRAPH", 2);
+        
         gfx->setTextSize(1);
-        gfx->setCursor(120, 275);
-        gfx->printf("Touch: %d,%d to %d,%d", BACK_X, BACK_Y, BACK_X+BACK_W, BACK_Y+BACK_H);
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(10, 225);
+        gfx->print("Tap = MEASURE");
+    }
+    
+    static bool touchIn(int px, int py, int x, int y, int w, int h) {
+        return px >= x && px <= x + w && py >= y && py <= y + h;
+    }
+    
+    // === MAPPA DI QUOTA ===
+    // Griglia 240x240 sotto l'intestazione; a ogni giro si disegnano solo le
+    // celle cambiate (36 pixel ciascuna). La scala colori si allarga quando
+    // un valore ne esce, e solo allora si ridisegnano tutte le celle.
+    static const int MAP_Y = 28;
+    static const int MAP_PX = LCD_WIDTH / HEIGHT_MAP_COLS;
+    static const int MAP_BUTTONS_Y = 272;
+    static const int MAP_BUTTON_H = 34;
+    static const int MAP_INFO_Y = 310;
+    
+    static void drawMapHeader(const HeightMapStats &s, float lo, float hi) {
+        bool angular = s.mode == HEIGHT_MAP_ANGULAR;
+        gfx->fillRect(0, 0, LCD_WIDTH, MAP_Y, BLACK);
+        gfx->setTextSize(2);
+        gfx->setTextColor(YELLOW);
+        gfx->setCursor(4, 6);
+        gfx->print(angular ? "MAP Y/P" : "MAP XY");
+        
+        // Legenda: gradiente e estremi della scala corrente
+        for (int x = 0; x < 60; x++) {
+            gfx->drawFastVLine(100 + x, 4, 8, heightMapColor(x / 59.0f));
+        }
+        gfx->setTextSize(1);
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(100, 16);
+        if (hi > lo) gfx->printf("%.0f..%.0f", lo, hi);
+        gfx->setCursor(170, 4);
+        gfx->printf("%s %.2g%s", angular ? "dist" : "quota", s.cell_size, angular ? "d" : "mm");
+    }
+    
+    static void drawMapInfo(const char *text) {
+        gfx->fillRect(0, MAP_INFO_Y, LCD_WIDTH, 10, BLACK);
+        gfx->setTextSize(1);
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(4, MAP_INFO_Y);
+        gfx->print(text);
+    }
+    
+    static void showHeightMap() {
+        Serial.println("🗺️ Showing height map...");
+        gfx->fillScreen(BLACK);
+        drawButton(10, MAP_BUTTONS_Y, 70, MAP_BUTTON_H, ORANGE, "BACK", 2);
+        drawButton(85, MAP_BUTTONS_Y, 70, MAP_BUTTON_H, DARKGREY, "MODE", 2);
+        drawButton(160, MAP_BUTTONS_Y, 70, MAP_BUTTON_H, DARKGREY, "CLEAR", 2);
+        
+        HeightMapStats s;
+        getHeightMapStats(s);
+        bool first = true;
+        uint32_t shownGeneration = 0;
+        float lo = 0, hi = 0;
+        uint32_t lastTapMs = 0;
+        uint32_t lastInfoMs = 0;
+        bool pinned = false;        // Dettaglio di una cella toccata sulla riga info
+        char info[48];
+        
+        while (isInLiveDataMode()) {
+            getHeightMapStats(s);
+            
+            // Modo cambiato o griglia svuotata (anche da console): sfondo e scala da capo
+            if (first || s.generation != shownGeneration) {
+                first = false;
+                shownGeneration = s.generation;
+                lo = hi = 0;
+                gfx->fillRect(0, MAP_Y, LCD_WIDTH, HEIGHT_MAP_ROWS * MAP_PX, BLACK);
+                markHeightMapDirty();
+                drawMapHeader(s, lo, hi);
+            }
+            
+            // Scala colori con margine: si allarga di rado, mai a ogni campione
+            if (s.occupied > 0 && (hi <= lo || s.value_min < lo || s.value_max > hi)) {
+                float margin = (s.value_max - s.value_min) * 0.1f + 1.0f;
+                lo = s.value_min - margin;
+                hi = s.value_max + margin;
+                markHeightMapDirty();
+                drawMapHeader(s, lo, hi);
+            }
+            
+            // Solo le celle cambiate
+            uint32_t t0 = micros();
+            uint32_t drawn = 0;
+            uint16_t indices[32];
+            HeightMapCell cells[32];
+            uint16_t n;
+            while ((n = takeHeightMapDirty(indices, cells, 32)) > 0) {
+                for (uint16_t i = 0; i < n; i++) {
+                    int col = indices[i] % HEIGHT_MAP_COLS;
+                    int row = indices[i] / HEIGHT_MAP_COLS;
+                    uint16_t color = cells[i].count ? heightMapColor((cells[i].mean - lo) / (hi - lo)) : BLACK;
+                    gfx->fillRect(col * MAP_PX, MAP_Y + row * MAP_PX, MAP_PX, MAP_PX, color);
+                }
+                drawn += n;
+            }
+            if (!pinned && millis() - lastInfoMs >= 1000) {
+                lastInfoMs = millis();
+                snprintf(info, sizeof(info), "%lu celle  %lu camp  %lu rid %luus",
+                         (unsigned long)s.occupied, (unsigned long)s.samples,
+                         (unsigned long)drawn, (unsigned long)(micros() - t0));
+                drawMapInfo(info);
+            }
+            
+            if (touch->getTouches() > 0 && millis() - lastTapMs > 300) {
+                lastTapMs = millis();
+                auto p = touch->touchPoints[0];
+                if (touchIn(p.x, p.y, 0, MAP_BUTTONS_Y - 6, 85, MAP_BUTTON_H + 12)) {
+                    break;
+                } else if (touchIn(p.x, p.y, 85, MAP_BUTTONS_Y - 6, 75, MAP_BUTTON_H + 12)) {
+                    setHeightMapMode(s.mode == HEIGHT_MAP_ANGULAR ? HEIGHT_MAP_PLAN : HEIGHT_MAP_ANGULAR);
+                    captureConfigTunables();    // Persistente come da console
+                    pinned = false;
+                } else if (touchIn(p.x, p.y, 160, MAP_BUTTONS_Y - 6, 80, MAP_BUTTON_H + 12)) {
+                    clearHeightMap();
+                    pinned = false;
+                } else if (p.y >= MAP_Y && p.y < MAP_Y + HEIGHT_MAP_ROWS * MAP_PX) {
+                    // Dettaglio della cella: media, minimo, massimo, campioni
+                    HeightMapCell c;
+                    int col = p.x / MAP_PX, row = (p.y - MAP_Y) / MAP_PX;
+                    pinned = getHeightMapCell(col, row, c);
+                    if (pinned) {
+                        snprintf(info, sizeof(info), "%d,%d: %.1f (%.1f..%.1f) n%u",
+                                 col, row, c.mean, c.min, c.max, c.count);
+                        drawMapInfo(info);
+                    }
+                }
+            }
+            
+            // Ridisegno al ritmo dei campioni (10Hz) o del touch
+            waitUIEvent(UI_EVENT_SENSOR | UI_EVENT_TOUCH, 100);
+        }
+    }
+    
+    void showLiveData() {
+        Serial.println("📊 Showing live data...");
+        actionRunning = true;
+        stopRequested = false;
+        
+        drawLiveDataLayout();
+        
+        uint32_t lastTapMs = 0;
+        MeasureResult measured;
+        uint32_t shownMeasure = 0;
+        AutoCaptureStatus capture;
+        getAutoCaptureStatus(capture);
+        uint32_t shownCaptures = capture.captures;
         
         // Live update loop con gestione touch integrata
         while (!stopRequested && isInLiveDataMode()) {
             // === UPDATE DATI ===
-            #ifdef USE_FREERTOS
+            // Dati dal task sensori: la UI non accede direttamente al bus I2C
             SensorData data;
             if (getLatestSensorData(data)) {
                 // Distanza
@@ -101,42 +314,21 @@ namespace LeafActions {
                 // Pitch
                 gfx->fillRect(140, 135, 80, 30, RGB565_BLUE);
                 gfx->setCursor(140, 140);
-                gfx->printf("%+6.1f", data.pitch);
+                gfx->printf("%+6.1f", data.pitch_deg);
                 
                 // Yaw
                 gfx->fillRect(140, 195, 80, 30, RGB565_BLUE);
                 gfx->setCursor(140, 200);
-                gfx->printf("%5.1f", data.yaw);
+                gfx->printf("%5.1f", data.yaw_deg);
             }
-            #else
-            // Versione senza FreeRTOS
-            float distance = getFilteredRadarDistance();
-            float pitch = getIMUPitch();
-            float yaw = getIMUYaw();
-            
-            // Update display
-            gfx->fillRect(140, 75, 80, 30, RGB565_BLUE);
-            gfx->setCursor(140, 80);
-            gfx->setTextColor(YELLOW);
-            gfx->setTextSize(2);
-            gfx->printf("%4.0f mm", distance);
-            
-            gfx->fillRect(140, 135, 80, 30, RGB565_BLUE);
-            gfx->setCursor(140, 140);
-            gfx->printf("%+6.1f", pitch);
-            
-            gfx->fillRect(140, 195, 80, 30, RGB565_BLUE);
-            gfx->setCursor(140, 200);
-            gfx->printf("%5.1f", yaw);
-            #endif
             
             // === CHECK TOUCH DIRETTAMENTE QUI ===
             if (touch->getTouches() > 0) {
                 auto p = touch->touchPoints[0];
                 
                 // Debug: mostra coordinate touch
-                gfx->fillRect(120, 290, 100, 20, RGB565_BLUE);
-                gfx->setCursor(120, 290);
+                gfx->fillRect(130, 308, 100, 10, RGB565_BLUE);
+                gfx->setCursor(130, 308);
                 gfx->setTextSize(1);
                 gfx->setTextColor(WHITE);
                 gfx->printf("X:%d Y:%d", p.x, p.y);
@@ -159,10 +351,52 @@ namespace LeafActions {
                     stopRequested = true;
                     setCurrentMenuState(SUBMENU_1);  // Torna al submenu
                     Serial.println("Back pressed - exiting live data");
+                } else if (touchIn(p.x, p.y, MAP_BTN_X - 5, MAP_BTN_Y - 5, MAP_BTN_W + 10, MAP_BTN_H + 10)) {
+                    showHeightMap();
+                    drawLiveDataLayout();
+                    if (getLastMeasurement(measured)) drawMeasurement(measured);
+                    lastTapMs = millis();
+                } else if (touchIn(p.x, p.y, GRAPH_BTN_X - 5, MAP_BTN_Y - 5, GRAPH_BTN_W + 8, MAP_BTN_H + 10)) {
+                    showLiveGraph();
+                    drawLiveDataLayout();
+                    if (getLastMeasurement(measured)) drawMeasurement(measured);
+                    lastTapMs = millis();
+                } else if (p.x >= AUTO_X - 10 && p.y >= BACK_Y - 10 &&
+                           millis() - lastTapMs > 500) {
+                    lastTapMs = millis();
+                    setAutoCaptureEnabled(!isAutoCaptureEnabled());
+                    captureConfigTunables();    // Persistente come da console
+                    drawAutoButton(AUTO_X, BACK_Y, AUTO_W, BACK_H, isAutoCaptureEnabled());
+                } else if (p.y < BACK_Y - 10 && millis() - lastTapMs > 500) {
+                    // Tap sull'area dati: misura sullo storico fino a questo istante
+                    lastTapMs = millis();
+                    measureNow(MEASURE_SRC_TOUCH, measured);
+                    printMeasurement(measured);
                 }
             }
             
-            delay(100);  // 10Hz update
+            // Misure da qualunque trigger (anche il tasto fisico)
+            MeasureStats mstats;
+            getMeasureStats(mstats);
+            if (mstats.count != shownMeasure && getLastMeasurement(measured)) {
+                shownMeasure = mstats.count;
+                drawMeasurement(measured);
+            }
+            
+            // Stato cattura automatica: barra di stabilità e nuovo punto
+            getAutoCaptureStatus(capture);
+            drawStillnessBar(capture);
+            if (capture.captures != shownCaptures) {
+                shownCaptures = capture.captures;
+                drawCapture(capture);
+                Serial.printf("📍 Auto-capture #%lu: X %.1f Y %.1f Z %.1f mm\n",
+                              (unsigned long)capture.captures,
+                              capture.last.x_mm, capture.last.y_mm, capture.last.z_mm);
+            }
+            
+            // Attende il prossimo campione (10Hz), un touch, una misura o
+            // una cattura, senza polling
+            waitUIEvent(UI_EVENT_SENSOR | UI_EVENT_TOUCH | UI_EVENT_MEASURE | UI_EVENT_CAPTURE, 100);
         }
         
         actionRunning = false;
@@ -172,46 +406,619 @@ namespace LeafActions {
         drawMenu(gfx, ui, getCurrentMenuState());
     }
     
+    // === GRAFICO A SCORRIMENTO ===
+    // In orizzontale (rotazione 1) le righe del pannello (gate, lato da 320)
+    // diventano le colonne dello schermo: lo scroll verticale hardware
+    // dell'ST7789 fa scorrere il grafico verso sinistra. Area di scroll =
+    // righe 0..239 (grafico), area fissa in fondo = righe 240..319 (pannello
+    // info a destra). Ogni campione nuovo scrive una sola colonna (480 byte)
+    // e sposta l'inizio dello scroll; tutto il grafico si ridisegna solo
+    // quando cambia una scala.
+    static const uint16_t GRAPH_W = LCD_WIDTH;                  // Colonne = campioni visibili
+    static const uint16_t GRAPH_H = LCD_WIDTH;                  // Altezza in orizzontale
+    static const uint16_t GRAPH_PANEL_X = GRAPH_W;
+    static const uint16_t GRAPH_PANEL_W = LCD_HEIGHT - GRAPH_W;
+    
+    typedef StripChart<GRAPH_W, GRAPH_H, 3> LiveChart;
+    static LiveChart liveChart;
+    static uint16_t graphColumn[GRAPH_H];
+    
+    static void setScrollArea(uint16_t top, uint16_t height, uint16_t bottom) {
+        bus->beginWrite();
+        bus->writeCommand(ST7789_VSCRDEF);
+        bus->write16(top);
+        bus->write16(height);
+        bus->write16(bottom);
+        bus->endWrite();
+    }
+    
+    static void setScrollStart(uint16_t line) {
+        bus->beginWrite();
+        bus->writeCommand(ST7789_VSCRSADD);
+        bus->write16(line);
+        bus->endWrite();
+    }
+    
+    // Colonna di età age nella riga del pannello che le spetta (la più
+    // recente sta subito prima dell'inizio dello scroll, cioè a destra)
+    static void drawGraphColumn(uint16_t age, uint16_t scroll) {
+        liveChart.renderColumn(age, graphColumn);
+        uint16_t line = (uint16_t)((scroll + 2 * GRAPH_W - 1 - age) % GRAPH_W);
+        gfx->draw16bitRGBBitmap(line, 0, graphColumn, 1, GRAPH_H);
+    }
+    
+    static void drawGraphPanel(const SensorData &d, bool valid, float yawUnwrapped,
+                               uint32_t avgUs, uint32_t maxUs, uint32_t redrawUs,
+                               uint32_t rate, uint32_t dropped) {
+        static const char *names[3] = {"DIST mm", "PITCH", "YAW"};
+        static const uint16_t colors[3] = {GREEN, YELLOW, CYAN};
+        float values[3] = {d.distance_mm, d.pitch_deg, yawUnwrapped};
+        
+        gfx->fillRect(GRAPH_PANEL_X, 0, GRAPH_PANEL_W, GRAPH_H, BLACK);
+        gfx->setTextSize(1);
+        for (uint8_t t = 0; t < 3; t++) {
+            int y = t * LiveChart::BAND + 4;
+            gfx->setTextColor(colors[t]);
+            gfx->setCursor(GRAPH_PANEL_X + 4, y);
+            gfx->print(names[t]);
+            gfx->setCursor(GRAPH_PANEL_X + 4, y + 12);
+            if (valid) gfx->printf("%.1f", values[t]);
+            else gfx->print("--");
+            gfx->setTextColor(DARKGREY);
+            gfx->setCursor(GRAPH_PANEL_X + 4, y + 28);
+            gfx->printf("%.1f", liveChart.high(t));
+            gfx->setCursor(GRAPH_PANEL_X + 4, y + 38);
+            gfx->printf("%.1f", liveChart.low(t));
+        }
+        
+        // Costo del ridisegno: per colonna e per grafico intero
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(GRAPH_PANEL_X + 4, 186);
+        gfx->printf("%luHz", (unsigned long)rate);
+        gfx->setCursor(GRAPH_PANEL_X + 4, 196);
+        gfx->printf("col %luus", (unsigned long)avgUs);
+        gfx->setCursor(GRAPH_PANEL_X + 4, 206);
+        gfx->printf("max %luus", (unsigned long)maxUs);
+        gfx->setCursor(GRAPH_PANEL_X + 4, 216);
+        gfx->printf("full %lums", (unsigned long)(redrawUs / 1000));
+        gfx->setCursor(GRAPH_PANEL_X + 4, 226);
+        gfx->printf("persi %lu", (unsigned long)dropped);
+    }
+    
     void showLiveGraph() {
         Serial.println("📈 Showing live graph...");
         
-        // TODO: Implementare grafico real-time
-        // - Usa buffer circolare per storia
-        // - Disegna assi e griglia
-        // - Plotta ultimi N campioni
+        int8_t sub = subscribeSensorData("graph", PUBSUB_DECIMATED, 1);
+        if (sub < 0) {
+            Serial.println("❌ Graph: nessun subscriber libero");
+            return;
+        }
         
+        static const uint16_t colors[3] = {GREEN, YELLOW, CYAN};
+        static const float minSpan[3] = {20.0f, 2.0f, 2.0f};    // mm, gradi, gradi
+        liveChart.begin(colors, minSpan, BLACK);
+        
+        gfx->setRotation(1);
         gfx->fillScreen(BLACK);
+        setScrollArea(0, GRAPH_W, GRAPH_PANEL_W);
+        uint16_t scroll = 0;
+        setScrollStart(scroll);
+        for (uint16_t a = 0; a < GRAPH_W; a++) drawGraphColumn(a, scroll);
+        
+        SensorData d = {};
+        bool valid = false;
+        float yawUnwrapped = 0;
+        float lastYaw = NAN;
+        uint32_t columns = 0, columnUs = 0, maxColumnUs = 0;
+        uint32_t redraws = 0, redrawUs = 0;
+        uint32_t lastInfoMs = 0;
+        uint32_t startMs = millis();
+        bool touched = touch->getTouches() > 0;     // Il tap che ha aperto il grafico
+        
+        while (isInLiveDataMode()) {
+            // Tutti i campioni arrivati: una colonna ciascuno
+            while (readSensorData(sub, d, 0)) {
+                uint32_t t0 = micros();
+                valid = d.radar_valid && d.imu_valid;
+                float v[3] = {NAN, NAN, NAN};
+                if (valid) {
+                    // Yaw continuo attraverso 0/360 (niente salti a tutta fascia)
+                    yawUnwrapped = isfinite(lastYaw) ? yawUnwrapped + heightMapWrapDeg(d.yaw_deg - lastYaw) : d.yaw_deg;
+                    lastYaw = d.yaw_deg;
+                    v[0] = d.distance_mm;
+                    v[1] = d.pitch_deg;
+                    v[2] = yawUnwrapped;
+                }
+                
+                bool rescaled = liveChart.push(v);
+                scroll = (uint16_t)((scroll + 1) % GRAPH_W);
+                if (rescaled) {
+                    for (uint16_t a = 0; a < GRAPH_W; a++) drawGraphColumn(a, scroll);
+                    setScrollStart(scroll);
+                    redraws++;
+                    redrawUs = micros() - t0;
+                } else {
+                    drawGraphColumn(0, scroll);
+                    setScrollStart(scroll);
+                    uint32_t us = micros() - t0;
+                    columns++;
+                    columnUs += us;
+                    if (us > maxColumnUs) maxColumnUs = us;
+                }
+            }
+            
+            if (millis() - lastInfoMs >= 1000) {
+                uint32_t elapsed = millis() - lastInfoMs;
+                lastInfoMs = millis();
+                PubSubSubscriberStats stats;
+                getSensorSubscriberStats(sub, stats);
+                uint32_t avgUs = columns ? columnUs / columns : 0;
+                uint32_t rate = elapsed ? (columns + redraws) * 1000 / elapsed : 0;
+                drawGraphPanel(d, valid, yawUnwrapped, avgUs, maxColumnUs, redrawUs, rate, stats.dropped);
+                if (millis() - startMs >= 1000) {
+                    Serial.printf("📈 Graph: %lu col/s, colonna %lu us (max %lu), %lu ridisegni (%lu us), persi %lu\n",
+                                  (unsigned long)rate, (unsigned long)avgUs, (unsigned long)maxColumnUs,
+                                  (unsigned long)redraws, (unsigned long)redrawUs, (unsigned long)stats.dropped);
+                }
+                columns = columnUs = maxColumnUs = 0;
+                redraws = 0;
+            }
+            
+            // Un tocco qualunque chiude (dopo aver rilasciato quello di apertura)
+            bool now = touch->getTouches() > 0;
+            if (now && !touched) break;
+            touched = now;
+            
+            waitUIEvent(UI_EVENT_SENSOR | UI_EVENT_TOUCH, 100);
+        }
+        
+        unsubscribeSensorData(sub);
+        
+        // Scroll disattivato e orientamento del menu
+        setScrollArea(0, LCD_HEIGHT, 0);
+        setScrollStart(0);
+        gfx->setRotation(0);
+        delay(200);     // Debounce: il tocco di uscita non arriva al Live Data
+    }
+    
+    // === VIEWER DEI LOG ===
+    // Una colonna per pixel dalla piramide min/max/media della sessione
+    // (log_pyramid.h): banda min..max attenuata e media piena. Zoom a
+    // potenze di 2 e pan di mezzo schermo; ogni vista legge al più
+    // 240 x 8 bin dalla SD, qualunque sia la durata della registrazione.
+    static const int VIEW_Y = 26;
+    static const int VIEW_H = 200;
+    static const int VIEW_INFO_Y = 232;
+    static const int VIEW_BUTTONS_Y = 272;
+    static const int VIEW_BUTTON_W = 36;
+    static const int VIEW_BUTTON_H = 34;
+    static const uint16_t VIEW_SCRATCH_BINS = 64;
+    
+    static PyramidBin viewColumns[LCD_WIDTH];
+    static PyramidBin viewScratch[VIEW_SCRATCH_BINS];
+    
+    static int viewButtonX(int i) {
+        return 4 + i * (VIEW_BUTTON_W + 3);
+    }
+    
+    static void formatLogTime(char *out, size_t max, uint64_t us) {
+        uint32_t s = (uint32_t)(us / 1000000ULL);
+        snprintf(out, max, "%lu:%02lu:%02lu", (unsigned long)(s / 3600),
+                 (unsigned long)(s / 60 % 60), (unsigned long)(s % 60));
+    }
+    
+    static void drawLogView(LogSessionReader &reader, uint32_t first, uint32_t spp, uint8_t channel) {
+        static const char *names[3] = {"DIST mm", "PITCH", "YAW"};
+        static const uint16_t colors[3] = {GREEN, YELLOW, CYAN};
+        static const uint16_t dims[3] = {0x0320, 0x6300, 0x0318};
+        float scale = channel == LOG_CH_DISTANCE ? 1.0f / RECORD_UM_PER_MM : 1.0f / RECORD_CDEG_PER_DEG;
+        
+        uint32_t t0 = micros();
+        PyramidRenderStats st;
+        pyramidRender(reader, first, spp, LCD_WIDTH, viewColumns, viewScratch, VIEW_SCRATCH_BINS, st);
+        uint32_t readUs = micros() - t0;
+        
+        // Scala verticale sulle colonne visibili
+        int32_t lo = INT32_MAX, hi = INT32_MIN;
+        for (int x = 0; x < LCD_WIDTH; x++) {
+            const PyramidBin &b = viewColumns[x];
+            if (!b.count) continue;
+            if (b.min[channel] < lo) lo = b.min[channel];
+            if (b.max[channel] > hi) hi = b.max[channel];
+        }
+        if (lo > hi) lo = hi = 0;
+        int32_t margin = (hi - lo) / 10 + 1;
+        lo -= margin;
+        hi += margin;
+        
+        gfx->fillRect(0, 0, LCD_WIDTH, VIEW_INFO_Y + 24, BLACK);
+        gfx->setTextSize(2);
+        gfx->setTextColor(colors[channel]);
+        gfx->setCursor(4, 4);
+        gfx->printf("LOG %03u %s", reader.session(), names[channel]);
+        
+        gfx->drawFastHLine(0, VIEW_Y - 1, LCD_WIDTH, DARKGREY);
+        gfx->drawFastHLine(0, VIEW_Y + VIEW_H, LCD_WIDTH, DARKGREY);
+        for (int x = 0; x < LCD_WIDTH; x++) {
+            const PyramidBin &b = viewColumns[x];
+            if (!b.count) continue;     // Buco: nessun campione valido
+            int yTop = VIEW_Y + (int)((int64_t)(hi - b.max[channel]) * (VIEW_H - 1) / (hi - lo));
+            int yBottom = VIEW_Y + (int)((int64_t)(hi - b.min[channel]) * (VIEW_H - 1) / (hi - lo));
+            int yMean = VIEW_Y + (int)((int64_t)(hi - b.mean[channel]) * (VIEW_H - 1) / (hi - lo));
+            gfx->drawFastVLine(x, yTop, yBottom - yTop + 1, dims[channel]);
+            gfx->drawPixel(x, yMean, colors[channel]);
+        }
+        
+        // Estremi della scala e intervallo di tempo
+        gfx->setTextSize(1);
         gfx->setTextColor(WHITE);
-        gfx->setCursor(50, 150);
-        gfx->println("Graph Mode");
-        gfx->setCursor(30, 180);
-        gfx->println("Coming Soon...");
+        gfx->setCursor(2, VIEW_Y + 2);
+        gfx->printf("%.2f", hi * scale);
+        gfx->setCursor(2, VIEW_Y + VIEW_H - 10);
+        gfx->printf("%.2f", lo * scale);
+        
+        SensorRecord r0, r1;
+        uint32_t last = first + spp * LCD_WIDTH - 1;
+        if (last >= reader.records()) last = reader.records() - 1;
+        char a[16] = "?", b[16] = "?";
+        if (reader.readRecord(first, r0)) formatLogTime(a, sizeof(a), r0.timestamp_us - reader.startUs());
+        if (reader.readRecord(last, r1)) formatLogTime(b, sizeof(b), r1.timestamp_us - reader.startUs());
+        gfx->setCursor(4, VIEW_INFO_Y);
+        gfx->printf("%s - %s  %lu camp/px", a, b, (unsigned long)spp);
+        gfx->setCursor(4, VIEW_INFO_Y + 12);
+        gfx->printf("L%u %lu bin %lu lett %lums  %lu rec", st.level, (unsigned long)st.bins,
+                    (unsigned long)st.reads, (unsigned long)(readUs / 1000),
+                    (unsigned long)reader.records());
+        Serial.printf("📉 Log view %03u: primo %lu, %lu camp/px, L%u, %lu bin in %lu us\n",
+                      reader.session(), (unsigned long)first, (unsigned long)spp, st.level,
+                      (unsigned long)st.bins, (unsigned long)readUs);
+    }
+    
+    static void showLogViewer(uint16_t session) {
+        Serial.printf("📉 Showing log %03u...\n", session);
+        LogSessionReader reader;
+        if (!reader.open(session) || reader.records() == 0) {
+            showMessage(gfx, "Log vuoto", ORANGE, BLACK);
+            delay(1500);
+            return;
+        }
+        
+        gfx->fillScreen(BLACK);
+        static const char *labels[6] = {"BACK", "<", ">", "-", "+", "CH"};
+        for (int i = 0; i < 6; i++) {
+            drawButton(viewButtonX(i), VIEW_BUTTONS_Y, VIEW_BUTTON_W, VIEW_BUTTON_H,
+                       i == 0 ? ORANGE : DARKGREY, labels[i], i == 0 ? 1 : 2);
+        }
         
-        delay(3000);
+        // Vista iniziale: tutta la sessione
+        uint32_t total = reader.records();
+        uint32_t fullSpp = (total + LCD_WIDTH - 1) / LCD_WIDTH;
+        uint32_t spp = fullSpp;
+        uint32_t first = 0;
+        uint8_t channel = LOG_CH_DISTANCE;
+        bool redraw = true;
+        uint32_t lastTapMs = millis();
+        
+        while (1) {
+            if (redraw) {
+                drawLogView(reader, first, spp, channel);
+                redraw = false;
+            }
+            
+            if (touch->getTouches() > 0 && millis() - lastTapMs > 250) {
+                lastTapMs = millis();
+                auto p = touch->touchPoints[0];
+                if (p.y < VIEW_BUTTONS_Y - 6) continue;
+                int button = (p.x - 4) / (VIEW_BUTTON_W + 3);
+                uint32_t half = spp * (LCD_WIDTH / 2);
+                uint32_t center = first + half;
+                if (button <= 0) {
+                    break;
+                } else if (button == 1) {
+                    first = first > half ? first - half : 0;
+                } else if (button == 2) {
+                    if (first + half < total) first += half;
+                } else if (button == 3 && spp < fullSpp) {
+                    spp = spp * 2 < fullSpp ? spp * 2 : fullSpp;
+                } else if (button == 4 && spp > 1) {
+                    spp /= 2;
+                } else if (button == 5) {
+                    channel = (channel + 1) % LOG_PYRAMID_CHANNELS;
+                } else {
+                    continue;
+                }
+                // Zoom attorno al centro dello schermo
+                if (button == 3 || button == 4) {
+                    uint32_t newHalf = spp * (LCD_WIDTH / 2);
+                    first = center > newHalf ? center - newHalf : 0;
+                }
+                if (first >= total) first = total - 1;
+                redraw = true;
+            }
+            waitUIEvent(UI_EVENT_TOUCH, 100);
+        }
+        delay(200);     // Debounce
+    }
+    
+    // === ACQUISIZIONE ===
+    // Elenco delle ultime sessioni dal catalogo su SD (log_format.h), tocco
+    // su una riga = viewer; REC registra (data_logger.h) finché non si tocca
+    // STOP e torna all'elenco.
+    static const int LIST_Y = 34;
+    static const int LIST_ROW_H = 38;
+    static const uint16_t LIST_ROWS = 6;
+    
+    static void drawLogStats(const DataLogStats &s) {
+        gfx->fillRect(0, 60, LCD_WIDTH, 160, BLACK);
+        gfx->setTextSize(2);
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(10, 70);
+        gfx->printf("/log_%03u", s.session);
+        gfx->setCursor(10, 100);
+        gfx->printf("%lu rec", (unsigned long)s.records);
+        gfx->setCursor(10, 130);
+        gfx->printf("%lu:%02lu  %luKB", (unsigned long)(s.duration_ms / 60000),
+                    (unsigned long)(s.duration_ms / 1000 % 60), (unsigned long)(s.bytes / 1024));
+        gfx->setTextSize(1);
+        gfx->setCursor(10, 165);
+        gfx->printf("Piramide L1 %lu  L3 %lu  L5 %lu bin", (unsigned long)s.bins[0],
+                    (unsigned long)s.bins[2], (unsigned long)s.bins[4]);
+        gfx->setCursor(10, 180);
+        gfx->printf("Persi %lu  flush max %lums", (unsigned long)s.dropped,
+                    (unsigned long)(s.max_flush_us / 1000));
     }
     
-    void exportCSV() {
-        Serial.println("💾 Exporting to CSV...");
+    static void recordSession() {
+        DataLogStats s;
+        if (!startDataLogging()) {
+            getDataLogStats(s);
+            Serial.printf("❌ Acquisition: %s\n", dataLogErrorName(s.error));
+            showMessage(gfx, dataLogErrorName(s.error), RED, BLACK);
+            delay(1500);
+            return;
+        }
         
-        // TODO: Implementare export
-        // - Aprire file su SD
-        // - Scrivere header CSV
-        // - Scrivere dati buffer
+        gfx->fillScreen(BLACK);
+        gfx->setTextColor(RED);
+        gfx->setTextSize(3);
+        gfx->setCursor(60, 20);
+        gfx->print("REC");
+        drawButton(BACK_X, BACK_Y, 200, BACK_H, RED, "STOP", 2);
+        
+        uint32_t lastTapMs = millis();
+        while (isDataLogging()) {
+            getDataLogStats(s);
+            drawLogStats(s);
+            if (touch->getTouches() > 0 && millis() - lastTapMs > 300) {
+                auto p = touch->touchPoints[0];
+                if (p.y >= BACK_Y - 10) break;
+            }
+            waitUIEvent(UI_EVENT_TOUCH, 500);
+        }
+        
+        stopDataLogging();
+        getDataLogStats(s);
+        printDataLogStats();
+        if (s.state == DATA_LOG_ERROR) {
+            showMessage(gfx, dataLogErrorName(s.error), RED, BLACK);
+            delay(1500);
+        }
+        delay(200);     // Debounce: il tocco su STOP non arriva all'elenco
+    }
+    
+    static uint16_t drawLogList(LogCatalogEntry *list) {
+        uint32_t t0 = micros();
+        uint16_t n = readLogCatalog(list, LIST_ROWS);
+        uint32_t readUs = micros() - t0;
         
         gfx->fillScreen(BLACK);
-        gfx->setTextColor(GREEN);
-        gfx->setCursor(50, 150);
-        gfx->println("Exporting...");
+        gfx->setTextSize(2);
+        gfx->setTextColor(CYAN);
+        gfx->setCursor(8, 8);
+        gfx->print("LOG");
+        gfx->setTextSize(1);
+        gfx->setTextColor(DARKGREY);
+        gfx->setCursor(70, 12);
+        gfx->printf("catalogo %lu.%lums", (unsigned long)(readUs / 1000), (unsigned long)(readUs / 100 % 10));
         
-        delay(2000);
+        for (uint16_t i = 0; i < n; i++) {
+            const LogCatalogEntry &e = list[i];
+            int y = LIST_Y + i * LIST_ROW_H;
+            bool open = e.state == LOG_SESSION_OPEN;
+            char t[16];
+            formatLogTime(t, sizeof(t), e.end_us > e.start_us ? e.end_us - e.start_us : 0);
+            gfx->drawRect(2, y, LCD_WIDTH - 4, LIST_ROW_H - 4, DARKGREY);
+            gfx->setTextSize(2);
+            gfx->setTextColor(e.state == LOG_SESSION_FAILED ? RED : WHITE);
+            gfx->setCursor(8, y + 4);
+            gfx->printf("%03u%s %s", e.session, open ? "*" : " ", t);
+            gfx->setTextSize(1);
+            gfx->setTextColor(WHITE);
+            gfx->setCursor(8, y + 22);
+            if (open) {
+                gfx->print("interrotta: dati fino all'ultimo flush");
+            } else {
+                gfx->printf("%lu rec  %ld..%ld mm", (unsigned long)e.records,
+                            (long)(e.dist_min_um / RECORD_UM_PER_MM), (long)(e.dist_max_um / RECORD_UM_PER_MM));
+            }
+        }
+        if (n == 0) {
+            gfx->setTextSize(2);
+            gfx->setTextColor(DARKGREY);
+            gfx->setCursor(40, 120);
+            gfx->print("Nessun log");
+        }
+        
+        drawButton(4, VIEW_BUTTONS_Y, 112, VIEW_BUTTON_H, ORANGE, "BACK", 2);
+        drawButton(124, VIEW_BUTTONS_Y, 112, VIEW_BUTTON_H, RED, "REC", 2);
+        Serial.printf("📂 Log list: %u sessioni in %lu us\n", n, (unsigned long)readUs);
+        return n;
+    }
+    
+    void startDataAcquisition() {
+        Serial.println("🔵 Starting data acquisition...");
+        actionRunning = true;
+        
+        LogCatalogEntry list[LIST_ROWS];
+        uint16_t n = drawLogList(list);
+        uint32_t lastTapMs = millis();
         
-        gfx->setCursor(50, 180);
-        gfx->println("Complete!");
-        delay(1000);
+        while (1) {
+            if (touch->getTouches() > 0 && millis() - lastTapMs > 300) {
+                lastTapMs = millis();
+                auto p = touch->touchPoints[0];
+                if (p.y >= VIEW_BUTTONS_Y - 6) {
+                    if (p.x < LCD_WIDTH / 2) break;
+                    recordSession();
+                } else if (p.y >= LIST_Y && (p.y - LIST_Y) / LIST_ROW_H < n) {
+                    showLogViewer(list[(p.y - LIST_Y) / LIST_ROW_H].session);
+                } else {
+                    continue;
+                }
+                n = drawLogList(list);
+                lastTapMs = millis();
+            }
+            waitUIEvent(UI_EVENT_TOUCH, 100);
+        }
+        
+        delay(200);     // Debounce
+        actionRunning = false;
+        Serial.println("✅ Acquisition complete");
+    }
+    
+    // Barra di avanzamento dell'export (callback di cloud_export)
+    static void drawExportProgress(uint32_t done, uint32_t total) {
+        gfx->fillRect(20, 150, (int)(200ULL * done / total), 16, GREEN);
+    }
+
+    // Export della nuvola di punti in PLY binario su SD
+    void exportPointCloud() {
+        Serial.println("💾 Exporting point cloud to PLY...");
+
+        PointCloudStats stats;
+        getPointCloudStats(stats);
+
+        gfx->fillScreen(BLACK);
+        gfx->setTextColor(YELLOW);
+        gfx->setTextSize(3);
+        gfx->setCursor(30, 40);
+        gfx->println("EXPORT PLY");
+        gfx->setTextSize(2);
+        gfx->setTextColor(WHITE);
+        gfx->setCursor(20, 110);
+        gfx->printf("%lu punti", (unsigned long)stats.count);
+        gfx->drawRect(19, 149, 202, 18, WHITE);
+
+        CloudExportResult r;
+        exportPointCloudToSD(POINT_EXPORT_PLY, r, drawExportProgress);
+        printCloudExport(r);
+
+        gfx->setCursor(20, 190);
+        if (r.status == CLOUD_EXPORT_OK) {
+            gfx->setTextColor(GREEN);
+            gfx->println(r.path);
+            gfx->setTextSize(1);
+            gfx->setCursor(20, 215);
+            gfx->printf("%lu KB in %lums", (unsigned long)(r.bytes / 1024), (unsigned long)r.duration_ms);
+        } else {
+            gfx->setTextColor(RED);
+            gfx->println(cloudExportStatusName(r.status));
+        }
+        delay(2000);
     }
     
     // === SUBMENU 2: CALIB. IMU ===
     
+    // Pulsante CANCEL comune alle calibrazioni
+    static void drawCalibrationCancel() {
+        gfx->fillRect(70, 250, 100, 40, RED);
+        gfx->drawRect(70, 250, 100, 40, WHITE);
+        gfx->setCursor(95, 265);
+        gfx->setTextSize(2);
+        gfx->setTextColor(WHITE);
+        gfx->println("CANCEL");
+    }
+    
+    static bool calibrationCancelTouched() {
+        if (touch->getTouches() == 0) return false;
+        auto p = touch->touchPoints[0];
+        return p.x >= 70 && p.x <= 170 && p.y >= 250 && p.y <= 290;
+    }
+    
+    static void drawCalibrationProgress(float progress) {
+        gfx->fillRect(20, 200, (int)(200 * progress), 20, GREEN);
+        gfx->drawRect(20, 200, 200, 20, WHITE);
+        gfx->fillRect(90, 225, 60, 12, BLACK);
+        gfx->setCursor(105, 227);
+        gfx->setTextSize(1);
+        gfx->setTextColor(WHITE);
+        gfx->printf("%.0f%%", progress * 100);
+    }
+    
+    // Attende la convergenza: i campioni li elabora il task sensori, qui
+    // solo il ridisegno a 10Hz. Ritorna lo stato finale.
+    static IMUCalState runIMUCalibrationScreen(IMUCalMode mode, void (*drawStatus)(const IMUCalStatus &)) {
+        if (!startIMUCalibration(mode)) return IMU_CAL_FAILED;
+        drawCalibrationCancel();
+        
+        IMUCalStatus status;
+        while (true) {
+            getIMUCalibrationStatus(status);
+            if (status.state != IMU_CAL_RUNNING) break;
+            
+            drawStatus(status);
+            drawCalibrationProgress(status.progress);
+            
+            if (calibrationCancelTouched()) {
+                Serial.println("Calibration cancelled");
+                cancelIMUCalibration();
+                return IMU_CAL_IDLE;
+            }
+            waitForTouch(100);
+        }
+        return status.state;
+    }
+    
+    static void showCalibrationResult(IMUCalState state, const char *detail) {
+        gfx->fillRect(20, 240, 200, 60, BLACK);
+        gfx->setCursor(60, 250);
+        gfx->setTextSize(2);
+        gfx->setTextColor(state == IMU_CAL_DONE ? GREEN : RED);
+        gfx->println(state == IMU_CAL_DONE ? "COMPLETE!" : state == IMU_CAL_IDLE ? "CANCELLED" : "FAILED");
+        gfx->fillRect(20, 280, 200, 20, BLACK);
+        gfx->setCursor(20, 285);
+        gfx->setTextSize(1);
+        gfx->setTextColor(WHITE);
+        gfx->print(detail);
+        
+        delay(1500);
+        setCurrentMenuState(SUBMENU_2);
+        // Ridisegna menu dopo calibrazione
+        drawMenu(gfx, ui, SUBMENU_2);
+    }
+    
+    static void drawGyroStatus(const IMUCalStatus &status) {
+        gfx->fillRect(20, 150, 200, 12, BLACK);
+        gfx->setCursor(20, 150);
+        gfx->setTextSize(1);
+        gfx->setTextColor(status.still ? GREEN : YELLOW);
+        gfx->println(status.still ? "Still - measuring bias" : "Motion detected - hold still");
+    }
+    
+    static void drawAccelStatus(const IMUCalStatus &status) {
+        // Sei caselle: verde = acquisita, giallo = in corso
+        for (int f = 0; f < ACCEL_CAL_FACES; f++) {
+            int x = 20 + f * 34;
+            uint16_t color = (status.faces_done & (1u << f)) ? GREEN :
+                             (f == status.face ? YELLOW : DARKGREY);
+            gfx->fillRect(x, 160, 30, 24, color);
+            gfx->setCursor(x + 8, 168);
+            gfx->setTextSize(1);
+            gfx->setTextColor(BLACK);
+            gfx->print(accelFaceName(f));
+        }
+    }
+    
     void calibrateGyro() {
         Serial.println("🔧 Calibrating Gyroscope...");
         
@@ -221,25 +1028,22 @@ namespace LeafActions {
         gfx->setTextSize(2);
         gfx->println("GYRO CALIBRATION");
         
-        gfx->setCursor(20, 150);
+        gfx->setCursor(20, 130);
         gfx->setTextSize(1);
-        gfx->println("Keep device still for 5 sec");
+        gfx->println("Keep device still");
         
-        // Progress bar
-        for (int i = 0; i <= 100; i += 20) {
-            gfx->fillRect(20, 180, i * 2, 20, GREEN);
-            gfx->drawRect(20, 180, 200, 20, WHITE);
-            delay(1000);
-        }
+        IMUCalState state = runIMUCalibrationScreen(IMU_CAL_MODE_GYRO, drawGyroStatus);
         
-        gfx->setCursor(70, 220);
-        gfx->setTextColor(GREEN);
-        gfx->println("COMPLETE!");
-        
-        delay(1500);
-        setCurrentMenuState(SUBMENU_2);
-        // Ridisegna menu dopo calibrazione
-        drawMenu(gfx, ui, SUBMENU_2);
+        IMUCalStatus status;
+        getIMUCalibrationStatus(status);
+        char detail[40];
+        if (state == IMU_CAL_DONE) {
+            snprintf(detail, sizeof(detail), "Bias %.2f %.2f %.2f dps", status.gyro_bias_dps[0],
+                     status.gyro_bias_dps[1], status.gyro_bias_dps[2]);
+        } else {
+            snprintf(detail, sizeof(detail), "Previous bias kept");
+        }
+        showCalibrationResult(state, detail);
     }
     
     void calibrateAccel() {
@@ -251,20 +1055,22 @@ namespace LeafActions {
         gfx->setTextSize(2);
         gfx->println("ACCEL CALIBRATION");
         
-        gfx->setCursor(20, 150);
+        gfx->setCursor(20, 130);
         gfx->setTextSize(1);
-        gfx->println("Place on flat surface");
+        gfx->println("Rest on each of 6 faces");
         
-        delay(3000);
+        IMUCalState state = runIMUCalibrationScreen(IMU_CAL_MODE_ACCEL, drawAccelStatus);
         
-        gfx->setCursor(70, 220);
-        gfx->setTextColor(GREEN);
-        gfx->println("COMPLETE!");
-        
-        delay(1500);
-        setCurrentMenuState(SUBMENU_2);
-        // Ridisegna menu dopo calibrazione
-        drawMenu(gfx, ui, SUBMENU_2);
+        IMUCalStatus status;
+        getIMUCalibrationStatus(status);
+        char detail[40];
+        if (state == IMU_CAL_DONE) {
+            snprintf(detail, sizeof(detail), "Scale %.3f %.3f %.3f", status.accel_scale[0],
+                     status.accel_scale[1], status.accel_scale[2]);
+        } else {
+            snprintf(detail, sizeof(detail), "Previous values kept");
+        }
+        showCalibrationResult(state, detail);
     }
     
     void calibrateMag() {
@@ -280,17 +1086,13 @@ namespace LeafActions {
         gfx->setTextSize(1);
         gfx->println("Rotate device in all");
         gfx->setCursor(20, 150);
-        gfx->println("directions for 20 sec");
+        gfx->println("directions (max 20 sec)");
         
         // Avvia calibrazione IMU
         startMagCalibration();
         
         // Progress con Cancel button
-        gfx->fillRect(70, 250, 100, 40, RED);
-        gfx->drawRect(70, 250, 100, 40, WHITE);
-        gfx->setCursor(95, 265);
-        gfx->setTextSize(2);
-        gfx->println("CANCEL");
+        drawCalibrationCancel();
         
         // Mostra progresso
         while (isMagCalibrationInProgress()) {
@@ -309,24 +1111,47 @@ namespace LeafActions {
             gfx->printf("%.0f%%", progress * 100);
             
             // Check per CANCEL
-            if (touch->getTouches() > 0) {
-                auto p = touch->touchPoints[0];
-                if (p.x >= 70 && p.x <= 170 && p.y >= 250 && p.y <= 290) {
-                    Serial.println("Calibration cancelled");
-                    break;
-                }
+            if (calibrationCancelTouched()) {
+                Serial.println("Calibration cancelled");
+                break;
             }
             
-            delay(100);
+            // Aggiorna la barra a 10Hz, risveglio anticipato su touch o fine calibrazione
+            waitUIEvent(UI_EVENT_TOUCH | UI_EVENT_MAG_CAL, 100);
         }
         
-        finishMagCalibration();
+        // Fine anticipata (CANCEL): il fit usa quanto raccolto finora e lo
+        // chiude il task sensori, che segnala UI_EVENT_MAG_CAL
+        if (isMagCalibrationInProgress()) {
+            finishMagCalibration();
+            uint32_t start = millis();
+            while (isMagCalibrationInProgress()) {
+                uint32_t elapsed = millis() - start;
+                if (elapsed >= MAG_CAL_FINISH_WAIT_MS) break;
+                waitUIEvent(UI_EVENT_MAG_CAL, MAG_CAL_FINISH_WAIT_MS - elapsed);
+            }
+            // IMU sospesa, nessun campione: resta la calibrazione precedente
+            if (isMagCalibrationInProgress()) abortMagCalibration();
+        }
+        
+        MagFitResult fit;
+        bool ok = getMagCalibrationResult(fit);
         
         gfx->fillRect(20, 240, 200, 60, BLACK);
         gfx->setCursor(70, 250);
-        gfx->setTextColor(GREEN);
+        gfx->setTextColor(ok ? GREEN : RED);
         gfx->setTextSize(2);
-        gfx->println("COMPLETE!");
+        gfx->println(ok ? "COMPLETE!" : "FAILED");
+        
+        gfx->fillRect(20, 280, 200, 20, BLACK);
+        gfx->setCursor(20, 285);
+        gfx->setTextSize(1);
+        gfx->setTextColor(WHITE);
+        if (ok) {
+            gfx->printf("Res %.1f uT  Cov %.0f%%", fit.residual_ut, fit.coverage * 100);
+        } else {
+            gfx->printf("Cov %.0f%% - rotate more", fit.coverage * 100);
+        }
         
         delay(1500);
         setCurrentMenuState(SUBMENU_2);
@@ -374,13 +1199,105 @@ namespace LeafActions {
                     break;
                 }
             }
-            delay(50);
+            waitForTouch(UI_IDLE_TIMEOUT_MS);
         }
         
         // Ridisegna menu service
         drawMenu(gfx, ui, SUBMENU_3);
     }
     
+    // === SYSTEM INFO ===
+    // Parte fissa disegnata una volta; le righe del monitor (system_monitor_service.h)
+    // si ridisegnano a ogni nuova fotografia, una fascia alla volta
+    #define SYS_LIVE_Y      88
+    #define SYS_LINE_H      14
+    
+    static SystemSnapshot sysSnapshot;      // Statica: ~1.1KB fuori dallo stack del loop
+    
+    static uint16_t gradeColor(uint8_t grade) {
+        static const uint16_t colors[] = {GREEN, YELLOW, ORANGE, RED};
+        return grade <= SYSMON_GRADE_CRIT ? colors[grade] : WHITE;
+    }
+    
+    static void drawSysLine(uint8_t line, uint16_t color, const char *text) {
+        int y = SYS_LIVE_Y + line * SYS_LINE_H;
+        gfx->fillRect(0, y, LCD_WIDTH, SYS_LINE_H - 2, BLACK);
+        gfx->setTextSize(1);
+        gfx->setTextColor(color);
+        gfx->setCursor(20, y);
+        gfx->print(text);
+    }
+    
+    static const SysMonTask *findSysTask(const SystemSnapshot &s, const char *name) {
+        for (uint8_t i = 0; i < s.task_count; i++) {
+            if (strncmp(s.tasks[i].name, name, SYSMON_NAME_LEN) == 0) return &s.tasks[i];
+        }
+        return nullptr;
+    }
+    
+    static void drawSystemLive(const SystemSnapshot &s) {
+        char text[48];
+        uint8_t line = 0;
+        
+        if (s.runtime_stats) {
+            snprintf(text, sizeof(text), "CPU %.1f%%  avg %.1f%%  peak %.1f%%",
+                     s.cpu_permille / 10.0f, s.cpu_avg_permille / 10.0f, s.cpu_peak_permille / 10.0f);
+            uint8_t grade = sysmonGrade(s.cpu_avg_permille, SYSMON_CPU_AVG_TARGET,
+                                        SYSMON_CPU_AVG_ACCEPT, SYSMON_CPU_AVG_CRIT);
+            uint8_t peak = sysmonGrade(s.cpu_peak_permille, SYSMON_CPU_PEAK_TARGET,
+                                       SYSMON_CPU_PEAK_ACCEPT, SYSMON_CPU_PEAK_CRIT);
+            drawSysLine(line++, gradeColor(grade > peak ? grade : peak), text);
+            snprintf(text, sizeof(text), "Core0 %.1f%%  Core1 %.1f%%",
+                     s.core_permille[0] / 10.0f, s.core_permille[1] / 10.0f);
+            drawSysLine(line++, WHITE, text);
+        } else {
+            drawSysLine(line++, DARKGREY, "CPU: run-time stats non attive");
+            drawSysLine(line++, WHITE, "");
+        }
+        
+        snprintf(text, sizeof(text), "Heap %luKB  min %luKB",
+                 (unsigned long)(s.free_heap / 1024), (unsigned long)(s.min_free_heap / 1024));
+        drawSysLine(line++, gradeColor(sysmonGradeAbove(s.min_free_heap / 1024, SYSMON_HEAP_TARGET_KB,
+                                                        SYSMON_HEAP_ACCEPT_KB, SYSMON_HEAP_CRIT_KB)), text);
+        snprintf(text, sizeof(text), "Blocco %luKB  frag %.1f%%",
+                 (unsigned long)(s.largest_block / 1024), s.frag_permille / 10.0f);
+        drawSysLine(line++, gradeColor(sysmonGrade(s.frag_permille, SYSMON_FRAG_TARGET,
+                                                   SYSMON_FRAG_ACCEPT, SYSMON_FRAG_CRIT)), text);
+        
+        // Stack dei task che contano per la UI e l'acquisizione
+        static const char *watched[] = {"SensorTask", "loopTask", "Logger"};
+        for (const char *name : watched) {
+            const SysMonTask *t = findSysTask(s, name);
+            if (t) {
+                snprintf(text, sizeof(text), "Stack %-10s %.1f%%  cpu %.1f%%", name,
+                         t->stack_used_permille / 10.0f, t->load_permille / 10.0f);
+                drawSysLine(line++, gradeColor(sysmonGrade(t->stack_used_permille, SYSMON_STACK_TARGET,
+                                                           SYSMON_STACK_ACCEPT, SYSMON_STACK_CRIT)), text);
+            } else {
+                snprintf(text, sizeof(text), "Stack %-10s --", name);
+                drawSysLine(line++, DARKGREY, text);
+            }
+        }
+        snprintf(text, sizeof(text), "Peggiore %s %.1f%%", s.stack_worst_name,
+                 s.stack_worst_permille / 10.0f);
+        drawSysLine(line++, gradeColor(sysmonGrade(s.stack_worst_permille, SYSMON_STACK_TARGET,
+                                                   SYSMON_STACK_ACCEPT, SYSMON_STACK_CRIT)), text);
+        
+        snprintf(text, sizeof(text), "Topic lag %lu  coda I2C %u",
+                 (unsigned long)s.topic_lag, s.i2c_pending);
+        drawSysLine(line++, WHITE, text);
+        
+        TaskStats stats;
+        getSensorTaskStats(stats);
+        snprintf(text, sizeof(text), "Samples %lu  Bus err %lu",
+                 (unsigned long)stats.samples_acquired, (unsigned long)stats.bus_failures);
+        drawSysLine(line++, WHITE, text);
+        
+        snprintf(text, sizeof(text), "%u task  monitor %luus  up %lus", s.task_count,
+                 (unsigned long)s.sample_us, (unsigned long)(s.uptime_ms / 1000));
+        drawSysLine(line++, DARKGREY, text);
+    }
+    
     void showSystemInfo() {
         Serial.println("ℹ️ System Information");
         
@@ -391,54 +1308,19 @@ namespace LeafActions {
         gfx->println("SYSTEM INFO");
         
         gfx->setTextSize(1);
-        gfx->setCursor(20, 60);
-        gfx->println("HySeq Plus v1.0");
-        
-        gfx->setCursor(20, 80);
-        gfx->printf("Free Heap: %d KB", ESP.getFreeHeap() / 1024);
-        
-        gfx->setCursor(20, 100);
-        gfx->printf("CPU Freq: %d MHz", ESP.getCpuFreqMHz());
-        
-        gfx->setCursor(20, 120);
-        gfx->printf("Flash: %d MB", ESP.getFlashChipSize() / 1048576);
+        gfx->setCursor(20, 50);
+        gfx->printf("HySeq Plus v1.0  %d MHz  Flash %d MB",
+                    ESP.getCpuFreqMHz(), ESP.getFlashChipSize() / 1048576);
         
         // Stato sensori
-        gfx->setCursor(20, 150);
+        gfx->setCursor(20, 68);
         gfx->print("IMU: ");
         gfx->setTextColor(isIMUReady() ? GREEN : RED);
-        gfx->println(isIMUReady() ? "OK" : "ERROR");
-        
+        gfx->print(isIMUReady() ? "OK" : "ERROR");
         gfx->setTextColor(WHITE);
-        gfx->setCursor(20, 170);
-        gfx->print("Radar: ");
+        gfx->print("   Radar: ");
         gfx->setTextColor(isRadarReady() ? GREEN : RED);
-        gfx->println(isRadarReady() ? "OK" : "ERROR");
-        
-        // Test sensori in tempo reale
-        gfx->setTextColor(WHITE);
-        gfx->setCursor(20, 190);
-        gfx->println("--- Live Sensor Data ---");
-        
-        if (isIMUReady()) {
-            gfx->setCursor(20, 210);
-            gfx->printf("Pitch: %.1f  Yaw: %.1f", getIMUPitch(), getIMUYaw());
-        }
-        
-        if (isRadarReady()) {
-            gfx->setCursor(20, 230);
-            gfx->printf("Distance: %.0f mm", getFilteredRadarDistance());
-        }
-        
-        // Statistiche
-        #ifdef USE_FREERTOS
-        TaskStats stats;
-        getSensorTaskStats(stats);
-        
-        gfx->setTextColor(WHITE);
-        gfx->setCursor(20, 250);
-        gfx->printf("Samples: %d", stats.samples_acquired);
-        #endif
+        gfx->print(isRadarReady() ? "OK" : "ERROR");
         
         // Back button
         gfx->fillRect(80, 270, 80, 35, ORANGE);
@@ -448,8 +1330,15 @@ namespace LeafActions {
         gfx->setTextColor(WHITE);
         gfx->println("BACK");
         
-        // Attendi back
+        // Attendi back, ridisegnando a ogni nuova fotografia del monitor
+        uint32_t lastSeq = UINT32_MAX;
         while (true) {
+            getSystemSnapshot(sysSnapshot);
+            if (sysSnapshot.seq != lastSeq) {
+                lastSeq = sysSnapshot.seq;
+                drawSystemLive(sysSnapshot);
+            }
+            
             if (touch->getTouches() > 0) {
                 auto p = touch->touchPoints[0];
                 if (p.x >= 80 && p.x <= 160 && p.y >= 270 && p.y <= 305) {
@@ -457,7 +1346,7 @@ namespace LeafActions {
                     break;
                 }
             }
-            delay(50);
+            waitForTouch(SYSMON_PERIOD_MS / 4);
         }
         
         // Ridisegna menu service
@@ -512,7 +1401,7 @@ namespace LeafActions {
                     break;
                 }
             }
-            delay(50);
+            waitForTouch(UI_IDLE_TIMEOUT_MS);
         }
         
         if (confirmed) {
@@ -523,15 +1412,10 @@ namespace LeafActions {
             gfx->setCursor(50, 120);
             gfx->println("RESETTING...");
             
-            // Cancella EEPROM
-            EEPROM.begin(512);
-            for (int i = 0; i < 512; i++) {
-                EEPROM.write(i, 0xFF);
+            // Cancella configurazione NVS (calibrazione + tuning)
+            if (!factoryResetConfig()) {
+                Serial.println("❌ Reset configurazione fallito");
             }
-            EEPROM.commit();
-            
-            // Reset preferenze
-            // TODO: Reset altre impostazioni
             
             gfx->setCursor(40, 160);
             gfx->println("COMPLETE!");
@@ -11,7 +11,7 @@ namespace LeafActions {
     void startDataAcquisition();
     void showLiveData();
     void showLiveGraph();
-    void exportCSV();
+    void exportPointCloud();
     
     // === SUBMENU 2: CALIB. IMU ===
     void calibrateGyro();
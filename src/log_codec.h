@@ -0,0 +1,354 @@
+// log_codec.h
+// Compressione a blocchi dei SensorRecord nei log di sessione: per ogni
+// campo quantizzato il delta dal record precedente (delta del delta per il
+// timestamp, XOR per flag e versione), zigzag e varint. A 10-100Hz i campi
+// cambiano di poco fra due campioni e il record da 32 byte scende a ~10-14.
+//
+// Ogni blocco (header + payload) si decodifica da solo: il primo record è
+// codificato contro zero, nessuno stato passa da un blocco all'altro. Il
+// CRC copre header e payload: un blocco scritto a metà (reset) o rovinato
+// si scarta senza perdere gli altri.
+//
+// Codifica incrementale (un record alla volta, nessun buffer di colonne) e
+// decodifica senza allocazioni. Nel file dei record (log_format.h) i blocchi
+// sono in fila e l'indice ha una voce per blocco: LogRecordFile qui sotto
+// legge record e cerca per tempo allo stesso modo su device e host.
+// Header puro C++.
+#ifndef LOG_CODEC_H
+#define LOG_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "sensor_record.h"
+#include "log_format.h"
+
+#define LOG_BLOCK_MAGIC             0x4B4C4248u   // "HBLK" in little endian
+#define LOG_BLOCK_RECORDS           128           // 12.8s a 10Hz, 1.28s a 100Hz
+#define LOG_CODEC_MAX_RECORD_BYTES  42            // Caso peggiore: 10 + 4x5 + 4x3
+#define LOG_BLOCK_MAX_PAYLOAD       (LOG_BLOCK_RECORDS * LOG_CODEC_MAX_RECORD_BYTES)
+
+struct LogBlockHeader {
+    uint32_t magic;
+    uint32_t first_record;      // Indice nella sessione del primo record
+    uint16_t records;           // 1..LOG_BLOCK_RECORDS
+    uint16_t payload_bytes;
+    uint32_t crc;               // CRC32 dei 12 byte precedenti e del payload
+};
+
+static_assert(sizeof(LogBlockHeader) == 16, "LogBlockHeader: 16 byte");
+static_assert(LOG_BLOCK_MAX_PAYLOAD <= 0xFFFF, "payload_bytes a 16 bit");
+
+// === VARINT ===
+inline uint64_t logZigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t logUnzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+inline uint8_t *logPutVarint(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// NULL se il varint esce dal payload o supera 10 byte
+inline const uint8_t *logGetVarint(const uint8_t *p, const uint8_t *end, uint64_t &v) {
+    if (p < end && *p < 0x80) {             // Caso comune: un byte
+        v = *p;
+        return p + 1;
+    }
+    v = 0;
+    for (uint8_t shift = 0; p < end && shift < 70; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (b < 0x80) return p;
+    }
+    return NULL;
+}
+
+// === STATO DEL DELTA ===
+// Comune a encoder e decoder: il record precedente e l'ultimo passo del
+// timestamp. Azzerato all'inizio di ogni blocco.
+struct LogCodecState {
+    uint64_t timestamp_us;
+    uint64_t step_us;
+    SensorRecord prev;
+
+    void reset() { memset(this, 0, sizeof(*this)); }
+};
+
+// Un record in coda a p (al più LOG_CODEC_MAX_RECORD_BYTES)
+inline uint8_t *logEncodeRecord(LogCodecState &s, const SensorRecord &r, uint8_t *p) {
+    const SensorRecord &q = s.prev;
+    uint64_t step = r.timestamp_us - s.timestamp_us;            // Aritmetica modulo 2^64: senza perdite
+    p = logPutVarint(p, logZigzag((int64_t)(step - s.step_us)));
+    p = logPutVarint(p, logZigzag((int64_t)r.radar_dt_us - q.radar_dt_us));
+    p = logPutVarint(p, logZigzag((int64_t)r.imu_dt_us - q.imu_dt_us));
+    p = logPutVarint(p, logZigzag((int64_t)r.distance_um - q.distance_um));
+    p = logPutVarint(p, logZigzag((int64_t)r.filtered_um - q.filtered_um));
+    p = logPutVarint(p, logZigzag((int32_t)r.pitch_cdeg - q.pitch_cdeg));
+    p = logPutVarint(p, logZigzag((int16_t)(uint16_t)(r.yaw_cdeg - q.yaw_cdeg)));   // Giro 359.99->0: delta piccolo
+    p = logPutVarint(p, logZigzag((int32_t)r.roll_cdeg - q.roll_cdeg));
+    p = logPutVarint(p, (uint32_t)(r.flags ^ q.flags) | (uint32_t)(r.version ^ q.version) << 8);
+    s.timestamp_us = r.timestamp_us;
+    s.step_us = step;
+    s.prev = r;
+    return p;
+}
+
+inline const uint8_t *logDecodeRecord(LogCodecState &s, const uint8_t *p, const uint8_t *end, SensorRecord &r) {
+    uint64_t v[9];
+    for (uint8_t i = 0; i < 9; i++) {
+        p = logGetVarint(p, end, v[i]);
+        if (!p) return NULL;
+    }
+    const SensorRecord &q = s.prev;
+    s.step_us += (uint64_t)logUnzigzag(v[0]);
+    s.timestamp_us += s.step_us;
+    r.timestamp_us = s.timestamp_us;
+    r.radar_dt_us = (int32_t)(q.radar_dt_us + logUnzigzag(v[1]));
+    r.imu_dt_us = (int32_t)(q.imu_dt_us + logUnzigzag(v[2]));
+    r.distance_um = (int32_t)(q.distance_um + logUnzigzag(v[3]));
+    r.filtered_um = (int32_t)(q.filtered_um + logUnzigzag(v[4]));
+    r.pitch_cdeg = (int16_t)(q.pitch_cdeg + logUnzigzag(v[5]));
+    r.yaw_cdeg = (uint16_t)(q.yaw_cdeg + logUnzigzag(v[6]));
+    r.roll_cdeg = (int16_t)(q.roll_cdeg + logUnzigzag(v[7]));
+    r.flags = q.flags ^ (uint8_t)v[8];
+    r.version = q.version ^ (uint8_t)(v[8] >> 8);
+    s.prev = r;
+    return p;
+}
+
+// === BLOCCHI ===
+// CRC32 come configCrc32() ma con tabella da 256 voci: un accesso per byte
+// invece di due, è il costo principale della decodifica
+inline uint32_t logCrc32(const void *data, size_t len, uint32_t crc = 0) {
+    static const uint32_t table[256] = {
+        0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F, 0xE963A535, 0x9E6495A3,
+        0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988, 0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91,
+        0x1DB71064, 0x6AB020F2, 0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+        0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9, 0xFA0F3D63, 0x8D080DF5,
+        0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172, 0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B,
+        0x35B5A8FA, 0x42B2986C, 0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+        0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423, 0xCFBA9599, 0xB8BDA50F,
+        0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924, 0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D,
+        0x76DC4190, 0x01DB7106, 0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+        0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D, 0x91646C97, 0xE6635C01,
+        0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E, 0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457,
+        0x65B0D9C6, 0x12B7E950, 0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+        0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7, 0xA4D1C46D, 0xD3D6F4FB,
+        0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0, 0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9,
+        0x5005713C, 0x270241AA, 0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+        0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81, 0xB7BD5C3B, 0xC0BA6CAD,
+        0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A, 0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683,
+        0xE3630B12, 0x94643B84, 0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+        0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB, 0x196C3671, 0x6E6B06E7,
+        0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC, 0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5,
+        0xD6D6A3E8, 0xA1D1937E, 0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+        0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55, 0x316E8EEF, 0x4669BE79,
+        0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236, 0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F,
+        0xC5BA3BBE, 0xB2BD0B28, 0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+        0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F, 0x72076785, 0x05005713,
+        0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38, 0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21,
+        0x86D3D2D4, 0xF1D4E242, 0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+        0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69, 0x616BFFD3, 0x166CCF45,
+        0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2, 0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB,
+        0xAED16A4A, 0xD9D65ADC, 0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+        0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693, 0x54DE5729, 0x23D967BF,
+        0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94, 0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+    };
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline uint32_t logBlockCrc(const LogBlockHeader &h, const uint8_t *payload) {
+    return logCrc32(payload, h.payload_bytes, logCrc32(&h, offsetof(LogBlockHeader, crc)));
+}
+
+inline bool logBlockHeaderValid(const LogBlockHeader &h) {
+    return h.magic == LOG_BLOCK_MAGIC && h.records > 0 && h.records <= LOG_BLOCK_RECORDS &&
+           h.payload_bytes <= LOG_BLOCK_MAX_PAYLOAD;
+}
+
+// Blocco in costruzione: header e payload contigui, pronti da scrivere
+class LogBlockEncoder {
+public:
+    void begin(uint32_t firstRecord) {
+        header().magic = LOG_BLOCK_MAGIC;
+        header().first_record = firstRecord;
+        header().records = 0;
+        state.reset();
+        end = buf + sizeof(LogBlockHeader);
+    }
+
+    // true quando il blocco è pieno (da chiudere con seal())
+    bool add(const SensorRecord &r) {
+        if (header().records == 0) first = r.timestamp_us;
+        end = logEncodeRecord(state, r, end);
+        return ++header().records == LOG_BLOCK_RECORDS;
+    }
+
+    // Chiude il blocco: byte da scrivere a partire da data()
+    uint32_t seal() {
+        LogBlockHeader &h = header();
+        h.payload_bytes = (uint16_t)(end - buf - sizeof(LogBlockHeader));
+        h.crc = logBlockCrc(h, buf + sizeof(LogBlockHeader));
+        return (uint32_t)(end - buf);
+    }
+
+    const uint8_t *data() const { return buf; }
+    uint16_t records() const { return ((const LogBlockHeader *)buf)->records; }
+    uint32_t firstRecord() const { return ((const LogBlockHeader *)buf)->first_record; }
+    uint64_t firstTimestampUs() const { return first; }     // Per la voce di indice del blocco
+
+private:
+    LogBlockHeader &header() { return *(LogBlockHeader *)buf; }
+
+    alignas(8) uint8_t buf[sizeof(LogBlockHeader) + LOG_BLOCK_MAX_PAYLOAD];
+    uint8_t *end = buf + sizeof(LogBlockHeader);
+    LogCodecState state;
+    uint64_t first = 0;
+};
+
+// Record di un blocco già letto (header valido e CRC verificato dal
+// chiamante con logBlockCrc). false se il payload non torna.
+inline bool logBlockDecode(const LogBlockHeader &h, const uint8_t *payload, SensorRecord *out) {
+    LogCodecState s;
+    s.reset();
+    const uint8_t *p = payload, *end = payload + h.payload_bytes;
+    for (uint16_t i = 0; i < h.records; i++) {
+        p = logDecodeRecord(s, p, end, out[i]);
+        if (!p) return false;
+    }
+    return p == end;
+}
+
+// Lettura di un blocco da un file qualsiasi: readAt(offset, buf, len) ->
+// byte letti (File::seek/read sul device, fseek/fread sull'host). payload
+// almeno LOG_BLOCK_MAX_PAYLOAD byte. false se troncato o rovinato.
+template <typename ReadAt>
+inline bool logBlockLoad(ReadAt readAt, uint64_t offset, LogBlockHeader &h, uint8_t *payload) {
+    return readAt(offset, &h, sizeof(h)) == sizeof(h) && logBlockHeaderValid(h) &&
+           readAt(offset + sizeof(h), payload, h.payload_bytes) == h.payload_bytes &&
+           logBlockCrc(h, payload) == h.crc;
+}
+
+// === FILE DEI RECORD ===
+// Record di una sessione da un .rec a record fissi (LOG_FILE_RECORDS) o a
+// blocchi (LOG_FILE_BLOCKS), con l'indice sparso .idx. La sottoclasse
+// fornisce solo le letture puntuali; payload e block sono buffer del
+// chiamante (LOG_BLOCK_MAX_PAYLOAD byte e LOG_BLOCK_RECORDS record), l'ultimo
+// blocco decodificato resta in block per le letture vicine.
+class LogRecordFile {
+public:
+    virtual ~LogRecordFile() {}
+    // Byte letti a partire da offset
+    virtual uint32_t readRecords(uint64_t offset, void *buf, uint32_t len) = 0;
+    virtual uint32_t readIndex(uint64_t offset, void *buf, uint32_t len) = 0;
+
+    // recBytes/idxBytes: dimensioni dei file (idxBytes = 0 senza indice).
+    // Un file a blocchi senza indice risulta vuoto (ricostruibile con
+    // tools/log_pyramid_cli build).
+    void begin(uint8_t kind, uint64_t recBytes, uint64_t idxBytes, uint8_t *payload, SensorRecord *block) {
+        fileKind = kind;
+        entries = logItemCount(idxBytes, sizeof(LogIndexEntry));
+        payloadBuf = payload;
+        blockBuf = block;
+        cachedEntry = UINT32_MAX;
+        reads = 0;
+        count = 0;
+        if (kind == LOG_FILE_RECORDS) {
+            count = logItemCount(recBytes, sizeof(SensorRecord));
+            return;
+        }
+        // Ultimo blocco indicizzato e integro: un reset può lasciare in coda
+        // un blocco a metà o una voce di indice senza blocco
+        for (uint32_t i = entries; i-- > 0 && count == 0;) {
+            if (loadBlock(i)) count = blockFirst + blockRecords;
+        }
+        entries = count > 0 ? cachedEntry + 1 : 0;
+    }
+
+    uint32_t records() const { return count; }
+
+    // Fino a n record da first in out; record letti
+    uint32_t read(uint32_t first, uint32_t n, SensorRecord *out) {
+        if (first >= count) return 0;
+        if (n > count - first) n = count - first;
+        if (fileKind == LOG_FILE_RECORDS) {
+            reads++;
+            return readRecords(sizeof(LogFileHeader) + (uint64_t)first * sizeof(SensorRecord), out,
+                               n * sizeof(SensorRecord)) / sizeof(SensorRecord);
+        }
+        uint32_t got = 0;
+        while (got < n) {
+            uint32_t record = first + got;
+            uint32_t b = logLowerBound(entries, (uint64_t)record + 1,
+                                       [&](uint32_t i) { return (uint64_t)entryAt(i).record; });
+            if (b == 0 || !loadBlock(b - 1) || record >= blockFirst + blockRecords) break;
+            uint32_t k = blockFirst + blockRecords - record;
+            if (k > n - got) k = n - got;
+            memcpy(out + got, blockBuf + (record - blockFirst), k * sizeof(SensorRecord));
+            got += k;
+        }
+        return got;
+    }
+
+    // Primo record con timestamp >= t (records() se nessuno)
+    uint32_t find(uint64_t t) {
+        if (fileKind == LOG_FILE_RECORDS) {
+            return logFindRecord(entries, [&](uint32_t i) { return entryAt(i); }, count,
+                                 [&](uint32_t i) -> uint64_t {
+                                     SensorRecord r;
+                                     return read(i, 1, &r) == 1 ? r.timestamp_us : UINT64_MAX;
+                                 }, t);
+        }
+        // Blocco che contiene t: l'ultimo che inizia prima di t
+        uint32_t k = logLowerBound(entries, t, [&](uint32_t i) { return entryAt(i).timestamp_us; });
+        if (k == 0) return 0;
+        if (!loadBlock(k - 1)) return count;
+        uint32_t j = logLowerBound(blockRecords, t, [&](uint32_t i) { return blockBuf[i].timestamp_us; });
+        return blockFirst + j;
+    }
+
+    uint32_t reads = 0;         // Letture puntuali dall'ultimo begin()
+
+private:
+    LogIndexEntry entryAt(uint32_t i) {
+        LogIndexEntry e;
+        reads++;
+        if (readIndex(sizeof(LogFileHeader) + (uint64_t)i * sizeof(e), &e, sizeof(e)) != sizeof(e)) {
+            memset(&e, 0xFF, sizeof(e));        // Illeggibile: oltre ogni tempo e record
+        }
+        return e;
+    }
+
+    // Blocco della voce i in block (già lì se è l'ultimo letto)
+    bool loadBlock(uint32_t i) {
+        if (i == cachedEntry) return true;
+        LogIndexEntry e = entryAt(i);
+        LogBlockHeader h;
+        reads++;
+        bool ok = logBlockLoad([&](uint64_t offset, void *buf, uint32_t len) { return readRecords(offset, buf, len); },
+                               e.offset, h, payloadBuf) &&
+                  h.first_record == e.record && logBlockDecode(h, payloadBuf, blockBuf);
+        cachedEntry = ok ? i : UINT32_MAX;
+        blockFirst = h.first_record;
+        blockRecords = ok ? h.records : 0;
+        return ok;
+    }
+
+    uint8_t fileKind = LOG_FILE_RECORDS;
+    uint32_t entries = 0;
+    uint32_t count = 0;
+    uint8_t *payloadBuf = NULL;
+    SensorRecord *blockBuf = NULL;
+    uint32_t cachedEntry = UINT32_MAX;
+    uint32_t blockFirst = 0;
+    uint16_t blockRecords = 0;
+};
+
+#endif // LOG_CODEC_H
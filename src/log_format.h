@@ -0,0 +1,192 @@
+// log_format.h
+// Formato dei file di log su SD, comune a firmware (data_logger.cpp) e tool
+// host (tools/log_pyramid_cli.cpp). Una sessione = un file di record grezzi
+// più un file per livello della piramide di decimazione:
+//
+//   /log_NNN.rec   header + blocchi compressi di SensorRecord (log_codec.h),
+//                  oppure SensorRecord da 32 byte in fila (firmware precedenti,
+//                  tools/log_codec_cli unpack): lo dice il kind dell'header
+//   /log_NNN.p1    header + PyramidBin (40 byte), 1 bin ogni FANOUT record
+//   /log_NNN.pL    1 bin ogni FANOUT^L record
+//   /log_NNN.idx   indice sparso tempo -> record/offset: una voce per blocco,
+//                  o ogni LOG_INDEX_STRIDE record fissi (ricerca binaria, mai
+//                  una scansione)
+//   /logs.cat      catalogo di tutte le sessioni: una voce all'apertura e una
+//                  alla chiusura, la più recente vince. Si legge dalla coda,
+//                  quindi l'elenco delle ultime sessioni costa uguale con 10 o
+//                  1000 log sulla SD.
+//
+// Tutti i file crescono solo in coda: dopo un reset si perde al più l'ultimo
+// buffer, il numero di elementi si ricava dalla dimensione (la coda parziale
+// viene ignorata).
+// Header puro C++.
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "config_schema.h"      // configCrc32
+#include "sensor_record.h"
+
+#define LOG_FILE_MAGIC        0x474C5348u   // "HSLG" in little endian
+#define LOG_FORMAT_VERSION    1
+#define LOG_MAX_SESSIONS      1000          // /log_000 .. /log_999
+#define LOG_PATH_MAX          20
+#define LOG_CATALOG_PATH      "/logs.cat"
+#define LOG_INDEX_STRIDE      256           // Record fissi per voce dell'indice (25.6s a 10Hz)
+
+enum LogFileKind : uint8_t {
+    LOG_FILE_RECORDS = 0,
+    LOG_FILE_PYRAMID,
+    LOG_FILE_INDEX,
+    LOG_FILE_CATALOG,
+    LOG_FILE_BLOCKS             // Record a blocchi compressi (item_bytes = record decodificato)
+};
+
+struct LogFileHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t kind;               // LogFileKind
+    uint8_t level;              // 0 = record grezzi
+    uint8_t fanout;             // Record per bin al livello 1
+    uint16_t item_bytes;        // Dimensione di un elemento
+    uint16_t session;
+    uint64_t start_us;          // Timebase all'apertura della sessione
+    uint8_t reserved[8];
+};
+
+static_assert(sizeof(LogFileHeader) == 32, "LogFileHeader: 32 byte");
+
+inline void logHeaderInit(LogFileHeader &h, uint8_t kind, uint8_t level, uint8_t fanout,
+                          uint16_t itemBytes, uint16_t session, uint64_t startUs) {
+    h = LogFileHeader();
+    h.magic = LOG_FILE_MAGIC;
+    h.version = LOG_FORMAT_VERSION;
+    h.kind = kind;
+    h.level = level;
+    h.fanout = fanout;
+    h.item_bytes = itemBytes;
+    h.session = session;
+    h.start_us = startUs;
+}
+
+inline bool logHeaderValid(const LogFileHeader &h, uint8_t kind, uint8_t level) {
+    return h.magic == LOG_FILE_MAGIC && h.version == LOG_FORMAT_VERSION &&
+           h.kind == kind && h.level == level && h.item_bytes > 0;
+}
+
+// Elementi completi in un file di fileBytes byte
+inline uint32_t logItemCount(uint64_t fileBytes, uint16_t itemBytes) {
+    if (fileBytes <= sizeof(LogFileHeader) || itemBytes == 0) return 0;
+    return (uint32_t)((fileBytes - sizeof(LogFileHeader)) / itemBytes);
+}
+
+// Percorso del file di un livello (0 = record grezzi); prefix = "" su SD
+inline void logFilePath(char *out, size_t max, const char *prefix, uint16_t session, uint8_t level) {
+    if (level == 0) snprintf(out, max, "%s/log_%03u.rec", prefix, session);
+    else snprintf(out, max, "%s/log_%03u.p%u", prefix, session, level);
+}
+
+inline void logIndexPath(char *out, size_t max, const char *prefix, uint16_t session) {
+    snprintf(out, max, "%s/log_%03u.idx", prefix, session);
+}
+
+// === INDICE SPARSO ===
+struct LogIndexEntry {
+    uint64_t timestamp_us;      // Del record indicizzato
+    uint32_t record;            // Multiplo di LOG_INDEX_STRIDE o primo del blocco
+    uint32_t offset;            // Byte nel file dei record (record o blocco)
+};
+
+static_assert(sizeof(LogIndexEntry) == 16, "LogIndexEntry: 16 byte");
+
+// Primo elemento con timestamp >= t in una sequenza ordinata di n elementi
+// (n se nessuno). timestampAt(i) legge l'elemento i: sul device una seek.
+template <typename F>
+inline uint32_t logLowerBound(uint32_t n, uint64_t t, F timestampAt) {
+    uint32_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (timestampAt(mid) < t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+inline void logIndexEntryInit(LogIndexEntry &e, uint32_t record, uint64_t timestampUs) {
+    e.timestamp_us = timestampUs;
+    e.record = record;
+    e.offset = sizeof(LogFileHeader) + record * (uint32_t)sizeof(SensorRecord);
+}
+
+// Primo record con timestamp >= t: ricerca binaria sulle voci dell'indice,
+// poi sui record fra due voci (al più LOG_INDEX_STRIDE). entryAt(i) ->
+// LogIndexEntry, timestampAt(i) -> timestamp del record i. Con entries = 0
+// (indice assente) diventa una ricerca binaria su tutto il file.
+template <typename I, typename R>
+inline uint32_t logFindRecord(uint32_t entries, I entryAt, uint32_t records, R timestampAt, uint64_t t) {
+    uint32_t lo = 0, hi = records;
+    uint32_t k = logLowerBound(entries, t, [&](uint32_t i) { return entryAt(i).timestamp_us; });
+    if (k > 0) lo = entryAt(k - 1).record;
+    if (k < entries) {
+        uint32_t next = entryAt(k).record;
+        if (next < hi) hi = next;
+    }
+    if (lo >= hi) return hi;
+    return lo + logLowerBound(hi - lo, t, [&](uint32_t i) { return timestampAt(lo + i); });
+}
+
+// === CATALOGO ===
+enum LogSessionState : uint8_t {
+    LOG_SESSION_OPEN = 0,       // Ultima voce all'apertura: sessione interrotta
+    LOG_SESSION_CLOSED,
+    LOG_SESSION_FAILED          // Chiusa per errore di scrittura
+};
+
+struct LogCatalogEntry {
+    uint32_t magic;
+    uint16_t session;
+    uint8_t state;              // LogSessionState
+    uint8_t version;
+    uint64_t start_us;          // Timebase all'apertura
+    uint64_t end_us;            // Ultimo record (0 = nessuno)
+    uint32_t records;
+    uint32_t valid;             // Con radar e IMU validi
+    uint32_t dropped;           // Persi dal subscriber del logger
+    uint32_t config_crc;        // Calibrazione e tuning in uso (CRC di DeviceConfig)
+    int32_t dist_min_um;        // Riassunto sui record validi
+    int32_t dist_max_um;
+    int32_t dist_mean_um;
+    int16_t pitch_min_cdeg;
+    int16_t pitch_max_cdeg;
+    uint16_t config_schema;
+    uint16_t reserved;
+    uint32_t crc;               // CRC32 dei byte precedenti: voci scritte a metà scartate
+};
+
+static_assert(sizeof(LogCatalogEntry) == 64, "LogCatalogEntry: 64 byte");
+
+inline void logCatalogSeal(LogCatalogEntry &e) {
+    e.magic = LOG_FILE_MAGIC;
+    e.version = LOG_FORMAT_VERSION;
+    e.crc = configCrc32(&e, offsetof(LogCatalogEntry, crc));
+}
+
+inline bool logCatalogValid(const LogCatalogEntry &e) {
+    return e.magic == LOG_FILE_MAGIC && e.version == LOG_FORMAT_VERSION &&
+           e.crc == configCrc32(&e, offsetof(LogCatalogEntry, crc));
+}
+
+// Lettura dalla coda: la prima voce vista di una sessione è la più recente.
+// false quando list è piena.
+inline bool logCatalogCollect(LogCatalogEntry *list, uint16_t &count, uint16_t max,
+                              const LogCatalogEntry &e) {
+    if (!logCatalogValid(e)) return count < max;
+    for (uint16_t i = 0; i < count; i++) {
+        if (list[i].session == e.session) return true;
+    }
+    if (count < max) list[count++] = e;
+    return count < max;
+}
+
+#endif // LOG_FORMAT_H
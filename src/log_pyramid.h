@@ -0,0 +1,280 @@
+// log_pyramid.h
+// Piramide di decimazione min/max/media per sfogliare registrazioni lunghe
+// su uno schermo largo 240 pixel. Il logger la costruisce in modo
+// incrementale accanto ai record grezzi (un bin al livello L ogni FANOUT^L
+// record, scritto appena chiuso); il viewer sceglie il livello più grosso
+// che non supera i campioni per pixel e legge così al più
+// larghezza x FANOUT bin, qualunque sia la durata della sessione.
+//
+// Canali in interi come nel SensorRecord: distanza in µm, pitch e yaw in
+// centesimi di grado. Lo yaw è srotolato (continuo attraverso 0/360) così
+// min/max di un bin restano significativi. Un campione conta solo con radar
+// e IMU validi; un bin senza campioni validi (count 0) è un buco.
+// Header puro C++, test in tools/log_pyramid_cli.cpp (selftest).
+#ifndef LOG_PYRAMID_H
+#define LOG_PYRAMID_H
+
+#include <stdint.h>
+#include <string.h>
+#include "sensor_record.h"
+
+#define LOG_PYRAMID_FANOUT     8
+#define LOG_PYRAMID_LEVELS     5       // Livelli su file: 8 .. 32768 record per bin
+#define LOG_PYRAMID_CHANNELS   3
+
+enum LogChannel : uint8_t {
+    LOG_CH_DISTANCE = 0,        // µm
+    LOG_CH_PITCH,               // 0.01°
+    LOG_CH_YAW                  // 0.01°, srotolato
+};
+
+struct PyramidBin {
+    int32_t min[LOG_PYRAMID_CHANNELS];
+    int32_t max[LOG_PYRAMID_CHANNELS];
+    int32_t mean[LOG_PYRAMID_CHANNELS];
+    uint32_t count;             // Campioni validi (0 = buco)
+};
+
+static_assert(sizeof(PyramidBin) == 40, "PyramidBin: layout su file");
+
+// Record per bin al livello L (0 = record grezzi)
+inline uint32_t pyramidSpan(uint8_t level) {
+    uint32_t span = 1;
+    for (uint8_t l = 0; l < level; l++) span *= LOG_PYRAMID_FANOUT;
+    return span;
+}
+
+// Livello più grosso con al massimo samplesPerPixel record per bin
+inline uint8_t pyramidLevelFor(uint32_t samplesPerPixel) {
+    uint8_t level = 0;
+    while (level < LOG_PYRAMID_LEVELS && pyramidSpan(level + 1) <= samplesPerPixel) level++;
+    return level;
+}
+
+// Yaw in centesimi vicino a ref (differenza nel verso più corto)
+inline int32_t pyramidUnwrapYaw(int32_t yaw, int32_t ref) {
+    int32_t d = (yaw - ref) % RECORD_YAW_CDEG_TURN;
+    if (d > RECORD_YAW_CDEG_TURN / 2) d -= RECORD_YAW_CDEG_TURN;
+    if (d <= -RECORD_YAW_CDEG_TURN / 2) d += RECORD_YAW_CDEG_TURN;
+    return ref + d;
+}
+
+// Divisione arrotondata al più vicino (medie dalle somme esatte)
+inline int32_t pyramidRoundDiv(int64_t sum, int64_t n) {
+    return (int32_t)(sum >= 0 ? (sum + n / 2) / n : (sum - n / 2) / n);
+}
+
+// Bin di un solo record (livello 0); yaw ancora in [0, 360°)
+inline void pyramidBinFromRecord(const SensorRecord &r, PyramidBin &b) {
+    bool valid = r.radarValid() && r.imuValid();
+    int32_t v[LOG_PYRAMID_CHANNELS] = {r.distance_um, r.pitch_cdeg, r.yaw_cdeg};
+    for (uint8_t c = 0; c < LOG_PYRAMID_CHANNELS; c++) b.min[c] = b.max[c] = b.mean[c] = v[c];
+    b.count = valid ? 1 : 0;
+}
+
+// === COSTRUZIONE INCREMENTALE ===
+// Destinazione dei bin chiusi (file per livello sul device, memoria su host)
+class PyramidSink {
+public:
+    virtual ~PyramidSink() {}
+    virtual bool append(uint8_t level, const PyramidBin &bin) = 0;
+};
+
+class PyramidBuilder {
+public:
+    void begin() {
+        memset(acc, 0, sizeof(acc));
+        memset(&total, 0, sizeof(total));
+        records = 0;
+        yawValid = false;
+        yawPrev = 0;
+    }
+
+    // Un record nel livello 1; i bin pieni si chiudono a cascata. O(1)
+    // ammortizzato: un bin al livello L ogni FANOUT^L record.
+    bool add(const SensorRecord &r, PyramidSink &sink) {
+        records++;
+        if (r.radarValid() && r.imuValid()) {
+            int32_t yaw = yawValid ? pyramidUnwrapYaw(r.yaw_cdeg, yawPrev) : r.yaw_cdeg;
+            yawPrev = yaw;
+            yawValid = true;
+            int32_t v[LOG_PYRAMID_CHANNELS] = {r.distance_um, r.pitch_cdeg, yaw};
+            accumulate(acc[0], v);
+            accumulate(total, v);
+        }
+        acc[0].children++;
+
+        for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS && acc[l].children == LOG_PYRAMID_FANOUT; l++) {
+            if (!close(l, sink)) return false;
+        }
+        return true;
+    }
+
+    // Fine sessione: chiude i bin parziali, così il livello L ha
+    // ceil(record / FANOUT^L) bin
+    bool finish(PyramidSink &sink) {
+        for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS; l++) {
+            if (acc[l].children > 0 && !close(l, sink)) return false;
+        }
+        return true;
+    }
+
+    uint32_t recordCount() const { return records; }
+
+    // Riassunto dell'intera sessione (catalogo): min/max/media dei validi
+    void summary(PyramidBin &b) const { toBin(total, b); }
+
+private:
+    struct Acc {
+        int32_t min[LOG_PYRAMID_CHANNELS];
+        int32_t max[LOG_PYRAMID_CHANNELS];
+        int64_t sum[LOG_PYRAMID_CHANNELS];      // Somme esatte: niente errori di media sui livelli alti
+        uint32_t count;
+        uint32_t children;
+    };
+
+    static void accumulate(Acc &a, const int32_t *v) {
+        for (uint8_t c = 0; c < LOG_PYRAMID_CHANNELS; c++) {
+            if (a.count == 0 || v[c] < a.min[c]) a.min[c] = v[c];
+            if (a.count == 0 || v[c] > a.max[c]) a.max[c] = v[c];
+            a.sum[c] += v[c];
+        }
+        a.count++;
+    }
+
+    static void toBin(const Acc &a, PyramidBin &b) {
+        for (uint8_t c = 0; c < LOG_PYRAMID_CHANNELS; c++) {
+            b.min[c] = a.count ? a.min[c] : 0;
+            b.max[c] = a.count ? a.max[c] : 0;
+            b.mean[c] = pyramidRoundDiv(a.sum[c], a.count ? a.count : 1);
+        }
+        b.count = a.count;
+    }
+
+    // Scrive il bin del livello l+1 (acc[l]) e lo somma al livello sopra
+    bool close(uint8_t l, PyramidSink &sink) {
+        Acc &a = acc[l];
+        PyramidBin b;
+        toBin(a, b);
+        if (!sink.append(l + 1, b)) return false;
+
+        if (l + 1 < LOG_PYRAMID_LEVELS) {
+            Acc &up = acc[l + 1];
+            if (a.count) {
+                for (uint8_t c = 0; c < LOG_PYRAMID_CHANNELS; c++) {
+                    if (up.count == 0 || a.min[c] < up.min[c]) up.min[c] = a.min[c];
+                    if (up.count == 0 || a.max[c] > up.max[c]) up.max[c] = a.max[c];
+                    up.sum[c] += a.sum[c];
+                }
+                up.count += a.count;
+            }
+            up.children++;
+        }
+        memset(&a, 0, sizeof(a));
+        return true;
+    }
+
+    Acc acc[LOG_PYRAMID_LEVELS];        // acc[l] = bin aperto del livello l+1
+    Acc total;
+    uint32_t records = 0;
+    bool yawValid = false;
+    int32_t yawPrev = 0;
+};
+
+// === LETTURA PER IL VIEWER ===
+// Sorgente dei bin: file su SD o su host. Il livello 0 sono i record grezzi
+// convertiti con pyramidBinFromRecord() (yaw non srotolato).
+class PyramidSource {
+public:
+    virtual ~PyramidSource() {}
+    virtual uint32_t records() = 0;
+    // Fino a n bin consecutivi del livello da first; ritorna quanti letti
+    virtual uint32_t read(uint8_t level, uint32_t first, uint32_t n, PyramidBin *out) = 0;
+};
+
+struct PyramidRenderStats {
+    uint8_t level;
+    uint32_t bins;              // Bin letti
+    uint32_t reads;             // Chiamate a read() (una per blocco di scratch)
+};
+
+inline void pyramidColumnMean(PyramidBin &col, const int64_t *sum) {
+    if (col.count == 0) return;
+    for (uint8_t k = 0; k < LOG_PYRAMID_CHANNELS; k++) col.mean[k] = pyramidRoundDiv(sum[k], col.count);
+}
+
+// Colonne [first + c*spp, first + (c+1)*spp) per c < width. Ogni bin va
+// nella colonna del suo primo record: con FANOUT^L <= spp ogni colonna dentro
+// la sessione ne riceve almeno uno. scratch: buffer di lettura (>= 1 bin).
+inline void pyramidRender(PyramidSource &src, uint32_t first, uint32_t spp, uint16_t width,
+                          PyramidBin *columns, PyramidBin *scratch, uint32_t scratchBins,
+                          PyramidRenderStats &stats) {
+    memset(columns, 0, sizeof(PyramidBin) * width);
+    memset(&stats, 0, sizeof(stats));
+    if (spp == 0) spp = 1;
+    uint8_t level = pyramidLevelFor(spp);
+    stats.level = level;
+
+    uint32_t total = src.records();
+    if (first >= total || width == 0) return;
+    uint64_t end = (uint64_t)first + (uint64_t)spp * width;
+    if (end > total) end = total;
+
+    uint32_t span = pyramidSpan(level);
+    uint32_t b0 = first / span;
+    uint32_t b1 = (uint32_t)((end + span - 1) / span);
+
+    // Riferimento per srotolare lo yaw dei record grezzi: la media del bin
+    // di livello 1 che li contiene (stessa scala della piramide)
+    bool yawRef = false;
+    int32_t yawPrev = 0;
+    if (level == 0) {
+        PyramidBin ref;
+        stats.reads++;
+        if (src.read(1, first / LOG_PYRAMID_FANOUT, 1, &ref) == 1 && ref.count) {
+            yawPrev = ref.mean[LOG_CH_YAW];
+            yawRef = true;
+        }
+    }
+
+    // I bin arrivano in ordine di colonna: somme esatte della colonna
+    // corrente, media arrotondata una volta sola alla chiusura
+    int32_t col = -1;
+    int64_t sum[LOG_PYRAMID_CHANNELS] = {0, 0, 0};
+    for (uint32_t b = b0; b < b1;) {
+        uint32_t want = b1 - b < scratchBins ? b1 - b : scratchBins;
+        uint32_t got = src.read(level, b, want, scratch);
+        stats.reads++;
+        if (got == 0) break;
+        for (uint32_t i = 0; i < got; i++) {
+            PyramidBin &bin = scratch[i];
+            uint64_t start = (uint64_t)(b + i) * span;
+            uint32_t c = start <= first ? 0 : (uint32_t)((start - first) / spp);
+            if (c >= width) continue;
+            if ((int32_t)c != col) {
+                if (col >= 0) pyramidColumnMean(columns[col], sum);
+                col = (int32_t)c;
+                memset(sum, 0, sizeof(sum));
+            }
+            if (bin.count == 0) continue;
+            if (level == 0) {
+                int32_t yaw = yawRef ? pyramidUnwrapYaw(bin.mean[LOG_CH_YAW], yawPrev) : bin.mean[LOG_CH_YAW];
+                bin.min[LOG_CH_YAW] = bin.max[LOG_CH_YAW] = bin.mean[LOG_CH_YAW] = yaw;
+                yawPrev = yaw;
+                yawRef = true;
+            }
+            PyramidBin &dst = columns[c];
+            for (uint8_t k = 0; k < LOG_PYRAMID_CHANNELS; k++) {
+                if (dst.count == 0 || bin.min[k] < dst.min[k]) dst.min[k] = bin.min[k];
+                if (dst.count == 0 || bin.max[k] > dst.max[k]) dst.max[k] = bin.max[k];
+                sum[k] += (int64_t)bin.mean[k] * bin.count;
+            }
+            dst.count += bin.count;
+        }
+        stats.bins += got;
+        b += got;
+    }
+    if (col >= 0) pyramidColumnMean(columns[col], sum);
+}
+
+#endif // LOG_PYRAMID_H
@@ -0,0 +1,325 @@
+// mag_calibration.h
+// Calibrazione magnetometro hard/soft-iron con fit di ellissoide ai minimi
+// quadrati. Le equazioni normali si accumulano un campione alla volta
+// (memoria costante, ~450 byte) e il sistema 9x9 si risolve solo alla fine.
+// Header puro C++: lo stesso codice gira nel task sensori e nei test host
+// (tools/mag_fit_test.cpp).
+//
+// Modello (quadrica con traccia fissata a 3, non degenera se l'ellissoide
+// passa vicino all'origine, cioè con hard iron grande quanto il campo):
+//   x²+y²+z² = a(x²+y²-2z²) + b(x²-2y²+z²) + 2cxy + 2dxz + 2eyz + 2fx + 2gy + 2hz + i
+// Correzione: m = W (raw - offset), W simmetrica, campo corretto su sfera unitaria
+#ifndef MAG_CALIBRATION_H
+#define MAG_CALIBRATION_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// === CONFIGURAZIONE ===
+#define MAG_FIT_PARAMS           9
+#define MAG_FIT_MIN_SAMPLES      60      // Sotto questa soglia niente fit
+#define MAG_FIT_MIN_COVERAGE     0.5f    // Frazione di direzioni viste
+#define MAG_FIT_SCALE_UT         100.0f  // Normalizzazione per il condizionamento
+#define MAG_FIT_MAX_FIELD_UT     400.0f  // Fondo scala LIS3MDL a ±4 gauss
+#define MAG_FIT_SPIKE_UT         40.0f   // Salto isolato oltre cui il campione è un picco
+#define MAG_FIT_AZ_BINS          8
+#define MAG_FIT_EL_BINS          4       // Fasce di uguale area (z normalizzato)
+
+struct MagFitResult {
+    bool ok;
+    float offset[3];            // Hard iron (uT)
+    float soft_iron[9];         // W, riga per riga
+    float field_ut;             // Raggio medio dell'ellissoide
+    float residual_ut;          // RMS stimato della distanza dalla superficie
+    float coverage;             // 0..1
+    uint32_t samples;
+    uint32_t rejected;
+};
+
+// === ALGEBRA 3x3 SIMMETRICA ===
+// Autovalori/vettori con Jacobi ciclico (converge in pochi sweep per 3x3)
+inline void magSymEigen3(const double in[9], double values[3], double vectors[9]) {
+    double a[9];
+    memcpy(a, in, sizeof(a));
+    for (int i = 0; i < 9; i++) vectors[i] = (i % 4 == 0) ? 1.0 : 0.0;
+
+    for (int sweep = 0; sweep < 16; sweep++) {
+        double off = a[1] * a[1] + a[2] * a[2] + a[5] * a[5];
+        if (off < 1e-30) break;
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                double apq = a[p * 3 + q];
+                if (fabs(apq) < 1e-300) continue;
+                double theta = (a[q * 3 + q] - a[p * 3 + p]) / (2 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1));
+                double c = 1 / sqrt(t * t + 1), s = t * c;
+                for (int k = 0; k < 3; k++) {
+                    double akp = a[k * 3 + p], akq = a[k * 3 + q];
+                    a[k * 3 + p] = c * akp - s * akq;
+                    a[k * 3 + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double apk = a[p * 3 + k], aqk = a[q * 3 + k];
+                    a[p * 3 + k] = c * apk - s * aqk;
+                    a[q * 3 + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double vkp = vectors[k * 3 + p], vkq = vectors[k * 3 + q];
+                    vectors[k * 3 + p] = c * vkp - s * vkq;
+                    vectors[k * 3 + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 3; i++) values[i] = a[i * 4];
+}
+
+// Risolve A x = b (n <= 9) con eliminazione gaussiana a pivot parziale
+inline bool magSolveLinear(double *a, double *b, int n) {
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int r = col + 1; r < n; r++) {
+            if (fabs(a[r * n + col]) > fabs(a[pivot * n + col])) pivot = r;
+        }
+        if (fabs(a[pivot * n + col]) < 1e-12) return false;
+        if (pivot != col) {
+            for (int k = 0; k < n; k++) {
+                double t = a[col * n + k];
+                a[col * n + k] = a[pivot * n + k];
+                a[pivot * n + k] = t;
+            }
+            double t = b[col];
+            b[col] = b[pivot];
+            b[pivot] = t;
+        }
+        for (int r = col + 1; r < n; r++) {
+            double f = a[r * n + col] / a[col * n + col];
+            if (f == 0) continue;
+            for (int k = col; k < n; k++) a[r * n + k] -= f * a[col * n + k];
+            b[r] -= f * b[col];
+        }
+    }
+    for (int r = n - 1; r >= 0; r--) {
+        double s = b[r];
+        for (int k = r + 1; k < n; k++) s -= a[r * n + k] * b[k];
+        b[r] = s / a[r * n + r];
+    }
+    return true;
+}
+
+// === FIT INCREMENTALE ===
+class EllipsoidFit {
+public:
+    EllipsoidFit() { reset(); }
+
+    void reset() {
+        memset(ata, 0, sizeof(ata));
+        memset(atb, 0, sizeof(atb));
+        btb = 0;
+        count = 0;
+        rejectedCount = 0;
+        pending = 0;
+        bins = 0;
+        for (int i = 0; i < 3; i++) {
+            minV[i] = 1e9f;
+            maxV[i] = -1e9f;
+        }
+    }
+
+    // Un campione raw (uT). Con un campione di ritardo: un salto isolato
+    // (lontano dal precedente e dal successivo, che sono vicini fra loro)
+    // viene scartato. Ritorna false se il campione è fuori scala.
+    bool add(float x, float y, float z) {
+        float v[3] = {x, y, z};
+        for (int i = 0; i < 3; i++) {
+            if (!(fabsf(v[i]) < MAG_FIT_MAX_FIELD_UT)) {
+                rejectedCount++;
+                return false;
+            }
+        }
+
+        if (pending == 2) {
+            bool farPrev = dist(cur, prev) > MAG_FIT_SPIKE_UT;
+            bool farNext = dist(cur, v) > MAG_FIT_SPIKE_UT;
+            bool neighborsClose = dist(prev, v) <= MAG_FIT_SPIKE_UT;
+            if (farPrev && farNext && neighborsClose) {
+                rejectedCount++;
+                memcpy(cur, v, sizeof(cur));    // Il picco non diventa "precedente"
+                return true;
+            }
+            accumulate(cur);
+            memcpy(prev, cur, sizeof(prev));
+        } else if (pending == 1) {
+            pending = 2;
+        } else {
+            pending = 1;
+            memcpy(prev, v, sizeof(prev));
+            accumulate(v);
+            return true;
+        }
+        memcpy(cur, v, sizeof(cur));
+        return true;
+    }
+
+    uint32_t samples() const { return count; }
+    uint32_t rejected() const { return rejectedCount; }
+
+    float coverage() const {
+        uint32_t n = 0;
+        for (uint32_t b = bins; b; b &= b - 1) n++;
+        return n / (float)(MAG_FIT_AZ_BINS * MAG_FIT_EL_BINS);
+    }
+
+    // Fit su quanto accumulato (l'ultimo campione in attesa è incluso)
+    bool solve(MagFitResult &r) const {
+        EllipsoidFit f = *this;
+        if (f.pending == 2) f.accumulate(f.cur);
+
+        memset(&r, 0, sizeof(r));
+        r.samples = f.count;
+        r.rejected = f.rejectedCount;
+        r.coverage = f.coverage();
+        if (f.count < MAG_FIT_MIN_SAMPLES || r.coverage < MAG_FIT_MIN_COVERAGE) return false;
+
+        // Equazioni normali complete dalla forma triangolare
+        double a[MAG_FIT_PARAMS * MAG_FIT_PARAMS], theta[MAG_FIT_PARAMS];
+        for (int i = 0; i < MAG_FIT_PARAMS; i++) {
+            theta[i] = f.atb[i];
+            for (int j = 0; j < MAG_FIT_PARAMS; j++) {
+                a[i * MAG_FIT_PARAMS + j] = f.ata[index(i, j)];
+            }
+        }
+        if (!magSolveLinear(a, theta, MAG_FIT_PARAMS)) return false;
+
+        // Quadrica x'Mx + 2g'x + d0 = 0 (coordinate normalizzate)
+        double a0 = theta[0], b0 = theta[1];
+        double m[9] = {
+            1 - a0 - b0, -theta[2],        -theta[3],
+            -theta[2],   1 - a0 + 2 * b0,  -theta[4],
+            -theta[3],   -theta[4],        1 + 2 * a0 - b0
+        };
+        double g[3] = {-theta[5], -theta[6], -theta[7]};
+        double d0 = -theta[8];
+
+        // Centro: M c = -g
+        double mc[9], c[3] = {-g[0], -g[1], -g[2]};
+        memcpy(mc, m, sizeof(mc));
+        if (!magSolveLinear(mc, c, 3)) return false;
+
+        // (x-c)' M (x-c) = k  con  k = c' M c - d0
+        double k = -d0;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) k += c[i] * m[i * 3 + j] * c[j];
+        }
+        if (!(k > 0)) return false;
+
+        double values[3], vectors[9];
+        magSymEigen3(m, values, vectors);
+        for (int i = 0; i < 3; i++) {
+            values[i] /= k;
+            if (!(values[i] > 0)) return false;     // Non è un ellissoide
+        }
+
+        // W = sqrt(M/k) riportata in uT
+        double sq[3] = {sqrt(values[0]), sqrt(values[1]), sqrt(values[2])};
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                double w = 0;
+                for (int e = 0; e < 3; e++) w += vectors[i * 3 + e] * sq[e] * vectors[j * 3 + e];
+                r.soft_iron[i * 3 + j] = (float)(w / MAG_FIT_SCALE_UT);
+            }
+            r.offset[i] = (float)(c[i] * MAG_FIT_SCALE_UT);
+        }
+
+        // Raggio medio: sfera di pari volume
+        double radius = pow(sq[0] * sq[1] * sq[2], -1.0 / 3.0);
+        r.field_ut = (float)(radius * MAG_FIT_SCALE_UT);
+
+        // Residuo algebrico medio (t't - 2θ'A't + θ'A'Aθ) / N, convertito in
+        // distanza: Q(x)/k ≈ 2 δr / R
+        double quad = 0, lin = 0;
+        for (int i = 0; i < MAG_FIT_PARAMS; i++) {
+            lin += theta[i] * f.atb[i];
+            for (int j = 0; j < MAG_FIT_PARAMS; j++) {
+                quad += theta[i] * f.ata[index(i, j)] * theta[j];
+            }
+        }
+        double mse = (f.btb - 2 * lin + quad) / f.count;
+        if (mse < 0) mse = 0;
+        r.residual_ut = (float)(r.field_ut * sqrt(mse) / (2 * k));
+
+        r.ok = true;
+        return true;
+    }
+
+private:
+    double ata[MAG_FIT_PARAMS * (MAG_FIT_PARAMS + 1) / 2];  // Triangolo superiore
+    double atb[MAG_FIT_PARAMS];
+    double btb;                 // Σ t² (per il residuo)
+    uint32_t count;
+    uint32_t rejectedCount;
+    uint8_t pending;            // Campioni nel ritardo del filtro picchi
+    float prev[3], cur[3];
+    float minV[3], maxV[3];     // Box per il centro approssimato (copertura)
+    uint32_t bins;
+
+    static int index(int i, int j) {
+        if (i > j) {
+            int t = i;
+            i = j;
+            j = t;
+        }
+        return i * MAG_FIT_PARAMS - i * (i - 1) / 2 + (j - i);
+    }
+
+    static float dist(const float a[3], const float b[3]) {
+        float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+        return sqrtf(dx * dx + dy * dy + dz * dz);
+    }
+
+    void accumulate(const float v[3]) {
+        double x = v[0] / MAG_FIT_SCALE_UT, y = v[1] / MAG_FIT_SCALE_UT, z = v[2] / MAG_FIT_SCALE_UT;
+        double xx = x * x, yy = y * y, zz = z * z;
+        double p[MAG_FIT_PARAMS] = {xx + yy - 2 * zz, xx - 2 * yy + zz,
+                                    2 * x * y, 2 * x * z, 2 * y * z,
+                                    2 * x, 2 * y, 2 * z, 1};
+        double t = xx + yy + zz;
+
+        int idx = 0;
+        btb += t * t;
+        for (int i = 0; i < MAG_FIT_PARAMS; i++) {
+            atb[i] += p[i] * t;
+            for (int j = i; j < MAG_FIT_PARAMS; j++) ata[idx++] += p[i] * p[j];
+        }
+        count++;
+
+        // Copertura: direzione dal centro del box corrente
+        for (int i = 0; i < 3; i++) {
+            if (v[i] < minV[i]) minV[i] = v[i];
+            if (v[i] > maxV[i]) maxV[i] = v[i];
+        }
+        float d[3];
+        for (int i = 0; i < 3; i++) d[i] = v[i] - (minV[i] + maxV[i]) / 2;
+        float n = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+        if (n < 1.0f) return;
+
+        float az = atan2f(d[1], d[0]);
+        int azBin = (int)((az + (float)M_PI) / (2 * (float)M_PI) * MAG_FIT_AZ_BINS);
+        int elBin = (int)((d[2] / n + 1) / 2 * MAG_FIT_EL_BINS);
+        if (azBin >= MAG_FIT_AZ_BINS) azBin = MAG_FIT_AZ_BINS - 1;
+        if (elBin >= MAG_FIT_EL_BINS) elBin = MAG_FIT_EL_BINS - 1;
+        bins |= 1u << (elBin * MAG_FIT_AZ_BINS + azBin);
+    }
+};
+
+// === APPLICAZIONE (per campione: 9 moltiplicazioni) ===
+inline void magApplyCalibration(const float raw[3], const float offset[3],
+                                const float softIron[9], float out[3]) {
+    float d0 = raw[0] - offset[0], d1 = raw[1] - offset[1], d2 = raw[2] - offset[2];
+    out[0] = softIron[0] * d0 + softIron[1] * d1 + softIron[2] * d2;
+    out[1] = softIron[3] * d0 + softIron[4] * d1 + softIron[5] * d2;
+    out[2] = softIron[6] * d0 + softIron[7] * d1 + softIron[8] * d2;
+}
+
+#endif // MAG_CALIBRATION_H
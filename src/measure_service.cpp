@@ -0,0 +1,183 @@
+// measure_service.cpp
+#include "measure_service.h"
+#include "task_config.h"
+#include "sensor_tasks.h"
+#include "power_manager.h"
+#include "timebase.h"
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t measureTaskHandle = NULL;
+static SemaphoreHandle_t measureMutex = NULL;
+static portMUX_TYPE stateLock = portMUX_INITIALIZER_UNLOCKED;   // config, ultimo risultato, stats
+
+static MeasureConfig config = {MEASURE_DEFAULT_PRE, MEASURE_DEFAULT_POST,
+                               MEASURE_DEFAULT_DIST_SD, MEASURE_DEFAULT_ANGLE_SD};
+static MeasureResult lastResult;
+static bool hasResult = false;
+static MeasureStats stats = {0};
+
+// Solo sotto measureMutex
+static SensorRecord history[SENSOR_TOPIC_DEPTH];
+
+// Trigger dal tasto (scritto nell'ISR)
+static volatile timestamp_us_t buttonTriggerUs = 0;
+static volatile timestamp_us_t lastButtonUs = 0;
+
+// === MISURA ===
+static bool measureAt(timestamp_us_t triggerUs, MeasureSource source, MeasureResult &r) {
+    if (!measureMutex || !TAKE_MUTEX(measureMutex, MS_TO_TICKS(MEASURE_LOCK_TIMEOUT_MS))) {
+        memset(&r, 0, sizeof(r));
+        r.status = MEASURE_NO_DATA;
+        r.source = source;
+        r.trigger_us = triggerUs;
+        return false;
+    }
+
+    MeasureConfig cfg;
+    getMeasureConfig(cfg);
+
+    uint16_t n = getSensorHistory(history, SENSOR_TOPIC_DEPTH);
+
+    // Campioni dopo il trigger: il subscriber serve solo da campanello, i
+    // dati si rileggono dallo storico (nessun campione perso fra i due)
+    if (cfg.post_samples > 0 && measureCountPost(history, n, triggerUs) < cfg.post_samples) {
+        int8_t sub = subscribeSensorData("measure", PUBSUB_LATEST_ONLY);
+        uint32_t waitMs = cfg.post_samples * SENSOR_SAMPLE_RATE_MS + MEASURE_POST_MARGIN_MS;
+        uint32_t start = millis();
+        while (sub >= 0) {
+            n = getSensorHistory(history, SENSOR_TOPIC_DEPTH);
+            if (measureCountPost(history, n, triggerUs) >= cfg.post_samples) break;
+            int32_t remaining = (int32_t)(waitMs - (millis() - start));
+            SensorRecord doorbell;
+            if (remaining <= 0) break;
+            readSensorRecord(sub, doorbell, remaining);
+        }
+        if (sub >= 0) unsubscribeSensorData(sub);
+    }
+
+    measureCompute(history, n, triggerUs, cfg, r);
+    r.source = source;
+    uint64_t latency = timeAbsDeltaUs(timebaseNowUs(), triggerUs);
+    r.latency_us = latency > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)latency;
+    GIVE_MUTEX(measureMutex);
+
+    taskENTER_CRITICAL(&stateLock);
+    lastResult = r;
+    hasResult = true;
+    stats.count++;
+    if (r.status == MEASURE_UNSTABLE) stats.unstable++;
+    else if (r.status == MEASURE_PARTIAL) stats.partial++;
+    else if (r.status == MEASURE_NO_DATA) stats.no_data++;
+    stats.last_latency_us = r.latency_us;
+    if (r.latency_us > stats.max_latency_us) stats.max_latency_us = r.latency_us;
+    taskEXIT_CRITICAL(&stateLock);
+
+    notifyUIEvent(UI_EVENT_MEASURE);
+    return r.status == MEASURE_OK;
+}
+
+// === TASTO ===
+static void IRAM_ATTR measureButtonIsr() {
+    timestamp_us_t now = timebaseNowUs();
+    if (now - lastButtonUs < MEASURE_BUTTON_DEBOUNCE_US) return;
+    lastButtonUs = now;
+    buttonTriggerUs = now;
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(measureTaskHandle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void measureTask(void *pvParameters) {
+    RTOS_LOG("Measure task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_MEASURE);
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        MeasureResult r;
+        measureAt(buttonTriggerUs, MEASURE_SRC_BUTTON, r);
+        printMeasurement(r);
+    }
+}
+
+// === API ===
+bool initMeasureService() {
+    if (measureTaskHandle) return true;
+
+    measureMutex = xSemaphoreCreateMutex();
+    flightRegisterMutex(measureMutex, FR_MUTEX_MEASURE);
+    if (!measureMutex) {
+        Serial.println("❌ Failed to create measure mutex");
+        return false;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        measureTask,
+        "Measure",
+        MEASURE_TASK_STACK_SIZE,
+        NULL,
+        MEASURE_TASK_PRIORITY,
+        &measureTaskHandle,
+        MEASURE_TASK_CORE
+    );
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create measure task");
+        return false;
+    }
+
+    if (MEASURE_BUTTON_PIN >= 0) {
+        pinMode(MEASURE_BUTTON_PIN, INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(MEASURE_BUTTON_PIN), measureButtonIsr, FALLING);
+    }
+    return true;
+}
+
+bool measureNow(MeasureSource source, MeasureResult &result) {
+    return measureAt(timebaseNowUs(), source, result);
+}
+
+bool getLastMeasurement(MeasureResult &result) {
+    taskENTER_CRITICAL(&stateLock);
+    result = lastResult;
+    bool ok = hasResult;
+    taskEXIT_CRITICAL(&stateLock);
+    return ok;
+}
+
+void setMeasureConfig(const MeasureConfig &c) {
+    MeasureConfig v = c;
+    if (v.pre_samples + v.post_samples == 0) v.pre_samples = 1;
+    if (v.pre_samples + v.post_samples > MEASURE_MAX_SAMPLES) {
+        v.post_samples = v.post_samples > MEASURE_MAX_SAMPLES ? MEASURE_MAX_SAMPLES : v.post_samples;
+        v.pre_samples = MEASURE_MAX_SAMPLES - v.post_samples;
+    }
+    taskENTER_CRITICAL(&stateLock);
+    config = v;
+    taskEXIT_CRITICAL(&stateLock);
+}
+
+void getMeasureConfig(MeasureConfig &c) {
+    taskENTER_CRITICAL(&stateLock);
+    c = config;
+    taskEXIT_CRITICAL(&stateLock);
+}
+
+void getMeasureStats(MeasureStats &s) {
+    taskENTER_CRITICAL(&stateLock);
+    s = stats;
+    taskEXIT_CRITICAL(&stateLock);
+}
+
+void printMeasurement(const MeasureResult &r) {
+    static const char *sources[] = {"console", "touch", "button", "api"};
+    Serial.printf("%s Misura [%s, %s]: %.1f mm pitch %.2f° yaw %.2f° -> X %.1f Y %.1f Z %.1f mm\n",
+                  r.status == MEASURE_OK ? "✅" : "⚠️", measureStatusName(r.status),
+                  r.source < 4 ? sources[r.source] : "?",
+                  r.distance_mm, r.pitch_deg, r.yaw_deg, r.x_mm, r.y_mm, r.z_mm);
+    Serial.printf("   σ %.2f mm / %.3f° / %.3f°, %u campioni (%u interpolati, allineamento max %lu us), "
+                  "finestra %+ld..%+ld ms, latenza %lu us\n",
+                  r.distance_sd_mm, r.pitch_sd_deg, r.yaw_sd_deg, r.samples, r.interpolated,
+                  (unsigned long)r.max_align_us,
+                  r.samples ? (long)(timeDeltaUs(r.first_us, r.trigger_us) / 1000) : 0L,
+                  r.samples ? (long)(timeDeltaUs(r.last_us, r.trigger_us) / 1000) : 0L,
+                  (unsigned long)r.latency_us);
+}
@@ -0,0 +1,46 @@
+// measure_service.h
+#ifndef MEASURE_SERVICE_H
+#define MEASURE_SERVICE_H
+
+#include <Arduino.h>
+#include "measurement.h"
+
+// === SERVIZIO MISURA SU TRIGGER ===
+// Lo storico pre-trigger è il ring del topic sensori (32 campioni, 3.2s):
+// al trigger si copiano gli ultimi campioni e il risultato è pronto subito
+// (latenza ~0.1ms con post_samples = 0). Con post_samples > 0 il servizio
+// attende i campioni successivi (+100ms ciascuno a 10Hz).
+// Trigger: console ("measure"), touch sulla schermata Live Data, tasto
+// fisico su MEASURE_BUTTON_PIN (istante preso nell'ISR).
+
+#ifndef MEASURE_BUTTON_PIN
+#define MEASURE_BUTTON_PIN        0        // Tasto BOOT dell'ESP32-S3 (-1 = nessuno)
+#endif
+#define MEASURE_BUTTON_DEBOUNCE_US 250000
+#define MEASURE_POST_MARGIN_MS    50       // Oltre il periodo di campionamento per post sample
+#define MEASURE_LOCK_TIMEOUT_MS   500      // Una misura alla volta
+
+struct MeasureStats {
+    uint32_t count;
+    uint32_t unstable;
+    uint32_t partial;
+    uint32_t no_data;
+    uint32_t last_latency_us;
+    uint32_t max_latency_us;
+};
+
+bool initMeasureService();
+
+// Misura con trigger = adesso. Ritorna true se status == MEASURE_OK.
+bool measureNow(MeasureSource source, MeasureResult &result);
+
+// Ultima misura (da qualunque trigger); false se nessuna
+bool getLastMeasurement(MeasureResult &result);
+
+void setMeasureConfig(const MeasureConfig &config);
+void getMeasureConfig(MeasureConfig &config);
+void getMeasureStats(MeasureStats &stats);
+
+void printMeasurement(const MeasureResult &result);
+
+#endif // MEASURE_SERVICE_H
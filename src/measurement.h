@@ -0,0 +1,239 @@
+// measurement.h
+// Misura su trigger dallo storico dei campioni: media dei campioni radar
+// subito prima (ed eventualmente subito dopo) l'istante del trigger, con
+// gli angoli IMU interpolati all'istante di ciascuna lettura radar invece
+// di prendere quelli dello stesso ciclo. Controllo di stabilità sugli
+// scarti. Header puro C++ (sensor_record.h, running_stats.h), testato in
+// tools/measurement_test.cpp.
+#ifndef MEASUREMENT_H
+#define MEASUREMENT_H
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include "sensor_record.h"
+#include "running_stats.h"
+
+#define MEASURE_MAX_SAMPLES        16
+#define MEASURE_DEFAULT_PRE        5       // 0.5s di storico a 10Hz: risultato immediato
+#define MEASURE_DEFAULT_POST       0       // Ogni campione dopo il trigger = +100ms
+#define MEASURE_DEFAULT_DIST_SD    5.0f    // mm
+#define MEASURE_DEFAULT_ANGLE_SD   0.5f    // gradi
+#define MEASURE_MAX_AGE_MS         1000    // Campioni più vecchi non descrivono il trigger
+#define MEASURE_MAX_ALIGN_US       150000  // IMU più lontana di così: campione scartato
+
+struct MeasureConfig {
+    uint8_t pre_samples;        // Campioni radar con t <= trigger
+    uint8_t post_samples;       // Campioni radar con t > trigger (attesa)
+    float max_distance_sd_mm;   // Oltre: MEASURE_UNSTABLE
+    float max_angle_sd_deg;
+};
+
+inline void measureDefaults(MeasureConfig &c) {
+    c.pre_samples = MEASURE_DEFAULT_PRE;
+    c.post_samples = MEASURE_DEFAULT_POST;
+    c.max_distance_sd_mm = MEASURE_DEFAULT_DIST_SD;
+    c.max_angle_sd_deg = MEASURE_DEFAULT_ANGLE_SD;
+}
+
+enum MeasureStatus : uint8_t {
+    MEASURE_OK = 0,
+    MEASURE_UNSTABLE,           // Risultato calcolato ma scarti oltre soglia
+    MEASURE_PARTIAL,            // Meno campioni di quelli richiesti (timeout/storico corto)
+    MEASURE_NO_DATA
+};
+
+enum MeasureSource : uint8_t {
+    MEASURE_SRC_CONSOLE = 0,
+    MEASURE_SRC_TOUCH,
+    MEASURE_SRC_BUTTON,
+    MEASURE_SRC_API
+};
+
+struct MeasureResult {
+    uint8_t status;             // MeasureStatus
+    uint8_t source;             // MeasureSource
+    uint8_t samples;            // Campioni mediati
+    uint8_t interpolated;       // Di cui con angoli interpolati/estrapolati da due letture IMU
+    float x_mm, y_mm, z_mm;     // Punto 3D dalle medie (stessa formula del task sensori)
+    float distance_mm;
+    float pitch_deg;
+    float yaw_deg;
+    float distance_sd_mm;
+    float pitch_sd_deg;
+    float yaw_sd_deg;
+    uint32_t max_align_us;      // Distanza massima radar -> IMU più vicina
+    timestamp_us_t trigger_us;
+    timestamp_us_t first_us;    // Primo e ultimo campione radar usati
+    timestamp_us_t last_us;
+    uint32_t latency_us;        // Trigger -> risultato (lo imposta il servizio)
+};
+
+// Differenza di yaw nel verso più corto (-180..180]
+inline float measureYawDiff(float a, float b) {
+    float d = fmodf(a - b, 360.0f);
+    if (d > 180.0f) d -= 360.0f;
+    if (d <= -180.0f) d += 360.0f;
+    return d;
+}
+
+// Angoli IMU all'istante t: interpolazione fra le due letture che lo
+// racchiudono. Dopo l'ultima lettura (il campione radar più recente arriva
+// prima dell'IMU del ciclo dopo) estrapolazione dalle ultime due, altrimenti
+// la più vicina. false se nessuna entro MEASURE_MAX_ALIGN_US.
+inline bool measureAnglesAt(const SensorRecord *hist, uint16_t n, timestamp_us_t t,
+                            float &pitch, float &yaw, bool &interpolated, uint32_t &gapUs) {
+    int prev = -1, before = -1, after = -1;
+    for (uint16_t i = 0; i < n; i++) {
+        timestamp_us_t ti = hist[i].imuTimestampUs();
+        if (!hist[i].imuValid() || ti == 0) continue;
+        if (ti <= t) {
+            prev = before;
+            before = i;
+        } else if (after < 0) {
+            after = i;
+        }
+    }
+
+    int nearest = before >= 0 ? before : after;
+    if (nearest < 0) return false;
+    uint64_t gap = timeAbsDeltaUs(t, hist[nearest].imuTimestampUs());
+    if (after < 0 && gap > MEASURE_MAX_ALIGN_US) return false;
+
+    interpolated = false;
+    int a = -1, b = -1;
+    if (before >= 0 && after >= 0) {
+        a = before;
+        b = after;
+    } else if (after < 0 && prev >= 0) {
+        a = prev;
+        b = before;
+    }
+
+    if (a >= 0) {
+        timestamp_us_t t0 = hist[a].imuTimestampUs(), t1 = hist[b].imuTimestampUs();
+        float f = (float)timeDeltaUs(t, t0) / (float)(t1 - t0);
+        float p0 = hist[a].pitchDeg(), y0 = hist[a].yawDeg();
+        pitch = p0 + f * (hist[b].pitchDeg() - p0);
+        yaw = y0 + f * measureYawDiff(hist[b].yawDeg(), y0);
+        yaw = fmodf(yaw, 360.0f);
+        if (yaw < 0) yaw += 360.0f;
+        if (after >= 0 && t1 - t < gap) gap = t1 - t;
+        gapUs = (uint32_t)gap;
+        interpolated = true;
+        return true;
+    }
+
+    if (gap > MEASURE_MAX_ALIGN_US) return false;
+    pitch = hist[nearest].pitchDeg();
+    yaw = hist[nearest].yawDeg();
+    gapUs = (uint32_t)gap;
+    return true;
+}
+
+// hist: storico in ordine cronologico (più vecchio per primo)
+inline MeasureStatus measureCompute(const SensorRecord *hist, uint16_t n, timestamp_us_t triggerUs,
+                                    const MeasureConfig &cfg, MeasureResult &r) {
+    memset(&r, 0, sizeof(r));
+    r.trigger_us = triggerUs;
+
+    // Selezione: i pre più recenti fino al trigger, poi i primi post
+    uint16_t selected[MEASURE_MAX_SAMPLES];
+    uint8_t count = 0;
+    uint8_t pre = cfg.pre_samples, post = cfg.post_samples;
+    if (pre + post > MEASURE_MAX_SAMPLES) pre = MEASURE_MAX_SAMPLES - post;
+
+    uint8_t preFound = 0;
+    for (int i = (int)n - 1; i >= 0 && preFound < pre; i--) {
+        timestamp_us_t t = hist[i].radarTimestampUs();
+        if (!hist[i].radarValid() || t == 0 || t > triggerUs) continue;
+        if (triggerUs - t > (uint64_t)MEASURE_MAX_AGE_MS * 1000) break;
+        selected[count++] = (uint16_t)i;
+        preFound++;
+    }
+    uint8_t postFound = 0;
+    for (uint16_t i = 0; i < n && postFound < post; i++) {
+        if (!hist[i].radarValid() || hist[i].radarTimestampUs() <= triggerUs) continue;
+        selected[count++] = i;
+        postFound++;
+    }
+
+    RunningStats dist, pitch, yaw;
+    dist.reset();
+    pitch.reset();
+    yaw.reset();
+    float yawRef = 0;
+    for (uint8_t k = 0; k < count; k++) {
+        const SensorRecord &rec = hist[selected[k]];
+        timestamp_us_t t = rec.radarTimestampUs();
+        float p, y;
+        bool interp;
+        uint32_t gap;
+        if (!measureAnglesAt(hist, n, t, p, y, interp, gap)) continue;
+
+        // Yaw come scarto dal primo campione: media corretta anche attorno a 0/360
+        if (dist.n == 0) yawRef = y;
+        dist.add(rec.distanceMm());
+        pitch.add(p);
+        yaw.add(measureYawDiff(y, yawRef));
+
+        if (interp) r.interpolated++;
+        if (gap > r.max_align_us) r.max_align_us = gap;
+        if (r.first_us == 0 || t < r.first_us) r.first_us = t;
+        if (t > r.last_us) r.last_us = t;
+    }
+
+    r.samples = (uint8_t)dist.n;
+    if (r.samples == 0) {
+        r.status = MEASURE_NO_DATA;
+        return MEASURE_NO_DATA;
+    }
+
+    r.distance_mm = (float)dist.mean;
+    r.pitch_deg = (float)pitch.mean;
+    r.yaw_deg = yawRef + (float)yaw.mean;
+    if (r.yaw_deg < 0) r.yaw_deg += 360.0f;
+    if (r.yaw_deg >= 360.0f) r.yaw_deg -= 360.0f;
+    r.distance_sd_mm = (float)dist.stddev();
+    r.pitch_sd_deg = (float)pitch.stddev();
+    r.yaw_sd_deg = (float)yaw.stddev();
+
+    SensorData d = {};
+    d.distance_mm = r.distance_mm;
+    d.pitch_deg = r.pitch_deg;
+    d.yaw_deg = r.yaw_deg;
+    calculateCoordinates(d);
+    r.x_mm = d.x_mm;
+    r.y_mm = d.y_mm;
+    r.z_mm = d.z_mm;
+
+    if (r.distance_sd_mm > cfg.max_distance_sd_mm || r.pitch_sd_deg > cfg.max_angle_sd_deg ||
+        r.yaw_sd_deg > cfg.max_angle_sd_deg) {
+        r.status = MEASURE_UNSTABLE;
+    } else if (r.samples < pre + post) {
+        r.status = MEASURE_PARTIAL;
+    } else {
+        r.status = MEASURE_OK;
+    }
+    return (MeasureStatus)r.status;
+}
+
+// Campioni dopo il trigger già presenti nello storico
+inline uint8_t measureCountPost(const SensorRecord *hist, uint16_t n, timestamp_us_t triggerUs) {
+    uint8_t c = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        if (hist[i].radarValid() && hist[i].radarTimestampUs() > triggerUs) c++;
+    }
+    return c;
+}
+
+inline const char *measureStatusName(uint8_t s) {
+    switch (s) {
+        case MEASURE_OK:       return "OK";
+        case MEASURE_UNSTABLE: return "UNSTABLE";
+        case MEASURE_PARTIAL:  return "PARTIAL";
+        default:               return "NO_DATA";
+    }
+}
+
+#endif // MEASUREMENT_H
@@ -1,5 +1,6 @@
 // menu_state.cpp
 #include "menu_state.h"
+#include "flight_recorder_service.h"
 
 // === DEFINIZIONI DEGLI ARRAY (una sola volta qui!) ===
 const char* mainMenuItems[] = {
@@ -11,7 +12,7 @@ const char* mainMenuItems[] = {
 const char* submenu1Items[] = {
     "Start Acquis.",
     "Live Graph",
-    "Export CSV"
+    "Export PLY"
 };
 
 const char* submenu2Items[] = {
@@ -42,6 +43,9 @@ MenuState getCurrentMenuState() {
 }
 
 void setCurrentMenuState(MenuState state) {
+    if (state != currentMenuState) {
+        flightEvent(FR_EV_MENU, state, currentMenuState);
+    }
     currentMenuState = state;
 }
 
@@ -52,6 +56,7 @@ void navigateToMenu(MenuState state) {
         navigationStack[stackPointer++] = currentMenuState;
     }
     
+    flightEvent(FR_EV_MENU, state, currentMenuState);
     previousMenuState = currentMenuState;
     currentMenuState = state;
     selectedMenuIndex = -1;  // Reset selezione
@@ -64,7 +69,9 @@ void navigateToMenu(MenuState state) {
 void navigateBack() {
     if (canNavigateBack()) {
         // Ripristina stato precedente dallo stack
+        MenuState from = currentMenuState;
         currentMenuState = navigationStack[--stackPointer];
+        flightEvent(FR_EV_MENU, currentMenuState, from);
         selectedMenuIndex = -1;
         
         Serial.printf("Navigate back to: %s\n", getMenuTitle(currentMenuState));
@@ -136,6 +143,15 @@ const char* getCurrentMenuItemText() {
     return "No Selection";
 }
 
+bool menuItemNeedsSensors(MenuState state, int index) {
+    switch (state) {
+        case MAIN_MENU:  return index == 0 || index == 1;   // PITCH,YAW,DIST / CALIB. IMU
+        case SUBMENU_1:  return index == 0 || index == 1;   // Start Acquis. / Live Graph
+        case SUBMENU_2:  return true;                       // Calibrazioni IMU
+        default:         return false;
+    }
+}
+
 // === STATI SPECIALI ===
 bool isInLiveDataMode() {
     return currentMenuState == DISPLAY_LIVE_DATA;
@@ -54,6 +54,9 @@ const char** getMenuItems(MenuState state);
 int getMenuItemCount(MenuState state);
 const char* getCurrentMenuItemText();
 
+// Voci che richiedono sensori attivi ("warming up" durante il boot)
+bool menuItemNeedsSensors(MenuState state, int index);
+
 // Azioni specifiche
 bool isInLiveDataMode();
 bool isCalibrating();
@@ -54,7 +54,7 @@ void MenuSystem::buildMenuStructure() {
     
     subMenuItems[0][2] = new MenuItem("Export Data");
     subMenuItems[0][2]->setAction(
-        []() { LeafActions::exportCSV(); }
+        []() { LeafActions::exportPointCloud(); }
     );
     
     // Add to parent
@@ -0,0 +1,264 @@
+// point_cloud.h
+// Nuvola di punti a capacità fissa su memoria fornita dal chiamante (PSRAM
+// sul device, malloc nei test): array separati per colonna (SoA), nessuna
+// allocazione dopo begin(), quindi niente frammentazione dello heap.
+// Deduplicazione per voxel con hash spaziale a indirizzamento aperto: un
+// campione che cade in un voxel già occupato aggiorna la media del punto
+// invece di aggiungerne uno. Bounding box e centroide incrementali.
+// Header puro C++, benchmark in tools/point_cloud_bench.cpp.
+#ifndef POINT_CLOUD_H
+#define POINT_CLOUD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include "sync_queue.h"
+
+#define POINT_CLOUD_VOXEL_BITS    21          // Per asse: ±1M voxel (±10km a 1cm)
+#define POINT_CLOUD_SLOT_EMPTY    0xFFFFFFFFu
+#define POINT_CLOUD_MAX_HITS      0xFFFF
+
+// Origine del punto (OR se un voxel riceve campioni da più sorgenti)
+#define POINT_FLAG_STREAMED       0x01        // Flusso continuo del task sensori
+#define POINT_FLAG_CAPTURED       0x02        // Cattura automatica da fermo
+#define POINT_FLAG_MEASURED       0x04        // Misura su trigger (measure_service)
+
+enum PointCloudResult : uint8_t {
+    POINT_ADDED = 0,
+    POINT_MERGED,               // Voxel già occupato: media aggiornata
+    POINT_FULL,                 // Capacità esaurita: campione scartato
+    POINT_INVALID               // Coordinate non finite
+};
+
+struct PointCloudStats {
+    uint32_t count;             // Punti memorizzati
+    uint32_t capacity;
+    uint32_t inserted;          // Campioni ricevuti
+    uint32_t merged;
+    uint32_t rejected;          // Pieno o non validi
+    float voxel_mm;
+    float min_mm[3];            // Bounding box di tutti i campioni accettati
+    float max_mm[3];
+    float centroid_mm[3];       // Media dei punti memorizzati
+};
+
+// Slot della tabella hash: potenza di 2 >= 2x capacità (carico <= 50%)
+inline uint32_t pointCloudSlots(uint32_t capacity) {
+    uint32_t s = 16;
+    while (s < capacity * 2) s <<= 1;
+    return s;
+}
+
+// Byte da allocare per una nuvola di capacity punti
+inline size_t pointCloudBytes(uint32_t capacity) {
+    return (size_t)capacity * (sizeof(uint64_t) + 4 * sizeof(float) + sizeof(uint16_t) + sizeof(uint8_t)) +
+           (size_t)pointCloudSlots(capacity) * sizeof(uint32_t) + 8;
+}
+
+class PointCloud {
+public:
+    PointCloud() : cap(0), slots(0), n(0), voxel(0) {}
+
+    // mem deve durare quanto la nuvola; false se bytes < pointCloudBytes()
+    bool begin(void *mem, size_t bytes, uint32_t capacity, float voxelMm) {
+        if (!mem || capacity == 0 || bytes < pointCloudBytes(capacity)) return false;
+        cap = capacity;
+        slots = pointCloudSlots(capacity);
+
+        // Colonne a 8 byte per prime, poi 4, 2, 1: allineamento naturale
+        uintptr_t p = ((uintptr_t)mem + 7) & ~(uintptr_t)7;
+        keys = (uint64_t *)p;       p += cap * sizeof(uint64_t);
+        px = (float *)p;            p += cap * sizeof(float);
+        py = (float *)p;            p += cap * sizeof(float);
+        pz = (float *)p;            p += cap * sizeof(float);
+        ptime = (uint32_t *)p;      p += cap * sizeof(uint32_t);
+        table = (uint32_t *)p;      p += slots * sizeof(uint32_t);
+        phits = (uint16_t *)p;      p += cap * sizeof(uint16_t);
+        pflags = (uint8_t *)p;
+
+        voxel = voxelMm > 0 ? voxelMm : 0;
+        clear();
+        return true;
+    }
+
+    void clear() {
+        n = 0;
+        inserted = 0;
+        merged = 0;
+        rejected = 0;
+        sum[0] = sum[1] = sum[2] = 0;
+        for (int i = 0; i < 3; i++) {
+            bbMin[i] = INFINITY;
+            bbMax[i] = -INFINITY;
+        }
+        if (table) memset(table, 0xFF, slots * sizeof(uint32_t));
+    }
+
+    PointCloudResult add(float x, float y, float z, uint32_t timeMs, uint8_t flags) {
+        inserted++;
+        if (!isfinite(x) || !isfinite(y) || !isfinite(z)) {
+            rejected++;
+            return POINT_INVALID;
+        }
+
+        uint64_t key = 0;
+        uint32_t slot = 0;
+        if (voxel > 0) {
+            key = voxelKey(x, y, z);
+            slot = findSlot(key);
+            uint32_t idx = table[slot];
+            if (idx != POINT_CLOUD_SLOT_EMPTY) {
+                mergeInto(idx, x, y, z, 1, timeMs, flags);
+                expandBox(x, y, z);
+                merged++;
+                return POINT_MERGED;
+            }
+        }
+        if (n == cap) {
+            rejected++;
+            return POINT_FULL;          // Scartato: non allarga il box
+        }
+        expandBox(x, y, z);
+
+        keys[n] = key;
+        px[n] = x;
+        py[n] = y;
+        pz[n] = z;
+        ptime[n] = timeMs;
+        phits[n] = 1;
+        pflags[n] = flags;
+        sum[0] += x;
+        sum[1] += y;
+        sum[2] += z;
+        if (voxel > 0) table[slot] = n;
+        n++;
+        return POINT_ADDED;
+    }
+
+    // Punto del task sensori (coordinate già calcolate)
+    PointCloudResult add(const SensorData &d, uint8_t flags) {
+        return add(d.x_mm, d.y_mm, d.z_mm, usToMs(d.timestamp_us), flags);
+    }
+
+    // Nuovo lato del voxel: i punti esistenti vengono riassegnati e fusi
+    // in place (O(n), nessuna memoria extra). 0 = nessuna deduplicazione.
+    void setVoxelSize(float voxelMm) {
+        voxel = voxelMm > 0 ? voxelMm : 0;
+        if (!table) return;
+        memset(table, 0xFF, slots * sizeof(uint32_t));
+        uint32_t count = n;
+        n = 0;
+        sum[0] = sum[1] = sum[2] = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t key = 0;
+            uint32_t slot = 0;
+            if (voxel > 0) {
+                key = voxelKey(px[i], py[i], pz[i]);
+                slot = findSlot(key);
+                uint32_t idx = table[slot];
+                if (idx != POINT_CLOUD_SLOT_EMPTY) {
+                    mergeInto(idx, px[i], py[i], pz[i], phits[i], ptime[i], pflags[i]);
+                    continue;
+                }
+                table[slot] = n;
+            }
+            keys[n] = key;
+            px[n] = px[i];
+            py[n] = py[i];
+            pz[n] = pz[i];
+            ptime[n] = ptime[i];
+            phits[n] = phits[i];
+            pflags[n] = pflags[i];
+            sum[0] += px[n];
+            sum[1] += py[n];
+            sum[2] += pz[n];
+            n++;
+        }
+    }
+
+    void getStats(PointCloudStats &s) const {
+        s.count = n;
+        s.capacity = cap;
+        s.inserted = inserted;
+        s.merged = merged;
+        s.rejected = rejected;
+        s.voxel_mm = voxel;
+        for (int i = 0; i < 3; i++) {
+            s.min_mm[i] = n ? bbMin[i] : 0;
+            s.max_mm[i] = n ? bbMax[i] : 0;
+            s.centroid_mm[i] = n ? (float)(sum[i] / n) : 0;
+        }
+    }
+
+    // === COLONNE (lettura diretta per trasformazioni ed export) ===
+    uint32_t size() const { return n; }
+    uint32_t capacity() const { return cap; }
+    float voxelSize() const { return voxel; }
+    const float *x() const { return px; }
+    const float *y() const { return py; }
+    const float *z() const { return pz; }
+    const uint32_t *timeMs() const { return ptime; }
+    const uint16_t *hits() const { return phits; }
+    const uint8_t *flags() const { return pflags; }
+
+private:
+    uint64_t voxelKey(float x, float y, float z) const {
+        const int64_t mask = (1 << POINT_CLOUD_VOXEL_BITS) - 1;
+        int64_t ix = (int64_t)floorf(x / voxel) & mask;
+        int64_t iy = (int64_t)floorf(y / voxel) & mask;
+        int64_t iz = (int64_t)floorf(z / voxel) & mask;
+        return ((uint64_t)ix << (2 * POINT_CLOUD_VOXEL_BITS)) | ((uint64_t)iy << POINT_CLOUD_VOXEL_BITS) |
+               (uint64_t)iz;
+    }
+
+    // Slot con la chiave o primo slot vuoto (sondaggio lineare)
+    uint32_t findSlot(uint64_t key) const {
+        uint64_t h = key * 0x9E3779B97F4A7C15ull;   // Fibonacci: voxel vicini su slot lontani
+        uint32_t s = (uint32_t)(h >> 32) & (slots - 1);
+        while (table[s] != POINT_CLOUD_SLOT_EMPTY && keys[table[s]] != key) {
+            s = (s + 1) & (slots - 1);
+        }
+        return s;
+    }
+
+    void mergeInto(uint32_t idx, float x, float y, float z, uint32_t weight, uint32_t timeMs, uint8_t flags) {
+        uint32_t h = phits[idx];
+        uint32_t total = h + weight;
+        float ox = px[idx], oy = py[idx], oz = pz[idx];
+        px[idx] += (x - ox) * weight / total;
+        py[idx] += (y - oy) * weight / total;
+        pz[idx] += (z - oz) * weight / total;
+        sum[0] += px[idx] - ox;
+        sum[1] += py[idx] - oy;
+        sum[2] += pz[idx] - oz;
+        phits[idx] = total > POINT_CLOUD_MAX_HITS ? POINT_CLOUD_MAX_HITS : (uint16_t)total;
+        if (timeMs > ptime[idx]) ptime[idx] = timeMs;    // Ultima osservazione
+        pflags[idx] |= flags;
+    }
+
+    void expandBox(float x, float y, float z) {
+        if (x < bbMin[0]) bbMin[0] = x;
+        if (y < bbMin[1]) bbMin[1] = y;
+        if (z < bbMin[2]) bbMin[2] = z;
+        if (x > bbMax[0]) bbMax[0] = x;
+        if (y > bbMax[1]) bbMax[1] = y;
+        if (z > bbMax[2]) bbMax[2] = z;
+    }
+
+    uint32_t cap;
+    uint32_t slots;
+    uint32_t n;
+    float voxel;
+    uint64_t *keys = nullptr;
+    float *px = nullptr, *py = nullptr, *pz = nullptr;
+    uint32_t *ptime = nullptr;
+    uint32_t *table = nullptr;
+    uint16_t *phits = nullptr;
+    uint8_t *pflags = nullptr;
+    uint32_t inserted = 0, merged = 0, rejected = 0;
+    double sum[3] = {0, 0, 0};
+    float bbMin[3], bbMax[3];
+};
+
+#endif // POINT_CLOUD_H
@@ -0,0 +1,236 @@
+// point_cloud_service.cpp
+#include "point_cloud_service.h"
+#include "task_config.h"
+#include "sensor_tasks.h"
+#include "auto_capture.h"
+#include "measure_service.h"
+#include "esp_heap_caps.h"
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t cloudTaskHandle = NULL;
+static SemaphoreHandle_t cloudMutex = NULL;
+static PointCloud cloud;                        // Sotto cloudMutex
+static bool inPSRAM = false;
+static volatile PointCloudMode mode = POINT_CLOUD_OFF;
+static volatile float voxelMm = POINT_CLOUD_DEFAULT_VOXEL_MM;
+static CoordMount mount = {{0, 0, 0}, 0, 0};    // Sotto mountMux
+static portMUX_TYPE mountMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Solo il task
+static int8_t cloudSub = -1;
+static uint32_t seenCaptures = 0;
+static uint32_t seenMeasures = 0;
+
+// Coordinate dal montaggio corrente (roll compreso) invece di quelle del
+// task sensori, che assumono il radar sull'asse di rotazione
+static void addPoint(float distance, float pitch, float yaw, float roll, timestamp_us_t t, uint8_t flags) {
+    CoordMount m;
+    portENTER_CRITICAL(&mountMux);
+    m = mount;
+    portEXIT_CRITICAL(&mountMux);
+
+    float x, y, z;
+    coordTransformPoint(distance, pitch, yaw, roll, m, x, y, z);
+    if (!TAKE_MUTEX(cloudMutex, MS_TO_TICKS(POINT_CLOUD_LOCK_TIMEOUT_MS))) return;
+    cloud.add(x, y, z, usToMs(t), flags);
+    GIVE_MUTEX(cloudMutex);
+}
+
+// Catture e misure nuove dall'ultimo giro (contatori dei rispettivi moduli)
+static void collectEvents() {
+    AutoCaptureStatus capture;
+    getAutoCaptureStatus(capture);
+    if (capture.captures != seenCaptures) {
+        seenCaptures = capture.captures;
+        const SensorData &d = capture.last;
+        addPoint(d.distance_mm, d.pitch_deg, d.yaw_deg, d.roll_deg, d.timestamp_us, POINT_FLAG_CAPTURED);
+    }
+
+    MeasureStats stats;
+    getMeasureStats(stats);
+    MeasureResult r;
+    if (stats.count != seenMeasures && getLastMeasurement(r)) {
+        seenMeasures = stats.count;
+        if (r.status == MEASURE_OK) {
+            // La misura non media il roll: punto con roll nullo
+            addPoint(r.distance_mm, r.pitch_deg, r.yaw_deg, 0, r.trigger_us, POINT_FLAG_MEASURED);
+        }
+    }
+}
+
+// === TASK ===
+static void pointCloudTask(void *pvParameters) {
+    RTOS_LOG("Point cloud task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_CLOUD);
+
+    // Eventi precedenti all'avvio non entrano nella nuvola
+    AutoCaptureStatus capture;
+    getAutoCaptureStatus(capture);
+    seenCaptures = capture.captures;
+    MeasureStats stats;
+    getMeasureStats(stats);
+    seenMeasures = stats.count;
+
+    while (1) {
+        PointCloudMode m = mode;
+        SensorBootState boot = getSensorBootState();
+        if (m == POINT_CLOUD_OFF || boot != SENSOR_BOOT_DONE) {
+            if (cloudSub >= 0) {
+                unsubscribeSensorData(cloudSub);
+                cloudSub = -1;
+            }
+            // In OFF fermo fino a setPointCloudMode(); si riprova a tempo
+            // solo mentre i sensori si avviano
+            ulTaskNotifyTake(pdTRUE, m != POINT_CLOUD_OFF && boot != SENSOR_BOOT_FAILED ?
+                                     MS_TO_TICKS(POINT_CLOUD_IDLE_MS) : portMAX_DELAY);
+
+            // Eventi avvenuti nel frattempo non entrano nella nuvola
+            getAutoCaptureStatus(capture);
+            seenCaptures = capture.captures;
+            getMeasureStats(stats);
+            seenMeasures = stats.count;
+            continue;
+        }
+
+        // Il topic fa da clock (10Hz) anche per catture e misure; mai LOSSLESS:
+        // un task lento perde campioni, non rallenta l'acquisizione
+        if (cloudSub < 0) {
+            cloudSub = subscribeSensorData("cloud", PUBSUB_DECIMATED, 1);
+            if (cloudSub < 0) {
+                vTaskDelay(MS_TO_TICKS(POINT_CLOUD_IDLE_MS));
+                continue;
+            }
+        }
+
+        SensorRecord record;
+        if (readSensorRecord(cloudSub, record, POINT_CLOUD_IDLE_MS) && m == POINT_CLOUD_STREAM &&
+            record.radarValid() && record.imuValid()) {
+            addPoint(record.distanceMm(), record.pitchDeg(), record.yawDeg(), record.rollDeg(),
+                     record.timestamp_us, POINT_FLAG_STREAMED);
+        }
+        collectEvents();
+    }
+}
+
+// === API ===
+bool initPointCloud() {
+    if (cloudTaskHandle) return true;
+
+    cloudMutex = xSemaphoreCreateMutex();
+    flightRegisterMutex(cloudMutex, FR_MUTEX_CLOUD);
+    if (!cloudMutex) {
+        Serial.println("❌ Failed to create point cloud mutex");
+        return false;
+    }
+
+    // Allocazione unica per tutta la vita del firmware
+    uint32_t capacity = POINT_CLOUD_CAPACITY;
+    size_t bytes = pointCloudBytes(capacity);
+    void *mem = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    inPSRAM = mem != NULL;
+    if (!mem) {
+        capacity = POINT_CLOUD_INTERNAL_CAPACITY;
+        bytes = pointCloudBytes(capacity);
+        mem = heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    }
+    if (!mem || !cloud.begin(mem, bytes, capacity, voxelMm)) {
+        Serial.println("❌ Point cloud buffer allocation failed");
+        return false;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        pointCloudTask,
+        "PointCloud",
+        CLOUD_TASK_STACK_SIZE,
+        NULL,
+        CLOUD_TASK_PRIORITY,
+        &cloudTaskHandle,
+        CLOUD_TASK_CORE
+    );
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create point cloud task");
+        return false;
+    }
+
+    Serial.printf("✅ Point cloud: %lu punti in %s (%u KB)\n", (unsigned long)capacity,
+                  inPSRAM ? "PSRAM" : "RAM interna", (unsigned)(bytes / 1024));
+    return true;
+}
+
+void setPointCloudMode(PointCloudMode m) {
+    mode = m > POINT_CLOUD_STREAM ? POINT_CLOUD_OFF : m;
+    if (cloudTaskHandle) xTaskNotifyGive(cloudTaskHandle);
+}
+
+PointCloudMode getPointCloudMode() {
+    return mode;
+}
+
+void setPointCloudVoxel(float mm) {
+    voxelMm = mm > 0 ? mm : 0;
+    if (!cloudMutex || !TAKE_MUTEX(cloudMutex, portMAX_DELAY)) return;
+    cloud.setVoxelSize(voxelMm);
+    GIVE_MUTEX(cloudMutex);
+}
+
+float getPointCloudVoxel() {
+    return voxelMm;
+}
+
+void setPointCloudMount(const CoordMount &m) {
+    portENTER_CRITICAL(&mountMux);
+    mount = m;
+    portEXIT_CRITICAL(&mountMux);
+}
+
+void getPointCloudMount(CoordMount &m) {
+    portENTER_CRITICAL(&mountMux);
+    m = mount;
+    portEXIT_CRITICAL(&mountMux);
+}
+
+void clearPointCloud() {
+    if (!cloudMutex || !TAKE_MUTEX(cloudMutex, portMAX_DELAY)) return;
+    cloud.clear();
+    GIVE_MUTEX(cloudMutex);
+}
+
+void getPointCloudStats(PointCloudStats &stats) {
+    memset(&stats, 0, sizeof(stats));
+    if (!cloudMutex || !TAKE_MUTEX(cloudMutex, MS_TO_TICKS(POINT_CLOUD_LOCK_TIMEOUT_MS))) return;
+    cloud.getStats(stats);
+    GIVE_MUTEX(cloudMutex);
+}
+
+bool lockPointCloud(PointCloudView &view, uint32_t timeout_ms) {
+    if (!cloudMutex || !TAKE_MUTEX(cloudMutex, MS_TO_TICKS(timeout_ms))) return false;
+    view.x = cloud.x();
+    view.y = cloud.y();
+    view.z = cloud.z();
+    view.time_ms = cloud.timeMs();
+    view.hits = cloud.hits();
+    view.flags = cloud.flags();
+    view.count = cloud.size();
+    return true;
+}
+
+void unlockPointCloud() {
+    GIVE_MUTEX(cloudMutex);
+}
+
+void printPointCloudStats() {
+    static const char *modes[] = {"OFF", "CAPTURE", "STREAM"};
+    PointCloudStats s;
+    getPointCloudStats(s);
+    Serial.printf("\n=== Point Cloud (%s, %s) ===\n", modes[mode], inPSRAM ? "PSRAM" : "RAM");
+    Serial.printf("Punti %lu/%lu, campioni %lu (fusi %lu, scartati %lu), voxel %.1fmm\n",
+                  (unsigned long)s.count, (unsigned long)s.capacity, (unsigned long)s.inserted,
+                  (unsigned long)s.merged, (unsigned long)s.rejected, s.voxel_mm);
+    if (s.count > 0) {
+        Serial.printf("Box X %.0f..%.0f Y %.0f..%.0f Z %.0f..%.0f mm\n",
+                      s.min_mm[0], s.max_mm[0], s.min_mm[1], s.max_mm[1], s.min_mm[2], s.max_mm[2]);
+        Serial.printf("Centroide %.1f %.1f %.1f mm\n",
+                      s.centroid_mm[0], s.centroid_mm[1], s.centroid_mm[2]);
+    }
+    Serial.println("=====================\n");
+}
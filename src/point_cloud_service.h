@@ -0,0 +1,58 @@
+// point_cloud_service.h
+#ifndef POINT_CLOUD_SERVICE_H
+#define POINT_CLOUD_SERVICE_H
+
+#include <Arduino.h>
+#include "point_cloud.h"
+#include "coord_transform.h"
+
+// === ACCUMULO NUVOLA DI PUNTI ===
+// Buffer unico allocato una volta in PSRAM all'avvio (fallback ridotto in
+// RAM interna se la PSRAM manca). Un task a bassa priorità raccoglie i
+// punti: catture automatiche e misure su trigger sempre (tranne in OFF),
+// più il flusso continuo del topic sensori in modalità STREAM. Il ciclo
+// sensori non viene mai toccato. Le coordinate si ricalcolano qui con
+// coordTransformPoint(): roll e offset di montaggio del radar compresi.
+
+#define POINT_CLOUD_CAPACITY          32768   // ~1.1MB in PSRAM con la tabella hash
+#define POINT_CLOUD_INTERNAL_CAPACITY 2048    // Senza PSRAM (~70KB)
+#define POINT_CLOUD_DEFAULT_VOXEL_MM  10.0f
+#define POINT_CLOUD_IDLE_MS           250     // Riprova durante il boot sensori / topic non pronto
+#define POINT_CLOUD_LOCK_TIMEOUT_MS   100
+
+enum PointCloudMode : uint8_t {
+    POINT_CLOUD_OFF = 0,
+    POINT_CLOUD_CAPTURE,        // Solo catture e misure
+    POINT_CLOUD_STREAM          // Anche ogni campione valido del flusso (sweep)
+};
+
+// Vista in sola lettura sulle colonne, valida fino a unlockPointCloud()
+struct PointCloudView {
+    const float *x;
+    const float *y;
+    const float *z;
+    const uint32_t *time_ms;
+    const uint16_t *hits;
+    const uint8_t *flags;
+    uint32_t count;
+};
+
+bool initPointCloud();
+
+void setPointCloudMode(PointCloudMode mode);
+PointCloudMode getPointCloudMode();
+void setPointCloudVoxel(float voxelMm);     // Rifonde i punti esistenti
+float getPointCloudVoxel();
+void setPointCloudMount(const CoordMount &mount);   // Vale per i punti successivi
+void getPointCloudMount(CoordMount &mount);
+void clearPointCloud();
+void getPointCloudStats(PointCloudStats &stats);
+
+// Accesso diretto per export/trasformazioni: blocca l'accumulo finché non
+// si chiama unlockPointCloud() (i campioni in STREAM nel frattempo si perdono)
+bool lockPointCloud(PointCloudView &view, uint32_t timeout_ms);
+void unlockPointCloud();
+
+void printPointCloudStats();
+
+#endif // POINT_CLOUD_SERVICE_H
@@ -0,0 +1,152 @@
+// point_export.h
+// Export di punti 3D in PLY binario (little endian) o XYZ ASCII, scritto a
+// blocchi grandi e sequenziali su un buffer del chiamante: una write per
+// blocco, nessuna allocazione. Proprietà per punto: x y z (mm), time_s,
+// strength, valid, flags. Il numero di punti nell'header PLY ha larghezza
+// fissa, così si riscrive a fine export quando il totale cambia (nuvola che
+// cresce durante la copia, log filtrati). I file si aprono direttamente in
+// CloudCompare/MeshLab.
+// Header puro C++: lo usano cloud_export.cpp sul device e
+// tools/cloud_export_cli.cpp sull'host.
+#ifndef POINT_EXPORT_H
+#define POINT_EXPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define POINT_EXPORT_PLY_BYTES     26      // Byte per punto nel PLY binario
+#define POINT_EXPORT_XYZ_MAX_LINE  96
+#define POINT_EXPORT_HEADER_MAX    384
+
+enum PointExportFormat : uint8_t {
+    POINT_EXPORT_PLY = 0,       // Binario: ~26 byte/punto, il più veloce da scrivere e leggere
+    POINT_EXPORT_XYZ            // Testo "x y z time strength valid flags" per riga
+};
+
+// strength: supporto del punto (campioni fusi nel voxel, 1 per un campione
+// grezzo): il driver radar non legge ancora l'ampiezza del picco.
+struct ExportPoint {
+    float x_mm, y_mm, z_mm;
+    double time_s;              // Timebase del device
+    float strength;
+    uint8_t valid;              // Radar e IMU validi
+    uint8_t flags;              // POINT_FLAG_* (nuvola) o RECORD_FLAG_* (log grezzi)
+};
+
+inline const char *pointExportExtension(PointExportFormat f) {
+    return f == POINT_EXPORT_XYZ ? "xyz" : "ply";
+}
+
+// Header PLY con conteggio a 10 cifre: stessa lunghezza per ogni count
+inline size_t pointExportPlyHeader(char *buf, size_t max, uint32_t count) {
+    int n = snprintf(buf, max,
+                     "ply\n"
+                     "format binary_little_endian 1.0\n"
+                     "comment HySeq radar point cloud, mm\n"
+                     "element vertex %010lu\n"
+                     "property float x\n"
+                     "property float y\n"
+                     "property float z\n"
+                     "property double time_s\n"
+                     "property float strength\n"
+                     "property uchar valid\n"
+                     "property uchar flags\n"
+                     "end_header\n",
+                     (unsigned long)count);
+    return n > 0 && (size_t)n < max ? (size_t)n : 0;
+}
+
+// === DESTINAZIONE ===
+// File su SD (device) o FILE* (host). rewrite() serve solo per il PLY.
+class ExportSink {
+public:
+    virtual ~ExportSink() {}
+    virtual bool write(const uint8_t *data, size_t len) = 0;
+    virtual bool rewrite(uint32_t offset, const uint8_t *data, size_t len) = 0;
+};
+
+// === WRITER ===
+class PointExportWriter {
+public:
+    PointExportWriter() : sink(nullptr), buf(nullptr), cap(0), used(0), n(0), total(0), ok(false) {}
+
+    // buf deve restare valido fino a finish(); almeno 1KB, meglio 8-32KB
+    bool begin(ExportSink &s, uint8_t *buffer, size_t bytes, PointExportFormat f) {
+        sink = &s;
+        buf = buffer;
+        cap = bytes;
+        format = f;
+        used = 0;
+        n = 0;
+        total = 0;
+        ok = buffer && bytes >= POINT_EXPORT_HEADER_MAX && bytes >= POINT_EXPORT_XYZ_MAX_LINE;
+        if (ok && format == POINT_EXPORT_PLY) {
+            used = pointExportPlyHeader((char *)buf, cap, 0);
+            ok = used > 0;
+        }
+        return ok;
+    }
+
+    bool add(const ExportPoint &p) {
+        if (!ok) return false;
+        size_t need = format == POINT_EXPORT_PLY ? POINT_EXPORT_PLY_BYTES : POINT_EXPORT_XYZ_MAX_LINE;
+        if (cap - used < need && !flush()) return false;
+
+        uint8_t *o = buf + used;
+        if (format == POINT_EXPORT_PLY) {
+            // Layout dell'header, little endian come ESP32 e x86/ARM
+            memcpy(o, &p.x_mm, 4);
+            memcpy(o + 4, &p.y_mm, 4);
+            memcpy(o + 8, &p.z_mm, 4);
+            memcpy(o + 12, &p.time_s, 8);
+            memcpy(o + 20, &p.strength, 4);
+            o[24] = p.valid;
+            o[25] = p.flags;
+            used += POINT_EXPORT_PLY_BYTES;
+        } else {
+            int len = snprintf((char *)o, cap - used, "%.2f %.2f %.2f %.6f %.0f %u %u\n",
+                               p.x_mm, p.y_mm, p.z_mm, p.time_s, p.strength, p.valid, p.flags);
+            if (len <= 0 || (size_t)len >= cap - used) return ok = false;
+            used += len;
+        }
+        n++;
+        return true;
+    }
+
+    // Scarica l'ultimo blocco e corregge il conteggio nell'header
+    bool finish() {
+        if (!ok || !flush()) return false;
+        if (format == POINT_EXPORT_PLY) {
+            char header[POINT_EXPORT_HEADER_MAX];
+            size_t len = pointExportPlyHeader(header, sizeof(header), n);
+            ok = len > 0 && sink->rewrite(0, (const uint8_t *)header, len);
+        }
+        return ok;
+    }
+
+    uint32_t count() const { return n; }
+    uint64_t bytes() const { return total + used; }
+    bool failed() const { return !ok; }
+
+private:
+    bool flush() {
+        if (used == 0) return true;
+        if (!sink->write(buf, used)) return ok = false;
+        total += used;
+        used = 0;
+        return true;
+    }
+
+    ExportSink *sink;
+    uint8_t *buf;
+    size_t cap;
+    size_t used;
+    uint32_t n;
+    uint64_t total;
+    bool ok;
+    PointExportFormat format = POINT_EXPORT_PLY;
+};
+
+#endif // POINT_EXPORT_H
@@ -0,0 +1,268 @@
+// power_manager.cpp
+#include "power_manager.h"
+#include "freertos/task.h"
+#include "task_config.h"
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <esp_freertos_hooks.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+
+// === VARIABILI DI STATO ===
+static EventGroupHandle_t uiEvents = NULL;
+static bool touchIrqActive = false;
+static int touchIrqPin = -1;
+static volatile bool touchWakeLevel = false;   // IRQ a livello per il risveglio
+static bool pmActive = false;
+
+static uint32_t noSleepHolders = 0;            // Bit PM_HOLD_*
+static portMUX_TYPE holdersMux = portMUX_INITIALIZER_UNLOCKED;
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t noSleepLock = NULL;
+static bool noSleepHeld = false;
+#endif
+
+// Contatori risvegli idle (incrementati dagli idle hook)
+static volatile uint32_t idleWakeups[portNUM_PROCESSORS] = {0};
+
+// Snapshot precedente per il calcolo a finestra
+static int64_t lastReportUs = 0;
+static uint32_t lastWakeups[portNUM_PROCESSORS] = {0};
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define IDLE_RUNTIME_STATS 1
+#define MAX_TRACKED_TASKS 32
+static TaskStatus_t taskStatus[MAX_TRACKED_TASKS];
+static uint32_t lastIdleRuntime[portNUM_PROCESSORS] = {0};
+static uint32_t lastTotalRuntime = 0;
+#else
+#define IDLE_RUNTIME_STATS 0
+#endif
+
+// === IDLE HOOK ===
+// Chiamati a ogni giro del task IDLE: con tickless idle ogni giro
+// corrisponde a un risveglio, quindi meno giri = sleep più lunghi.
+static bool idleHookCore0() {
+    idleWakeups[0]++;
+    return true;
+}
+
+#if portNUM_PROCESSORS > 1
+static bool idleHookCore1() {
+    idleWakeups[1]++;
+    return true;
+}
+#endif
+
+// === ISR TOUCH ===
+static void IRAM_ATTR touchIsr() {
+    // A livello basso l'interrupt rientrerebbe finché INT resta basso:
+    // si spegne qui e waitUIEvent() lo riaccende alla prossima attesa
+    if (touchWakeLevel) gpio_intr_disable((gpio_num_t)touchIrqPin);
+    BaseType_t woken = pdFALSE;
+    xEventGroupSetBitsFromISR(uiEvents, UI_EVENT_TOUCH, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+// === INIZIALIZZAZIONE ===
+bool initPowerManagement() {
+    esp_register_freertos_idle_hook_for_cpu(idleHookCore0, 0);
+#if portNUM_PROCESSORS > 1
+    esp_register_freertos_idle_hook_for_cpu(idleHookCore1, 1);
+#endif
+    lastReportUs = esp_timer_get_time();
+
+#if CONFIG_PM_ENABLE
+    esp_pm_config_esp32s3_t pmConfig = {};
+    pmConfig.max_freq_mhz = PM_MAX_CPU_FREQ_MHZ;
+    pmConfig.min_freq_mhz = PM_MIN_CPU_FREQ_MHZ;
+  #if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    // Senza IRQ touch nulla risveglierebbe la UI da un tocco
+    pmConfig.light_sleep_enable = PM_LIGHT_SLEEP_ENABLE && touchIrqActive;
+  #else
+    pmConfig.light_sleep_enable = false;
+  #endif
+
+    // Risveglio dal light sleep su INT basso: il fronte non è visto in sleep,
+    // quindi l'interrupt del pin passa a livello (gestito in touchIsr)
+    if (pmConfig.light_sleep_enable) {
+        gpio_wakeup_enable((gpio_num_t)touchIrqPin, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+        touchWakeLevel = true;
+    }
+
+    esp_err_t err = esp_pm_configure(&pmConfig);
+    if (err != ESP_OK) {
+        Serial.printf("❌ esp_pm_configure fallita: %s\n", esp_err_to_name(err));
+        return false;
+    }
+
+    esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "no_sleep", &noSleepLock);
+    setLightSleepAllowed(0, true);     // Divieti chiesti prima dell'init
+
+    pmActive = true;
+    Serial.printf("✅ Power management: DFS %d-%d MHz, light sleep %s\n",
+                  PM_MIN_CPU_FREQ_MHZ, PM_MAX_CPU_FREQ_MHZ,
+                  pmConfig.light_sleep_enable ? "ON" : "OFF");
+    return true;
+#else
+    Serial.println("⚠️ CONFIG_PM_ENABLE assente: frequenza CPU fissa");
+    return false;
+#endif
+}
+
+bool initUIEvents() {
+    if (uiEvents) return true;
+
+    uiEvents = xEventGroupCreate();
+    if (!uiEvents) {
+        Serial.println("❌ Failed to create UI event group");
+        return false;
+    }
+    return true;
+}
+
+bool initTouchInterrupt(int pin) {
+    if (pin < 0 || !uiEvents) {
+        touchIrqActive = false;
+        return false;
+    }
+
+    pinMode(pin, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(pin), touchIsr, FALLING);
+    touchIrqPin = pin;
+    touchIrqActive = true;
+    return true;
+}
+
+bool isTouchInterruptActive() {
+    return touchIrqActive;
+}
+
+// === ATTESA EVENTI ===
+void notifyUIEvent(EventBits_t bits) {
+    if (uiEvents) {
+        xEventGroupSetBits(uiEvents, bits);
+    }
+}
+
+EventBits_t waitUIEvent(EventBits_t bits, uint32_t timeout_ms) {
+    // Senza IRQ il touch va interrogato a intervalli regolari
+    bool pollTouch = (bits & UI_EVENT_TOUCH) && !touchIrqActive;
+    if (pollTouch && timeout_ms > TOUCH_SCAN_RATE_MS) {
+        timeout_ms = TOUCH_SCAN_RATE_MS;
+    }
+
+    if (touchWakeLevel) gpio_intr_enable((gpio_num_t)touchIrqPin);
+
+    EventBits_t received = 0;
+    if (uiEvents) {
+        TickType_t ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : MS_TO_TICKS(timeout_ms);
+        received = xEventGroupWaitBits(uiEvents, bits, pdTRUE, pdFALSE, ticks) & bits;
+    } else {
+        delay(timeout_ms);
+    }
+
+    if (pollTouch) {
+        received |= UI_EVENT_TOUCH;
+    }
+    return received;
+}
+
+bool waitForTouch(uint32_t timeout_ms) {
+    return (waitUIEvent(UI_EVENT_TOUCH, timeout_ms) & UI_EVENT_TOUCH) != 0;
+}
+
+void setLightSleepAllowed(uint32_t holder, bool allowed) {
+    portENTER_CRITICAL(&holdersMux);
+    if (allowed) {
+        noSleepHolders &= ~holder;
+    } else {
+        noSleepHolders |= holder;
+    }
+
+#if CONFIG_PM_ENABLE
+    // Un solo acquire sul lock, qualunque sia il numero di holder
+    // (acquire/release sono in IRAM e annidabili nella sezione critica)
+    bool hold = noSleepHolders != 0;
+    if (noSleepLock && hold != noSleepHeld) {
+        if (hold) {
+            esp_pm_lock_acquire(noSleepLock);
+        } else {
+            esp_pm_lock_release(noSleepLock);
+        }
+        noSleepHeld = hold;
+    }
+#endif
+    portEXIT_CRITICAL(&holdersMux);
+}
+
+// === REPORT IDLE ===
+void getIdleReport(IdleReport &report) {
+    int64_t now = esp_timer_get_time();
+    int64_t windowUs = now - lastReportUs;
+    if (windowUs <= 0) windowUs = 1;
+    lastReportUs = now;
+
+    report.window_ms = (uint32_t)(windowUs / 1000);
+    report.pm_active = pmActive;
+    report.cpu_freq_mhz = ESP.getCpuFreqMHz();
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        uint32_t wakeups = idleWakeups[core];
+        report.core[core].idle_wakeups = wakeups - lastWakeups[core];
+        report.core[core].wakeups_per_sec = report.core[core].idle_wakeups * 1e6f / windowUs;
+        report.core[core].idle_pct = 0;
+        lastWakeups[core] = wakeups;
+    }
+
+#if IDLE_RUNTIME_STATS
+    uint32_t totalRuntime = 0;
+    UBaseType_t count = uxTaskGetSystemState(taskStatus, MAX_TRACKED_TASKS, &totalRuntime);
+    uint32_t deltaTotal = totalRuntime - lastTotalRuntime;
+    lastTotalRuntime = totalRuntime;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(core);
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (taskStatus[i].xHandle != idle) continue;
+
+            uint32_t deltaIdle = taskStatus[i].ulRunTimeCounter - lastIdleRuntime[core];
+            lastIdleRuntime[core] = taskStatus[i].ulRunTimeCounter;
+            if (deltaTotal > 0) {
+                report.core[core].idle_pct = min(100.0f, deltaIdle * 100.0f / deltaTotal);
+            }
+            break;
+        }
+    }
+    report.runtime_stats = true;
+#else
+    report.runtime_stats = false;
+#endif
+}
+
+void printIdleReport() {
+    IdleReport report;
+    getIdleReport(report);
+
+    Serial.printf("💤 Idle (%lums, %luMHz, PM %s):",
+                  (unsigned long)report.window_ms,
+                  (unsigned long)report.cpu_freq_mhz,
+                  report.pm_active ? "ON" : "OFF");
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (report.runtime_stats) {
+            Serial.printf(" C%d %.1f%% %.0f wk/s", core,
+                          report.core[core].idle_pct,
+                          report.core[core].wakeups_per_sec);
+        } else {
+            Serial.printf(" C%d n/a %.0f wk/s", core,
+                          report.core[core].wakeups_per_sec);
+        }
+    }
+    Serial.println();
+
+#if CONFIG_PM_PROFILING
+    // Residenza per modalità (CPU max / APB max / light sleep)
+    esp_pm_dump_locks(stdout);
+#endif
+}
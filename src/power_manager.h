@@ -0,0 +1,79 @@
+// power_manager.h
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+
+// === CONFIGURAZIONE POWER MANAGEMENT ===
+// Richiede CONFIG_PM_ENABLE e CONFIG_FREERTOS_USE_TICKLESS_IDLE nello sdkconfig,
+// altrimenti initPowerManagement() lascia la CPU a frequenza fissa.
+#define PM_MAX_CPU_FREQ_MHZ    240     // Frequenza piena (display, calcoli)
+#define PM_MIN_CPU_FREQ_MHZ    80      // DFS: frequenza minima quando idle
+// Light sleep automatico in idle: spento finché TP_INT non è verificato
+// sulla scheda, altrimenti il touch non risveglia la CPU
+#define PM_LIGHT_SLEEP_ENABLE  0
+
+// Pin interrupt touch CST328 (attivo basso), come nel pinout di riferimento
+// della scheda (TP_SDA 1 / TP_SCL 3): non ancora verificato sullo schematico.
+// È anche la sorgente di risveglio dal light sleep (livello basso).
+#define TP_INT                 4
+
+// Chi vieta il light sleep: bit indipendenti, basta uno attivo
+#define PM_HOLD_CONSOLE        (1 << 0)   // Sessione console su USB-CDC
+#define PM_HOLD_TELEMETRY      (1 << 1)   // Stream binario abilitato
+
+// === EVENTI UI (event group) ===
+#define UI_EVENT_TOUCH         (1 << 0)   // IRQ touch CST328
+#define UI_EVENT_SENSOR        (1 << 1)   // Nuovo campione sensori pubblicato
+#define UI_EVENT_BOOT          (1 << 2)   // Boot sensori in background terminato
+#define UI_EVENT_MEASURE       (1 << 3)   // Nuova misura su trigger (measure_service)
+#define UI_EVENT_CAPTURE       (1 << 4)   // Punto catturato da fermo (auto_capture)
+#define UI_EVENT_MAG_CAL       (1 << 5)   // Calibrazione magnetometro conclusa (imu_handler)
+#define UI_EVENT_ALL           (UI_EVENT_TOUCH | UI_EVENT_SENSOR | UI_EVENT_BOOT | \
+                                UI_EVENT_MEASURE | UI_EVENT_CAPTURE | UI_EVENT_MAG_CAL)
+
+// === INIZIALIZZAZIONE ===
+bool initPowerManagement();            // DFS + light sleep automatico
+bool initUIEvents();                   // Event group condiviso UI/sensori
+bool initTouchInterrupt(int pin);      // ISR su INT del touch
+bool isTouchInterruptActive();
+
+// === ATTESA EVENTI (sostituisce i delay() di polling) ===
+// Segnala uno o più eventi alla UI (da task, non da ISR)
+void notifyUIEvent(EventBits_t bits);
+
+// Blocca finché arriva uno degli eventi richiesti o scade il timeout.
+// Ritorna i bit ricevuti (0 = timeout). Senza IRQ touch, UI_EVENT_TOUCH
+// viene simulato ogni TOUCH_SCAN_RATE_MS per mantenere il polling.
+EventBits_t waitUIEvent(EventBits_t bits, uint32_t timeout_ms);
+
+// Scorciatoia per i loop delle leaf action: true se conviene leggere il touch
+bool waitForTouch(uint32_t timeout_ms);
+
+// Vieta il light sleep per conto di holder (PM_HOLD_*): in light sleep la
+// USB-CDC si ferma e console/telemetria perderebbero byte. Si può chiamare
+// anche prima di initPowerManagement(): il divieto vale da quando parte.
+void setLightSleepAllowed(uint32_t holder, bool allowed);
+
+// === REPORT IDLE PER CORE ===
+struct CoreIdleStats {
+    float idle_pct;            // % tempo nel task IDLE (include light sleep)
+    uint32_t idle_wakeups;     // Iterazioni idle nella finestra (risvegli)
+    float wakeups_per_sec;
+};
+
+struct IdleReport {
+    CoreIdleStats core[portNUM_PROCESSORS];
+    uint32_t window_ms;        // Durata finestra di misura
+    bool runtime_stats;        // false = % idle non disponibile
+    bool pm_active;            // DFS/light sleep configurati
+    uint32_t cpu_freq_mhz;
+};
+
+// Calcola il report sulla finestra dall'ultima chiamata
+void getIdleReport(IdleReport &report);
+void printIdleReport();
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,210 @@
+// pubsub_ring.h
+// Ring condiviso publish/subscribe: un solo buffer, un cursore per subscriber.
+// Nessuna dipendenza da Arduino/FreeRTOS (il locking è del chiamante, vedi
+// pubsub_topic.h), così la logica delle policy gira anche su host.
+#ifndef PUBSUB_RING_H
+#define PUBSUB_RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+// === POLICY DI OVERFLOW PER SUBSCRIBER ===
+enum PubSubPolicy : uint8_t {
+    PUBSUB_LATEST_ONLY = 0,     // Solo il più recente: i non letti vengono saltati
+    PUBSUB_LOSSLESS,            // Tutti, in ordine: il publisher attende (backpressure)
+    PUBSUB_DECIMATED            // Uno ogni N (numero di sequenza multiplo di N)
+};
+
+struct PubSubSubscriberStats {
+    uint32_t delivered;         // Campioni consegnati
+    uint32_t skipped;           // Scartati dalla policy (superati / decimati)
+    uint32_t dropped;           // Persi: sovrascritti prima della lettura
+    uint32_t lag;               // Pubblicati e non ancora letti
+    uint32_t max_lag;
+};
+
+template <typename T, uint16_t CAPACITY, uint8_t MAX_SUBSCRIBERS>
+class PubSubRing {
+public:
+    PubSubRing() { reset(); }
+
+    void reset() {
+        head = 0;
+        memset(subs, 0, sizeof(subs));
+    }
+
+    // === SUBSCRIBER ===
+    // Ritorna l'id (>= 0) o -1 se non ci sono slot. Il cursore parte dal
+    // prossimo campione: lo storico già nel ring non viene riconsegnato.
+    int8_t subscribe(uint8_t policy, uint16_t decimation = 1) {
+        for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+            if (subs[i].active) continue;
+            memset(&subs[i], 0, sizeof(subs[i]));
+            subs[i].active = true;
+            subs[i].policy = policy;
+            subs[i].decimation = decimation ? decimation : 1;
+            subs[i].cursor = head;
+            return (int8_t)i;
+        }
+        return -1;
+    }
+
+    void unsubscribe(int8_t id) {
+        if (valid(id)) subs[id].active = false;
+    }
+
+    bool isSubscribed(int8_t id) const { return valid(id); }
+
+    // === PUBLISH ===
+    // false se un subscriber LOSSLESS perderebbe un campione non letto
+    bool canPublish() const {
+        for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+            if (subs[i].active && subs[i].policy == PUBSUB_LOSSLESS &&
+                head - subs[i].cursor >= CAPACITY) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Scrive sempre: chi è indietro di CAPACITY perde il campione più vecchio.
+    // Ritorna il numero di sequenza assegnato.
+    uint32_t publish(const T &item) {
+        for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+            Subscriber &s = subs[i];
+            if (!s.active || head - s.cursor < CAPACITY) continue;
+
+            // Lo slot che sta per essere sovrascritto non è stato letto
+            if (wanted(s, s.cursor)) {
+                s.stats.dropped++;
+            } else {
+                s.stats.skipped++;
+            }
+            s.cursor++;
+        }
+
+        uint32_t seq = head;
+        slots[seq % CAPACITY] = item;
+        head++;
+
+        for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+            Subscriber &s = subs[i];
+            if (!s.active) continue;
+            uint32_t l = head - s.cursor;
+            if (l > s.stats.max_lag) s.stats.max_lag = l;
+        }
+        return seq;
+    }
+
+    // === READ ===
+    bool read(int8_t id, T &out) {
+        if (!valid(id)) return false;
+        Subscriber &s = subs[id];
+
+        switch (s.policy) {
+            case PUBSUB_LATEST_ONLY:
+                if (s.cursor == head) return false;
+                s.stats.skipped += head - s.cursor - 1;
+                out = slots[(head - 1) % CAPACITY];
+                s.cursor = head;
+                s.stats.delivered++;
+                return true;
+
+            case PUBSUB_DECIMATED:
+                while (s.cursor != head) {
+                    uint32_t seq = s.cursor++;
+                    if (wanted(s, seq)) {
+                        out = slots[seq % CAPACITY];
+                        s.stats.delivered++;
+                        return true;
+                    }
+                    s.stats.skipped++;
+                }
+                return false;
+
+            default:    // PUBSUB_LOSSLESS
+                if (s.cursor == head) return false;
+                out = slots[s.cursor % CAPACITY];
+                s.cursor++;
+                s.stats.delivered++;
+                return true;
+        }
+    }
+
+    // Ultimo campione pubblicato, senza consumare nessun cursore
+    bool latest(T &out) const {
+        if (head == 0) return false;
+        out = slots[(head - 1) % CAPACITY];
+        return true;
+    }
+
+    // Ultimi campioni pubblicati in ordine cronologico (al massimo
+    // CAPACITY), senza cursore: il ring è anche lo storico recente
+    uint16_t history(T *out, uint16_t max) const {
+        uint32_t n = head < CAPACITY ? head : CAPACITY;
+        if (n > max) n = max;
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = slots[(head - n + i) % CAPACITY];
+        }
+        return (uint16_t)n;
+    }
+
+    // === STATO ===
+    uint32_t published() const { return head; }
+
+    uint32_t lag(int8_t id) const {
+        return valid(id) ? head - subs[id].cursor : 0;
+    }
+
+    bool hasData(int8_t id) const {
+        return valid(id) && subs[id].cursor != head;
+    }
+
+    // Bit i = subscriber i attivo (per le notifiche del livello RTOS)
+    uint32_t activeMask() const {
+        uint32_t mask = 0;
+        for (uint8_t i = 0; i < MAX_SUBSCRIBERS; i++) {
+            if (subs[i].active) mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    uint8_t policy(int8_t id) const {
+        return valid(id) ? subs[id].policy : (uint8_t)PUBSUB_LATEST_ONLY;
+    }
+
+    void getStats(int8_t id, PubSubSubscriberStats &stats) const {
+        if (!valid(id)) {
+            memset(&stats, 0, sizeof(stats));
+            return;
+        }
+        stats = subs[id].stats;
+        stats.lag = head - subs[id].cursor;
+    }
+
+private:
+    struct Subscriber {
+        bool active;
+        uint8_t policy;
+        uint16_t decimation;
+        uint32_t cursor;            // Prossimo numero di sequenza da leggere
+        PubSubSubscriberStats stats;
+    };
+
+    T slots[CAPACITY];
+    uint32_t head;                  // Prossimo numero di sequenza da scrivere
+    Subscriber subs[MAX_SUBSCRIBERS];
+
+    bool valid(int8_t id) const {
+        return id >= 0 && id < MAX_SUBSCRIBERS && subs[id].active;
+    }
+
+    // Il subscriber vorrebbe questo campione? (decimazione sulla sequenza)
+    static bool wanted(const Subscriber &s, uint32_t seq) {
+        if (s.policy == PUBSUB_LATEST_ONLY) return false;
+        if (s.policy == PUBSUB_DECIMATED) return seq % s.decimation == 0;
+        return true;
+    }
+};
+
+#endif // PUBSUB_RING_H
@@ -0,0 +1,155 @@
+// pubsub_topic.h
+#ifndef PUBSUB_TOPIC_H
+#define PUBSUB_TOPIC_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "pubsub_ring.h"
+#include "task_config.h"
+
+// === TOPIC PUBLISH/SUBSCRIBE (FreeRTOS) ===
+// PubSubRing protetto da spinlock: ogni subscriber ha il proprio cursore,
+// quindi display, logger, telemetria e test non si rubano i campioni.
+// Un event group sveglia i lettori (bit = id subscriber) e, per i LOSSLESS,
+// il publisher in attesa di spazio (PUBSUB_SPACE_BIT).
+
+#define PUBSUB_SPACE_BIT   (1 << 23)    // Un subscriber LOSSLESS ha letto
+
+template <typename T, uint16_t CAPACITY, uint8_t MAX_SUBSCRIBERS>
+class PubSubTopic {
+    static_assert(MAX_SUBSCRIBERS <= 16, "un bit di event group per subscriber");
+
+public:
+    PubSubTopic() : events(NULL) {
+        memset(names, 0, sizeof(names));
+    }
+
+    bool begin() {
+        if (!events) events = xEventGroupCreate();
+        return events != NULL;
+    }
+
+    // === SUBSCRIBER ===
+    int8_t subscribe(const char *name, uint8_t policy, uint16_t decimation = 1) {
+        portENTER_CRITICAL(&lock);
+        int8_t id = ring.subscribe(policy, decimation);
+        if (id >= 0) names[id] = name;
+        portEXIT_CRITICAL(&lock);
+        return id;
+    }
+
+    void unsubscribe(int8_t id) {
+        portENTER_CRITICAL(&lock);
+        ring.unsubscribe(id);
+        portEXIT_CRITICAL(&lock);
+
+        // Un LOSSLESS che se ne va libera spazio
+        if (events) xEventGroupSetBits(events, PUBSUB_SPACE_BIT);
+    }
+
+    // === PUBLISH ===
+    // Con un subscriber LOSSLESS indietro di CAPACITY attende fino a
+    // block_ms che legga, poi sovrascrive comunque (il campione perso finisce
+    // nel suo contatore dropped). Ritorna false se è stato forzato.
+    bool publish(const T &item, uint32_t block_ms) {
+        TickType_t start = xTaskGetTickCount();
+        TickType_t block = MS_TO_TICKS(block_ms);
+
+        while (1) {
+            if (events) xEventGroupClearBits(events, PUBSUB_SPACE_BIT);
+
+            portENTER_CRITICAL(&lock);
+            bool room = ring.canPublish();
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (room || !events || elapsed >= block) {
+                ring.publish(item);
+                uint32_t mask = ring.activeMask();
+                portEXIT_CRITICAL(&lock);
+
+                if (events && mask) xEventGroupSetBits(events, (EventBits_t)mask);
+                return room;
+            }
+            portEXIT_CRITICAL(&lock);
+
+            xEventGroupWaitBits(events, PUBSUB_SPACE_BIT, pdTRUE, pdFALSE, block - elapsed);
+        }
+    }
+
+    // === READ ===
+    // Prossimo campione secondo la policy del subscriber (0 = non bloccante)
+    bool read(int8_t id, T &out, uint32_t timeout_ms) {
+        TickType_t start = xTaskGetTickCount();
+        TickType_t timeout = MS_TO_TICKS(timeout_ms);
+        EventBits_t bit = (id >= 0) ? (EventBits_t)(1u << id) : 0;
+
+        while (1) {
+            portENTER_CRITICAL(&lock);
+            bool ok = ring.read(id, out);
+            bool lossless = ring.policy(id) == PUBSUB_LOSSLESS;
+            portEXIT_CRITICAL(&lock);
+
+            if (ok) {
+                if (lossless && events) xEventGroupSetBits(events, PUBSUB_SPACE_BIT);
+                return true;
+            }
+
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (!bit || !events || elapsed >= timeout) return false;
+
+            // Bit rimasto da una pubblicazione già letta: il giro dopo ricontrolla
+            xEventGroupWaitBits(events, bit, pdTRUE, pdFALSE, timeout - elapsed);
+        }
+    }
+
+    // Ultimo campione, senza cursore (compatibilità con il vecchio peek)
+    bool latest(T &out) {
+        portENTER_CRITICAL(&lock);
+        bool ok = ring.latest(out);
+        portEXIT_CRITICAL(&lock);
+        return ok;
+    }
+
+    // Storico recente (più vecchio per primo), copia sotto lock
+    uint16_t history(T *out, uint16_t max) {
+        portENTER_CRITICAL(&lock);
+        uint16_t n = ring.history(out, max);
+        portEXIT_CRITICAL(&lock);
+        return n;
+    }
+
+    // === STATO ===
+    void getStats(int8_t id, PubSubSubscriberStats &stats) {
+        portENTER_CRITICAL(&lock);
+        ring.getStats(id, stats);
+        portEXIT_CRITICAL(&lock);
+    }
+
+    bool isSubscribed(int8_t id) {
+        portENTER_CRITICAL(&lock);
+        bool active = ring.isSubscribed(id);
+        portEXIT_CRITICAL(&lock);
+        return active;
+    }
+
+    uint8_t getPolicy(int8_t id) {
+        portENTER_CRITICAL(&lock);
+        uint8_t policy = ring.policy(id);
+        portEXIT_CRITICAL(&lock);
+        return policy;
+    }
+
+    const char *getName(int8_t id) const {
+        return (id >= 0 && id < MAX_SUBSCRIBERS && names[id]) ? names[id] : "?";
+    }
+
+    uint32_t published() const { return ring.published(); }
+
+private:
+    PubSubRing<T, CAPACITY, MAX_SUBSCRIBERS> ring;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    EventGroupHandle_t events;
+    const char *names[MAX_SUBSCRIBERS];
+};
+
+#endif // PUBSUB_TOPIC_H
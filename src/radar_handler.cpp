@@ -10,10 +10,13 @@ static const uint8_t DEFAULT_MAX_PROFILE = 2;
 static const float DEFAULT_SMOOTHING = 0.2f;
 static const uint32_t DEFAULT_START_MM = 250;
 static const uint32_t DEFAULT_END_MM = 1500;
+static const float DEFAULT_KALMAN_PROCESS = 20;
+static const float DEFAULT_KALMAN_MEASURE = 10;
+static const float DEFAULT_KALMAN_INIT_ERROR = 0.1;
 
 // === OGGETTI GLOBALI ===
 static SparkFunXM125DistanceV1 radarSensor;
-static SimpleKalmanFilter kalmanFilter(20, 10, 0.1);
+static SimpleKalmanFilter kalmanFilter(DEFAULT_KALMAN_PROCESS, DEFAULT_KALMAN_MEASURE, DEFAULT_KALMAN_INIT_ERROR);
 
 // === VARIABILI DI STATO ===
 static bool radarReady = false;
@@ -25,59 +28,91 @@ static bool firstReading = true;
 // Configurazione
 static uint32_t rangeStart = DEFAULT_START_MM;
 static uint32_t rangeEnd = DEFAULT_END_MM;
+static volatile bool rangePending = false;  // Range cambiato a sensore attivo
 static uint8_t currentProfile = DEFAULT_MAX_PROFILE;
 static float smoothingFactor = DEFAULT_SMOOTHING;
+static float kalmanProcessNoise = DEFAULT_KALMAN_PROCESS;
+static float kalmanMeasureNoise = DEFAULT_KALMAN_MEASURE;
+static float kalmanInitError = DEFAULT_KALMAN_INIT_ERROR;
 
 // Statistiche
 static uint32_t totalReadings = 0;
 static uint32_t validReadings = 0;
 static uint32_t errorReadings = 0;
+static uint32_t busErrorReadings = 0;   // Sottoinsieme: errori di comunicazione
 
 
 // === INIZIALIZZAZIONE ===
 bool initRadar() {
     Serial.println("🔧 Inizializzazione XM125...");
     
-    // Reset variabili
-    firstReading = true;
-    rawDistance = 0;
-    filteredDistance = 0;
-    kalmanFiltered = 0;
-    
-    // Inizializza comunicazione I2C
-    if (radarSensor.begin(RADAR_I2C_ADDRESS, Wire) != 1) {
-        Serial.println("❌ Errore inizializzazione radar XM125!");
-        radarReady = false;
-        return false;
-    }
-    
-    Serial.println("✅ Radar XM125 connesso");
-    
-    // Configura profilo
-    radarSensor.setMaxProfile(currentProfile);
-    Serial.printf("⚙️  Profilo radar: %d\n", currentProfile);
-    
-    // Avvia servizio distanza
-    int32_t setupError = radarSensor.distanceBegin();
-    if (setupError != 0) {
-        Serial.printf("❌ Errore in distanceBegin: %d\n", setupError);
-        radarReady = false;
-        return false;
-    }
-    
-    // Setup lettura distanza
-    uint32_t distanceSetupError = radarSensor.distanceDetectorReadingSetup();
-    if (distanceSetupError != 0) {
-        Serial.printf("❌ Errore in distanceDetectorReadingSetup: %d\n", distanceSetupError);
-        radarReady = false;
-        return false;
+    for (uint8_t step = RADAR_INIT_CONNECT; step < RADAR_INIT_DONE; step++) {
+        if (!radarInitStep(step)) {
+            return false;
+        }
     }
-    
-    Serial.println("✅ Configurazione XM125 completata");
-    radarReady = true;
     return true;
 }
 
+// Un passo alla volta: il supervisore può eseguire la re-inizializzazione
+// come job I2C separati, lasciando spazio alle letture IMU fra un passo e l'altro
+bool radarInitStep(uint8_t step) {
+    switch (step) {
+        case RADAR_INIT_CONNECT:
+            // Reset variabili
+            radarReady = false;
+            firstReading = true;
+            rawDistance = 0;
+            filteredDistance = 0;
+            kalmanFiltered = 0;
+            
+            // Inizializza comunicazione I2C
+            if (radarSensor.begin(RADAR_I2C_ADDRESS, Wire) != 1) {
+                Serial.println("❌ Errore inizializzazione radar XM125!");
+                return false;
+            }
+            Serial.println("✅ Radar XM125 connesso");
+            return true;
+            
+        case RADAR_INIT_PROFILE:
+            // Configura profilo
+            radarSensor.setMaxProfile(currentProfile);
+            Serial.printf("⚙️  Profilo radar: %d\n", currentProfile);
+            return true;
+            
+        case RADAR_INIT_DISTANCE: {
+            // Avvia servizio distanza sul range configurato
+            rangePending = false;
+            int32_t setupError = radarSensor.distanceBegin(rangeStart, rangeEnd);
+            if (setupError != 0) {
+                Serial.printf("❌ Errore in distanceBegin: %d\n", setupError);
+                return false;
+            }
+            return true;
+        }
+            
+        case RADAR_INIT_READING: {
+            // Setup lettura distanza
+            uint32_t distanceSetupError = radarSensor.distanceDetectorReadingSetup();
+            if (distanceSetupError != 0) {
+                Serial.printf("❌ Errore in distanceDetectorReadingSetup: %d\n", distanceSetupError);
+                return false;
+            }
+            
+            Serial.println("✅ Configurazione XM125 completata");
+            radarReady = true;
+            return true;
+        }
+            
+        default:
+            return false;
+    }
+}
+
+void markRadarFault() {
+    radarReady = false;
+}
+
 // === FUNZIONI DI STATO ===
 bool isRadarReady() {
     return radarReady;
@@ -88,17 +123,41 @@ bool isRadarValid() {
            (rawDistance >= rangeStart) && (rawDistance <= rangeEnd);
 }
 
+// Riconfigura start/end del detector: distanceBegin() riscrive i registri
+// e ricalibra, quindi gira nel job di lettura sul bus manager
+static bool applyRadarRange() {
+    int32_t setupError = radarSensor.distanceBegin(rangeStart, rangeEnd);
+    if (setupError != 0) {
+        Serial.printf("❌ Errore applicazione range: %d\n", setupError);
+        return false;
+    }
+    rangePending = false;
+    Serial.printf("📏 Range applicato al sensore: %lu - %lu mm\n",
+                  (unsigned long)rangeStart, (unsigned long)rangeEnd);
+    return true;
+}
+
 // === NUOVA FUNZIONE PRINCIPALE (per FreeRTOS) ===
 RadarData getRadarData() {
     RadarData data;
-    data.timestamp_ms = millis();
+    data.timestamp_us = timebaseNowUs();
+    data.timestamp_ms = usToMs(data.timestamp_us);
+    data.valid = false;
+    data.bus_error = false;
+    data.distance_mm = 0;
+    data.filtered_distance_mm = 0;
+    data.strength = 0;
+    data.num_peaks = 0;
     
     if (!radarReady) {
-        data.valid = false;
-        data.distance_mm = 0;
-        data.filtered_distance_mm = 0;
-        data.strength = 0;
-        data.num_peaks = 0;
+        return data;
+    }
+    
+    // Nuovo range da console/config: applicato prima della misura
+    if (rangePending && !applyRadarRange()) {
+        data.bus_error = true;
+        errorReadings++;
+        busErrorReadings++;
         return data;
     }
     
@@ -106,15 +165,24 @@ RadarData getRadarData() {
     uint32_t setupError = radarSensor.distanceDetectorReadingSetup();
     if (setupError != 0) {
         Serial.printf("⚠️ Errore setup lettura: %d\n", setupError);
-        data.valid = false;
+        data.bus_error = true;
         errorReadings++;
+        busErrorReadings++;
         return data;
     }
     
     // Leggi distanza peak 0
     uint32_t distancePeak = 0;
-    radarSensor.getDistancePeak0Distance(distancePeak);
+    if (radarSensor.getDistancePeak0Distance(distancePeak) != 0) {
+        data.bus_error = true;
+        errorReadings++;
+        busErrorReadings++;
+        return data;
+    }
     
+    // Istante della misura: fine del trasferimento del picco
+    data.timestamp_us = timebaseNowUs();
+    data.timestamp_ms = usToMs(data.timestamp_us);
     totalReadings++;
     
     if (distancePeak > 0) {
@@ -161,6 +229,14 @@ RadarData getRadarData() {
     return data;
 }
 
+uint32_t getRadarErrorCount() {
+    return errorReadings;
+}
+
+uint32_t getRadarBusErrorCount() {
+    return busErrorReadings;
+}
+
 // === FUNZIONI DI LETTURA (compatibilità) ===
 float getRadarDistance() {
     if (!radarReady) return 0;
@@ -201,12 +277,19 @@ void setRadarRange(uint32_t startMm, uint32_t endMm) {
     rangeStart = constrain(startMm, 100, 5000);
     rangeEnd = constrain(endMm, rangeStart + 100, 10000);
     
-    Serial.printf("📏 Radar range impostato: %d - %d mm\n", rangeStart, rangeEnd);
+    Serial.printf("📏 Radar range impostato: %lu - %lu mm\n",
+                  (unsigned long)rangeStart, (unsigned long)rangeEnd);
     
-    // TODO: Applicare configurazione al sensore tramite registri
-    // Esempio (da verificare con documentazione):
-    // radarSensor.writeRegister(START_REGISTER, rangeStart);
-    // radarSensor.writeRegister(END_REGISTER, rangeEnd);
+    // Sensore attivo: i registri li scrive il prossimo job di lettura
+    // (niente accessi I2C fuori dal bus manager). Altrimenti vale al re-init.
+    if (radarReady) {
+        rangePending = true;
+    }
+}
+
+void getRadarRange(uint32_t &startMm, uint32_t &endMm) {
+    startMm = rangeStart;
+    endMm = rangeEnd;
 }
 
 void setRadarProfile(uint8_t profile) {
@@ -226,14 +309,27 @@ void setRadarProfile(uint8_t profile) {
     }
 }
 
+uint8_t getRadarProfile() {
+    return currentProfile;
+}
+
 // === CONFIGURAZIONE FILTRI ===
 void setKalmanParameters(float processNoise, float measureNoise, float initError) {
     // Ricrea il filtro con nuovi parametri
     kalmanFilter = SimpleKalmanFilter(processNoise, measureNoise, initError);
+    kalmanProcessNoise = processNoise;
+    kalmanMeasureNoise = measureNoise;
+    kalmanInitError = initError;
     Serial.printf("🔧 Kalman filter: P=%.1f M=%.1f E=%.3f\n", 
                   processNoise, measureNoise, initError);
 }
 
+void getKalmanParameters(float &processNoise, float &measureNoise, float &initError) {
+    processNoise = kalmanProcessNoise;
+    measureNoise = kalmanMeasureNoise;
+    initError = kalmanInitError;
+}
+
 void setSmoothingFactor(float factor) {
     smoothingFactor = constrain(factor, 0.0f, 1.0f);
     Serial.printf("🔧 Smoothing factor: %.2f\n", smoothingFactor);
@@ -244,7 +340,11 @@ float getSmoothingFactor() {
 }
 
 void resetKalmanFilter() {
-    kalmanFilter = SimpleKalmanFilter(20, 10, 0.1);  // Reset ai valori default
+    // Reset ai valori default
+    kalmanFilter = SimpleKalmanFilter(DEFAULT_KALMAN_PROCESS, DEFAULT_KALMAN_MEASURE, DEFAULT_KALMAN_INIT_ERROR);
+    kalmanProcessNoise = DEFAULT_KALMAN_PROCESS;
+    kalmanMeasureNoise = DEFAULT_KALMAN_MEASURE;
+    kalmanInitError = DEFAULT_KALMAN_INIT_ERROR;
     firstReading = true;
     Serial.println("🔧 Filtro Kalman resettato");
 }
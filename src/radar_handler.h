@@ -3,6 +3,7 @@
 #define RADAR_HANDLER_H
 
 #include <Arduino.h>
+#include "timebase.h"
 
 // === COSTANTI CONFIGURAZIONE RADAR ===
 #define RADAR_I2C_ADDR         0x52    // Indirizzo I2C XM125
@@ -27,6 +28,7 @@
 struct RadarData {
     // Timestamp
     uint32_t timestamp_ms;
+    timestamp_us_t timestamp_us;   // Fine lettura picco sul bus
     
     // Distanza principale (peak 0)
     float distance_mm;
@@ -40,6 +42,7 @@ struct RadarData {
     
     // Stato
     bool valid;
+    bool bus_error;          // Comando XM125 fallito (non solo "nessun target")
     bool near_start_edge;    // Oggetto vicino al limite minimo
     bool calibration_needed; // Radar necessita ricalibrazione
     
@@ -53,6 +56,21 @@ bool initRadar();
 bool isRadarReady();
 bool isRadarValid();
 
+// Inizializzazione a passi (re-init in background dal supervisore)
+enum RadarInitStep {
+    RADAR_INIT_CONNECT = 0,  // begin() + reset stato filtri
+    RADAR_INIT_PROFILE,      // setMaxProfile()
+    RADAR_INIT_DISTANCE,     // distanceBegin() - il passo più lento
+    RADAR_INIT_READING,      // distanceDetectorReadingSetup()
+    RADAR_INIT_DONE
+};
+bool radarInitStep(uint8_t step);
+void markRadarFault();              // Sospende le letture fino a re-init
+
+// Contatori errori (letture senza picco + errori bus)
+uint32_t getRadarErrorCount();
+uint32_t getRadarBusErrorCount();
+
 // Lettura dati completa (NUOVA - per FreeRTOS)
 RadarData getRadarData();
 
@@ -75,7 +93,7 @@ uint8_t getRadarProfile();
 
 // Configurazione filtro
 void setKalmanParameters(float processNoise, float measureNoise, float initError);
-void getKalmanParameters(float &processNoise, float &measureNoise);
+void getKalmanParameters(float &processNoise, float &measureNoise, float &initError);
 void resetKalmanFilter();
 
 // Configurazione smoothing
@@ -0,0 +1,125 @@
+// running_stats.h
+// Media e varianza in streaming (Welford): un passaggio, memoria costante,
+// numericamente stabile anche con offset grandi rispetto al rumore
+// (es. 9.8 m/s² ± pochi mg). Header puro C++, usato anche dai test host.
+#ifndef RUNNING_STATS_H
+#define RUNNING_STATS_H
+
+#include <stdint.h>
+#include <math.h>
+
+// === SCALARE ===
+struct RunningStats {
+    uint32_t n;
+    double mean;
+    double m2;                  // Σ (x - media)²
+
+    void reset() {
+        n = 0;
+        mean = 0;
+        m2 = 0;
+    }
+
+    void add(double x) {
+        n++;
+        double d = x - mean;
+        mean += d / n;
+        m2 += d * (x - mean);
+    }
+
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+    double stddev() const { return sqrt(variance()); }
+    // Incertezza della media: si riduce come 1/sqrt(n)
+    double stdError() const { return n > 1 ? sqrt(variance() / n) : INFINITY; }
+};
+
+// === VETTORE 3 ASSI ===
+struct RunningStats3 {
+    RunningStats axis[3];
+
+    void reset() {
+        for (int i = 0; i < 3; i++) axis[i].reset();
+    }
+
+    void add(const float v[3]) {
+        for (int i = 0; i < 3; i++) axis[i].add(v[i]);
+    }
+
+    uint32_t count() const { return axis[0].n; }
+
+    void mean(float out[3]) const {
+        for (int i = 0; i < 3; i++) out[i] = (float)axis[i].mean;
+    }
+
+    // Scarto massimo del campione dalla media corrente (rilevamento movimento)
+    float maxDeviation(const float v[3]) const {
+        float m = 0;
+        for (int i = 0; i < 3; i++) {
+            float d = fabsf(v[i] - (float)axis[i].mean);
+            if (d > m) m = d;
+        }
+        return m;
+    }
+
+    float maxStdError() const {
+        double m = 0;
+        for (int i = 0; i < 3; i++) {
+            double e = axis[i].stdError();
+            if (e > m) m = e;
+        }
+        return (float)m;
+    }
+
+    float maxStddev() const {
+        double m = 0;
+        for (int i = 0; i < 3; i++) {
+            double s = axis[i].stddev();
+            if (s > m) m = s;
+        }
+        return (float)m;
+    }
+};
+
+// === FINESTRA SCORREVOLE ===
+// Media e varianza degli ultimi N campioni in O(1) per campione: Welford
+// con sostituzione (entra il nuovo, esce il più vecchio), senza le somme
+// Σx/Σx² che perdono precisione su offset grandi (distanze in mm).
+template <uint16_t N>
+struct SlidingStats {
+    float window[N];
+    uint16_t n;
+    uint16_t next;              // Slot del prossimo campione (= il più vecchio se pieno)
+    double mean;
+    double m2;
+
+    void reset() {
+        n = 0;
+        next = 0;
+        mean = 0;
+        m2 = 0;
+    }
+
+    void add(float x) {
+        if (n < N) {
+            window[next] = x;
+            n++;
+            double d = x - mean;
+            mean += d / n;
+            m2 += d * (x - mean);
+        } else {
+            float old = window[next];
+            window[next] = x;
+            double oldMean = mean;
+            mean += ((double)x - old) / N;
+            m2 += ((double)x - old) * ((double)x - mean + old - oldMean);
+            if (m2 < 0) m2 = 0;     // Arrotondamento con varianza ~0
+        }
+        next = (next + 1) % N;
+    }
+
+    bool full() const { return n == N; }
+    double variance() const { return n > 1 ? m2 / (n - 1) : 0; }
+    double stddev() const { return sqrt(variance()); }
+};
+
+#endif // RUNNING_STATS_H
@@ -0,0 +1,44 @@
+// sd_card.cpp
+#include "sd_card.h"
+#include "config.h"
+#include "task_config.h"
+#include <SD.h>
+#include <SPI.h>
+
+// === VARIABILI DI STATO ===
+static SPIClass sdSPI(HSPI);
+static bool sdMounted = false;          // Sotto sdMux
+static bool sdMounting = false;
+static portMUX_TYPE sdMux = portMUX_INITIALIZER_UNLOCKED;
+
+// === API ===
+bool mountSDCard() {
+    // Un solo task alla volta dentro SD.begin(); gli altri aspettano l'esito
+    while (1) {
+        portENTER_CRITICAL(&sdMux);
+        bool mounted = sdMounted;
+        bool busy = sdMounting;
+        if (!mounted && !busy) sdMounting = true;
+        portEXIT_CRITICAL(&sdMux);
+        if (mounted) return true;
+        if (!busy) break;
+        vTaskDelay(MS_TO_TICKS(10));
+    }
+
+    sdSPI.begin(SD_SCK, SD_MISO, SD_MOSI, SD_CS);
+    bool ok = SD.begin(SD_CS, sdSPI, SD_CARD_HZ, "/sd", SD_CARD_MAX_FILES);
+    if (!ok) sdSPI.end();
+
+    portENTER_CRITICAL(&sdMux);
+    sdMounted = ok;
+    sdMounting = false;
+    portEXIT_CRITICAL(&sdMux);
+    return ok;
+}
+
+bool isSDCardMounted() {
+    portENTER_CRITICAL(&sdMux);
+    bool mounted = sdMounted;
+    portEXIT_CRITICAL(&sdMux);
+    return mounted;
+}
@@ -0,0 +1,18 @@
+// sd_card.h
+#ifndef SD_CARD_H
+#define SD_CARD_H
+
+#include <Arduino.h>
+
+// === SD CARD (SPI) ===
+// Montaggio condiviso fra export nuvola e logger: la SD non serve al resto
+// del firmware, quindi si monta al primo uso. Thread-safe: due task che
+// montano insieme fanno un solo SD.begin().
+
+#define SD_CARD_HZ          20000000
+#define SD_CARD_MAX_FILES   10      // Logger (record, livelli, indice, catalogo) + un lettore
+
+bool mountSDCard();
+bool isSDCardMounted();
+
+#endif // SD_CARD_H
@@ -0,0 +1,129 @@
+// sensor_health.cpp
+#include "sensor_health.h"
+#include "i2c_bus.h"
+#include "imu_handler.h"
+#include "radar_handler.h"
+#include "task_config.h"
+
+// === JOB DI RE-INIT (eseguiti dal task bus) ===
+static bool radarInitJob(void *ctx) {
+    return radarInitStep((uint8_t)(uintptr_t)ctx);
+}
+
+static bool imuInitJob(void *ctx) {
+    return initIMU();
+}
+
+static const char *stateNames[] = {"OK", "DEGRADED", "FAILED", "RECOVERING"};
+static const char *sensorNames[HEALTH_SENSOR_COUNT] = {"Radar", "IMU"};
+
+// === COLLEGAMENTO A DRIVER E BUS MANAGER ===
+class DeviceHealthPort : public HealthPort {
+public:
+    void suspend(uint8_t sensor) override {
+        if (sensor == HEALTH_RADAR) {
+            markRadarFault();
+        } else {
+            markIMUFault();
+        }
+    }
+
+    // Radar: un job per passo di init, fra un passo e l'altro passa l'IMU
+    bool prepareInitStep(uint8_t sensor, uint8_t step, I2CTransaction &tx) override {
+        if (sensor == HEALTH_RADAR) {
+            uint8_t radarStep = RADAR_INIT_CONNECT + step;
+            if (radarStep >= RADAR_INIT_DONE) return false;
+            i2cPrepareJob(tx, I2C_DEV_RADAR, I2C_PRIO_LOW, radarInitJob, (void *)(uintptr_t)radarStep);
+            tx.addr = RADAR_I2C_ADDR;
+        } else {
+            if (step > 0) return false;
+            i2cPrepareJob(tx, I2C_DEV_IMU, I2C_PRIO_LOW, imuInitJob, NULL);
+            tx.addr = IMU_I2C_ADDR_6DOF;
+        }
+        return true;
+    }
+
+    uint64_t deadlineFromNow(uint32_t us) override {
+        return i2cDeadlineFromNow(us);
+    }
+
+    bool submit(I2CTransaction &tx) override {
+        return i2cSubmit(tx);
+    }
+
+    void onFault(uint8_t sensor, const SensorHealth &health) override {
+        Serial.printf("⚠️ %s guasto (%lu errori), re-init in background\n",
+                      sensorNames[sensor], (unsigned long)health.total_errors);
+    }
+
+    void onAttemptFailed(uint8_t sensor, const SensorHealth &health, uint8_t result) override {
+        RTOS_LOG("%s re-init failed (result %d), retry in %lums",
+                 sensorNames[sensor], result, (unsigned long)health.backoff_ms);
+    }
+
+    void onRecovered(uint8_t sensor, const SensorHealth &health) override {
+        Serial.printf("✅ %s re-inizializzato in %lums\n",
+                      sensorNames[sensor], (unsigned long)health.last_attempt_ms);
+    }
+};
+
+// === STATO SUPERVISORE ===
+static DeviceHealthPort port;
+static HealthSupervisor supervisor(port);
+
+// === INTERFACCIA TASK SENSORI ===
+void initSensorHealth() {
+    supervisor.begin(millis(), isRadarReady(), isIMUReady());
+}
+
+void reportSensorCycle(uint8_t sensor, bool busOk, bool dataOk) {
+    supervisor.report(sensor, busOk, dataOk, millis());
+}
+
+void serviceSensorHealth() {
+    supervisor.service(millis());
+}
+
+// === STATO ===
+bool isSensorHealthy(uint8_t sensor) {
+    return supervisor.isHealthy(sensor);
+}
+
+void getSensorHealth(uint8_t sensor, SensorHealth &health) {
+    if (sensor >= HEALTH_SENSOR_COUNT) {
+        memset(&health, 0, sizeof(health));
+        return;
+    }
+    health = supervisor.health(sensor);
+}
+
+void getBusHealth(BusHealth &health) {
+    health = supervisor.busHealth();
+}
+
+const char *getHealthStateName(uint8_t state) {
+    return state <= HEALTH_RECOVERING ? stateNames[state] : "?";
+}
+
+void printSensorHealth() {
+    Serial.println("\n=== Sensor Health ===");
+    for (uint8_t i = 0; i < HEALTH_SENSOR_COUNT; i++) {
+        const SensorHealth &h = supervisor.health(i);
+        Serial.printf("%-5s %-10s err:%lu faults:%lu rec:%lu/%lu last:%lums max:%lums\n",
+                      sensorNames[i],
+                      getHealthStateName(h.state),
+                      (unsigned long)h.total_errors,
+                      (unsigned long)h.faults,
+                      (unsigned long)h.recoveries,
+                      (unsigned long)h.attempts,
+                      (unsigned long)h.last_recovery_ms,
+                      (unsigned long)h.max_recovery_ms);
+    }
+    const BusHealth &bus = supervisor.busHealth();
+    Serial.printf("Bus   recover:%lu failed:%lu last:%luus max:%luus\n",
+                  (unsigned long)bus.recoveries,
+                  (unsigned long)bus.failed,
+                  (unsigned long)bus.last_us,
+                  (unsigned long)bus.max_us);
+    Serial.println("=====================\n");
+}
@@ -0,0 +1,35 @@
+// sensor_health.h
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <Arduino.h>
+#include "health_supervisor.h"
+
+// === SUPERVISORE SALUTE SENSORI ===
+// Il task sensori riporta l'esito di ogni ciclo. Se un sensore smette di
+// rispondere viene sospeso e re-inizializzato in background con job I2C a
+// bassa priorità (backoff esponenziale), mentre l'altro continua a campionare.
+// Se anche l'altro sensore sbaglia, o un tentativo fallisce, prima del
+// tentativo successivo il bus viene sbloccato (clock-out SCL + STOP).
+
+// Macchina a stati, configurazione e tipi: health_supervisor.h
+
+// === INTERFACCIA TASK SENSORI ===
+// Stato iniziale dai flag ready dei driver (un sensore assente parte FAILED)
+void initSensorHealth();
+
+// Esito del ciclo: busOk = transazioni riuscite, dataOk = dato plausibile
+// (radar con picco, IMU con campioni che cambiano)
+void reportSensorCycle(uint8_t sensor, bool busOk, bool dataOk);
+
+// Avanza la macchina a stati: sottomette job e ritorna subito
+void serviceSensorHealth();
+
+// === STATO ===
+bool isSensorHealthy(uint8_t sensor);
+void getSensorHealth(uint8_t sensor, SensorHealth &health);
+void getBusHealth(BusHealth &health);
+const char *getHealthStateName(uint8_t state);
+void printSensorHealth();
+
+#endif // SENSOR_HEALTH_H
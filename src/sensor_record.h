@@ -0,0 +1,139 @@
+// sensor_record.h
+// Record compatto di SensorData per ring pub/sub, log e telemetria:
+// 32 byte senza padding (SensorData ~96), interi quantizzati e timestamp
+// radar/IMU in delta dall'avvio ciclo. Le coordinate 3D e i campi in ms
+// sono derivati e vengono ricalcolati in unpackSensorRecord().
+//
+// Precisione (mezzo LSB), ben dentro performance-criteria.md:
+//   distanza  1µm    -> errore max 0.0005mm  (spec ±1mm)
+//   angoli    0.01°  -> errore max 0.005°    (spec pitch ±0.05°)
+//   tempi     1µs    -> esatti (delta saturati a ±35 min)
+#ifndef SENSOR_RECORD_H
+#define SENSOR_RECORD_H
+
+#include "sync_queue.h"
+
+#define SENSOR_RECORD_VERSION    1
+
+// === FLAG ===
+#define RECORD_FLAG_RADAR_VALID  0x01
+#define RECORD_FLAG_IMU_VALID    0x02
+#define RECORD_FLAG_RADAR_TS     0x04   // Radar letto nel ciclo (delta valido)
+#define RECORD_FLAG_IMU_TS       0x08   // IMU letta nel ciclo (delta valido)
+
+// === SCALE ===
+#define RECORD_UM_PER_MM         1000
+#define RECORD_CDEG_PER_DEG      100
+#define RECORD_YAW_CDEG_TURN     36000  // Yaw in [0, 360°)
+
+struct SensorRecord {
+    uint64_t timestamp_us;      // Avvio ciclo (timebase)
+    int32_t radar_dt_us;        // Fine job radar - timestamp_us
+    int32_t imu_dt_us;          // Fine burst IMU - timestamp_us
+    int32_t distance_um;
+    int32_t filtered_um;
+    int16_t pitch_cdeg;
+    uint16_t yaw_cdeg;
+    int16_t roll_cdeg;
+    uint8_t flags;
+    uint8_t version;
+
+    // === ACCESSORI (lettura in place: ring, buffer di log, frame) ===
+    float distanceMm() const { return distance_um / (float)RECORD_UM_PER_MM; }
+    float filteredMm() const { return filtered_um / (float)RECORD_UM_PER_MM; }
+    float pitchDeg() const { return pitch_cdeg / (float)RECORD_CDEG_PER_DEG; }
+    float yawDeg() const { return yaw_cdeg / (float)RECORD_CDEG_PER_DEG; }
+    float rollDeg() const { return roll_cdeg / (float)RECORD_CDEG_PER_DEG; }
+    bool radarValid() const { return flags & RECORD_FLAG_RADAR_VALID; }
+    bool imuValid() const { return flags & RECORD_FLAG_IMU_VALID; }
+
+    timestamp_us_t radarTimestampUs() const {
+        return (flags & RECORD_FLAG_RADAR_TS) ? timestamp_us + radar_dt_us : 0;
+    }
+    timestamp_us_t imuTimestampUs() const {
+        return (flags & RECORD_FLAG_IMU_TS) ? timestamp_us + imu_dt_us : 0;
+    }
+    // Come setSensorTimestamps(): un sensore non letto conta come istante 0
+    uint32_t syncDeltaUs() const {
+        uint64_t d = timeAbsDeltaUs(radarTimestampUs(), imuTimestampUs());
+        return d > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)d;
+    }
+};
+
+static_assert(sizeof(SensorRecord) == 32, "SensorRecord: layout senza padding");
+
+// === QUANTIZZAZIONE ===
+// Arrotondamento al più vicino con saturazione sul tipo di destinazione
+inline int32_t recordQuantize(float value, float scale, int32_t lo, int32_t hi) {
+    float q = value * scale;
+    if (!(q == q)) return 0;                // NaN
+    if (q <= (float)lo) return lo;
+    if (q >= (float)hi) return hi;
+    return (int32_t)(q < 0 ? q - 0.5f : q + 0.5f);
+}
+
+inline int32_t recordDeltaUs(timestamp_us_t t, timestamp_us_t base) {
+    int64_t d = timeDeltaUs(t, base);
+    if (d > INT32_MAX) return INT32_MAX;
+    if (d < INT32_MIN) return INT32_MIN;
+    return (int32_t)d;
+}
+
+// === CONVERSIONE ===
+inline void packSensorRecord(const SensorData &d, SensorRecord &r) {
+    r.timestamp_us = d.timestamp_us;
+    r.flags = 0;
+    r.version = SENSOR_RECORD_VERSION;
+
+    r.radar_dt_us = 0;
+    if (d.radar_timestamp_us) {
+        r.radar_dt_us = recordDeltaUs(d.radar_timestamp_us, d.timestamp_us);
+        r.flags |= RECORD_FLAG_RADAR_TS;
+    }
+    r.imu_dt_us = 0;
+    if (d.imu_timestamp_us) {
+        r.imu_dt_us = recordDeltaUs(d.imu_timestamp_us, d.timestamp_us);
+        r.flags |= RECORD_FLAG_IMU_TS;
+    }
+
+    r.distance_um = recordQuantize(d.distance_mm, RECORD_UM_PER_MM, INT32_MIN, INT32_MAX);
+    r.filtered_um = recordQuantize(d.filtered_distance_mm, RECORD_UM_PER_MM, INT32_MIN, INT32_MAX);
+    r.pitch_cdeg = (int16_t)recordQuantize(d.pitch_deg, RECORD_CDEG_PER_DEG, INT16_MIN, INT16_MAX);
+    r.roll_cdeg = (int16_t)recordQuantize(d.roll_deg, RECORD_CDEG_PER_DEG, INT16_MIN, INT16_MAX);
+
+    // Yaw circolare: 359.996° arrotonda a 0, non a 360
+    int32_t yaw = recordQuantize(d.yaw_deg, RECORD_CDEG_PER_DEG, -RECORD_YAW_CDEG_TURN, 2 * RECORD_YAW_CDEG_TURN);
+    yaw %= RECORD_YAW_CDEG_TURN;
+    if (yaw < 0) yaw += RECORD_YAW_CDEG_TURN;
+    r.yaw_cdeg = (uint16_t)yaw;
+
+    if (d.radar_valid) r.flags |= RECORD_FLAG_RADAR_VALID;
+    if (d.imu_valid) r.flags |= RECORD_FLAG_IMU_VALID;
+}
+
+inline void unpackSensorRecord(const SensorRecord &r, SensorData &d) {
+    d.timestamp_us = r.timestamp_us;
+    d.timestamp_ms = usToMs(r.timestamp_us);
+
+    d.distance_mm = r.distanceMm();
+    d.filtered_distance_mm = r.filteredMm();
+    d.radar_valid = r.radarValid();
+
+    d.pitch_deg = r.pitchDeg();
+    d.yaw_deg = r.yawDeg();
+    d.roll_deg = r.rollDeg();
+    d.imu_valid = r.imuValid();
+
+    setSensorTimestamps(d, r.radarTimestampUs(), r.imuTimestampUs());
+
+    // Coordinate: stessa regola del task sensori
+    if (d.radar_valid && d.imu_valid) {
+        calculateCoordinates(d);
+    } else {
+        d.x_mm = 0;
+        d.y_mm = 0;
+        d.z_mm = 0;
+    }
+}
+
+#endif // SENSOR_RECORD_H
@@ -2,6 +2,16 @@
 #include "sensor_tasks.h"
 #include "imu_handler.h"
 #include "radar_handler.h"
+#include "power_manager.h"
+#include "i2c_bus.h"
+#include "sensor_health.h"
+#include "boot_profiler.h"
+#include "ui_config.h"
+#include "pubsub_topic.h"
+#include "config_store.h"
+#include "sensor_record.h"
+#include "auto_capture.h"
+#include "height_map_service.h"
 #include <Wire.h>
 
 
@@ -10,95 +20,218 @@ static void handleBackgroundCalibration();  // Aggiungi questa dichiarazione
 
 
 // === VARIABILI GLOBALI ===
-QueueHandle_t sensorDataQueue = NULL;
 TaskHandle_t sensorTaskHandle = NULL;
-SemaphoreHandle_t i2cMutex = NULL;
 SemaphoreHandle_t displayMutex = NULL;
 SemaphoreHandle_t eepromMutex = NULL;
 
+// Topic dati sensori (ring condiviso, un cursore per subscriber)
+// Il ring contiene record compatti (32 byte): copie e RAM ~3x più piccole
+static PubSubTopic<SensorRecord, SENSOR_TOPIC_DEPTH, SENSOR_TOPIC_SUBSCRIBERS> sensorTopic;
+static int8_t legacySub = -1;   // Per getSensorDataTimeout()
+
+// Boot in background
+static volatile SensorBootState bootState = SENSOR_BOOT_IDLE;
+
 // Statistiche interne
 static TaskStats taskStats = {0};
 static bool calibrationInProgress = false;
 static float calibrationProgress = 0.0;
 
+// === TRANSAZIONI I2C DEL CICLO ===
+// Statiche: restano valide anche se il ciclo scade con transazioni in volo
+static I2CTransaction radarTx;
+static I2CTransaction gyroTx;
+static I2CTransaction accelTx;
+static I2CTransaction magTx;
+static RadarData radarResult;
+static IMURawSample imuRaw;
+static uint8_t lastAccel[sizeof(imuRaw.accel)];
+static volatile bool imuChained = false;   // IMU da leggere dopo il radar
+
+// Job radar: l'XM125 richiede la sequenza di comandi del driver SparkFun
+static bool radarReadJob(void *ctx) {
+    radarResult = getRadarData();
+    return !radarResult.bus_error;
+}
+
+static void submitIMUReads(uint64_t base) {
+    uint64_t deadline = base + IMU_READ_DEADLINE_US;
+    gyroTx.deadline_us = deadline;
+    accelTx.deadline_us = deadline;
+    magTx.deadline_us = deadline;
+    i2cSubmit(gyroTx);
+    i2cSubmit(accelTx);
+    i2cSubmit(magTx);
+}
+
+// A radar completato accoda subito l'IMU ad alta priorità: i due
+// campioni restano vicini nel tempo anche se la lettura radar è lenta
+static void onRadarComplete(I2CTransaction *t) {
+    if (!imuChained) return;
+    submitIMUReads(t->complete_us ? t->complete_us : i2cDeadlineFromNow(0));
+}
+
+static bool cycleInFlight() {
+    return radarTx.result == I2C_RESULT_PENDING ||
+           gyroTx.result == I2C_RESULT_PENDING ||
+           accelTx.result == I2C_RESULT_PENDING ||
+           magTx.result == I2C_RESULT_PENDING;
+}
+
 // === TASK PRINCIPALE SENSORI ===
 void sensorAcquisitionTask(void *pvParameters) {
     RTOS_LOG("Sensor task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_SENSOR);
     
     // Variabili locali task
     SensorData sensorData;
+    SensorRecord sensorRecord;
     TickType_t xLastWakeTime = xTaskGetTickCount();
-    uint32_t lastRadarRead = 0;
-    uint32_t lastImuRead = 0;
     
     taskStats.current_state = TASK_STATE_RUNNING;
     
     while (1) {
         // Timestamp comune
-        uint32_t currentTime = millis();
-        sensorData.timestamp_ms = currentTime;
-        
-        // === LETTURA RADAR (con mutex I2C) ===
-        if (TAKE_MUTEX(i2cMutex, MS_TO_TICKS(10))) {
-            sensorData.distance_mm = getRadarDistance();
-            sensorData.filtered_distance_mm = getFilteredRadarDistance();
-            sensorData.radar_valid = isRadarValid();
-            sensorData.radar_timestamp = millis();
-            lastRadarRead = sensorData.radar_timestamp;
-            GIVE_MUTEX(i2cMutex);
-        } else {
-            RTOS_LOG("Failed to get I2C mutex for radar");
-            sensorData.radar_valid = false;
+        sensorData.timestamp_us = timebaseNowUs();
+        sensorData.timestamp_ms = usToMs(sensorData.timestamp_us);
+        
+        // === AVVIO CICLO I2C (radar -> IMU in catena) ===
+        if (cycleInFlight()) {
+            // Ciclo precedente ancora sul bus: salta per non riusare i descrittori
+            taskStats.bus_overruns++;
+            serviceSensorHealth();
+            vTaskDelayUntil(&xLastWakeTime, MS_TO_TICKS(SENSOR_SAMPLE_RATE_MS));
+            continue;
         }
         
-        // === LETTURA IMU (con mutex I2C) ===
-        if (TAKE_MUTEX(i2cMutex, MS_TO_TICKS(10))) {
-            IMUData imuData = getIMUData();
-            sensorData.pitch_deg = imuData.pitch;
-            sensorData.yaw_deg = imuData.yaw;
-            sensorData.roll_deg = imuData.roll;
-            sensorData.imu_valid = imuData.valid;
-            sensorData.imu_timestamp = millis();
-            lastImuRead = sensorData.imu_timestamp;
-            GIVE_MUTEX(i2cMutex);
-        } else {
-            RTOS_LOG("Failed to get I2C mutex for IMU");
-            sensorData.imu_valid = false;
+        // I sensori sospesi dal supervisore (re-init in corso) non si leggono
+        bool readRadar = isRadarReady();
+        bool readIMU = isIMUReady();
+        imuChained = readRadar && readIMU;
+        
+        i2cPrepareJob(radarTx, I2C_DEV_RADAR, I2C_PRIO_NORMAL, radarReadJob, NULL);
+        radarTx.addr = RADAR_I2C_ADDR;
+        radarTx.deadline_us = i2cDeadlineFromNow(RADAR_READ_DEADLINE_US);
+        radarTx.callback = onRadarComplete;
+        
+        prepareIMURawReads(imuRaw, gyroTx, accelTx, magTx);
+        
+        // Notifica sull'ultima transazione della catena
+        I2CTransaction *lastTx = readIMU ? &magTx : (readRadar ? &radarTx : NULL);
+        if (lastTx) {
+            lastTx->notify = xTaskGetCurrentTaskHandle();
         }
         
-        // === CALCOLO SINCRONIZZAZIONE ===
-        sensorData.sync_delta_ms = abs((int32_t)sensorData.radar_timestamp - 
-                                       (int32_t)sensorData.imu_timestamp);
+        ulTaskNotifyTake(pdTRUE, 0);   // Scarta notifiche residue
+        if (readRadar) {
+            if (!i2cSubmit(radarTx)) {
+                onRadarComplete(&radarTx);
+            }
+        } else if (readIMU) {
+            submitIMUReads(i2cDeadlineFromNow(0));
+        }
         
-        // Aggiorna statistiche
-        taskStats.samples_acquired++;
-        if (isSyncValid(sensorData)) {
-            taskStats.sync_success++;
-            // Media mobile per avg_sync_delta
-            taskStats.avg_sync_delta_ms = (taskStats.avg_sync_delta_ms * 0.95) + 
-                                         (sensorData.sync_delta_ms * 0.05);
-        } else {
-            taskStats.sync_failures++;
+        // Attende la fine della catena senza occupare la CPU
+        TickType_t waitStart = xTaskGetTickCount();
+        while (lastTx && !i2cIsDone(*lastTx)) {
+            TickType_t elapsed = xTaskGetTickCount() - waitStart;
+            if (elapsed >= MS_TO_TICKS(SENSOR_CYCLE_TIMEOUT_MS) ||
+                !ulTaskNotifyTake(pdTRUE, MS_TO_TICKS(SENSOR_CYCLE_TIMEOUT_MS) - elapsed)) {
+                break;
+            }
+        }
+        
+        // === RISULTATO RADAR ===
+        sensorData.radar_valid = false;
+        if (readRadar) {
+            bool radarBusOk = radarTx.result == I2C_RESULT_OK;
+            if (radarBusOk) {
+                sensorData.distance_mm = radarResult.distance_mm;
+                sensorData.filtered_distance_mm = radarResult.filtered_distance_mm;
+                sensorData.radar_valid = radarResult.valid;
+            } else {
+                RTOS_LOG("Radar read failed: %d", radarTx.result);
+                taskStats.bus_failures++;
+            }
+            reportSensorCycle(HEALTH_RADAR, radarBusOk, sensorData.radar_valid);
         }
         
-        if (sensorData.sync_delta_ms > taskStats.max_sync_delta_ms) {
-            taskStats.max_sync_delta_ms = sensorData.sync_delta_ms;
+        // === RISULTATO IMU ===
+        sensorData.imu_valid = false;
+        float gyroRateDps = 0;
+        if (readIMU) {
+            bool imuBusOk = gyroTx.result == I2C_RESULT_OK &&
+                            accelTx.result == I2C_RESULT_OK &&
+                            magTx.result == I2C_RESULT_OK;
+            bool imuFresh = false;
+            if (imuBusOk) {
+                IMUData imuData = processIMURaw(imuRaw);
+                sensorData.pitch_deg = imuData.pitch;
+                sensorData.yaw_deg = imuData.yaw;
+                sensorData.roll_deg = imuData.roll;
+                sensorData.imu_valid = imuData.valid;
+                gyroRateDps = autoCaptureRate(imuData.gyro_dps);
+                
+                // Il rumore cambia sempre gli LSB: registri fermi = sensore in reset
+                imuFresh = memcmp(imuRaw.accel, lastAccel, sizeof(lastAccel)) != 0;
+                memcpy(lastAccel, imuRaw.accel, sizeof(lastAccel));
+            } else {
+                RTOS_LOG("IMU read failed: %d/%d/%d", gyroTx.result, accelTx.result, magTx.result);
+                taskStats.bus_failures++;
+            }
+            reportSensorCycle(HEALTH_IMU, imuBusOk, imuFresh);
+        }
+        
+        // === CALCOLO SINCRONIZZAZIONE ===
+        // Istanti di fine trasferimento sul bus (stessa timebase, 1µs)
+        setSensorTimestamps(sensorData, radarTx.complete_us, accelTx.complete_us);
+        
+        // Aggiorna statistiche (sync solo se entrambi i sensori sono attivi)
+        taskStats.samples_acquired++;
+        if (readRadar && readIMU) {
+            if (isSyncValid(sensorData)) {
+                taskStats.sync_success++;
+                // Media mobile per avg_sync_delta
+                taskStats.avg_sync_delta_ms = (taskStats.avg_sync_delta_ms * 0.95) + 
+                                             (usToMsF(sensorData.sync_delta_us) * 0.05);
+            } else {
+                taskStats.sync_failures++;
+            }
+            
+            if (sensorData.sync_delta_us > taskStats.max_sync_delta_us) {
+                taskStats.max_sync_delta_us = sensorData.sync_delta_us;
+                taskStats.max_sync_delta_ms = sensorData.sync_delta_ms;
+            }
         }
         
         // === CALCOLO COORDINATE 3D ===
         if (sensorData.radar_valid && sensorData.imu_valid) {
             calculateCoordinates(sensorData);
+        } else {
+            sensorData.x_mm = 0;
+            sensorData.y_mm = 0;
+            sensorData.z_mm = 0;
         }
         
-        // === INVIO A QUEUE ===
-        if (xQueueSend(sensorDataQueue, &sensorData, 0) != pdTRUE) {
-            // Queue piena, rimuovi il più vecchio
-            SensorData dummy;
-            xQueueReceive(sensorDataQueue, &dummy, 0);
-            xQueueSend(sensorDataQueue, &sensorData, 0);
+        // === PUBBLICAZIONE ===
+        // Quantizzato una volta sola; attende (poco) solo se un subscriber
+        // LOSSLESS ha il ring pieno
+        packSensorRecord(sensorData, sensorRecord);
+        if (!sensorTopic.publish(sensorRecord, SENSOR_PUBLISH_BLOCK_MS)) {
             taskStats.queue_overflows++;
-            RTOS_LOG("Sensor queue overflow!");
+            flightEvent(FR_EV_QUEUE_OVERFLOW, FR_QUEUE_SENSOR_TOPIC, taskStats.queue_overflows);
+            RTOS_LOG("Sensor topic overflow: lossless subscriber lagging");
         }
+
+        // Sveglia la UI solo ora che c'è un dato nuovo (niente polling)
+        notifyUIEvent(UI_EVENT_SENSOR);
+        
+        // Cattura da fermo: O(1), dopo la pubblicazione
+        autoCaptureProcess(sensorData, gyroRateDps);
+        heightMapProcess(sensorData);
+        
+        // === SUPERVISORE (re-init in background, non bloccante) ===
+        serviceSensorHealth();
         
         // === GESTIONE CALIBRAZIONE ===
         if (calibrationInProgress) {
@@ -107,6 +240,7 @@ void sensorAcquisitionTask(void *pvParameters) {
         }
         
         // Attendi prossimo ciclo (10Hz)
+        flightTaskBeat(FR_TASK_SENSOR);
         vTaskDelayUntil(&xLastWakeTime, MS_TO_TICKS(SENSOR_SAMPLE_RATE_MS));
     }
 }
@@ -114,22 +248,30 @@ void sensorAcquisitionTask(void *pvParameters) {
 // === INIZIALIZZAZIONE ===
 bool initSensorTasks() {
     // Crea mutex
-    i2cMutex = xSemaphoreCreateMutex();
     displayMutex = xSemaphoreCreateMutex();
+    flightRegisterMutex(displayMutex, FR_MUTEX_DISPLAY);
     eepromMutex = xSemaphoreCreateMutex();
     
-    if (!i2cMutex || !displayMutex || !eepromMutex) {
+    if (!displayMutex || !eepromMutex) {
         Serial.println("❌ Failed to create mutexes");
         return false;
     }
     
-    // Crea queue sensori
-    sensorDataQueue = xQueueCreate(SENSOR_QUEUE_SIZE, sizeof(SensorData));
-    if (!sensorDataQueue) {
-        Serial.println("❌ Failed to create sensor queue");
+    // Il bus manager possiede Wire: i sensori passano da lì
+    if (!initI2CBus(Wire, SENSOR_SDA, SENSOR_SCL)) {
         return false;
     }
     
+    // Supervisore: un sensore mancante al boot viene ritentato in background
+    initSensorHealth();
+    
+    // Topic dati sensori
+    if (!sensorTopic.begin()) {
+        Serial.println("❌ Failed to create sensor topic");
+        return false;
+    }
+    legacySub = sensorTopic.subscribe("legacy", PUBSUB_LATEST_ONLY);
+    
     // Crea task sensori
     BaseType_t result = xTaskCreatePinnedToCore(
         sensorAcquisitionTask,           // Funzione
@@ -150,6 +292,79 @@ bool initSensorTasks() {
     return true;
 }
 
+// === BOOT SENSORI IN BACKGROUND ===
+static bool initWithRetry(bool (*initFn)(), const char *name) {
+    for (int retry = 0; retry < SENSOR_INIT_RETRIES; retry++) {
+        if (initFn()) return true;
+        Serial.printf("❌ %s Init Failed (attempt %d/%d)\n", name, retry + 1, SENSOR_INIT_RETRIES);
+        vTaskDelay(MS_TO_TICKS(SENSOR_INIT_RETRY_MS));
+    }
+    return false;
+}
+
+static void sensorBootTask(void *pvParameters) {
+    RTOS_LOG("Sensor boot task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_SENSOR_BOOT);
+    
+    // Parametri salvati (range, profilo, filtri) prima di configurare i sensori
+    applyConfigTunables();
+    
+    // Stesso bus (Wire): IMU e radar in sequenza, ma in parallelo alla UI
+    bootPhaseBegin(BOOT_PHASE_IMU);
+    bool imuOk = initWithRetry(initIMU, "IMU");
+    bootPhaseEnd(BOOT_PHASE_IMU, imuOk);
+    
+    bootPhaseBegin(BOOT_PHASE_RADAR);
+    bool radarOk = initWithRetry(initRadar, "Radar");
+    bootPhaseEnd(BOOT_PHASE_RADAR, radarOk);
+    
+    // I task partono comunque: il supervisore ritenta i sensori mancanti
+    bootPhaseBegin(BOOT_PHASE_TASKS);
+    bool tasksOk = initSensorTasks();
+    bootPhaseEnd(BOOT_PHASE_TASKS, tasksOk);
+    
+    if (tasksOk) {
+        Serial.printf("✅ Boot sensori completato (IMU %s, Radar %s)\n",
+                      imuOk ? "OK" : "KO", radarOk ? "OK" : "KO");
+    } else {
+        Serial.println("❌ FreeRTOS init failed");
+    }
+    
+    bootState = tasksOk ? SENSOR_BOOT_DONE : SENSOR_BOOT_FAILED;
+    notifyUIEvent(UI_EVENT_BOOT);
+    vTaskDelete(NULL);
+}
+
+bool startSensorBoot() {
+    if (bootState != SENSOR_BOOT_IDLE) return true;
+    bootState = SENSOR_BOOT_RUNNING;
+    
+    BaseType_t result = xTaskCreatePinnedToCore(
+        sensorBootTask,
+        "SensorBoot",
+        SENSOR_BOOT_TASK_STACK_SIZE,
+        NULL,
+        SENSOR_BOOT_TASK_PRIORITY,
+        NULL,
+        SENSOR_BOOT_TASK_CORE
+    );
+    
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create sensor boot task");
+        bootState = SENSOR_BOOT_FAILED;
+        return false;
+    }
+    return true;
+}
+
+SensorBootState getSensorBootState() {
+    return bootState;
+}
+
+bool areSensorsReady() {
+    return bootState == SENSOR_BOOT_DONE && (isIMUReady() || isRadarReady());
+}
+
 // === CONTROLLO TASK ===
 void suspendSensorTask() {
     if (sensorTaskHandle) {
@@ -165,14 +380,88 @@ void resumeSensorTask() {
     }
 }
 
+// === PUB/SUB DATI SENSORI ===
+int8_t subscribeSensorData(const char *name, uint8_t policy, uint16_t decimation) {
+    int8_t sub = sensorTopic.subscribe(name, policy, decimation);
+    if (sub < 0) {
+        Serial.printf("❌ Sensor topic: nessuno slot per '%s'\n", name);
+    }
+    return sub;
+}
+
+void unsubscribeSensorData(int8_t sub) {
+    sensorTopic.unsubscribe(sub);
+}
+
+bool readSensorData(int8_t sub, SensorData &data, uint32_t timeout_ms) {
+    SensorRecord record;
+    if (!sensorTopic.read(sub, record, timeout_ms)) return false;
+    unpackSensorRecord(record, data);
+    return true;
+}
+
+bool readSensorRecord(int8_t sub, SensorRecord &record, uint32_t timeout_ms) {
+    return sensorTopic.read(sub, record, timeout_ms);
+}
+
+void getSensorSubscriberStats(int8_t sub, PubSubSubscriberStats &stats) {
+    sensorTopic.getStats(sub, stats);
+}
+
+uint32_t getSensorTopicMaxLag() {
+    uint32_t lag = 0;
+    for (int8_t i = 0; i < SENSOR_TOPIC_SUBSCRIBERS; i++) {
+        if (!sensorTopic.isSubscribed(i)) continue;
+        PubSubSubscriberStats s;
+        sensorTopic.getStats(i, s);
+        if (s.lag > lag) lag = s.lag;
+    }
+    return lag;
+}
+
+void printSensorSubscribers() {
+    static const char *policyNames[] = {"latest", "lossless", "decim"};
+    
+    Serial.printf("\n=== Sensor Topic (%lu pubblicati) ===\n",
+                  (unsigned long)sensorTopic.published());
+    for (int8_t i = 0; i < SENSOR_TOPIC_SUBSCRIBERS; i++) {
+        if (!sensorTopic.isSubscribed(i)) continue;
+        
+        PubSubSubscriberStats s;
+        sensorTopic.getStats(i, s);
+        uint8_t policy = sensorTopic.getPolicy(i);
+        Serial.printf("%-10s %-8s rx:%lu skip:%lu drop:%lu lag:%lu max:%lu\n",
+                      sensorTopic.getName(i),
+                      policy <= PUBSUB_DECIMATED ? policyNames[policy] : "?",
+                      (unsigned long)s.delivered,
+                      (unsigned long)s.skipped,
+                      (unsigned long)s.dropped,
+                      (unsigned long)s.lag,
+                      (unsigned long)s.max_lag);
+    }
+    Serial.println("=====================\n");
+}
+
 // === UTILITY ===
 bool getLatestSensorData(SensorData &data) {
-    // Non bloccante - prende l'ultimo disponibile
-    return xQueuePeek(sensorDataQueue, &data, 0) == pdTRUE;
+    // Non bloccante - prende l'ultimo disponibile senza consumarlo
+    SensorRecord record;
+    if (!sensorTopic.latest(record)) return false;
+    unpackSensorRecord(record, data);
+    return true;
+}
+
+bool getLatestSensorRecord(SensorRecord &record) {
+    return sensorTopic.latest(record);
+}
+
+uint16_t getSensorHistory(SensorRecord *out, uint16_t max) {
+    return sensorTopic.history(out, max);
 }
 
 bool getSensorDataTimeout(SensorData &data, uint32_t timeout_ms) {
-    return xQueueReceive(sensorDataQueue, &data, MS_TO_TICKS(timeout_ms)) == pdTRUE;
+    if (legacySub < 0) return false;
+    return readSensorData(legacySub, data, timeout_ms);
 }
 
 void getSensorTaskStats(TaskStats &stats) {
@@ -186,10 +475,16 @@ void resetSensorTaskStats() {
     taskStats.queue_overflows = 0;
     taskStats.avg_sync_delta_ms = 0;
     taskStats.max_sync_delta_ms = 0;
+    taskStats.max_sync_delta_us = 0;
+    taskStats.bus_failures = 0;
+    taskStats.bus_overruns = 0;
 }
 
 // === CALIBRAZIONE ===
+// Bias del giroscopio: i campioni li consuma processIMURaw() in questo task,
+// la fine arriva con la convergenza (imu_calibration.h), non a tempo
 void startBackgroundCalibration() {
+    if (!startIMUCalibration(IMU_CAL_MODE_GYRO)) return;
     calibrationInProgress = true;
     calibrationProgress = 0.0;
     taskStats.current_state = TASK_STATE_CALIBRATING;
@@ -205,24 +500,18 @@ float getCalibrationProgress() {
 
 // Helper privato per calibrazione
 static void handleBackgroundCalibration() {
-    static uint32_t calibStartTime = 0;
-    static int calibStep = 0;
+    IMUCalStatus status;
+    getIMUCalibrationStatus(status);
+    calibrationProgress = status.progress;
+    if (status.state == IMU_CAL_RUNNING) return;
     
-    if (calibStep == 0) {
-        calibStartTime = millis();
-        calibStep = 1;
-    }
-    
-    // Simula progresso calibrazione (20 secondi)
-    uint32_t elapsed = millis() - calibStartTime;
-    calibrationProgress = min(1.0f, elapsed / 20000.0f);
-    
-    if (elapsed >= 20000) {
-        calibrationInProgress = false;
-        calibrationProgress = 1.0;
-        calibStep = 0;
-        taskStats.current_state = TASK_STATE_RUNNING;
+    calibrationInProgress = false;
+    calibrationProgress = 1.0;
+    taskStats.current_state = TASK_STATE_RUNNING;
+    if (status.state == IMU_CAL_DONE) {
         RTOS_LOG("Calibration complete");
+    } else {
+        RTOS_LOG("Calibration failed: device not still");
     }
 }
 
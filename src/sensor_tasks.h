@@ -8,6 +8,8 @@
 #include "freertos/semphr.h"
 #include "task_config.h"
 #include "sync_queue.h"
+#include "pubsub_ring.h"
+#include "sensor_record.h"
 
 // === FUNZIONI TASK ===
 // Task principale acquisizione sensori
@@ -17,16 +19,57 @@ void sensorAcquisitionTask(void *pvParameters);
 // Inizializza task e risorse FreeRTOS
 bool initSensorTasks();
 
+// === BOOT SENSORI IN BACKGROUND ===
+// IMU + radar + task partono in un task dedicato mentre setup() disegna il
+// menu; alla fine viene segnalato UI_EVENT_BOOT.
+enum SensorBootState {
+    SENSOR_BOOT_IDLE,
+    SENSOR_BOOT_RUNNING,    // Init in corso: voci sensori "warming up"
+    SENSOR_BOOT_DONE,       // Task avviati (sensori mancanti ritentati dal supervisore)
+    SENSOR_BOOT_FAILED      // Risorse RTOS non create
+};
+
+bool startSensorBoot();
+SensorBootState getSensorBootState();
+
+// Boot terminato e almeno un sensore attivo
+bool areSensorsReady();
+
 // === CONTROLLO TASK ===
 // Sospende/riprende il task sensori
 void suspendSensorTask();
 void resumeSensorTask();
 
+// === PUB/SUB DATI SENSORI ===
+// Ogni consumatore si iscrive con la propria policy e legge dal proprio
+// cursore sul ring condiviso (nessuno consuma i campioni degli altri).
+// Ritorna l'id subscriber o -1; il nome deve restare valido (letterale).
+int8_t subscribeSensorData(const char *name, uint8_t policy, uint16_t decimation = 1);
+void unsubscribeSensorData(int8_t sub);
+
+// Prossimo campione per il subscriber (timeout 0 = non bloccante)
+bool readSensorData(int8_t sub, SensorData &data, uint32_t timeout_ms);
+
+// Come sopra ma senza conversione: per log e telemetria che scrivono il
+// record compatto così com'è
+bool readSensorRecord(int8_t sub, SensorRecord &record, uint32_t timeout_ms);
+
+void getSensorSubscriberStats(int8_t sub, PubSubSubscriberStats &stats);
+void printSensorSubscribers();
+
+// Campioni non ancora letti dal subscriber più indietro (profondità della coda)
+uint32_t getSensorTopicMaxLag();
+
 // === UTILITY ===
-// Ottiene l'ultimo dato sincronizzato (non bloccante)
+// Ottiene l'ultimo dato sincronizzato (non bloccante, non consuma)
 bool getLatestSensorData(SensorData &data);
+bool getLatestSensorRecord(SensorRecord &record);
+
+// Ultimi campioni del topic (fino a SENSOR_TOPIC_DEPTH), più vecchio per primo
+uint16_t getSensorHistory(SensorRecord *out, uint16_t max);
 
-// Ottiene dato sincronizzato con timeout
+// Attende un campione più recente dell'ultimo restituito (subscriber
+// condiviso LATEST_ONLY; i consumatori dedicati usano subscribeSensorData)
 bool getSensorDataTimeout(SensorData &data, uint32_t timeout_ms);
 
 // Statistiche task
@@ -34,9 +77,12 @@ struct TaskStats {
     uint32_t samples_acquired;
     uint32_t sync_success;
     uint32_t sync_failures;
-    uint32_t queue_overflows;
+    uint32_t queue_overflows;   // Pubblicazioni forzate: subscriber LOSSLESS in ritardo
     float avg_sync_delta_ms;
     uint32_t max_sync_delta_ms;
+    uint32_t max_sync_delta_us;  // Stessa misura a 1µs
+    uint32_t bus_failures;      // Letture fallite sul bus (errore/deadline)
+    uint32_t bus_overruns;      // Cicli saltati: bus ancora occupato
     TaskState_t current_state;
 };
 
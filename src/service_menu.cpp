@@ -1,6 +1,8 @@
 // service_menu.cpp
 #include "service_menu.h"
 #include "menu_state.h"
+#include "power_manager.h"
+#include "task_config.h"
 #include <CSE_CST328.h>
 
 extern CSE_CST328 *touch;
@@ -86,6 +88,6 @@ bool enterServiceCode(Arduino_GFX* gfx, UIConfig& ui) {
                 }
             }
         }
-        delay(50);
+        waitForTouch(UI_IDLE_TIMEOUT_MS);
     }
 }
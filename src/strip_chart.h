@@ -0,0 +1,147 @@
+// strip_chart.h
+// Grafico a scorrimento: ring degli ultimi W campioni per TRACES tracce,
+// autoscala per traccia e rendering di una colonna alla volta (H pixel
+// RGB565). Con lo scroll hardware del display ogni campione nuovo costa una
+// sola colonna; il grafico intero si ridisegna solo quando cambia una scala.
+// Ogni traccia ha la sua fascia orizzontale; NaN = campione non valido
+// (buco nella traccia).
+// Header puro C++, test in tools/strip_chart_test.cpp.
+#ifndef STRIP_CHART_H
+#define STRIP_CHART_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#define STRIP_CHART_MARGIN        0.1f      // Margine sopra/sotto all'autoscala
+#define STRIP_CHART_SHRINK_RATIO  0.4f      // Si stringe se i dati usano meno di così
+#define STRIP_CHART_GRID_COLOR    0x2104    // Linea di mezzo fascia
+#define STRIP_CHART_SEP_COLOR     0x4208    // Separatore fra fasce
+
+template <uint16_t W, uint16_t H, uint8_t TRACES>
+class StripChart {
+public:
+    static constexpr uint16_t BAND = H / TRACES;
+
+    // minSpan: escursione minima della scala (evita di ingrandire il rumore)
+    void begin(const uint16_t *colors, const float *minSpan, uint16_t background) {
+        for (uint8_t t = 0; t < TRACES; t++) {
+            color[t] = colors[t];
+            span[t] = minSpan[t] > 0 ? minSpan[t] : 1.0f;
+            lo[t] = hi[t] = 0;
+            scaled[t] = false;
+        }
+        bg = background;
+        head = 0;
+        count = 0;
+        sinceShrink = 0;
+        rescales = 0;
+    }
+
+    // Nuovo campione (un valore per traccia). true se una scala è cambiata:
+    // allora vanno ridisegnate tutte le colonne, altrimenti solo la nuova.
+    bool push(const float *values) {
+        memcpy(ring[head], values, sizeof(ring[head]));
+        head = (uint16_t)((head + 1) % W);
+        if (count < W) count++;
+
+        bool changed = false;
+        for (uint8_t t = 0; t < TRACES; t++) {
+            float v = values[t];
+            if (!isfinite(v)) continue;
+            if (!scaled[t] || v < lo[t] || v > hi[t]) changed |= rescale(t);
+        }
+        // Ogni W campioni: scala troppo larga per i dati visibili
+        if (++sinceShrink >= W) {
+            sinceShrink = 0;
+            for (uint8_t t = 0; t < TRACES; t++) {
+                float mn, mx;
+                if (scaled[t] && windowRange(t, mn, mx) &&
+                    (mx - mn) * (1 + 2 * STRIP_CHART_MARGIN) < (hi[t] - lo[t]) * STRIP_CHART_SHRINK_RATIO &&
+                    hi[t] - lo[t] > span[t]) {
+                    changed |= rescale(t);
+                }
+            }
+        }
+        if (changed) rescales++;
+        return changed;
+    }
+
+    // Colonna del campione di età age (0 = il più recente), dall'alto in basso
+    void renderColumn(uint16_t age, uint16_t *out) const {
+        for (uint16_t y = 0; y < H; y++) out[y] = bg;
+        for (uint8_t t = 0; t < TRACES; t++) {
+            uint16_t top = t * BAND;
+            out[top + BAND / 2] = STRIP_CHART_GRID_COLOR;
+            out[top + BAND - 1] = STRIP_CHART_SEP_COLOR;
+            if (age >= count || !scaled[t]) continue;
+
+            float v = sample(age)[t];
+            if (!isfinite(v)) continue;
+            int y0 = rowOf(t, v);
+            int y1 = y0;
+            // Segmento verticale verso il campione precedente: traccia continua
+            if (age + 1 < count && isfinite(sample(age + 1)[t])) y1 = rowOf(t, sample(age + 1)[t]);
+            if (y1 < y0) {
+                int tmp = y0;
+                y0 = y1;
+                y1 = tmp;
+            }
+            for (int y = y0; y <= y1; y++) out[top + y] = color[t];
+        }
+    }
+
+    const float *sample(uint16_t age) const { return ring[(head + W - 1 - age) % W]; }
+    uint16_t size() const { return count; }
+    float low(uint8_t t) const { return lo[t]; }
+    float high(uint8_t t) const { return hi[t]; }
+    uint32_t rescaleCount() const { return rescales; }
+
+private:
+    // Riga nella fascia (0 in alto = valore massimo), sempre dentro la fascia
+    int rowOf(uint8_t t, float v) const {
+        const int usable = BAND - 2;
+        float f = (hi[t] - v) / (hi[t] - lo[t]);
+        int y = (int)(f * usable + 0.5f);
+        if (y < 0) y = 0;
+        if (y > usable) y = usable;
+        return y;
+    }
+
+    bool windowRange(uint8_t t, float &mn, float &mx) const {
+        mn = INFINITY;
+        mx = -INFINITY;
+        for (uint16_t a = 0; a < count; a++) {
+            float v = sample(a)[t];
+            if (!isfinite(v)) continue;
+            if (v < mn) mn = v;
+            if (v > mx) mx = v;
+        }
+        return mn <= mx;
+    }
+
+    // Scala sui campioni visibili con margine e escursione minima
+    bool rescale(uint8_t t) {
+        float mn, mx;
+        if (!windowRange(t, mn, mx)) return false;
+        float mid = (mn + mx) * 0.5f;
+        float half = (mx - mn) * (0.5f + STRIP_CHART_MARGIN);
+        if (half < span[t] * 0.5f) half = span[t] * 0.5f;
+        lo[t] = mid - half;
+        hi[t] = mid + half;
+        scaled[t] = true;
+        return true;
+    }
+
+    float ring[W][TRACES];
+    uint16_t head = 0;
+    uint16_t count = 0;
+    uint16_t sinceShrink = 0;
+    uint32_t rescales = 0;
+    float lo[TRACES], hi[TRACES], span[TRACES];
+    bool scaled[TRACES];
+    uint16_t color[TRACES];
+    uint16_t bg = 0;
+};
+
+#endif // STRIP_CHART_H
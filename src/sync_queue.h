@@ -1,12 +1,21 @@
 #ifndef SYNC_QUEUE_H
 #define SYNC_QUEUE_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include <stdint.h>
+#include <math.h>
+#endif
+#include "timebase.h"
 
 // Struttura dati sincronizzata per sensori
+// I campi *_us (timebase a 64 bit) sono la fonte; i campi in ms restano
+// per le API esistenti e sono derivati con usToMs().
 struct SensorData {
     // Timestamp comune
     uint32_t timestamp_ms;
+    timestamp_us_t timestamp_us;     // Avvio ciclo
     
     // Dati Radar
     float distance_mm;
@@ -22,9 +31,12 @@ struct SensorData {
     // Timestamp individuali per debug
     uint32_t radar_timestamp;
     uint32_t imu_timestamp;
+    timestamp_us_t radar_timestamp_us;   // Fine job radar sul bus
+    timestamp_us_t imu_timestamp_us;     // Fine burst accel/gyro sul bus
     
     // Metriche sincronizzazione
     uint32_t sync_delta_ms;  // |radar_ts - imu_ts|
+    uint32_t sync_delta_us;  // Stessa misura a 1µs (target ±5ms)
     
     // Coordinate 3D calcolate
     float x_mm;
@@ -32,24 +44,35 @@ struct SensorData {
     float z_mm;
 };
 
-// Configurazione Queue
-#define SENSOR_QUEUE_SIZE 5      // Buffer di 5 misure
+// Configurazione topic pub/sub (vedi pubsub_topic.h)
+#define SENSOR_TOPIC_DEPTH        32   // Storico condiviso: 3.2s a 10Hz
+#define SENSOR_TOPIC_SUBSCRIBERS  8    // Display, logger, telemetria, test...
+#define SENSOR_PUBLISH_BLOCK_MS   20   // Attesa max per subscriber LOSSLESS in ritardo
 #define MAX_SYNC_DELTA_MS 10     // Max 10ms tra sensori
-
-// Handle globale per la queue (definito in sensor_tasks.cpp)
-extern QueueHandle_t sensorDataQueue;
+#define SYNC_DEG_TO_RAD   0.017453292519943295
 
 // Funzioni helper
 inline bool isSyncValid(const SensorData& data) {
-    return data.sync_delta_ms <= MAX_SYNC_DELTA_MS;
+    return data.sync_delta_us <= (uint32_t)MAX_SYNC_DELTA_MS * 1000;
+}
+
+// Imposta i timestamp di radar e IMU e ricava delta/campi in ms
+inline void setSensorTimestamps(SensorData& data, timestamp_us_t radar_us, timestamp_us_t imu_us) {
+    data.radar_timestamp_us = radar_us;
+    data.imu_timestamp_us = imu_us;
+    data.radar_timestamp = usToMs(radar_us);
+    data.imu_timestamp = usToMs(imu_us);
+    uint64_t delta = timeAbsDeltaUs(radar_us, imu_us);
+    data.sync_delta_us = delta > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)delta;
+    data.sync_delta_ms = usToMsSat(delta);
 }
 
 // Calcola coordinate 3D da distanza e angoli
 inline void calculateCoordinates(SensorData& data) {
-    float dist_orizz = data.distance_mm * cos(data.pitch_deg * PI / 180.0);
-    data.x_mm = dist_orizz * sin(data.yaw_deg * PI / 180.0);
-    data.y_mm = dist_orizz * cos(data.yaw_deg * PI / 180.0);
-    data.z_mm = data.distance_mm * sin(data.pitch_deg * PI / 180.0);
+    float dist_orizz = data.distance_mm * cos(data.pitch_deg * SYNC_DEG_TO_RAD);
+    data.x_mm = dist_orizz * sin(data.yaw_deg * SYNC_DEG_TO_RAD);
+    data.y_mm = dist_orizz * cos(data.yaw_deg * SYNC_DEG_TO_RAD);
+    data.z_mm = data.distance_mm * sin(data.pitch_deg * SYNC_DEG_TO_RAD);
 }
 
 #endif // SYNC_QUEUE_H
@@ -3,6 +3,9 @@
 
 #include "sensor_tasks.h"
 #include "sync_queue.h"
+#include "i2c_bus.h"
+#include "sensor_health.h"
+#include "timebase.h"
 
 // === TEST SUITE SINCRONIZZAZIONE ===
 class SyncTestSuite {
@@ -23,9 +26,9 @@ public:
         result.testName = "Sync Latency Test";
         uint32_t startTime = millis();
         
-        // Raccogli 100 campioni
+        // Raccogli 100 campioni (delta a 1µs)
         int validSamples = 0;
-        uint32_t totalDelta = 0;
+        uint64_t totalDelta = 0;
         uint32_t maxDelta = 0;
         
         for (int i = 0; i < 100; i++) {
@@ -33,8 +36,8 @@ public:
             if (getSensorDataTimeout(data, 200)) {
                 if (data.radar_valid && data.imu_valid) {
                     validSamples++;
-                    totalDelta += data.sync_delta_ms;
-                    maxDelta = max(maxDelta, data.sync_delta_ms);
+                    totalDelta += data.sync_delta_us;
+                    maxDelta = max(maxDelta, data.sync_delta_us);
                 }
             }
             delay(100);  // 10Hz
@@ -43,9 +46,10 @@ public:
         result.executionTime = millis() - startTime;
         
         if (validSamples > 90) {  // 90% campioni validi
-            float avgDelta = totalDelta / (float)validSamples;
-            result.passed = (avgDelta < 10.0 && maxDelta < 15);
-            result.details = String("Avg: ") + avgDelta + "ms, Max: " + maxDelta + "ms";
+            float avgDelta = usToMsF(totalDelta / validSamples);
+            float maxDeltaMs = usToMsF(maxDelta);
+            result.passed = (avgDelta < 10.0 && maxDeltaMs < 15.0);
+            result.details = String("Avg: ") + String(avgDelta, 3) + "ms, Max: " + String(maxDeltaMs, 3) + "ms";
         } else {
             result.passed = false;
             result.details = "Insufficient valid samples: " + String(validSamples);
@@ -61,13 +65,13 @@ public:
         uint32_t startTime = millis();
         
         // Misura tempo per 50 campioni
-        uint32_t timestamps[50];
+        timestamp_us_t timestamps[50];
         int samplesReceived = 0;
         
         for (int i = 0; i < 50; i++) {
             SensorData data;
             if (getSensorDataTimeout(data, 150)) {
-                timestamps[samplesReceived++] = data.timestamp_ms;
+                timestamps[samplesReceived++] = data.timestamp_us;
             }
         }
         
@@ -77,7 +81,7 @@ public:
             // Calcola intervalli
             float avgInterval = 0;
             for (int i = 1; i < samplesReceived; i++) {
-                avgInterval += (timestamps[i] - timestamps[i-1]);
+                avgInterval += usToMsF(timeDeltaUs(timestamps[i], timestamps[i-1]));
             }
             avgInterval /= (samplesReceived - 1);
             
@@ -98,23 +102,47 @@ public:
         result.testName = "Buffer Overflow Test";
         uint32_t startTime = millis();
         
-        // Sospendi consumo per causare overflow
-        delay(1000);  // Accumula 10 campioni
+        // Subscriber LOSSLESS che non legge per 1s: i campioni restano nel
+        // ring (lag), nessuno viene perso e gli altri subscriber non ne risentono
+        int8_t sub = subscribeSensorData("test", PUBSUB_LOSSLESS);
+        if (sub < 0) {
+            result.executionTime = 0;
+            result.passed = false;
+            result.details = "No subscriber slot";
+            results.push_back(result);
+            return;
+        }
         
-        // Verifica statistiche
         TaskStats stats;
         getSensorTaskStats(stats);
         uint32_t overflowsBefore = stats.queue_overflows;
         
-        // Aspetta altri campioni
-        delay(1000);
+        delay(1000);  // Accumula ~10 campioni
+        
+        PubSubSubscriberStats subStats;
+        getSensorSubscriberStats(sub, subStats);
+        uint32_t lag = subStats.lag;
+        
+        // Il display continua a vedere dati freschi mentre il test non legge
+        SensorData latest;
+        bool displayOk = getLatestSensorData(latest) &&
+                         timeDeltaUs(timebaseNowUs(), latest.timestamp_us) < 2 * SENSOR_SAMPLE_RATE_MS * 1000;
+        
+        // Svuota: tutti in ordine, senza buchi di sequenza
+        SensorData data;
+        uint32_t drained = 0;
+        while (readSensorData(sub, data, 0)) drained++;
         
+        getSensorSubscriberStats(sub, subStats);
         getSensorTaskStats(stats);
-        uint32_t overflowsAfter = stats.queue_overflows;
+        unsubscribeSensorData(sub);
         
         result.executionTime = millis() - startTime;
-        result.passed = (overflowsAfter - overflowsBefore) < 10;
-        result.details = "Overflows: " + String(overflowsAfter - overflowsBefore);
+        result.passed = lag >= 8 && drained >= lag && subStats.dropped == 0 &&
+                        stats.queue_overflows == overflowsBefore && displayOk;
+        result.details = "Lag: " + String(lag) + ", Drained: " + String(drained) +
+                         ", Dropped: " + String(subStats.dropped) +
+                         ", Display: " + (displayOk ? "OK" : "KO");
         
         results.push_back(result);
     }
@@ -165,6 +193,41 @@ public:
         results.push_back(result);
     }
     
+    // === TEST 5: Timebase ===
+    void testTimebase() {
+        TestResult result;
+        result.testName = "Timebase Test";
+        uint32_t startTime = millis();
+        
+        // Monotonia su letture ravvicinate
+        bool monotonic = true;
+        timestamp_us_t prev = timebaseNowUs();
+        for (int i = 0; i < 1000; i++) {
+            timestamp_us_t now = timebaseNowUs();
+            if (timeDeltaUs(now, prev) < 0) monotonic = false;
+            prev = now;
+        }
+        
+        // Delta a cavallo del wrap (64 bit µs e 32 bit ms)
+        bool wrapOk = timeDeltaUs(5, UINT64_MAX - 4) == 10 &&
+                      timeAbsDeltaUs(UINT64_MAX - 4, 5) == 10 &&
+                      timeDeltaMs(3, 0xFFFFFFFDu) == 6 &&
+                      timeReachedMs(2, 0xFFFFFFF0u);
+        
+        // Conversione coerente con millis()
+        uint32_t ms = millis();
+        uint32_t tbMs = usToMs(timebaseNowUs());
+        bool msOk = timeDeltaMs(tbMs, ms) >= 0 && timeDeltaMs(tbMs, ms) <= 1;
+        
+        result.executionTime = millis() - startTime;
+        result.passed = monotonic && wrapOk && msOk;
+        result.details = String("Monotonic: ") + (monotonic ? "OK" : "KO") +
+                         ", Wrap: " + (wrapOk ? "OK" : "KO") +
+                         ", ms: " + (msOk ? "OK" : "KO");
+        
+        results.push_back(result);
+    }
+    
     // === ESEGUI TUTTI I TEST ===
     void runAllTests() {
         Serial.println("\n=== SYNC TEST SUITE ===");
@@ -180,8 +243,12 @@ public:
         delay(500);
         
         testCoordinateCalculation();
+        testTimebase();
         
         printResults();
+        printI2CStats();  // Tempo bus per dispositivo durante i test
+        printSensorHealth();  // Guasti e tempi di recovery
+        printSensorSubscribers();  // Lag/perdite per subscriber
     }
     
     // === STAMPA RISULTATI ===
@@ -0,0 +1,226 @@
+// system_monitor.h
+// Calcoli del monitor di sistema (system_monitor_service.cpp): carico CPU per
+// core e per task dai contatori run-time di FreeRTOS, media e picco contro i
+// target di docs/test-plans/performance-criteria.md, uso dello stack e
+// frammentazione dello heap. Valori in permille: niente float nel task.
+// Header puro C++, testato in tools/system_monitor_test.cpp.
+#ifndef SYSTEM_MONITOR_H
+#define SYSTEM_MONITOR_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define SYSMON_MAX_TASKS       32      // uxTaskGetSystemState: Arduino + IDF + nostri, ~22
+#define SYSMON_MAX_CORES       2
+#define SYSMON_NAME_LEN        16      // configMAX_TASK_NAME_LEN di ESP-IDF
+
+// === TARGET (target / accettabile / critico) ===
+#define SYSMON_CPU_AVG_TARGET      300     // permille
+#define SYSMON_CPU_AVG_ACCEPT      500
+#define SYSMON_CPU_AVG_CRIT        700
+#define SYSMON_CPU_PEAK_TARGET     700
+#define SYSMON_CPU_PEAK_ACCEPT     850
+#define SYSMON_CPU_PEAK_CRIT       950
+#define SYSMON_HEAP_TARGET_KB      200     // Heap libero: sopra è meglio
+#define SYSMON_HEAP_ACCEPT_KB      150
+#define SYSMON_HEAP_CRIT_KB        100
+#define SYSMON_STACK_TARGET        800     // permille usati
+#define SYSMON_STACK_ACCEPT        900
+#define SYSMON_STACK_CRIT          950
+#define SYSMON_FRAG_TARGET         100     // permille
+#define SYSMON_FRAG_ACCEPT         200
+#define SYSMON_FRAG_CRIT           300
+
+enum SysMonGrade : uint8_t {
+    SYSMON_GRADE_TARGET = 0,
+    SYSMON_GRADE_ACCEPT,
+    SYSMON_GRADE_LIMIT,         // Fra accettabile e critico
+    SYSMON_GRADE_CRIT
+};
+
+// Valori dove più basso è meglio (CPU, stack, frammentazione)
+inline uint8_t sysmonGrade(uint32_t value, uint32_t target, uint32_t accept, uint32_t crit) {
+    if (value < target) return SYSMON_GRADE_TARGET;
+    if (value < accept) return SYSMON_GRADE_ACCEPT;
+    if (value < crit) return SYSMON_GRADE_LIMIT;
+    return SYSMON_GRADE_CRIT;
+}
+
+// Dove più alto è meglio (heap libero)
+inline uint8_t sysmonGradeAbove(uint32_t value, uint32_t target, uint32_t accept, uint32_t crit) {
+    if (value > target) return SYSMON_GRADE_TARGET;
+    if (value > accept) return SYSMON_GRADE_ACCEPT;
+    if (value > crit) return SYSMON_GRADE_LIMIT;
+    return SYSMON_GRADE_CRIT;
+}
+
+inline const char *sysmonGradeName(uint8_t grade) {
+    static const char *names[] = {"target", "accettabile", "limite", "critico"};
+    return grade <= SYSMON_GRADE_CRIT ? names[grade] : "?";
+}
+
+// === RAPPORTI ===
+inline uint16_t sysmonPermille(uint64_t part, uint64_t whole) {
+    if (whole == 0) return 0;
+    uint64_t p = part * 1000 / whole;
+    return (uint16_t)(p > 1000 ? 1000 : p);
+}
+
+// 1 - blocco più grande / libero: 0 = tutto contiguo
+inline uint16_t sysmonFragmentation(uint32_t freeBytes, uint32_t largestBlock) {
+    if (freeBytes == 0 || largestBlock >= freeBytes) return 0;
+    return (uint16_t)(1000 - sysmonPermille(largestBlock, freeBytes));
+}
+
+inline uint16_t sysmonStackUsed(uint32_t freeUnits, uint32_t sizeUnits) {
+    if (sizeUnits == 0 || freeUnits >= sizeUnits) return 0;
+    return sysmonPermille(sizeUnits - freeUnits, sizeUnits);
+}
+
+// === CARICO CPU ===
+// Una finestra = due letture dei contatori run-time a distanza elapsed (stessa
+// unità, µs con esp_timer). Carico di un core = 1 - tempo del suo IDLE.
+// Media = tempo occupato / tempo totale dall'avvio del monitor; picco = la
+// finestra peggiore (sistema: media dei core nella finestra).
+class SysMonCpuLoad {
+public:
+    void reset() {
+        *this = SysMonCpuLoad();
+    }
+
+    // idleDelta[c] = runtime dell'IDLE del core c nella finestra
+    void addWindow(const uint32_t *idleDelta, uint8_t cores, uint32_t elapsed) {
+        if (elapsed == 0 || cores == 0) return;
+        if (cores > SYSMON_MAX_CORES) cores = SYSMON_MAX_CORES;
+        nCores = cores;
+        uint32_t sum = 0;
+        for (uint8_t c = 0; c < cores; c++) {
+            uint32_t idle = idleDelta[c] > elapsed ? elapsed : idleDelta[c];
+            uint32_t busy = elapsed - idle;
+            coreLoad[c] = sysmonPermille(busy, elapsed);
+            if (coreLoad[c] > corePeak[c]) corePeak[c] = coreLoad[c];
+            busyTotal[c] += busy;
+            sum += coreLoad[c];
+        }
+        timeTotal += elapsed;
+        load = (uint16_t)(sum / cores);
+        if (load > peak) peak = load;
+        windows++;
+    }
+
+    uint16_t windowLoad() const { return load; }
+    uint16_t peakLoad() const { return peak; }
+    uint16_t coreWindowLoad(uint8_t c) const { return c < SYSMON_MAX_CORES ? coreLoad[c] : 0; }
+    uint16_t corePeakLoad(uint8_t c) const { return c < SYSMON_MAX_CORES ? corePeak[c] : 0; }
+    uint32_t windowCount() const { return windows; }
+
+    uint16_t coreAverageLoad(uint8_t c) const {
+        return c < SYSMON_MAX_CORES ? sysmonPermille(busyTotal[c], timeTotal) : 0;
+    }
+
+    uint16_t averageLoad() const {
+        if (!nCores) return 0;
+        uint64_t busy = 0;
+        for (uint8_t c = 0; c < nCores; c++) busy += busyTotal[c];
+        return sysmonPermille(busy, timeTotal * nCores);
+    }
+
+private:
+    uint64_t busyTotal[SYSMON_MAX_CORES] = {0};
+    uint64_t timeTotal = 0;
+    uint16_t coreLoad[SYSMON_MAX_CORES] = {0};
+    uint16_t corePeak[SYSMON_MAX_CORES] = {0};
+    uint16_t load = 0;
+    uint16_t peak = 0;
+    uint8_t nCores = 0;
+    uint32_t windows = 0;
+};
+
+// === CARICO PER TASK ===
+// Contatore run-time di ogni task alla lettura precedente, per numero di task
+// (xTaskNumber: unico, non riusato come gli handle)
+struct SysMonRuntime {
+    uint32_t id;
+    uint32_t runtime;
+};
+
+class SysMonTaskRuntimes {
+public:
+    // Runtime nella finestra; false per un task nuovo (niente lettura precedente)
+    bool delta(uint32_t id, uint32_t runtime, uint32_t &out) const {
+        for (uint8_t i = 0; i < prevCount; i++) {
+            if (prev[i].id == id) {
+                out = runtime - prev[i].runtime;    // Modulo 2^32
+                return true;
+            }
+        }
+        out = 0;
+        return false;
+    }
+
+    // Lettura corrente da usare come precedente alla prossima finestra:
+    // i task cancellati spariscono da soli
+    void store(uint8_t index, uint32_t id, uint32_t runtime) {
+        if (index < SYSMON_MAX_TASKS) next[index] = {id, runtime};
+    }
+
+    void commit(uint8_t count) {
+        prevCount = count < SYSMON_MAX_TASKS ? count : SYSMON_MAX_TASKS;
+        memcpy(prev, next, prevCount * sizeof(SysMonRuntime));
+    }
+
+private:
+    SysMonRuntime prev[SYSMON_MAX_TASKS];
+    SysMonRuntime next[SYSMON_MAX_TASKS];
+    uint8_t prevCount = 0;
+};
+
+// === FOTOGRAFIA ===
+struct SysMonTask {
+    char name[SYSMON_NAME_LEN];
+    uint8_t core;               // 0/1, SYSMON_MAX_CORES = nessuna affinità
+    uint8_t priority;
+    uint16_t load_permille;     // Di un core, nell'ultima finestra
+    uint32_t stack_free;        // High-water mark (unità di task_config.h)
+    uint32_t stack_size;        // 0 = non noto
+    uint16_t stack_used_permille;
+};
+
+struct SystemSnapshot {
+    uint32_t seq;               // Fotografie prese: cambia a ogni campionamento
+    uint32_t uptime_ms;
+    uint32_t window_ms;
+    bool runtime_stats;         // false = firmware senza run-time stats: niente CPU
+    uint8_t cores;
+    uint16_t cpu_permille;      // Finestra, media dei core
+    uint16_t cpu_avg_permille;  // Dall'avvio del monitor
+    uint16_t cpu_peak_permille; // Finestra peggiore
+    uint16_t core_permille[SYSMON_MAX_CORES];
+    uint32_t free_heap;         // Heap interno a 8 bit
+    uint32_t min_free_heap;     // Minimo dall'avvio
+    uint32_t largest_block;
+    uint16_t frag_permille;
+    uint32_t free_psram;
+    uint16_t stack_worst_permille;  // Task con lo stack più pieno
+    char stack_worst_name[SYSMON_NAME_LEN];
+    uint32_t topic_lag;         // Campioni non letti dal subscriber più indietro
+    uint8_t i2c_pending;        // Transazioni in coda sul bus manager
+    uint32_t sample_us;         // Costo del campionamento
+    uint8_t task_count;
+    SysMonTask tasks[SYSMON_MAX_TASKS];
+};
+
+// Task con lo stack più pieno fra quelli di dimensione nota
+inline void sysmonFindWorstStack(SystemSnapshot &s) {
+    s.stack_worst_permille = 0;
+    s.stack_worst_name[0] = '\0';
+    for (uint8_t i = 0; i < s.task_count; i++) {
+        const SysMonTask &t = s.tasks[i];
+        if (t.stack_size && t.stack_used_permille >= s.stack_worst_permille) {
+            s.stack_worst_permille = t.stack_used_permille;
+            memcpy(s.stack_worst_name, t.name, SYSMON_NAME_LEN);
+        }
+    }
+}
+
+#endif // SYSTEM_MONITOR_H
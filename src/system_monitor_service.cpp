@@ -0,0 +1,271 @@
+// system_monitor_service.cpp
+#include "system_monitor_service.h"
+#include "task_config.h"
+#include "sensor_tasks.h"
+#include "i2c_bus.h"
+#include "timebase.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define SYSMON_RUNTIME_STATS 1
+#else
+#define SYSMON_RUNTIME_STATS 0
+#endif
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t monitorTaskHandle = NULL;
+static SystemSnapshot work;                     // Solo il task monitor
+static SystemSnapshot published;                // Sotto snapshotMux
+static portMUX_TYPE snapshotMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool resetRequested = false;
+
+static SysMonCpuLoad cpuLoad;
+#if SYSMON_RUNTIME_STATS
+static TaskStatus_t taskStatus[SYSMON_MAX_TASKS];
+static SysMonTaskRuntimes runtimes;
+static uint32_t lastTotalRuntime = 0;
+static bool haveWindow = false;
+#endif
+
+// Stack configurato per nome (xTaskCreate dei nostri moduli + loopTask)
+struct StackSize {
+    const char *name;
+    uint32_t size;
+};
+
+static const StackSize stackSizes[] = {
+    {"loopTask",     SYSMON_LOOP_STACK_SIZE},
+    {"SensorTask",   SENSOR_TASK_STACK_SIZE},
+    {"I2CBus",       I2C_BUS_TASK_STACK_SIZE},
+    {"SensorBoot",   SENSOR_BOOT_TASK_STACK_SIZE},
+    {"Logger",       LOGGER_TASK_STACK_SIZE},
+    {"Telemetry",    TELEMETRY_TASK_STACK_SIZE},
+    {"Console",      CONSOLE_TASK_STACK_SIZE},
+    {"ConfigStore",  CONFIG_TASK_STACK_SIZE},
+    {"Inclinometer", INCLINO_TASK_STACK_SIZE},
+    {"Measure",      MEASURE_TASK_STACK_SIZE},
+    {"PointCloud",   CLOUD_TASK_STACK_SIZE},
+    {"SysMonitor",   MONITOR_TASK_STACK_SIZE},
+};
+
+static uint32_t stackSizeFor(const char *name) {
+    for (const StackSize &s : stackSizes) {
+        if (strcmp(s.name, name) == 0) return s.size;
+    }
+    return 0;
+}
+
+static void setTask(SysMonTask &t, const char *name, uint8_t core, uint8_t priority, uint32_t stackFree) {
+    strncpy(t.name, name, SYSMON_NAME_LEN - 1);
+    t.name[SYSMON_NAME_LEN - 1] = '\0';
+    t.core = core;
+    t.priority = priority;
+    t.load_permille = 0;
+    t.stack_free = stackFree;
+    t.stack_size = stackSizeFor(t.name);
+    t.stack_used_permille = sysmonStackUsed(stackFree, t.stack_size);
+}
+
+// === CAMPIONAMENTO ===
+static void sampleTasks() {
+#if SYSMON_RUNTIME_STATS
+    uint32_t totalRuntime = 0;
+    UBaseType_t count = uxTaskGetSystemState(taskStatus, SYSMON_MAX_TASKS, &totalRuntime);
+    uint32_t elapsed = totalRuntime - lastTotalRuntime;
+    lastTotalRuntime = totalRuntime;
+
+    uint32_t idleDelta[SYSMON_MAX_CORES] = {0};
+    work.task_count = 0;
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t &ts = taskStatus[i];
+        SysMonTask &t = work.tasks[work.task_count++];
+        uint8_t core = ts.xCoreID < SYSMON_MAX_CORES ? (uint8_t)ts.xCoreID : SYSMON_MAX_CORES;
+        setTask(t, ts.pcTaskName, core, (uint8_t)ts.uxCurrentPriority, ts.usStackHighWaterMark);
+
+        uint32_t delta;
+        if (runtimes.delta(ts.xTaskNumber, ts.ulRunTimeCounter, delta)) {
+            t.load_permille = sysmonPermille(delta, elapsed);
+        }
+        runtimes.store(i, ts.xTaskNumber, ts.ulRunTimeCounter);
+
+        for (uint8_t c = 0; c < portNUM_PROCESSORS && c < SYSMON_MAX_CORES; c++) {
+            if (ts.xHandle == xTaskGetIdleTaskHandleForCPU(c)) idleDelta[c] = delta;
+        }
+    }
+    runtimes.commit((uint8_t)count);
+
+    // La prima lettura fa solo da riferimento
+    if (haveWindow && count > 0) {
+        cpuLoad.addWindow(idleDelta, portNUM_PROCESSORS, elapsed);
+    }
+    haveWindow = count > 0;
+    work.runtime_stats = count > 0;     // 0 = più di SYSMON_MAX_TASKS task
+#else
+    // Solo stack, dai task registrati nel registratore di volo
+    work.task_count = 0;
+    for (uint8_t id = 1; id < FR_TASK_COUNT; id++) {
+        if (id == FR_TASK_SENSOR_BOOT) continue;    // Si cancella a fine boot
+        TaskHandle_t h = getFlightTaskHandle(id);
+        if (!h) continue;
+        setTask(work.tasks[work.task_count++], pcTaskGetName(h), SYSMON_MAX_CORES,
+                (uint8_t)uxTaskPriorityGet(h), uxTaskGetStackHighWaterMark(h));
+    }
+    work.runtime_stats = false;
+#endif
+}
+
+static void sample() {
+    timestamp_us_t start = timebaseNowUs();
+
+    if (resetRequested) {
+        cpuLoad.reset();
+        resetRequested = false;
+    }
+
+    uint32_t prevUptime = work.uptime_ms;
+    work.seq++;
+    work.uptime_ms = usToMs(start);
+    work.window_ms = work.uptime_ms - prevUptime;
+    work.cores = portNUM_PROCESSORS;
+
+    sampleTasks();
+    sysmonFindWorstStack(work);
+
+    work.cpu_permille = cpuLoad.windowLoad();
+    work.cpu_avg_permille = cpuLoad.averageLoad();
+    work.cpu_peak_permille = cpuLoad.peakLoad();
+    for (uint8_t c = 0; c < SYSMON_MAX_CORES; c++) {
+        work.core_permille[c] = cpuLoad.coreWindowLoad(c);
+    }
+
+    work.free_heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    work.min_free_heap = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    work.largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    work.frag_permille = sysmonFragmentation(work.free_heap, work.largest_block);
+    work.free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+    work.topic_lag = getSensorTopicMaxLag();
+    work.i2c_pending = getI2CQueueDepth();
+
+    work.sample_us = (uint32_t)timeDeltaUs(timebaseNowUs(), start);
+
+    portENTER_CRITICAL(&snapshotMux);
+    published = work;
+    portEXIT_CRITICAL(&snapshotMux);
+}
+
+// === TASK ===
+static void monitorTask(void *pvParameters) {
+    RTOS_LOG("System monitor task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_MONITOR);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (1) {
+        sample();
+        flightTaskBeat(FR_TASK_MONITOR);
+        vTaskDelayUntil(&lastWake, MS_TO_TICKS(SYSMON_PERIOD_MS));
+    }
+}
+
+// === API ===
+bool initSystemMonitor() {
+    if (monitorTaskHandle) return true;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        monitorTask,
+        "SysMonitor",
+        MONITOR_TASK_STACK_SIZE,
+        NULL,
+        MONITOR_TASK_PRIORITY,
+        &monitorTaskHandle,
+        MONITOR_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create system monitor task");
+        monitorTaskHandle = NULL;
+        return false;
+    }
+#if !SYSMON_RUNTIME_STATS
+    Serial.println("⚠️ Monitor: run-time stats FreeRTOS assenti, solo stack e heap");
+#endif
+    return true;
+}
+
+void getSystemSnapshot(SystemSnapshot &snapshot) {
+    portENTER_CRITICAL(&snapshotMux);
+    snapshot = published;
+    portEXIT_CRITICAL(&snapshotMux);
+}
+
+void resetSystemMonitorPeak() {
+    resetRequested = true;
+}
+
+// === REPORT ===
+static const char *gradeIcon(uint8_t grade) {
+    return grade == SYSMON_GRADE_TARGET ? "✅" : grade == SYSMON_GRADE_CRIT ? "❌" : "⚠️";
+}
+
+static void printCriterion(const char *name, uint32_t value, const char *unit, uint8_t grade) {
+    Serial.printf("%-16s %6lu%s  %s %s\n", name, (unsigned long)value, unit,
+                  gradeIcon(grade), sysmonGradeName(grade));
+}
+
+void printSystemMonitor() {
+    static SystemSnapshot s;    // ~1.1KB: fuori dallo stack della console
+    getSystemSnapshot(s);
+    if (s.seq == 0) {
+        Serial.println("⚠️ Monitor: nessun campionamento ancora");
+        return;
+    }
+
+    Serial.printf("\n=== System Monitor (#%lu, finestra %lums, campionamento %luus) ===\n",
+                  (unsigned long)s.seq, (unsigned long)s.window_ms, (unsigned long)s.sample_us);
+    Serial.println("Task             core prio   CPU%  stack libero  uso");
+    for (uint8_t i = 0; i < s.task_count; i++) {
+        const SysMonTask &t = s.tasks[i];
+        char core = t.core < SYSMON_MAX_CORES ? '0' + t.core : '-';
+        Serial.printf("%-16s %c %5u %5.1f %8lu", t.name, core, t.priority,
+                      t.load_permille / 10.0f, (unsigned long)t.stack_free);
+        if (t.stack_size) {
+            Serial.printf("  %5.1f%%\n", t.stack_used_permille / 10.0f);
+        } else {
+            Serial.println();
+        }
+    }
+
+    if (s.runtime_stats) {
+        Serial.printf("CPU: C0 %.1f%% C1 %.1f%%, media %.1f%%, picco %.1f%%\n",
+                      s.core_permille[0] / 10.0f, s.core_permille[1] / 10.0f,
+                      s.cpu_avg_permille / 10.0f, s.cpu_peak_permille / 10.0f);
+    }
+    Serial.printf("Heap: %luKB liberi (min %luKB), blocco max %luKB, PSRAM %luKB\n",
+                  (unsigned long)(s.free_heap / 1024), (unsigned long)(s.min_free_heap / 1024),
+                  (unsigned long)(s.largest_block / 1024), (unsigned long)(s.free_psram / 1024));
+    Serial.printf("Code: topic sensori %lu non letti, I2C %u in coda\n",
+                  (unsigned long)s.topic_lag, s.i2c_pending);
+
+    // Verdetto rispetto a performance-criteria.md
+    if (s.runtime_stats) {
+        printCriterion("CPU media", s.cpu_avg_permille / 10, "%",
+                       sysmonGrade(s.cpu_avg_permille, SYSMON_CPU_AVG_TARGET,
+                                   SYSMON_CPU_AVG_ACCEPT, SYSMON_CPU_AVG_CRIT));
+        printCriterion("CPU picco", s.cpu_peak_permille / 10, "%",
+                       sysmonGrade(s.cpu_peak_permille, SYSMON_CPU_PEAK_TARGET,
+                                   SYSMON_CPU_PEAK_ACCEPT, SYSMON_CPU_PEAK_CRIT));
+    }
+    printCriterion("Heap min", s.min_free_heap / 1024, "KB",
+                   sysmonGradeAbove(s.min_free_heap / 1024, SYSMON_HEAP_TARGET_KB,
+                                    SYSMON_HEAP_ACCEPT_KB, SYSMON_HEAP_CRIT_KB));
+    printCriterion("Frammentazione", s.frag_permille / 10, "%",
+                   sysmonGrade(s.frag_permille, SYSMON_FRAG_TARGET,
+                               SYSMON_FRAG_ACCEPT, SYSMON_FRAG_CRIT));
+    char label[24];
+    snprintf(label, sizeof(label), "Stack %s", s.stack_worst_name);
+    printCriterion(label, s.stack_worst_permille / 10, "%",
+                   sysmonGrade(s.stack_worst_permille, SYSMON_STACK_TARGET,
+                               SYSMON_STACK_ACCEPT, SYSMON_STACK_CRIT));
+    Serial.println("===========================\n");
+}
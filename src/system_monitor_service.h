@@ -0,0 +1,38 @@
+// system_monitor_service.h
+#ifndef SYSTEM_MONITOR_SERVICE_H
+#define SYSTEM_MONITOR_SERVICE_H
+
+#include <Arduino.h>
+#include "system_monitor.h"
+
+// === MONITOR DI SISTEMA ===
+// Task a bassa priorità che ogni SYSMON_PERIOD_MS fotografa carico CPU per
+// core e per task (run-time stats di FreeRTOS), stack high-water di tutti i
+// task, heap libero / minimo / blocco più grande e profondità delle code
+// (topic sensori, bus I2C). Un campionamento costa qualche decina di µs una
+// volta al secondo; i lettori (UI, telemetria, console) copiano l'ultima
+// fotografia sotto spinlock, senza mai interrogare FreeRTOS.
+// Media e picco CPU vanno confrontati con i target di
+// docs/test-plans/performance-criteria.md (printSystemMonitor lo fa).
+
+#define SYSMON_PERIOD_MS       1000
+
+// loopTask di Arduino: non passa da task_config.h
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+#define SYSMON_LOOP_STACK_SIZE CONFIG_ARDUINO_LOOP_STACK_SIZE
+#else
+#define SYSMON_LOOP_STACK_SIZE 8192
+#endif
+
+bool initSystemMonitor();
+
+// Ultima fotografia (seq = 0: nessun campionamento ancora)
+void getSystemSnapshot(SystemSnapshot &snapshot);
+
+// Media e picco ripartono da zero (inizio di una prova)
+void resetSystemMonitorPeak();
+
+// Tabella per task + verdetto sui target
+void printSystemMonitor();
+
+#endif // SYSTEM_MONITOR_SERVICE_H
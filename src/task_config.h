@@ -5,25 +5,62 @@
 // Stack sizes (in words, not bytes!)
 #define SENSOR_TASK_STACK_SIZE  4096    // 16KB per task sensori
 #define DISPLAY_TASK_STACK_SIZE 8192    // 32KB per display (se futuro)
+#define I2C_BUS_TASK_STACK_SIZE 3072    // 12KB per bus manager I2C (driver)
+#define SENSOR_BOOT_TASK_STACK_SIZE 4096 // 16KB per init sensori (temporaneo)
+#define TELEMETRY_TASK_STACK_SIZE 3072  // 12KB per stream telemetria
+#define CONSOLE_TASK_STACK_SIZE 3072    // 12KB per console seriale (printf)
+#define CONFIG_TASK_STACK_SIZE 3072     // 12KB per salvataggio NVS
+#define INCLINO_TASK_STACK_SIZE 3072    // 12KB per inclinometro (FIFO IMU)
+#define MEASURE_TASK_STACK_SIZE 3072    // 12KB per misura da tasto (printf)
+#define CLOUD_TASK_STACK_SIZE   3072    // 12KB per accumulo nuvola di punti
+#define LOGGER_TASK_STACK_SIZE  3072    // 12KB per log di sessione su SD
+#define MONITOR_TASK_STACK_SIZE 3072    // 12KB per monitor di sistema (printf)
 
 // Priorità task (0=lowest, configMAX_PRIORITIES-1=highest)
 #define SENSOR_TASK_PRIORITY    2       // Media priorità
+#define I2C_BUS_TASK_PRIORITY   3       // Sopra i sensori: serve le loro richieste
 #define UI_TASK_PRIORITY       3       // Alta priorità per responsività
 #define LOGGER_TASK_PRIORITY   1       // Bassa priorità
+#define SENSOR_BOOT_TASK_PRIORITY 1    // Sotto la UI: il menu va a video per primo
+#define TELEMETRY_TASK_PRIORITY 1      // Come il logger: usa solo il tempo libero
+#define CONSOLE_TASK_PRIORITY   1      // Interattiva ma mai sopra UI e sensori
+#define CONFIG_TASK_PRIORITY    1      // Scrittura flash solo nel tempo libero
+#define INCLINO_TASK_PRIORITY   1      // Sotto i sensori: la FIFO tollera ritardi
+#define MEASURE_TASK_PRIORITY   1      // L'istante del trigger è preso nell'ISR
+#define CLOUD_TASK_PRIORITY     1      // Subscriber con perdita: mai backpressure sui sensori
+#define MONITOR_TASK_PRIORITY   1      // Appena sopra idle: misura, non deve pesare
 
 // Core assignment
 #define SENSOR_TASK_CORE       1       // Core 1 dedicato ai sensori
 #define UI_TASK_CORE          0       // Core 0 per UI/WiFi/BT
+#define SENSOR_BOOT_TASK_CORE 0       // Opposto a setup()/loop(): boot in parallelo
+#define TELEMETRY_TASK_CORE   0       // Fuori dal core di loop() e dei sensori
+#define CONSOLE_TASK_CORE     0
+#define CONFIG_TASK_CORE      0
+#define INCLINO_TASK_CORE     0
+#define MEASURE_TASK_CORE     0
+#define CLOUD_TASK_CORE       0
+#define LOGGER_TASK_CORE      0
+#define MONITOR_TASK_CORE     0
+
+// Boot sensori
+#define SENSOR_INIT_RETRIES    3       // Tentativi per sensore al boot
+#define SENSOR_INIT_RETRY_MS   100     // Pausa fra i tentativi
 
 // Timing
 #define SENSOR_SAMPLE_RATE_MS  100     // 10Hz come da specifica
 #define UI_UPDATE_RATE_MS      33      // ~30Hz per display fluido
-#define TOUCH_SCAN_RATE_MS     10      // 100Hz per touch responsivo
+#define TOUCH_SCAN_RATE_MS     10      // 100Hz per touch responsivo (solo senza IRQ)
+#define UI_IDLE_TIMEOUT_MS     1000    // Attesa max eventi UI (report seriale 1Hz)
+
+// Deadline transazioni I2C del ciclo sensori
+#define RADAR_READ_DEADLINE_US 50000   // Avvio lettura radar entro 50ms
+#define IMU_READ_DEADLINE_US   5000    // IMU entro 5ms dalla fine radar
+#define SENSOR_CYCLE_TIMEOUT_MS 90     // Attesa max catena radar+IMU
 
 // === SEMAFORI E MUTEX ===
-extern SemaphoreHandle_t i2cMutex;      // Protezione bus I2C
 extern SemaphoreHandle_t displayMutex;  // Protezione display
-extern SemaphoreHandle_t eepromMutex;   // Protezione EEPROM
+extern SemaphoreHandle_t eepromMutex;   // Protezione EEPROM (solo layout legacy)
 
 // === TASK HANDLES ===
 extern TaskHandle_t sensorTaskHandle;
@@ -39,7 +76,9 @@ typedef enum {
 } TaskState_t;
 
 // === MACRO UTILITY ===
-#define TAKE_MUTEX(mutex, timeout) (xSemaphoreTake(mutex, timeout) == pdTRUE)
+// Le attese sui mutex contesi finiscono nel registratore di volo
+#include "flight_recorder_service.h"
+#define TAKE_MUTEX(mutex, timeout) flightTakeMutex(mutex, timeout)
 #define GIVE_MUTEX(mutex) xSemaphoreGive(mutex)
 
 // Conversione ms to ticks
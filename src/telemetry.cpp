@@ -0,0 +1,231 @@
+// telemetry.cpp
+#include "telemetry.h"
+#include "task_config.h"
+#include "sensor_tasks.h"
+#include "sensor_health.h"
+#include "i2c_bus.h"
+#include "timebase.h"
+#include "system_monitor_service.h"
+#include "power_manager.h"
+
+// === VARIABILI DI STATO ===
+static TaskHandle_t telemetryTaskHandle = NULL;
+static volatile bool telemetryEnabled = TELEMETRY_AUTOSTART;
+static int8_t telemetrySub = -1;
+static uint16_t frameSeq = 0;
+static uint8_t txBuffer[TELEM_MAX_ENCODED];
+
+static TelemLinkStats linkStats;
+static uint32_t windowBusyUs = 0;
+static SystemSnapshot snapshot;         // Statica: ~1.1KB fuori dallo stack del task
+static uint32_t lastSnapshotSeq = 0;
+static timestamp_us_t windowStartUs = 0;
+
+// === INVIO ===
+// Non bloccante: se il buffer CDC non ha spazio il frame è perso (contato)
+static void sendFrame(uint8_t type, const void *payload, size_t len) {
+    timestamp_us_t start = timebaseNowUs();
+
+    size_t n = telemEncodeFrame(type, frameSeq++, payload, len, txBuffer);
+    if (n == 0) return;
+
+    if (Serial.availableForWrite() < (int)n) {
+        linkStats.frames_dropped++;
+    } else {
+        Serial.write(txBuffer, n);
+        linkStats.frames_sent++;
+        linkStats.bytes_sent += n;
+    }
+
+    uint32_t us = (uint32_t)timeDeltaUs(timebaseNowUs(), start);
+    windowBusyUs += us;
+    if (us > linkStats.max_frame_us) linkStats.max_frame_us = us > 0xFFFF ? 0xFFFF : us;
+}
+
+// Solo quando il monitor ha una fotografia nuova (1Hz, non a ogni finestra)
+static void sendSystemStats() {
+    getSystemSnapshot(snapshot);
+    if (snapshot.seq == lastSnapshotSeq) return;
+    lastSnapshotSeq = snapshot.seq;
+
+    TelemSystemStats sys = {};
+    sys.uptime_ms = snapshot.uptime_ms;
+    sys.free_heap = snapshot.free_heap;
+    sys.min_free_heap = snapshot.min_free_heap;
+    sys.largest_block = snapshot.largest_block;
+    sys.free_psram = snapshot.free_psram;
+    sys.topic_lag = snapshot.topic_lag;
+    sys.cpu_permille = snapshot.cpu_permille;
+    sys.cpu_avg_permille = snapshot.cpu_avg_permille;
+    sys.cpu_peak_permille = snapshot.cpu_peak_permille;
+    sys.core_permille[0] = snapshot.core_permille[0];
+    sys.core_permille[1] = snapshot.core_permille[1];
+    sys.frag_permille = snapshot.frag_permille;
+    sys.stack_worst_permille = snapshot.stack_worst_permille;
+    sys.sample_us = snapshot.sample_us > 0xFFFF ? 0xFFFF : snapshot.sample_us;
+    sys.i2c_pending = snapshot.i2c_pending;
+    sys.task_count = snapshot.task_count;
+    sys.runtime_stats = snapshot.runtime_stats;
+    sendFrame(TELEM_FRAME_SYSTEM, &sys, sizeof(sys));
+
+    for (uint8_t i = 0; i < snapshot.task_count; i++) {
+        const SysMonTask &t = snapshot.tasks[i];
+        TelemTaskLoad load = {};
+        memcpy(load.name, t.name, sizeof(load.name));
+        load.stack_free = t.stack_free;
+        load.load_permille = t.load_permille;
+        load.stack_used_permille = t.stack_used_permille;
+        load.core = t.core;
+        load.priority = t.priority;
+        load.index = i;
+        sendFrame(TELEM_FRAME_TASK_LOAD, &load, sizeof(load));
+    }
+}
+
+static void sendStats() {
+    TaskStats ts;
+    getSensorTaskStats(ts);
+    TelemTaskStats task = {
+        ts.samples_acquired, ts.sync_success, ts.sync_failures, ts.queue_overflows,
+        ts.bus_failures, ts.bus_overruns, ts.max_sync_delta_us,
+        (uint32_t)(ts.avg_sync_delta_ms * 1000)
+    };
+    sendFrame(TELEM_FRAME_TASK_STATS, &task, sizeof(task));
+
+    for (uint8_t d = 0; d < I2C_DEV_COUNT; d++) {
+        I2CDeviceStats s;
+        getI2CDeviceStats(d, s);
+        TelemI2CStats i2c = {};
+        i2c.device = d;
+        i2c.transactions = s.transactions;
+        i2c.bytes = s.bytes;
+        i2c.errors = s.errors;
+        i2c.deadline_misses = s.deadline_misses;
+        i2c.batched = s.batched;
+        i2c.busy_ms = (uint32_t)(s.busy_us / 1000);
+        i2c.max_busy_us = s.max_busy_us;
+        i2c.max_wait_us = s.max_wait_us;
+        sendFrame(TELEM_FRAME_I2C_STATS, &i2c, sizeof(i2c));
+    }
+
+    BusHealth bus;
+    getBusHealth(bus);
+    for (uint8_t i = 0; i < HEALTH_SENSOR_COUNT; i++) {
+        SensorHealth h;
+        getSensorHealth(i, h);
+        TelemHealth health = {};
+        health.sensor = i;
+        health.state = h.state;
+        health.consecutive_errors = h.consecutive_errors;
+        health.total_errors = h.total_errors;
+        health.faults = h.faults;
+        health.recoveries = h.recoveries;
+        health.max_recovery_ms = h.max_recovery_ms;
+        health.bus_recoveries = bus.recoveries;
+        health.bus_recovery_failed = bus.failed;
+        sendFrame(TELEM_FRAME_HEALTH, &health, sizeof(health));
+    }
+
+    sendSystemStats();
+
+    // Costo del task nella finestra appena chiusa (frame link incluso nella prossima)
+    timestamp_us_t now = timebaseNowUs();
+    linkStats.uptime_ms = usToMs(now);
+    linkStats.busy_us = windowBusyUs;
+    linkStats.window_us = (uint32_t)timeDeltaUs(now, windowStartUs);
+    linkStats.cpu_permille = linkStats.window_us ? (uint16_t)((uint64_t)windowBusyUs * 1000 / linkStats.window_us) : 0;
+    if (telemetrySub >= 0) {
+        PubSubSubscriberStats sub;
+        getSensorSubscriberStats(telemetrySub, sub);
+        linkStats.samples_dropped = sub.dropped;
+    }
+    sendFrame(TELEM_FRAME_LINK, &linkStats, sizeof(linkStats));
+
+    windowBusyUs = 0;
+    windowStartUs = now;
+}
+
+// === TASK ===
+static void telemetryTask(void *pvParameters) {
+    RTOS_LOG("Telemetry task started on core %d", xPortGetCoreID());
+    flightRegisterTask(FR_TASK_TELEMETRY);
+    uint32_t nextStatsMs = millis();
+
+    while (1) {
+        // Subscriber attivo solo con lo stream abilitato e il topic pronto
+        SensorBootState boot = getSensorBootState();
+        if (!telemetryEnabled || boot != SENSOR_BOOT_DONE) {
+            if (telemetrySub >= 0) {
+                unsubscribeSensorData(telemetrySub);
+                telemetrySub = -1;
+            }
+            // Disabilitato: fermo fino a setTelemetryEnabled(); si riprova a
+            // tempo solo mentre i sensori si avviano
+            ulTaskNotifyTake(pdTRUE, telemetryEnabled && boot != SENSOR_BOOT_FAILED ?
+                                     MS_TO_TICKS(TELEMETRY_STATS_PERIOD_MS) : portMAX_DELAY);
+            nextStatsMs = millis();
+            continue;
+        }
+        if (telemetrySub < 0) {
+            telemetrySub = subscribeSensorData("telemetry", PUBSUB_DECIMATED,
+                                               TELEMETRY_SAMPLE_DECIMATION);
+            windowStartUs = timebaseNowUs();
+            windowBusyUs = 0;
+            if (telemetrySub < 0) {
+                vTaskDelay(MS_TO_TICKS(TELEMETRY_STATS_PERIOD_MS));
+                continue;
+            }
+        }
+
+        // Attende il prossimo campione al massimo fino ai record di stato
+        int32_t wait = timeDeltaMs(nextStatsMs, millis());
+        SensorRecord record;
+        if (readSensorRecord(telemetrySub, record, wait > 0 ? wait : 0)) {
+            sendFrame(TELEM_FRAME_SAMPLE, &record, sizeof(record));
+        }
+
+        if (timeReachedMs(millis(), nextStatsMs)) {
+            sendStats();
+            nextStatsMs += TELEMETRY_STATS_PERIOD_MS;
+            // Dopo una lunga pausa non recuperare i periodi persi
+            if (timeReachedMs(millis(), nextStatsMs)) nextStatsMs = millis() + TELEMETRY_STATS_PERIOD_MS;
+        }
+    }
+}
+
+// === API ===
+bool initTelemetry() {
+    if (telemetryTaskHandle) return true;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        telemetryTask,
+        "Telemetry",
+        TELEMETRY_TASK_STACK_SIZE,
+        NULL,
+        TELEMETRY_TASK_PRIORITY,
+        &telemetryTaskHandle,
+        TELEMETRY_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("❌ Failed to create telemetry task");
+        return false;
+    }
+    setLightSleepAllowed(PM_HOLD_TELEMETRY, !telemetryEnabled);
+    return true;
+}
+
+void setTelemetryEnabled(bool enabled) {
+    telemetryEnabled = enabled;
+    // In light sleep la USB-CDC si ferma: lo stream perderebbe frame
+    setLightSleepAllowed(PM_HOLD_TELEMETRY, !enabled);
+    if (telemetryTaskHandle) xTaskNotifyGive(telemetryTaskHandle);
+}
+
+bool isTelemetryEnabled() {
+    return telemetryEnabled;
+}
+
+void getTelemetryStats(TelemLinkStats &stats) {
+    stats = linkStats;
+}
@@ -0,0 +1,29 @@
+// telemetry.h
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "telemetry_protocol.h"
+
+// === TELEMETRIA BINARIA (USB-CDC) ===
+// Task a bassa priorità: ogni campione (SensorRecord) e i record di stato
+// (task, I2C, health, link) come frame COBS+CRC. Non blocca mai: con il
+// buffer USB pieno il frame viene scartato e contato in frames_dropped.
+// Decoder/registratore host: tools/telemetry_cli.cpp
+
+#ifndef TELEMETRY_AUTOSTART
+#define TELEMETRY_AUTOSTART        0   // 1 = stream attivo dal boot
+#endif
+#define TELEMETRY_STATS_PERIOD_MS  250     // Record di stato: 4Hz
+#define TELEMETRY_SAMPLE_DECIMATION 1      // 1 = tutti i campioni
+
+// Crea il task (lo stream parte solo se abilitato)
+bool initTelemetry();
+
+void setTelemetryEnabled(bool enabled);
+bool isTelemetryEnabled();
+
+// Contatori del link (stessi valori del frame TELEM_FRAME_LINK)
+void getTelemetryStats(TelemLinkStats &stats);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,281 @@
+// telemetry_protocol.h
+// Protocollo telemetria binaria su USB-CDC e formato trace del registratore
+// host. Header puro C++ (nessuna dipendenza Arduino): lo stesso codice
+// codifica sul device e decodifica in tools/telemetry_cli.cpp.
+//
+// Frame sul filo:  0x00 | COBS( header | payload | crc16 ) | 0x00
+// Lo 0x00 iniziale isola il frame dalle righe di log testuali che passano
+// sulla stessa seriale: il decoder le riconosce come chunk non validi.
+#ifndef TELEMETRY_PROTOCOL_H
+#define TELEMETRY_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define TELEM_PROTOCOL_VERSION   1
+#define TELEM_MAX_PAYLOAD        64
+#define TELEM_MAX_FRAME          (sizeof(TelemFrameHeader) + TELEM_MAX_PAYLOAD + 2)
+// COBS aggiunge 1 byte ogni 254 + i due delimitatori
+#define TELEM_MAX_ENCODED        (TELEM_MAX_FRAME + TELEM_MAX_FRAME / 254 + 1 + 2)
+
+// === TIPI DI FRAME ===
+enum TelemFrameType : uint8_t {
+    TELEM_FRAME_SAMPLE = 1,     // SensorRecord (sensor_record.h), ogni campione
+    TELEM_FRAME_TASK_STATS,     // TelemTaskStats
+    TELEM_FRAME_I2C_STATS,      // TelemI2CStats, uno per dispositivo
+    TELEM_FRAME_HEALTH,         // TelemHealth, uno per sensore
+    TELEM_FRAME_LINK,           // TelemLinkStats: costo e perdite della telemetria
+    TELEM_FRAME_SYSTEM,         // TelemSystemStats: CPU, heap, code (monitor, 1Hz)
+    TELEM_FRAME_TASK_LOAD       // TelemTaskLoad, uno per task a ogni TELEM_FRAME_SYSTEM
+};
+
+struct TelemFrameHeader {
+    uint8_t type;
+    uint8_t version;
+    uint16_t seq;               // Per frame inviato: i buchi sull'host = perdite
+};
+
+// === PAYLOAD (little endian, campi allineati, niente padding implicito) ===
+struct TelemTaskStats {
+    uint32_t samples_acquired;
+    uint32_t sync_success;
+    uint32_t sync_failures;
+    uint32_t queue_overflows;
+    uint32_t bus_failures;
+    uint32_t bus_overruns;
+    uint32_t max_sync_delta_us;
+    uint32_t avg_sync_delta_us;
+};
+
+struct TelemI2CStats {
+    uint8_t device;             // I2C_DEV_*
+    uint8_t reserved[3];
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t deadline_misses;
+    uint32_t batched;
+    uint32_t busy_ms;
+    uint32_t max_busy_us;
+    uint32_t max_wait_us;
+};
+
+struct TelemHealth {
+    uint8_t sensor;             // HEALTH_RADAR / HEALTH_IMU
+    uint8_t state;              // HealthState
+    uint8_t consecutive_errors;
+    uint8_t reserved;
+    uint32_t total_errors;
+    uint32_t faults;
+    uint32_t recoveries;
+    uint32_t max_recovery_ms;
+    uint32_t bus_recoveries;
+    uint32_t bus_recovery_failed;
+};
+
+struct TelemLinkStats {
+    uint32_t uptime_ms;
+    uint32_t frames_sent;
+    uint32_t frames_dropped;    // Buffer USB pieno: frame scartato senza bloccare
+    uint32_t bytes_sent;
+    uint32_t samples_dropped;   // Campioni sovrascritti nel topic prima dell'invio
+    uint32_t busy_us;           // Tempo CPU del task nell'ultima finestra
+    uint32_t window_us;
+    uint16_t cpu_permille;      // busy_us / window_us
+    uint16_t max_frame_us;      // Codifica + scrittura più lenta
+};
+
+struct TelemSystemStats {
+    uint32_t uptime_ms;
+    uint32_t free_heap;
+    uint32_t min_free_heap;
+    uint32_t largest_block;
+    uint32_t free_psram;
+    uint32_t topic_lag;         // Campioni non letti dal subscriber più indietro
+    uint16_t cpu_permille;      // Ultima finestra, media dei core
+    uint16_t cpu_avg_permille;
+    uint16_t cpu_peak_permille;
+    uint16_t core_permille[2];
+    uint16_t frag_permille;
+    uint16_t stack_worst_permille;
+    uint16_t sample_us;         // Costo del campionamento
+    uint8_t i2c_pending;
+    uint8_t task_count;         // Frame TELEM_FRAME_TASK_LOAD che seguono
+    uint8_t runtime_stats;      // 0 = CPU non disponibile
+    uint8_t reserved;
+};
+
+struct TelemTaskLoad {
+    char name[16];
+    uint32_t stack_free;
+    uint16_t load_permille;
+    uint16_t stack_used_permille;   // 0 = dimensione non nota
+    uint8_t core;               // 2 = nessuna affinità
+    uint8_t priority;
+    uint8_t index;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(TelemFrameHeader) == 4, "TelemFrameHeader: 4 byte");
+static_assert(sizeof(TelemTaskStats) == 32, "TelemTaskStats: layout fisso");
+static_assert(sizeof(TelemI2CStats) == 36, "TelemI2CStats: layout fisso");
+static_assert(sizeof(TelemHealth) == 28, "TelemHealth: layout fisso");
+static_assert(sizeof(TelemLinkStats) == 32, "TelemLinkStats: layout fisso");
+static_assert(sizeof(TelemSystemStats) == 44, "TelemSystemStats: layout fisso");
+static_assert(sizeof(TelemTaskLoad) == 28, "TelemTaskLoad: layout fisso");
+
+// === CRC-16/CCITT-FALSE ===
+// Tabella a nibble: 32 byte di flash, ~2 lookup per byte
+inline uint16_t telemCrc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF) {
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+    };
+    for (size_t i = 0; i < len; i++) {
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+// === COBS ===
+// Codifica senza delimitatore; out deve avere len + len/254 + 1 byte
+inline size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t codeIdx = 0, o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[codeIdx] = code;
+            codeIdx = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) {
+            out[codeIdx] = code;
+            codeIdx = o++;
+            code = 1;
+        }
+    }
+    out[codeIdx] = code;
+    return o;
+}
+
+// Ritorna la lunghezza decodificata, 0 se il chunk non è COBS valido
+inline size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t outMax) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) return 0;
+        for (uint8_t k = 1; k < code; k++) {
+            if (o >= outMax) return 0;
+            out[o++] = in[i++];
+        }
+        if (code != 0xFF && i < len) {
+            if (o >= outMax) return 0;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+// === FRAME ===
+// Ritorna i byte da scrivere (delimitatori inclusi), 0 se il payload è troppo grande
+inline size_t telemEncodeFrame(uint8_t type, uint16_t seq, const void *payload,
+                               size_t len, uint8_t *out) {
+    if (len > TELEM_MAX_PAYLOAD) return 0;
+
+    uint8_t frame[TELEM_MAX_FRAME];
+    TelemFrameHeader hdr = {type, TELEM_PROTOCOL_VERSION, seq};
+    memcpy(frame, &hdr, sizeof(hdr));
+    memcpy(frame + sizeof(hdr), payload, len);
+    size_t n = sizeof(hdr) + len;
+    uint16_t crc = telemCrc16(frame, n);
+    frame[n++] = (uint8_t)(crc & 0xFF);
+    frame[n++] = (uint8_t)(crc >> 8);
+
+    out[0] = 0;
+    size_t e = cobsEncode(frame, n, out + 1);
+    out[e + 1] = 0;
+    return e + 2;
+}
+
+enum TelemDecodeResult {
+    TELEM_DECODE_OK = 0,
+    TELEM_DECODE_EMPTY,         // Due delimitatori consecutivi
+    TELEM_DECODE_COBS_ERROR,    // Rumore o testo di log
+    TELEM_DECODE_SHORT,
+    TELEM_DECODE_CRC_ERROR
+};
+
+// Decodifica un chunk (senza delimitatori). frame riceve header + payload,
+// frameLen esclude il CRC.
+inline TelemDecodeResult telemDecodeFrame(const uint8_t *chunk, size_t len,
+                                          uint8_t *frame, size_t &frameLen) {
+    frameLen = 0;
+    if (len == 0) return TELEM_DECODE_EMPTY;
+    size_t n = cobsDecode(chunk, len, frame, TELEM_MAX_FRAME);
+    if (n == 0) return TELEM_DECODE_COBS_ERROR;
+    if (n < sizeof(TelemFrameHeader) + 2) return TELEM_DECODE_SHORT;
+
+    uint16_t crc = (uint16_t)(frame[n - 2] | (frame[n - 1] << 8));
+    if (telemCrc16(frame, n - 2) != crc) return TELEM_DECODE_CRC_ERROR;
+    frameLen = n - 2;
+    return TELEM_DECODE_OK;
+}
+
+// Accumula byte dalla seriale fino al delimitatore
+class TelemStreamDecoder {
+public:
+    TelemStreamDecoder() : len(0), overflow(false) {}
+
+    // true quando chunk()/chunkLen() contengono un chunk completo
+    bool feed(uint8_t byte) {
+        if (byte == 0) {
+            bool ready = len > 0 && !overflow;
+            if (!ready) len = 0;
+            overflow = false;
+            return ready;
+        }
+        if (len >= sizeof(buf)) {
+            overflow = true;    // Riga di log lunga: scartata
+            return false;
+        }
+        buf[len++] = byte;
+        return false;
+    }
+
+    const uint8_t *chunk() const { return buf; }
+    size_t chunkLen() const { return len; }
+    void consume() { len = 0; }
+
+private:
+    uint8_t buf[512];
+    size_t len;
+    bool overflow;
+};
+
+// === FORMATO TRACE (registrazione host, riproducibile) ===
+// File: TelemTraceHeader, poi per ogni frame valido TelemTraceRecord seguito
+// da `len` byte di header + payload (CRC già verificato).
+#define TELEM_TRACE_MAGIC    "HYSQTRC1"
+#define TELEM_TRACE_VERSION  1
+
+struct TelemTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t protocol;
+};
+
+struct TelemTraceRecord {
+    uint64_t host_us;           // Istante di ricezione sull'host
+    uint16_t len;
+    uint16_t reserved;
+    uint32_t reserved2;
+};
+
+static_assert(sizeof(TelemTraceHeader) == 16, "TelemTraceHeader: layout fisso");
+static_assert(sizeof(TelemTraceRecord) == 16, "TelemTraceRecord: layout fisso");
+
+#endif // TELEMETRY_PROTOCOL_H
@@ -0,0 +1,80 @@
+// timebase.h
+// Base tempi unica per i timestamp sensori: µs a 64 bit, monotona, presa
+// all'istante di fine trasferimento I2C. 2^64 µs non vanno mai in overflow;
+// le API in millisecondi esistenti ricevono valori convertiti da qui.
+// Su host (senza ARDUINO) o con TIMEBASE_VIRTUAL l'orologio è virtuale e
+// avanza solo a comando: i test di timing sono deterministici.
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+
+#if defined(ARDUINO) && !defined(TIMEBASE_VIRTUAL)
+#include <esp_timer.h>
+#define TIMEBASE_HW 1
+#else
+#define TIMEBASE_HW 0
+#endif
+
+typedef uint64_t timestamp_us_t;
+
+// === OROLOGIO ===
+#if TIMEBASE_HW
+// esp_timer: 1µs, parte all'avvio dell'app, stesso riferimento di millis()
+inline timestamp_us_t timebaseNowUs() {
+    return (timestamp_us_t)esp_timer_get_time();
+}
+#else
+inline timestamp_us_t &timebaseVirtualClock() {
+    static timestamp_us_t clockUs = 0;
+    return clockUs;
+}
+
+inline timestamp_us_t timebaseNowUs() { return timebaseVirtualClock(); }
+inline void timebaseSetUs(timestamp_us_t us) { timebaseVirtualClock() = us; }
+inline void timebaseAdvanceUs(uint64_t us) { timebaseVirtualClock() += us; }
+#endif
+
+// === DIFFERENZE ===
+// a - b con segno: corretta anche se i due istanti stanno a cavallo di un wrap
+inline int64_t timeDeltaUs(timestamp_us_t a, timestamp_us_t b) {
+    return (int64_t)(a - b);
+}
+
+inline uint64_t timeAbsDeltaUs(timestamp_us_t a, timestamp_us_t b) {
+    int64_t d = timeDeltaUs(a, b);
+    return (uint64_t)(d < 0 ? -d : d);
+}
+
+// Per i contatori a 32 bit (millis()): confronto modulo 2^32, valido
+// finché i due istanti distano meno di ~24 giorni
+inline int32_t timeDeltaMs(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b);
+}
+
+inline bool timeReachedMs(uint32_t now, uint32_t target) {
+    return timeDeltaMs(now, target) >= 0;
+}
+
+// === CONVERSIONI (API in millisecondi) ===
+// Troncamento come millis(): usToMs(timebaseNowUs()) == millis()
+inline uint32_t usToMs(timestamp_us_t us) {
+    return (uint32_t)(us / 1000);
+}
+
+inline timestamp_us_t msToUs(uint32_t ms) {
+    return (timestamp_us_t)ms * 1000;
+}
+
+// Intervalli brevi (sync, latenze) con risoluzione sub-ms
+inline float usToMsF(int64_t us) {
+    return us / 1000.0f;
+}
+
+// Saturata a 32 bit per i campi "delta" esistenti
+inline uint32_t usToMsSat(uint64_t us) {
+    uint64_t ms = us / 1000;
+    return ms > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)ms;
+}
+
+#endif // TIMEBASE_H
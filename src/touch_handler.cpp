@@ -5,6 +5,9 @@
 #include "leaf_actions.h"
 #include "service_menu.h"
 #include "ui_config.h"
+#include "power_manager.h"
+#include "task_config.h"
+#include "sensor_tasks.h"
 
 // Puntatori esterni
 extern CSE_CST328 *touch;
@@ -55,9 +58,13 @@ void drawMenu(Arduino_GFX* gfx, UIConfig& ui, MenuState state) {
         for (int i = 0; i < itemCount; i++) {
             int y = BTN_Y_START + i * BTN_SPACING;
             
+            // Voci sensori non ancora disponibili: grigie con stato
+            bool waiting = menuItemNeedsSensors(state, i) && !areSensorsReady();
+            
             // Colore basato su selezione
             uint16_t bgColor = (i == selectedIndex) ? ui.activeColor : ui.buttonColor;
             uint16_t textColor = (i == selectedIndex) ? WHITE : ui.textColor;
+            if (waiting) textColor = DARKGREY;
             
             // Disegna pulsante
             gfx->fillRect(BTN_X_OFFSET, y, BTN_WIDTH, BTN_HEIGHT, bgColor);
@@ -67,6 +74,13 @@ void drawMenu(Arduino_GFX* gfx, UIConfig& ui, MenuState state) {
             gfx->setCursor(BTN_X_OFFSET + 20, y + (BTN_HEIGHT - 16) / 2);
             gfx->setTextColor(textColor);
             gfx->println(items[i]);
+            
+            if (waiting) {
+                gfx->setTextSize(1);
+                gfx->setCursor(BTN_X_OFFSET + 20, y + BTN_HEIGHT - 10);
+                gfx->println(getSensorBootState() == SENSOR_BOOT_RUNNING ? "warming up..." : "sensor error");
+                gfx->setTextSize(ui.textSize);
+            }
         }
     }
     
@@ -167,6 +181,14 @@ void handleMenuConfirm(Arduino_GFX* gfx, UIConfig& ui) {
     MenuState currentState = getCurrentMenuState();
     int selectedIndex = getSelectedIndex();
     
+    // Sensori ancora in avvio: la voce resta inattiva
+    if (menuItemNeedsSensors(currentState, selectedIndex) && !areSensorsReady()) {
+        showMessage(gfx, "Warming up...", YELLOW, BLACK);
+        delay(1000);
+        drawMenu(gfx, ui, currentState);
+        return;
+    }
+    
     switch (currentState) {
         case MAIN_MENU:
             handleMainMenuSelection(selectedIndex, gfx, ui);
@@ -213,6 +235,8 @@ void handleMainMenuSelection(int index, Arduino_GFX* gfx, UIConfig& ui) {
 
 // === GESTIONE SUBMENU 1 (PITCH,YAW,DIST) ===
 void handleSubmenu1Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
+    // Le leaf bloccano il loop: se non esce, la traccia lo dice
+    flightEvent(FR_EV_LEAF_ENTER, SUBMENU_1, index);
     switch (index) {
         case 0: // Start Acquis.
             showMessage(gfx, "Starting...", WHITE, BLACK);
@@ -222,13 +246,14 @@ void handleSubmenu1Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
         case 1: // Live Graph
             setCurrentMenuState(DISPLAY_LIVE_DATA);
             LeafActions::showLiveData();
+            flightEvent(FR_EV_LEAF_EXIT, SUBMENU_1, index);
             return; // Non ridisegnare menu
             
-        case 2: // Export CSV
-            showMessage(gfx, "Exporting...", WHITE, BLACK);
-            LeafActions::exportCSV();
+        case 2: // Export PLY
+            LeafActions::exportPointCloud();
             break;
     }
+    flightEvent(FR_EV_LEAF_EXIT, SUBMENU_1, index);
     
     // Ridisegna menu dopo azione
     delay(1000);
@@ -237,6 +262,7 @@ void handleSubmenu1Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
 
 // === GESTIONE SUBMENU 2 (CALIB. IMU) ===
 void handleSubmenu2Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
+    flightEvent(FR_EV_LEAF_ENTER, SUBMENU_2, index);
     switch (index) {
         case 0: // Gyro Calib
             setCurrentMenuState(CALIBRATING_IMU);
@@ -253,12 +279,14 @@ void handleSubmenu2Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
             LeafActions::calibrateMag();
             break;
     }
+    flightEvent(FR_EV_LEAF_EXIT, SUBMENU_2, index);
     
     // La calibrazione gestirà il proprio display
 }
 
 // === GESTIONE SUBMENU 3 (SERVICE) ===
 void handleSubmenu3Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
+    flightEvent(FR_EV_LEAF_ENTER, SUBMENU_3, index);
     switch (index) {
         case 0: // Settings
             showMessage(gfx, "Settings...", WHITE, BLACK);
@@ -278,6 +306,7 @@ void handleSubmenu3Selection(int index, Arduino_GFX* gfx, UIConfig& ui) {
             }
             break;
     }
+    flightEvent(FR_EV_LEAF_EXIT, SUBMENU_3, index);
     
     // Ridisegna menu dopo azione
     delay(1000);
@@ -369,7 +398,7 @@ bool confirmDialog(Arduino_GFX* gfx, const char* title, const char* message) {
                 return false;
             }
         }
-        delay(50);
+        waitForTouch(UI_IDLE_TIMEOUT_MS);
     }
 }
 
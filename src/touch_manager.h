@@ -8,12 +8,14 @@
 #include <Wire.h>
 #include <CSE_CST328.h>
 #include "config.h"
+#include "timebase.h"
 
 struct TouchPoint {
     int16_t x;
     int16_t y;
     bool touched;
     uint32_t timestamp;
+    timestamp_us_t timestamp_us;
 };
 
 class TouchManager {
@@ -38,6 +38,10 @@
 #define LCD_MOSI 45    // Data SPI
 #define LCD_BL   5     // Backlight
 
+// Pin per I2C sensori (XM125 + LSM6DSOX + LIS3MDL)
+#define SENSOR_SDA 11    // I2C Data (Wire)
+#define SENSOR_SCL 10    // I2C Clock (Wire)
+
 // Pin per touch CST328
 #define TP_SDA   1     // I2C Data (Wire1)
 #define TP_SCL   3     // I2C Clock (Wire1)
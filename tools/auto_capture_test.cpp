@@ -0,0 +1,132 @@
+// auto_capture_test.cpp
+// Test host della cattura automatica da fermo (src/auto_capture_detector.h):
+// varianza a finestra scorrevole contro il calcolo diretto, sequenza
+// movimento -> tap -> fermo, riarmo, deriva lenta e costo per campione.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/auto_capture_test.cpp -o auto_capture_test && ./auto_capture_test
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include "auto_capture_detector.h"
+#include "test_check.h"
+
+static const uint32_t PERIOD_US = 100000;     // 10Hz come il task sensori
+
+struct Sim {
+    std::mt19937 rng{3};
+    timestamp_us_t t = 1000000;
+    uint32_t captures = 0;
+    timestamp_us_t lastCaptureUs = 0;
+    SensorData lastPoint = {};
+
+    // Un campione: distanza vera + rumore radar, velocità angolare + rumore gyro
+    void step(AutoCaptureDetector &det, float distance, float rateDps, bool valid = true) {
+        std::normal_distribution<float> radar(0.0f, 1.0f);
+        std::normal_distribution<float> gyro(0.0f, 0.15f);
+        SensorData d = {};
+        d.timestamp_us = t;
+        d.distance_mm = distance + radar(rng);
+        d.pitch_deg = 12.0f;
+        d.yaw_deg = 30.0f;
+        d.radar_valid = valid;
+        d.imu_valid = true;
+        SensorData out;
+        if (det.add(d, fabsf(rateDps + gyro(rng)), out)) {
+            captures++;
+            lastCaptureUs = t;
+            lastPoint = out;
+        }
+        t += PERIOD_US;
+    }
+};
+
+int main() {
+    // Finestra scorrevole contro varianza calcolata da zero sugli ultimi N
+    {
+        const int N = 16;
+        SlidingStats<N> s;
+        s.reset();
+        std::mt19937 rng(1);
+        std::normal_distribution<float> noise(0.0f, 2.0f);
+        float hist[100000];
+        double worst = 0;
+        for (int i = 0; i < 100000; i++) {
+            hist[i] = 1500.0f + (i / 5000) * 37.0f + noise(rng);  // Offset grande e gradini
+            s.add(hist[i]);
+            if (i >= N && i % 997 == 0) {
+                double m = 0, v = 0;
+                for (int k = i - N + 1; k <= i; k++) m += hist[k];
+                m /= N;
+                for (int k = i - N + 1; k <= i; k++) v += (hist[k] - m) * (hist[k] - m);
+                v /= N - 1;
+                double e = fabs(s.variance() - v) / v;
+                if (e > worst) worst = e;
+            }
+        }
+        printf("    errore relativo max varianza: %.2e\n", worst);
+        check(worst < 1e-6, "varianza scorrevole = calcolo diretto");
+    }
+
+    // Movimento, tap (picco di velocità), poi fermo: una cattura sola
+    {
+        AutoCaptureDetector det;
+        Sim sim;
+        for (int i = 0; i < 30; i++) sim.step(det, 800.0f + i * 15.0f, 25.0f);     // Puntamento
+        for (int i = 0; i < 20; i++) sim.step(det, 1250.0f, 0.5f);                // Fermo
+        sim.step(det, 1250.0f, 40.0f);                                            // Tap
+        timestamp_us_t stillStart = sim.t;
+        for (int i = 0; i < 30; i++) sim.step(det, 1250.0f, 0.5f);
+        uint32_t afterTapMs = (uint32_t)((sim.lastCaptureUs - stillStart) / 1000);
+        printf("    catture %u, ultima %u ms dopo il tap, distanza %.2f mm, XYZ %.1f %.1f %.1f\n",
+               sim.captures, afterTapMs, sim.lastPoint.distance_mm,
+               sim.lastPoint.x_mm, sim.lastPoint.y_mm, sim.lastPoint.z_mm);
+        check(sim.captures == 2, "una cattura prima del tap e una dopo");
+        check(sim.lastCaptureUs > stillStart &&
+              afterTapMs <= AUTO_CAPTURE_DEFAULT_HOLD_MS + 100, "il tap non entra nel punto");
+        check(fabsf(sim.lastPoint.distance_mm - 1250.0f) < 1.5f && sim.lastPoint.y_mm > 0,
+              "punto mediato con coordinate");
+    }
+
+    // Fermo a lungo: nessuna cattura ripetuta; dopo un movimento si riarma
+    {
+        AutoCaptureDetector det;
+        Sim sim;
+        for (int i = 0; i < 100; i++) sim.step(det, 600.0f, 0.3f);
+        check(sim.captures == 1 && det.state() == AUTO_CAPTURE_CAPTURED, "fermo 10 s: un solo punto");
+        for (int i = 0; i < 5; i++) sim.step(det, 600.0f + i * 40.0f, 30.0f);
+        for (int i = 0; i < 30; i++) sim.step(det, 800.0f, 0.3f);
+        check(sim.captures == 2, "movimento e nuovo fermo: riarmo");
+    }
+
+    // Scorrimento lento (gyro fermo, distanza che cambia) e radar non valido
+    {
+        AutoCaptureDetector det;
+        Sim sim;
+        for (int i = 0; i < 60; i++) sim.step(det, 500.0f + i * 4.0f, 0.3f);
+        check(sim.captures == 0, "distanza in deriva: nessuna cattura");
+
+        det.reset();
+        for (int i = 0; i < 60; i++) sim.step(det, 700.0f, 0.3f, i % 6 != 5);
+        check(sim.captures == 0, "radar intermittente: nessuna cattura");
+    }
+
+    // Costo per campione (riportato: deve restare trascurabile rispetto al ciclo da 100ms)
+    {
+        AutoCaptureDetector det;
+        SensorData d = {};
+        d.radar_valid = true;
+        d.imu_valid = true;
+        SensorData out;
+        uint32_t n = 2000000, hits = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < n; i++) {
+            d.timestamp_us = (timestamp_us_t)i * PERIOD_US;
+            d.distance_mm = 1000.0f + (i % 97 == 0 ? 50.0f : (float)(i & 1));
+            hits += det.add(d, (i % 211 == 0) ? 20.0f : 0.2f, out);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        printf("    %.1f ns/campione (host), %u catture\n", ns, hits);
+    }
+
+    return testSummary();
+}
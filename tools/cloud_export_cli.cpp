@@ -0,0 +1,322 @@
+// cloud_export_cli.cpp
+// Conversione host dei log grezzi (trace della telemetria, formato in
+// src/telemetry_protocol.h) in PLY binario o XYZ, con lo stesso writer del
+// device (src/point_export.h) e la trasformazione a lotti di
+// src/coord_transform.h. Lettura e scrittura a blocchi da 1MB: il limite è
+// il disco, non la conversione.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/cloud_export_cli.cpp -o cloud_export_cli
+//
+//   cloud_export_cli <in.trace> <out.ply|out.xyz> [valid] [mount x y z pitch yaw]
+//   cloud_export_cli selftest
+//
+// valid: solo campioni con radar e IMU validi (altrimenti restano con
+// valid=0 e coordinate nulle). mount: offset del radar in mm e
+// disallineamento in gradi, come `set mount.offset` / `set mount.angles`.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "telemetry_protocol.h"
+#include "sensor_record.h"
+#include "coord_transform.h"
+#include "point_export.h"
+#include "test_check.h"
+
+#define IO_BLOCK      (1u << 20)
+#define RECORD_BATCH  4096
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// === DESTINAZIONE FILE ===
+class FileSink : public ExportSink {
+public:
+    explicit FileSink(FILE *f) : file(f) {}
+    bool write(const uint8_t *data, size_t len) override {
+        return fwrite(data, 1, len, file) == len;
+    }
+    bool rewrite(uint32_t offset, const uint8_t *data, size_t len) override {
+        return fseek(file, offset, SEEK_SET) == 0 && fwrite(data, 1, len, file) == len;
+    }
+
+private:
+    FILE *file;
+};
+
+// === LETTURA TRACE A BLOCCHI ===
+class TraceReader {
+public:
+    explicit TraceReader(FILE *f) : file(f), buf(IO_BLOCK), pos(0), len(0) {}
+
+    bool header() {
+        TelemTraceHeader th;
+        return take(&th, sizeof(th)) && memcmp(th.magic, TELEM_TRACE_MAGIC, sizeof(th.magic)) == 0;
+    }
+
+    // Prossimo frame campione; false a fine file (o trace troncato)
+    bool nextSample(SensorRecord &r) {
+        TelemTraceRecord tr;
+        while (take(&tr, sizeof(tr))) {
+            if (!fill(tr.len)) return false;
+            const uint8_t *frame = &buf[pos];
+            pos += tr.len;
+            TelemFrameHeader hdr;
+            if (tr.len != sizeof(hdr) + sizeof(r)) continue;
+            memcpy(&hdr, frame, sizeof(hdr));
+            if (hdr.type != TELEM_FRAME_SAMPLE) continue;
+            memcpy(&r, frame + sizeof(hdr), sizeof(r));
+            return true;
+        }
+        return false;
+    }
+
+private:
+    bool fill(size_t n) {
+        if (len - pos >= n) return true;
+        memmove(&buf[0], &buf[pos], len - pos);
+        len -= pos;
+        pos = 0;
+        len += fread(&buf[len], 1, buf.size() - len, file);
+        return len >= n;
+    }
+    bool take(void *out, size_t n) {
+        if (!fill(n)) return false;
+        memcpy(out, &buf[pos], n);
+        pos += n;
+        return true;
+    }
+
+    FILE *file;
+    std::vector<uint8_t> buf;
+    size_t pos, len;
+};
+
+// === CONVERSIONE ===
+struct ConvertStats {
+    uint64_t samples;
+    uint32_t points;
+    uint64_t bytes;
+    double seconds;
+};
+
+static bool convert(const char *in, const char *out, bool validOnly, const CoordMount &mount, ConvertStats &st) {
+    memset(&st, 0, sizeof(st));
+    const char *ext = strrchr(out, '.');
+    PointExportFormat format = (ext && strcmp(ext, ".xyz") == 0) ? POINT_EXPORT_XYZ : POINT_EXPORT_PLY;
+
+    FILE *fi = fopen(in, "rb");
+    if (!fi) {
+        perror(in);
+        return false;
+    }
+    TraceReader reader(fi);
+    if (!reader.header()) {
+        fprintf(stderr, "%s: non è un trace telemetria\n", in);
+        fclose(fi);
+        return false;
+    }
+    FILE *fo = fopen(out, "wb");
+    if (!fo) {
+        perror(out);
+        fclose(fi);
+        return false;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    FileSink sink(fo);
+    std::vector<uint8_t> chunk(IO_BLOCK);
+    PointExportWriter writer;
+    writer.begin(sink, chunk.data(), chunk.size(), format);
+
+    std::vector<SensorRecord> batch(RECORD_BATCH);
+    std::vector<float> x(RECORD_BATCH), y(RECORD_BATCH), z(RECORD_BATCH);
+    bool more = true;
+    while (more && !writer.failed()) {
+        uint32_t n = 0;
+        while (n < RECORD_BATCH && (more = reader.nextSample(batch[n]))) {
+            st.samples++;
+            if (!validOnly || (batch[n].radarValid() && batch[n].imuValid())) n++;
+        }
+        coordTransformRecords(batch.data(), n, mount, x.data(), y.data(), z.data());
+        for (uint32_t i = 0; i < n; i++) {
+            const SensorRecord &r = batch[i];
+            ExportPoint p;
+            p.valid = r.radarValid() && r.imuValid();
+            p.x_mm = p.valid ? x[i] : 0;
+            p.y_mm = p.valid ? y[i] : 0;
+            p.z_mm = p.valid ? z[i] : 0;
+            p.time_s = r.timestamp_us / 1e6;
+            p.strength = 1;
+            p.flags = r.flags;
+            writer.add(p);
+        }
+    }
+    bool ok = writer.finish();
+    ok = fclose(fo) == 0 && ok;
+    fclose(fi);
+
+    st.points = writer.count();
+    st.bytes = writer.bytes();
+    st.seconds = seconds(t0);
+    if (!ok) fprintf(stderr, "%s: errore di scrittura\n", out);
+    return ok;
+}
+
+// === SELFTEST ===
+// Trace sintetico: sweep a 10Hz con un campione non valido ogni 10, più
+// frame di statistiche intercalati come in una registrazione vera
+static uint32_t writeSyntheticTrace(const char *path, uint32_t n, std::vector<SensorRecord> &valid) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    TelemTraceHeader th;
+    memcpy(th.magic, TELEM_TRACE_MAGIC, sizeof(th.magic));
+    th.version = TELEM_TRACE_VERSION;
+    th.protocol = TELEM_PROTOCOL_VERSION;
+    fwrite(&th, sizeof(th), 1, f);
+
+    uint8_t frame[TELEM_MAX_FRAME];
+    for (uint32_t i = 0; i < n; i++) {
+        SensorData d = {};
+        d.timestamp_us = 1000000ull + i * 100000ull;
+        d.distance_mm = 800.0f + (i % 500) * 3.0f;
+        d.filtered_distance_mm = d.distance_mm;
+        d.pitch_deg = -30.0f + (i % 61);
+        d.yaw_deg = (i * 0.37f);
+        while (d.yaw_deg >= 360.0f) d.yaw_deg -= 360.0f;
+        d.roll_deg = (i % 21) - 10.0f;
+        d.radar_valid = i % 10 != 9;
+        d.imu_valid = true;
+        SensorRecord r;
+        packSensorRecord(d, r);
+        if (d.radar_valid) valid.push_back(r);
+
+        TelemFrameHeader hdr = {TELEM_FRAME_SAMPLE, TELEM_PROTOCOL_VERSION, (uint16_t)i};
+        memcpy(frame, &hdr, sizeof(hdr));
+        memcpy(frame + sizeof(hdr), &r, sizeof(r));
+        TelemTraceRecord tr = {d.timestamp_us, (uint16_t)(sizeof(hdr) + sizeof(r)), 0, 0};
+        fwrite(&tr, sizeof(tr), 1, f);
+        fwrite(frame, tr.len, 1, f);
+
+        if (i % 10 == 0) {
+            TelemTaskStats t = {};
+            hdr.type = TELEM_FRAME_TASK_STATS;
+            memcpy(frame, &hdr, sizeof(hdr));
+            memcpy(frame + sizeof(hdr), &t, sizeof(t));
+            tr.len = sizeof(hdr) + sizeof(t);
+            fwrite(&tr, sizeof(tr), 1, f);
+            fwrite(frame, tr.len, 1, f);
+        }
+    }
+    fclose(f);
+    return n;
+}
+
+static std::vector<uint8_t> readFile(const char *path) {
+    std::vector<uint8_t> data;
+    FILE *f = fopen(path, "rb");
+    if (!f) return data;
+    fseek(f, 0, SEEK_END);
+    data.resize(ftell(f));
+    fseek(f, 0, SEEK_SET);
+    if (fread(data.data(), 1, data.size(), f) != data.size()) data.clear();
+    fclose(f);
+    return data;
+}
+
+static int cmdSelftest() {
+    const uint32_t N = 2000000;
+    const char *trace = "/tmp/cloud_export_selftest.trace";
+    const char *ply = "/tmp/cloud_export_selftest.ply";
+    const char *xyz = "/tmp/cloud_export_selftest.xyz";
+    std::vector<SensorRecord> valid;
+    check(writeSyntheticTrace(trace, N, valid) == N, "trace sintetico");
+
+    CoordMount mount = {{10.0f, -25.0f, 40.0f}, 0.5f, -1.0f};
+    ConvertStats st;
+    bool ok = convert(trace, ply, true, mount, st);
+    printf("    %llu campioni -> %u punti, %.1f MB in %.0f ms (%.0f MB/s, %.1f M punti/s)\n",
+           (unsigned long long)st.samples, st.points, st.bytes / 1e6, st.seconds * 1e3,
+           st.bytes / 1e6 / st.seconds, st.points / 1e6 / st.seconds);
+    check(ok && st.samples == N && st.points == valid.size(), "solo campioni validi");
+
+    // Rilettura: header col conteggio corretto, dimensione, punti a campione
+    std::vector<uint8_t> data = readFile(ply);
+    const char *end = data.empty() ? nullptr : strstr((const char *)data.data(), "end_header\n");
+    size_t headerLen = end ? end + 11 - (const char *)data.data() : 0;
+    unsigned long count = 0;
+    const char *ev = end ? strstr((const char *)data.data(), "element vertex ") : nullptr;
+    if (ev) count = strtoul(ev + 15, nullptr, 10);
+    check(count == valid.size() && data.size() == headerLen + count * POINT_EXPORT_PLY_BYTES,
+          "header PLY riscritto col conteggio finale");
+
+    double worst = 0;
+    bool fieldsOk = headerLen > 0;
+    for (size_t i = 0; fieldsOk && i < valid.size(); i += 9973) {
+        const uint8_t *p = &data[headerLen + i * POINT_EXPORT_PLY_BYTES];
+        float v[3], strength;
+        double t;
+        memcpy(v, p, 12);
+        memcpy(&t, p + 12, 8);
+        memcpy(&strength, p + 20, 4);
+        float ex, ey, ez;
+        const SensorRecord &r = valid[i];
+        coordTransformPoint(r.distanceMm(), r.pitchDeg(), r.yawDeg(), r.rollDeg(), mount, ex, ey, ez);
+        worst = fmax(worst, fmax(fabs(v[0] - ex), fmax(fabs(v[1] - ey), fabs(v[2] - ez))));
+        fieldsOk = fabs(t - r.timestamp_us / 1e6) < 1e-9 && strength == 1 && p[24] == 1 && p[25] == r.flags;
+    }
+    check(fieldsOk && worst < 1e-3, "punti, tempo e proprietà per punto");
+
+    // XYZ con anche i non validi
+    ok = convert(trace, xyz, false, mount, st);
+    data = readFile(xyz);
+    uint32_t lines = 0;
+    for (uint8_t c : data) lines += c == '\n';
+    printf("    XYZ: %u righe, %.1f MB in %.0f ms\n", lines, st.bytes / 1e6, st.seconds * 1e3);
+    float fx, fy, fz;
+    double ft;
+    unsigned fv = 9;
+    bool parsed = !data.empty() && sscanf((const char *)data.data(), "%f %f %f %lf %*f %u", &fx, &fy, &fz, &ft, &fv) == 5;
+    check(ok && lines == N && st.points == N && parsed && fabs(ft - 1.0) < 1e-6 && fv == 1,
+          "XYZ con campioni non validi marcati");
+
+    remove(trace);
+    remove(ply);
+    remove(xyz);
+    return testSummary();
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "selftest") == 0) {
+        return cmdSelftest();
+    }
+    if (argc >= 3) {
+        bool validOnly = false;
+        CoordMount mount;
+        coordMountDefaults(mount);
+        int i = 3;
+        if (i < argc && strcmp(argv[i], "valid") == 0) {
+            validOnly = true;
+            i++;
+        }
+        if (i + 6 == argc && strcmp(argv[i], "mount") == 0) {
+            for (int k = 0; k < 3; k++) mount.offset_mm[k] = atof(argv[i + 1 + k]);
+            mount.pitch_offset_deg = atof(argv[i + 4]);
+            mount.yaw_offset_deg = atof(argv[i + 5]);
+            i += 6;
+        }
+        if (i == argc) {
+            ConvertStats st;
+            if (!convert(argv[1], argv[2], validOnly, mount, st)) return 1;
+            fprintf(stderr, "%llu campioni -> %u punti, %.1f MB in %.0f ms\n",
+                    (unsigned long long)st.samples, st.points, st.bytes / 1e6, st.seconds * 1e3);
+            return 0;
+        }
+    }
+    fprintf(stderr,
+            "uso: %s <in.trace> <out.ply|out.xyz> [valid] [mount x y z pitch yaw]\n"
+            "     %s selftest\n", argv[0], argv[0]);
+    return 2;
+}
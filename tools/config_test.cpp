@@ -0,0 +1,118 @@
+// config_test.cpp
+// Test host dello store di configurazione (src/config_schema.h) sul backend
+// in RAM: round-trip, scritture saltate, guasti, corruzione e migrazione.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/config_test.cpp -o config_test && ./config_test
+#include <stdio.h>
+#include "config_schema.h"
+#include "test_check.h"
+
+int main() {
+    // Supporto vuoto: default, niente scritture finché non cambia qualcosa
+    {
+        ConfigMemoryBackend mem;
+        ConfigStoreCore store(mem);
+        check(store.load() == CONFIG_LOAD_EMPTY, "vuoto -> default");
+        check(store.get().radar_profile == 2 && store.get().mag_scale[1] == 1.0f, "valori default");
+        check(store.save() && mem.writes == 0, "nessuna scrittura senza modifiche");
+    }
+
+    // Round-trip e scritture identiche saltate (usura)
+    {
+        ConfigMemoryBackend mem;
+        ConfigStoreCore store(mem);
+        store.load();
+        DeviceConfig c = store.get();
+        c.mag_offset[0] = 12.5f;
+        c.range_end_mm = 2200;
+        store.set(c);
+        check(store.save() && mem.writes == 1, "salvataggio");
+
+        store.set(c);
+        check(store.save() && mem.writes == 1 && store.getSkipped() == 1, "contenuto invariato: saltato");
+
+        ConfigStoreCore reload(mem);
+        check(reload.load() == CONFIG_LOAD_OK && reload.get().mag_offset[0] == 12.5f &&
+              reload.get().range_end_mm == 2200 && reload.getSequence() == 1, "ricarica");
+        check(reload.save() && mem.writes == 1, "ricarica non riscrive");
+    }
+
+    // Scrittura fallita: il record precedente resta, la modifica resta in RAM
+    {
+        ConfigMemoryBackend mem;
+        ConfigStoreCore store(mem);
+        store.load();
+        DeviceConfig c = store.get();
+        c.smoothing = 0.5f;
+        store.set(c);
+        store.save();
+
+        c.smoothing = 0.9f;
+        store.set(c);
+        mem.failNextWrite = true;
+        check(!store.save() && store.isDirty() && store.getFailures() == 1, "scrittura fallita resta dirty");
+
+        ConfigStoreCore before(mem);
+        before.load();
+        check(before.get().smoothing == 0.5f, "record precedente intatto");
+        check(store.save() && mem.writes == 2, "nuovo tentativo riuscito");
+    }
+
+    // Corruzione: CRC errato -> default, niente crash
+    {
+        ConfigMemoryBackend mem;
+        ConfigStoreCore store(mem);
+        store.load();
+        DeviceConfig c = store.get();
+        c.kalman_process = 33;
+        store.set(c);
+        store.save();
+        mem.data[sizeof(ConfigRecordHeader) + 3] ^= 0x40;
+
+        ConfigStoreCore reload(mem);
+        check(reload.load() == CONFIG_LOAD_CORRUPT && reload.get().kalman_process == 20, "CRC errato -> default");
+
+        mem.len = 5;
+        check(reload.load() == CONFIG_LOAD_CORRUPT, "record troncato");
+    }
+
+    // Migrazione: record di uno schema precedente più corto (solo calibrazione)
+    {
+        ConfigMemoryBackend mem;
+        DeviceConfig old;
+        configDefaults(old);
+        old.mag_offset[2] = -7.0f;
+        old.mag_calibrated = 1;
+        old.mag_scale[0] = 50.0f;
+        old.smoothing = 0.77f;  // Fuori dal prefisso: deve tornare al default
+
+        const uint16_t oldLength = 28;  // mag_offset, mag_scale, mag_calibrated + 3
+        ConfigRecordHeader h = {CONFIG_RECORD_MAGIC, 1, oldLength, 4, configCrc32(&old, oldLength)};
+        memcpy(mem.data, &h, sizeof(h));
+        memcpy(mem.data + sizeof(h), &old, oldLength);
+        mem.len = sizeof(h) + oldLength;
+
+        ConfigStoreCore store(mem);
+        check(store.load() == CONFIG_LOAD_MIGRATED, "schema precedente riconosciuto");
+        check(store.get().mag_offset[2] == -7.0f && store.get().mag_calibrated == 1 &&
+              store.get().smoothing == 0.2f, "prefisso conservato, campi nuovi default");
+        check(store.get().mag_soft_iron[0] == 0.02f && store.get().mag_soft_iron[4] == 1.0f &&
+              store.get().mag_soft_iron[1] == 0.0f, "v1: scala min/max -> matrice diagonale");
+        check(store.isDirty() && store.save() && mem.len == sizeof(h) + sizeof(DeviceConfig) &&
+              store.getSequence() == 5, "migrazione risalvata");
+    }
+
+    // Factory reset
+    {
+        ConfigMemoryBackend mem;
+        ConfigStoreCore store(mem);
+        store.load();
+        DeviceConfig c = store.get();
+        c.radar_profile = 4;
+        store.set(c);
+        store.save();
+        check(store.reset() && mem.len == 0 && store.get().radar_profile == 2, "factory reset");
+    }
+
+    return testSummary();
+}
@@ -0,0 +1,124 @@
+// coord_transform_bench.cpp
+// Benchmark della trasformazione a lotti (src/coord_transform.h) contro
+// calculateCoordinates() campione per campione, con verifica di
+// precisione contro un riferimento double e della geometria di roll e
+// offset di montaggio.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/coord_transform_bench.cpp -o coord_transform_bench && ./coord_transform_bench
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "coord_transform.h"
+#include "test_check.h"
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Riferimento: matrici di rotazione esplicite in double
+static void reference(double d, double p, double yw, double r, const CoordMount &m, double out[3]) {
+    const double k = M_PI / 180.0;
+    p = (p + m.pitch_offset_deg) * k;
+    yw = (yw + m.yaw_offset_deg) * k;
+    r *= k;
+    double b[3] = {m.offset_mm[0], m.offset_mm[1] + d, m.offset_mm[2]};
+    double rr[3] = {b[0] * cos(r) + b[2] * sin(r), b[1], -b[0] * sin(r) + b[2] * cos(r)};
+    double pp[3] = {rr[0], rr[1] * cos(p) - rr[2] * sin(p), rr[1] * sin(p) + rr[2] * cos(p)};
+    out[0] = pp[0] * cos(yw) + pp[1] * sin(yw);
+    out[1] = -pp[0] * sin(yw) + pp[1] * cos(yw);
+    out[2] = pp[2];
+}
+
+int main() {
+    // Seno/coseno veloci su tutto il giro e oltre
+    {
+        double worst = 0;
+        for (float deg = -1000.0f; deg <= 1000.0f; deg += 0.0137f) {
+            float s, c;
+            fastSinCosDeg(deg, s, c);
+            double e = fmax(fabs(s - sin(deg * M_PI / 180.0)), fabs(c - cos(deg * M_PI / 180.0)));
+            if (e > worst) worst = e;
+        }
+        printf("    fastSinCosDeg: errore max %.2e\n", worst);
+        check(worst < 1e-6, "seno/coseno veloci");
+    }
+
+    const uint32_t N = 4000000;
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> ud(200.0f, 10000.0f), up(-89.0f, 89.0f), uy(0.0f, 360.0f),
+        ur(-30.0f, 30.0f);
+    std::vector<float> dist(N), pitch(N), yaw(N), roll(N), x(N), y(N), z(N);
+    for (uint32_t i = 0; i < N; i++) {
+        dist[i] = ud(rng);
+        pitch[i] = up(rng);
+        yaw[i] = uy(rng);
+        roll[i] = ur(rng);
+    }
+
+    // Stessa formula di calculateCoordinates() (montaggio nullo, senza roll)
+    CoordMount zero;
+    coordMountDefaults(zero);
+    double scalarS, batchS, rollS;
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < N; i++) {
+            SensorData d = {};
+            d.distance_mm = dist[i];
+            d.pitch_deg = pitch[i];
+            d.yaw_deg = yaw[i];
+            calculateCoordinates(d);
+            x[i] = d.x_mm;
+            y[i] = d.y_mm;
+            z[i] = d.z_mm;
+        }
+        scalarS = seconds(t0);
+    }
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        coordTransformBatch(dist.data(), pitch.data(), yaw.data(), nullptr, N, zero, x.data(), y.data(), z.data());
+        batchS = seconds(t0);
+        double worst = 0;
+        for (uint32_t i = 0; i < N; i += 97) {
+            double ref[3];
+            reference(dist[i], pitch[i], yaw[i], 0, zero, ref);
+            double e = fmax(fabs(x[i] - ref[0]), fmax(fabs(y[i] - ref[1]), fabs(z[i] - ref[2])));
+            if (e > worst) worst = e;
+        }
+        printf("    errore max a 10m (float): %.4f mm\n", worst);
+        check(worst < 0.01, "precisione sotto 0.01mm fino a 10m");
+    }
+
+    // Roll e montaggio fuori asse
+    CoordMount mount = {{15.0f, -20.0f, 45.0f}, 0.8f, -1.5f};
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        coordTransformBatch(dist.data(), pitch.data(), yaw.data(), roll.data(), N, mount,
+                            x.data(), y.data(), z.data());
+        rollS = seconds(t0);
+        double worst = 0;
+        for (uint32_t i = 0; i < N; i += 97) {
+            double ref[3];
+            reference(dist[i], pitch[i], yaw[i], roll[i], mount, ref);
+            double e = fmax(fabs(x[i] - ref[0]), fmax(fabs(y[i] - ref[1]), fabs(z[i] - ref[2])));
+            if (e > worst) worst = e;
+        }
+        printf("    con roll e offset: errore max %.4f mm\n", worst);
+        check(worst < 0.01, "roll e offset di montaggio");
+
+        // Radar 45mm sopra l'asse: con roll 90° l'offset finisce di lato
+        float px, py, pz;
+        CoordMount up = {{0, 0, 45.0f}, 0, 0};
+        coordTransformPoint(1000.0f, 0, 0, 90.0f, up, px, py, pz);
+        check(fabsf(px - 45.0f) < 1e-3f && fabsf(py - 1000.0f) < 1e-3f && fabsf(pz) < 1e-3f,
+              "roll 90° con offset verticale");
+    }
+
+    printf("    %u campioni: scalare %.1f ms (%.1f M/s), lotto %.1f ms (%.1f M/s, x%.1f), "
+           "lotto+roll %.1f ms (%.1f M/s)\n",
+           N, scalarS * 1e3, N / scalarS / 1e6, batchS * 1e3, N / batchS / 1e6, scalarS / batchS,
+           rollS * 1e3, N / rollS / 1e6);
+    check(batchS < scalarS, "lotto più veloce dello scalare");
+
+    return testSummary();
+}
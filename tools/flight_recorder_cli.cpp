@@ -0,0 +1,273 @@
+// flight_recorder_cli.cpp
+// Decoder host del registratore di volo (src/flight_recorder.h): legge un
+// log seriale con le righe "FR ..." di "trace dump" (o la struttura binaria
+// grezza) e stampa la timeline divisa per avvio, il riassunto per tipo di
+// evento e l'ultimo giro di ogni task.
+//
+//   g++ -std=c++17 -O2 -pthread -Isrc tools/flight_recorder_cli.cpp -o flight_recorder_cli
+//
+//   flight_recorder_cli decode <log seriale | file binario> [ultimi N]
+//   flight_recorder_cli selftest
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "flight_recorder.h"
+#include "test_check.h"
+
+// === LETTURA ===
+// Binario grezzo se la dimensione coincide, altrimenti righe FR in un log
+static bool loadTrace(const char *path, FlightTrace &t) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    memset(&t, 0, sizeof(t));
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    bool ok;
+    if (size == (long)sizeof(FlightTrace)) {
+        ok = fread(&t, sizeof(t), 1, f) == 1;
+    } else {
+        char line[256];
+        uint32_t lines = 0;
+        while (fgets(line, sizeof(line), f)) {
+            if (strstr(line, "FR end")) break;
+            if (flightParseLine(t, line)) lines++;
+        }
+        ok = lines > 0;
+        if (!ok) fprintf(stderr, "%s: nessuna riga FR (\"trace dump\" dalla console)\n", path);
+    }
+    fclose(f);
+
+    if (ok && !flightTraceValid(t)) {
+        fprintf(stderr, "%s: traccia non valida (magic %08x, versione %u, %u eventi)\n",
+                path, t.magic, t.version, t.capacity);
+        ok = false;
+    }
+    return ok;
+}
+
+// === TIMELINE ===
+// Un task fermo mentre gli altri girano = bloccato (leaf, mutex, I2C)
+static void printBeats(const char *title, const uint32_t *beats) {
+    uint32_t newest = 0;
+    for (uint8_t i = 1; i < FR_TASK_COUNT; i++) {
+        if (beats[i] > newest) newest = beats[i];
+    }
+    if (!newest) return;
+    printf("%s\n", title);
+    for (uint8_t i = 1; i < FR_TASK_COUNT; i++) {
+        if (!beats[i]) continue;
+        printf("  %-10s %10.3f s  (%.3f s prima dell'ultimo)\n", flightTaskName(i),
+               beats[i] / 1e6, (newest - beats[i]) / 1e6);
+    }
+}
+
+static void printTimeline(const FlightTrace &t, uint32_t last) {
+    uint32_t from = last && t.head > last ? t.head - last : 0;
+    uint32_t counts[FR_EV_COUNT] = {0};
+    FlightClock clock;
+    char line[128];
+
+    printf("Traccia: %u eventi scritti, %u avvii, ultimi %u nel ring\n",
+           t.head, t.boots, t.head < FR_EVENTS ? t.head : FR_EVENTS);
+
+    uint32_t skipped = flightTraceForEach(t, [&](uint32_t i, const FlightEvent &e) {
+        uint64_t us = clock.advance(e);
+        counts[e.type]++;
+        if (i < from) return;
+        if (e.type == FR_EV_BOOT) printf("---- avvio ----\n");
+        flightEventFormat(line, sizeof(line), us, e);
+        printf("%s\n", line);
+    });
+
+    printf("\nRiassunto:");
+    for (uint8_t i = 1; i < FR_EV_COUNT; i++) {
+        if (counts[i]) printf(" %s=%u", flightEventName(i), counts[i]);
+    }
+    if (skipped) printf(" (scartati %u slot incompleti)", skipped);
+    printf("\n");
+
+    printBeats("Ultimo giro per task, avvio precedente:", t.prev_beat_us);
+    printBeats("Ultimo giro per task, avvio corrente:", t.beat_us);
+}
+
+static int cmdDecode(const char *path, uint32_t last) {
+    FlightTrace *t = new FlightTrace;
+    bool ok = loadTrace(path, *t);
+    if (ok) printTimeline(*t, last);
+    delete t;
+    return ok ? 0 : 1;
+}
+
+// === SELFTEST ===
+static std::vector<FlightEvent> collect(const FlightTrace &t, uint32_t *skipped = NULL) {
+    std::vector<FlightEvent> out;
+    uint32_t s = flightTraceForEach(t, [&](uint32_t, const FlightEvent &e) { out.push_back(e); });
+    if (skipped) *skipped = s;
+    return out;
+}
+
+static int cmdSelftest() {
+    static FlightTrace t;
+
+    // Ring non ancora pieno: tutti gli eventi, in ordine
+    {
+        flightTraceReset(t);
+        for (uint32_t i = 0; i < 10; i++) {
+            flightTraceRecord(t, 1000 + i, FR_EV_MARK, flightTaskTag(FR_TASK_SENSOR, 1), i, i * 10);
+        }
+        std::vector<FlightEvent> ev = collect(t);
+        bool ordered = ev.size() == 10;
+        for (size_t i = 0; ordered && i < ev.size(); i++) {
+            ordered = ev[i].object == i && ev[i].arg == i * 10 && (ev[i].task & FR_TASK_CORE_BIT);
+        }
+        check(ordered, "ring parziale: 10 eventi in ordine con core e task");
+    }
+
+    // Dopo molti giri restano gli ultimi FR_EVENTS
+    {
+        flightTraceReset(t);
+        const uint32_t n = FR_EVENTS * 5 + 17;
+        for (uint32_t i = 0; i < n; i++) flightTraceRecord(t, i, FR_EV_MARK, 0, 0, i);
+        std::vector<FlightEvent> ev = collect(t);
+        check(ev.size() == FR_EVENTS && ev.front().arg == n - FR_EVENTS && ev.back().arg == n - 1,
+              "ring pieno: restano gli ultimi FR_EVENTS");
+    }
+
+    // Reset a metà scrittura: head avanzato, seq non ancora scritto
+    {
+        flightTraceReset(t);
+        for (uint32_t i = 0; i < FR_EVENTS + 3; i++) flightTraceRecord(t, i, FR_EV_MARK, 0, 0, i);
+        uint32_t idx = t.head++;
+        FlightEvent &e = t.events[idx & (FR_EVENTS - 1)];
+        e.time_us = 999999;
+        e.type = FR_EV_I2C_ERROR;
+        uint32_t skipped = 0;
+        std::vector<FlightEvent> ev = collect(t, &skipped);
+        bool noTorn = true;
+        for (const FlightEvent &x : ev) noTorn &= x.time_us != 999999;
+        check(skipped == 1 && noTorn && ev.size() == FR_EVENTS - 1, "slot interrotto da un reset scartato");
+    }
+
+    // Scrittori concorrenti: nessun evento perso né mescolato
+    {
+        flightTraceReset(t);
+        const uint32_t threads = 4, perThread = 200000;
+        std::vector<std::thread> pool;
+        for (uint32_t k = 0; k < threads; k++) {
+            pool.emplace_back([k]() {
+                for (uint32_t i = 0; i < perThread; i++) {
+                    flightTraceRecord(t, i, FR_EV_MARK, (uint8_t)k, (uint16_t)k, i ^ (k << 24));
+                }
+            });
+        }
+        for (std::thread &th : pool) th.join();
+        uint32_t skipped = 0;
+        std::vector<FlightEvent> ev = collect(t, &skipped);
+        // Solo uno scrittore fermato per un giro intero del ring può lasciare
+        // uno slot misto: al più uno per thread
+        uint32_t mixed = 0;
+        for (const FlightEvent &x : ev) {
+            if (x.task != x.object || (x.arg >> 24) != x.object || (x.arg & 0xFFFFFF) != x.time_us) mixed++;
+        }
+        check(t.head == threads * perThread, "fetch-add: nessun indice perso fra 4 thread");
+        check(mixed <= threads && ev.size() + skipped == FR_EVENTS, "eventi concorrenti integri");
+    }
+
+    // Orologio: wrap dei 32 bit e ripartenza a ogni BOOT
+    {
+        flightTraceReset(t);
+        flightTraceRecord(t, 0xFFFFFE00u, FR_EV_BOOT, 0, 1, 1);
+        flightTraceRecord(t, 0xFFFFFF00u, FR_EV_MARK, 0, 0, 0);
+        flightTraceRecord(t, 0x00000100u, FR_EV_MARK, 0, 0, 0);  // dopo il wrap
+        flightTraceRecord(t, 0x000000F0u, FR_EV_MARK, 0, 0, 0);  // altro core, poco prima
+        flightTraceRecord(t, 20, FR_EV_BOOT, 0, 2, 4);
+        std::vector<uint64_t> times;
+        FlightClock clock;
+        flightTraceForEach(t, [&](uint32_t, const FlightEvent &e) { times.push_back(clock.advance(e)); });
+        check(times.size() == 5 && times[0] == 0xFFFFFE00ull && times[1] == 0xFFFFFF00ull && times[2] == 0x100000100ull &&
+              times[3] == 0x1000000F0ull && times[4] == 20, "tempo srotolato oltre il wrap, zero a ogni avvio");
+    }
+
+    // Dump testuale -> parse: struttura identica, anche in mezzo ad altro log
+    {
+        flightTraceReset(t);
+        t.boots = 7;
+        t.beat_us[FR_TASK_LOOP] = 123456;
+        for (uint32_t i = 0; i < FR_EVENTS + 40; i++) {
+            flightTraceRecord(t, i * 37, (uint8_t)(1 + i % (FR_EV_COUNT - 1)), (uint8_t)(i % FR_TASK_COUNT),
+                              (uint16_t)i, i * 3);
+        }
+        std::string text = "Navigate: MAIN -> SUB1\n";
+        char line[16 + FR_DUMP_LINE_BYTES * 2];
+        for (uint32_t off = 0; off < sizeof(FlightTrace); off += FR_DUMP_LINE_BYTES) {
+            flightDumpLine(line, sizeof(line), t, off);
+            text += "12:00:01.123 -> ";      // Timestamp del monitor seriale
+            text += line;
+            text += "\r\n";
+            if (off == 64) text += "✅ riga estranea\n";
+        }
+        static FlightTrace back;
+        memset(&back, 0, sizeof(back));
+        uint32_t lines = 0;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t nl = text.find('\n', pos);
+            if (nl == std::string::npos) nl = text.size();
+            if (flightParseLine(back, text.substr(pos, nl - pos).c_str())) lines++;
+            pos = nl + 1;
+        }
+        check(lines == (sizeof(FlightTrace) + FR_DUMP_LINE_BYTES - 1) / FR_DUMP_LINE_BYTES &&
+              memcmp(&back, &t, sizeof(t)) == 0 && flightTraceValid(back),
+              "dump FR -> parse identico (con timestamp del monitor e righe estranee)");
+    }
+
+    // Descrizioni leggibili
+    {
+        FlightEvent e = {};
+        char out[128];
+        e.type = FR_EV_MUTEX_WAIT;
+        e.task = flightTaskTag(FR_TASK_CONSOLE, 0);
+        e.object = FR_MUTEX_DISPLAY;
+        e.arg = 1500;
+        flightEventFormat(out, sizeof(out), 2500000, e);
+        check(strstr(out, "2.500000") && strstr(out, "Console") && strstr(out, "display 1500 us"),
+              out);
+        e.type = FR_EV_BOOT;
+        e.arg = 6;
+        e.object = 3;
+        flightEventDescribe(out, sizeof(out), e);
+        check(strcmp(out, "reset task_wdt, avvio 3") == 0, out);
+    }
+
+    // Costo per evento (host, un thread): riportato, dipende dalla macchina
+    {
+        flightTraceReset(t);
+        const uint32_t n = 20000000;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < n; i++) flightTraceRecord(t, i, FR_EV_MARK, 1, 2, i);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        printf("    %.1f ns/evento (host), %zu byte in RTC RAM\n", ns, sizeof(FlightTrace));
+        check(sizeof(FlightTrace) <= 4400, "traccia sotto 4.3KB (RTC slow memory 8KB)");
+    }
+
+    return testSummary();
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "selftest") == 0) return cmdSelftest();
+    if (argc == 3 && strcmp(argv[1], "decode") == 0) return cmdDecode(argv[2], 0);
+    if (argc == 4 && strcmp(argv[1], "decode") == 0) return cmdDecode(argv[2], (uint32_t)atoi(argv[3]));
+    fprintf(stderr,
+            "uso: %s decode <log seriale | file binario> [ultimi N]\n"
+            "     %s selftest\n", argv[0], argv[0]);
+    return 2;
+}
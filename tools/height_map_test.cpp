@@ -0,0 +1,134 @@
+// height_map_test.cpp
+// Test host della mappa di quota (src/height_map.h): statistiche per cella
+// contro un calcolo diretto, sweep di yaw attraverso 0/360, pianta di una
+// rampa, lista delle celle cambiate e costo per aggiornamento.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/height_map_test.cpp -o height_map_test && ./height_map_test
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "height_map.h"
+#include "test_check.h"
+
+typedef HeightMap<40, 40> Map;
+
+int main() {
+    static Map map;
+
+    // Media/min/max per cella contro il calcolo diretto
+    {
+        map.reset(HEIGHT_MAP_PLAN, 50.0f);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> pos(-900.0f, 900.0f);
+        std::normal_distribution<float> noise(0.0f, 3.0f);
+        struct Ref { double sum; float min, max; uint32_t n; };
+        std::vector<Ref> ref(Map::CELLS, Ref{0, INFINITY, -INFINITY, 0});
+
+        map.add(0, 0, 0);               // Centro della griglia sull'origine
+        ref[20 * 40 + 20] = {0, 0, 0, 1};
+        for (int i = 0; i < 200000; i++) {
+            float x = pos(rng), y = pos(rng);
+            float z = 0.2f * x + noise(rng);        // Rampa lungo X
+            map.add(x, y, z);
+            int col = (int)floorf(x / 50.0f + 20), row = (int)floorf(20 - y / 50.0f);
+            Ref &r = ref[row * 40 + col];
+            r.sum += z;
+            r.n++;
+            if (z < r.min) r.min = z;
+            if (z > r.max) r.max = z;
+        }
+        double worst = 0;
+        bool same = true;
+        for (uint16_t row = 0; row < 40; row++) {
+            for (uint16_t col = 0; col < 40; col++) {
+                const HeightMapCell &c = map.at(col, row);
+                const Ref &r = ref[row * 40 + col];
+                same &= c.count == r.n;
+                if (!r.n) continue;
+                worst = fmax(worst, fabs(c.mean - r.sum / r.n));
+                same &= c.min == r.min && c.max == r.max;
+            }
+        }
+        printf("    errore max media per cella: %.4f mm\n", worst);
+        check(same && worst < 0.01, "media, minimo, massimo e conteggi per cella");
+
+        // Rampa: le colonne a destra sono più alte
+        check(map.at(35, 20).mean > map.at(5, 20).mean + 250.0f, "pianta: quota crescente lungo X");
+    }
+
+    // Yaw attraverso 0/360: le celle restano contigue attorno al centro
+    {
+        map.reset(HEIGHT_MAP_ANGULAR, 1.0f);
+        SensorData d = {};
+        d.radar_valid = d.imu_valid = true;
+        d.pitch_deg = 5.0f;
+        d.distance_mm = 1200.0f;
+        d.yaw_deg = 359.5f;             // Primo campione: centro
+        map.add(d);
+        for (float yaw = 350.0f; yaw < 370.0f; yaw += 0.25f) {
+            d.yaw_deg = fmodf(yaw, 360.0f);
+            map.add(d);
+        }
+        HeightMapStats s;
+        map.getStats(s);
+        bool contiguous = true;
+        for (int col = 10; col <= 30; col++) contiguous &= map.at(col, 20).count > 0;
+        printf("    celle %u, fuori griglia %u\n", s.occupied, s.rejected);
+        check(contiguous && s.rejected == 0 && s.occupied == 21, "yaw continuo attraverso 0/360");
+
+        d.yaw_deg = 90.0f;              // Fuori dalla finestra di ±20°
+        check(!map.add(d) && !map.add(NAN, 0, 0), "fuori griglia e non finiti scartati");
+    }
+
+    // Lista delle celle cambiate: solo quelle toccate, ognuna una volta
+    {
+        map.reset(HEIGHT_MAP_PLAN, 10.0f);
+        uint16_t idx[64];
+        HeightMapCell out[64];
+        for (int k = 0; k < 5; k++) {
+            for (int i = 0; i < 3; i++) map.add(i * 10.0f + 1, 1.0f, (float)k);
+        }
+        uint16_t n = map.takeDirty(idx, out, 64);
+        check(n == 3 && map.takeDirty(idx, out, 64) == 0 && out[0].count == 5, "celle cambiate una volta sola");
+
+        map.add(1.0f, 1.0f, 9.0f);
+        n = map.takeDirty(idx, out, 64);
+        check(n == 1 && out[0].max == 9.0f, "solo la cella aggiornata");
+
+        map.markAllDirty();
+        check(map.takeDirty(idx, out, 64) == 3, "ridisegno completo delle celle occupate");
+
+        HeightMapStats before, after;
+        map.getStats(before);
+        map.clear();
+        map.getStats(after);
+        check(after.generation != before.generation && after.occupied == 0 && map.pending() == 0,
+              "clear: griglia vuota e nuova generazione");
+    }
+
+    // Costo per aggiornamento (riportato: deve restare trascurabile nel ciclo sensori)
+    {
+        map.reset(HEIGHT_MAP_ANGULAR, 0.5f);
+        SensorData d = {};
+        d.radar_valid = d.imu_valid = true;
+        uint32_t n = 5000000, hits = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < n; i++) {
+            d.yaw_deg = (i % 4000) * 0.01f;
+            d.pitch_deg = ((i / 4000) % 40) * 0.5f - 10.0f;
+            d.distance_mm = 1000.0f + (i & 63);
+            hits += map.add(d);
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        printf("    %.1f ns/aggiornamento (host), %u in griglia, %u celle da ridisegnare\n",
+               ns, hits, map.pending());
+        check(map.pending() <= Map::CELLS, "lista delle celle da ridisegnare limitata");
+    }
+
+    // Scala colori: estremi e NaN
+    check(heightMapColor(0) == 0x001F && heightMapColor(1) == 0xF800 && heightMapColor(NAN) == 0x001F,
+          "scala colori blu -> rosso");
+
+    return testSummary();
+}
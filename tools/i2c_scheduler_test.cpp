@@ -0,0 +1,230 @@
+// i2c_scheduler_test.cpp
+// Test host dello scheduler del bus I2C (src/i2c_scheduler.h) su
+// I2CSimBackend: ordine per priorità e deadline, scarto delle transazioni
+// scadute, fusione in burst delle letture contigue, coda piena, cancel,
+// accounting del tempo bus per dispositivo e pubblicazione dell'esito.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/i2c_scheduler_test.cpp -o i2c_scheduler_test && ./i2c_scheduler_test
+#include <stdio.h>
+#include "i2c_sim_backend.h"
+#include "test_check.h"
+
+#define IMU_ADDR    0x6A
+#define MAG_ADDR    0x1C
+#define RADAR_ADDR  0x52
+
+// Esegue tutto ciò che è in coda; ritorna i batch eseguiti
+static uint32_t drain(I2CScheduler &sched, I2CTransaction **order, uint8_t *sizes, uint32_t max) {
+    I2CTransaction *batch[I2C_BATCH_MAX];
+    uint32_t batches = 0, served = 0;
+    uint8_t n;
+    while ((n = sched.pop(batch)) > 0) {
+        sched.execute(batch, n);
+        sched.publish(batch, n);
+        if (sizes && batches < max) sizes[batches] = n;
+        for (uint8_t i = 0; i < n && order && served < max; i++) order[served++] = batch[i];
+        batches++;
+    }
+    return batches;
+}
+
+int main() {
+    I2CSimBackend sim;
+    sim.addDevice(IMU_ADDR);
+    sim.addDevice(MAG_ADDR);
+    sim.addDevice(RADAR_ADDR);
+    for (int r = 0; r < 256; r++) sim.setRegister(IMU_ADDR, (uint8_t)r, (uint8_t)r);
+
+    I2CScheduler sched;
+    sched.setBackend(&sim);
+
+    // Priorità: HIGH prima di NORMAL prima di LOW, a prescindere dall'ordine di arrivo
+    {
+        uint8_t a[2], b[2];
+        I2CTransaction low, normal, high;
+        i2cPrepareJob(low, I2C_DEV_OTHER, I2C_PRIO_LOW, [](void *) { return true; }, nullptr);
+        i2cPrepareRead(normal, I2C_DEV_RADAR, I2C_PRIO_NORMAL, RADAR_ADDR, 0x10, a, 2);
+        i2cPrepareRead(high, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x22, b, 2);
+        sched.push(&low, sim.nowUs());
+        sched.push(&normal, sim.nowUs());
+        sched.push(&high, sim.nowUs());
+
+        I2CTransaction *order[3] = {nullptr};
+        drain(sched, order, nullptr, 3);
+        check(order[0] == &high && order[1] == &normal && order[2] == &low, "ordine per priorità");
+        check(high.result == I2C_RESULT_OK && normal.result == I2C_RESULT_OK && low.result == I2C_RESULT_OK,
+              "tutte completate OK");
+        check(b[0] == 0x22 && b[1] == 0x23, "dati letti dalla mappa registri");
+    }
+
+    // Stessa priorità: deadline più vicina prima, senza deadline in coda (FIFO fra pari)
+    {
+        uint8_t buf[4][1];
+        I2CTransaction t[4];
+        for (int i = 0; i < 4; i++) {
+            i2cPrepareRead(t[i], I2C_DEV_RADAR, I2C_PRIO_NORMAL, RADAR_ADDR, (uint8_t)(0x40 + i * 8), buf[i], 1);
+        }
+        uint64_t now = sim.nowUs();
+        t[0].deadline_us = 0;
+        t[1].deadline_us = now + 5000;
+        t[2].deadline_us = 0;
+        t[3].deadline_us = now + 1000;
+        for (int i = 0; i < 4; i++) sched.push(&t[i], now);
+
+        I2CTransaction *order[4] = {nullptr};
+        drain(sched, order, nullptr, 4);
+        check(order[0] == &t[3] && order[1] == &t[1], "deadline più vicina prima");
+        check(order[2] == &t[0] && order[3] == &t[2], "senza deadline: ordine di arrivo");
+    }
+
+    // Deadline già passata all'avvio: scartata senza toccare il bus
+    {
+        sched.resetStats();
+        uint8_t buf[6];
+        I2CTransaction late, ok;
+        i2cPrepareRead(late, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x28, buf, 6);
+        i2cPrepareRead(ok, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x10, buf, 1);
+        ok.flags = I2C_FLAG_NO_BATCH;
+        late.deadline_us = sim.nowUs() + 100;
+        sched.push(&late, sim.nowUs());
+        sched.push(&ok, sim.nowUs());
+        sim.advance(500);
+
+        uint32_t readsBefore = sim.getReadCount();
+        drain(sched, nullptr, nullptr, 0);
+        const I2CDeviceStats &s = sched.getStats(I2C_DEV_IMU);
+        check(late.result == I2C_RESULT_DEADLINE_MISSED && s.deadline_misses == 1, "deadline mancata: scartata e contata");
+        check(ok.result == I2C_RESULT_OK && sim.getReadCount() == readsBefore + 1, "solo la transazione valida va sul bus");
+        check(late.complete_us == late.start_us, "scartata: nessun tempo bus");
+    }
+
+    // Burst: letture contigue sullo stesso indirizzo fuse in una sola transazione
+    {
+        sched.resetStats();
+        uint8_t gyro[6], accel[6], temp[2], other[2];
+        I2CTransaction tg, ta, tt, to;
+        // Arrivano fuori ordine: accel (0x28) dopo gyro (0x22), temp (0x20) prima di entrambi
+        i2cPrepareRead(tg, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x22, gyro, 6);
+        i2cPrepareRead(ta, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x28, accel, 6);
+        i2cPrepareRead(tt, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x20, temp, 2);
+        i2cPrepareRead(to, I2C_DEV_MAG, I2C_PRIO_HIGH, MAG_ADDR, 0x28, other, 2);
+        sched.push(&tg, sim.nowUs());
+        sched.push(&ta, sim.nowUs());
+        sched.push(&to, sim.nowUs());
+        sched.push(&tt, sim.nowUs());
+
+        uint32_t readsBefore = sim.getReadCount();
+        uint8_t sizes[4] = {0};
+        uint32_t batches = drain(sched, nullptr, sizes, 4);
+        check(batches == 3 && sizes[0] == 2 && sizes[1] == 1 && sizes[2] == 1,
+              "gyro+accel fusi, mag e temp (non contigui alla testa) separati");
+        check(sim.getReadCount() == readsBefore + 3, "una lettura bus per batch");
+        check(gyro[0] == 0x22 && gyro[5] == 0x27 && accel[0] == 0x28 && accel[5] == 0x2D,
+              "burst ridistribuito nei buffer dei chiamanti");
+        check(tg.complete_us == ta.complete_us && sched.getStats(I2C_DEV_IMU).batched == 1,
+              "fuse: stesso completamento, una servita nel burst altrui");
+    }
+
+    // Limiti del burst: I2C_FLAG_NO_BATCH e I2C_BATCH_MAX_BYTES
+    {
+        uint8_t a[16], b[16], c[8];
+        I2CTransaction ta, tb, tc;
+        i2cPrepareRead(ta, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x00, a, 16);
+        i2cPrepareRead(tb, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x10, b, 16);
+        i2cPrepareRead(tc, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x20, c, 8);
+        sched.push(&ta, sim.nowUs());
+        sched.push(&tb, sim.nowUs());
+        sched.push(&tc, sim.nowUs());
+        uint8_t sizes[3] = {0};
+        drain(sched, nullptr, sizes, 3);
+        check(sizes[0] == 2 && sizes[1] == 1, "burst limitato a I2C_BATCH_MAX_BYTES");
+
+        i2cPrepareRead(ta, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x00, a, 4);
+        i2cPrepareRead(tb, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x04, b, 4);
+        tb.flags = I2C_FLAG_NO_BATCH;
+        sched.push(&ta, sim.nowUs());
+        sched.push(&tb, sim.nowUs());
+        uint32_t batches = drain(sched, nullptr, sizes, 3);
+        check(batches == 2, "I2C_FLAG_NO_BATCH non viene fusa");
+
+        // Le scritture non si fondono mai
+        uint8_t w[1] = {0x55};
+        I2CTransaction w1, w2;
+        i2cPrepareWrite(w1, I2C_DEV_IMU, I2C_PRIO_LOW, IMU_ADDR, 0x10, w, 1);
+        i2cPrepareWrite(w2, I2C_DEV_IMU, I2C_PRIO_LOW, IMU_ADDR, 0x11, w, 1);
+        sched.push(&w1, sim.nowUs());
+        sched.push(&w2, sim.nowUs());
+        batches = drain(sched, nullptr, sizes, 3);
+        check(batches == 2 && sim.getRegister(IMU_ADDR, 0x11) == 0x55, "scritture separate e applicate");
+    }
+
+    // Coda piena per priorità e cancel di una transazione non avviata
+    {
+        uint8_t buf[1];
+        I2CTransaction t[I2C_QUEUE_DEPTH + 1];
+        bool allOk = true;
+        for (int i = 0; i < I2C_QUEUE_DEPTH; i++) {
+            i2cPrepareRead(t[i], I2C_DEV_RADAR, I2C_PRIO_NORMAL, RADAR_ADDR, (uint8_t)(i * 4), buf, 1);
+            allOk &= sched.push(&t[i], sim.nowUs());
+        }
+        i2cPrepareRead(t[I2C_QUEUE_DEPTH], I2C_DEV_RADAR, I2C_PRIO_NORMAL, RADAR_ADDR, 0xF0, buf, 1);
+        bool full = !sched.push(&t[I2C_QUEUE_DEPTH], sim.nowUs());
+        check(allOk && full && t[I2C_QUEUE_DEPTH].result == I2C_RESULT_QUEUE_FULL, "coda piena: QUEUE_FULL");
+
+        uint8_t hb[1];
+        I2CTransaction other;
+        i2cPrepareRead(other, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x00, hb, 1);
+        check(sched.push(&other, sim.nowUs()), "code indipendenti per priorità");
+
+        check(sched.cancel(&t[3]) && !sched.cancel(&t[3]) && sched.pendingCount(I2C_PRIO_NORMAL) == I2C_QUEUE_DEPTH - 1,
+              "cancel rimuove una sola volta");
+        drain(sched, nullptr, nullptr, 0);
+        check(t[3].result == I2C_RESULT_PENDING && !sched.hasPending(), "cancellata mai eseguita, coda vuota");
+    }
+
+    // Accounting: tempo bus al dispositivo che lo occupa, attesa in coda
+    {
+        sched.resetStats();
+        uint8_t buf[8];
+        I2CTransaction r1, r2;
+        i2cPrepareRead(r1, I2C_DEV_RADAR, I2C_PRIO_NORMAL, RADAR_ADDR, 0x00, buf, 8);
+        i2cPrepareRead(r2, I2C_DEV_RADAR, I2C_PRIO_NORMAL, RADAR_ADDR, 0x40, buf, 8);
+        sched.push(&r1, sim.nowUs());
+        sched.push(&r2, sim.nowUs());
+        drain(sched, nullptr, nullptr, 0);
+        const I2CDeviceStats &s = sched.getStats(I2C_DEV_RADAR);
+        uint32_t oneRead = 60 + 8 * 25;     // Latenze di default del simulatore
+        check(s.transactions == 2 && s.bytes == 16 && s.busy_us == 2 * oneRead && s.max_busy_us == oneRead,
+              "tempo bus e byte per dispositivo");
+        check(s.max_wait_us == oneRead && r2.start_us - r2.submit_us == oneRead, "attesa in coda della seconda");
+    }
+
+    // Errore del backend: ERROR e contatore errori
+    {
+        sched.resetStats();
+        sim.injectNack(MAG_ADDR, 1);
+        uint8_t buf[2];
+        I2CTransaction t;
+        i2cPrepareRead(t, I2C_DEV_MAG, I2C_PRIO_HIGH, MAG_ADDR, 0x28, buf, 2);
+        sched.push(&t, sim.nowUs());
+        drain(sched, nullptr, nullptr, 0);
+        check(t.result == I2C_RESULT_ERROR && sched.getStats(I2C_DEV_MAG).errors == 1, "NACK: ERROR contato");
+    }
+
+    // Esito in outcome: result resta PENDING fino alla pubblicazione
+    // (il chiamante sincrono può liberare il descrittore solo dopo)
+    {
+        uint8_t buf[2];
+        I2CTransaction t;
+        I2CTransaction *batch[I2C_BATCH_MAX];
+        i2cPrepareRead(t, I2C_DEV_IMU, I2C_PRIO_HIGH, IMU_ADDR, 0x22, buf, 2);
+        sched.push(&t, sim.nowUs());
+        uint8_t n = sched.pop(batch);
+        sched.execute(batch, n);
+        check(!i2cIsDone(t) && t.outcome == I2C_RESULT_OK && t.complete_us > 0, "dopo execute: esito non ancora pubblicato");
+        sched.publish(batch, n);
+        check(i2cIsDone(t) && t.result == I2C_RESULT_OK, "publish: result visibile al chiamante");
+    }
+
+    return testSummary();
+}
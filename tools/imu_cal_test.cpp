@@ -0,0 +1,116 @@
+// imu_cal_test.cpp
+// Test host dei motori di calibrazione IMU (src/imu_calibration.h) con dati
+// sintetici a 10Hz: bias del giroscopio con movimento iniziale, sei facce
+// dell'accelerometro con offset/scala noti, casi da rifiutare.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/imu_cal_test.cpp -o imu_cal_test && ./imu_cal_test
+#include <stdio.h>
+#include <random>
+#include "imu_calibration.h"
+#include "test_check.h"
+
+static std::mt19937 rng(1234);
+
+static float noise(float sigma) {
+    std::normal_distribution<float> d(0.0f, sigma);
+    return d(rng);
+}
+
+int main() {
+    const float g = IMU_CAL_GRAVITY;
+
+    // Welford: stabile con offset grande rispetto al rumore
+    {
+        RunningStats s;
+        s.reset();
+        const double v[4] = {1e6 + 4, 1e6 + 7, 1e6 + 13, 1e6 + 16};
+        for (double x : v) s.add(x);
+        check(s.mean == 1e6 + 10 && fabs(s.variance() - 30.0) < 1e-9, "Welford media/varianza");
+    }
+
+    // Giroscopio: 3 s di movimento, poi fermo con bias noto
+    {
+        const float bias[3] = {0.8f, -1.3f, 0.25f};
+        GyroBiasCalibrator cal;
+        cal.start();
+        uint32_t n = 0;
+        IMUCalState st = IMU_CAL_RUNNING;
+        for (; n < 30 && st == IMU_CAL_RUNNING; n++) {
+            float gy[3] = {20.0f * sinf(n * 0.7f), -15.0f, 5.0f * cosf(n * 0.3f)};
+            float a[3] = {noise(1.0f), noise(1.0f), g};
+            st = cal.add(gy, a);
+        }
+        uint32_t stillStart = n;
+        while (st == IMU_CAL_RUNNING) {
+            float gy[3] = {bias[0] + noise(0.03f), bias[1] + noise(0.03f), bias[2] + noise(0.03f)};
+            float a[3] = {noise(0.004f), noise(0.004f), g + noise(0.004f)};
+            st = cal.add(gy, a);
+            n++;
+        }
+        float est[3];
+        cal.getBias(est);
+        float err = 0;
+        for (int i = 0; i < 3; i++) err = fmaxf(err, fabsf(est[i] - bias[i]));
+        printf("    gyro: %u campioni fermi (%.1f s), errore max %.4f dps, riavvii %u\n",
+               n - stillStart, (n - stillStart) / 10.0f, err, cal.getRestarts());
+        check(st == IMU_CAL_DONE && err < 3 * GYRO_CAL_TARGET_SE_DPS, "bias giroscopio");
+        check(n - stillStart < 60, "fine per convergenza, non a tempo");
+    }
+
+    // Giroscopio: sempre in movimento -> fallita, bias precedente da tenere
+    {
+        GyroBiasCalibrator cal;
+        cal.start();
+        IMUCalState st = IMU_CAL_RUNNING;
+        for (int n = 0; st == IMU_CAL_RUNNING; n++) {
+            float gy[3] = {30.0f * sinf(n * 0.9f), 0, 0};
+            float a[3] = {0, 0, g};
+            st = cal.add(gy, a);
+        }
+        check(st == IMU_CAL_FAILED, "movimento continuo: rifiutata");
+    }
+
+    // Accelerometro: sei facce con transizioni rumorose e una pausa fuori faccia
+    {
+        const float offset[3] = {0.15f, -0.22f, 0.31f};
+        const float scale[3] = {1.012f, 0.991f, 1.004f};
+        AccelSixPosCalibrator cal;
+        cal.start();
+        IMUCalState st = IMU_CAL_RUNNING;
+        uint32_t n = 0;
+        for (int f = 0; f < ACCEL_CAL_FACES && st == IMU_CAL_RUNNING; f++) {
+            // Rotazione verso la faccia successiva
+            for (int k = 0; k < 8; k++, n++) {
+                float a[3] = {noise(4.0f), noise(4.0f), noise(4.0f)};
+                st = cal.add(a);
+            }
+            float tilt = 0.05f;     // Appoggio non perfetto
+            for (int k = 0; k < 80 && !cal.isFaceDone(f); k++, n++) {
+                float truth[3] = {tilt * g, tilt * g, tilt * g};
+                truth[f / 2] = (f & 1) ? -g : g;
+                float a[3];
+                for (int i = 0; i < 3; i++) a[i] = scale[i] * truth[i] + offset[i] + noise(0.004f);
+                st = cal.add(a);
+            }
+        }
+        float off[3], sc[3];
+        cal.getResult(off, sc);
+        float errOff = 0, errScale = 0;
+        for (int i = 0; i < 3; i++) {
+            errOff = fmaxf(errOff, fabsf(off[i] - offset[i]));
+            errScale = fmaxf(errScale, fabsf(sc[i] - scale[i]));
+        }
+        printf("    accel: %u campioni, errore offset %.4f m/s2, scala %.5f\n", n, errOff, errScale);
+        check(st == IMU_CAL_DONE && cal.getFaces() == ACCEL_CAL_ALL_FACES, "sei facce acquisite");
+        check(errOff < 0.01f && errScale < 0.002f, "offset e scala");
+    }
+
+    // Accelerometro: facce classificate solo se appoggiate
+    {
+        float flat[3] = {0.3f, -0.2f, -9.7f};
+        float tilted[3] = {6.9f, 0, 6.9f};
+        check(accelClassifyFace(flat) == 5 && accelClassifyFace(tilted) == -1, "classificazione facce");
+    }
+
+    return testSummary();
+}
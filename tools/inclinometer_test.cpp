@@ -0,0 +1,117 @@
+// inclinometer_test.cpp
+// Test host dell'estimatore di pitch di precisione (src/inclinometer_estimator.h)
+// su accelerometro sintetico a 416Hz: rumore correlato (filtro del sensore),
+// picchi da urto, copertura dell'intervallo di confidenza e movimento.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/inclinometer_test.cpp -o inclinometer_test && ./inclinometer_test
+#include <stdio.h>
+#include <random>
+#include "inclinometer_estimator.h"
+#include "test_check.h"
+
+static const float ODR_HZ = 416.0f;
+static const float NOISE_MS2 = 0.012f;      // ~1.2 mg RMS a 416Hz
+static const float TARGET_DEG = 0.05f;
+
+// Rumore AR(1): i campioni consecutivi sono correlati come dopo l'LPF
+struct Sensor {
+    std::mt19937 rng;
+    float state[3] = {0, 0, 0};
+    float rho = 0.6f;
+
+    explicit Sensor(uint32_t seed) : rng(seed) {}
+
+    void sample(float pitchDeg, float a[3], float spikeProb) {
+        std::normal_distribution<float> n(0.0f, NOISE_MS2 * sqrtf(1 - rho * rho));
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        float p = pitchDeg * (float)M_PI / 180.0f;
+        float truth[3] = {-INCLINO_GRAVITY * sinf(p), 0.0f, INCLINO_GRAVITY * cosf(p)};
+        for (int i = 0; i < 3; i++) {
+            state[i] = rho * state[i] + n(rng);
+            a[i] = truth[i] + state[i];
+        }
+        if (u(rng) < spikeProb) a[0] += 0.4f;    // Urto: ~2.3° sul singolo campione
+    }
+};
+
+// Campioni fino alla convergenza (0 = mai entro maxSamples)
+static uint32_t measure(PrecisionPitchEstimator &est, Sensor &s, float pitch,
+                        float spikeProb, uint32_t maxSamples) {
+    est.reset();
+    for (uint32_t n = 1; n <= maxSamples; n++) {
+        float a[3];
+        s.sample(pitch, a, spikeProb);
+        est.add(a);
+        if (est.converged(TARGET_DEG)) return n;
+    }
+    return 0;
+}
+
+int main() {
+    // Convergenza e precisione su una misura
+    {
+        PrecisionPitchEstimator est;
+        Sensor s(7);
+        const float pitch = 12.345f;
+        uint32_t n = measure(est, s, pitch, 0.01f, 5 * (uint32_t)ODR_HZ);
+        float err = fabsf(est.pitch() - pitch);
+        printf("    %u campioni (%.0f ms), pitch %.4f ±%.4f°, errore %.4f°, scartati %u\n",
+               n, n * 1000.0f / ODR_HZ, est.pitch(), est.ci95(), err, est.rejected());
+        check(n > 0 && n * 1000.0f / ODR_HZ < 1000.0f, "convergenza sotto 1 s");
+        check(err < TARGET_DEG, "errore entro il target");
+        check(est.rejected() > 0, "picchi scartati");
+    }
+
+    // Copertura dell'IC al 95%: la verità deve cadere dentro in ~95% dei casi
+    {
+        const int runs = 400;
+        int inside = 0;
+        for (int r = 0; r < runs; r++) {
+            PrecisionPitchEstimator est;
+            Sensor s(1000 + r);
+            // 40 blocchi a pitch fisso
+            est.reset();
+            for (int k = 0; k < 40 * INCLINO_BLOCK_SAMPLES; k++) {
+                float a[3];
+                s.sample(-3.0f, a, 0.0f);
+                est.add(a);
+            }
+            if (fabsf(est.pitch() + 3.0f) <= est.ci95()) inside++;
+        }
+        float coverage = inside / (float)runs;
+        printf("    copertura IC95: %.1f%% su %d misure\n", coverage * 100.0f, runs);
+        check(coverage > 0.90f && coverage < 0.99f, "IC95 calibrato con rumore correlato");
+    }
+
+    // Movimento a metà misura: ripartenza, la stima finale è la nuova posizione
+    {
+        PrecisionPitchEstimator est;
+        Sensor s(99);
+        for (int k = 0; k < 3 * INCLINO_BLOCK_SAMPLES; k++) {  // Non ancora convergente
+            float a[3];
+            s.sample(5.0f, a, 0.0f);
+            est.add(a);
+        }
+        uint32_t n = 0;
+        for (; n < 5 * (uint32_t)ODR_HZ && !est.converged(TARGET_DEG); n++) {
+            float a[3];
+            s.sample(8.0f, a, 0.0f);
+            est.add(a);
+        }
+        printf("    dopo lo spostamento: pitch %.4f°, ripartenze %u\n", est.pitch(), est.restarts());
+        check(est.restarts() >= 1 && fabsf(est.pitch() - 8.0f) < TARGET_DEG, "movimento: misura ripartita");
+    }
+
+    // Vibrazione: modulo di a fuori tolleranza, nessuna convergenza spuria
+    {
+        PrecisionPitchEstimator est;
+        uint32_t accepted = 0;
+        for (int k = 0; k < 500; k++) {
+            float a[3] = {0.0f, 0.0f, INCLINO_GRAVITY * (k % 2 ? 1.2f : 0.8f)};
+            if (est.add(a)) accepted++;
+        }
+        check(accepted == 0 && !est.converged(TARGET_DEG), "vibrazione: campioni rifiutati");
+    }
+
+    return testSummary();
+}
@@ -0,0 +1,364 @@
+// log_codec_cli.cpp
+// Formato a blocchi compressi dei log di sessione (src/log_codec.h):
+// conversione fra .rec a blocchi e a record fissi, benchmark su un log
+// registrato e selftest (round-trip esatto, blocchi indipendenti, CRC,
+// rapporto di compressione su dati sintetici da campo). La velocità dipende
+// dalla macchina: il selftest la stampa soltanto, bench la misura sul log.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/log_codec_cli.cpp -o log_codec_cli
+//
+//   log_codec_cli bench <file.rec>
+//   log_codec_cli unpack <file.rec> <uscita.rec>
+//   log_codec_cli pack <file.rec> <uscita.rec>
+//   log_codec_cli selftest
+//
+// unpack scrive record fissi da 32 byte (script di analisi esistenti); pack
+// fa il contrario. L'indice del file a blocchi si rifà con
+// log_pyramid_cli build.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "log_format.h"
+#include "log_codec.h"
+#include "test_check.h"
+
+static double millisSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// === FILE ===
+// Tutti i record di un .rec, fissi o a blocchi (fino al primo blocco rovinato)
+static bool loadRecords(const char *path, std::vector<SensorRecord> &recs, LogFileHeader &h, uint32_t *blocks = NULL) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    recs.clear();
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.item_bytes == sizeof(SensorRecord) &&
+              (logHeaderValid(h, LOG_FILE_RECORDS, 0) || logHeaderValid(h, LOG_FILE_BLOCKS, 0));
+    if (!ok) {
+        fprintf(stderr, "%s: non è un log di record\n", path);
+    } else if (h.kind == LOG_FILE_RECORDS) {
+        SensorRecord r;
+        while (fread(&r, sizeof(r), 1, f) == 1) recs.push_back(r);
+    } else {
+        static uint8_t payload[LOG_BLOCK_MAX_PAYLOAD];
+        SensorRecord block[LOG_BLOCK_RECORDS];
+        LogBlockHeader bh;
+        uint64_t offset = sizeof(LogFileHeader);
+        auto readAt = [&](uint64_t at, void *buf, uint32_t len) {
+            return fseek(f, (long)at, SEEK_SET) == 0 ? (uint32_t)fread(buf, 1, len, f) : 0u;
+        };
+        uint32_t n = 0;
+        while (logBlockLoad(readAt, offset, bh, payload) && bh.first_record == recs.size() &&
+               logBlockDecode(bh, payload, block)) {
+            recs.insert(recs.end(), block, block + bh.records);
+            offset += sizeof(bh) + bh.payload_bytes;
+            n++;
+        }
+        if (blocks) *blocks = n;
+    }
+    fclose(f);
+    return ok;
+}
+
+// Blocchi da LOG_BLOCK_RECORDS, chiusi prima ogni flushEvery record (come
+// il logger a ogni flush). Byte totali.
+static uint64_t encodeBlocks(const std::vector<SensorRecord> &recs, uint32_t flushEvery,
+                             std::vector<uint8_t> &out, std::vector<uint64_t> *offsets = NULL) {
+    static LogBlockEncoder encoder;
+    out.clear();
+    encoder.begin(0);
+    for (uint32_t i = 0; i < recs.size(); i++) {
+        bool full = encoder.add(recs[i]);
+        if (full || (i + 1) % flushEvery == 0 || i + 1 == recs.size()) {
+            if (offsets) offsets->push_back(out.size());
+            uint32_t n = encoder.seal();
+            out.insert(out.end(), encoder.data(), encoder.data() + n);
+            encoder.begin(i + 1);
+        }
+    }
+    return out.size();
+}
+
+// Decodifica di tutti i blocchi in fila con verifica del CRC; record decodificati
+static uint32_t decodeBlocks(const std::vector<uint8_t> &data, std::vector<SensorRecord> &out) {
+    uint64_t offset = 0;
+    uint32_t n = 0;
+    while (offset + sizeof(LogBlockHeader) <= data.size()) {
+        LogBlockHeader h;
+        memcpy(&h, data.data() + offset, sizeof(h));
+        const uint8_t *payload = data.data() + offset + sizeof(h);
+        if (!logBlockHeaderValid(h) || offset + sizeof(h) + h.payload_bytes > data.size() ||
+            logBlockCrc(h, payload) != h.crc || !logBlockDecode(h, payload, out.data() + n)) {
+            break;
+        }
+        n += h.records;
+        offset += sizeof(h) + h.payload_bytes;
+    }
+    return n;
+}
+
+static bool writeFile(const char *path, const LogFileHeader &h, const void *data, size_t bytes) {
+    FILE *f = fopen(path, "wb");
+    bool ok = f && fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(data, 1, bytes, f) == bytes;
+    if (f) ok &= fclose(f) == 0;
+    if (!ok) perror(path);
+    return ok;
+}
+
+// === MISURE ===
+struct CodecReport {
+    double bytesPerRecord;
+    double ratio;               // Record fissi / blocchi
+    double encodeNs;            // Per record, CRC compreso
+    double decodeNs;            // Per record, CRC compreso
+    double decodeMBs;           // Record decodificati (32 byte) al secondo
+    double inputMBs;            // Byte compressi letti al secondo
+};
+
+static CodecReport measure(const std::vector<SensorRecord> &recs, uint32_t flushEvery, int reps) {
+    CodecReport r = {};
+    std::vector<uint8_t> data;
+    std::vector<SensorRecord> out(recs.size());
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; i++) encodeBlocks(recs, flushEvery, data);
+    r.encodeNs = millisSince(t0) * 1e6 / reps / recs.size();
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; i++) decodeBlocks(data, out);
+    double ms = millisSince(t0) / reps;
+    r.decodeNs = ms * 1e6 / recs.size();
+    r.decodeMBs = recs.size() * sizeof(SensorRecord) / (ms * 1e3);
+    r.inputMBs = data.size() / (ms * 1e3);
+    r.bytesPerRecord = (double)data.size() / recs.size();
+    r.ratio = sizeof(SensorRecord) / r.bytesPerRecord;
+    return r;
+}
+
+static void printReport(const char *label, const CodecReport &r) {
+    printf("    %-26s %5.2f B/record (%.2fx), codifica %5.1f ns/record, "
+           "decodifica %5.1f ns/record = %4.0f MB/s record, %4.0f MB/s compressi\n",
+           label, r.bytesPerRecord, r.ratio, r.encodeNs, r.decodeNs, r.decodeMBs, r.inputMBs);
+}
+
+// === COMANDI ===
+static int cmdBench(const char *path) {
+    std::vector<SensorRecord> recs;
+    LogFileHeader h;
+    uint32_t blocks = 0;
+    if (!loadRecords(path, recs, h, &blocks) || recs.empty()) return 1;
+    double seconds = (recs.back().timestamp_us - recs.front().timestamp_us) / 1e6;
+    printf("%s: %zu record in %.0f s (%.1f Hz), %s\n", path, recs.size(), seconds,
+           seconds > 0 ? (recs.size() - 1) / seconds : 0.0,
+           h.kind == LOG_FILE_BLOCKS ? "a blocchi" : "record fissi");
+    if (h.kind == LOG_FILE_BLOCKS) printf("    file: %u blocchi, %.1f record/blocco\n", blocks, (double)recs.size() / blocks);
+    int reps = recs.size() < 100000 ? 20 : 3;
+    printReport("blocchi pieni (128):", measure(recs, UINT32_MAX, reps));
+    printReport("flush ogni 50 (5s a 10Hz):", measure(recs, 50, reps));
+    return 0;
+}
+
+static int cmdConvert(const char *in, const char *out, uint8_t kind) {
+    std::vector<SensorRecord> recs;
+    LogFileHeader h;
+    if (!loadRecords(in, recs, h)) return 1;
+    LogFileHeader oh = h;
+    oh.kind = kind;
+    bool ok;
+    if (kind == LOG_FILE_RECORDS) {
+        ok = writeFile(out, oh, recs.data(), recs.size() * sizeof(SensorRecord));
+    } else {
+        std::vector<uint8_t> data;
+        encodeBlocks(recs, UINT32_MAX, data);
+        ok = writeFile(out, oh, data.data(), data.size());
+    }
+    if (ok) fprintf(stderr, "%zu record scritti in %s\n", recs.size(), out);
+    return ok ? 0 : 1;
+}
+
+// === SELFTEST ===
+// Sweep da campo: profilo di superficie lento sotto rumore radar, filtrato
+// IIR, IMU con rumore di quantizzazione, jitter di ciclo e letture mancate
+static void fieldRecords(std::vector<SensorRecord> &recs, uint32_t n, float rateHz, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> radarNoise(0.0f, 0.8f), imuNoise(0.0f, 0.02f);
+    std::uniform_int_distribution<int> jitter(-400, 400), radarJob(3000, 6000), imuBurst(500, 1500);
+    uint64_t period = (uint64_t)(1e6f / rateHz);
+    float filtered = 0.0f;
+    recs.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        float t = i / rateHz;
+        SensorData d = {};
+        d.timestamp_us = 2000000ull + i * period + jitter(rng);
+        d.yaw_deg = fmodf(200.0f + t * 1.5f, 360.0f);                  // Giro lento, passa per 0
+        d.pitch_deg = -12.0f + 4.0f * sinf(t * 0.05f) + imuNoise(rng);
+        d.roll_deg = 0.8f + imuNoise(rng);
+        d.distance_mm = 1800.0f + 250.0f * sinf(d.yaw_deg * 0.0349f) + 40.0f * sinf(t * 0.7f) + radarNoise(rng);
+        filtered = i == 0 ? d.distance_mm : filtered + 0.2f * (d.distance_mm - filtered);
+        d.filtered_distance_mm = filtered;
+        d.radar_valid = (i % 211) != 0;
+        d.imu_valid = (i % 997) != 0;
+        setSensorTimestamps(d, d.timestamp_us + radarJob(rng), (i % 53) ? d.timestamp_us + imuBurst(rng) : 0);
+        packSensorRecord(d, recs[i]);
+    }
+}
+
+// Valori qualsiasi su tutto il range dei campi, timestamp anche all'indietro
+static void randomRecords(std::vector<SensorRecord> &recs, uint32_t n) {
+    std::mt19937_64 rng(5);
+    recs.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        SensorRecord &r = recs[i];
+        uint64_t a = rng(), b = rng(), c = rng();
+        r.timestamp_us = i % 7 == 0 ? a : (i ? recs[i - 1].timestamp_us + (a & 0xFFFF) : 0);
+        r.radar_dt_us = (int32_t)b;
+        r.imu_dt_us = (int32_t)(b >> 32);
+        r.distance_um = (int32_t)c;
+        r.filtered_um = (int32_t)(c >> 32);
+        r.pitch_cdeg = (int16_t)a;
+        r.yaw_cdeg = (uint16_t)(a >> 16);
+        r.roll_cdeg = (int16_t)(a >> 32);
+        r.flags = (uint8_t)(b >> 8);
+        r.version = (uint8_t)(c >> 8);
+    }
+    // Caso peggiore: estremi alternati in ogni campo
+    for (uint32_t i = 0; i < 256 && i < n; i++) {
+        SensorRecord &r = recs[i];
+        bool hi = i & 1;
+        r.timestamp_us = hi ? UINT64_MAX : 0;
+        r.radar_dt_us = r.imu_dt_us = r.distance_um = r.filtered_um = hi ? INT32_MAX : INT32_MIN;
+        r.pitch_cdeg = r.roll_cdeg = hi ? INT16_MAX : INT16_MIN;
+        r.yaw_cdeg = hi ? 0x8000 : 0;
+        r.flags = r.version = hi ? 0xFF : 0;
+    }
+}
+
+static bool sameRecords(const std::vector<SensorRecord> &a, const SensorRecord *b, uint32_t n) {
+    return a.size() == n && memcmp(a.data(), b, n * sizeof(SensorRecord)) == 0;
+}
+
+static int cmdSelftest() {
+    std::vector<SensorRecord> field10, field100, random;
+    fieldRecords(field10, 864000, 10.0f, 1);            // 24 ore a 10Hz
+    fieldRecords(field100, 360000, 100.0f, 2);          // 1 ora a 100Hz
+    randomRecords(random, 200000);
+
+    // CRC a tabella piena = configCrc32 (stesso polinomio, anche a pezzi)
+    {
+        const uint8_t *bytes = (const uint8_t *)random.data();
+        bool same = true;
+        for (size_t len = 0; len < 300; len += 7) {
+            same &= logCrc32(bytes, len) == configCrc32(bytes, len);
+            same &= logCrc32(bytes + len, 50, logCrc32(bytes, len)) == configCrc32(bytes, len + 50);
+        }
+        check(same, "logCrc32 = configCrc32");
+    }
+
+    // Round-trip esatto
+    std::vector<uint8_t> data;
+    std::vector<uint64_t> offsets;
+    std::vector<SensorRecord> out(field10.size());
+    encodeBlocks(field10, 50, data, &offsets);
+    check(decodeBlocks(data, out) == field10.size() && sameRecords(field10, out.data(), field10.size()),
+          "10Hz: round-trip esatto");
+    std::vector<uint8_t> data100;
+    out.assign(field100.size(), SensorRecord());
+    encodeBlocks(field100, UINT32_MAX, data100);
+    check(decodeBlocks(data100, out) == field100.size() && sameRecords(field100, out.data(), field100.size()),
+          "100Hz: round-trip esatto");
+
+    std::vector<uint8_t> dataRandom;
+    std::vector<uint64_t> offsetsRandom;
+    out.assign(random.size(), SensorRecord());
+    encodeBlocks(random, UINT32_MAX, dataRandom, &offsetsRandom);
+    bool bounded = true;
+    for (size_t b = 0; b < offsetsRandom.size(); b++) {
+        LogBlockHeader h;
+        memcpy(&h, dataRandom.data() + offsetsRandom[b], sizeof(h));
+        bounded &= h.payload_bytes <= (uint32_t)h.records * LOG_CODEC_MAX_RECORD_BYTES;
+    }
+    printf("    valori casuali: %.2f B/record (massimo %u)\n", (double)dataRandom.size() / random.size(),
+           LOG_CODEC_MAX_RECORD_BYTES);
+    check(decodeBlocks(dataRandom, out) == random.size() && sameRecords(random, out.data(), random.size()),
+          "valori su tutto il range (wrap, salti indietro): round-trip esatto");
+    check(bounded, "payload entro LOG_CODEC_MAX_RECORD_BYTES per record");
+
+    // Blocchi indipendenti: ognuno decodificato da solo, copiato altrove
+    {
+        std::mt19937 rng(3);
+        bool alone = true;
+        SensorRecord block[LOG_BLOCK_RECORDS];
+        for (int k = 0; k < 500; k++) {
+            size_t b = rng() % offsets.size();
+            LogBlockHeader h;
+            memcpy(&h, data.data() + offsets[b], sizeof(h));
+            std::vector<uint8_t> copy(data.begin() + offsets[b] + sizeof(h),
+                                      data.begin() + offsets[b] + sizeof(h) + h.payload_bytes);
+            alone &= logBlockCrc(h, copy.data()) == h.crc && logBlockDecode(h, copy.data(), block) &&
+                     memcmp(block, &field10[h.first_record], h.records * sizeof(SensorRecord)) == 0;
+        }
+        check(alone, "ogni blocco si decodifica da solo");
+    }
+
+    // Un bit sbagliato invalida solo il suo blocco
+    {
+        std::mt19937 rng(4);
+        uint32_t detected = 0, trials = 2000, othersOk = 0;
+        for (uint32_t k = 0; k < trials; k++) {
+            size_t b = rng() % offsets.size();
+            uint64_t start = offsets[b];
+            uint64_t end = b + 1 < offsets.size() ? offsets[b + 1] : data.size();
+            uint64_t pos = start + rng() % (end - start);
+            uint8_t bit = 1 << (rng() % 8);
+            data[pos] ^= bit;
+            LogBlockHeader h;
+            memcpy(&h, data.data() + start, sizeof(h));
+            bool valid = logBlockHeaderValid(h) && start + sizeof(h) + h.payload_bytes <= data.size() &&
+                         logBlockCrc(h, data.data() + start + sizeof(h)) == h.crc;
+            if (!valid) detected++;
+            // Il blocco dopo resta leggibile
+            if (b + 1 < offsets.size()) {
+                LogBlockHeader n;
+                memcpy(&n, data.data() + offsets[b + 1], sizeof(n));
+                if (logBlockCrc(n, data.data() + offsets[b + 1] + sizeof(n)) == n.crc) othersOk++;
+            } else {
+                othersOk++;
+            }
+            data[pos] ^= bit;
+        }
+        check(detected == trials, "bit sbagliato rilevato dal CRC del blocco");
+        check(othersOk == trials, "gli altri blocchi restano validi");
+    }
+
+    // Compressione e costo
+    printf("\n");
+    CodecReport r10 = measure(field10, 50, 5);
+    CodecReport r10full = measure(field10, UINT32_MAX, 5);
+    CodecReport r100 = measure(field100, UINT32_MAX, 5);
+    printReport("10Hz, flush ogni 5s:", r10);
+    printReport("10Hz, blocchi pieni:", r10full);
+    printReport("100Hz, blocchi pieni:", r100);
+    printf("    24 ore a 10Hz: %.1f MB a record fissi, %.1f MB a blocchi\n",
+           field10.size() * 32.0 / 1e6, field10.size() * r10.bytesPerRecord / 1e6);
+    check(r10.ratio >= 2.0 && r100.ratio >= 2.0, "compressione almeno 2x sui dati da campo");
+
+    return testSummary();
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "selftest") == 0) return cmdSelftest();
+    if (argc == 3 && strcmp(argv[1], "bench") == 0) return cmdBench(argv[2]);
+    if (argc == 4 && strcmp(argv[1], "unpack") == 0) return cmdConvert(argv[2], argv[3], LOG_FILE_RECORDS);
+    if (argc == 4 && strcmp(argv[1], "pack") == 0) return cmdConvert(argv[2], argv[3], LOG_FILE_BLOCKS);
+    fprintf(stderr,
+            "uso: %s bench <file.rec>\n"
+            "     %s unpack <file.rec> <uscita.rec>\n"
+            "     %s pack <file.rec> <uscita.rec>\n"
+            "     %s selftest\n", argv[0], argv[0], argv[0], argv[0]);
+    return 2;
+}
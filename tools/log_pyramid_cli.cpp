@@ -0,0 +1,731 @@
+// log_pyramid_cli.cpp
+// Lettura host delle sessioni di log su SD (formato in src/log_format.h):
+// informazioni, rendering di una finestra con la stessa pyramidRender() del
+// viewer sul device, ricostruzione di piramide e indice dai record grezzi
+// (per sessioni copiate a metà o registrate con un firmware precedente),
+// catalogo delle sessioni e ricerca per tempo con logFindRecord().
+//
+//   g++ -std=c++17 -O2 -Isrc tools/log_pyramid_cli.cpp -o log_pyramid_cli
+//
+//   log_pyramid_cli info <dir> <sessione>
+//   log_pyramid_cli render <dir> <sessione> <primo> <camp/pixel> [larghezza] [dist|pitch|yaw]
+//   log_pyramid_cli build <dir> <sessione>
+//   log_pyramid_cli catalog <dir> [max]
+//   log_pyramid_cli seek <dir> <sessione> <secondi>
+//   log_pyramid_cli selftest
+//
+// <dir> è la radice della SD montata (es. /media/sd), <sessione> il numero
+// di /log_NNN. render stampa una riga CSV per colonna e su stderr livello,
+// bin letti e tempo; seek stampa il record trovato e le letture fatte.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "log_format.h"
+#include "log_pyramid.h"
+#include "log_codec.h"
+#include "test_check.h"
+
+#define READ_SCRATCH_BINS  256      // Come il viewer: letture a blocchi
+#define IO_RECORDS         32768
+#define CATALOG_CHUNK      8        // Come DATA_LOG_CATALOG_CHUNK
+
+static double millisSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static uint64_t fileSize(FILE *f) {
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    return n > 0 ? (uint64_t)n : 0;
+}
+
+// === SORGENTE SU FILE ===
+// Record (a blocchi o fissi) e indice come sul device, con letture puntuali
+class FileRecords : public LogRecordFile {
+public:
+    uint32_t readRecords(uint64_t offset, void *buf, uint32_t len) override { return readAt(rec, offset, buf, len); }
+    uint32_t readIndex(uint64_t offset, void *buf, uint32_t len) override { return readAt(idx, offset, buf, len); }
+    FILE *rec = NULL;
+    FILE *idx = NULL;
+
+private:
+    static uint32_t readAt(FILE *f, uint64_t offset, void *buf, uint32_t len) {
+        return f && fseek(f, (long)offset, SEEK_SET) == 0 ? (uint32_t)fread(buf, 1, len, f) : 0;
+    }
+};
+
+class FileSource : public PyramidSource {
+public:
+    ~FileSource() { close(); }
+
+    // useIndex = false: come se il .idx mancasse
+    bool open(const char *dir, uint16_t session, bool useIndex = true) {
+        close();
+        char path[512];
+        for (uint8_t l = 0; l <= LOG_PYRAMID_LEVELS; l++) {
+            logFilePath(path, sizeof(path), dir, session, l);
+            files[l] = fopen(path, "rb");
+            counts[l] = 0;
+            if (!files[l]) continue;
+            LogFileHeader h;
+            bool valid = fread(&h, sizeof(h), 1, files[l]) == 1 && h.fanout == LOG_PYRAMID_FANOUT;
+            if (l == 0) {
+                valid = valid && (logHeaderValid(h, LOG_FILE_RECORDS, 0) || logHeaderValid(h, LOG_FILE_BLOCKS, 0)) &&
+                        h.item_bytes == sizeof(SensorRecord);
+            } else {
+                valid = valid && logHeaderValid(h, LOG_FILE_PYRAMID, l) && h.item_bytes == sizeof(PyramidBin);
+            }
+            if (!valid) {
+                fprintf(stderr, "%s: header non valido\n", path);
+                fclose(files[l]);
+                files[l] = NULL;
+                continue;
+            }
+            if (l == 0) header = h;
+            else counts[l] = logItemCount(fileSize(files[l]), sizeof(PyramidBin));
+        }
+        if (!files[0]) return false;
+
+        logIndexPath(path, sizeof(path), dir, session);
+        recs.rec = files[0];
+        recs.idx = useIndex ? fopen(path, "rb") : NULL;
+        recs.begin(header.kind, fileSize(files[0]), recs.idx ? fileSize(recs.idx) : 0, payload, block);
+        counts[0] = recs.records();
+        if (useIndex && header.kind == LOG_FILE_BLOCKS && counts[0] == 0 && fileSize(files[0]) > sizeof(LogFileHeader)) {
+            fprintf(stderr, "sessione %03u: indice dei blocchi mancante, usare build\n", session);
+        }
+        return true;
+    }
+
+    void close() {
+        for (uint8_t l = 0; l <= LOG_PYRAMID_LEVELS; l++) {
+            if (files[l]) fclose(files[l]);
+            files[l] = NULL;
+        }
+        if (recs.idx) fclose(recs.idx);
+        recs.rec = recs.idx = NULL;
+    }
+
+    uint32_t records() override { return counts[0]; }
+    uint32_t bins(uint8_t level) const { return counts[level]; }
+    const LogFileHeader &recordsHeader() const { return header; }
+    FileRecords &recordFile() { return recs; }
+
+    uint32_t read(uint8_t level, uint32_t first, uint32_t n, PyramidBin *out) override {
+        FILE *f = files[level];
+        if (!f || first >= counts[level]) return 0;
+        if (n > counts[level] - first) n = counts[level] - first;
+        if (level == 0) {
+            static SensorRecord buf[READ_SCRATCH_BINS];
+            uint32_t got = 0;
+            while (got < n) {
+                uint32_t want = n - got < READ_SCRATCH_BINS ? n - got : READ_SCRATCH_BINS;
+                uint32_t k = recs.read(first + got, want, buf);
+                for (uint32_t i = 0; i < k; i++) pyramidBinFromRecord(buf[i], out[got + i]);
+                got += k;
+                if (k < want) break;
+            }
+            return got;
+        }
+        fseek(f, sizeof(LogFileHeader) + (uint64_t)first * sizeof(PyramidBin), SEEK_SET);
+        return (uint32_t)fread(out, sizeof(PyramidBin), n, f);
+    }
+
+private:
+    FILE *files[LOG_PYRAMID_LEVELS + 1] = {};
+    uint32_t counts[LOG_PYRAMID_LEVELS + 1] = {};
+    LogFileHeader header = {};
+    FileRecords recs;
+    uint8_t payload[LOG_BLOCK_MAX_PAYLOAD];
+    SensorRecord block[LOG_BLOCK_RECORDS];
+};
+
+// === SCRITTURA PIRAMIDE ===
+class FileLevelSink : public PyramidSink {
+public:
+    bool append(uint8_t level, const PyramidBin &bin) override {
+        return fwrite(&bin, sizeof(bin), 1, files[level - 1]) == 1;
+    }
+    FILE *files[LOG_PYRAMID_LEVELS] = {};
+};
+
+// Livelli 1..5 e indice sparso dai record grezzi, sovrascritti
+static bool buildPyramid(const char *dir, uint16_t session, uint32_t &records) {
+    char path[512];
+    logFilePath(path, sizeof(path), dir, session, 0);
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return false;
+    }
+    LogFileHeader h;
+    if (fread(&h, sizeof(h), 1, in) != 1 ||
+        !(logHeaderValid(h, LOG_FILE_RECORDS, 0) || logHeaderValid(h, LOG_FILE_BLOCKS, 0)) ||
+        h.item_bytes != sizeof(SensorRecord)) {
+        fprintf(stderr, "%s: non è un log di record\n", path);
+        fclose(in);
+        return false;
+    }
+
+    FileLevelSink sink;
+    bool ok = true;
+    for (uint8_t l = 1; l <= LOG_PYRAMID_LEVELS && ok; l++) {
+        logFilePath(path, sizeof(path), dir, session, l);
+        sink.files[l - 1] = fopen(path, "wb");
+        LogFileHeader ph;
+        logHeaderInit(ph, LOG_FILE_PYRAMID, l, LOG_PYRAMID_FANOUT, sizeof(PyramidBin), session, h.start_us);
+        ok = sink.files[l - 1] && fwrite(&ph, sizeof(ph), 1, sink.files[l - 1]) == 1;
+    }
+    logIndexPath(path, sizeof(path), dir, session);
+    FILE *idx = fopen(path, "wb");
+    LogFileHeader ih;
+    logHeaderInit(ih, LOG_FILE_INDEX, 0, LOG_PYRAMID_FANOUT, sizeof(LogIndexEntry), session, h.start_us);
+    ok = ok && idx && fwrite(&ih, sizeof(ih), 1, idx) == 1;
+
+    PyramidBuilder builder;
+    builder.begin();
+    if (h.kind == LOG_FILE_RECORDS) {
+        std::vector<SensorRecord> buf(IO_RECORDS);
+        size_t n;
+        while (ok && (n = fread(buf.data(), sizeof(SensorRecord), buf.size(), in)) > 0) {
+            for (size_t i = 0; i < n && ok; i++) {
+                uint32_t record = builder.recordCount();
+                if (record % LOG_INDEX_STRIDE == 0) {
+                    LogIndexEntry e;
+                    logIndexEntryInit(e, record, buf[i].timestamp_us);
+                    ok = fwrite(&e, sizeof(e), 1, idx) == 1;
+                }
+                ok = ok && builder.add(buf[i], sink);
+            }
+        }
+    } else {
+        // Blocchi in fila fino al primo troncato o rovinato (coda dopo un reset)
+        static uint8_t payload[LOG_BLOCK_MAX_PAYLOAD];
+        static SensorRecord block[LOG_BLOCK_RECORDS];
+        LogBlockHeader bh;
+        uint64_t offset = sizeof(LogFileHeader);
+        auto readAt = [&](uint64_t at, void *buf, uint32_t len) {
+            return fseek(in, (long)at, SEEK_SET) == 0 ? (uint32_t)fread(buf, 1, len, in) : 0u;
+        };
+        while (ok && logBlockLoad(readAt, offset, bh, payload) && bh.first_record == builder.recordCount() &&
+               logBlockDecode(bh, payload, block)) {
+            LogIndexEntry e = {block[0].timestamp_us, bh.first_record, (uint32_t)offset};
+            ok = fwrite(&e, sizeof(e), 1, idx) == 1;
+            for (uint16_t i = 0; i < bh.records && ok; i++) ok = builder.add(block[i], sink);
+            offset += sizeof(bh) + bh.payload_bytes;
+        }
+    }
+    ok = ok && builder.finish(sink);
+    records = builder.recordCount();
+
+    fclose(in);
+    if (idx) ok &= fclose(idx) == 0;
+    for (uint8_t l = 0; l < LOG_PYRAMID_LEVELS; l++) {
+        if (sink.files[l]) ok &= fclose(sink.files[l]) == 0;
+    }
+    return ok;
+}
+
+// === CATALOGO E INDICE ===
+// Come readLogCatalog() sul device: dalla coda a blocchi, la prima voce di
+// ogni sessione vince
+static uint16_t readCatalog(const char *dir, LogCatalogEntry *out, uint16_t max, uint32_t *reads = NULL) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", dir, LOG_CATALOG_PATH);
+    FILE *f = fopen(path, "rb");
+    if (reads) *reads = 0;
+    if (!f || max == 0) {
+        if (f) fclose(f);
+        return 0;
+    }
+    LogCatalogEntry chunk[CATALOG_CHUNK];
+    uint32_t remaining = logItemCount(fileSize(f), sizeof(LogCatalogEntry));
+    uint16_t count = 0;
+    bool more = true;
+    while (remaining > 0 && more) {
+        uint32_t n = remaining < CATALOG_CHUNK ? remaining : CATALOG_CHUNK;
+        remaining -= n;
+        fseek(f, sizeof(LogFileHeader) + (uint64_t)remaining * sizeof(LogCatalogEntry), SEEK_SET);
+        if (reads) (*reads)++;
+        if (fread(chunk, sizeof(LogCatalogEntry), n, f) != n) break;
+        for (int32_t i = (int32_t)n - 1; i >= 0 && more; i--) {
+            more = logCatalogCollect(out, count, max, chunk[i]);
+        }
+    }
+    fclose(f);
+    return count;
+}
+
+// === COMANDI ===
+static int cmdInfo(const char *dir, uint16_t session) {
+    FileSource src;
+    if (!src.open(dir, session)) {
+        fprintf(stderr, "sessione %03u non trovata in %s\n", session, dir);
+        return 1;
+    }
+    const LogFileHeader &h = src.recordsHeader();
+    printf("Sessione %03u: %u record, avvio a %.3f s di uptime\n", session, src.records(), h.start_us / 1e6);
+    for (uint8_t l = 1; l <= LOG_PYRAMID_LEVELS; l++) {
+        uint32_t span = pyramidSpan(l);
+        uint32_t expected = (src.records() + span - 1) / span;
+        printf("  L%u  %6u record/bin  %8u bin%s\n", l, span, src.bins(l),
+               src.bins(l) == expected ? "" : "  (incompleto: usare build)");
+    }
+    return 0;
+}
+
+static int cmdRender(const char *dir, uint16_t session, uint32_t first, uint32_t spp,
+                     uint16_t width, uint8_t channel) {
+    FileSource src;
+    if (!src.open(dir, session)) {
+        fprintf(stderr, "sessione %03u non trovata in %s\n", session, dir);
+        return 1;
+    }
+    std::vector<PyramidBin> columns(width), scratch(READ_SCRATCH_BINS);
+    PyramidRenderStats st;
+    auto t0 = std::chrono::steady_clock::now();
+    pyramidRender(src, first, spp, width, columns.data(), scratch.data(), scratch.size(), st);
+    double ms = millisSince(t0);
+
+    float scale = channel == LOG_CH_DISTANCE ? 1.0f / RECORD_UM_PER_MM : 1.0f / RECORD_CDEG_PER_DEG;
+    printf("colonna,primo_record,campioni,min,max,media\n");
+    for (uint16_t c = 0; c < width; c++) {
+        const PyramidBin &b = columns[c];
+        printf("%u,%llu,%u", c, (unsigned long long)first + (uint64_t)c * spp, b.count);
+        if (b.count) printf(",%.3f,%.3f,%.3f\n", b.min[channel] * scale, b.max[channel] * scale, b.mean[channel] * scale);
+        else printf(",,,\n");
+    }
+    fprintf(stderr, "livello %u, %u bin in %u letture, %.2f ms\n", st.level, st.bins, st.reads, ms);
+    return 0;
+}
+
+static int cmdCatalog(const char *dir, uint16_t max) {
+    static const char *states[] = {"interrotta", "ok", "errore"};
+    std::vector<LogCatalogEntry> list(max);
+    uint32_t reads;
+    uint16_t n = readCatalog(dir, list.data(), max, &reads);
+    printf("sessione,stato,inizio_s,durata_s,record,validi,persi,dist_min_mm,dist_max_mm,dist_media_mm,"
+           "pitch_min,pitch_max,config_crc,schema\n");
+    for (uint16_t i = 0; i < n; i++) {
+        const LogCatalogEntry &e = list[i];
+        double duration = e.end_us > e.start_us ? (e.end_us - e.start_us) / 1e6 : 0.0;
+        printf("%u,%s,%.3f,%.3f,%u,%u,%u,%.3f,%.3f,%.3f,%.2f,%.2f,%08X,%u\n", e.session,
+               e.state <= LOG_SESSION_FAILED ? states[e.state] : "?", e.start_us / 1e6, duration,
+               e.records, e.valid, e.dropped, e.dist_min_um / 1000.0, e.dist_max_um / 1000.0,
+               e.dist_mean_um / 1000.0, e.pitch_min_cdeg / 100.0, e.pitch_max_cdeg / 100.0,
+               e.config_crc, e.config_schema);
+    }
+    fprintf(stderr, "%u sessioni, %u letture\n", n, reads);
+    return 0;
+}
+
+static int cmdSeek(const char *dir, uint16_t session, double seconds) {
+    FileSource src;
+    if (!src.open(dir, session)) {
+        fprintf(stderr, "sessione %03u non trovata in %s\n", session, dir);
+        return 1;
+    }
+    uint64_t t = src.recordsHeader().start_us + (uint64_t)(seconds * 1e6);
+    FileRecords &recs = src.recordFile();
+    recs.reads = 0;
+    uint32_t index = recs.find(t);
+    uint32_t reads = recs.reads;
+    SensorRecord r;
+    if (recs.read(index, 1, &r) == 1) {
+        printf("record %u: t=%.6f s, %.3f mm, pitch %.2f, yaw %.2f%s\n", index,
+               (r.timestamp_us - src.recordsHeader().start_us) / 1e6, r.distanceMm(),
+               r.pitch_cdeg / 100.0, r.yaw_cdeg / 100.0, r.radarValid() && r.imuValid() ? "" : " (non valido)");
+    } else {
+        printf("oltre la fine (%u record)\n", src.records());
+    }
+    fprintf(stderr, "%u letture\n", reads);
+    return 0;
+}
+
+// === SELFTEST ===
+// Sessione sintetica: distanza sinusoidale con rumore, pitch a rampa, yaw
+// che gira più volte attraverso 0/360, buchi di validità
+static void syntheticRecords(std::vector<SensorRecord> &recs, uint32_t n) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 2.0f);
+    recs.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        SensorData d = {};
+        d.timestamp_us = 1000000ull + (uint64_t)i * 100000;
+        d.distance_mm = 1500.0f + 400.0f * sinf(i * 0.0007f) + noise(rng);
+        d.filtered_distance_mm = d.distance_mm;
+        d.pitch_deg = -30.0f + 60.0f * (float)(i % 50000) / 50000.0f;
+        d.yaw_deg = fmodf(i * 0.37f, 360.0f);
+        d.radar_valid = (i / 1000) % 17 != 5;      // Buchi di 1000 campioni
+        d.imu_valid = i % 101 != 0;
+        packSensorRecord(d, recs[i]);
+    }
+}
+
+struct BruteBin {
+    int64_t sum[LOG_PYRAMID_CHANNELS];
+    int32_t min[LOG_PYRAMID_CHANNELS];
+    int32_t max[LOG_PYRAMID_CHANNELS];
+    uint32_t count;
+};
+
+// Colonne calcolate direttamente dai record, stessa assegnazione per bin
+static bool compareRender(FileSource &src, const std::vector<SensorRecord> &recs,
+                          const std::vector<int32_t> &yaw, uint32_t first, uint32_t spp,
+                          uint16_t width, PyramidRenderStats &st) {
+    std::vector<PyramidBin> columns(width), scratch(READ_SCRATCH_BINS);
+    pyramidRender(src, first, spp, width, columns.data(), scratch.data(), scratch.size(), st);
+
+    uint32_t span = pyramidSpan(st.level);
+    std::vector<BruteBin> ref(width);
+    memset(ref.data(), 0, sizeof(BruteBin) * width);
+    uint64_t end = std::min<uint64_t>((uint64_t)first + (uint64_t)spp * width, recs.size());
+    uint64_t s0 = (uint64_t)(first / span) * span;
+    uint64_t s1 = std::min<uint64_t>((end + span - 1) / span * span, recs.size());
+    for (uint64_t s = s0; s < s1; s++) {
+        const SensorRecord &r = recs[s];
+        if (!r.radarValid() || !r.imuValid()) continue;
+        uint64_t start = s / span * span;
+        uint32_t col = start <= first ? 0 : (uint32_t)((start - first) / spp);
+        if (col >= width) continue;
+        int32_t v[LOG_PYRAMID_CHANNELS] = {r.distance_um, r.pitch_cdeg, yaw[s]};
+        BruteBin &b = ref[col];
+        for (uint8_t c = 0; c < LOG_PYRAMID_CHANNELS; c++) {
+            if (!b.count || v[c] < b.min[c]) b.min[c] = v[c];
+            if (!b.count || v[c] > b.max[c]) b.max[c] = v[c];
+            b.sum[c] += v[c];
+        }
+        b.count++;
+    }
+
+    bool ok = true;
+    for (uint16_t col = 0; col < width; col++) {
+        const PyramidBin &p = columns[col];
+        const BruteBin &b = ref[col];
+        ok &= p.count == b.count;
+        if (!b.count) continue;
+        for (uint8_t c = 0; c < LOG_PYRAMID_CHANNELS; c++) {
+            double mean = (double)b.sum[c] / b.count;
+            ok &= p.min[c] == b.min[c] && p.max[c] == b.max[c] && fabs(p.mean[c] - mean) <= 1.0;
+        }
+    }
+    return ok;
+}
+
+// Catalogo: 300 sessioni (OPEN e poi CLOSED), una interrotta, una voce
+// corrotta e una scritta a metà in coda
+static void catalogSelftest(const char *dir) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", dir, LOG_CATALOG_PATH);
+    FILE *f = fopen(path, "wb");
+    LogFileHeader h;
+    logHeaderInit(h, LOG_FILE_CATALOG, 0, LOG_PYRAMID_FANOUT, sizeof(LogCatalogEntry), 0, 0);
+    bool wrote = f && fwrite(&h, sizeof(h), 1, f) == 1;
+    const uint16_t sessions = 300;
+    for (uint16_t s = 0; s < sessions && wrote; s++) {
+        LogCatalogEntry e = {};
+        e.session = s;
+        e.state = LOG_SESSION_OPEN;
+        e.start_us = (uint64_t)s * 3600000000ull;
+        logCatalogSeal(e);
+        wrote = fwrite(&e, sizeof(e), 1, f) == 1;
+        if (s == 150 || s == sessions - 1) continue;        // Interrotte da un reset
+        e.state = s % 50 == 7 ? LOG_SESSION_FAILED : LOG_SESSION_CLOSED;
+        e.end_us = e.start_us + 60000000;
+        e.records = 600;
+        e.dist_min_um = 1000000 + s;
+        logCatalogSeal(e);
+        wrote = wrote && fwrite(&e, sizeof(e), 1, f) == 1;
+    }
+    LogCatalogEntry bad = {};
+    bad.session = sessions;
+    logCatalogSeal(bad);
+    bad.records = 1;                                        // CRC non più valido
+    wrote = wrote && fwrite(&bad, sizeof(bad), 1, f) == 1 && fwrite(&bad, 1, 40, f) == 40;
+    if (f) fclose(f);
+    check(wrote, "catalogo sintetico scritto");
+
+    LogCatalogEntry list[sessions];
+    uint32_t reads;
+    uint16_t n = readCatalog(dir, list, 6, &reads);
+    bool latest = n == 6;
+    for (uint16_t i = 0; i < n; i++) latest &= list[i].session == sessions - 1 - i;
+    latest = latest && list[0].state == LOG_SESSION_OPEN && list[1].state == LOG_SESSION_CLOSED &&
+             list[1].dist_min_um == 1000000 + sessions - 2;
+    printf("    ultime 6 di %u sessioni in %u letture\n", sessions, reads);
+    check(latest, "ultime sessioni dalla coda, voci corrotte e parziali scartate");
+    check(reads <= 3, "elenco a costo costante (non dipende dalle sessioni)");
+
+    n = readCatalog(dir, list, sessions, &reads);
+    bool all = n == sessions;
+    for (uint16_t i = 0; i < n && all; i++) {
+        uint16_t s = list[i].session;
+        uint8_t state = s == 150 || s == sessions - 1 ? LOG_SESSION_OPEN
+                      : s % 50 == 7 ? LOG_SESSION_FAILED : LOG_SESSION_CLOSED;
+        all &= s == sessions - 1 - i && list[i].state == state;
+    }
+    check(all, "una voce per sessione, stato dell'ultima voce");
+    remove(path);
+}
+
+// Ricerca per tempo con e senza indice contro lower_bound sull'intero vettore
+static void checkSeek(const char *dir, uint16_t session, const std::vector<SensorRecord> &recs,
+                      const char *label, uint32_t readLimit) {
+    const uint32_t N = recs.size();
+    FileSource indexed, plain;
+    bool opened = indexed.open(dir, session) && plain.open(dir, session, false);
+    std::mt19937 rng(11);
+    uint64_t tFirst = recs.front().timestamp_us, tLast = recs.back().timestamp_us;
+    std::uniform_int_distribution<uint64_t> anyTime(tFirst - 1000000, tLast + 1000000);
+    std::uniform_int_distribution<uint32_t> anyRecord(0, N - 1);
+    bool same = opened, sameScan = opened;
+    uint32_t maxReads = 0, maxScanReads = 0;
+    const int seeks = 3000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < seeks && opened; i++) {
+        // Tempi qualsiasi, esatti e a cavallo delle voci di indice
+        uint64_t t = i % 3 == 0 ? anyTime(rng)
+                   : i % 3 == 1 ? recs[anyRecord(rng)].timestamp_us
+                   : recs[(anyRecord(rng) / LOG_INDEX_STRIDE) * LOG_INDEX_STRIDE].timestamp_us + (i % 2);
+        uint32_t expected = (uint32_t)(std::lower_bound(recs.begin(), recs.end(), t,
+            [](const SensorRecord &r, uint64_t v) { return r.timestamp_us < v; }) - recs.begin());
+        FileRecords &a = indexed.recordFile();
+        a.reads = 0;
+        same &= a.find(t) == expected;
+        if (a.reads > maxReads) maxReads = a.reads;
+        if (i < 200 && indexed.recordsHeader().kind == LOG_FILE_RECORDS) {
+            FileRecords &b = plain.recordFile();
+            b.reads = 0;
+            sameScan &= b.find(t) == expected;
+            if (b.reads > maxScanReads) maxScanReads = b.reads;
+        }
+    }
+    double ms = millisSince(t0);
+    char name[96];
+    printf("    %s: %d ricerche, max %u letture con indice, %u senza, %.1f us/ricerca\n",
+           label, seeks, maxReads, maxScanReads, ms * 1000.0 / seeks);
+    snprintf(name, sizeof(name), "%s: ricerca con indice = lower_bound sui record", label);
+    check(same, name);
+    if (indexed.recordsHeader().kind == LOG_FILE_RECORDS) {
+        snprintf(name, sizeof(name), "%s: ricerca senza indice = lower_bound sui record", label);
+        check(sameScan, name);
+    } else {
+        snprintf(name, sizeof(name), "%s: senza indice nessun record (build lo ricostruisce)", label);
+        check(plain.records() == 0, name);
+    }
+    snprintf(name, sizeof(name), "%s: letture per ricerca O(log n)", label);
+    check(maxReads <= readLimit, name);
+}
+
+// Sessione a blocchi compressi come la scrive il logger: un blocco chiuso
+// ogni LOG_BLOCK_RECORDS record o a ogni flush (flushEvery record)
+static bool writeBlockSession(const char *dir, uint16_t session, const std::vector<SensorRecord> &recs,
+                              uint32_t flushEvery, uint64_t &bytes) {
+    char path[512];
+    logFilePath(path, sizeof(path), dir, session, 0);
+    FILE *f = fopen(path, "wb");
+    LogFileHeader h;
+    logHeaderInit(h, LOG_FILE_BLOCKS, 0, LOG_PYRAMID_FANOUT, sizeof(SensorRecord), session, 1000000);
+    bool ok = f && fwrite(&h, sizeof(h), 1, f) == 1;
+    static LogBlockEncoder encoder;
+    encoder.begin(0);
+    bytes = sizeof(h);
+    for (uint32_t i = 0; i < recs.size() && ok; i++) {
+        bool full = encoder.add(recs[i]);
+        if (full || (i + 1) % flushEvery == 0 || i + 1 == recs.size()) {
+            uint32_t n = encoder.seal();
+            ok = fwrite(encoder.data(), 1, n, f) == n;
+            bytes += n;
+            encoder.begin(i + 1);
+        }
+    }
+    if (f) ok &= fclose(f) == 0;
+    return ok;
+}
+
+static int cmdSelftest() {
+    const char *dir = "/tmp";
+    const uint16_t session = 997;
+    const uint32_t N = 1000003;             // ~28 ore a 10Hz, non multiplo del fanout
+    char path[512];
+
+    std::vector<SensorRecord> recs;
+    syntheticRecords(recs, N);
+
+    // Yaw srotolato di riferimento (solo campioni validi, come il builder)
+    std::vector<int32_t> yaw(N, 0);
+    bool have = false;
+    int32_t prev = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        if (!recs[i].radarValid() || !recs[i].imuValid()) continue;
+        prev = have ? pyramidUnwrapYaw(recs[i].yaw_cdeg, prev) : recs[i].yaw_cdeg;
+        yaw[i] = prev;
+        have = true;
+    }
+
+    logFilePath(path, sizeof(path), dir, session, 0);
+    FILE *f = fopen(path, "wb");
+    LogFileHeader h;
+    logHeaderInit(h, LOG_FILE_RECORDS, 0, LOG_PYRAMID_FANOUT, sizeof(SensorRecord), session, 1000000);
+    bool wrote = f && fwrite(&h, sizeof(h), 1, f) == 1 &&
+                 fwrite(recs.data(), sizeof(SensorRecord), N, f) == N;
+    if (f) fclose(f);
+    check(wrote, "log sintetico scritto");
+
+    // Costruzione incrementale: costo per record
+    uint32_t built = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = buildPyramid(dir, session, built);
+    double ms = millisSince(t0);
+    printf("    piramide di %u record in %.1f ms (%.0f ns/record, I/O compreso)\n", built, ms, ms * 1e6 / N);
+    check(ok && built == N, "piramide costruita dai record");
+
+    FileSource src;
+    ok = src.open(dir, session);
+    bool counts = ok;
+    for (uint8_t l = 1; l <= LOG_PYRAMID_LEVELS; l++) {
+        counts &= src.bins(l) == (N + pyramidSpan(l) - 1) / pyramidSpan(l);
+    }
+    check(counts, "bin per livello = ceil(record / 8^L)");
+
+    checkSeek(dir, session, recs, "record fissi", 13 + 8 + 2);   // log2(voci) + log2(passo) + 2
+
+    // Finestre a ogni zoom: confronto con il calcolo diretto e limite di letture
+    struct View { uint32_t first, spp; };
+    const View views[] = {
+        {0, 1}, {123457, 1}, {5000, 3}, {77777, 8}, {99991, 37}, {300001, 64},
+        {12345, 511}, {0, 4096}, {250000, 1000}, {0, (N + 239) / 240}, {N - 100, 1}, {N - 5000, 64}
+    };
+    bool allOk = true, bounded = true;
+    for (const View &v : views) {
+        PyramidRenderStats st;
+        bool same = compareRender(src, recs, yaw, v.first, v.spp, 240, st);
+        bounded &= st.bins <= 240u * LOG_PYRAMID_FANOUT + 2;
+        printf("    primo %7u, %6u camp/pixel -> L%u, %5u bin, %3u letture %s\n",
+               v.first, v.spp, st.level, st.bins, st.reads, same ? "" : "DIVERSO");
+        allOk &= same;
+    }
+    check(allOk, "colonne = min/max/media calcolati dai record (yaw srotolato)");
+    check(bounded, "al più larghezza x fanout bin letti per vista");
+
+    // Vista intera ripetuta: costo indipendente dalla durata
+    {
+        std::vector<PyramidBin> columns(240), scratch(READ_SCRATCH_BINS);
+        PyramidRenderStats st;
+        const int reps = 200;
+        t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) {
+            pyramidRender(src, (i * 7919) % (N / 2), (N / 2 + 239) / 240, 240,
+                          columns.data(), scratch.data(), scratch.size(), st);
+        }
+        double per = millisSince(t0) / reps;
+        printf("    vista di %u record: %.3f ms (host, file in cache), %u bin\n", N / 2, per, st.bins);
+        check(per < 20.0, "zoom e pan interattivi");
+    }
+
+    // Sessione interrotta: coda parziale ignorata
+    src.close();
+    logFilePath(path, sizeof(path), dir, session, 1);
+    f = fopen(path, "r+b");
+    uint64_t size = f ? fileSize(f) : 0;
+    if (f) fclose(f);
+    if (size > 20) {
+        FILE *t = fopen(path, "r+b");
+        std::vector<uint8_t> data(size);
+        size_t rd = t ? fread(data.data(), 1, size, t) : 0;
+        if (t) fclose(t);
+        t = fopen(path, "wb");
+        if (t) {
+            fwrite(data.data(), 1, rd - 20, t);
+            fclose(t);
+        }
+    }
+    src.open(dir, session);
+    check(src.bins(1) == (N + 7) / 8 - 1, "bin troncato a metà scartato");
+    src.close();
+
+    // Stessa sessione a blocchi compressi: build rifà indice e piramide,
+    // viewer e ricerca leggono i record decodificando un blocco alla volta
+    {
+        uint64_t bytes = 0;
+        bool wrote = writeBlockSession(dir, session, recs, 50, bytes);   // Flush ogni 5s a 10Hz
+        printf("    blocchi: %.2f byte/record (%.2fx sui record fissi)\n",
+               (double)bytes / N, (double)N * sizeof(SensorRecord) / bytes);
+        t0 = std::chrono::steady_clock::now();
+        ok = wrote && buildPyramid(dir, session, built) && built == N;
+        printf("    piramide e indice dai blocchi in %.1f ms\n", millisSince(t0));
+        check(ok, "build da record a blocchi");
+        checkSeek(dir, session, recs, "blocchi", 14 + 2 + 2);       // log2(voci) + 2 + blocco
+
+        ok = src.open(dir, session) && src.records() == N;
+        bool same = ok;
+        for (const View &v : views) {
+            PyramidRenderStats st;
+            same &= compareRender(src, recs, yaw, v.first, v.spp, 240, st);
+        }
+        check(same, "blocchi: colonne = calcolo diretto a ogni zoom");
+        src.close();
+
+        // Blocco in coda scritto a metà: si perde solo quello
+        logFilePath(path, sizeof(path), dir, session, 0);
+        f = fopen(path, "r+b");
+        uint64_t size = f ? fileSize(f) : 0;
+        if (f) fclose(f);
+        if (truncate(path, (off_t)size - 10) != 0) size = 0;
+        src.open(dir, session);
+        uint32_t lastBlock = (N - 1) / 50 * 50;
+        check(size > 0 && src.records() == lastBlock, "blocco troncato a metà scartato");
+        src.close();
+    }
+
+    for (uint8_t l = 0; l <= LOG_PYRAMID_LEVELS; l++) {
+        logFilePath(path, sizeof(path), dir, session, l);
+        remove(path);
+    }
+    logIndexPath(path, sizeof(path), dir, session);
+    remove(path);
+
+    catalogSelftest(dir);
+    return testSummary();
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && strcmp(argv[1], "selftest") == 0) return cmdSelftest();
+    if (argc == 4 && strcmp(argv[1], "info") == 0) return cmdInfo(argv[2], (uint16_t)atoi(argv[3]));
+    if (argc == 4 && strcmp(argv[1], "build") == 0) {
+        uint32_t n = 0;
+        if (!buildPyramid(argv[2], (uint16_t)atoi(argv[3]), n)) return 1;
+        fprintf(stderr, "piramide e indice ricostruiti da %u record\n", n);
+        return 0;
+    }
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "catalog") == 0) {
+        return cmdCatalog(argv[2], argc == 4 ? (uint16_t)atoi(argv[3]) : LOG_MAX_SESSIONS);
+    }
+    if (argc == 5 && strcmp(argv[1], "seek") == 0) return cmdSeek(argv[2], (uint16_t)atoi(argv[3]), atof(argv[4]));
+    if ((argc >= 6 && argc <= 8) && strcmp(argv[1], "render") == 0) {
+        uint16_t width = argc >= 7 ? (uint16_t)atoi(argv[6]) : 240;
+        uint8_t channel = LOG_CH_DISTANCE;
+        if (argc == 8) {
+            if (strcmp(argv[7], "pitch") == 0) channel = LOG_CH_PITCH;
+            else if (strcmp(argv[7], "yaw") == 0) channel = LOG_CH_YAW;
+            else if (strcmp(argv[7], "dist") != 0) width = 0;
+        }
+        if (width > 0) {
+            return cmdRender(argv[2], (uint16_t)atoi(argv[3]), (uint32_t)strtoul(argv[4], NULL, 10),
+                             (uint32_t)strtoul(argv[5], NULL, 10), width, channel);
+        }
+    }
+    fprintf(stderr,
+            "uso: %s info <dir> <sessione>\n"
+            "     %s render <dir> <sessione> <primo> <camp/pixel> [larghezza] [dist|pitch|yaw]\n"
+            "     %s build <dir> <sessione>\n"
+            "     %s catalog <dir> [max]\n"
+            "     %s seek <dir> <sessione> <secondi>\n"
+            "     %s selftest\n", argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,159 @@
+// mag_fit_test.cpp
+// Validazione host del fit di ellissoide (src/mag_calibration.h).
+//
+//   g++ -std=c++17 -O2 -Isrc tools/mag_fit_test.cpp -o mag_fit_test
+//   ./mag_fit_test                 dati sintetici con hard/soft iron, rumore e picchi
+//   ./mag_fit_test raw_mag.csv     campioni registrati "x,y,z" in uT (una riga ciascuno)
+//
+// Sui dati sintetici confronta anche con il vecchio metodo min/max.
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <random>
+#include "mag_calibration.h"
+
+// Dispersione del modulo del campo corretto (ideale: costante)
+struct Spread {
+    double sum = 0, sum2 = 0;
+    uint32_t n = 0;
+    void add(double v) { sum += v; sum2 += v * v; n++; }
+    double mean() const { return sum / n; }
+    double rel() const { return sqrt(sum2 / n - mean() * mean()) / mean(); }
+};
+
+static void printResult(const MagFitResult &r) {
+    printf("Campioni %u (scartati %u), copertura %.0f%%\n", r.samples, r.rejected, r.coverage * 100);
+    if (!r.ok) {
+        printf("Fit fallito\n");
+        return;
+    }
+    printf("Offset     %8.2f %8.2f %8.2f uT\n", r.offset[0], r.offset[1], r.offset[2]);
+    for (int i = 0; i < 3; i++) {
+        printf("W[%d]       %8.5f %8.5f %8.5f\n", i, r.soft_iron[i * 3], r.soft_iron[i * 3 + 1], r.soft_iron[i * 3 + 2]);
+    }
+    printf("Campo %.2f uT, residuo %.3f uT\n", r.field_ut, r.residual_ut);
+}
+
+static int runCsv(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    static float data[200000][3];
+    uint32_t n = 0;
+    EllipsoidFit fit;
+    char line[128];
+    while (fgets(line, sizeof(line), f) && n < 200000) {
+        float *v = data[n];
+        if (sscanf(line, "%f,%f,%f", &v[0], &v[1], &v[2]) != 3) continue;
+        fit.add(v[0], v[1], v[2]);
+        n++;
+    }
+    fclose(f);
+
+    MagFitResult r;
+    fit.solve(r);
+    printResult(r);
+    if (!r.ok) return 1;
+
+    Spread s;
+    for (uint32_t i = 0; i < n; i++) {
+        float m[3];
+        magApplyCalibration(data[i], r.offset, r.soft_iron, m);
+        s.add(sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]));
+    }
+    printf("|m| corretto: media %.4f, dispersione %.2f%%\n", s.mean(), s.rel() * 100);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) return runCsv(argv[1]);
+
+    // Campo terrestre 48uT, hard iron e soft iron (scala + accoppiamento assi)
+    const double field = 48.0;
+    const double hard[3] = {22.0, -35.0, 14.0};
+    const double soft[9] = {1.18, 0.09, -0.05,
+                            0.09, 0.86, 0.07,
+                            -0.05, 0.07, 1.03};
+
+    std::mt19937 rng(42);
+    std::normal_distribution<double> noise(0.0, 0.4);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    EllipsoidFit fit;
+    float minV[3] = {1e9f, 1e9f, 1e9f}, maxV[3] = {-1e9f, -1e9f, -1e9f};
+    const int N = 400;
+    static float raw[N][3], truth[N][3];
+
+    // Rotazione lenta a mano (traiettoria continua) con qualche picco
+    for (int i = 0; i < N; i++) {
+        double t = i / (double)N;
+        double az = 2 * M_PI * 3 * t;
+        double el = asin(2 * t - 1);
+        double u[3] = {cos(el) * cos(az), cos(el) * sin(az), sin(el)};
+        for (int k = 0; k < 3; k++) {
+            truth[i][k] = (float)(field * u[k]);
+            double v = hard[k];
+            for (int j = 0; j < 3; j++) v += soft[k * 3 + j] * field * u[j];
+            raw[i][k] = (float)(v + noise(rng));
+        }
+        float sample[3] = {raw[i][0], raw[i][1], raw[i][2]};
+        if (i % 97 == 50) {
+            sample[0] += 180;   // Picco (motore, cavo)
+            sample[2] -= 120;
+        }
+        fit.add(sample[0], sample[1], sample[2]);
+        for (int k = 0; k < 3; k++) {
+            minV[k] = fminf(minV[k], sample[k]);
+            maxV[k] = fmaxf(maxV[k], sample[k]);
+        }
+    }
+
+    MagFitResult r;
+    fit.solve(r);
+    printResult(r);
+
+    // Vecchio metodo: offset = centro del box, scala = semiasse per asse
+    Spread fitSpread, boxSpread;
+    double headingErrFit = 0, headingErrBox = 0;
+    for (int i = 0; i < N; i++) {
+        float m[3], b[3];
+        magApplyCalibration(raw[i], r.offset, r.soft_iron, m);
+        for (int k = 0; k < 3; k++) {
+            b[k] = (raw[i][k] - (minV[k] + maxV[k]) / 2) / ((maxV[k] - minV[k]) / 2);
+        }
+        fitSpread.add(sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]));
+        boxSpread.add(sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]));
+
+        // Errore di heading a livello (sul piano xy)
+        double ht = atan2(truth[i][1], truth[i][0]);
+        double hf = atan2(m[1], m[0]) - ht, hb = atan2(b[1], b[0]) - ht;
+        hf = fabs(atan2(sin(hf), cos(hf))) * 180 / M_PI;
+        hb = fabs(atan2(sin(hb), cos(hb))) * 180 / M_PI;
+        if (fabs(truth[i][2]) < field * 0.5) {
+            headingErrFit = fmax(headingErrFit, hf);
+            headingErrBox = fmax(headingErrBox, hb);
+        }
+    }
+
+    printf("\n=== Confronto (|m| ideale costante) ===\n");
+    printf("Ellissoide  dispersione %.2f%%  heading max %.2f°\n", fitSpread.rel() * 100, headingErrFit);
+    printf("Min/max     dispersione %.2f%%  heading max %.2f°\n", boxSpread.rel() * 100, headingErrBox);
+
+    bool ok = r.ok && r.rejected >= 3 && fitSpread.rel() < 0.02 && headingErrFit < 3.0 &&
+              fabs(r.offset[0] - hard[0]) < 1.5 && fabs(r.offset[1] - hard[1]) < 1.5 &&
+              fabs(r.offset[2] - hard[2]) < 1.5 && r.residual_ut < 1.5 &&
+              fitSpread.rel() < boxSpread.rel();
+
+    // Copertura insufficiente: il fit deve rifiutarsi
+    EllipsoidFit partial;
+    for (int i = 0; i < 100; i++) partial.add(raw[i % 30][0], raw[i % 30][1], raw[i % 30][2]);
+    MagFitResult pr;
+    bool refused = !partial.solve(pr);
+    printf("Copertura parziale %.0f%%: %s\n", pr.coverage * 100, refused ? "rifiutato" : "accettato");
+
+    ok = ok && refused;
+    printf("%s\n", ok ? "✅ PASS" : "❌ FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// measurement_test.cpp
+// Test host della misura su trigger (src/measurement.h): storico sintetico a
+// 10Hz con IMU e radar letti in istanti diversi del ciclo, allineamento
+// degli angoli, yaw attorno a 0/360, stabilità e finestra pre/post trigger.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/measurement_test.cpp -o measurement_test && ./measurement_test
+#include <stdio.h>
+#include <random>
+#include "measurement.h"
+#include "test_check.h"
+
+static const timestamp_us_t T0 = 5000000;
+static const uint32_t PERIOD_US = 100000;
+static const uint32_t IMU_DT_US = 2000;       // Burst IMU a inizio ciclo
+static const uint32_t RADAR_DT_US = 60000;    // Job radar verso fine ciclo
+
+// Verità in funzione del tempo
+struct Scene {
+    float pitchRate;        // gradi/s
+    float yaw0, yawRate;
+    float distance;
+    float distNoise;
+    std::mt19937 rng{42};
+
+    float pitchAt(timestamp_us_t t) const { return 10.0f + pitchRate * (t - T0) / 1e6f; }
+    float yawAt(timestamp_us_t t) const {
+        float y = fmodf(yaw0 + yawRate * (t - T0) / 1e6f, 360.0f);
+        return y < 0 ? y + 360.0f : y;
+    }
+};
+
+static uint16_t buildHistory(Scene &s, SensorRecord *hist, uint16_t n) {
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    for (uint16_t k = 0; k < n; k++) {
+        SensorData d = {};
+        d.timestamp_us = T0 + (timestamp_us_t)k * PERIOD_US;
+        d.imu_timestamp_us = d.timestamp_us + IMU_DT_US;
+        d.radar_timestamp_us = d.timestamp_us + RADAR_DT_US;
+        d.pitch_deg = s.pitchAt(d.imu_timestamp_us);
+        d.yaw_deg = s.yawAt(d.imu_timestamp_us);
+        d.distance_mm = s.distance + s.distNoise * noise(s.rng);
+        d.filtered_distance_mm = d.distance_mm;
+        d.radar_valid = true;
+        d.imu_valid = true;
+        packSensorRecord(d, hist[k]);
+    }
+    return n;
+}
+
+int main() {
+    SensorRecord hist[32];
+    MeasureConfig cfg;
+    MeasureResult r;
+
+    // Allineamento: pitch in rampa, il valore va preso all'istante del radar
+    {
+        Scene s = {};
+        s.pitchRate = 10.0f;            // 1° per ciclo
+        s.yaw0 = 90.0f;
+        s.distance = 800.0f;
+        uint16_t n = buildHistory(s, hist, 20);
+        measureDefaults(cfg);
+        cfg.pre_samples = 1;
+        cfg.max_angle_sd_deg = 100.0f;
+        timestamp_us_t trigger = T0 + 10 * PERIOD_US + 80000;
+        measureCompute(hist, n, trigger, cfg, r);
+        timestamp_us_t tRadar = T0 + 10 * PERIOD_US + RADAR_DT_US;
+        float sameCycle = s.pitchAt(T0 + 10 * PERIOD_US + IMU_DT_US);
+        printf("    pitch %.3f° (verità al radar %.3f°, IMU dello stesso ciclo %.3f°), allineamento %u us\n",
+               r.pitch_deg, s.pitchAt(tRadar), sameCycle, r.max_align_us);
+        check(r.status == MEASURE_OK && r.last_us == tRadar, "ultimo campione prima del trigger");
+        check(fabsf(r.pitch_deg - s.pitchAt(tRadar)) < 0.02f && r.interpolated == 1,
+              "angoli interpolati all'istante del radar");
+    }
+
+    // Yaw attorno a 0/360: la media non deve finire a 180
+    {
+        Scene s = {};
+        s.yaw0 = 359.0f;
+        s.yawRate = 2.0f;               // Attraversa 0 durante la finestra
+        s.distance = 1200.0f;
+        uint16_t n = buildHistory(s, hist, 10);
+        measureDefaults(cfg);
+        timestamp_us_t trigger = T0 + 10 * PERIOD_US;
+        measureCompute(hist, n, trigger, cfg, r);
+        float truth = s.yawAt(T0 + 7 * PERIOD_US + RADAR_DT_US);     // Centro dei 5 campioni
+        printf("    yaw %.3f° (atteso %.3f°), σ %.3f°\n", r.yaw_deg, truth, r.yaw_sd_deg);
+        check(fabsf(measureYawDiff(r.yaw_deg, truth)) < 0.02f && r.yaw_sd_deg < 0.5f,
+              "yaw mediato attraverso 0/360");
+    }
+
+    // Stabilità: rumore radar oltre soglia -> UNSTABLE, sotto -> OK
+    {
+        Scene s = {};
+        s.yaw0 = 45.0f;
+        s.distance = 600.0f;
+        s.distNoise = 20.0f;
+        uint16_t n = buildHistory(s, hist, 20);
+        measureDefaults(cfg);
+        cfg.pre_samples = 10;
+        measureCompute(hist, n, T0 + 20 * PERIOD_US, cfg, r);
+        printf("    σ distanza %.1f mm -> %s\n", r.distance_sd_mm, measureStatusName(r.status));
+        check(r.status == MEASURE_UNSTABLE, "rumore alto: UNSTABLE");
+
+        s.distNoise = 1.0f;
+        n = buildHistory(s, hist, 20);
+        measureCompute(hist, n, T0 + 20 * PERIOD_US, cfg, r);
+        check(r.status == MEASURE_OK && fabsf(r.distance_mm - 600.0f) < 1.0f, "rumore basso: OK e media corretta");
+    }
+
+    // Finestra pre/post: campioni attorno al trigger, niente di troppo vecchio
+    {
+        Scene s = {};
+        s.distance = 500.0f;
+        uint16_t n = buildHistory(s, hist, 20);
+        measureDefaults(cfg);
+        cfg.pre_samples = 3;
+        cfg.post_samples = 2;
+        timestamp_us_t trigger = T0 + 10 * PERIOD_US;
+        measureCompute(hist, n, trigger, cfg, r);
+        check(r.samples == 5 && r.first_us == T0 + 7 * PERIOD_US + RADAR_DT_US &&
+              r.last_us == T0 + 11 * PERIOD_US + RADAR_DT_US, "3 pre + 2 post");
+        check(measureCountPost(hist, 12, trigger) == 2, "conteggio campioni dopo il trigger");
+
+        cfg.post_samples = 0;
+        cfg.pre_samples = 5;
+        measureCompute(hist, n, T0 + 19 * PERIOD_US + RADAR_DT_US + 2 * MEASURE_MAX_AGE_MS * 1000, cfg, r);
+        check(r.status == MEASURE_NO_DATA, "storico troppo vecchio: NO_DATA");
+
+        measureCompute(hist, 3, T0 + 3 * PERIOD_US, cfg, r);
+        check(r.status == MEASURE_PARTIAL && r.samples == 3, "storico corto: PARTIAL");
+    }
+
+    return testSummary();
+}
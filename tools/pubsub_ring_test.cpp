@@ -0,0 +1,136 @@
+// pubsub_ring_test.cpp
+// Test host del ring publish/subscribe (src/pubsub_ring.h): LATEST_ONLY che
+// salta i non letti, LOSSLESS con backpressure (canPublish) e perdita solo
+// a publish forzato, DECIMATED su sequenza, contatori delivered/skipped/
+// dropped/lag/max_lag, subscriber indipendenti sullo stesso buffer.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/pubsub_ring_test.cpp -o pubsub_ring_test && ./pubsub_ring_test
+#include <stdio.h>
+#include "pubsub_ring.h"
+#include "test_check.h"
+
+#define DEPTH   8
+#define SUBS    4
+
+typedef PubSubRing<uint32_t, DEPTH, SUBS> Ring;
+
+// Come PubSubTopic::publish() a timeout scaduto: si scrive comunque
+static void publishRange(Ring &ring, uint32_t from, uint32_t count) {
+    for (uint32_t v = from; v < from + count; v++) ring.publish(v);
+}
+
+int main() {
+    // Subscribe: slot finiti, cursore dal prossimo campione
+    {
+        static Ring ring;
+        ring.publish(100);
+        int8_t a = ring.subscribe(PUBSUB_LOSSLESS);
+        uint32_t v;
+        check(a == 0 && !ring.hasData(a) && !ring.read(a, v), "storico non riconsegnato al nuovo subscriber");
+        for (uint8_t i = 1; i < SUBS; i++) ring.subscribe(PUBSUB_LATEST_ONLY);
+        check(ring.subscribe(PUBSUB_LATEST_ONLY) == -1 && ring.activeMask() == 0x0F, "slot esauriti: -1");
+        ring.unsubscribe(2);
+        check(ring.activeMask() == 0x0B && ring.subscribe(PUBSUB_DECIMATED, 0) == 2 && ring.policy(2) == PUBSUB_DECIMATED,
+              "slot liberato riusato");
+    }
+
+    // LATEST_ONLY: solo il più recente, i superati contano come skipped
+    {
+        static Ring ring;
+        int8_t id = ring.subscribe(PUBSUB_LATEST_ONLY);
+        publishRange(ring, 0, 5);
+        uint32_t v = 0;
+        PubSubSubscriberStats st;
+        ring.getStats(id, st);
+        check(st.lag == 5 && st.max_lag == 5, "lag prima della lettura");
+        check(ring.read(id, v) && v == 4 && !ring.read(id, v), "consegnato solo l'ultimo");
+        ring.getStats(id, st);
+        check(st.delivered == 1 && st.skipped == 4 && st.dropped == 0 && st.lag == 0, "4 superati, nessuna perdita");
+
+        // Sovrascrittura del ring: per LATEST_ONLY non è mai una perdita
+        publishRange(ring, 5, DEPTH * 3);
+        check(ring.canPublish(), "LATEST_ONLY non frena il publisher");
+        check(ring.read(id, v) && v == 5 + DEPTH * 3 - 1, "dopo 3 giri: ultimo valore");
+        ring.getStats(id, st);
+        check(st.delivered == 2 && st.dropped == 0 && st.skipped == 4 + DEPTH * 3 - 1 && st.max_lag == DEPTH,
+              "sovrascritti contati come skipped, lag limitato a DEPTH");
+    }
+
+    // LOSSLESS: tutti in ordine, backpressure a ring pieno, perdita solo se forzata
+    {
+        static Ring ring;
+        int8_t id = ring.subscribe(PUBSUB_LOSSLESS);
+        publishRange(ring, 0, DEPTH - 1);
+        check(ring.canPublish(), "posto per l'ultimo slot");
+        ring.publish(DEPTH - 1);
+        check(!ring.canPublish() && ring.lag(id) == DEPTH, "ring pieno: il publisher deve attendere");
+
+        // Il subscriber legge uno: il publisher riparte
+        uint32_t v;
+        check(ring.read(id, v) && v == 0 && ring.canPublish(), "una lettura libera uno slot");
+        ring.publish(DEPTH);
+
+        // Timeout di blocco scaduto: si scrive lo stesso e il più vecchio è perso
+        check(!ring.canPublish(), "di nuovo pieno");
+        publishRange(ring, DEPTH + 1, 3);
+        PubSubSubscriberStats st;
+        ring.getStats(id, st);
+        check(st.dropped == 3 && st.skipped == 0 && st.lag == DEPTH && st.max_lag == DEPTH,
+              "publish forzato: 3 persi, lag fermo a DEPTH");
+
+        bool inOrder = true;
+        uint32_t expected = 4, n = 0;
+        while (ring.read(id, v)) {
+            inOrder = inOrder && v == expected++;
+            n++;
+        }
+        ring.getStats(id, st);
+        check(inOrder && n == DEPTH && expected == DEPTH + 4, "i restanti consegnati in ordine, dal più vecchio");
+        check(st.delivered == 1 + DEPTH && st.lag == 0 && ring.canPublish(), "contatori dopo lo svuotamento");
+    }
+
+    // DECIMATED: uno ogni N sulla sequenza, scarti non contati come perdite
+    {
+        static Ring ring;
+        int8_t id = ring.subscribe(PUBSUB_DECIMATED, 3);
+        publishRange(ring, 0, 7);       // Sequenze 0..6: volute 0, 3, 6
+        uint32_t v, got[4], n = 0;
+        while (n < 4 && ring.read(id, v)) got[n++] = v;
+        PubSubSubscriberStats st;
+        ring.getStats(id, st);
+        check(n == 3 && got[0] == 0 && got[1] == 3 && got[2] == 6, "consegnate le sequenze multiple di 3");
+        check(st.delivered == 3 && st.skipped == 4 && st.dropped == 0, "4 decimati come skipped");
+        check(ring.canPublish(), "DECIMATED non frena il publisher");
+
+        // Sovrascrittura: perso solo ciò che la decimazione avrebbe consegnato
+        publishRange(ring, 7, DEPTH + 5);       // Sequenze 7..19, sovrascritte 7..11
+        ring.getStats(id, st);
+        check(st.dropped == 1 && st.skipped == 4 + 4 && st.lag == DEPTH, "sovrascritti: 9 perso, 7 8 10 11 scartati");
+        n = 0;
+        while (n < 4 && ring.read(id, v)) got[n++] = v;
+        check(n == 3 && got[0] == 12 && got[1] == 15 && got[2] == 18, "consegna ripresa dal ring: 12, 15, 18");
+    }
+
+    // Subscriber indipendenti sullo stesso buffer; LOSSLESS frena tutti
+    {
+        static Ring ring;
+        int8_t latest = ring.subscribe(PUBSUB_LATEST_ONLY);
+        int8_t all = ring.subscribe(PUBSUB_LOSSLESS);
+        int8_t dec = ring.subscribe(PUBSUB_DECIMATED, 2);
+        publishRange(ring, 0, DEPTH);
+        uint32_t v;
+        check(!ring.canPublish(), "il subscriber LOSSLESS frena il publish comune");
+        check(ring.read(latest, v) && v == DEPTH - 1 && ring.read(dec, v) && v == 0, "letture indipendenti");
+        check(ring.lag(latest) == 0 && ring.lag(dec) == DEPTH - 1 && ring.lag(all) == DEPTH, "lag per subscriber");
+
+        ring.unsubscribe(all);
+        check(ring.canPublish() && ring.activeMask() == 0x05, "senza LOSSLESS il publisher non attende");
+
+        uint32_t hist[DEPTH];
+        publishRange(ring, DEPTH, 2);
+        check(ring.history(hist, DEPTH) == DEPTH && hist[0] == 2 && hist[DEPTH - 1] == DEPTH + 1 &&
+              ring.latest(v) && v == DEPTH + 1, "storico recente in ordine cronologico");
+    }
+
+    return testSummary();
+}
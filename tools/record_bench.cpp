@@ -0,0 +1,182 @@
+// record_bench.cpp
+// Benchmark e test di precisione host per SensorRecord (src/sensor_record.h):
+// dimensioni, costo copia nel ring pub/sub, banda di log e round-trip
+// SensorData -> SensorRecord -> SensorData rispetto a performance-criteria.md.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/record_bench.cpp -o record_bench && ./record_bench
+//
+// Exit code 0 = precisione dentro specifica.
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include "sensor_record.h"
+#include "pubsub_ring.h"
+
+// === SPECIFICHE (performance-criteria.md) ===
+#define SPEC_DISTANCE_MM      1.0f      // Accuratezza distanza ±1mm
+#define SPEC_PITCH_DEG        0.05f     // Accuratezza pitch ±0.05°
+#define SPEC_COORD_MM         1.0f      // Errore coordinate accettabile <1mm
+#define SPEC_MAX_RANGE_MM     3000.0f   // Portata radar considerata
+
+#define BENCH_SAMPLES         200000
+#define BENCH_RATE_HZ         10
+
+static uint32_t rng = 12345;
+static float randf(float lo, float hi) {
+    rng = rng * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((rng >> 8) / 16777216.0f);
+}
+
+static double nowNs() {
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static SensorData makeSample(uint32_t i) {
+    SensorData d = {};
+    d.timestamp_us = 5000000ull + (uint64_t)i * 100000 + (uint64_t)randf(0, 500);
+    d.timestamp_ms = usToMs(d.timestamp_us);
+    d.distance_mm = randf(100.0f, SPEC_MAX_RANGE_MM);
+    d.filtered_distance_mm = d.distance_mm + randf(-2.0f, 2.0f);
+    d.radar_valid = (i % 17) != 0;
+    d.pitch_deg = randf(-90.0f, 90.0f);
+    d.yaw_deg = randf(0.0f, 360.0f);
+    d.roll_deg = randf(-180.0f, 180.0f);
+    d.imu_valid = (i % 23) != 0;
+    setSensorTimestamps(d, d.timestamp_us + (uint64_t)randf(2000, 9000),
+                        (i % 31) ? d.timestamp_us + (uint64_t)randf(8000, 14000) : 0);
+    if (d.radar_valid && d.imu_valid) calculateCoordinates(d);
+    return d;
+}
+
+// === PRECISIONE ===
+static bool precisionTest() {
+    float maxDist = 0, maxAngle = 0, maxCoord = 0;
+    uint32_t timeErrors = 0, flagErrors = 0;
+
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        SensorData in = makeSample(i), out;
+        SensorRecord r;
+        packSensorRecord(in, r);
+        unpackSensorRecord(r, out);
+
+        maxDist = fmaxf(maxDist, fabsf(out.distance_mm - in.distance_mm));
+        maxDist = fmaxf(maxDist, fabsf(out.filtered_distance_mm - in.filtered_distance_mm));
+        maxAngle = fmaxf(maxAngle, fabsf(out.pitch_deg - in.pitch_deg));
+        maxAngle = fmaxf(maxAngle, fabsf(out.roll_deg - in.roll_deg));
+        float dyaw = fabsf(out.yaw_deg - in.yaw_deg);
+        maxAngle = fmaxf(maxAngle, fminf(dyaw, 360.0f - dyaw));
+
+        if (in.radar_valid && in.imu_valid) {
+            maxCoord = fmaxf(maxCoord, fabsf(out.x_mm - in.x_mm));
+            maxCoord = fmaxf(maxCoord, fabsf(out.y_mm - in.y_mm));
+            maxCoord = fmaxf(maxCoord, fabsf(out.z_mm - in.z_mm));
+        }
+
+        if (out.timestamp_us != in.timestamp_us || out.timestamp_ms != in.timestamp_ms ||
+            out.radar_timestamp_us != in.radar_timestamp_us ||
+            out.imu_timestamp_us != in.imu_timestamp_us ||
+            out.sync_delta_us != in.sync_delta_us || out.sync_delta_ms != in.sync_delta_ms ||
+            r.syncDeltaUs() != in.sync_delta_us) {
+            timeErrors++;
+        }
+        if (out.radar_valid != in.radar_valid || out.imu_valid != in.imu_valid) flagErrors++;
+    }
+
+    // Bordi: yaw vicino a 360°, valori fuori range saturati
+    SensorData edge = {}, back;
+    SensorRecord r;
+    edge.yaw_deg = 359.996f;
+    edge.pitch_deg = 1000.0f;
+    packSensorRecord(edge, r);
+    unpackSensorRecord(r, back);
+    bool edgeOk = r.yaw_cdeg == 0 && r.pitch_cdeg == INT16_MAX;
+
+    // Errore teorico coordinate: mezzo LSB angolare alla portata massima
+    float coordBound = SPEC_MAX_RANGE_MM * 0.005f * (float)SYNC_DEG_TO_RAD * 2.0f;
+
+    bool ok = maxDist <= SPEC_DISTANCE_MM / 100 && maxAngle <= SPEC_PITCH_DEG / 5 &&
+              maxCoord <= coordBound && coordBound < SPEC_COORD_MM &&
+              timeErrors == 0 && flagErrors == 0 && edgeOk;
+
+    printf("\n=== Precisione round-trip (%d campioni) ===\n", BENCH_SAMPLES);
+    printf("Distanza  max %.4fmm   (spec ±%.2fmm)\n", maxDist, SPEC_DISTANCE_MM);
+    printf("Angoli    max %.4f°    (spec pitch ±%.2f°)\n", maxAngle, SPEC_PITCH_DEG);
+    printf("Coord     max %.4fmm   (limite %.3fmm @%.0fmm, spec <%.1fmm)\n",
+           maxCoord, coordBound, SPEC_MAX_RANGE_MM, SPEC_COORD_MM);
+    printf("Tempi     %u errori, flag %u errori, bordi %s\n",
+           timeErrors, flagErrors, edgeOk ? "OK" : "KO");
+    printf("%s\n", ok ? "✅ PASS" : "❌ FAIL");
+    return ok;
+}
+
+// === THROUGHPUT ===
+template <typename T>
+static double ringCopyNs(const T *items, uint32_t n) {
+    static PubSubRing<T, SENSOR_TOPIC_DEPTH, SENSOR_TOPIC_SUBSCRIBERS> ring;
+    ring.reset();
+    int8_t subs[3] = {ring.subscribe(PUBSUB_LATEST_ONLY),
+                      ring.subscribe(PUBSUB_LOSSLESS),
+                      ring.subscribe(PUBSUB_DECIMATED, 10)};
+    T out;
+    volatile uint32_t sink = 0;
+
+    double t0 = nowNs();
+    for (uint32_t i = 0; i < n; i++) {
+        ring.publish(items[i]);
+        for (int8_t s : subs) {
+            if (ring.read(s, out)) sink += ((const uint8_t *)&out)[0];
+        }
+    }
+    return (nowNs() - t0) / n;
+}
+
+int main() {
+    SensorData *data = (SensorData *)malloc(sizeof(SensorData) * BENCH_SAMPLES);
+    SensorRecord *records = (SensorRecord *)malloc(sizeof(SensorRecord) * BENCH_SAMPLES);
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) data[i] = makeSample(i);
+
+    // Dimensioni
+    size_t ringFull = sizeof(PubSubRing<SensorData, SENSOR_TOPIC_DEPTH, SENSOR_TOPIC_SUBSCRIBERS>);
+    size_t ringRec = sizeof(PubSubRing<SensorRecord, SENSOR_TOPIC_DEPTH, SENSOR_TOPIC_SUBSCRIBERS>);
+    printf("=== Dimensioni ===\n");
+    printf("SensorData   %3zu byte\n", sizeof(SensorData));
+    printf("SensorRecord %3zu byte  (%.1fx)\n", sizeof(SensorRecord),
+           (double)sizeof(SensorData) / sizeof(SensorRecord));
+    printf("Ring %d slot: %zu -> %zu byte\n", SENSOR_TOPIC_DEPTH, ringFull, ringRec);
+    printf("Log @%dHz:    %zu -> %zu byte/s\n", BENCH_RATE_HZ,
+           sizeof(SensorData) * BENCH_RATE_HZ, sizeof(SensorRecord) * BENCH_RATE_HZ);
+
+    // Conversione
+    volatile uint32_t sink = 0;
+    double t0 = nowNs();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) packSensorRecord(data[i], records[i]);
+    double packNs = (nowNs() - t0) / BENCH_SAMPLES;
+
+    SensorData out;
+    t0 = nowNs();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        unpackSensorRecord(records[i], out);
+        sink += out.timestamp_ms;
+    }
+    double unpackNs = (nowNs() - t0) / BENCH_SAMPLES;
+
+    t0 = nowNs();
+    float acc = 0;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) acc += records[i].distanceMm();
+    double accessNs = (nowNs() - t0) / BENCH_SAMPLES;
+    sink += (uint32_t)acc;
+
+    printf("\n=== Throughput (host) ===\n");
+    printf("pack         %6.1f ns\n", packNs);
+    printf("unpack       %6.1f ns (coordinate incluse)\n", unpackNs);
+    printf("accessore    %6.1f ns (distanceMm in place)\n", accessNs);
+    printf("ring+3 sub   %6.1f ns SensorData\n", ringCopyNs(data, BENCH_SAMPLES));
+    printf("ring+3 sub   %6.1f ns SensorRecord\n", ringCopyNs(records, BENCH_SAMPLES));
+
+    bool ok = precisionTest();
+    free(data);
+    free(records);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+// sensor_health_test.cpp
+// Test host del supervisore salute sensori (src/health_supervisor.h) sul bus
+// simulato con guasti iniettati (src/i2c_sim_backend.h): NACK sporadici
+// assorbiti, guasto e re-init dopo NACK ripetuti, dispositivo assente con
+// backoff esponenziale fino al tetto, bus bloccato sbloccato dal clock-out,
+// tentativo oltre il budget.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/sensor_health_test.cpp -o sensor_health_test && ./sensor_health_test
+#include <stdio.h>
+#include <vector>
+#include "health_supervisor.h"
+#include "i2c_sim_backend.h"
+#include "test_check.h"
+
+#define RADAR_ADDR      0x52
+#define IMU_ADDR        0x6A
+#define RADAR_STEPS     4           // Come RADAR_INIT_CONNECT..RADAR_INIT_READING
+#define CYCLE_MS        100         // Task sensori a 10Hz
+
+static bool initJob(void *) { return true; }    // Il guasto lo decide il simulatore
+
+// Driver e bus manager sul simulatore: tutto ciò che è in coda gira a fine ciclo
+class SimHealthPort : public HealthPort {
+public:
+    I2CSimBackend sim;
+    I2CScheduler sched;
+    uint32_t suspends[HEALTH_SENSOR_COUNT] = {0};
+    std::vector<uint32_t> retryBackoffs[HEALTH_SENSOR_COUNT];
+
+    SimHealthPort() {
+        sim.addDevice(RADAR_ADDR);
+        sim.addDevice(IMU_ADDR);
+        sched.setBackend(&sim);
+    }
+
+    void suspend(uint8_t sensor) override { suspends[sensor]++; }
+
+    bool prepareInitStep(uint8_t sensor, uint8_t step, I2CTransaction &tx) override {
+        uint8_t steps = sensor == HEALTH_RADAR ? RADAR_STEPS : 1;
+        if (step >= steps) return false;
+        i2cPrepareJob(tx, sensor == HEALTH_RADAR ? I2C_DEV_RADAR : I2C_DEV_IMU, I2C_PRIO_LOW, initJob, nullptr);
+        tx.addr = sensor == HEALTH_RADAR ? RADAR_ADDR : IMU_ADDR;
+        return true;
+    }
+
+    uint64_t deadlineFromNow(uint32_t us) override { return sim.nowUs() + us; }
+
+    bool submit(I2CTransaction &tx) override { return sched.push(&tx, sim.nowUs()); }
+
+    void onAttemptFailed(uint8_t sensor, const SensorHealth &health, uint8_t) override {
+        retryBackoffs[sensor].push_back(health.backoff_ms);
+    }
+
+    uint32_t nowMs() { return (uint32_t)(sim.nowUs() / 1000); }
+
+    void drain() {
+        I2CTransaction *batch[I2C_BATCH_MAX];
+        uint8_t n;
+        while ((n = sched.pop(batch)) > 0) {
+            sched.execute(batch, n);
+            sched.publish(batch, n);
+        }
+    }
+};
+
+// Un ciclo del task sensori: letture dei sensori attivi, esiti, supervisore, bus
+static void cycle(SimHealthPort &port, HealthSupervisor &sup) {
+    uint64_t start = port.sim.nowUs();
+    static const uint8_t addr[HEALTH_SENSOR_COUNT] = {RADAR_ADDR, IMU_ADDR};
+    uint8_t buf[HEALTH_SENSOR_COUNT][6];
+    I2CTransaction tx[HEALTH_SENSOR_COUNT];
+    bool read[HEALTH_SENSOR_COUNT];
+
+    for (uint8_t i = 0; i < HEALTH_SENSOR_COUNT; i++) {
+        read[i] = sup.isHealthy(i);
+        if (!read[i]) continue;
+        i2cPrepareRead(tx[i], i == HEALTH_RADAR ? I2C_DEV_RADAR : I2C_DEV_IMU, I2C_PRIO_HIGH,
+                       addr[i], 0x00, buf[i], sizeof(buf[i]));
+        port.submit(tx[i]);
+    }
+    port.drain();
+    for (uint8_t i = 0; i < HEALTH_SENSOR_COUNT; i++) {
+        if (read[i]) sup.report(i, tx[i].result == I2C_RESULT_OK, true, port.nowMs());
+    }
+
+    sup.service(port.nowMs());
+    port.drain();
+
+    uint64_t used = port.sim.nowUs() - start;
+    if (used < CYCLE_MS * 1000) port.sim.advance(CYCLE_MS * 1000 - used);
+}
+
+static void run(SimHealthPort &port, HealthSupervisor &sup, uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += CYCLE_MS) cycle(port, sup);
+}
+
+int main() {
+    // NACK sporadici: sotto HEALTH_FAIL_LIMIT restano DEGRADED e poi OK
+    {
+        SimHealthPort port;
+        HealthSupervisor sup(port);
+        sup.begin(port.nowMs(), true, true);
+
+        port.sim.injectNack(IMU_ADDR, HEALTH_FAIL_LIMIT - 1);
+        cycle(port, sup);
+        check(sup.health(HEALTH_IMU).state == HEALTH_DEGRADED && sup.isHealthy(HEALTH_IMU),
+              "NACK singolo: DEGRADED, letture attive");
+        run(port, sup, 1000);
+        const SensorHealth &h = sup.health(HEALTH_IMU);
+        check(h.state == HEALTH_OK && h.total_errors == HEALTH_FAIL_LIMIT - 1 && h.faults == 0,
+              "NACK assorbiti: di nuovo OK senza guasto");
+        check(port.suspends[HEALTH_IMU] == 0 && sup.health(HEALTH_RADAR).total_errors == 0,
+              "nessuna sospensione, radar non toccato");
+    }
+
+    // NACK ripetuti: guasto, re-init dopo HEALTH_BACKOFF_MIN_MS, misura di recovery
+    {
+        SimHealthPort port;
+        HealthSupervisor sup(port);
+        sup.begin(port.nowMs(), true, true);
+
+        port.sim.injectNack(IMU_ADDR, HEALTH_FAIL_LIMIT);
+        run(port, sup, HEALTH_FAIL_LIMIT * CYCLE_MS);
+        const SensorHealth &h = sup.health(HEALTH_IMU);
+        check(h.state == HEALTH_FAILED && h.faults == 1 && port.suspends[HEALTH_IMU] == 1,
+              "NACK ripetuti: guasto e sospensione");
+        check(h.backoff_ms == HEALTH_BACKOFF_MIN_MS && sup.isHealthy(HEALTH_RADAR),
+              "primo tentativo dopo il backoff minimo, radar continua");
+
+        run(port, sup, HEALTH_BACKOFF_MIN_MS + 2 * CYCLE_MS);
+        check(h.state == HEALTH_OK && h.attempts == 1 && h.recoveries == 1 && h.backoff_ms == 0,
+              "re-init riuscito al primo tentativo");
+        check(h.last_recovery_ms >= HEALTH_BACKOFF_MIN_MS && h.last_recovery_ms <= HEALTH_BACKOFF_MIN_MS + 3 * CYCLE_MS,
+              "tempo di recovery: guasto -> primo ciclo OK");
+    }
+
+    // Dispositivo assente: tentativi falliti con backoff esponenziale e tetto
+    {
+        SimHealthPort port;
+        HealthSupervisor sup(port);
+        sup.begin(port.nowMs(), true, true);
+
+        port.sim.setDevicePresent(RADAR_ADDR, false);
+        run(port, sup, 60000);
+        const SensorHealth &h = sup.health(HEALTH_RADAR);
+        const std::vector<uint32_t> &b = port.retryBackoffs[HEALTH_RADAR];
+        bool doubling = b.size() >= 6;
+        for (size_t i = 0; doubling && i < b.size(); i++) {
+            uint32_t expected = HEALTH_BACKOFF_MIN_MS << (i + 1);
+            if (expected > HEALTH_BACKOFF_MAX_MS) expected = HEALTH_BACKOFF_MAX_MS;
+            doubling = b[i] == expected;
+        }
+        printf("    %zu tentativi in 60s, backoff finale %lums\n", b.size(), (unsigned long)h.backoff_ms);
+        check(h.state == HEALTH_FAILED || h.state == HEALTH_RECOVERING, "radar assente: resta sospeso");
+        check(doubling && h.backoff_ms == HEALTH_BACKOFF_MAX_MS, "backoff raddoppia fino a HEALTH_BACKOFF_MAX_MS");
+        check(h.attempts == b.size() || h.attempts == b.size() + 1, "un fallimento per tentativo");
+        check(sup.busHealth().recoveries >= b.size() - 1 && port.sim.getRecoveryCount() == sup.busHealth().recoveries,
+              "bus sbloccato prima di ogni nuovo tentativo");
+        check(sup.health(HEALTH_IMU).state == HEALTH_OK && sup.health(HEALTH_IMU).total_errors == 0,
+              "IMU campiona regolarmente durante il guasto radar");
+
+        // Ricollegato: rientra al prossimo tentativo, backoff azzerato
+        port.sim.setDevicePresent(RADAR_ADDR, true);
+        run(port, sup, HEALTH_BACKOFF_MAX_MS + (RADAR_STEPS + 2) * CYCLE_MS);
+        check(h.state == HEALTH_OK && h.recoveries == 1 && h.backoff_ms == 0, "radar ricollegato: re-init a passi riuscito");
+    }
+
+    // Bus bloccato: entrambi i sensori falliscono, clock-out prima del re-init
+    {
+        SimHealthPort port;
+        HealthSupervisor sup(port);
+        sup.begin(port.nowMs(), true, true);
+
+        port.sim.injectStuckBus();
+        run(port, sup, HEALTH_FAIL_LIMIT * CYCLE_MS);
+        check(sup.health(HEALTH_RADAR).state == HEALTH_FAILED && sup.health(HEALTH_IMU).state == HEALTH_FAILED,
+              "bus bloccato: guasto su entrambi");
+        check(port.sim.isBusStuck() && sup.health(HEALTH_RADAR).attempts == 0, "nessun re-init prima del backoff");
+
+        run(port, sup, HEALTH_BACKOFF_MIN_MS + (RADAR_STEPS + 2) * CYCLE_MS);
+        const BusHealth &bus = sup.busHealth();
+        check(!port.sim.isBusStuck() && bus.recoveries == 1 && bus.failed == 0 && bus.last_us == I2C_SIM_RECOVER_US,
+              "clock-out eseguito una volta e misurato");
+        check(sup.health(HEALTH_RADAR).state == HEALTH_OK && sup.health(HEALTH_IMU).state == HEALTH_OK &&
+              sup.health(HEALTH_RADAR).attempts == 1 && sup.health(HEALTH_IMU).attempts == 1,
+              "dopo lo sblocco entrambi rientrano al primo tentativo");
+    }
+
+    // Tentativo più lungo del budget: fallito anche se il job riesce
+    {
+        SimHealthPort port;
+        HealthSupervisor sup(port);
+        port.sim.setJobLatency((HEALTH_RECOVERY_BUDGET_MS + 500) * 1000);
+        sup.begin(port.nowMs(), true, false);     // IMU non partita al boot
+        check(sup.health(HEALTH_IMU).state == HEALTH_FAILED && sup.health(HEALTH_IMU).faults == 1,
+              "sensore assente al boot: parte FAILED");
+
+        run(port, sup, HEALTH_BACKOFF_MIN_MS + 2 * CYCLE_MS);
+        const SensorHealth &h = sup.health(HEALTH_IMU);
+        check(h.attempts == 1 && h.recoveries == 0 && h.last_attempt_ms >= HEALTH_RECOVERY_BUDGET_MS &&
+              h.backoff_ms == 2 * HEALTH_BACKOFF_MIN_MS, "oltre HEALTH_RECOVERY_BUDGET_MS: fallito, backoff raddoppiato");
+
+        port.sim.setJobLatency(2000);
+        run(port, sup, 2 * HEALTH_BACKOFF_MIN_MS + 3 * CYCLE_MS);
+        check(h.state == HEALTH_OK && h.recoveries == 1, "job di nuovo veloce: recuperata");
+    }
+
+    return testSummary();
+}
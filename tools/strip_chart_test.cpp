@@ -0,0 +1,127 @@
+// strip_chart_test.cpp
+// Test host del grafico a scorrimento (src/strip_chart.h): autoscala in
+// allargamento e restringimento, righe dei pixel, segmento fra campioni
+// consecutivi, buchi sui NaN e costo per colonna.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/strip_chart_test.cpp -o strip_chart_test && ./strip_chart_test
+#include <stdio.h>
+#include <chrono>
+#include "strip_chart.h"
+#include "test_check.h"
+
+typedef StripChart<240, 240, 3> Chart;
+
+static const uint16_t COLORS[3] = {0x07E0, 0xFFE0, 0x07FF};
+static const float SPANS[3] = {20.0f, 2.0f, 2.0f};
+
+// Riga colorata della traccia t nella colonna (-1 se assente)
+static int traceRows(const uint16_t *col, uint8_t t, int &first, int &last) {
+    first = last = -1;
+    int n = 0;
+    for (int y = t * Chart::BAND; y < (t + 1) * Chart::BAND; y++) {
+        if (col[y] != COLORS[t]) continue;
+        if (first < 0) first = y;
+        last = y;
+        n++;
+    }
+    return n;
+}
+
+int main() {
+    static Chart chart;
+    uint16_t col[240];
+
+    // Primo campione: scala centrata con escursione minima
+    {
+        chart.begin(COLORS, SPANS, 0);
+        float v[3] = {1000.0f, 0.0f, 0.0f};
+        bool redraw = chart.push(v);
+        check(redraw && chart.low(0) == 990.0f && chart.high(0) == 1010.0f, "prima scala: escursione minima");
+    }
+
+    // Allargamento: un valore fuori scala chiede il ridisegno completo
+    {
+        float v[3] = {1000.0f, 0.0f, 0.0f};
+        bool redraw = false;
+        for (int i = 0; i < 10; i++) redraw |= chart.push(v);
+        check(!redraw, "valori in scala: solo la colonna nuova");
+
+        v[0] = 1500.0f;
+        redraw = chart.push(v);
+        check(redraw && chart.high(0) >= 1500.0f && chart.low(0) <= 1000.0f, "fuori scala: allarga con margine");
+    }
+
+    // Righe: il massimo in alto, il minimo in basso, dentro la fascia
+    {
+        chart.renderColumn(0, col);
+        int first, last;
+        traceRows(col, 0, first, last);
+        int topHigh = first;
+        chart.renderColumn(1, col);
+        traceRows(col, 0, first, last);
+        check(topHigh >= 0 && topHigh < last && last < Chart::BAND - 1, "valore alto sopra, basso sotto");
+
+        // Colonna del salto: segmento continuo fra i due campioni
+        chart.renderColumn(0, col);
+        int n = traceRows(col, 0, first, last);
+        check(n == last - first + 1 && n > Chart::BAND / 2, "salto collegato da un segmento verticale");
+        check(col[Chart::BAND - 1] == STRIP_CHART_SEP_COLOR, "separatore fra fasce");
+    }
+
+    // Restringimento: dopo una finestra intera di valori piatti
+    {
+        float v[3] = {1200.0f, 0.0f, 0.0f};
+        uint32_t before = chart.rescaleCount();
+        for (int i = 0; i < 480; i++) chart.push(v);
+        float range = chart.high(0) - chart.low(0);
+        printf("    scala dopo due finestre piatte: %.1f..%.1f mm\n", chart.low(0), chart.high(0));
+        check(chart.rescaleCount() > before && range <= 20.0f + 0.01f, "scala ristretta ai dati visibili");
+    }
+
+    // NaN: nessun pixel della traccia, le altre continuano
+    {
+        float v[3] = {NAN, 0.5f, -0.5f};
+        chart.push(v);
+        chart.renderColumn(0, col);
+        int first, last;
+        check(traceRows(col, 0, first, last) == 0 && traceRows(col, 1, first, last) > 0 &&
+              traceRows(col, 2, first, last) > 0, "campione non valido: buco solo nella sua traccia");
+
+        // Il campione dopo il buco non si collega a quello prima
+        float w[3] = {1200.0f, 0.5f, -0.5f};
+        chart.push(w);
+        chart.renderColumn(0, col);
+        check(traceRows(col, 0, first, last) == 1, "dopo il buco: solo il punto");
+    }
+
+    // Colonne oltre i campioni disponibili: solo sfondo e griglia
+    {
+        chart.begin(COLORS, SPANS, 0);
+        float v[3] = {1.0f, 2.0f, 3.0f};
+        chart.push(v);
+        chart.renderColumn(5, col);
+        int first, last;
+        bool empty = true;
+        for (uint8_t t = 0; t < 3; t++) empty &= traceRows(col, t, first, last) == 0;
+        check(empty && chart.size() == 1, "colonne vuote prima di riempire il ring");
+    }
+
+    // Costo per colonna (push + render): il display ne chiede una per campione
+    {
+        chart.begin(COLORS, SPANS, 0);
+        uint32_t n = 2000000, redraws = 0;
+        uint32_t sink = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < n; i++) {
+            float v[3] = {1000.0f + (float)(i % 100), (float)((i / 7) % 20) * 0.5f, (float)(i % 360)};
+            redraws += chart.push(v);
+            chart.renderColumn(0, col);
+            sink += col[i % 240];
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+        printf("    %.1f ns/colonna (host), %u ridisegni completi (%u)\n", ns, redraws, sink & 1);
+        check(ns < 5000.0 && redraws < n / 100, "colonna incrementale, ridisegni rari");
+    }
+
+    return testSummary();
+}
@@ -0,0 +1,146 @@
+// system_monitor_test.cpp
+// Test host dei calcoli del monitor di sistema (src/system_monitor.h): carico
+// per core da finestre di IDLE, media e picco, contatori run-time a 32 bit che
+// si riavvolgono, task nuovi e cancellati fra due letture, frammentazione,
+// stack usato, classi dei target e task con lo stack peggiore.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/system_monitor_test.cpp -o system_monitor_test && ./system_monitor_test
+#include <stdio.h>
+#include <chrono>
+#include "system_monitor.h"
+#include "test_check.h"
+
+static void addTask(SystemSnapshot &s, const char *name, uint32_t stackFree, uint32_t stackSize) {
+    SysMonTask &t = s.tasks[s.task_count++];
+    memset(&t, 0, sizeof(t));
+    strncpy(t.name, name, SYSMON_NAME_LEN - 1);
+    t.stack_free = stackFree;
+    t.stack_size = stackSize;
+    t.stack_used_permille = sysmonStackUsed(stackFree, stackSize);
+}
+
+int main() {
+    // Carico per core: 1 - IDLE nella finestra, sistema = media dei core
+    {
+        SysMonCpuLoad cpu;
+        uint32_t idle[2] = {700000, 900000};    // 30% e 10% su 1s
+        cpu.addWindow(idle, 2, 1000000);
+        check(cpu.coreWindowLoad(0) == 300 && cpu.coreWindowLoad(1) == 100, "carico per core dalla finestra");
+        check(cpu.windowLoad() == 200 && cpu.peakLoad() == 200, "sistema: media dei core");
+    }
+
+    // Media pesata sul tempo, picco = finestra peggiore
+    {
+        SysMonCpuLoad cpu;
+        uint32_t busy[2] = {100000, 100000};    // 90% su 1s
+        uint32_t calm[2] = {900000, 900000};    // 10% su 1s
+        cpu.addWindow(busy, 2, 1000000);
+        for (int i = 0; i < 3; i++) cpu.addWindow(calm, 2, 1000000);
+        check(cpu.averageLoad() == 300, "media: (900 + 3*100) / 4");
+        check(cpu.peakLoad() == 900 && cpu.windowLoad() == 100, "picco conservato, finestra corrente");
+        check(cpu.corePeakLoad(0) == 900 && cpu.coreAverageLoad(1) == 300, "picco e media per core");
+
+        // Finestra più lunga pesa di più nella media
+        uint32_t half[2] = {1000000, 1000000};  // 50% su 2s
+        cpu.addWindow(half, 2, 2000000);
+        check(cpu.averageLoad() == 1000 * (900 + 300 + 1000) / 6000 && cpu.windowCount() == 5,
+              "media pesata sulla durata delle finestre");
+
+        cpu.reset();
+        check(cpu.averageLoad() == 0 && cpu.peakLoad() == 0 && cpu.windowCount() == 0, "reset di media e picco");
+    }
+
+    // IDLE oltre la finestra (jitter della lettura): carico 0, non negativo
+    {
+        SysMonCpuLoad cpu;
+        uint32_t idle[2] = {1000500, 0};
+        cpu.addWindow(idle, 2, 1000000);
+        check(cpu.coreWindowLoad(0) == 0 && cpu.coreWindowLoad(1) == 1000, "IDLE saturato alla finestra");
+        cpu.addWindow(idle, 2, 0);
+        check(cpu.windowCount() == 1, "finestra vuota ignorata");
+    }
+
+    // Contatori run-time: riavvolgimento a 32 bit, task nuovi e cancellati
+    {
+        SysMonTaskRuntimes rt;
+        rt.store(0, 1, 0xFFFFF000u);   // IDLE0 vicino al riavvolgimento
+        rt.store(1, 7, 5000);          // Task che verrà cancellato
+        rt.commit(2);
+
+        uint32_t d;
+        bool known = rt.delta(1, 0x00001000u, d);
+        check(known && d == 0x2000, "riavvolgimento del contatore a 32 bit");
+        check(!rt.delta(9, 123, d) && d == 0, "task nuovo: nessun delta");
+
+        rt.store(0, 1, 0x00001000u);
+        rt.store(1, 9, 123);
+        rt.commit(2);
+        check(!rt.delta(7, 9000, d), "task cancellato dimenticato");
+        check(rt.delta(9, 1123, d) && d == 1000, "task nuovo contato dalla seconda finestra");
+    }
+
+    // Heap: frammentazione = 1 - blocco più grande / libero
+    {
+        check(sysmonFragmentation(200000, 200000) == 0, "heap contiguo: 0%");
+        check(sysmonFragmentation(200000, 150000) == 250, "blocco 150K su 200K: 25%");
+        check(sysmonFragmentation(0, 0) == 0 && sysmonFragmentation(1000, 2000) == 0, "casi limite senza divisioni");
+    }
+
+    // Stack: permille usati dall'high-water mark
+    {
+        check(sysmonStackUsed(1024, 4096) == 750, "stack 3K usati su 4K: 75%");
+        check(sysmonStackUsed(0, 4096) == 1000, "stack esaurito: 100%");
+        check(sysmonStackUsed(100, 0) == 0 && sysmonStackUsed(5000, 4096) == 0, "dimensione ignota o incoerente: 0");
+    }
+
+    // Classi dei target di performance-criteria.md
+    {
+        check(sysmonGrade(250, SYSMON_CPU_AVG_TARGET, SYSMON_CPU_AVG_ACCEPT, SYSMON_CPU_AVG_CRIT) == SYSMON_GRADE_TARGET &&
+              sysmonGrade(450, SYSMON_CPU_AVG_TARGET, SYSMON_CPU_AVG_ACCEPT, SYSMON_CPU_AVG_CRIT) == SYSMON_GRADE_ACCEPT &&
+              sysmonGrade(600, SYSMON_CPU_AVG_TARGET, SYSMON_CPU_AVG_ACCEPT, SYSMON_CPU_AVG_CRIT) == SYSMON_GRADE_LIMIT &&
+              sysmonGrade(700, SYSMON_CPU_AVG_TARGET, SYSMON_CPU_AVG_ACCEPT, SYSMON_CPU_AVG_CRIT) == SYSMON_GRADE_CRIT,
+              "CPU media: target / accettabile / limite / critico");
+        check(sysmonGradeAbove(240, SYSMON_HEAP_TARGET_KB, SYSMON_HEAP_ACCEPT_KB, SYSMON_HEAP_CRIT_KB) == SYSMON_GRADE_TARGET &&
+              sysmonGradeAbove(120, SYSMON_HEAP_TARGET_KB, SYSMON_HEAP_ACCEPT_KB, SYSMON_HEAP_CRIT_KB) == SYSMON_GRADE_LIMIT &&
+              sysmonGradeAbove(100, SYSMON_HEAP_TARGET_KB, SYSMON_HEAP_ACCEPT_KB, SYSMON_HEAP_CRIT_KB) == SYSMON_GRADE_CRIT,
+              "heap libero: più alto è meglio");
+    }
+
+    // Stack peggiore fra i task di dimensione nota
+    {
+        static SystemSnapshot s;
+        memset(&s, 0, sizeof(s));
+        addTask(s, "SensorTask", 1500, 4096);
+        addTask(s, "IDLE0", 100, 0);        // Dimensione ignota: esclusa
+        addTask(s, "Logger", 400, 4096);
+        addTask(s, "loopTask", 4000, 8192);
+        sysmonFindWorstStack(s);
+        check(s.stack_worst_permille == 902 && strcmp(s.stack_worst_name, "Logger") == 0,
+              "stack peggiore: Logger 90.2%");
+    }
+
+    // Costo di una finestra con SYSMON_MAX_TASKS task (il monitor gira a 1Hz)
+    {
+        SysMonCpuLoad cpu;
+        SysMonTaskRuntimes rt;
+        uint32_t n = 200000, sink = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint32_t w = 0; w < n; w++) {
+            for (uint8_t i = 0; i < SYSMON_MAX_TASKS; i++) {
+                uint32_t d;
+                rt.delta(i, w * 1000 + i, d);
+                rt.store(i, i, w * 1000 + i);
+                sink += d;
+            }
+            rt.commit(SYSMON_MAX_TASKS);
+            uint32_t idle[2] = {w % 1000, (w * 7) % 1000};
+            cpu.addWindow(idle, 2, 1000);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / n;
+        printf("    %.2f us/finestra con %u task (host), snapshot %zu B (%u)\n",
+               us, SYSMON_MAX_TASKS, sizeof(SystemSnapshot), sink & 1);
+        check(us < 50.0, "finestra trascurabile rispetto al periodo di 1s");
+    }
+
+    return testSummary();
+}
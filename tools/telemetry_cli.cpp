@@ -0,0 +1,323 @@
+// telemetry_cli.cpp
+// Decoder/registratore host per la telemetria binaria (src/telemetry.h).
+//
+//   g++ -std=c++17 -O2 -Isrc tools/telemetry_cli.cpp -o telemetry_cli
+//
+//   telemetry_cli record <porta|file|-> <out.trace> [secondi]
+//   telemetry_cli dump <in.trace> [csv]
+//   telemetry_cli selftest
+//
+// record: decodifica lo stream, scrive i frame validi nel formato trace
+// (telemetry_protocol.h) e stampa ogni secondo perdite e costo CPU del
+// device. Le righe di log testuali sulla stessa seriale vanno su stderr.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <chrono>
+#include "telemetry_protocol.h"
+#include "sensor_record.h"
+
+static volatile bool running = true;
+static void onSignal(int) { running = false; }
+
+static uint64_t hostNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static const char *frameName(uint8_t type) {
+    switch (type) {
+        case TELEM_FRAME_SAMPLE:     return "sample";
+        case TELEM_FRAME_TASK_STATS: return "task";
+        case TELEM_FRAME_I2C_STATS:  return "i2c";
+        case TELEM_FRAME_HEALTH:     return "health";
+        case TELEM_FRAME_LINK:       return "link";
+        case TELEM_FRAME_SYSTEM:     return "system";
+        case TELEM_FRAME_TASK_LOAD:  return "load";
+        default:                     return "?";
+    }
+}
+
+// === STAMPA FRAME ===
+template <typename T>
+static bool payloadAs(const uint8_t *frame, size_t len, T &out) {
+    if (len != sizeof(TelemFrameHeader) + sizeof(T)) return false;
+    memcpy(&out, frame + sizeof(TelemFrameHeader), sizeof(T));
+    return true;
+}
+
+static void printFrame(uint64_t host_us, const uint8_t *frame, size_t len, bool csv) {
+    TelemFrameHeader hdr;
+    memcpy(&hdr, frame, sizeof(hdr));
+
+    if (csv) {
+        SensorRecord r;
+        if (hdr.type != TELEM_FRAME_SAMPLE || !payloadAs(frame, len, r)) return;
+        printf("%llu,%.3f,%.3f,%.2f,%.2f,%.2f,%d,%d,%u\n",
+               (unsigned long long)r.timestamp_us, r.distanceMm(), r.filteredMm(),
+               r.pitchDeg(), r.yawDeg(), r.rollDeg(),
+               r.radarValid(), r.imuValid(), r.syncDeltaUs());
+        return;
+    }
+
+    printf("%10.3f #%-5u %-7s ", host_us / 1e6, hdr.seq, frameName(hdr.type));
+    SensorRecord r;
+    TelemTaskStats t;
+    TelemI2CStats i;
+    TelemHealth h;
+    TelemLinkStats l;
+    TelemSystemStats s;
+    TelemTaskLoad k;
+    if (hdr.type == TELEM_FRAME_SAMPLE && payloadAs(frame, len, r)) {
+        printf("t=%lluus d=%.1fmm P=%.2f Y=%.2f R=%.2f %c%c sync=%uus\n",
+               (unsigned long long)r.timestamp_us, r.distanceMm(),
+               r.pitchDeg(), r.yawDeg(), r.rollDeg(),
+               r.radarValid() ? 'R' : '-', r.imuValid() ? 'I' : '-', r.syncDeltaUs());
+    } else if (hdr.type == TELEM_FRAME_TASK_STATS && payloadAs(frame, len, t)) {
+        printf("samples=%u sync=%u/%u overflow=%u busfail=%u overrun=%u maxsync=%uus\n",
+               t.samples_acquired, t.sync_success, t.sync_failures, t.queue_overflows,
+               t.bus_failures, t.bus_overruns, t.max_sync_delta_us);
+    } else if (hdr.type == TELEM_FRAME_I2C_STATS && payloadAs(frame, len, i)) {
+        printf("dev=%u tx=%u err=%u miss=%u busy=%ums maxwait=%uus\n",
+               i.device, i.transactions, i.errors, i.deadline_misses, i.busy_ms, i.max_wait_us);
+    } else if (hdr.type == TELEM_FRAME_HEALTH && payloadAs(frame, len, h)) {
+        printf("sensor=%u state=%u err=%u faults=%u rec=%u maxrec=%ums\n",
+               h.sensor, h.state, h.total_errors, h.faults, h.recoveries, h.max_recovery_ms);
+    } else if (hdr.type == TELEM_FRAME_LINK && payloadAs(frame, len, l)) {
+        printf("sent=%u drop=%u lost=%u cpu=%.1f%% maxframe=%uus\n",
+               l.frames_sent, l.frames_dropped, l.samples_dropped,
+               l.cpu_permille / 10.0, l.max_frame_us);
+    } else if (hdr.type == TELEM_FRAME_SYSTEM && payloadAs(frame, len, s)) {
+        if (s.runtime_stats) {
+            printf("cpu=%.1f%% avg=%.1f%% peak=%.1f%% core=%.1f/%.1f%% ",
+                   s.cpu_permille / 10.0, s.cpu_avg_permille / 10.0, s.cpu_peak_permille / 10.0,
+                   s.core_permille[0] / 10.0, s.core_permille[1] / 10.0);
+        }
+        printf("heap=%uKB min=%uKB block=%uKB frag=%.1f%% stack=%.1f%% lag=%u i2c=%u tasks=%u cost=%uus\n",
+               s.free_heap / 1024, s.min_free_heap / 1024, s.largest_block / 1024,
+               s.frag_permille / 10.0, s.stack_worst_permille / 10.0,
+               s.topic_lag, s.i2c_pending, s.task_count, s.sample_us);
+    } else if (hdr.type == TELEM_FRAME_TASK_LOAD && payloadAs(frame, len, k)) {
+        char name[sizeof(k.name) + 1] = {0};
+        memcpy(name, k.name, sizeof(k.name));
+        printf("%-16s core=%c prio=%u cpu=%.1f%% stack=%.1f%% free=%u\n",
+               name, k.core < 2 ? '0' + k.core : '-', k.priority,
+               k.load_permille / 10.0, k.stack_used_permille / 10.0, k.stack_free);
+    } else {
+        printf("len=%zu (payload inatteso)\n", len);
+    }
+}
+
+// === RECORD ===
+struct RecordStats {
+    uint32_t frames;
+    uint32_t samples;
+    uint32_t crc_errors;
+    uint32_t noise;             // Chunk non COBS: righe di log
+    uint32_t seq_lost;          // Buchi nella sequenza
+    bool have_seq;
+    uint16_t last_seq;
+    TelemLinkStats link;
+    bool have_link;
+};
+
+static int openInput(const char *path) {
+    if (strcmp(path, "-") == 0) return STDIN_FILENO;
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) return -1;
+    if (isatty(fd)) {
+        termios tio;
+        tcgetattr(fd, &tio);
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);     // Ignorato da USB-CDC
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 1;           // read() ritorna ogni 100ms
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+static void printStatus(const RecordStats &s) {
+    fprintf(stderr, "frames=%u samples=%u crc=%u lost=%u",
+            s.frames, s.samples, s.crc_errors, s.seq_lost);
+    if (s.have_link) {
+        fprintf(stderr, " | device: drop=%u topic_lost=%u cpu=%.1f%% maxframe=%uus",
+                s.link.frames_dropped, s.link.samples_dropped,
+                s.link.cpu_permille / 10.0, s.link.max_frame_us);
+    }
+    fprintf(stderr, "\n");
+}
+
+static int cmdRecord(const char *in, const char *out, double seconds) {
+    int fd = openInput(in);
+    if (fd < 0) {
+        perror(in);
+        return 1;
+    }
+    FILE *trace = fopen(out, "wb");
+    if (!trace) {
+        perror(out);
+        return 1;
+    }
+
+    TelemTraceHeader th = {};
+    memcpy(th.magic, TELEM_TRACE_MAGIC, sizeof(th.magic));
+    th.version = TELEM_TRACE_VERSION;
+    th.protocol = TELEM_PROTOCOL_VERSION;
+    fwrite(&th, sizeof(th), 1, trace);
+
+    signal(SIGINT, onSignal);
+    TelemStreamDecoder decoder;
+    RecordStats s = {};
+    uint64_t start = hostNowUs(), lastStatus = start;
+    uint8_t buf[256], frame[TELEM_MAX_FRAME];
+
+    while (running) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0) break;
+        if (n == 0 && !isatty(fd)) break;   // Fine file/pipe
+
+        uint64_t now = hostNowUs();
+        for (ssize_t k = 0; k < n; k++) {
+            if (!decoder.feed(buf[k])) continue;
+
+            size_t len;
+            TelemDecodeResult res = telemDecodeFrame(decoder.chunk(), decoder.chunkLen(), frame, len);
+            if (res == TELEM_DECODE_OK) {
+                TelemFrameHeader hdr;
+                memcpy(&hdr, frame, sizeof(hdr));
+                if (s.have_seq) s.seq_lost += (uint16_t)(hdr.seq - s.last_seq - 1);
+                s.have_seq = true;
+                s.last_seq = hdr.seq;
+                s.frames++;
+                if (hdr.type == TELEM_FRAME_SAMPLE) s.samples++;
+                if (hdr.type == TELEM_FRAME_LINK) s.have_link = payloadAs(frame, len, s.link);
+
+                TelemTraceRecord tr = {};
+                tr.host_us = now - start;
+                tr.len = (uint16_t)len;
+                fwrite(&tr, sizeof(tr), 1, trace);
+                fwrite(frame, len, 1, trace);
+            } else if (res == TELEM_DECODE_CRC_ERROR || res == TELEM_DECODE_SHORT) {
+                s.crc_errors++;
+            } else {
+                // Testo di log del firmware
+                s.noise++;
+                fprintf(stderr, "[log] %.*s", (int)decoder.chunkLen(), (const char *)decoder.chunk());
+            }
+            decoder.consume();
+        }
+
+        if (now - lastStatus >= 1000000) {
+            printStatus(s);
+            lastStatus = now;
+        }
+        if (seconds > 0 && now - start >= seconds * 1e6) break;
+    }
+
+    fclose(trace);
+    if (fd != STDIN_FILENO) close(fd);
+    printStatus(s);
+    return 0;
+}
+
+// === DUMP ===
+static int cmdDump(const char *in, bool csv) {
+    FILE *f = fopen(in, "rb");
+    if (!f) {
+        perror(in);
+        return 1;
+    }
+    TelemTraceHeader th;
+    if (fread(&th, sizeof(th), 1, f) != 1 || memcmp(th.magic, TELEM_TRACE_MAGIC, sizeof(th.magic)) != 0) {
+        fprintf(stderr, "%s: non è un trace telemetria\n", in);
+        fclose(f);
+        return 1;
+    }
+
+    if (csv) printf("timestamp_us,distance_mm,filtered_mm,pitch,yaw,roll,radar_valid,imu_valid,sync_us\n");
+    TelemTraceRecord tr;
+    uint8_t frame[TELEM_MAX_FRAME];
+    while (fread(&tr, sizeof(tr), 1, f) == 1) {
+        if (tr.len > sizeof(frame) || fread(frame, tr.len, 1, f) != 1) break;
+        if (tr.len < sizeof(TelemFrameHeader)) continue;
+        printFrame(tr.host_us, frame, tr.len, csv);
+    }
+    fclose(f);
+    return 0;
+}
+
+// === SELFTEST ===
+// Round-trip codifica/decodifica, rumore di log e corruzioni singole
+static int cmdSelftest() {
+    uint32_t rng = 1;
+    uint32_t failures = 0, detected = 0, corrupted = 0;
+    uint8_t payload[TELEM_MAX_PAYLOAD], wire[TELEM_MAX_ENCODED], frame[TELEM_MAX_FRAME];
+
+    for (uint32_t i = 0; i < 100000; i++) {
+        size_t len = i % (TELEM_MAX_PAYLOAD + 1);
+        for (size_t k = 0; k < len; k++) {
+            rng = rng * 1664525u + 1013904223u;
+            payload[k] = (i & 1) ? 0 : (uint8_t)(rng >> 24);   // Metà con soli zeri
+        }
+        size_t n = telemEncodeFrame(TELEM_FRAME_SAMPLE, (uint16_t)i, payload, len, wire);
+
+        // Corrompe un byte interno un frame su 4
+        bool corrupt = (i % 4) == 3 && n > 3;
+        if (corrupt) {
+            size_t pos = 1 + (rng >> 8) % (n - 2);
+            wire[pos] ^= (uint8_t)(1 + (rng & 0x7F));
+            if (wire[pos] == 0) wire[pos] = 0x55;
+            corrupted++;
+        }
+
+        // Riga di log prima del frame, come sulla seriale vera
+        TelemStreamDecoder decoder;
+        const char *log = "✅ Sensor tasks initialized\n";
+        for (const char *c = log; *c; c++) decoder.feed((uint8_t)*c);
+
+        bool gotFrame = false;
+        for (size_t k = 0; k < n; k++) {
+            if (!decoder.feed(wire[k])) continue;
+            size_t flen;
+            TelemDecodeResult res = telemDecodeFrame(decoder.chunk(), decoder.chunkLen(), frame, flen);
+            decoder.consume();
+            if (res != TELEM_DECODE_OK) continue;
+
+            TelemFrameHeader hdr;
+            memcpy(&hdr, frame, sizeof(hdr));
+            bool same = flen == sizeof(hdr) + len && hdr.seq == (uint16_t)i &&
+                        memcmp(frame + sizeof(hdr), payload, len) == 0;
+            if (corrupt || !same) failures++;
+            gotFrame = true;
+        }
+        if (!corrupt && !gotFrame) failures++;
+        if (corrupt && !gotFrame) detected++;
+    }
+
+    printf("Selftest: %u errori, %u/%u corruzioni rilevate\n", failures, detected, corrupted);
+    bool ok = failures == 0 && detected == corrupted;
+    printf("%s\n", ok ? "✅ PASS" : "❌ FAIL");
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "record") == 0) {
+        return cmdRecord(argv[2], argv[3], argc >= 5 ? atof(argv[4]) : 0);
+    }
+    if (argc >= 3 && strcmp(argv[1], "dump") == 0) {
+        return cmdDump(argv[2], argc >= 4 && strcmp(argv[3], "csv") == 0);
+    }
+    if (argc >= 2 && strcmp(argv[1], "selftest") == 0) {
+        return cmdSelftest();
+    }
+    fprintf(stderr,
+            "uso: %s record <porta|file|-> <out.trace> [secondi]\n"
+            "     %s dump <in.trace> [csv]\n"
+            "     %s selftest\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,23 @@
+// test_check.h
+// Esito dei test host di tools/: una riga [PASS]/[FAIL] per controllo e
+// riepilogo finale con exit code (0 = tutti passati). Un solo .cpp per tool,
+// quindi lo stato statico nell'header non si duplica.
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+static inline void check(bool ok, const char *name) {
+    printf("[%s] %s\n", ok ? "PASS" : "FAIL", name);
+    if (!ok) failures++;
+}
+
+// Riepilogo finale, da restituire da main() o dal selftest
+static inline int testSummary() {
+    printf("\n%s (%d falliti)\n", failures == 0 ? "✅ PASS" : "❌ FAIL", failures);
+    return failures == 0 ? 0 : 1;
+}
+
+#endif // TEST_CHECK_H
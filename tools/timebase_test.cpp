@@ -0,0 +1,82 @@
+// timebase_test.cpp
+// Test host della base tempi (src/timebase.h) sull'orologio virtuale:
+// avanzamento a comando, differenze con segno a cavallo del wrap a 64 e a
+// 32 bit (millis()), timeReachedMs, conversioni ms/µs con troncamento e
+// saturazione, timestamp e delta di sincronizzazione di SensorData.
+//
+//   g++ -std=c++17 -O2 -Isrc tools/timebase_test.cpp -o timebase_test && ./timebase_test
+#include <stdio.h>
+#include "timebase.h"
+#include "sync_queue.h"
+#include "test_check.h"
+
+int main() {
+    // Orologio virtuale: fermo finché non lo si avanza
+    {
+        timebaseSetUs(0);
+        check(timebaseNowUs() == 0 && timebaseNowUs() == 0, "orologio fermo senza avanzamento");
+        timebaseAdvanceUs(1500);
+        timebaseAdvanceUs(250);
+        check(timebaseNowUs() == 1750, "avanzamento cumulativo");
+        timebaseSetUs(42000000);
+        check(timebaseNowUs() == 42000000 && usToMs(timebaseNowUs()) == 42000, "impostazione assoluta");
+    }
+
+    // Differenze a 64 bit: con segno, anche a cavallo del wrap
+    {
+        timestamp_us_t before = UINT64_MAX - 499;
+        timebaseSetUs(before);
+        timebaseAdvanceUs(1000);
+        timestamp_us_t after = timebaseNowUs();
+        check(after == 500 && timeDeltaUs(after, before) == 1000, "delta in avanti attraverso il wrap");
+        check(timeDeltaUs(before, after) == -1000, "delta all'indietro negativo");
+        check(timeAbsDeltaUs(before, after) == 1000 && timeAbsDeltaUs(after, before) == 1000, "delta assoluto simmetrico");
+    }
+
+    // Contatori a 32 bit (millis()): confronto modulo 2^32
+    {
+        uint32_t before = 0xFFFFFF00u;
+        uint32_t after = before + 0x200;     // Riavvolto a 0x100
+        check(after == 0x100 && timeDeltaMs(after, before) == 0x200, "delta ms attraverso il riavvolgimento");
+        check(timeDeltaMs(before, after) == -0x200, "delta ms negativo");
+        check(timeReachedMs(after, before + 0x200) && timeReachedMs(after, before + 0x100),
+              "scadenza raggiunta dopo il riavvolgimento");
+        // Qui il confronto ingenuo now >= target darebbe la scadenza per raggiunta
+        check(!timeReachedMs(before, before + 0x200), "scadenza oltre il riavvolgimento non ancora raggiunta");
+    }
+
+    // Conversioni: troncamento come millis(), saturazione a 32 bit
+    {
+        check(usToMs(999) == 0 && usToMs(1000) == 1 && usToMs(1999) == 1, "usToMs tronca");
+        check(msToUs(0xFFFFFFFFu) == 4294967295000ull, "msToUs senza overflow a 32 bit");
+        check(usToMs(msToUs(123456)) == 123456, "andata e ritorno ms -> us -> ms");
+        check(usToMsF(1500) == 1.5f && usToMsF(-250) == -0.25f, "usToMsF con risoluzione sub-ms");
+        check(usToMsSat(4294967295000ull) == 0xFFFFFFFFu && usToMsSat(UINT64_MAX) == 0xFFFFFFFFu,
+              "usToMsSat satura a 32 bit");
+        check(usToMsSat(2500) == 2, "usToMsSat sotto la soglia = usToMs");
+        // Oltre ~49.7 giorni usToMs riavvolge come millis()
+        check(usToMs(msToUs(0xFFFFFFFFu) + 1000) == 0, "usToMs riavvolge come millis()");
+    }
+
+    // Timestamp sensori: delta in µs indipendente dall'ordine, campi ms derivati
+    {
+        SensorData d = {};
+        timebaseSetUs(msToUs(0xFFFFFFFFu) - 2000);      // millis() a 3ms dal riavvolgimento
+        timestamp_us_t radarUs = timebaseNowUs();
+        timebaseAdvanceUs(4200);
+        timestamp_us_t imuUs = timebaseNowUs();
+        setSensorTimestamps(d, radarUs, imuUs);
+        check(d.sync_delta_us == 4200 && d.sync_delta_ms == 4, "delta radar/IMU in µs e ms");
+        check(d.radar_timestamp == 0xFFFFFFFDu && d.imu_timestamp == 1, "campi ms a cavallo del riavvolgimento");
+        check(isSyncValid(d), "4.2ms entro MAX_SYNC_DELTA_MS");
+
+        setSensorTimestamps(d, imuUs, radarUs);
+        check(d.sync_delta_us == 4200, "delta indipendente dall'ordine");
+
+        timebaseAdvanceUs(MAX_SYNC_DELTA_MS * 1000 + 1 - 4200);
+        setSensorTimestamps(d, radarUs, timebaseNowUs());
+        check(!isSyncValid(d) && d.sync_delta_ms == MAX_SYNC_DELTA_MS, "oltre MAX_SYNC_DELTA_MS di 1µs: non valido");
+    }
+
+    return testSummary();
+}